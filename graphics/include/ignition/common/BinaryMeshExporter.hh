@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_COMMON_BINARYMESHEXPORTER_HH_
+#define IGNITION_COMMON_BINARYMESHEXPORTER_HH_
+
+#include <string>
+
+#include <ignition/utils/ImplPtr.hh>
+
+#include <ignition/common/MeshExporter.hh>
+#include <ignition/common/graphics/Export.hh>
+
+namespace ignition
+{
+  namespace common
+  {
+    /// \brief Class used to export meshes in the native binary mesh format,
+    /// which BinaryMeshLoader reads back. The format stores submeshes,
+    /// materials including PBR properties, the skeleton with its vertex
+    /// weights, and skeleton animations in chunks that are loaded straight
+    /// from a memory mapped file. Files use the ".ignmesh" extension.
+    class IGNITION_COMMON_GRAPHICS_VISIBLE BinaryMeshExporter
+      : public MeshExporter
+    {
+      /// \brief Constructor
+      public: BinaryMeshExporter();
+
+      /// \brief Destructor
+      public: virtual ~BinaryMeshExporter();
+
+      /// \brief Set whether chunk payloads are compressed. Compressed files
+      /// are smaller but are decompressed into memory when loaded, instead
+      /// of being read from the mapped file. The default is false.
+      /// \param[in] _compress True to compress.
+      public: void SetCompression(const bool _compress);
+
+      /// \brief Get whether chunk payloads are compressed.
+      /// \return True if exported files are compressed.
+      public: bool Compression() const;
+
+      /// \brief Export a mesh to a file
+      /// \param[in] _mesh Pointer to the mesh to be exported
+      /// \param[in] _filename Exported file's path and name, to which the
+      /// ".ignmesh" extension is added
+      /// \param[in] _exportTextures Unused. Materials keep the paths of
+      /// their textures.
+      public: virtual void Export(const Mesh *_mesh,
+          const std::string &_filename, bool _exportTextures = false);
+
+      /// \brief Pointer to private data.
+      IGN_UTILS_IMPL_PTR(dataPtr)
+    };
+  }
+}
+#endif
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_COMMON_BINARYMESHLOADER_HH_
+#define IGNITION_COMMON_BINARYMESHLOADER_HH_
+
+#include <string>
+
+#include <ignition/utils/ImplPtr.hh>
+
+#include <ignition/common/MeshLoader.hh>
+#include <ignition/common/graphics/Export.hh>
+
+namespace ignition
+{
+  namespace common
+  {
+    /// \brief Class used to load meshes written by BinaryMeshExporter
+    class IGNITION_COMMON_GRAPHICS_VISIBLE BinaryMeshLoader : public MeshLoader
+    {
+      /// \brief Constructor
+      public: BinaryMeshLoader();
+
+      /// \brief Destructor
+      public: virtual ~BinaryMeshLoader();
+
+      /// \brief Load a mesh
+      /// \param[in] _filename Binary mesh file to load
+      /// \return Pointer to a new Mesh, or nullptr if the file could not be
+      /// read
+      public: virtual Mesh *Load(const std::string &_filename);
+
+      /// \internal
+      /// \brief Private data pointer.
+      IGN_UTILS_IMPL_PTR(dataPtr)
+    };
+  }
+}
+#endif
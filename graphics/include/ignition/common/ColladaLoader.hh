@@ -42,6 +42,20 @@ namespace ignition
       /// \return Pointer to a new Mesh
       public: virtual Mesh *Load(const std::string &_filename);
 
+      /// \brief Decode the geometries of a file in parallel on the shared
+      /// worker pool. Geometries are merged in document order, so the mesh
+      /// is identical to the one loaded serially. Geometries that are
+      /// skinned by a controller are always decoded serially. Parallel
+      /// decoding is disabled by default.
+      /// \param[in] _parallel True to decode geometries in parallel
+      /// \sa ParallelWorkerPool()
+      public: void SetParallel(const bool _parallel);
+
+      /// \brief Get whether geometries are decoded in parallel
+      /// \return True if geometries are decoded in parallel
+      /// \sa SetParallel(const bool)
+      public: bool Parallel() const;
+
       /// \internal
       /// \brief Pointer to private data.
       IGN_UTILS_IMPL_PTR(dataPtr)
@@ -17,6 +17,8 @@
 #ifndef IGNITION_COMMON_IMAGE_HH_
 #define IGNITION_COMMON_IMAGE_HH_
 
+#include <array>
+#include <cstddef>
 #include <limits>
 #include <memory>
 #include <string>
@@ -55,6 +57,8 @@ namespace ignition
       "BAYER_GRBG8"
     };
 
+    class ImageView;
+
     /// \class Image Image.hh ignition/common/common.hh
     /// \brief Encapsulates an image
     class IGNITION_COMMON_GRAPHICS_VISIBLE Image
@@ -84,6 +88,42 @@ namespace ignition
                 PIXEL_FORMAT_COUNT
               };
 
+      /// \brief Smallest, largest and mean value of every channel of a
+      /// set of pixels, in the units of their pixel format: [0, 255] for 8
+      /// bit channels, [0, 65535] for 16 bit channels and unscaled values
+      /// for float channels.
+      public: class ChannelStatistics
+      {
+        /// \brief Number of channels: 1 for luminance formats, 3 for RGB
+        /// formats and 4 for RGBA formats. Zero if there are no pixels.
+        public: unsigned int channels = 0u;
+
+        /// \brief Smallest value of every channel, in red, green, blue and
+        /// alpha order, whatever the order in memory.
+        public: std::array<double, 4> min{{0.0, 0.0, 0.0, 0.0}};
+
+        /// \brief Largest value of every channel.
+        public: std::array<double, 4> max{{0.0, 0.0, 0.0, 0.0}};
+
+        /// \brief Mean value of every channel.
+        public: std::array<double, 4> mean{{0.0, 0.0, 0.0, 0.0}};
+      };
+
+      /// \brief Filters used to resample images
+      public: enum class ResampleFilter
+      {
+        /// \brief Average of the pixels that a pixel covers. Nearest
+        /// pixel when enlarging.
+        BOX,
+
+        /// \brief Linear interpolation, widened to a tent over the pixels
+        /// that a pixel covers when shrinking.
+        BILINEAR,
+
+        /// \brief Lanczos windowed sinc with 3 lobes. Sharpest, and the
+        /// slowest.
+        LANCZOS3
+      };
 
       /// \brief Convert a string to a Image::PixelFormat.
       /// \param[in] _format Pixel format string. \sa Image::PixelFormatNames
@@ -126,6 +166,80 @@ namespace ignition
       /// \param[out] _count The resulting data array size
       public: void Data(unsigned char **_data, unsigned int &_count);
 
+      /// \brief Get the pixels of the image converted to a pixel format.
+      /// Rows are stored from top to bottom, without padding. The
+      /// conversion works on whole scanlines with vector instructions where
+      /// available.
+      ///
+      /// The supported formats are L_INT8, L_INT16, RGB_INT8, BGR_INT8,
+      /// RGBA_INT8, BGRA_INT8, RGB_INT16, BGR_INT16, R_FLOAT32 and
+      /// RGB_FLOAT32. Float channels hold values in [0, 1]. Colors are
+      /// turned into luminance with the weights 77, 150 and 29 out of 256
+      /// for red, green and blue.
+      /// \param[in] _format Pixel format of the output.
+      /// \param[out] _data The pixels. Its capacity is reused, so repeated
+      /// calls with the same vector do not allocate.
+      /// \return False if the image is not valid or the format is not
+      /// supported.
+      public: bool Data(const PixelFormatType _format,
+                  std::vector<unsigned char> &_data) const;
+
+      /// \brief Convert the pixels of the image into a buffer owned by the
+      /// caller, like Data(const PixelFormatType,
+      /// std::vector<unsigned char> &), without allocating.
+      /// \param[in] _format Pixel format of the output.
+      /// \param[out] _data Buffer for the pixels.
+      /// \param[in] _size Size of _data in bytes, at least
+      /// DataSize(_format, Width(), Height()).
+      /// \return False if the image is not valid, the format is not
+      /// supported or _data is too small.
+      public: bool Data(const PixelFormatType _format, unsigned char *_data,
+                  const std::size_t _size) const;
+
+      /// \brief Get the number of bytes of pixels without padding, in one of
+      /// the formats supported by Data(const PixelFormatType,
+      /// std::vector<unsigned char> &).
+      /// \param[in] _format Pixel format.
+      /// \param[in] _width Width in pixels.
+      /// \param[in] _height Height in pixels.
+      /// \return The number of bytes, or 0 if the format is not supported.
+      public: static std::size_t DataSize(const PixelFormatType _format,
+                  const unsigned int _width, const unsigned int _height);
+
+      /// \brief Get a view of the pixels of the image, as they are stored,
+      /// without copying them. The view is valid until the image is loaded,
+      /// set, rescaled or destroyed.
+      /// \return The view. It is empty if the image is not valid or stores
+      /// pixels in a format that is not supported by Data(const
+      /// PixelFormatType, std::vector<unsigned char> &), such as palettes.
+      public: ImageView View() const;
+
+      /// \brief Convert pixels between two of the formats supported by
+      /// Data(const PixelFormatType, std::vector<unsigned char> &). Rows
+      /// are converted in parallel.
+      /// \param[in] _src Pixels to convert, without padding between rows.
+      /// \param[in] _srcFormat Pixel format of _src.
+      /// \param[in] _width Width in pixels.
+      /// \param[in] _height Height in pixels.
+      /// \param[in] _dstFormat Pixel format of _dst.
+      /// \param[out] _dst Buffer for the converted pixels, which must not
+      /// overlap _src.
+      /// \return False if a format is not supported.
+      public: static bool ConvertPixels(const unsigned char *_src,
+                  const PixelFormatType _srcFormat, const unsigned int _width,
+                  const unsigned int _height, const PixelFormatType _dstFormat,
+                  unsigned char *_dst);
+
+      /// \brief Convert the pixels of a view, which may have padding
+      /// between rows or store them bottom up.
+      /// \param[in] _src Pixels to convert.
+      /// \param[in] _dstFormat Pixel format of _dst.
+      /// \param[out] _dst Buffer for the converted pixels, top row first
+      /// and without padding, which must not overlap _src.
+      /// \return False if a format is not supported.
+      public: static bool ConvertPixels(const ImageView &_src,
+                  const PixelFormatType _dstFormat, unsigned char *_dst);
+
       /// \brief Get only the RGB data from the image. This will drop the
       /// alpha channel if one is present.
       /// \param[out] _data Pointer to a NULL array of char.
@@ -171,11 +285,76 @@ namespace ignition
       /// \return The max color
       public: math::Color MaxColor() const;
 
-      /// \brief Rescale the image
+      /// \brief Get the statistics of every channel of the image, computed
+      /// on whole scanlines with vector instructions where available.
+      /// \return The statistics, with no channels if the image is not
+      /// valid.
+      public: ChannelStatistics Statistics() const;
+
+      /// \brief Get the statistics of every channel of pixels in one of
+      /// the formats supported by
+      /// Data(const PixelFormatType, std::vector<unsigned char> &). Infinite
+      /// and NaN values of float channels are left out.
+      /// \param[in] _data Pixels, without padding between rows.
+      /// \param[in] _width Width in pixels.
+      /// \param[in] _height Height in pixels.
+      /// \param[in] _format Pixel format of _data.
+      /// \return The statistics, with no channels if the format is not
+      /// supported or there are no pixels.
+      public: static ChannelStatistics Statistics(const unsigned char *_data,
+                  const unsigned int _width, const unsigned int _height,
+                  const PixelFormatType _format);
+
+      /// \brief Rescale the image with a Lanczos filter
       /// \param[in] _width New image width
       /// \param[in] _height New image height
       public: void Rescale(const int _width, const int _height);
 
+      /// \brief Rescale the image. Images in the formats supported by
+      /// Data(const PixelFormatType, std::vector<unsigned char> &) are
+      /// resampled in parallel blocks of rows, with vector instructions
+      /// where available, and keep their pixel format.
+      /// \param[in] _width New image width
+      /// \param[in] _height New image height
+      /// \param[in] _filter Filter to resample with
+      public: void Rescale(const int _width, const int _height,
+                  const ResampleFilter _filter);
+
+      /// \brief Resample pixels with a separable filter: rows are resampled
+      /// first, then columns, in parallel blocks of rows.
+      /// \param[in] _src Pixels to resample, in one of the formats
+      /// supported by Data(const PixelFormatType,
+      /// std::vector<unsigned char> &).
+      /// \param[in] _width Width of the output in pixels.
+      /// \param[in] _height Height of the output in pixels.
+      /// \param[in] _filter Filter to resample with.
+      /// \param[out] _dst Buffer for the resampled pixels, in the format of
+      /// _src, top row first and without padding. Must not overlap _src.
+      /// \return False if the format of _src is not supported or a size is
+      /// zero.
+      public: static bool Resample(const ImageView &_src,
+                  const unsigned int _width, const unsigned int _height,
+                  const ResampleFilter _filter, unsigned char *_dst);
+
+      /// \brief Compute the full chain of mipmaps of the image in one
+      /// buffer. The first level is the image converted to _format. Every
+      /// other level halves the size of the previous one, rounding down to
+      /// at least 1, and is resampled from it, down to 1x1.
+      /// \param[in] _format Pixel format of the mipmaps, one of the
+      /// formats supported by Data(const PixelFormatType,
+      /// std::vector<unsigned char> &).
+      /// \param[out] _data Pixels of all the levels. Its capacity is
+      /// reused.
+      /// \param[out] _levels Views of the levels in _data, largest first.
+      /// They are valid until _data is modified.
+      /// \param[in] _filter Filter to resample with.
+      /// \return False if the image is not valid or the format is not
+      /// supported.
+      public: bool Mipmaps(const PixelFormatType _format,
+                  std::vector<unsigned char> &_data,
+                  std::vector<ImageView> &_levels,
+                  const ResampleFilter _filter = ResampleFilter::BOX) const;
+
       /// \brief Returns whether this is a valid image
       /// \return true if image has a bitmap
       public: bool Valid() const;
@@ -257,6 +436,72 @@ namespace ignition
       /// \brief Private data pointer
       IGN_UTILS_IMPL_PTR(dataPtr)
     };
+
+    /// \brief Non-owning view of rows of pixels, such as the pixels of an
+    /// Image or a buffer of the caller. The view does not copy the pixels,
+    /// which must outlive it.
+    class IGNITION_COMMON_GRAPHICS_VISIBLE ImageView
+    {
+      /// \brief Constructor of an empty view
+      public: ImageView() = default;
+
+      /// \brief Constructor
+      /// \param[in] _data First byte of the top row.
+      /// \param[in] _width Width in pixels.
+      /// \param[in] _height Height in pixels.
+      /// \param[in] _pitch Number of bytes from the start of a row to the
+      /// start of the row below it. It is negative if rows are stored
+      /// bottom up.
+      /// \param[in] _format Pixel format.
+      public: ImageView(const unsigned char *_data, const unsigned int _width,
+                  const unsigned int _height, const std::ptrdiff_t _pitch,
+                  const Image::PixelFormatType _format);
+
+      /// \brief Get the first byte of the top row
+      /// \return Pointer to the pixels, or nullptr if the view is empty
+      public: const unsigned char *Data() const;
+
+      /// \brief Get a row of pixels
+      /// \param[in] _y Row, from 0 at the top to Height() - 1
+      /// \return Pointer to the first byte of the row
+      public: const unsigned char *Row(const unsigned int _y) const;
+
+      /// \brief Get the width
+      /// \return The width in pixels
+      public: unsigned int Width() const;
+
+      /// \brief Get the height
+      /// \return The height in pixels
+      public: unsigned int Height() const;
+
+      /// \brief Get the number of bytes from a row to the row below it
+      /// \return The pitch, negative if rows are stored bottom up
+      public: std::ptrdiff_t Pitch() const;
+
+      /// \brief Get the pixel format
+      /// \return The pixel format
+      public: Image::PixelFormatType PixelFormat() const;
+
+      /// \brief Returns whether the view has pixels
+      /// \return True if the view is not empty
+      public: bool Valid() const;
+
+      /// \brief First byte of the top row
+      private: const unsigned char *data = nullptr;
+
+      /// \brief Width in pixels
+      private: unsigned int width = 0u;
+
+      /// \brief Height in pixels
+      private: unsigned int height = 0u;
+
+      /// \brief Bytes from a row to the row below it
+      private: std::ptrdiff_t pitch = 0;
+
+      /// \brief Pixel format
+      private: Image::PixelFormatType format =
+                   Image::UNKNOWN_PIXEL_FORMAT;
+    };
   }
 }
 #endif
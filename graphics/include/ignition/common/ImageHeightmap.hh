@@ -30,6 +30,9 @@ namespace ignition
   namespace common
   {
     /// \brief Encapsulates an image that will be interpreted as a heightmap.
+    /// Heights come from the red channel of the pixels, at the precision of
+    /// their format: 8 and 16 bit channels are scaled to [0, 1], and float
+    /// channels are used as they are.
     class IGNITION_COMMON_GRAPHICS_VISIBLE ImageHeightmap
       : public ignition::common::HeightmapData
     {
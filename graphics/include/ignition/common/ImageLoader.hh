@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_COMMON_IMAGELOADER_HH_
+#define IGNITION_COMMON_IMAGELOADER_HH_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ignition/utils/ImplPtr.hh>
+
+#include <ignition/common/SingletonT.hh>
+#include <ignition/common/TaskFuture.hh>
+#include <ignition/common/graphics/Export.hh>
+
+namespace ignition
+{
+  namespace common
+  {
+    /// \brief forward declaration
+    class Image;
+    class Material;
+
+    /// \class ImageLoader ImageLoader.hh ignition/common/ImageLoader.hh
+    /// \brief Loads images on ParallelWorkerPool(), and keeps the images it
+    /// loaded in a cache bounded in bytes, so that images shared by several
+    /// materials are decoded once per process.
+    ///
+    /// Images are keyed by the path that the file name resolves to with
+    /// findFile. Concurrent requests for the same image share a single
+    /// decode. When the cache holds more bytes than its capacity, the least
+    /// recently used images are dropped from it. Images that were handed
+    /// out stay valid for as long as they are referenced.
+    class IGNITION_COMMON_GRAPHICS_VISIBLE ImageLoader
+        : public SingletonT<ImageLoader>
+    {
+      /// \brief Receives every image of a batch as soon as it is loaded.
+      /// \param[in] _index Index of the image in the batch.
+      /// \param[in] _filename File name of the image, as requested.
+      /// \param[in] _image The image, or nullptr if it could not be loaded.
+      public: using ImageCallback = std::function<void(
+                  const std::size_t _index, const std::string &_filename,
+                  const std::shared_ptr<const Image> &_image)>;
+
+      /// \brief Receives the progress of a batch, after every image.
+      /// \param[in] _done Number of images of the batch that are loaded or
+      /// failed to load.
+      /// \param[in] _total Number of images in the batch.
+      public: using ProgressCallback = std::function<void(
+                  const std::size_t _done, const std::size_t _total)>;
+
+      /// \brief Constructor
+      private: ImageLoader();
+
+      /// \brief Destructor
+      private: virtual ~ImageLoader();
+
+      /// \brief Load an image on the calling thread, or get it from the
+      /// cache. An exception thrown while decoding the file is rethrown to
+      /// every request waiting for the same file, and a later request tries
+      /// again.
+      /// \param[in] _filename Path of the image, searched with findFile.
+      /// \return The image, or nullptr if it could not be loaded.
+      public: std::shared_ptr<const Image> Load(const std::string &_filename);
+
+      /// \brief Load an image in the background.
+      /// \param[in] _filename Path of the image, searched with findFile.
+      /// \return A future holding the image, or nullptr if it could not be
+      /// loaded.
+      public: TaskFuture<std::shared_ptr<const Image>> LoadAsync(
+                  const std::string &_filename);
+
+      /// \brief Load several images in parallel in the background.
+      ///
+      /// The callbacks run on the worker threads, as images finish loading,
+      /// and never run concurrently for the same batch.
+      /// \param[in] _filenames Paths of the images, searched with findFile.
+      /// \param[in] _onImage Called with every image. May be empty.
+      /// \param[in] _onProgress Called after every image. May be empty.
+      /// \return A future holding the images in the order of _filenames,
+      /// with nullptr for images that could not be loaded. It is ready
+      /// after every callback has returned.
+      public: TaskFuture<std::vector<std::shared_ptr<const Image>>>
+              LoadBatch(const std::vector<std::string> &_filenames,
+                  const ImageCallback &_onImage = ImageCallback(),
+                  const ProgressCallback &_onProgress = ProgressCallback());
+
+      /// \brief Load the texture image and the maps of the PBR material of
+      /// a material in parallel in the background.
+      /// \param[in] _material Material whose textures are loaded.
+      /// \param[in] _onImage Called with every image. May be empty.
+      /// \param[in] _onProgress Called after every image. May be empty.
+      /// \return Same as LoadBatch, for the paths of TexturePaths(_material).
+      /// \sa LoadBatch
+      public: TaskFuture<std::vector<std::shared_ptr<const Image>>>
+              LoadTextures(const Material &_material,
+                  const ImageCallback &_onImage = ImageCallback(),
+                  const ProgressCallback &_onProgress = ProgressCallback());
+
+      /// \brief Get the paths of the images used by a material: its
+      /// texture image, then the albedo, normal, roughness, metalness,
+      /// ambient occlusion, emissive, light, environment, glossiness and
+      /// specular maps of its PBR material. Empty paths are skipped.
+      /// \param[in] _material Material.
+      /// \return The paths, without duplicates.
+      public: static std::vector<std::string> TexturePaths(
+                  const Material &_material);
+
+      /// \brief Set the maximum number of bytes of pixels held by the cache.
+      /// Images are dropped from the cache when it shrinks below its size.
+      /// Images larger than the capacity are not cached. The default is
+      /// 256 MiB.
+      /// \param[in] _bytes Capacity in bytes. 0 disables the cache.
+      public: void SetCacheCapacity(const std::size_t _bytes);
+
+      /// \brief Get the maximum number of bytes of pixels held by the cache.
+      /// \return Capacity in bytes.
+      public: std::size_t CacheCapacity() const;
+
+      /// \brief Get the number of bytes of pixels held by the cache.
+      /// \return Size in bytes.
+      public: std::size_t CacheSize() const;
+
+      /// \brief Get the number of images held by the cache.
+      /// \return Number of images.
+      public: std::size_t CachedImageCount() const;
+
+      /// \brief Check whether the cache holds an image.
+      /// \param[in] _filename Path of the image, searched with findFile.
+      /// \return True if the image is in the cache.
+      public: bool IsCached(const std::string &_filename) const;
+
+      /// \brief Drop every image from the cache.
+      public: void ClearCache();
+
+      /// \brief Private data pointer.
+      IGN_UTILS_UNIQUE_IMPL_PTR(dataPtr)
+
+      /// \brief Singleton implementation
+      private: friend class SingletonT<ImageLoader>;
+    };
+  }
+}
+#endif
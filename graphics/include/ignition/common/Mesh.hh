@@ -17,6 +17,7 @@
 #ifndef IGNITION_COMMON_MESH_HH_
 #define IGNITION_COMMON_MESH_HH_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -28,6 +29,7 @@
 
 #include <ignition/common/graphics/Types.hh>
 #include <ignition/common/graphics/Export.hh>
+#include <ignition/common/SubMesh.hh>
 
 namespace ignition
 {
@@ -141,10 +143,56 @@ namespace ignition
       /// \param[out] _indArr the index array
       public: void FillArrays(double **_vertArr, int **_indArr) const;
 
+      /// \brief Copy the positions and indices of all submeshes into
+      /// buffers owned by the caller, in one pass and without allocating.
+      /// Positions are concatenated in submesh order, and the indices of
+      /// each submesh are offset by the number of vertices of the submeshes
+      /// before it, so that they refer to the concatenated positions.
+      /// \param[out] _vertices Buffer with room for VertexCount() * 3
+      /// values, or nullptr to skip the positions.
+      /// \param[out] _indices Buffer with room for IndexCount() values, or
+      /// nullptr to skip the indices.
+      /// \return False if an index does not fit in the index type, in which
+      /// case nothing is written.
+      public: bool FillBuffers(float *_vertices, uint32_t *_indices) const;
+
+      /// \brief Same as FillBuffers above, with double precision positions.
+      /// \param[out] _vertices Buffer for VertexCount() * 3 values, or
+      /// nullptr.
+      /// \param[out] _indices Buffer for IndexCount() values, or nullptr.
+      /// \return False if an index does not fit in the index type.
+      public: bool FillBuffers(double *_vertices, uint32_t *_indices) const;
+
+      /// \brief Same as FillBuffers above, with 16 bit indices.
+      /// \param[out] _vertices Buffer for VertexCount() * 3 values, or
+      /// nullptr.
+      /// \param[out] _indices Buffer for IndexCount() values, or nullptr.
+      /// \return False if an index does not fit in 16 bits.
+      public: bool FillBuffers(float *_vertices, uint16_t *_indices) const;
+
+      /// \brief Same as FillBuffers above, with double precision positions
+      /// and 16 bit indices.
+      /// \param[out] _vertices Buffer for VertexCount() * 3 values, or
+      /// nullptr.
+      /// \param[out] _indices Buffer for IndexCount() values, or nullptr.
+      /// \return False if an index does not fit in 16 bits.
+      public: bool FillBuffers(double *_vertices, uint16_t *_indices) const;
+
       /// \brief Recalculate all the normals of each face defined by three
       /// indices.
       public: void RecalculateNormals();
 
+      /// \brief Recalculate all the normals of each face defined by three
+      /// indices.
+      /// \param[in] _weighting How the normals of the faces around a vertex
+      /// are combined.
+      /// \param[in] _weld True to combine the faces of every vertex that has
+      /// the same position, false to only combine the faces that reference a
+      /// vertex.
+      /// \sa SubMesh::RecalculateNormals(SubMesh::NormalWeighting, bool)
+      public: void RecalculateNormals(
+                  const SubMesh::NormalWeighting _weighting, const bool _weld);
+
       /// \brief Get axis-aligned bounding box in the mesh frame
       /// \param[out] _center Center of the bounding box
       /// \param[out] _minXYZ Bounding box minimum values
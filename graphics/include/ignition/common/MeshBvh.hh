@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_COMMON_MESHBVH_HH_
+#define IGNITION_COMMON_MESHBVH_HH_
+
+#include <limits>
+#include <vector>
+
+#include <ignition/math/AxisAlignedBox.hh>
+#include <ignition/math/Vector3.hh>
+#include <ignition/utils/ImplPtr.hh>
+
+#include <ignition/common/graphics/Export.hh>
+
+namespace ignition
+{
+  namespace common
+  {
+    class Mesh;
+
+    /// \class MeshBvh MeshBvh.hh ignition/common/MeshBvh.hh
+    /// \brief Bounding volume hierarchy over the triangles of a mesh, which
+    /// answers ray, closest point and box overlap queries in logarithmic
+    /// time.
+    ///
+    /// The hierarchy is built top down with the surface area heuristic,
+    /// with large subtrees built in parallel, and stored as a flat array of
+    /// 4-wide nodes. Each node holds the boxes of its four children side by
+    /// side, so a ray is tested against all of them at once with SIMD
+    /// instructions where available. Triangle corners are copied in leaf
+    /// order, so queries do not touch the submeshes.
+    ///
+    /// Only indexed triangle lists are included. The hierarchy keeps the
+    /// submeshes of the mesh alive, and Update() refits it after vertices
+    /// were moved, for example with SubMesh::SetVertex. Queries are const
+    /// and may run concurrently, but not concurrently with Build() or
+    /// Update().
+    class IGNITION_COMMON_GRAPHICS_VISIBLE MeshBvh
+    {
+      /// \brief Result of a query.
+      public: class Hit
+      {
+        /// \brief Index of the submesh in the mesh.
+        public: unsigned int subMesh = 0u;
+
+        /// \brief Index of the triangle in the submesh. Its corners are
+        /// the indices 3 * triangle to 3 * triangle + 2.
+        public: unsigned int triangle = 0u;
+
+        /// \brief Distance from the ray origin or from the query point.
+        public: double distance = 0.0;
+
+        /// \brief Point on the triangle.
+        public: math::Vector3d point;
+
+        /// \brief Unit normal of the triangle, following the winding of
+        /// its corners.
+        public: math::Vector3d normal;
+      };
+
+      /// \brief Constructor. The hierarchy is empty until Build() is called.
+      public: MeshBvh();
+
+      /// \brief Destructor
+      public: ~MeshBvh();
+
+      /// \brief Build the hierarchy over the triangles of a mesh, replacing
+      /// the previous one.
+      /// \param[in] _mesh Mesh to build the hierarchy for. Submeshes that
+      /// are not indexed triangle lists, and triangles with invalid indices,
+      /// are skipped.
+      public: void Build(const Mesh &_mesh);
+
+      /// \brief Bring the hierarchy up to date with its submeshes. Boxes are
+      /// refit when vertices were moved, and the hierarchy is rebuilt when
+      /// indices or the number of vertices changed.
+      /// \return True if anything changed.
+      /// \sa SubMesh::VertexRevision, SubMesh::IndexRevision
+      public: bool Update();
+
+      /// \brief Check whether Update() would change anything. Unlike
+      /// Update(), this only reads the hierarchy.
+      /// \return True if no submesh changed since the last build or refit.
+      public: bool UpToDate() const;
+
+      /// \brief Get the number of triangles in the hierarchy.
+      /// \return Number of triangles.
+      public: unsigned int TriangleCount() const;
+
+      /// \brief Get the number of nodes in the hierarchy.
+      /// \return Number of 4-wide nodes.
+      public: unsigned int NodeCount() const;
+
+      /// \brief Get the box that bounds all triangles.
+      /// \return The box, which is empty if there are no triangles.
+      public: math::AxisAlignedBox BoundingBox() const;
+
+      /// \brief Find the first triangle hit by a ray.
+      /// \param[in] _origin Origin of the ray.
+      /// \param[in] _direction Direction of the ray, which doesn't need to
+      /// be normalized.
+      /// \param[out] _hit The closest hit, if any.
+      /// \param[in] _maxDistance Largest distance from the origin.
+      /// \return True if a triangle was hit.
+      public: bool Raycast(const math::Vector3d &_origin,
+                  const math::Vector3d &_direction, Hit &_hit,
+                  const double _maxDistance =
+                    std::numeric_limits<double>::infinity()) const;
+
+      /// \brief Find the point on the triangles closest to a point.
+      /// \param[in] _point Query point.
+      /// \param[out] _hit The closest point, if any.
+      /// \param[in] _maxDistance Largest distance from _point.
+      /// \return True if a triangle is within _maxDistance.
+      public: bool ClosestPoint(const math::Vector3d &_point, Hit &_hit,
+                  const double _maxDistance =
+                    std::numeric_limits<double>::infinity()) const;
+
+      /// \brief Find the triangles that intersect a box.
+      /// \param[in] _box Query box.
+      /// \param[out] _hits Receives one hit per intersecting triangle, in
+      /// no particular order. Only subMesh, triangle and normal are set.
+      /// The vector is cleared first, and its capacity is reused.
+      public: void Overlap(const math::AxisAlignedBox &_box,
+                  std::vector<Hit> &_hits) const;
+
+      /// \brief Private data pointer.
+      IGN_UTILS_IMPL_PTR(dataPtr)
+    };
+  }
+}
+#endif
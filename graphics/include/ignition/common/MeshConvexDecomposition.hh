@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_COMMON_MESHCONVEXDECOMPOSITION_HH_
+#define IGNITION_COMMON_MESHCONVEXDECOMPOSITION_HH_
+
+#include <memory>
+#include <vector>
+
+#include <ignition/utils/ImplPtr.hh>
+
+#include <ignition/common/graphics/Export.hh>
+
+namespace ignition
+{
+  namespace common
+  {
+    class Mesh;
+    class SubMesh;
+
+    /// \class MeshConvexDecomposition MeshConvexDecomposition.hh
+    /// ignition/common/MeshConvexDecomposition.hh
+    /// \brief Computes convex hulls and approximate convex decompositions of
+    /// meshes, for example to create collision shapes.
+    ///
+    /// Hulls are computed with the quickhull algorithm. A decomposition
+    /// starts from all the triangles of a submesh and recursively cuts them
+    /// with the axis aligned plane whose sides have the smallest hulls, until
+    /// every piece is convex enough or the number of pieces reaches the
+    /// limit. The concavity of a piece is the largest depth of its surface
+    /// below the surface of its convex hull. Pieces of closed submeshes are
+    /// capped where they are cut, and are also cut while their hull holds
+    /// too much empty space. Pieces are cut in parallel, and the candidate
+    /// planes of every cut are evaluated in parallel. The hulls of the
+    /// pieces are the result, merged down to the limit when it is not a
+    /// power of two.
+    ///
+    /// Flat pieces have no volume and produce no hull.
+    class IGNITION_COMMON_GRAPHICS_VISIBLE MeshConvexDecomposition
+    {
+      /// \brief Constructor
+      public: MeshConvexDecomposition();
+
+      /// \brief Destructor
+      public: ~MeshConvexDecomposition();
+
+      /// \brief Set the largest number of convex hulls a submesh is
+      /// decomposed into. The default is 16.
+      /// \param[in] _count Largest number of hulls, at least 1.
+      public: void SetMaxConvexHulls(const unsigned int _count);
+
+      /// \brief Get the largest number of convex hulls of a submesh.
+      /// \return Largest number of hulls.
+      public: unsigned int MaxConvexHulls() const;
+
+      /// \brief Set the largest number of vertices of a hull. Hulls with
+      /// more vertices are approximated by the hull of the vertices farthest
+      /// out. The default is 64.
+      /// \param[in] _count Largest number of vertices, at least 4.
+      public: void SetMaxVerticesPerHull(const unsigned int _count);
+
+      /// \brief Get the largest number of vertices of a hull.
+      /// \return Largest number of vertices.
+      public: unsigned int MaxVerticesPerHull() const;
+
+      /// \brief Set the concavity below which a piece is not cut, as a
+      /// fraction of the diagonal of the bounding box of the submesh. The
+      /// default is 0.01.
+      /// \param[in] _concavity Largest concavity.
+      public: void SetMaxConcavity(const double _concavity);
+
+      /// \brief Get the concavity below which a piece is not cut.
+      /// \return Largest concavity, as a fraction of the diagonal of the
+      /// bounding box of the submesh.
+      public: double MaxConcavity() const;
+
+      /// \brief Compute the convex hull of the vertices of a submesh.
+      /// \param[in] _subMesh Submesh. Only its vertices are used.
+      /// \return The hull, as an indexed triangle list with outward facing
+      /// triangles and at most MaxVerticesPerHull() vertices, or nullptr if
+      /// the vertices are all on a plane.
+      public: std::unique_ptr<SubMesh> ConvexHull(
+                  const SubMesh &_subMesh) const;
+
+      /// \brief Decompose a submesh into convex hulls.
+      /// \param[in] _subMesh Indexed triangle list to decompose.
+      /// \return The hulls, as indexed triangle lists with outward facing
+      /// triangles. Empty if _subMesh is not an indexed triangle list with
+      /// valid indices, or if it is flat.
+      public: std::vector<std::unique_ptr<SubMesh>> Decompose(
+                  const SubMesh &_subMesh) const;
+
+      /// \brief Decompose every submesh of a mesh into convex hulls.
+      /// Submeshes are decomposed in parallel.
+      /// \param[in] _mesh Mesh to decompose.
+      /// \return A mesh with the name and path of _mesh, and one submesh
+      /// per hull. The hulls of a submesh named "name" are named
+      /// "name_convex_<i>" and have its material index. Materials are shared
+      /// with _mesh.
+      public: std::unique_ptr<Mesh> Decompose(const Mesh &_mesh) const;
+
+      /// \brief Private data pointer.
+      IGN_UTILS_IMPL_PTR(dataPtr)
+    };
+  }
+}
+#endif
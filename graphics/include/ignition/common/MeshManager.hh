@@ -17,6 +17,7 @@
 #ifndef IGNITION_COMMON_MESHMANAGER_HH_
 #define IGNITION_COMMON_MESHMANAGER_HH_
 
+#include <cstdint>
 #include <map>
 #include <utility>
 #include <string>
@@ -34,6 +35,7 @@
 
 #include <ignition/common/graphics/Types.hh>
 #include <ignition/common/SingletonT.hh>
+#include <ignition/common/TaskFuture.hh>
 #include <ignition/common/graphics/Export.hh>
 
 namespace ignition
@@ -42,6 +44,7 @@ namespace ignition
   {
     /// \brief forward declaration
     class Mesh;
+    class MeshBvh;
     class SubMesh;
 
     /// \class MeshManager MeshManager.hh ignition/common/MeshManager.hh
@@ -57,6 +60,20 @@ namespace ignition
       /// Destroys the collada loader, the stl loader and all the meshes
       private: virtual ~MeshManager();
 
+      /// \brief How cached meshes are matched with mesh files.
+      /// \sa SetCacheDirectory
+      public: enum class CacheKey
+      {
+        /// \brief Path, size and modification time of the file. This is
+        /// cheap, but misses changes that keep the size and time, as well
+        /// as changes to files the mesh refers to, such as OBJ materials.
+        FILE_STATS = 0,
+
+        /// \brief SHA-1 of the content of the file. The file is read on
+        /// every load, and identical files share a cache entry.
+        CONTENT_SHA1 = 1
+      };
+
       /// \brief Load a mesh from a file.
       /// The mesh will be searched on the global SystemPaths instance provided
       /// by Util.hh.
@@ -64,10 +81,71 @@ namespace ignition
       /// \return a pointer to the created mesh
       public: const Mesh *Load(const std::string &_filename);
 
+      /// \brief Load a mesh from a file in the background.
+      /// The file is decoded on ParallelWorkerPool(). Concurrent requests for
+      /// the same file, including calls to Load and LoadBatch, share a single
+      /// decode and return the same mesh. The manager is only locked while
+      /// the mesh is looked up and inserted, not while the file is decoded.
+      /// \param[in] _filename the path to the mesh
+      /// \return A future holding a pointer to the mesh, or nullptr if the
+      /// mesh could not be loaded.
+      public: TaskFuture<const Mesh *> LoadAsync(const std::string &_filename);
+
+      /// \brief Load several meshes from files concurrently, and wait for
+      /// all of them. The files are decoded on ParallelWorkerPool() and on
+      /// the calling thread, so that the load time scales with the number of
+      /// cores. Duplicate names share a single decode.
+      /// \param[in] _filenames the paths to the meshes
+      /// \return The meshes in the order of _filenames, with nullptr for
+      /// meshes that could not be loaded, including those whose loader
+      /// threw.
+      public: std::vector<const Mesh *> LoadBatch(
+                  const std::vector<std::string> &_filenames);
+
+      /// \brief Enable the on-disk cache of meshes loaded from files.
+      ///
+      /// When enabled, Load stores every mesh it parses in the cache
+      /// directory, in a versioned binary format that holds the fully
+      /// processed mesh: submeshes, materials, skeleton and animations.
+      /// Later loads of the same file, also by other processes, map the
+      /// cached mesh instead of parsing the file again. Cache files that
+      /// are stale, corrupt or from another format version are ignored and
+      /// replaced.
+      /// \param[in] _path Directory of the cache, created when needed. An
+      /// empty path disables the cache, which is the default.
+      /// \sa SetCacheKey
+      public: void SetCacheDirectory(const std::string &_path);
+
+      /// \brief Get the directory of the on-disk mesh cache.
+      /// \return The directory, or an empty string if the cache is
+      /// disabled.
+      public: std::string CacheDirectory() const;
+
+      /// \brief Set how cached meshes are matched with mesh files. The
+      /// default is CacheKey::FILE_STATS.
+      /// \param[in] _key The kind of key.
+      public: void SetCacheKey(const CacheKey _key);
+
+      /// \brief Get how cached meshes are matched with mesh files.
+      /// \return The kind of key.
+      public: CacheKey CacheKeyType() const;
+
+      /// \brief Set whether meshes loaded from files are optimized with
+      /// MeshOptimizer, which reorders their triangles and vertices for
+      /// cache locality. When the on-disk cache is enabled, it holds the
+      /// optimized meshes. The default is false.
+      /// \param[in] _optimize True to optimize loaded meshes.
+      public: void SetMeshOptimization(const bool _optimize);
+
+      /// \brief Get whether meshes loaded from files are optimized.
+      /// \return True if loaded meshes are optimized.
+      public: bool MeshOptimization() const;
+
       /// \brief Export a mesh to a file
       /// \param[in] _mesh Pointer to the mesh to be exported
       /// \param[in] _filename Exported file's path and name
-      /// \param[in] _extension Exported file's format ("dae" for Collada)
+      /// \param[in] _extension Exported file's format ("dae" for Collada,
+      /// "ignmesh" for the native binary format)
       /// \param[in] _exportTextures True to export texture images to
       /// '../materials/textures' folder
       public: void Export(const Mesh *_mesh, const std::string &_filename,
@@ -110,6 +188,74 @@ namespace ignition
       /// \param[in] _name the name of the mesh
       public: bool HasMesh(const std::string &_name) const;
 
+      /// \brief Create levels of detail of a mesh with MeshSimplifier and
+      /// add them to the manager. Level i is named "<_name>::lod<i>" and is
+      /// simplified from level i - 1, keeping _ratio of its triangles.
+      /// Nothing is done if all the levels exist.
+      /// \param[in] _name Name of the mesh, which is level 0.
+      /// \param[in] _levels Number of levels to create.
+      /// \param[in] _ratio Fraction of the triangles of a level kept by the
+      /// next level, between 0 and 1.
+      /// \return False if no mesh is named _name.
+      public: bool CreateLods(const std::string &_name,
+                  const unsigned int _levels, const double _ratio = 0.5);
+
+      /// \brief Get a level of detail created by CreateLods.
+      /// \param[in] _name Name of the mesh.
+      /// \param[in] _level Level, 0 for the mesh itself.
+      /// \return The level, or nullptr if it does not exist.
+      public: const Mesh *MeshLod(const std::string &_name,
+                  const unsigned int _level) const;
+
+      /// \brief Get a bounding volume hierarchy of a mesh, for ray, closest
+      /// point and box overlap queries. It is built on the first call for a
+      /// mesh. When the mesh has changed since, later calls refit a copy of
+      /// it to the current vertices and hand out the copy from then on.
+      /// Hierarchies are never modified once handed out, so they may be
+      /// queried from several threads while other threads call Bvh.
+      /// \param[in] _name Name of the mesh.
+      /// \return The hierarchy, or nullptr if no mesh is named _name.
+      public: std::shared_ptr<const MeshBvh> Bvh(const std::string &_name);
+
+      /// \brief Get an approximate convex decomposition of a mesh, for
+      /// collision shapes. It is computed with MeshConvexDecomposition on
+      /// the first call for a mesh, and added to the manager as
+      /// "<_name>::convex", with one submesh per convex hull. Later calls
+      /// return it without computing anything, whatever their arguments.
+      /// \param[in] _name Name of the mesh.
+      /// \param[in] _maxConvexHulls Largest number of hulls per submesh.
+      /// \param[in] _maxVerticesPerHull Largest number of vertices of a
+      /// hull.
+      /// \return The decomposition, or nullptr if no mesh is named _name.
+      public: const Mesh *ConvexDecomposition(const std::string &_name,
+                  const unsigned int _maxConvexHulls = 16,
+                  const unsigned int _maxVerticesPerHull = 64);
+
+      /// \brief Get the number of mesh lookups that found a mesh.
+      /// Only lookups by MeshByName and HasMesh are counted, not the checks
+      /// the manager makes itself. Lookups take a read lock on one of
+      /// several shards of the mesh map, and never wait for a mesh that is
+      /// being loaded or built: a mesh is only inserted once it is
+      /// complete. Pointers to meshes stay valid until the manager is
+      /// destroyed.
+      /// \return Number of hits since the last ResetLookupCounters.
+      public: uint64_t LookupHits() const;
+
+      /// \brief Get the number of mesh lookups that found no mesh.
+      /// \return Number of misses since the last ResetLookupCounters.
+      /// \sa LookupHits
+      public: uint64_t LookupMisses() const;
+
+      /// \brief Get the number of mesh lookups that had to wait while a
+      /// mesh was inserted in the same shard of the mesh map.
+      /// \return Number of contended lookups since the last
+      /// ResetLookupCounters.
+      /// \sa LookupHits
+      public: uint64_t LookupContentions() const;
+
+      /// \brief Set the lookup counters to zero.
+      public: void ResetLookupCounters();
+
       /// \brief Create a sphere mesh.
       /// \param[in] _name the name of the mesh
       /// \param[in] _radius radius of the sphere in meter
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_COMMON_MESHOPTIMIZER_HH_
+#define IGNITION_COMMON_MESHOPTIMIZER_HH_
+
+#include <ignition/utils/ImplPtr.hh>
+
+#include <ignition/common/graphics/Export.hh>
+
+namespace ignition
+{
+  namespace common
+  {
+    class Mesh;
+    class SubMesh;
+
+    /// \class MeshOptimizer MeshOptimizer.hh ignition/common/MeshOptimizer.hh
+    /// \brief Reorders the triangles and vertices of meshes so that they
+    /// are rendered and traversed with fewer cache misses.
+    ///
+    /// Triangles are ordered for the post-transform vertex cache with the
+    /// Tipsify algorithm, which runs in linear time. The clusters it
+    /// produces are then sorted so that triangles facing away from the
+    /// center of the mesh come first, which reduces overdraw, as long as
+    /// that keeps the cache efficiency within OverdrawThreshold(). Last,
+    /// vertices are renumbered in the order triangles first use them, for
+    /// locality of vertex fetches.
+    ///
+    /// Cache efficiency is measured as the average cache miss ratio
+    /// (ACMR): the number of vertices transformed per triangle by a FIFO
+    /// cache of CacheSize() entries. It ranges from 3 down to about 0.5.
+    ///
+    /// Only indexed triangle lists are optimized. Other submeshes are left
+    /// unchanged.
+    class IGNITION_COMMON_GRAPHICS_VISIBLE MeshOptimizer
+    {
+      /// \brief Constructor
+      public: MeshOptimizer();
+
+      /// \brief Destructor
+      public: ~MeshOptimizer();
+
+      /// \brief Set the number of entries of the vertex cache that
+      /// triangles are ordered for, and that ACMR is measured with. The
+      /// default is 16.
+      /// \param[in] _size Number of vertices, at least 3.
+      public: void SetCacheSize(const unsigned int _size);
+
+      /// \brief Get the number of entries of the vertex cache.
+      /// \return Number of vertices.
+      public: unsigned int CacheSize() const;
+
+      /// \brief Set how much cache efficiency may be traded for less
+      /// overdraw. Triangle clusters are sorted for overdraw only if the
+      /// ACMR after sorting is at most _threshold times the ACMR before.
+      /// The default is 1.05. A value below 1 disables sorting.
+      /// \param[in] _threshold Largest accepted ratio of ACMR values.
+      public: void SetOverdrawThreshold(const double _threshold);
+
+      /// \brief Get how much cache efficiency may be traded for less
+      /// overdraw.
+      /// \return Largest accepted ratio of ACMR values.
+      public: double OverdrawThreshold() const;
+
+      /// \brief Optimize every submesh of a mesh. Submeshes are processed
+      /// in parallel.
+      /// \param[in,out] _mesh Mesh to optimize.
+      public: void Optimize(Mesh &_mesh);
+
+      /// \brief Optimize a submesh.
+      /// \param[in,out] _subMesh Submesh to optimize.
+      /// \return False if the submesh is not an indexed triangle list with
+      /// valid indices and per vertex attributes, in which case it is left
+      /// unchanged.
+      public: bool Optimize(SubMesh &_subMesh);
+
+      /// \brief Get the ACMR of the triangles optimized by the last call to
+      /// Optimize, before they were reordered.
+      /// \return Vertices transformed per triangle, or 0 if there were no
+      /// triangles.
+      public: double AcmrBefore() const;
+
+      /// \brief Get the ACMR of the triangles optimized by the last call to
+      /// Optimize, after they were reordered.
+      /// \return Vertices transformed per triangle, or 0 if there were no
+      /// triangles.
+      public: double AcmrAfter() const;
+
+      /// \brief Measure the ACMR of a submesh.
+      /// \param[in] _subMesh Indexed triangle list.
+      /// \param[in] _cacheSize Number of entries of the FIFO vertex cache.
+      /// \return Vertices transformed per triangle, or 0 if _subMesh has no
+      /// triangles.
+      public: static double Acmr(const SubMesh &_subMesh,
+                  const unsigned int _cacheSize = 16u);
+
+      /// \brief Private data pointer.
+      IGN_UTILS_IMPL_PTR(dataPtr)
+    };
+  }
+}
+#endif
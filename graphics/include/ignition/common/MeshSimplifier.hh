@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_COMMON_MESHSIMPLIFIER_HH_
+#define IGNITION_COMMON_MESHSIMPLIFIER_HH_
+
+#include <memory>
+#include <vector>
+
+#include <ignition/utils/ImplPtr.hh>
+
+#include <ignition/common/graphics/Export.hh>
+
+namespace ignition
+{
+  namespace common
+  {
+    class Mesh;
+    class SubMesh;
+
+    /// \class MeshSimplifier MeshSimplifier.hh
+    /// ignition/common/MeshSimplifier.hh
+    /// \brief Reduces the number of triangles of meshes, for example to
+    /// create levels of detail or collision shapes.
+    ///
+    /// Triangles are removed by collapsing an edge onto one of its
+    /// vertices, in the order of the quadric error metric of Garland and
+    /// Heckbert. Since collapses only keep existing vertices, normals,
+    /// texture coordinates and node assignments (skin weights) are
+    /// preserved exactly. Vertices on a texture seam or on a border only
+    /// move along it, and vertices where seams or borders meet never move,
+    /// so the outline of texture charts and of open surfaces is kept.
+    /// Collapses that would flip a triangle or make the surface non
+    /// manifold are skipped.
+    ///
+    /// The error of a collapse is the root mean square distance of the
+    /// remaining vertex to the planes of the original triangles merged
+    /// into it, in mesh units.
+    class IGNITION_COMMON_GRAPHICS_VISIBLE MeshSimplifier
+    {
+      /// \brief Constructor
+      public: MeshSimplifier();
+
+      /// \brief Destructor
+      public: ~MeshSimplifier();
+
+      /// \brief Set the largest error of a collapse. Simplification stops
+      /// before the target triangle count when no collapse with a smaller
+      /// error is left. The default is infinity, which only stops at the
+      /// target.
+      /// \param[in] _error Largest error, in mesh units.
+      public: void SetMaxError(const double _error);
+
+      /// \brief Get the largest error of a collapse.
+      /// \return Largest error, in mesh units.
+      public: double MaxError() const;
+
+      /// \brief Create a simplified copy of a submesh.
+      /// \param[in] _subMesh Indexed triangle list to simplify.
+      /// \param[in] _targetTriangles Number of triangles to reduce to.
+      /// \return The simplified submesh, with unused vertices removed, or
+      /// nullptr if _subMesh is not an indexed triangle list with valid
+      /// indices and per vertex attributes.
+      public: std::unique_ptr<SubMesh> Simplify(const SubMesh &_subMesh,
+                  const unsigned int _targetTriangles);
+
+      /// \brief Create a simplified copy of a mesh. Submeshes are simplified
+      /// in parallel, and the ones that can't be simplified are copied.
+      /// Materials and the skeleton are shared with _mesh.
+      /// \param[in] _mesh Mesh to simplify.
+      /// \param[in] _ratio Fraction of the triangles of every submesh to
+      /// keep, between 0 and 1.
+      /// \return The simplified mesh.
+      public: std::unique_ptr<Mesh> Simplify(const Mesh &_mesh,
+                  const double _ratio);
+
+      /// \brief Create levels of detail of a mesh. Every level is simplified
+      /// from the previous one.
+      /// \param[in] _mesh Mesh to simplify, which is level 0.
+      /// \param[in] _levels Number of levels to create.
+      /// \param[in] _ratio Fraction of the triangles of a level kept by the
+      /// next level, between 0 and 1.
+      /// \return Levels 1 to _levels, in order.
+      public: std::vector<std::unique_ptr<Mesh>> CreateLods(
+                  const Mesh &_mesh, const unsigned int _levels,
+                  const double _ratio = 0.5);
+
+      /// \brief Get the largest error of the collapses performed by the
+      /// last call to Simplify or CreateLods.
+      /// \return Largest error, in mesh units.
+      public: double Error() const;
+
+      /// \brief Private data pointer.
+      IGN_UTILS_IMPL_PTR(dataPtr)
+    };
+  }
+}
+#endif
@@ -17,6 +17,7 @@
 #ifndef IGNITION_COMMON_NODE_ANIMATION_HH_
 #define IGNITION_COMMON_NODE_ANIMATION_HH_
 
+#include <map>
 #include <string>
 #include <utility>
 
@@ -82,6 +83,12 @@ namespace ignition
       public: std::pair<double, math::Matrix4d> KeyFrame(
                       const unsigned int _i) const;
 
+      /// \brief Returns all the key frames. Prefer it to KeyFrame to visit
+      /// every frame, since finding a frame by index takes linear time.
+      /// \return Transformations of the key frames, sorted by time. The
+      /// reference is invalidated by adding frames or scaling.
+      public: const std::map<double, math::Matrix4d> &KeyFrames() const;
+
       /// \brief Returns the duration of the animations
       /// \return the time of the last animation
       public: double Length() const;
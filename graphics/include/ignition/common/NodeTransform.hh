@@ -18,6 +18,7 @@
 #define IGNITION_COMMON_NODE_TRANSFORM_HH_
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <ignition/math/Matrix4.hh>
 #include <ignition/math/Vector3.hh>
@@ -93,6 +94,11 @@ namespace ignition
       public: void SetSourceValues(const math::Vector3d &_axis,
                   const double _angle);
 
+      /// \brief Get the source data values
+      /// \return 16 values for a matrix, 3 for a translation or a scale, 4
+      /// (axis and angle) for a rotation, or none if they were not set
+      public: std::vector<double> SourceValues() const;
+
       /// \brief Sets the transform matrix from the source according to the type
       public: void RecalculateMatrix();
 
@@ -103,6 +103,10 @@ namespace ignition
       /// \param[in] _vertices the new size
       public: void SetNumVertAttached(const unsigned int _vertices);
 
+      /// \brief Get the size of the raw node weight array
+      /// \return Number of vertices with node weights
+      public: unsigned int NumVertAttached() const;
+
       /// \brief Add a new weight to a node (bone)
       /// \param[in] _vertex index of the vertex
       /// \param[in] _node name of the bone
@@ -17,6 +17,7 @@
 #ifndef IGNITION_COMMON_SKELETONANIMATION_HH_
 #define IGNITION_COMMON_SKELETONANIMATION_HH_
 
+#include <functional>
 #include <map>
 #include <utility>
 #include <string>
@@ -64,6 +65,23 @@ namespace ignition
       public: NodeAnimation *NodeAnimationByName(const std::string &_name)
           const;
 
+      /// \brief Returns a node animation by index. Node animations are
+      /// sorted by node name.
+      /// \param[in] _index Index of the node animation, less than
+      /// NodeCount()
+      /// \return NodeAnimation object, or nullptr if the index is out of
+      /// bounds
+      public: NodeAnimation *NodeAnimationByIndex(const unsigned int _index)
+          const;
+
+      /// \brief Calls a function with every node animation, sorted by node
+      /// name. Prefer it to NodeAnimationByIndex to visit every node, since
+      /// finding a node animation by index takes linear time.
+      /// \param[in] _fn Function to call
+      public: void ForEachNodeAnimation(
+                  const std::function<void(const NodeAnimation &)> &_fn)
+          const;
+
       /// \brief Looks for a node with a specific name in the animations
       /// \param[in] _node the name of the node
       /// \return true if the node exits
@@ -17,6 +17,7 @@
 #ifndef IGNITION_COMMON_SUBMESH_HH_
 #define IGNITION_COMMON_SUBMESH_HH_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -62,6 +63,35 @@ namespace ignition
                 TRISTRIPS
               };
 
+      /// \enum NormalWeighting
+      /// \brief How RecalculateNormals combines the normals of the faces
+      /// around a vertex.
+      public: enum class NormalWeighting
+      {
+        /// \brief Every face counts the same
+        UNIFORM = 0,
+        /// \brief Faces count in proportion to their area
+        AREA = 1,
+        /// \brief Faces count in proportion to their interior angle at the
+        /// vertex
+        ANGLE = 2
+      };
+
+      /// \enum VertexStorage
+      /// \brief How vertex positions, normals and texture coordinates are
+      /// stored in memory.
+      public: enum class VertexStorage
+      {
+        /// \brief Double precision math vectors. This is the default.
+        DOUBLE = 0,
+        /// \brief One tightly packed array of 32 bit floats per attribute:
+        /// x, y, z for every position and normal, and u, v for every texture
+        /// coordinate. Uses half the memory of DOUBLE, values are rounded to
+        /// float precision, and the arrays are available without copying
+        /// through VertexData, NormalData and TexCoordDataBySet.
+        FLOAT32 = 1
+      };
+
       /// \brief Constructor
       public: SubMesh();
 
@@ -88,10 +118,28 @@ namespace ignition
       /// \return The primitive type
       public: PrimitiveType SubMeshPrimitiveType() const;
 
+      /// \brief Reserve memory for vertex positions, normals and indices,
+      /// so that adding them does not reallocate. Does not change the number
+      /// of vertices or indices.
+      /// \param[in] _vertexCount Number of positions and normals
+      /// \param[in] _indexCount Number of indices
+      public: void Reserve(const unsigned int _vertexCount,
+                  const unsigned int _indexCount);
+
       /// \brief Add an index to the mesh
       /// \param[in] _index The new vertex index
       public: void AddIndex(const unsigned int _index);
 
+      /// \brief Reorder the vertices. Positions, normals, texture
+      /// coordinates of every set and node assignments move with their
+      /// vertex, and indices are updated to refer to the new positions.
+      /// \param[in] _order Old index of every vertex in the new order. It
+      /// must be a permutation of 0 to VertexCount() - 1.
+      /// \return False if _order is not a permutation, or if normals or
+      /// texture coordinates are not given per vertex, in which case
+      /// nothing is changed.
+      public: bool ReorderVertices(const std::vector<unsigned int> &_order);
+
       /// \brief Add a vertex to the mesh
       /// \param[in] _v The new position
       public: void AddVertex(const ignition::math::Vector3d &_v);
@@ -143,6 +191,11 @@ namespace ignition
       public: void AddTexCoordBySet(const ignition::math::Vector2d &_uv,
           unsigned int _setIndex);
 
+      /// \brief Add an empty texture coordinate set. Nothing changes if
+      /// the set exists already.
+      /// \param[in] _setIndex Texture coordinate set index
+      public: void AddTexCoordSet(const unsigned int _setIndex);
+
       /// \brief Add a vertex - skeleton node assignment
       /// \param[in] _vertex The vertex index
       /// \param[in] _node The node index
@@ -232,11 +285,14 @@ namespace ignition
       public: NodeAssignment NodeAssignmentByIndex(
           const unsigned int _index) const;
 
-      /// \brief Get the maximum X, Y, Z values from all the vertices
+      /// \brief Get the maximum X, Y, Z values from all the vertices.
+      /// The bounds are cached and kept up to date as vertices change, so
+      /// repeated calls are cheap. Safe to call from several threads.
       /// \return Max X,Y,Z values from all vertices in submesh
       public: ignition::math::Vector3d Max() const;
 
-      /// \brief Get the minimum X, Y, Z values from all the vertices
+      /// \brief Get the minimum X, Y, Z values from all the vertices.
+      /// \sa Max() const
       /// \return Min X,Y,Z values from all vertices in submesh
       public: ignition::math::Vector3d Min() const;
 
@@ -271,6 +327,11 @@ namespace ignition
       /// \return The number of texture coordinates sets.
       public: unsigned int TexCoordSetCount() const;
 
+      /// \brief Get the indices of the texture coordinate sets, including
+      /// empty sets
+      /// \return TexCoordSetCount() indices, in increasing order.
+      public: std::vector<unsigned int> TexCoordSetIndices() const;
+
       /// \brief Get the number of vertex-skeleton node assignments
       /// \return The number of vertex-skeleton node assignments
       public: unsigned int NodeAssignmentsCount() const;
@@ -338,16 +399,183 @@ namespace ignition
       /// \brief Get the index of the vertex
       /// \param[in] _v Vertex to check
       /// \return Index of the vertex that matches _v.
+      /// \sa SetVertexHashEnabled
       public: int IndexOfVertex(const ignition::math::Vector3d &_v) const;
 
+      /// \brief Enable or disable a spatial hash of the vertex positions.
+      /// While it is enabled, HasVertex(const ignition::math::Vector3d &) and
+      /// IndexOfVertex take constant expected time instead of scanning every
+      /// vertex, and return the same results. The hash is updated by every
+      /// function that adds or moves vertices, which makes them slightly
+      /// slower, and uses memory proportional to the number of vertices.
+      /// Enable it while building a mesh that deduplicates vertices. It is
+      /// disabled by default.
+      /// \param[in] _enabled True to enable the hash, false to free it.
+      public: void SetVertexHashEnabled(const bool _enabled);
+
+      /// \brief Get whether the spatial hash of vertex positions is enabled.
+      /// \return True if enabled.
+      /// \sa SetVertexHashEnabled
+      public: bool VertexHashEnabled() const;
+
+      /// \brief Change how vertex attributes are stored. Existing positions,
+      /// normals and texture coordinates are converted.
+      /// \param[in] _storage New storage.
+      public: void SetVertexStorage(const VertexStorage _storage);
+
+      /// \brief Get how vertex attributes are stored.
+      /// \return The current storage.
+      public: VertexStorage VertexStorageType() const;
+
+      /// \brief Get the vertex positions without copying them.
+      /// \return Pointer to VertexCount() * 3 floats (x, y, z of each
+      /// vertex), or nullptr unless the storage is VertexStorage::FLOAT32.
+      /// The pointer is invalidated by adding vertices or changing the
+      /// storage.
+      public: const float *VertexData() const;
+
+      /// \brief Get the normals without copying them.
+      /// \return Pointer to NormalCount() * 3 floats, or nullptr unless the
+      /// storage is VertexStorage::FLOAT32. The pointer is invalidated by
+      /// adding normals or changing the storage.
+      public: const float *NormalData() const;
+
+      /// \brief Get a texture coordinate set without copying it.
+      /// \param[in] _setIndex Texture coordinate set index.
+      /// \return Pointer to TexCoordCountBySet(_setIndex) * 2 floats, or
+      /// nullptr if the set does not exist or the storage is not
+      /// VertexStorage::FLOAT32. The pointer is invalidated by adding
+      /// texture coordinates or changing the storage.
+      public: const float *TexCoordDataBySet(
+                  const unsigned int _setIndex) const;
+
+      /// \brief Get the indices without copying them. Available with any
+      /// storage.
+      /// \return Pointer to IndexCount() indices. The pointer is invalidated
+      /// by adding indices.
+      public: const unsigned int *IndexData() const;
+
+      /// \brief Replace all vertex positions with copies of an array. The
+      /// bounds, the vertex hash and VertexRevision are updated once, which
+      /// is faster than adding vertices one by one. This is a plain copy
+      /// when the storage is VertexStorage::FLOAT32.
+      /// \param[in] _values x, y, z of each vertex.
+      /// \param[in] _count Number of vertices.
+      public: void SetVertexData(const float *_values,
+                  const unsigned int _count);
+
+      /// \brief Replace all vertex positions with copies of an array of
+      /// doubles, which are rounded if the storage is
+      /// VertexStorage::FLOAT32.
+      /// \param[in] _values x, y, z of each vertex.
+      /// \param[in] _count Number of vertices.
+      /// \sa SetVertexData(const float *, const unsigned int)
+      public: void SetVertexData(const double *_values,
+                  const unsigned int _count);
+
+      /// \brief Replace all normals with copies of an array. This is a
+      /// plain copy when the storage is VertexStorage::FLOAT32.
+      /// \param[in] _values x, y, z of each normal.
+      /// \param[in] _count Number of normals.
+      public: void SetNormalData(const float *_values,
+                  const unsigned int _count);
+
+      /// \brief Replace all normals with copies of an array of doubles.
+      /// \param[in] _values x, y, z of each normal.
+      /// \param[in] _count Number of normals.
+      public: void SetNormalData(const double *_values,
+                  const unsigned int _count);
+
+      /// \brief Replace the texture coordinates of a set with copies of an
+      /// array, creating the set if needed. A count of 0 leaves an empty
+      /// set. This is a plain copy when the storage is
+      /// VertexStorage::FLOAT32.
+      /// \param[in] _values u, v of each texture coordinate.
+      /// \param[in] _count Number of texture coordinates.
+      /// \param[in] _setIndex Texture coordinate set index.
+      public: void SetTexCoordDataBySet(const float *_values,
+                  const unsigned int _count, const unsigned int _setIndex);
+
+      /// \brief Replace the texture coordinates of a set with copies of an
+      /// array of doubles, creating the set if needed.
+      /// \param[in] _values u, v of each texture coordinate.
+      /// \param[in] _count Number of texture coordinates.
+      /// \param[in] _setIndex Texture coordinate set index.
+      public: void SetTexCoordDataBySet(const double *_values,
+                  const unsigned int _count, const unsigned int _setIndex);
+
+      /// \brief Replace all indices with copies of an array, updating
+      /// IndexRevision once.
+      /// \param[in] _indices Vertex indices.
+      /// \param[in] _count Number of indices.
+      public: void SetIndexData(const unsigned int *_indices,
+                  const unsigned int _count);
+
+      /// \brief Get a counter that is incremented whenever vertex positions
+      /// are added, moved, reordered or rounded. Data derived from the
+      /// positions, such as a MeshBvh, compares it to detect changes.
+      /// \return Revision of the vertex positions.
+      public: uint64_t VertexRevision() const;
+
+      /// \brief Get a counter that is incremented whenever indices are
+      /// added or changed, or the primitive type changes.
+      /// \return Revision of the indices.
+      public: uint64_t IndexRevision() const;
+
+      /// \brief Copy the vertex positions into a buffer owned by the
+      /// caller, without allocating. Single precision output is a plain
+      /// copy when the storage is VertexStorage::FLOAT32.
+      /// \param[out] _out Buffer with room for VertexCount() * 3 values,
+      /// which receives x, y, z of each vertex.
+      public: void FillVertexBuffer(float *_out) const;
+
+      /// \brief Copy the vertex positions into a buffer owned by the
+      /// caller, without allocating.
+      /// \param[out] _out Buffer with room for VertexCount() * 3 values,
+      /// which receives x, y, z of each vertex.
+      public: void FillVertexBuffer(double *_out) const;
+
+      /// \brief Copy the indices into a buffer owned by the caller, without
+      /// allocating.
+      /// \param[out] _out Buffer with room for IndexCount() values.
+      /// \param[in] _offset Value added to every index.
+      /// \return False if an index plus _offset does not fit in 32 bits, in
+      /// which case nothing is written.
+      public: bool FillIndexBuffer(uint32_t *_out,
+                  const unsigned int _offset = 0) const;
+
+      /// \brief Copy the indices into a buffer of 16 bit indices owned by
+      /// the caller, without allocating.
+      /// \param[out] _out Buffer with room for IndexCount() values.
+      /// \param[in] _offset Value added to every index.
+      /// \return False if an index plus _offset does not fit in 16 bits, in
+      /// which case nothing is written.
+      public: bool FillIndexBuffer(uint16_t *_out,
+                  const unsigned int _offset = 0) const;
+
       /// \brief Put all the data into flat arrays
       /// \param[in] _verArr The vertex array to be filled.
       /// \param[in] _indexndArr The index array to be filled.
       public: void FillArrays(double **_vertArr, int **_indexndArr) const;
 
-      /// \brief Recalculate all the normals.
+      /// \brief Recalculate all the normals. Every vertex gets the average
+      /// normal of all the faces that have a corner at its position, within
+      /// the tolerance of math::Vector3d::operator==. Same as
+      /// RecalculateNormals(NormalWeighting::UNIFORM, true).
       public: void RecalculateNormals();
 
+      /// \brief Recalculate all the normals from the faces defined by every
+      /// three indices. Runs in time linear in the number of faces.
+      /// \param[in] _weighting How the normals of the faces around a vertex
+      /// are combined.
+      /// \param[in] _weld True to combine the faces of every vertex that has
+      /// the same position, which smooths across seams where vertices were
+      /// duplicated, e.g. for texture coordinates. False to only combine the
+      /// faces that reference a vertex through the index buffer, which keeps
+      /// hard edges modeled with duplicated vertices.
+      public: void RecalculateNormals(const NormalWeighting _weighting,
+                  const bool _weld);
+
       /// \brief Generate texture coordinates using spherical projection
       /// from center
       /// \param[in] _center Center of the projection.
@@ -388,6 +616,7 @@ namespace ignition
       /// representation" by Cha Zhang and Tsuhan Chen. Link:
       /// http://chenlab.ece.cornell.edu/Publication/Cha/icip01_Cha.pdf.
       /// The formula does not check for a closed (water tight) mesh.
+      /// The volume is cached until the vertices or indices change.
       ///
       /// \return The submesh's volume. The volume can be zero if
       /// the primitive type is not TRIANGLES, or there are no triangles.
@@ -0,0 +1,1254 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <ignition/math/Color.hh>
+#include <ignition/math/Matrix4.hh>
+
+#include "ignition/common/Material.hh"
+#include "ignition/common/Mesh.hh"
+#include "ignition/common/NodeAnimation.hh"
+#include "ignition/common/NodeTransform.hh"
+#include "ignition/common/Pbr.hh"
+#include "ignition/common/Skeleton.hh"
+#include "ignition/common/SkeletonAnimation.hh"
+#include "ignition/common/SkeletonNode.hh"
+#include "ignition/common/SubMesh.hh"
+
+#include "BinaryMesh.hh"
+
+using namespace ignition;
+using namespace common;
+
+namespace
+{
+  /// \brief Build a chunk tag from four characters
+  /// \param[in] _s Four character string
+  /// \return Tag value
+  constexpr uint32_t MakeTag(const char (&_s)[5])
+  {
+    return static_cast<uint32_t>(static_cast<unsigned char>(_s[0])) |
+      static_cast<uint32_t>(static_cast<unsigned char>(_s[1])) << 8 |
+      static_cast<uint32_t>(static_cast<unsigned char>(_s[2])) << 16 |
+      static_cast<uint32_t>(static_cast<unsigned char>(_s[3])) << 24;
+  }
+
+  /// \brief First bytes of every binary mesh
+  const char kMagic[8] = {'I', 'G', 'N', 'M', 'E', 'S', 'H', '\0'};
+
+  /// \brief Version of the format. Increase it whenever the layout of a
+  /// chunk, or what it holds, changes, so that cached meshes are decoded
+  /// again. Version 3 keeps empty texture coordinate sets.
+  const uint32_t kVersion = 3u;
+
+  /// \brief Written in native byte order to detect foreign files
+  const uint32_t kByteOrderMark = 0x01020304u;
+
+  /// \brief Opaque key, always the first chunk
+  const uint32_t kTagKey = MakeTag("KEY ");
+
+  /// \brief Name and path of the mesh
+  const uint32_t kTagMesh = MakeTag("MESH");
+
+  /// \brief One material, in mesh order
+  const uint32_t kTagMaterial = MakeTag("MATL");
+
+  /// \brief One submesh, in mesh order
+  const uint32_t kTagSubMesh = MakeTag("SUBM");
+
+  /// \brief Skeleton nodes and vertex weights
+  const uint32_t kTagSkeleton = MakeTag("SKEL");
+
+  /// \brief One skeleton animation, after the skeleton
+  const uint32_t kTagAnimation = MakeTag("ANIM");
+
+  /// \brief Last chunk, marks a complete file
+  const uint32_t kTagEnd = MakeTag("END ");
+
+  /// \brief Parent index of the root skeleton node
+  const uint32_t kNoParent = std::numeric_limits<uint32_t>::max();
+
+  /// \brief Smallest encoded skeleton node: parent, two empty strings,
+  /// joint flag, three matrices and the number of raw transforms
+  const std::size_t kMinNodeSize = 4u + 4u + 4u + 1u + 3u * 128u + 4u;
+
+  /// \brief Smallest encoded weighted vertex: the number of weights
+  const std::size_t kMinVertexWeightsSize = 4u;
+
+  /// \brief Alignment of chunks and arrays
+  const std::size_t kAlignment = 8u;
+
+  /// \brief Chunk flag set when the payload is compressed. A compressed
+  /// payload is the size of the original payload, as 64 bits, followed by
+  /// the compressed bytes.
+  const uint32_t kFlagCompressed = 1u;
+
+  /// \brief Shortest repeated sequence the compressor encodes as a match
+  const std::size_t kMinMatch = 4u;
+
+  /// \brief Largest distance back to the start of a match
+  const std::size_t kMaxDistance = 0xFFFFu;
+
+  /// \brief Number of bits of the compressor hash table index
+  const unsigned int kHashBits = 14u;
+
+  /// \brief Node assignment as stored in the file
+  struct NodeAssignmentRecord
+  {
+    /// \brief Vertex index
+    uint32_t vertexIndex;
+
+    /// \brief Node index
+    uint32_t nodeIndex;
+
+    /// \brief Weight
+    float weight;
+  };
+
+  /// \brief Group the bytes of 32 bit words by significance: first the
+  /// lowest byte of every word, then the next one and so on. Neighbouring
+  /// values of an array share their high bytes, which then form long runs
+  /// that compress well.
+  /// \param[in] _data Data to shuffle
+  /// \param[in] _size Number of bytes, a multiple of 4
+  /// \param[out] _out Receives _size shuffled bytes
+  void Shuffle(const char *_data, const std::size_t _size, char *_out)
+  {
+    const std::size_t words = _size / sizeof(uint32_t);
+    for (std::size_t b = 0; b < sizeof(uint32_t); ++b)
+      for (std::size_t w = 0; w < words; ++w)
+        _out[b * words + w] = _data[w * sizeof(uint32_t) + b];
+  }
+
+  /// \brief Undo Shuffle
+  /// \param[in] _data Shuffled data
+  /// \param[in] _size Number of bytes, a multiple of 4
+  /// \param[out] _out Receives _size bytes in their original order
+  void Unshuffle(const char *_data, const std::size_t _size, char *_out)
+  {
+    const std::size_t words = _size / sizeof(uint32_t);
+    for (std::size_t b = 0; b < sizeof(uint32_t); ++b)
+      for (std::size_t w = 0; w < words; ++w)
+        _out[w * sizeof(uint32_t) + b] = _data[b * words + w];
+  }
+
+  /// \brief Append the part of a length that does not fit in its four bit
+  /// field of a sequence token
+  /// \param[in] _length Remaining length
+  /// \param[out] _out Compressed data
+  void PutLength(std::size_t _length, std::string &_out)
+  {
+    for (; _length >= 0xFFu; _length -= 0xFFu)
+      _out.push_back(static_cast<char>(0xFF));
+    _out.push_back(static_cast<char>(_length));
+  }
+
+  /// \brief Append a sequence: a token holding two four bit lengths, the
+  /// literals, then the distance back to the match. The last sequence of
+  /// the data has literals only.
+  /// \param[in] _literals First literal
+  /// \param[in] _literalCount Number of literals
+  /// \param[in] _distance Distance back to the match
+  /// \param[in] _length Length of the match, or 0 for the last sequence
+  /// \param[out] _out Compressed data
+  void PutSequence(const char *_literals, const std::size_t _literalCount,
+      const std::size_t _distance, const std::size_t _length,
+      std::string &_out)
+  {
+    const std::size_t matchCode = _length > 0u ? _length - kMinMatch : 0u;
+    _out.push_back(static_cast<char>(
+          std::min<std::size_t>(_literalCount, 15u) << 4 |
+          std::min<std::size_t>(matchCode, 15u)));
+    if (_literalCount >= 15u)
+      PutLength(_literalCount - 15u, _out);
+    _out.append(_literals, _literalCount);
+
+    if (_length == 0u)
+      return;
+    _out.push_back(static_cast<char>(_distance & 0xFFu));
+    _out.push_back(static_cast<char>(_distance >> 8));
+    if (matchCode >= 15u)
+      PutLength(matchCode - 15u, _out);
+  }
+
+  /// \brief Compress data with a byte oriented LZ77 coder. Matches are
+  /// found through a hash table of the last position of every 4 byte
+  /// sequence, which keeps compression fast at a modest ratio.
+  /// \param[in] _data Data to compress
+  /// \param[in] _size Number of bytes, less than 4 GiB
+  /// \return Compressed data
+  std::string Compress(const char *_data, const std::size_t _size)
+  {
+    std::string out;
+    out.reserve(_size / 2u);
+
+    // Positions are stored plus one, so that zero means empty
+    std::vector<uint32_t> table(std::size_t(1u) << kHashBits, 0u);
+    std::size_t anchor = 0u;
+    std::size_t pos = 0u;
+    while (pos + kMinMatch <= _size)
+    {
+      uint32_t word;
+      std::memcpy(&word, _data + pos, sizeof(word));
+      const uint32_t hash = (word * 2654435761u) >> (32u - kHashBits);
+      const std::size_t candidate = table[hash];
+      table[hash] = static_cast<uint32_t>(pos + 1u);
+      if (candidate == 0u || pos - (candidate - 1u) > kMaxDistance ||
+          std::memcmp(_data + candidate - 1u, _data + pos, kMinMatch) != 0)
+      {
+        ++pos;
+        continue;
+      }
+
+      const std::size_t match = candidate - 1u;
+      std::size_t length = kMinMatch;
+      while (pos + length < _size &&
+          _data[match + length] == _data[pos + length])
+      {
+        ++length;
+      }
+      PutSequence(_data + anchor, pos - anchor, pos - match, length, out);
+      pos += length;
+      anchor = pos;
+    }
+    PutSequence(_data + anchor, _size - anchor, 0u, 0u, out);
+    return out;
+  }
+
+  /// \brief Read the part of a length that did not fit in its sequence
+  /// token
+  /// \param[in] _data Compressed data
+  /// \param[in] _size Number of bytes in _data
+  /// \param[in, out] _pos Read position
+  /// \param[in, out] _length Length to add to
+  /// \return False if the data ends first
+  bool GetLength(const unsigned char *_data, const std::size_t _size,
+      std::size_t &_pos, std::size_t &_length)
+  {
+    unsigned char byte = 0xFFu;
+    while (byte == 0xFFu)
+    {
+      if (_pos >= _size)
+        return false;
+      byte = _data[_pos++];
+      _length += byte;
+    }
+    return true;
+  }
+
+  /// \brief Decompress data written by Compress
+  /// \param[in] _data Compressed data, possibly followed by padding
+  /// \param[in] _size Number of bytes in _data
+  /// \param[out] _out Receives the decompressed data
+  /// \param[in] _outSize Number of decompressed bytes
+  /// \return False if the data is corrupt
+  bool Decompress(const unsigned char *_data, const std::size_t _size,
+      char *_out, const std::size_t _outSize)
+  {
+    std::size_t in = 0u;
+    std::size_t out = 0u;
+    while (true)
+    {
+      if (in >= _size)
+        return false;
+      const unsigned int token = _data[in++];
+
+      std::size_t literals = token >> 4;
+      if (literals == 15u && !GetLength(_data, _size, in, literals))
+        return false;
+      if (literals > _size - in || literals > _outSize - out)
+        return false;
+      std::memcpy(_out + out, _data + in, literals);
+      in += literals;
+      out += literals;
+      if (out == _outSize)
+        return true;
+
+      if (_size - in < 2u)
+        return false;
+      const std::size_t distance =
+        static_cast<std::size_t>(_data[in]) |
+        static_cast<std::size_t>(_data[in + 1u]) << 8;
+      in += 2u;
+      std::size_t length = token & 15u;
+      if (length == 15u && !GetLength(_data, _size, in, length))
+        return false;
+      length += kMinMatch;
+      if (distance == 0u || distance > out || length > _outSize - out)
+        return false;
+
+      // Matches may overlap the bytes they produce
+      if (distance >= length)
+      {
+        std::memcpy(_out + out, _out + out - distance, length);
+      }
+      else
+      {
+        for (std::size_t i = 0; i < length; ++i)
+          _out[out + i] = _out[out + i - distance];
+      }
+      out += length;
+    }
+  }
+
+  /// \brief Appends binary data to a memory buffer
+  class BinaryWriter
+  {
+    /// \brief Append raw bytes
+    /// \param[in] _data Bytes to append
+    /// \param[in] _size Number of bytes
+    public: void Put(const void *_data, const std::size_t _size)
+    {
+      this->buffer.append(static_cast<const char *>(_data), _size);
+    }
+
+    /// \brief Append a value
+    /// \param[in] _value Value to append
+    public: template <typename T> void Write(const T &_value)
+    {
+      static_assert(std::is_trivially_copyable<T>::value,
+          "Only trivially copyable values can be written");
+      this->Put(&_value, sizeof(T));
+    }
+
+    /// \brief Append zeros up to the next multiple of kAlignment
+    public: void Align()
+    {
+      this->buffer.resize(
+          (this->buffer.size() + kAlignment - 1) / kAlignment * kAlignment);
+    }
+
+    /// \brief Append a string as its length followed by its characters
+    /// \param[in] _s String to append
+    public: void WriteString(const std::string &_s)
+    {
+      this->Write(static_cast<uint32_t>(_s.size()));
+      this->Put(_s.data(), _s.size());
+    }
+
+    /// \brief Append an array as its length followed by its aligned
+    /// elements
+    /// \param[in] _data First element
+    /// \param[in] _count Number of elements
+    public: template <typename T>
+            void WriteArray(const T *_data, const std::size_t _count)
+    {
+      this->Write(static_cast<uint64_t>(_count));
+      this->Align();
+      if (_count > 0u)
+        this->Put(_data, _count * sizeof(T));
+    }
+
+    /// \brief Append a matrix in row major order
+    /// \param[in] _m Matrix to append
+    public: void WriteMatrix(const math::Matrix4d &_m)
+    {
+      for (unsigned int r = 0; r < 4u; ++r)
+        for (unsigned int c = 0; c < 4u; ++c)
+          this->Write(_m(r, c));
+    }
+
+    /// \brief Append a color
+    /// \param[in] _c Color to append
+    public: void WriteColor(const math::Color &_c)
+    {
+      this->Write(_c.R());
+      this->Write(_c.G());
+      this->Write(_c.B());
+      this->Write(_c.A());
+    }
+
+    /// \brief Start a chunk. Must be paired with EndChunk.
+    /// \param[in] _tag Chunk tag
+    /// \return Offset of the size field, to pass to EndChunk
+    public: std::size_t BeginChunk(const uint32_t _tag)
+    {
+      this->Align();
+      this->Write(_tag);
+      this->Write(uint32_t(0u));
+      const std::size_t sizeOffset = this->buffer.size();
+      this->Write(uint64_t(0u));
+      return sizeOffset;
+    }
+
+    /// \brief Finish a chunk, filling in its size
+    /// \param[in] _sizeOffset Value returned by BeginChunk
+    /// \param[in] _compress True to compress the payload when that makes
+    /// it smaller
+    public: void EndChunk(const std::size_t _sizeOffset,
+                const bool _compress = false)
+    {
+      this->Align();
+      const std::size_t payloadOffset = _sizeOffset + sizeof(uint64_t);
+      const std::size_t rawSize = this->buffer.size() - payloadOffset;
+      if (_compress && rawSize > 0u &&
+          rawSize < std::numeric_limits<uint32_t>::max())
+      {
+        std::string shuffled(rawSize, '\0');
+        Shuffle(&this->buffer[payloadOffset], rawSize, &shuffled[0]);
+        const std::string packed = Compress(shuffled.data(), rawSize);
+        if (packed.size() + sizeof(uint64_t) < rawSize)
+        {
+          this->buffer.resize(payloadOffset);
+          this->Write(static_cast<uint64_t>(rawSize));
+          this->Put(packed.data(), packed.size());
+          this->Align();
+          std::memcpy(&this->buffer[_sizeOffset - sizeof(uint32_t)],
+              &kFlagCompressed, sizeof(kFlagCompressed));
+        }
+      }
+
+      const uint64_t size = this->buffer.size() - payloadOffset;
+      std::memcpy(&this->buffer[_sizeOffset], &size, sizeof(size));
+    }
+
+    /// \brief Written bytes
+    public: std::string buffer;
+  };
+
+  /// \brief Reads binary data from memory. Reading past the end sets an
+  /// error flag and returns default values instead.
+  class BinaryReader
+  {
+    /// \brief Constructor
+    /// \param[in] _data First byte
+    /// \param[in] _size Number of bytes
+    /// \param[in] _base Start of the file, which alignment is relative to
+    public: BinaryReader(const char *_data, const std::size_t _size,
+                const char *_base)
+      : data(_data), size(_size), base(_base)
+    {
+    }
+
+    /// \brief Check that nothing went past the end so far
+    /// \return True if all reads succeeded
+    public: bool Ok() const
+    {
+      return this->ok;
+    }
+
+    /// \brief Check whether all data has been read
+    /// \return True at the end of the data
+    public: bool AtEnd() const
+    {
+      return this->pos >= this->size;
+    }
+
+    /// \brief Read a value
+    /// \return The value, or a value initialized T on error
+    public: template <typename T> T Read()
+    {
+      T value{};
+      if (!this->Fits(sizeof(T), 1u))
+        return value;
+      std::memcpy(&value, this->data + this->pos, sizeof(T));
+      this->pos += sizeof(T);
+      return value;
+    }
+
+    /// \brief Skip to the next multiple of kAlignment from the start of
+    /// the file
+    public: void Align()
+    {
+      const std::size_t offset =
+        static_cast<std::size_t>(this->data - this->base) + this->pos;
+      const std::size_t padding = (kAlignment - offset % kAlignment) %
+        kAlignment;
+      this->Skip(padding);
+    }
+
+    /// \brief Skip bytes
+    /// \param[in] _count Number of bytes
+    public: void Skip(const std::size_t _count)
+    {
+      if (this->Fits(1u, _count))
+        this->pos += _count;
+    }
+
+    /// \brief Read a string written by BinaryWriter::WriteString
+    /// \return The string
+    public: std::string ReadString()
+    {
+      const uint32_t length = this->Read<uint32_t>();
+      if (!this->Fits(1u, length))
+        return std::string();
+      std::string s(this->data + this->pos, length);
+      this->pos += length;
+      return s;
+    }
+
+    /// \brief Read an array written by BinaryWriter::WriteArray, without
+    /// copying it
+    /// \param[out] _count Number of elements
+    /// \return Pointer to the first element inside the data, or nullptr if
+    /// the array is empty or on error
+    public: template <typename T> const T *ReadArray(std::size_t &_count)
+    {
+      const uint64_t count = this->Read<uint64_t>();
+      this->Align();
+      _count = 0u;
+      if (!this->Fits(sizeof(T), count) || 0u == count)
+        return nullptr;
+
+      const T *values = reinterpret_cast<const T *>(this->data + this->pos);
+      this->pos += static_cast<std::size_t>(count) * sizeof(T);
+      _count = static_cast<std::size_t>(count);
+      return values;
+    }
+
+    /// \brief Check that _count records can still be read, before
+    /// allocating room for them, and set the error flag if not
+    /// \param[in] _minSize Smallest encoded size of a record
+    /// \param[in] _count Number of records
+    /// \return True if they may fit in the remaining bytes
+    public: bool Holds(const std::size_t _minSize, const uint64_t _count)
+    {
+      return this->Fits(_minSize, _count);
+    }
+
+    /// \brief Read a matrix written by BinaryWriter::WriteMatrix
+    /// \return The matrix
+    public: math::Matrix4d ReadMatrix()
+    {
+      double v[16];
+      for (double &d : v)
+        d = this->Read<double>();
+      return math::Matrix4d(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7],
+          v[8], v[9], v[10], v[11], v[12], v[13], v[14], v[15]);
+    }
+
+    /// \brief Read a color written by BinaryWriter::WriteColor
+    /// \return The color
+    public: math::Color ReadColor()
+    {
+      const float r = this->Read<float>();
+      const float g = this->Read<float>();
+      const float b = this->Read<float>();
+      const float a = this->Read<float>();
+      return math::Color(r, g, b, a);
+    }
+
+    /// \brief Read the header of the next chunk and get a reader for its
+    /// payload. The payload is skipped in this reader.
+    /// \param[out] _tag Chunk tag
+    /// \param[out] _flags Chunk flags
+    /// \return Reader for the payload
+    public: BinaryReader ReadChunk(uint32_t &_tag, uint32_t &_flags)
+    {
+      this->Align();
+      _tag = this->Read<uint32_t>();
+      _flags = this->Read<uint32_t>();
+      const uint64_t chunkSize = this->Read<uint64_t>();
+      if (!this->Fits(1u, chunkSize))
+        return BinaryReader(this->base, 0u, this->base);
+
+      BinaryReader payload(this->data + this->pos,
+          static_cast<std::size_t>(chunkSize), this->base);
+      this->pos += static_cast<std::size_t>(chunkSize);
+      return payload;
+    }
+
+    /// \brief Decompress the rest of a compressed chunk payload
+    /// \param[out] _buffer Receives the decompressed payload. Stored as
+    /// doubles so that it is suitably aligned.
+    /// \return Reader for the decompressed payload. On error the error flag
+    /// of this reader is set.
+    public: BinaryReader Unpack(std::vector<double> &_buffer)
+    {
+      const uint64_t rawSize = this->Read<uint64_t>();
+      const std::size_t packedSize =
+        this->pos < this->size ? this->size - this->pos : 0u;
+
+      // Every compressed byte yields fewer than 256 bytes, which rejects
+      // corrupt sizes before allocating
+      if (!this->ok || rawSize % sizeof(uint32_t) != 0u ||
+          rawSize / 0xFFu > packedSize)
+      {
+        this->ok = false;
+        return BinaryReader(this->base, 0u, this->base);
+      }
+
+      const std::size_t bytes = static_cast<std::size_t>(rawSize);
+      std::string shuffled(bytes, '\0');
+      _buffer.assign((bytes + sizeof(double) - 1u) / sizeof(double), 0.0);
+      char *out = reinterpret_cast<char *>(_buffer.data());
+      if (!Decompress(reinterpret_cast<const unsigned char *>(
+              this->data + this->pos), packedSize, &shuffled[0], bytes))
+      {
+        this->ok = false;
+        return BinaryReader(this->base, 0u, this->base);
+      }
+      Unshuffle(shuffled.data(), bytes, out);
+      this->pos = this->size;
+      return BinaryReader(out, bytes, out);
+    }
+
+    /// \brief Check that _count elements of _elementSize bytes remain, and
+    /// set the error flag if not
+    /// \param[in] _elementSize Size of an element
+    /// \param[in] _count Number of elements
+    /// \return True if they fit
+    private: bool Fits(const std::size_t _elementSize, const uint64_t _count)
+    {
+      if (!this->ok || this->pos > this->size ||
+          _count > (this->size - this->pos) / _elementSize)
+      {
+        this->ok = false;
+      }
+      return this->ok;
+    }
+
+    /// \brief First byte
+    private: const char *data;
+
+    /// \brief Number of bytes
+    private: std::size_t size;
+
+    /// \brief Start of the file
+    private: const char *base;
+
+    /// \brief Read position
+    private: std::size_t pos = 0u;
+
+    /// \brief False once a read went past the end
+    private: bool ok = true;
+  };
+
+  /// \brief Raw transform of a skeleton node, as read from the file
+  struct RawTransformRecord
+  {
+    /// \brief SID
+    std::string sid;
+
+    /// \brief Type
+    NodeTransformType type;
+
+    /// \brief Transform matrix
+    math::Matrix4d transform;
+
+    /// \brief Source values
+    std::vector<double> source;
+  };
+
+  /// \brief Skeleton node, as read from the file
+  struct SkeletonNodeRecord
+  {
+    /// \brief Index of the parent node, or kNoParent
+    uint32_t parent;
+
+    /// \brief Name
+    std::string name;
+
+    /// \brief Id
+    std::string id;
+
+    /// \brief Type
+    SkeletonNode::SkeletonNodeType type;
+
+    /// \brief Local transform
+    math::Matrix4d transform;
+
+    /// \brief Model transform
+    math::Matrix4d modelTransform;
+
+    /// \brief Inverse bind transform
+    math::Matrix4d inverseBindTransform;
+
+    /// \brief Raw transforms
+    std::vector<RawTransformRecord> rawTransforms;
+  };
+
+  //////////////////////////////////////////////////
+  void WriteMaterial(const Material &_mat, BinaryWriter &_out)
+  {
+    _out.WriteString(_mat.TextureImage());
+    _out.WriteColor(_mat.Ambient());
+    _out.WriteColor(_mat.Diffuse());
+    _out.WriteColor(_mat.Specular());
+    _out.WriteColor(_mat.Emissive());
+    _out.Write(_mat.Transparency());
+    _out.Write(static_cast<uint8_t>(_mat.TextureAlphaEnabled()));
+    _out.Write(_mat.AlphaThreshold());
+    _out.Write(static_cast<uint8_t>(_mat.TwoSidedEnabled()));
+    _out.Write(_mat.RenderOrder());
+    _out.Write(_mat.Shininess());
+    _out.Write(_mat.PointSize());
+    _out.Write(static_cast<int32_t>(_mat.Blend()));
+    _out.Write(static_cast<int32_t>(_mat.Shade()));
+    _out.Write(static_cast<uint8_t>(_mat.DepthWrite()));
+    _out.Write(static_cast<uint8_t>(_mat.Lighting()));
+    double srcFactor, dstFactor;
+    _mat.BlendFactors(srcFactor, dstFactor);
+    _out.Write(srcFactor);
+    _out.Write(dstFactor);
+
+    const Pbr *pbr = _mat.PbrMaterial();
+    _out.Write(static_cast<uint8_t>(pbr != nullptr));
+    if (!pbr)
+      return;
+
+    _out.Write(static_cast<int32_t>(pbr->Type()));
+    _out.WriteString(pbr->AlbedoMap());
+    _out.WriteString(pbr->NormalMap());
+    _out.Write(static_cast<int32_t>(pbr->NormalMapType()));
+    _out.WriteString(pbr->EnvironmentMap());
+    _out.WriteString(pbr->AmbientOcclusionMap());
+    _out.WriteString(pbr->RoughnessMap());
+    _out.WriteString(pbr->MetalnessMap());
+    _out.WriteString(pbr->EmissiveMap());
+    _out.WriteString(pbr->LightMap());
+    _out.Write(static_cast<uint32_t>(pbr->LightMapTexCoordSet()));
+    _out.Write(pbr->Metalness());
+    _out.Write(pbr->Roughness());
+    _out.WriteString(pbr->GlossinessMap());
+    _out.Write(pbr->Glossiness());
+    _out.WriteString(pbr->SpecularMap());
+  }
+
+  //////////////////////////////////////////////////
+  MaterialPtr ReadMaterial(BinaryReader &_in)
+  {
+    auto mat = std::make_shared<Material>();
+    mat->SetTextureImage(_in.ReadString());
+    mat->SetAmbient(_in.ReadColor());
+    mat->SetDiffuse(_in.ReadColor());
+    mat->SetSpecular(_in.ReadColor());
+    mat->SetEmissive(_in.ReadColor());
+    mat->SetTransparency(_in.Read<double>());
+    const bool alphaEnabled = _in.Read<uint8_t>() != 0u;
+    const double alphaThreshold = _in.Read<double>();
+    const bool twoSided = _in.Read<uint8_t>() != 0u;
+    mat->SetAlphaFromTexture(alphaEnabled, alphaThreshold, twoSided);
+    mat->SetRenderOrder(_in.Read<float>());
+    mat->SetShininess(_in.Read<double>());
+    mat->SetPointSize(_in.Read<double>());
+    mat->SetBlend(static_cast<Material::BlendMode>(_in.Read<int32_t>()));
+    mat->SetShade(static_cast<Material::ShadeMode>(_in.Read<int32_t>()));
+    mat->SetDepthWrite(_in.Read<uint8_t>() != 0u);
+    mat->SetLighting(_in.Read<uint8_t>() != 0u);
+    const double srcFactor = _in.Read<double>();
+    const double dstFactor = _in.Read<double>();
+    mat->SetBlendFactors(srcFactor, dstFactor);
+
+    if (0u == _in.Read<uint8_t>())
+      return mat;
+
+    Pbr pbr;
+    pbr.SetType(static_cast<PbrType>(_in.Read<int32_t>()));
+    pbr.SetAlbedoMap(_in.ReadString());
+    const std::string normalMap = _in.ReadString();
+    pbr.SetNormalMap(normalMap,
+        static_cast<NormalMapSpace>(_in.Read<int32_t>()));
+    pbr.SetEnvironmentMap(_in.ReadString());
+    pbr.SetAmbientOcclusionMap(_in.ReadString());
+    pbr.SetRoughnessMap(_in.ReadString());
+    pbr.SetMetalnessMap(_in.ReadString());
+    pbr.SetEmissiveMap(_in.ReadString());
+    const std::string lightMap = _in.ReadString();
+    pbr.SetLightMap(lightMap, _in.Read<uint32_t>());
+    pbr.SetMetalness(_in.Read<double>());
+    pbr.SetRoughness(_in.Read<double>());
+    pbr.SetGlossinessMap(_in.ReadString());
+    pbr.SetGlossiness(_in.Read<double>());
+    pbr.SetSpecularMap(_in.ReadString());
+    mat->SetPbrMaterial(pbr);
+    return mat;
+  }
+
+  //////////////////////////////////////////////////
+  void WriteSubMesh(const SubMesh &_sub, BinaryWriter &_out)
+  {
+    const bool packed =
+      _sub.VertexStorageType() == SubMesh::VertexStorage::FLOAT32;
+
+    _out.WriteString(_sub.Name());
+    _out.Write(static_cast<int32_t>(_sub.SubMeshPrimitiveType()));
+    _out.Write(static_cast<uint32_t>(_sub.MaterialIndex()));
+    _out.Write(static_cast<uint8_t>(packed));
+
+    // Packed attributes are written as they are stored, everything else is
+    // gathered into double precision arrays
+    if (packed)
+    {
+      _out.WriteArray(_sub.VertexData(), _sub.VertexCount() * 3u);
+      _out.WriteArray(_sub.NormalData(), _sub.NormalCount() * 3u);
+    }
+    else
+    {
+      std::vector<double> values(_sub.VertexCount() * 3u);
+      _sub.FillVertexBuffer(values.data());
+      _out.WriteArray(values.data(), values.size());
+
+      values.resize(_sub.NormalCount() * 3u);
+      for (unsigned int i = 0; i < _sub.NormalCount(); ++i)
+      {
+        const math::Vector3d n = _sub.Normal(i);
+        values[i * 3u] = n.X();
+        values[i * 3u + 1u] = n.Y();
+        values[i * 3u + 2u] = n.Z();
+      }
+      _out.WriteArray(values.data(), values.size());
+    }
+
+    // Texture coordinate sets are not necessarily numbered contiguously,
+    // and empty sets are kept
+    const std::vector<unsigned int> sets = _sub.TexCoordSetIndices();
+    _out.Write(static_cast<uint32_t>(sets.size()));
+    for (const unsigned int set : sets)
+    {
+      const unsigned int count = _sub.TexCoordCountBySet(set);
+      _out.Write(static_cast<uint32_t>(set));
+      if (packed)
+      {
+        _out.WriteArray(_sub.TexCoordDataBySet(set), count * 2u);
+      }
+      else
+      {
+        std::vector<double> values(count * 2u);
+        for (unsigned int i = 0; i < count; ++i)
+        {
+          const math::Vector2d uv = _sub.TexCoordBySet(i, set);
+          values[i * 2u] = uv.X();
+          values[i * 2u + 1u] = uv.Y();
+        }
+        _out.WriteArray(values.data(), values.size());
+      }
+    }
+
+    _out.WriteArray(_sub.IndexData(), _sub.IndexCount());
+
+    std::vector<NodeAssignmentRecord> assignments(
+        _sub.NodeAssignmentsCount());
+    for (unsigned int i = 0; i < _sub.NodeAssignmentsCount(); ++i)
+    {
+      const NodeAssignment na = _sub.NodeAssignmentByIndex(i);
+      assignments[i] = {na.vertexIndex, na.nodeIndex, na.weight};
+    }
+    _out.WriteArray(assignments.data(), assignments.size());
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Read the vertex attribute arrays and indices of a submesh,
+  /// and copy them into the submesh as a whole
+  /// \param[in] _in Reader positioned at the vertices
+  /// \param[in, out] _sub Submesh, with a vertex storage matching T
+  template <typename T>
+  void ReadArrays(BinaryReader &_in, SubMesh &_sub)
+  {
+    std::size_t count = 0u;
+    const T *values = _in.ReadArray<T>(count);
+    _sub.SetVertexData(values, static_cast<unsigned int>(count / 3u));
+    values = _in.ReadArray<T>(count);
+    _sub.SetNormalData(values, static_cast<unsigned int>(count / 3u));
+
+    const uint32_t setCount = _in.Read<uint32_t>();
+    for (uint32_t s = 0u; s < setCount && _in.Ok(); ++s)
+    {
+      const uint32_t set = _in.Read<uint32_t>();
+      values = _in.ReadArray<T>(count);
+      _sub.SetTexCoordDataBySet(values, static_cast<unsigned int>(count / 2u),
+          set);
+    }
+
+    const uint32_t *indices = _in.ReadArray<uint32_t>(count);
+    _sub.SetIndexData(indices, static_cast<unsigned int>(count));
+  }
+
+  //////////////////////////////////////////////////
+  std::unique_ptr<SubMesh> ReadSubMesh(BinaryReader &_in)
+  {
+    auto sub = std::make_unique<SubMesh>(_in.ReadString());
+    sub->SetPrimitiveType(
+        static_cast<SubMesh::PrimitiveType>(_in.Read<int32_t>()));
+    sub->SetMaterialIndex(_in.Read<uint32_t>());
+    if (_in.Read<uint8_t>() != 0u)
+    {
+      sub->SetVertexStorage(SubMesh::VertexStorage::FLOAT32);
+      ReadArrays<float>(_in, *sub);
+    }
+    else
+    {
+      ReadArrays<double>(_in, *sub);
+    }
+
+    std::size_t count = 0u;
+    const NodeAssignmentRecord *assignments =
+      _in.ReadArray<NodeAssignmentRecord>(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      sub->AddNodeAssignment(assignments[i].vertexIndex,
+          assignments[i].nodeIndex, assignments[i].weight);
+    }
+
+    return sub;
+  }
+
+  //////////////////////////////////////////////////
+  void WriteSkeleton(const Skeleton &_skel, BinaryWriter &_out)
+  {
+    _out.WriteMatrix(_skel.BindShapeTransform());
+
+    // Nodes are numbered in depth first order, so parents come first and
+    // children keep their order
+    const SkeletonNodeMap &nodes = _skel.Nodes();
+    _out.Write(static_cast<uint32_t>(nodes.size()));
+    for (const auto &entry : nodes)
+    {
+      const SkeletonNode *node = entry.second;
+      const SkeletonNode *parent = node->Parent();
+      _out.Write(parent ? static_cast<uint32_t>(parent->Handle()) :
+          kNoParent);
+      _out.WriteString(node->Name());
+      _out.WriteString(node->Id());
+      _out.Write(static_cast<uint8_t>(node->IsJoint()));
+      _out.WriteMatrix(node->Transform());
+      _out.WriteMatrix(node->ModelTransform());
+      _out.WriteMatrix(node->InverseBindTransform());
+
+      const std::vector<NodeTransform> raw = node->RawTransforms();
+      _out.Write(static_cast<uint32_t>(raw.size()));
+      for (const NodeTransform &nt : raw)
+      {
+        _out.WriteString(nt.SID());
+        _out.Write(static_cast<int32_t>(nt.Type()));
+        _out.WriteMatrix(nt.Get());
+        const std::vector<double> source = nt.SourceValues();
+        _out.WriteArray(source.data(), source.size());
+      }
+    }
+
+    _out.Write(static_cast<uint32_t>(_skel.NumVertAttached()));
+    for (unsigned int v = 0; v < _skel.NumVertAttached(); ++v)
+    {
+      _out.Write(static_cast<uint32_t>(_skel.VertNodeWeightCount(v)));
+      for (unsigned int i = 0; i < _skel.VertNodeWeightCount(v); ++i)
+      {
+        const std::pair<std::string, double> weight =
+          _skel.VertNodeWeight(v, i);
+        _out.WriteString(weight.first);
+        _out.Write(weight.second);
+      }
+    }
+  }
+
+  //////////////////////////////////////////////////
+  SkeletonPtr ReadSkeleton(BinaryReader &_in)
+  {
+    const math::Matrix4d bindShape = _in.ReadMatrix();
+
+    // Read everything before creating nodes, which are only owned by the
+    // skeleton once it is complete
+    const uint32_t nodeCount = _in.Read<uint32_t>();
+    if (!_in.Holds(kMinNodeSize, nodeCount))
+      return nullptr;
+    std::vector<SkeletonNodeRecord> records(nodeCount);
+    for (std::size_t i = 0; i < records.size() && _in.Ok(); ++i)
+    {
+      SkeletonNodeRecord &record = records[i];
+      record.parent = _in.Read<uint32_t>();
+      record.name = _in.ReadString();
+      record.id = _in.ReadString();
+      record.type = _in.Read<uint8_t>() != 0u ?
+        SkeletonNode::JOINT : SkeletonNode::NODE;
+      record.transform = _in.ReadMatrix();
+      record.modelTransform = _in.ReadMatrix();
+      record.inverseBindTransform = _in.ReadMatrix();
+
+      const uint32_t rawCount = _in.Read<uint32_t>();
+      for (uint32_t r = 0u; r < rawCount && _in.Ok(); ++r)
+      {
+        RawTransformRecord raw;
+        raw.sid = _in.ReadString();
+        raw.type = static_cast<NodeTransformType>(_in.Read<int32_t>());
+        raw.transform = _in.ReadMatrix();
+        std::size_t count = 0u;
+        const double *source = _in.ReadArray<double>(count);
+        raw.source.assign(source, source + count);
+        record.rawTransforms.push_back(std::move(raw));
+      }
+
+      // Parents must precede their children, and only the first node may
+      // be the root
+      if ((i == 0u) != (record.parent == kNoParent) ||
+          (i > 0u && record.parent >= i))
+      {
+        return nullptr;
+      }
+    }
+    if (!_in.Ok() || records.empty())
+      return nullptr;
+
+    std::vector<SkeletonNode *> nodes;
+    nodes.reserve(records.size());
+    for (const SkeletonNodeRecord &record : records)
+    {
+      SkeletonNode *parent =
+        record.parent == kNoParent ? nullptr : nodes[record.parent];
+      SkeletonNode *node =
+        new SkeletonNode(parent, record.name, record.id, record.type);
+
+      // The local and model transforms are both restored, in case they
+      // were not kept consistent by the loader
+      node->SetTransform(record.transform, false);
+      if (node->ModelTransform() != record.modelTransform)
+        node->SetModelTransform(record.modelTransform, false);
+      node->SetInverseBindTransform(record.inverseBindTransform);
+
+      for (const RawTransformRecord &raw : record.rawTransforms)
+      {
+        NodeTransform nt(raw.transform, raw.sid, raw.type);
+        const std::vector<double> &s = raw.source;
+        if (s.size() == 16u)
+        {
+          nt.SetSourceValues(math::Matrix4d(s[0], s[1], s[2], s[3], s[4],
+                s[5], s[6], s[7], s[8], s[9], s[10], s[11], s[12], s[13],
+                s[14], s[15]));
+        }
+        else if (s.size() == 4u)
+        {
+          nt.SetSourceValues(math::Vector3d(s[0], s[1], s[2]), s[3]);
+        }
+        else if (s.size() == 3u)
+        {
+          nt.SetSourceValues(math::Vector3d(s[0], s[1], s[2]));
+        }
+        node->AddRawTransform(nt);
+      }
+      nodes.push_back(node);
+    }
+
+    auto skeleton = std::make_shared<Skeleton>(nodes[0]);
+    skeleton->SetBindShapeTransform(bindShape);
+
+    const uint32_t vertCount = _in.Read<uint32_t>();
+    if (!_in.Holds(kMinVertexWeightsSize, vertCount))
+      return nullptr;
+    skeleton->SetNumVertAttached(vertCount);
+    for (uint32_t v = 0u; v < vertCount && _in.Ok(); ++v)
+    {
+      const uint32_t count = _in.Read<uint32_t>();
+      for (uint32_t i = 0u; i < count && _in.Ok(); ++i)
+      {
+        const std::string node = _in.ReadString();
+        skeleton->AddVertNodeWeight(v, node, _in.Read<double>());
+      }
+    }
+    return skeleton;
+  }
+
+  //////////////////////////////////////////////////
+  void WriteAnimation(const SkeletonAnimation &_anim, BinaryWriter &_out)
+  {
+    _out.WriteString(_anim.Name());
+    _out.Write(static_cast<uint32_t>(_anim.NodeCount()));
+    _anim.ForEachNodeAnimation([&_out](const NodeAnimation &_nodeAnim)
+        {
+          const auto &frames = _nodeAnim.KeyFrames();
+          _out.WriteString(_nodeAnim.Name());
+          _out.Write(static_cast<uint32_t>(frames.size()));
+          for (const auto &frame : frames)
+          {
+            _out.Write(frame.first);
+            _out.WriteMatrix(frame.second);
+          }
+        });
+  }
+
+  //////////////////////////////////////////////////
+  SkeletonAnimation *ReadAnimation(BinaryReader &_in)
+  {
+    auto anim = std::make_unique<SkeletonAnimation>(_in.ReadString());
+    const uint32_t nodeCount = _in.Read<uint32_t>();
+    for (uint32_t n = 0u; n < nodeCount && _in.Ok(); ++n)
+    {
+      const std::string node = _in.ReadString();
+      const uint32_t frameCount = _in.Read<uint32_t>();
+      for (uint32_t k = 0u; k < frameCount && _in.Ok(); ++k)
+      {
+        const double time = _in.Read<double>();
+        anim->AddKeyFrame(node, time, _in.ReadMatrix());
+      }
+    }
+    return _in.Ok() ? anim.release() : nullptr;
+  }
+
+  //////////////////////////////////////////////////
+  bool ReadHeader(BinaryReader &_in)
+  {
+    char magic[sizeof(kMagic)];
+    for (char &c : magic)
+      c = _in.Read<char>();
+    const uint32_t version = _in.Read<uint32_t>();
+    const uint32_t byteOrderMark = _in.Read<uint32_t>();
+    return _in.Ok() && 0 == std::memcmp(magic, kMagic, sizeof(kMagic)) &&
+      version == kVersion && byteOrderMark == kByteOrderMark;
+  }
+}
+
+//////////////////////////////////////////////////
+bool ignition::common::WriteBinaryMesh(const Mesh &_mesh,
+    const std::string &_key, std::ostream &_out, const bool _compress)
+{
+  BinaryWriter writer;
+  writer.Put(kMagic, sizeof(kMagic));
+  writer.Write(kVersion);
+  writer.Write(kByteOrderMark);
+
+  std::size_t chunk = writer.BeginChunk(kTagKey);
+  writer.WriteString(_key);
+  writer.EndChunk(chunk);
+
+  chunk = writer.BeginChunk(kTagMesh);
+  writer.WriteString(_mesh.Name());
+  writer.WriteString(_mesh.Path());
+  writer.EndChunk(chunk);
+
+  for (unsigned int i = 0; i < _mesh.MaterialCount(); ++i)
+  {
+    chunk = writer.BeginChunk(kTagMaterial);
+    WriteMaterial(*_mesh.MaterialByIndex(i), writer);
+    writer.EndChunk(chunk, _compress);
+  }
+
+  for (unsigned int i = 0; i < _mesh.SubMeshCount(); ++i)
+  {
+    chunk = writer.BeginChunk(kTagSubMesh);
+    WriteSubMesh(*_mesh.SubMeshByIndex(i).lock(), writer);
+    writer.EndChunk(chunk, _compress);
+  }
+
+  const SkeletonPtr skeleton = _mesh.MeshSkeleton();
+  if (skeleton && skeleton->RootNode())
+  {
+    chunk = writer.BeginChunk(kTagSkeleton);
+    WriteSkeleton(*skeleton, writer);
+    writer.EndChunk(chunk, _compress);
+
+    for (unsigned int i = 0; i < skeleton->AnimationCount(); ++i)
+    {
+      chunk = writer.BeginChunk(kTagAnimation);
+      WriteAnimation(*skeleton->Animation(i), writer);
+      writer.EndChunk(chunk, _compress);
+    }
+  }
+
+  writer.EndChunk(writer.BeginChunk(kTagEnd));
+
+  _out.write(writer.buffer.data(),
+      static_cast<std::streamsize>(writer.buffer.size()));
+  return static_cast<bool>(_out);
+}
+
+//////////////////////////////////////////////////
+bool ignition::common::ReadBinaryMeshKey(const char *_data,
+    const std::size_t _size, std::string &_key)
+{
+  BinaryReader reader(_data, _size, _data);
+  if (!ReadHeader(reader))
+    return false;
+
+  uint32_t tag = 0u;
+  uint32_t flags = 0u;
+  BinaryReader payload = reader.ReadChunk(tag, flags);
+  if (tag != kTagKey || flags != 0u)
+    return false;
+
+  _key = payload.ReadString();
+  return reader.Ok() && payload.Ok();
+}
+
+//////////////////////////////////////////////////
+Mesh *ignition::common::ReadBinaryMesh(const char *_data,
+    const std::size_t _size)
+{
+  BinaryReader reader(_data, _size, _data);
+  if (!ReadHeader(reader))
+    return nullptr;
+
+  auto mesh = std::make_unique<Mesh>();
+  SkeletonPtr skeleton;
+  bool complete = false;
+  while (!complete && !reader.AtEnd())
+  {
+    uint32_t tag = 0u;
+    uint32_t flags = 0u;
+    BinaryReader payload = reader.ReadChunk(tag, flags);
+    if (!reader.Ok())
+      return nullptr;
+
+    std::vector<double> unpacked;
+    if (flags & kFlagCompressed)
+    {
+      payload = payload.Unpack(unpacked);
+      if (!payload.Ok())
+        return nullptr;
+    }
+
+    if (tag == kTagMesh)
+    {
+      mesh->SetName(payload.ReadString());
+      mesh->SetPath(payload.ReadString());
+    }
+    else if (tag == kTagMaterial)
+    {
+      mesh->AddMaterial(ReadMaterial(payload));
+    }
+    else if (tag == kTagSubMesh)
+    {
+      mesh->AddSubMesh(ReadSubMesh(payload));
+    }
+    else if (tag == kTagSkeleton)
+    {
+      skeleton = ReadSkeleton(payload);
+      if (!skeleton)
+        return nullptr;
+    }
+    else if (tag == kTagAnimation)
+    {
+      SkeletonAnimation *anim = ReadAnimation(payload);
+      if (!anim || !skeleton)
+      {
+        delete anim;
+        return nullptr;
+      }
+      skeleton->AddAnimation(anim);
+    }
+    else if (tag == kTagEnd)
+    {
+      complete = true;
+    }
+
+    if (!payload.Ok())
+      return nullptr;
+  }
+
+  if (!complete)
+    return nullptr;
+
+  if (skeleton)
+    mesh->SetSkeleton(skeleton);
+  return mesh.release();
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGNITION_COMMON_BINARYMESH_HH_
+#define IGNITION_COMMON_BINARYMESH_HH_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace ignition
+{
+  namespace common
+  {
+    class Mesh;
+
+    /// \brief Write a mesh in the native binary mesh format.
+    ///
+    /// The file starts with a 16 byte header (magic, format version and a
+    /// byte order mark) followed by chunks. Each chunk has a four character
+    /// tag, 32 bits of flags, a 64 bit payload size, and a payload padded to
+    /// 8 bytes. Arrays inside payloads are 8 byte aligned from the start of
+    /// the file, so a memory mapped file is decoded without parsing and
+    /// without unaligned reads. Readers skip chunks with unknown tags.
+    ///
+    /// Optionally, the payloads of material, submesh, skeleton and
+    /// animation chunks are compressed with a byte shuffle followed by a
+    /// fast LZ77 coder, when that makes them smaller. A flag marks these
+    /// chunks; they are decompressed into memory when read.
+    ///
+    /// Everything that defines the mesh is stored: submeshes with all
+    /// vertex attributes, node assignments and vertex storage, materials
+    /// including PBR properties, the skeleton with its vertex weights, and
+    /// skeleton animations.
+    /// \param[in] _mesh Mesh to write.
+    /// \param[in] _key Opaque string stored with the mesh, for example to
+    /// identify the file the mesh was loaded from.
+    /// \param[out] _out Stream to write to.
+    /// \param[in] _compress True to compress chunk payloads.
+    /// \return True if the stream accepted all the data.
+    bool WriteBinaryMesh(const Mesh &_mesh, const std::string &_key,
+        std::ostream &_out, const bool _compress = false);
+
+    /// \brief Read the key stored by WriteBinaryMesh, without decoding the
+    /// mesh.
+    /// \param[in] _data Content of a binary mesh file.
+    /// \param[in] _size Number of bytes in _data.
+    /// \param[out] _key The key.
+    /// \return False if _data does not start like a binary mesh of the
+    /// current version.
+    bool ReadBinaryMeshKey(const char *_data, const std::size_t _size,
+        std::string &_key);
+
+    /// \brief Read a mesh written by WriteBinaryMesh.
+    /// \param[in] _data Content of a binary mesh file. It must be aligned to
+    /// 8 bytes.
+    /// \param[in] _size Number of bytes in _data.
+    /// \return New mesh owned by the caller, or nullptr if _data is not a
+    /// complete binary mesh of the current version.
+    Mesh *ReadBinaryMesh(const char *_data, const std::size_t _size);
+  }
+}
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#include <fstream>
+
+#include "ignition/common/BinaryMeshExporter.hh"
+#include "ignition/common/Console.hh"
+#include "ignition/common/Mesh.hh"
+
+#include "BinaryMesh.hh"
+
+using namespace ignition;
+using namespace common;
+
+/// \brief Private data for the BinaryMeshExporter class
+class ignition::common::BinaryMeshExporter::Implementation
+{
+  /// \brief True to compress chunk payloads
+  public: bool compress = false;
+};
+
+//////////////////////////////////////////////////
+BinaryMeshExporter::BinaryMeshExporter()
+: MeshExporter(), dataPtr(ignition::utils::MakeImpl<Implementation>())
+{
+}
+
+//////////////////////////////////////////////////
+BinaryMeshExporter::~BinaryMeshExporter()
+{
+}
+
+//////////////////////////////////////////////////
+void BinaryMeshExporter::SetCompression(const bool _compress)
+{
+  this->dataPtr->compress = _compress;
+}
+
+//////////////////////////////////////////////////
+bool BinaryMeshExporter::Compression() const
+{
+  return this->dataPtr->compress;
+}
+
+//////////////////////////////////////////////////
+void BinaryMeshExporter::Export(const Mesh *_mesh,
+    const std::string &_filename, bool /*_exportTextures*/)
+{
+  if (!_mesh)
+  {
+    ignerr << "Unable to export a null mesh\n";
+    return;
+  }
+
+  const std::string filename = _filename + ".ignmesh";
+  std::ofstream out(filename, std::ios::binary);
+  bool written = out &&
+    WriteBinaryMesh(*_mesh, std::string(), out, this->dataPtr->compress);
+  out.close();
+  written = written && !out.fail();
+
+  if (!written)
+    ignerr << "Unable to write binary mesh file[" << filename << "]\n";
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#include "ignition/common/BinaryMeshLoader.hh"
+#include "ignition/common/Console.hh"
+#include "ignition/common/Mesh.hh"
+
+#include "BinaryMesh.hh"
+#include "MappedFile.hh"
+
+using namespace ignition;
+using namespace common;
+
+/// \brief Private data for the BinaryMeshLoader class
+class ignition::common::BinaryMeshLoader::Implementation
+{
+};
+
+//////////////////////////////////////////////////
+BinaryMeshLoader::BinaryMeshLoader()
+: MeshLoader(), dataPtr(ignition::utils::MakeImpl<Implementation>())
+{
+}
+
+//////////////////////////////////////////////////
+BinaryMeshLoader::~BinaryMeshLoader()
+{
+}
+
+//////////////////////////////////////////////////
+Mesh *BinaryMeshLoader::Load(const std::string &_filename)
+{
+  MappedFile file(_filename);
+  if (!file.Valid())
+  {
+    ignerr << "Unable to open file[" << _filename << "]\n";
+    return nullptr;
+  }
+
+  Mesh *mesh = ReadBinaryMesh(file.Data(), file.Size());
+  if (!mesh)
+    ignerr << "Invalid binary mesh file[" << _filename << "]\n";
+  return mesh;
+}
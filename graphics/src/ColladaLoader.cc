@@ -14,6 +14,13 @@
  * limitations under the License.
  *
  */
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 #include <map>
@@ -32,12 +39,15 @@
 #include "ignition/common/Material.hh"
 #include "ignition/common/SubMesh.hh"
 #include "ignition/common/Mesh.hh"
+#include "ignition/common/Parallel.hh"
 #include "ignition/common/Skeleton.hh"
 #include "ignition/common/SkeletonAnimation.hh"
 #include "ignition/common/SystemPaths.hh"
 #include "ignition/common/Util.hh"
 #include "ignition/common/ColladaLoader.hh"
 
+#include "NumberParser.hh"
+
 using namespace ignition;
 using namespace common;
 using RawNodeAnim = std::map<double, std::vector<NodeTransform> >;
@@ -47,6 +57,97 @@ namespace ignition
 {
   namespace common
   {
+    /// \brief Values of a COLLADA <source> element. A source is parsed once
+    /// per file, and shared read only by all the primitives that use it.
+    template <typename T>
+    class ColladaSource
+    {
+      /// \brief The values, in the order of the <float_array>
+      public: std::vector<T> values;
+
+      /// \brief Index of the first value equal to each value
+      public: std::vector<unsigned int> first;
+
+      /// \brief Get the index of the first value equal to a value
+      /// \param[in] _index Index of a value
+      /// \return Index of the first equal value, or _index if there is no
+      /// such value
+      public: unsigned int First(const unsigned int _index) const
+      {
+        return _index < this->first.size() ? this->first[_index] : _index;
+      }
+    };
+
+    /// \brief Source of positions or normals
+    using Vector3Source = ColladaSource<ignition::math::Vector3d>;
+
+    /// \brief Source of texture coordinates
+    using Vector2Source = ColladaSource<ignition::math::Vector2d>;
+
+    /// \brief Shared source of positions or normals
+    using Vector3SourcePtr = std::shared_ptr<const Vector3Source>;
+
+    /// \brief Shared source of texture coordinates
+    using Vector2SourcePtr = std::shared_ptr<const Vector2Source>;
+
+    /// \brief A <triangles>, <polylist> or <lines> element whose submesh
+    /// is decoded later, in parallel with other primitives
+    class PendingPrimitive
+    {
+      /// \brief The primitive element
+      public: tinyxml2::XMLElement *xml = nullptr;
+
+      /// \brief Transform of the node that instances the geometry
+      public: ignition::math::Matrix4d transform;
+
+      /// \brief The submesh, with its name, type and material already set
+      public: std::unique_ptr<SubMesh> subMesh;
+
+      /// \brief True if the submesh was decoded and belongs to the mesh
+      public: bool decoded = false;
+    };
+
+    /// \brief A source used by pending primitives, with the transform of
+    /// the first primitive that uses it
+    class SourceRequest
+    {
+      /// \brief Semantic of the source: POSITION, NORMAL or TEXCOORD
+      public: std::string semantic;
+
+      /// \brief Id of the source
+      public: std::string id;
+
+      /// \brief Transform applied to the source
+      public: ignition::math::Matrix4d transform;
+    };
+
+    /// \brief State shared by the threads that decode primitives. It only
+    /// lives during a call to Load, so copies of a loader start without it.
+    class DecodeState
+    {
+      /// \brief Constructor
+      public: DecodeState() = default;
+
+      /// \brief Copy constructor. Nothing is copied.
+      public: DecodeState(const DecodeState &)
+      {
+      }
+
+      /// \brief Assignment operator. Nothing is copied.
+      /// \return Reference to this state
+      public: DecodeState &operator=(const DecodeState &)
+      {
+        return *this;
+      }
+
+      /// \brief Protects the source caches while primitives are decoded
+      /// in parallel
+      public: std::mutex sourceMutex;
+
+      /// \brief Primitives waiting to be decoded, in document order
+      public: std::vector<PendingPrimitive> pending;
+    };
+
     /// \brief Private data for the ColladaLoader class
     class  ColladaLoader::Implementation
     {
@@ -68,35 +169,23 @@ namespace ignition
       /// \brief Name of the current node.
       public: std::string currentNodeName;
 
-      /// \brief Map of collada POSITION ids to list of vectors.
-      public: std::map<std::string,
-              std::vector<ignition::math::Vector3d> > positionIds;
+      /// \brief Map of collada POSITION ids to positions.
+      public: std::unordered_map<std::string, Vector3SourcePtr> positionIds;
 
-      /// \brief Map of collada NORMAL ids to list of normals.
-      public: std::map<std::string,
-              std::vector<ignition::math::Vector3d> > normalIds;
+      /// \brief Map of collada NORMAL ids to normals.
+      public: std::unordered_map<std::string, Vector3SourcePtr> normalIds;
 
-      /// \brief Map of collada TEXCOORD ids to list of texture coordinates.
-      public: std::map<std::string,
-              std::vector<ignition::math::Vector2d> >texcoordIds;
+      /// \brief Map of collada TEXCOORD ids to texture coordinates.
+      public: std::unordered_map<std::string, Vector2SourcePtr> texcoordIds;
 
       /// \brief Map of collada Material ids to Gazebo materials.
       public: std::map<std::string, MaterialPtr> materialIds;
 
-      /// \brief Map of collada POSITION ids to a map of
-      /// duplicate positions.
-      public: std::map<std::string, std::map<unsigned int, unsigned int> >
-          positionDuplicateMap;
+      /// \brief True to decode primitives in parallel
+      public: bool parallel = false;
 
-      /// \brief Map of collada NORMAL ids to a map of
-      /// duplicate normals.
-      public: std::map<std::string, std::map<unsigned int, unsigned int> >
-          normalDuplicateMap;
-
-      /// \brief Map of collada TEXCOORD ids to a map of
-      /// duplicate texture coordinates.
-      public: std::map<std::string, std::map<unsigned int, unsigned int> >
-          texcoordDuplicateMap;
+      /// \brief Pending primitives, and the lock of the source caches
+      public: DecodeState decode;
 
       /// \brief Current scene being parsed
       public: tinyxml2::XMLElement *currentScene = nullptr;
@@ -183,53 +272,30 @@ namespace ignition
       /// \param[in] _id String id of the vertices XML node
       /// \param[in] _transform Transform to apply to all vertices
       /// \param[out] _verts Holds the resulting vertices
-      /// \param[out] _norms Holds the resulting normals
+      /// \param[out] _norms Holds the resulting normals. Not changed if the
+      /// vertices have no normals.
       public: void LoadVertices(const std::string &_id,
           const ignition::math::Matrix4d &_transform,
-          std::vector<ignition::math::Vector3d> &_verts,
-          std::vector<ignition::math::Vector3d> &_norms);
-
-      /// \brief Load vertices
-      /// \param[in] _id String id of the vertices XML node
-      /// \param[in] _transform Transform to apply to all vertices
-      /// \param[out] _verts Holds the resulting vertices
-      /// \param[out] _norms Holds the resulting normals
-      /// \param[out] _vertDup Holds a map of duplicate position indices
-      /// \param[out] _normDup Holds a map of duplicate normal indices
-      public: void LoadVertices(const std::string &_id,
-                                 const ignition::math::Matrix4d &_transform,
-                                 std::vector<ignition::math::Vector3d> &_verts,
-                                 std::vector<ignition::math::Vector3d> &_norms,
-                                 std::map<unsigned int, unsigned int> &_vertDup,
-                                std::map<unsigned int, unsigned int> &_normDup);
+          Vector3SourcePtr &_verts, Vector3SourcePtr &_norms);
 
       /// \brief Load positions
       /// \param[in] _id String id of the XML node
       /// \param[in] _transform Transform to apply to all positions
-      /// \param[out] _values Holds the resulting position values
-      /// \param[out] _duplicates Holds a map of duplicate position indices
-      public: void LoadPositions(const std::string &_id,
-                                  const ignition::math::Matrix4d &_transform,
-                                 std::vector<ignition::math::Vector3d> &_values,
-                             std::map<unsigned int, unsigned int> &_duplicates);
+      /// \return The positions and their duplicates
+      public: Vector3SourcePtr LoadPositions(const std::string &_id,
+          const ignition::math::Matrix4d &_transform);
 
       /// \brief Load normals
       /// \param[in] _id String id of the XML node
       /// \param[in] _transform Transform to apply to all normals
-      /// \param[out] _values Holds the resulting normal values
-      /// \param[out] _duplicates Holds a map of duplicate normal indices
-      public: void LoadNormals(const std::string &_id,
-                                const ignition::math::Matrix4d &_transform,
-                                std::vector<ignition::math::Vector3d> &_values,
-                             std::map<unsigned int, unsigned int> &_duplicates);
+      /// \return The normals and their duplicates
+      public: Vector3SourcePtr LoadNormals(const std::string &_id,
+          const ignition::math::Matrix4d &_transform);
 
       /// \brief Load texture coordinates
       /// \param[in] _id String id of the XML node
-      /// \param[out] _values Holds the resulting uv values
-      /// \param[out] _duplicates Holds a map of duplicate uv indices
-      public: void LoadTexCoords(const std::string &_id,
-                                 std::vector<ignition::math::Vector2d> &_values,
-                             std::map<unsigned int, unsigned int> &_duplicates);
+      /// \return The uv values and their duplicates
+      public: Vector2SourcePtr LoadTexCoords(const std::string &_id);
 
       /// \brief Load a material
       /// \param _name Name of the material XML element
@@ -244,29 +310,70 @@ namespace ignition
                                        const std::string &_type,
                                        MaterialPtr _mat);
 
+      /// \brief Load a <triangles>, <polylist> or <lines> element. The
+      /// submesh is created and given its material right away. In parallel
+      /// mode, it is decoded later by DecodePending unless the mesh has a
+      /// skeleton.
+      /// \param[in] _xml Pointer to the XML element
+      /// \param[in] _transform Transform to apply
+      /// \param[in,out] _mesh Mesh that is currently being loaded
+      public: void LoadPrimitive(tinyxml2::XMLElement *_xml,
+                                 const ignition::math::Matrix4d &_transform,
+                                 Mesh *_mesh);
+
+      /// \brief Decode a primitive element into its submesh
+      /// \param[in] _xml Pointer to the XML element
+      /// \param[in] _transform Transform to apply
+      /// \param[in] _mesh Mesh that is currently being loaded. It is only
+      /// read.
+      /// \param[out] _subMesh Submesh to fill
+      /// \return False if the submesh should not be added to the mesh
+      public: bool DecodePrimitive(tinyxml2::XMLElement *_xml,
+                                   const ignition::math::Matrix4d &_transform,
+                                   const Mesh *_mesh, SubMesh &_subMesh);
+
+      /// \brief Decode all pending primitives in parallel, and add their
+      /// submeshes to the mesh in document order
+      /// \param[in,out] _mesh Mesh that is currently being loaded
+      public: void DecodePending(Mesh *_mesh);
+
+      /// \brief List the sources used by a primitive element
+      /// \param[in] _xml Pointer to the XML element
+      /// \param[in] _transform Transform to apply
+      /// \param[in,out] _requests Sources to load. Sources already listed
+      /// are not added again.
+      /// \param[in,out] _listed Semantics and ids of the listed sources
+      public: void ListSources(tinyxml2::XMLElement *_xml,
+                               const ignition::math::Matrix4d &_transform,
+                               std::vector<SourceRequest> &_requests,
+                               std::set<std::string> &_listed);
+
       /// \brief Load triangles
       /// \param[in] _trianglesXml Pointer the triangles XML instance
       /// \param[in] _transform Transform to apply to all triangles
-      /// \param[out] _mesh Mesh that is currently being loaded
-      public: void LoadTriangles(tinyxml2::XMLElement *_trianglesXml,
+      /// \param[in] _mesh Mesh that is currently being loaded
+      /// \param[out] _subMesh Submesh to fill
+      /// \return False if the triangles could not be read
+      public: bool LoadTriangles(tinyxml2::XMLElement *_trianglesXml,
                                   const ignition::math::Matrix4d &_transform,
-                                  Mesh *_mesh);
+                                  const Mesh *_mesh, SubMesh &_subMesh);
 
       /// \brief Load a polygon list
       /// \param[in] _polylistXml Pointer to the XML element
       /// \param[in] _transform Transform to apply to each polygon
-      /// \param[out] _mesh Mesh that is currently being loaded
+      /// \param[in] _mesh Mesh that is currently being loaded
+      /// \param[out] _subMesh Submesh to fill
       public: void LoadPolylist(tinyxml2::XMLElement *_polylistXml,
                                    const ignition::math::Matrix4d &_transform,
-                                   Mesh *_mesh);
+                                   const Mesh *_mesh, SubMesh &_subMesh);
 
       /// \brief Load lines
       /// \param[in] _xml Pointer to the XML element
       /// \param[in] _transform Transform to apply
-      /// \param[out] _mesh Mesh that is currently being loaded
+      /// \param[out] _subMesh Submesh to fill
       public: void LoadLines(tinyxml2::XMLElement *_xml,
                               const ignition::math::Matrix4d &_transform,
-                              Mesh *_mesh);
+                              SubMesh &_subMesh);
 
       /// \brief Load an entire scene
       /// \param[out] _mesh Mesh that is currently being loaded
@@ -326,37 +433,191 @@ namespace ignition
   }
 }
 
-/////////////////////////////////////////////////
-void hash_combine(std::size_t &_seed, const double &_v)
+namespace
 {
-  std::hash<double> hasher;
-  _seed ^= hasher(_v) + 0x9e3779b9 + (_seed << 6) + (_seed >> 2);
-}
+  /// \brief Check for a character that separates the items of a list
+  /// \param[in] _c Character
+  /// \return True if _c is a space, a tab or a line break
+  bool IsListSpace(const char _c)
+  {
+    return _c == ' ' || _c == '\t' || _c == '\n' || _c == '\r';
+  }
 
-/////////////////////////////////////////////////
-struct Vector3Hash
-{
-  std::size_t operator()(const ignition::math::Vector3d &_v) const
+  /// \brief Call a function on each item of a whitespace separated list
+  /// \param[in] _text Null terminated list, or nullptr
+  /// \param[in] _fn Function called with the start and the end of each
+  /// item
+  template <typename Fn>
+  void ForEachItem(const char *_text, Fn _fn)
+  {
+    const char *p = _text;
+    while (p && *p)
+    {
+      if (IsListSpace(*p))
+      {
+        ++p;
+        continue;
+      }
+      const char *begin = p;
+      while (*p && !IsListSpace(*p))
+        ++p;
+      _fn(begin, p);
+    }
+  }
+
+  /// \brief Parse the numbers of a <float_array>
+  /// \param[in] _text Null terminated list of numbers
+  /// \param[in] _count Expected number of values, used to reserve memory
+  /// \return The numbers, with NaN for items that are not numbers
+  std::vector<double> ParseFloats(const char *_text, const std::size_t _count)
   {
-    std::size_t seed = 0;
-    hash_combine(seed, _v.X());
-    hash_combine(seed, _v.Y());
-    hash_combine(seed, _v.Z());
-    return seed;
+    std::vector<double> values;
+    values.reserve(std::min(_count, std::strlen(_text) / 2u + 1u));
+    ForEachItem(_text, [&values](const char *_begin, const char *_end)
+    {
+      double value;
+      if (!ParseDecimal(_begin, _end, value))
+        value = ignition::math::parseFloat(std::string(_begin, _end));
+      values.push_back(value);
+    });
+    return values;
   }
-};
 
-/////////////////////////////////////////////////
-struct Vector2dHash
-{
-  std::size_t operator()(const ignition::math::Vector2d &_v) const
+  /// \brief Parse the indices of a <p> or a <vcount> element
+  /// \param[in] _text Null terminated list of indices, or nullptr
+  /// \return The indices
+  std::vector<unsigned int> ParseIndices(const char *_text)
+  {
+    std::vector<unsigned int> values;
+    ForEachItem(_text, [&values](const char *_begin, const char *_end)
+    {
+      // Plain numbers with up to 9 digits can not overflow
+      unsigned int value = 0;
+      const char *p = _begin;
+      for (; p < _end && p - _begin < 9 &&
+          static_cast<unsigned int>(*p - '0') < 10u; ++p)
+      {
+        value = value * 10u + static_cast<unsigned int>(*p - '0');
+      }
+      if (p != _end)
+      {
+        value = static_cast<unsigned int>(
+            ignition::math::parseInt(std::string(_begin, _end)));
+      }
+      values.push_back(value);
+    });
+    return values;
+  }
+
+  /// \brief Get the bits of a coordinate, for hashing. Zero and negative
+  /// zero have the same bits.
+  /// \param[in] _v Coordinate
+  /// \return The bits
+  uint64_t CoordinateBits(const double _v)
+  {
+    const double v = _v + 0.0;
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+  }
+
+  /// \brief Hash a position or a normal
+  /// \param[in] _v Value
+  /// \return Hash of the coordinates
+  uint64_t HashValue(const ignition::math::Vector3d &_v)
+  {
+    const uint64_t k = 0x9e3779b97f4a7c15ull;
+    uint64_t h = CoordinateBits(_v.X()) * k;
+    h = (h ^ CoordinateBits(_v.Y())) * k;
+    h = (h ^ CoordinateBits(_v.Z())) * k;
+    return h ^ (h >> 29);
+  }
+
+  /// \brief Hash a texture coordinate
+  /// \param[in] _v Value
+  /// \return Hash of the coordinates
+  uint64_t HashValue(const ignition::math::Vector2d &_v)
+  {
+    const uint64_t k = 0x9e3779b97f4a7c15ull;
+    uint64_t h = CoordinateBits(_v.X()) * k;
+    h = (h ^ CoordinateBits(_v.Y())) * k;
+    return h ^ (h >> 29);
+  }
+
+  /// \brief Check whether two positions or normals have equal coordinates
+  /// \param[in] _a First value
+  /// \param[in] _b Second value
+  /// \return True if all coordinates compare equal
+  bool SameValue(const ignition::math::Vector3d &_a,
+      const ignition::math::Vector3d &_b)
+  {
+    return _a.X() == _b.X() && _a.Y() == _b.Y() && _a.Z() == _b.Z();
+  }
+
+  /// \brief Check whether two texture coordinates are equal
+  /// \param[in] _a First value
+  /// \param[in] _b Second value
+  /// \return True if all coordinates compare equal
+  bool SameValue(const ignition::math::Vector2d &_a,
+      const ignition::math::Vector2d &_b)
   {
-    std::size_t seed = 0;
-    hash_combine(seed, _v.X());
-    hash_combine(seed, _v.Y());
-    return seed;
+    return _a.X() == _b.X() && _a.Y() == _b.Y();
   }
-};
+
+  /// \brief Decodes every string of a document. tinyxml2 decodes strings
+  /// in place the first time they are read, so a document can only be read
+  /// from several threads once all its strings are decoded.
+  class StringResolver : public tinyxml2::XMLVisitor
+  {
+    using tinyxml2::XMLVisitor::VisitEnter;
+    using tinyxml2::XMLVisitor::Visit;
+
+    // Documentation inherited
+    public: bool VisitEnter(const tinyxml2::XMLElement &_element,
+        const tinyxml2::XMLAttribute *_attribute) override
+    {
+      _element.Value();
+      for (; _attribute; _attribute = _attribute->Next())
+      {
+        _attribute->Name();
+        _attribute->Value();
+      }
+      return true;
+    }
+
+    // Documentation inherited
+    public: bool Visit(const tinyxml2::XMLText &_text) override
+    {
+      _text.Value();
+      return true;
+    }
+  };
+
+  /// \brief Find the first occurrence of every value of a source, with an
+  /// open addressing hash table of value indices
+  /// \param[in,out] _source Source whose first indices are computed
+  template <typename T>
+  void FindDuplicates(ignition::common::ColladaSource<T> &_source)
+  {
+    const std::vector<T> &values = _source.values;
+    std::size_t capacity = 16u;
+    while (capacity < values.size() * 2u)
+      capacity *= 2u;
+
+    const unsigned int empty = std::numeric_limits<unsigned int>::max();
+    std::vector<unsigned int> table(capacity, empty);
+    _source.first.resize(values.size());
+    for (unsigned int i = 0; i < values.size(); ++i)
+    {
+      std::size_t slot = HashValue(values[i]) & (capacity - 1u);
+      while (table[slot] != empty && !SameValue(values[table[slot]], values[i]))
+        slot = (slot + 1u) & (capacity - 1u);
+      if (table[slot] == empty)
+        table[slot] = i;
+      _source.first[i] = table[slot];
+    }
+  }
+}
 
 //////////////////////////////////////////////////
 ColladaLoader::ColladaLoader()
@@ -377,9 +638,6 @@ Mesh *ColladaLoader::Load(const std::string &_filename)
   this->dataPtr->normalIds.clear();
   this->dataPtr->texcoordIds.clear();
   this->dataPtr->materialIds.clear();
-  this->dataPtr->positionDuplicateMap.clear();
-  this->dataPtr->normalDuplicateMap.clear();
-  this->dataPtr->texcoordDuplicateMap.clear();
 
   // reset scale
   this->dataPtr->meter = 1.0;
@@ -400,6 +658,12 @@ Mesh *ColladaLoader::Load(const std::string &_filename)
   if (xmlDoc.LoadFile(_filename.c_str()) != tinyxml2::XML_SUCCESS)
     ignerr << "Unable to load collada file[" << _filename << "]\n";
 
+  if (this->dataPtr->parallel)
+  {
+    StringResolver resolver;
+    xmlDoc.Accept(&resolver);
+  }
+
   this->dataPtr->colladaXml = xmlDoc.FirstChildElement("COLLADA");
   if (!this->dataPtr->colladaXml)
     ignerr << "Missing COLLADA tag\n";
@@ -423,6 +687,11 @@ Mesh *ColladaLoader::Load(const std::string &_filename)
 
   this->dataPtr->LoadScene(mesh);
 
+  // Sources are only needed while loading
+  this->dataPtr->positionIds.clear();
+  this->dataPtr->normalIds.clear();
+  this->dataPtr->texcoordIds.clear();
+
   if (mesh->HasSkeleton())
     this->dataPtr->ApplyInvBindTransform(mesh->MeshSkeleton());
 
@@ -435,6 +704,18 @@ Mesh *ColladaLoader::Load(const std::string &_filename)
   return mesh;
 }
 
+/////////////////////////////////////////////////
+void ColladaLoader::SetParallel(const bool _parallel)
+{
+  this->dataPtr->parallel = _parallel;
+}
+
+/////////////////////////////////////////////////
+bool ColladaLoader::Parallel() const
+{
+  return this->dataPtr->parallel;
+}
+
 /////////////////////////////////////////////////
 void ColladaLoader::Implementation::LoadScene(Mesh *_mesh)
 {
@@ -457,6 +738,8 @@ void ColladaLoader::Implementation::LoadScene(Mesh *_mesh)
     this->LoadNode(nodeXml, _mesh, ignition::math::Matrix4d::Identity);
     nodeXml = nodeXml->NextSiblingElement("node");
   }
+
+  this->DecodePending(_mesh);
 }
 
 /////////////////////////////////////////////////
@@ -501,7 +784,7 @@ void ColladaLoader::Implementation::LoadNode(
     if (nodeName.empty())
     {
       // if none of the ancestor node has a name, then create a custom name
-      static int nodeCounter = 0;
+      static std::atomic<int> nodeCounter{0};
       nodeName = "unnamed_submesh_" + std::to_string(nodeCounter++);
     }
     this->currentNodeName = nodeName;
@@ -679,6 +962,9 @@ void ColladaLoader::Implementation::LoadController(
     const ignition::math::Matrix4d &_transform,
     Mesh *_mesh)
 {
+  // Submeshes loaded before the skeleton do not depend on it
+  this->DecodePending(_mesh);
+
   if (nullptr == _contrXml)
   {
     ignerr << "Can't load null controller element." << std::endl;
@@ -1324,25 +1610,186 @@ void ColladaLoader::Implementation::LoadGeometry(tinyxml2::XMLElement *_xml,
   childXml = meshXml->FirstChildElement("triangles");
   while (childXml)
   {
-    this->LoadTriangles(childXml, _transform, _mesh);
+    this->LoadPrimitive(childXml, _transform, _mesh);
     childXml = childXml->NextSiblingElement("triangles");
   }
 
   childXml = meshXml->FirstChildElement("polylist");
   while (childXml)
   {
-    this->LoadPolylist(childXml, _transform, _mesh);
+    this->LoadPrimitive(childXml, _transform, _mesh);
     childXml = childXml->NextSiblingElement("polylist");
   }
 
   childXml = meshXml->FirstChildElement("lines");
   while (childXml)
   {
-    this->LoadLines(childXml, _transform, _mesh);
+    this->LoadPrimitive(childXml, _transform, _mesh);
     childXml = childXml->NextSiblingElement("lines");
   }
 }
 
+/////////////////////////////////////////////////
+void ColladaLoader::Implementation::LoadPrimitive(
+    tinyxml2::XMLElement *_xml, const ignition::math::Matrix4d &_transform,
+    Mesh *_mesh)
+{
+  const std::string type = _xml->Value();
+  std::unique_ptr<SubMesh> subMesh(new SubMesh);
+  subMesh->SetName(this->currentNodeName);
+  subMesh->SetPrimitiveType(
+      type == "lines" ? SubMesh::LINES : SubMesh::TRIANGLES);
+
+  // Materials are added to the mesh in document order
+  if (type != "lines" && _xml->Attribute("material"))
+  {
+    std::map<std::string, std::string>::iterator iter;
+    std::string matStr = _xml->Attribute("material");
+
+    int matIndex = -1;
+    iter = this->materialMap.find(matStr);
+    if (iter != this->materialMap.end())
+      matStr = iter->second;
+
+    MaterialPtr mat = this->LoadMaterial(matStr);
+    matIndex = _mesh->IndexOfMaterial(mat.get());
+    if (matIndex < 0)
+      matIndex = _mesh->AddMaterial(mat);
+
+    if (matIndex < 0)
+      ignwarn << "Unable to add material[" << matStr << "]\n";
+    else
+      subMesh->SetMaterialIndex(matIndex);
+  }
+
+  // Skinned submeshes depend on the skeleton as it is now
+  if (this->parallel && !_mesh->HasSkeleton())
+  {
+    PendingPrimitive primitive;
+    primitive.xml = _xml;
+    primitive.transform = _transform;
+    primitive.subMesh = std::move(subMesh);
+    this->decode.pending.push_back(std::move(primitive));
+    return;
+  }
+
+  if (this->DecodePrimitive(_xml, _transform, _mesh, *subMesh))
+    _mesh->AddSubMesh(std::move(subMesh));
+}
+
+/////////////////////////////////////////////////
+bool ColladaLoader::Implementation::DecodePrimitive(
+    tinyxml2::XMLElement *_xml, const ignition::math::Matrix4d &_transform,
+    const Mesh *_mesh, SubMesh &_subMesh)
+{
+  const std::string type = _xml->Value();
+  if (type == "triangles")
+    return this->LoadTriangles(_xml, _transform, _mesh, _subMesh);
+
+  if (type == "polylist")
+    this->LoadPolylist(_xml, _transform, _mesh, _subMesh);
+  else
+    this->LoadLines(_xml, _transform, _subMesh);
+  return true;
+}
+
+/////////////////////////////////////////////////
+void ColladaLoader::Implementation::DecodePending(Mesh *_mesh)
+{
+  if (this->decode.pending.empty())
+    return;
+
+  // A source shared by several primitives is transformed like in the first
+  // primitive that uses it, as when decoding serially
+  std::vector<SourceRequest> requests;
+  std::set<std::string> listed;
+  for (const auto &primitive : this->decode.pending)
+  {
+    this->ListSources(primitive.xml, primitive.transform, requests, listed);
+  }
+
+  ParallelFor(0u, requests.size(), 1u,
+      [&](const std::size_t _first, const std::size_t _last)
+      {
+        for (std::size_t i = _first; i < _last; ++i)
+        {
+          const SourceRequest &request = requests[i];
+          if (request.semantic == "POSITION")
+            this->LoadPositions(request.id, request.transform);
+          else if (request.semantic == "NORMAL")
+            this->LoadNormals(request.id, request.transform);
+          else
+            this->LoadTexCoords(request.id);
+        }
+      });
+
+  ParallelFor(0u, this->decode.pending.size(), 1u,
+      [&](const std::size_t _first, const std::size_t _last)
+      {
+        for (std::size_t i = _first; i < _last; ++i)
+        {
+          PendingPrimitive &primitive = this->decode.pending[i];
+          primitive.decoded = this->DecodePrimitive(primitive.xml,
+              primitive.transform, _mesh, *primitive.subMesh);
+        }
+      });
+
+  for (auto &primitive : this->decode.pending)
+  {
+    if (primitive.decoded)
+      _mesh->AddSubMesh(std::move(primitive.subMesh));
+  }
+  this->decode.pending.clear();
+}
+
+/////////////////////////////////////////////////
+void ColladaLoader::Implementation::ListSources(
+    tinyxml2::XMLElement *_xml, const ignition::math::Matrix4d &_transform,
+    std::vector<SourceRequest> &_requests, std::set<std::string> &_listed)
+{
+  auto list = [&](const std::string &_semantic, const char *_id)
+  {
+    if (_id && _listed.insert(_semantic + " " + _id).second)
+      _requests.push_back({_semantic, _id, _transform});
+  };
+
+  // Lines only use their first input
+  const bool lines = std::string(_xml->Value()) == "lines";
+  for (tinyxml2::XMLElement *inputXml = _xml->FirstChildElement("input");
+      inputXml; inputXml = lines ? nullptr :
+      inputXml->NextSiblingElement("input"))
+  {
+    const char *semantic = inputXml->Attribute("semantic");
+    const char *source = inputXml->Attribute("source");
+    if (!source || (!semantic && !lines))
+      continue;
+
+    if (lines || std::string(semantic) == "VERTEX")
+    {
+      tinyxml2::XMLElement *verticesXml = this->ElementId(this->colladaXml,
+          "vertices", source);
+      if (!verticesXml)
+        continue;
+      for (tinyxml2::XMLElement *vertexInputXml =
+          verticesXml->FirstChildElement("input"); vertexInputXml;
+          vertexInputXml = vertexInputXml->NextSiblingElement("input"))
+      {
+        const char *vertexSemantic = vertexInputXml->Attribute("semantic");
+        if (vertexSemantic && (std::string(vertexSemantic) == "POSITION" ||
+              std::string(vertexSemantic) == "NORMAL"))
+        {
+          list(vertexSemantic, vertexInputXml->Attribute("source"));
+        }
+      }
+    }
+    else if (std::string(semantic) == "NORMAL" ||
+        std::string(semantic) == "TEXCOORD")
+    {
+      list(semantic, source);
+    }
+  }
+}
+
 /////////////////////////////////////////////////
 tinyxml2::XMLElement *ColladaLoader::Implementation::ElementId(
     const std::string &_name, const std::string &_id)
@@ -1384,21 +1831,7 @@ tinyxml2::XMLElement *ColladaLoader::Implementation::ElementId(
 /////////////////////////////////////////////////
 void ColladaLoader::Implementation::LoadVertices(const std::string &_id,
     const ignition::math::Matrix4d &_transform,
-    std::vector<ignition::math::Vector3d> &_verts,
-    std::vector<ignition::math::Vector3d> &_norms)
-{
-  std::map<unsigned int, unsigned int> vertDup;
-  std::map<unsigned int, unsigned int> normDup;
-  this->LoadVertices(_id, _transform, _verts, _norms, vertDup, normDup);
-}
-
-/////////////////////////////////////////////////
-void ColladaLoader::Implementation::LoadVertices(const std::string &_id,
-    const ignition::math::Matrix4d &_transform,
-    std::vector<ignition::math::Vector3d> &_verts,
-    std::vector<ignition::math::Vector3d> &_norms,
-    std::map<unsigned int, unsigned int> &_vertDups,
-    std::map<unsigned int, unsigned int> &_normDups)
+    Vector3SourcePtr &_verts, Vector3SourcePtr &_norms)
 {
   tinyxml2::XMLElement *verticesXml = this->ElementId(this->colladaXml,
       "vertices", _id);
@@ -1416,11 +1849,11 @@ void ColladaLoader::Implementation::LoadVertices(const std::string &_id,
     std::string sourceStr = inputXml->Attribute("source");
     if (semantic == "NORMAL")
     {
-      this->LoadNormals(sourceStr, _transform, _norms, _normDups);
+      _norms = this->LoadNormals(sourceStr, _transform);
     }
     else if (semantic == "POSITION")
     {
-      this->LoadPositions(sourceStr, _transform, _verts, _vertDups);
+      _verts = this->LoadPositions(sourceStr, _transform);
     }
 
     inputXml = inputXml->NextSiblingElement("input");
@@ -1428,23 +1861,22 @@ void ColladaLoader::Implementation::LoadVertices(const std::string &_id,
 }
 
 /////////////////////////////////////////////////
-void ColladaLoader::Implementation::LoadPositions(const std::string &_id,
-    const ignition::math::Matrix4d &_transform,
-    std::vector<ignition::math::Vector3d> &_values,
-    std::map<unsigned int, unsigned int> &_duplicates)
+Vector3SourcePtr ColladaLoader::Implementation::LoadPositions(
+    const std::string &_id, const ignition::math::Matrix4d &_transform)
 {
-  if (this->positionIds.find(_id) != this->positionIds.end())
   {
-    _values = this->positionIds[_id];
-    _duplicates = this->positionDuplicateMap[_id];
-    return;
+    std::lock_guard<std::mutex> lock(this->decode.sourceMutex);
+    auto cached = this->positionIds.find(_id);
+    if (cached != this->positionIds.end())
+      return cached->second;
   }
 
+  auto source = std::make_shared<Vector3Source>();
   tinyxml2::XMLElement *sourceXml = this->ElementId("source", _id);
   if (!sourceXml)
   {
     ignerr << "Unable to find source\n";
-    return;
+    return source;
   }
 
   tinyxml2::XMLElement *floatArrayXml =
@@ -1475,57 +1907,45 @@ void ColladaLoader::Implementation::LoadPositions(const std::string &_id,
         << "This is likely not desired\n";
     }
 
-    return;
+    return source;
   }
-  std::string valueStr = floatArrayXml->GetText();
-
-  std::unordered_map<ignition::math::Vector3d,
-      unsigned int, Vector3Hash> unique;
 
-  std::vector<std::string>::iterator iter, end;
-  std::vector<std::string> strs = split(valueStr, " \t\r\n");
-  end = strs.end();
-  for (iter = strs.begin(); iter != end; iter += 3)
+  const std::vector<double> floats = ParseFloats(floatArrayXml->GetText(),
+      floatArrayXml->UnsignedAttribute("count"));
+  source->values.reserve(floats.size() / 3u);
+  for (std::size_t i = 0; i + 2u < floats.size(); i += 3u)
   {
-    ignition::math::Vector3d vec(math::parseFloat(*iter),
-        ignition::math::parseFloat(*(iter+1)),
-        ignition::math::parseFloat(*(iter+2)));
-
-    vec = _transform * vec;
-    _values.push_back(vec);
-
-    // create a map of duplicate indices
-    if (unique.find(vec) != unique.end())
-      _duplicates[_values.size()-1] = unique[vec];
-    else
-      unique[vec] = _values.size()-1;
+    source->values.push_back(_transform *
+        ignition::math::Vector3d(floats[i], floats[i+1], floats[i+2]));
   }
 
-  this->positionDuplicateMap[_id] = _duplicates;
-  this->positionIds[_id] = _values;
+  // create a map of duplicate indices
+  FindDuplicates(*source);
+
+  std::lock_guard<std::mutex> lock(this->decode.sourceMutex);
+  return this->positionIds.emplace(_id, source).first->second;
 }
 
 /////////////////////////////////////////////////
-void ColladaLoader::Implementation::LoadNormals(const std::string &_id,
-    const ignition::math::Matrix4d &_transform,
-    std::vector<ignition::math::Vector3d> &_values,
-    std::map<unsigned int, unsigned int> &_duplicates)
+Vector3SourcePtr ColladaLoader::Implementation::LoadNormals(
+    const std::string &_id, const ignition::math::Matrix4d &_transform)
 {
-  if (this->normalIds.find(_id) != this->normalIds.end())
   {
-    _values = this->normalIds[_id];
-    _duplicates = this->normalDuplicateMap[_id];
-    return;
+    std::lock_guard<std::mutex> lock(this->decode.sourceMutex);
+    auto cached = this->normalIds.find(_id);
+    if (cached != this->normalIds.end())
+      return cached->second;
   }
 
   ignition::math::Matrix4d rotMat = _transform;
   rotMat.SetTranslation(ignition::math::Vector3d::Zero);
 
+  auto source = std::make_shared<Vector3Source>();
   tinyxml2::XMLElement *normalsXml = this->ElementId("source", _id);
   if (!normalsXml)
   {
     ignerr << "Unable to find normals[" << _id << "] in collada file\n";
-    return;
+    return source;
   }
 
   tinyxml2::XMLElement *floatArrayXml =
@@ -1556,48 +1976,39 @@ void ColladaLoader::Implementation::LoadNormals(const std::string &_id,
         << "This is likely not desired\n";
     }
 
-    return;
+    return source;
   }
 
-  std::unordered_map<ignition::math::Vector3d,
-      unsigned int, Vector3Hash> unique;
-
-  std::string valueStr = floatArrayXml->GetText();
-  std::istringstream iss(valueStr);
-  do
+  const std::vector<double> floats = ParseFloats(floatArrayXml->GetText(),
+      floatArrayXml->UnsignedAttribute("count"));
+  source->values.reserve(floats.size() / 3u);
+  for (std::size_t i = 0; i + 2u < floats.size(); i += 3u)
   {
-    ignition::math::Vector3d vec;
-    iss >> vec.X() >> vec.Y() >> vec.Z();
-    if (iss)
-    {
-      vec = rotMat * vec;
-      vec.Normalize();
-      _values.push_back(vec);
+    ignition::math::Vector3d vec = rotMat *
+        ignition::math::Vector3d(floats[i], floats[i+1], floats[i+2]);
+    vec.Normalize();
+    source->values.push_back(vec);
+  }
 
-      // create a map of duplicate indices
-      if (unique.find(vec) != unique.end())
-        _duplicates[_values.size()-1] = unique[vec];
-      else
-        unique[vec] = _values.size()-1;
-    }
-  } while (iss);
+  // create a map of duplicate indices
+  FindDuplicates(*source);
 
-  this->normalDuplicateMap[_id] = _duplicates;
-  this->normalIds[_id] = _values;
+  std::lock_guard<std::mutex> lock(this->decode.sourceMutex);
+  return this->normalIds.emplace(_id, source).first->second;
 }
 
 /////////////////////////////////////////////////
-void ColladaLoader::Implementation::LoadTexCoords(const std::string &_id,
-    std::vector<ignition::math::Vector2d> &_values,
-    std::map<unsigned int, unsigned int> &_duplicates)
+Vector2SourcePtr ColladaLoader::Implementation::LoadTexCoords(
+    const std::string &_id)
 {
-  if (this->texcoordIds.find(_id) != this->texcoordIds.end())
   {
-    _values = this->texcoordIds[_id];
-    _duplicates = this->texcoordDuplicateMap[_id];
-    return;
+    std::lock_guard<std::mutex> lock(this->decode.sourceMutex);
+    auto cached = this->texcoordIds.find(_id);
+    if (cached != this->texcoordIds.end())
+      return cached->second;
   }
 
+  auto source = std::make_shared<Vector2Source>();
   int stride = 0;
   int texCount = 0;
   int totCount = 0;
@@ -1607,7 +2018,7 @@ void ColladaLoader::Implementation::LoadTexCoords(const std::string &_id,
   if (!xml)
   {
     ignerr << "Unable to find tex coords[" << _id << "] in collada file\n";
-    return;
+    return source;
   }
 
   // Get the array of float values. These are the raw values for the texture
@@ -1639,7 +2050,7 @@ void ColladaLoader::Implementation::LoadTexCoords(const std::string &_id,
         << "This is likely not desired\n";
     }
 
-    return;
+    return source;
   }
   // Read in the total number of texture coordinate values
   else if (floatArrayXml->Attribute("count"))
@@ -1648,7 +2059,7 @@ void ColladaLoader::Implementation::LoadTexCoords(const std::string &_id,
   {
     ignerr << "<float_array> has no count attribute in texture coordinate "
           << "element with id[" << _id << "]\n";
-    return;
+    return source;
   }
 
   // The technique_common holds an <accessor> element that indicates how to
@@ -1658,7 +2069,7 @@ void ColladaLoader::Implementation::LoadTexCoords(const std::string &_id,
   {
     ignerr << "Unable to find technique_common element for texture "
           << "coordinates with id[" << _id << "]\n";
-    return;
+    return source;
   }
 
   // Get the accessor XML element.
@@ -1667,7 +2078,7 @@ void ColladaLoader::Implementation::LoadTexCoords(const std::string &_id,
   {
     ignerr << "Unable to find <accessor> as a child of <technique_common> "
           << "for texture coordinates with id[" << _id << "]\n";
-    return;
+    return source;
   }
 
   // Read in the stride for the texture coordinate values. The stride
@@ -1681,7 +2092,7 @@ void ColladaLoader::Implementation::LoadTexCoords(const std::string &_id,
   {
     ignerr << "<accessor> has no stride attribute in texture coordinate "
           << "element with id[" << _id << "]\n";
-    return;
+    return source;
   }
 
   // Read in the count of texture coordinates.
@@ -1691,7 +2102,7 @@ void ColladaLoader::Implementation::LoadTexCoords(const std::string &_id,
   {
     ignerr << "<accessor> has no count attribute in texture coordinate element "
           << "with id[" << _id << "]\n";
-    return;
+    return source;
   }
 
   // \TODO This is a good a IGN_ASSERT
@@ -1701,40 +2112,33 @@ void ColladaLoader::Implementation::LoadTexCoords(const std::string &_id,
   {
     ignerr << "Error reading texture coordinates. Coordinate counts in element "
              "with id[" << _id << "] do not add up correctly\n";
-    return;
+    return source;
   }
 
   // Nothing to read. Don't print a warning because the collada file is
   // correct.
   if (totCount == 0)
-    return;
-
-  std::unordered_map<ignition::math::Vector2d,
-      unsigned int, Vector2dHash> unique;
+    return source;
 
-  // Read the raw texture values, and split them on spaces.
-  std::string valueStr = floatArrayXml->GetText();
-  std::vector<std::string> values = split(valueStr, " \t\r\n");
+  // Read the raw texture values
+  const std::vector<double> values = ParseFloats(floatArrayXml->GetText(),
+      static_cast<std::size_t>(totCount));
 
   // Read in all the texture coordinates.
-  for (int i = 0; i < totCount; i += stride)
+  source->values.reserve(texCount);
+  for (int i = 0; i < totCount &&
+      static_cast<std::size_t>(i) + 1u < values.size(); i += stride)
   {
     // We only handle 2D texture coordinates right now.
-    ignition::math::Vector2d vec(std::stod(values[i]),
-          1.0 - std::stod(values[i+1]));
-    _values.push_back(vec);
-
-    // create a map of duplicate indices
-    if (unique.find(vec) != unique.end())
-    {
-      _duplicates[_values.size()-1] = unique[vec];
-    }
-    else
-      unique[vec] = _values.size()-1;
+    source->values.push_back(
+        ignition::math::Vector2d(values[i], 1.0 - values[i+1]));
   }
 
-  this->texcoordDuplicateMap[_id] = _duplicates;
-  this->texcoordIds[_id] = _values;
+  // create a map of duplicate indices
+  FindDuplicates(*source);
+
+  std::lock_guard<std::mutex> lock(this->decode.sourceMutex);
+  return this->texcoordIds.emplace(_id, source).first->second;
 }
 
 /////////////////////////////////////////////////
@@ -1960,46 +2364,20 @@ void ColladaLoader::Implementation::LoadColorOrTexture(
 void ColladaLoader::Implementation::LoadPolylist(
     tinyxml2::XMLElement *_polylistXml,
     const ignition::math::Matrix4d &_transform,
-    Mesh *_mesh)
+    const Mesh *_mesh, SubMesh &_subMesh)
 {
   // This function parses polylist types in collada into
   // a set of triangle meshes.  The assumption is that
   // each polylist polygon is convex, and we do decomposion
   // by anchoring each triangle about vertex 0 or each polygon
-  std::unique_ptr<SubMesh> subMesh(new SubMesh);
-  subMesh->SetName(this->currentNodeName);
   bool combinedVertNorms = false;
 
-  subMesh->SetPrimitiveType(SubMesh::TRIANGLES);
-
-  if (_polylistXml->Attribute("material"))
-  {
-    std::map<std::string, std::string>::iterator iter;
-    std::string matStr = _polylistXml->Attribute("material");
-
-    int matIndex = -1;
-    iter = this->materialMap.find(matStr);
-    if (iter != this->materialMap.end())
-      matStr = iter->second;
-
-    MaterialPtr mat = this->LoadMaterial(matStr);
-
-    matIndex = _mesh->IndexOfMaterial(mat.get());
-    if (matIndex < 0)
-      matIndex = _mesh->AddMaterial(mat);
-
-    if (matIndex < 0)
-      ignwarn << "Unable to add material[" << matStr << "]\n";
-    else
-      subMesh->SetMaterialIndex(matIndex);
-  }
-
   tinyxml2::XMLElement *polylistInputXml =
       _polylistXml->FirstChildElement("input");
 
-  std::vector<ignition::math::Vector3d> verts;
-  std::vector<ignition::math::Vector3d> norms;
-  std::map<unsigned int, std::vector<ignition::math::Vector2d>> texcoords;
+  Vector3SourcePtr verts = std::make_shared<Vector3Source>();
+  Vector3SourcePtr norms = std::make_shared<Vector3Source>();
+  std::map<unsigned int, Vector2SourcePtr> texcoords;
   std::vector<std::pair<unsigned int, unsigned int>> texcoordsOffsetToSet;
 
   const unsigned int VERTEX = 0;
@@ -2007,12 +2385,6 @@ void ColladaLoader::Implementation::LoadPolylist(
   const unsigned int TEXCOORD = 2;
   unsigned int otherSemantics = TEXCOORD + 1;
 
-  // look up table of position/normal/texcoord duplicate indices
-  std::unordered_map<unsigned int, std::map<unsigned int, unsigned int>>
-      texDupMap;
-  std::map<unsigned int, unsigned int> normalDupMap;
-  std::map<unsigned int, unsigned int> positionDupMap;
-
   ignition::math::Matrix4d bindShapeMat(ignition::math::Matrix4d::Identity);
   if (_mesh->HasSkeleton())
     bindShapeMat = _mesh->MeshSkeleton()->BindShapeTransform();
@@ -2028,16 +2400,18 @@ void ColladaLoader::Implementation::LoadPolylist(
     std::string offset = polylistInputXml->Attribute("offset");
     if (semantic == "VERTEX")
     {
-      unsigned int count = norms.size();
-      this->LoadVertices(source, _transform, verts, norms,
-          positionDupMap, normalDupMap);
-      if (norms.size() > count)
+      Vector3SourcePtr vertNorms;
+      this->LoadVertices(source, _transform, verts, vertNorms);
+      if (vertNorms && !vertNorms->values.empty())
+      {
+        norms = vertNorms;
         combinedVertNorms = true;
+      }
       inputs[VERTEX].insert(ignition::math::parseInt(offset));
     }
     else if (semantic == "NORMAL")
     {
-      this->LoadNormals(source, _transform, norms, normalDupMap);
+      norms = this->LoadNormals(source, _transform);
       combinedVertNorms = false;
       inputs[NORMAL].insert(ignition::math::parseInt(offset));
     }
@@ -2048,7 +2422,7 @@ void ColladaLoader::Implementation::LoadPolylist(
       auto setStr = polylistInputXml->Attribute("set");
       if (setStr)
         set = ignition::math::parseInt(setStr);
-      this->LoadTexCoords(source, texcoords[set], texDupMap[set]);
+      texcoords[set] = this->LoadTexCoords(source);
       inputs[TEXCOORD].insert(offsetInt);
       texcoordsOffsetToSet.push_back(std::make_pair(offsetInt, set));
     }
@@ -2070,29 +2444,33 @@ void ColladaLoader::Implementation::LoadPolylist(
   // if vcount >= 4, anchor around 0 (note this is bad for concave elements)
   //   e.g. if vcount = 4, break into triangle 1: [0,1,2], triangle 2: [0,2,3]
   tinyxml2::XMLElement *vcountXml = _polylistXml->FirstChildElement("vcount");
-  std::string vcountStr = vcountXml->GetText();
-  std::vector<std::string> vcountStrs = split(vcountStr, " \t\r\n");
-  std::vector<int> vcounts;
-  for (unsigned int j = 0; j < vcountStrs.size(); ++j)
-    vcounts.push_back(math::parseInt(vcountStrs[j]));
+  std::vector<unsigned int> vcounts = ParseIndices(vcountXml->GetText());
 
   // read p
   tinyxml2::XMLElement *pXml = _polylistXml->FirstChildElement("p");
-  std::string pStr = pXml->GetText();
+  std::vector<unsigned int> p = ParseIndices(pXml->GetText());
 
-  // vertexIndexMap is a map of collada vertex index to Gazebo submesh vertex
-  // indices, used for identifying vertices that can be shared.
-  std::map<unsigned int, std::vector<GeometryIndices> > vertexIndexMap;
-  unsigned int *values = new unsigned int[inputSize];
-  memset(values, 0, inputSize);
+  // vertexIndexMap holds, for each collada vertex index, the Gazebo submesh
+  // vertex last added for it, used for identifying vertices that can be
+  // shared.
+  std::vector<GeometryIndices> vertexIndexMap(verts->values.size());
+  std::vector<bool> vertexIndexAdded(verts->values.size(), false);
+  std::vector<unsigned int> values(inputSize, 0u);
 
-  std::vector<std::string> strs = split(pStr, " \t\r\n");
-  std::vector<std::string>::iterator strs_iter = strs.begin();
+  std::size_t polygonStart = 0;
   for (unsigned int l = 0; l < vcounts.size(); ++l)
   {
     // put us at the beginning of the polygon list
     if (l > 0)
-      strs_iter += inputSize * vcounts[l-1];
+      polygonStart += static_cast<std::size_t>(inputSize) * vcounts[l-1];
+    if (polygonStart + static_cast<std::size_t>(inputSize) * vcounts[l] >
+        p.size())
+    {
+      ignerr << "Collada file[" << this->filename
+        << "] has a polylist with fewer indices than its vcount. "
+        << "Loading what we can...\n";
+      break;
+    }
 
     for (unsigned int k = 2; k < static_cast<unsigned int>(vcounts[l]); ++k)
     {
@@ -2112,9 +2490,7 @@ void ColladaLoader::Implementation::LoadPolylist(
           triangle_index = (k)*inputSize;
 
         for (unsigned int i = 0; i < inputSize; ++i)
-        {
-          values[i] = ignition::math::parseInt(strs_iter[triangle_index+i]);
-        }
+          values[i] = p[polygonStart + triangle_index + i];
 
         unsigned int daeVertIndex = 0;
         bool addIndex = inputs[VERTEX].empty();
@@ -2125,12 +2501,10 @@ void ColladaLoader::Implementation::LoadPolylist(
         {
           // Get the vertex position index value. If it is a duplicate then use
           // the existing index instead
-          daeVertIndex = values[*inputs[VERTEX].begin()];
-          if (positionDupMap.find(daeVertIndex) != positionDupMap.end())
-            daeVertIndex = positionDupMap[daeVertIndex];
+          daeVertIndex = verts->First(values[*inputs[VERTEX].begin()]);
 
           // if the vertex index has not been previously added then just add it.
-          if (vertexIndexMap.find(daeVertIndex) == vertexIndexMap.end())
+          if (!vertexIndexAdded[daeVertIndex])
           {
             addIndex = true;
           }
@@ -2138,72 +2512,55 @@ void ColladaLoader::Implementation::LoadPolylist(
           {
             // if the vertex index was previously added, check to see if it has
             // the same normal and texcoord index values
-            bool toDuplicate = true;
-            unsigned int reuseIndex = 0;
-            std::vector<GeometryIndices> inputValues =
-                vertexIndexMap[daeVertIndex];
+            GeometryIndices &iv = vertexIndexMap[daeVertIndex];
+            bool normEqual = false;
+            bool texEqual = false;
 
-            for (unsigned int i = 0; i < inputValues.size(); ++i)
+            if (!inputs[NORMAL].empty())
             {
-              GeometryIndices iv = inputValues[i];
-              bool normEqual = false;
-              bool texEqual = false;
+              // Get the vertex normal index value. If the normal is a
+              // duplicate then reset the index to the first instance of the
+              // duplicated position
+              unsigned int remappedNormalIndex =
+                norms->First(values[*inputs[NORMAL].begin()]);
 
-              if (!inputs[NORMAL].empty())
-              {
-                // Get the vertex normal index value. If the normal is a
-                // duplicate then reset the index to the first instance of the
-                // duplicated position
-                unsigned int remappedNormalIndex =
-                  values[*inputs[NORMAL].begin()];
-                if (normalDupMap.find(remappedNormalIndex)
-                    != normalDupMap.end())
-                 {
-                  remappedNormalIndex = normalDupMap[remappedNormalIndex];
-                 }
-
-                if (iv.normalIndex == remappedNormalIndex)
-                  normEqual = true;
-              }
+              if (iv.normalIndex == remappedNormalIndex)
+                normEqual = true;
+            }
 
-              if (!inputs[TEXCOORD].empty())
+            if (!inputs[TEXCOORD].empty())
+            {
+              texEqual = true;
+              for (auto &pair : texcoordsOffsetToSet)
               {
-                texEqual = true;
-                for (auto &pair : texcoordsOffsetToSet)
+                unsigned int offset = pair.first;
+                unsigned int set = pair.second;
+                // Get the vertex texcoord index value. If the texcoord is a
+                // duplicate then reset the index to the first instance of the
+                // duplicated texcoord
+                unsigned int remappedTexcoordIndex =
+                  texcoords[set]->First(values[offset]);
+                if (iv.texcoordIndex[set] != remappedTexcoordIndex)
                 {
-                  unsigned int offset = pair.first;
-                  unsigned int set = pair.second;
-                  // Get the vertex texcoord index value. If the texcoord is a
-                  // duplicate then reset the index to the first instance of the
-                  // duplicated texcoord
-                  unsigned int remappedTexcoordIndex =
-                    values[offset];
-                  auto &texDupMapSet = texDupMap[set];
-                  auto texDupMapSetIt = texDupMapSet.find(
-                      remappedTexcoordIndex);
-                  if (texDupMapSetIt != texDupMapSet.end())
-                    remappedTexcoordIndex = texDupMapSetIt->second;
-                  if (iv.texcoordIndex[set] != remappedTexcoordIndex)
-                  {
-                    texEqual = false;
-                    break;
-                  }
+                  texEqual = false;
+                  break;
                 }
               }
+            }
 
-              // if the vertex has matching normal and texcoord index values
-              // then the vertex can be reused.
-              if ((inputs[NORMAL].empty() || normEqual) &&
-                  (inputs[TEXCOORD].empty() || texEqual))
-              {
-                // found a vertex that can be shared.
-                toDuplicate = false;
-                reuseIndex = iv.mappedIndex;
-                subMesh->AddIndex(reuseIndex);
-                break;
-              }
+            // if the vertex has matching normal and texcoord index values
+            // then the vertex can be reused.
+            if ((inputs[NORMAL].empty() || normEqual) &&
+                (inputs[TEXCOORD].empty() || texEqual))
+            {
+              // found a vertex that can be shared.
+              _subMesh.AddIndex(iv.mappedIndex);
+              addIndex = false;
+            }
+            else
+            {
+              addIndex = true;
             }
-            addIndex = toDuplicate;
           }
         }
 
@@ -2213,15 +2570,15 @@ void ColladaLoader::Implementation::LoadPolylist(
           GeometryIndices input;
           if (!inputs[VERTEX].empty())
           {
-            subMesh->AddVertex(verts[daeVertIndex]);
-            unsigned int newVertIndex = subMesh->VertexCount()-1;
-            subMesh->AddIndex(newVertIndex);
+            _subMesh.AddVertex(verts->values[daeVertIndex]);
+            unsigned int newVertIndex = _subMesh.VertexCount()-1;
+            _subMesh.AddIndex(newVertIndex);
             if (combinedVertNorms)
-              subMesh->AddNormal(norms[daeVertIndex]);
+              _subMesh.AddNormal(norms->values[daeVertIndex]);
             if (_mesh->HasSkeleton())
             {
-              subMesh->SetVertex(newVertIndex, bindShapeMat *
-                  subMesh->Vertex(newVertIndex));
+              _subMesh.SetVertex(newVertIndex, bindShapeMat *
+                  _subMesh.Vertex(newVertIndex));
               SkeletonPtr skel = _mesh->MeshSkeleton();
               for (unsigned int i = 0;
                   i < skel->VertNodeWeightCount(daeVertIndex); ++i)
@@ -2230,7 +2587,7 @@ void ColladaLoader::Implementation::LoadPolylist(
                   skel->VertNodeWeight(daeVertIndex, i);
                 SkeletonNode *node =
                     _mesh->MeshSkeleton()->NodeByName(node_weight.first);
-                subMesh->AddNodeAssignment(subMesh->VertexCount()-1,
+                _subMesh.AddNodeAssignment(_subMesh.VertexCount()-1,
                                 node->Handle(), node_weight.second);
               }
             }
@@ -2240,15 +2597,9 @@ void ColladaLoader::Implementation::LoadPolylist(
           if (!inputs[NORMAL].empty())
           {
             unsigned int inputRemappedNormalIndex =
-              values[*inputs[NORMAL].begin()];
+              norms->First(values[*inputs[NORMAL].begin()]);
 
-            if (normalDupMap.find(inputRemappedNormalIndex)
-                != normalDupMap.end())
-            {
-              inputRemappedNormalIndex = normalDupMap[inputRemappedNormalIndex];
-            }
-
-            subMesh->AddNormal(norms[inputRemappedNormalIndex]);
+            _subMesh.AddNormal(norms->values[inputRemappedNormalIndex]);
             input.normalIndex = inputRemappedNormalIndex;
           }
 
@@ -2259,18 +2610,13 @@ void ColladaLoader::Implementation::LoadPolylist(
               unsigned int offset = pair.first;
               unsigned int set = pair.second;
 
+              const Vector2Source &texcoordsSet = *texcoords[set];
               unsigned int inputRemappedTexcoordIndex =
-                values[offset];
-
-              auto &texDupMapSet = texDupMap[set];
-              auto texDupMapSetIt = texDupMapSet.find(
-                  inputRemappedTexcoordIndex);
-              if (texDupMapSetIt != texDupMapSet.end())
-                inputRemappedTexcoordIndex = texDupMapSetIt->second;
-              auto &texcoordsSet = texcoords[set];
-              subMesh->AddTexCoordBySet(
-                  texcoordsSet[inputRemappedTexcoordIndex].X(),
-                  texcoordsSet[inputRemappedTexcoordIndex].Y(), set);
+                texcoordsSet.First(values[offset]);
+
+              _subMesh.AddTexCoordBySet(
+                  texcoordsSet.values[inputRemappedTexcoordIndex].X(),
+                  texcoordsSet.values[inputRemappedTexcoordIndex].Y(), set);
               input.texcoordIndex[set] = inputRemappedTexcoordIndex;
             }
           }
@@ -2278,57 +2624,29 @@ void ColladaLoader::Implementation::LoadPolylist(
           // add the new ignition submesh vertex index to the map
           if (!inputs[VERTEX].empty())
           {
-            std::vector<GeometryIndices> inputValues;
-            inputValues.push_back(input);
-            vertexIndexMap[daeVertIndex] = inputValues;
+            vertexIndexMap[daeVertIndex] = std::move(input);
+            vertexIndexAdded[daeVertIndex] = true;
           }
         }
       }
     }
   }
-  delete [] values;
-
-  _mesh->AddSubMesh(std::move(subMesh));
 }
 
 /////////////////////////////////////////////////
-void ColladaLoader::Implementation::LoadTriangles(
+bool ColladaLoader::Implementation::LoadTriangles(
     tinyxml2::XMLElement *_trianglesXml,
-    const ignition::math::Matrix4d &_transform, Mesh *_mesh)
+    const ignition::math::Matrix4d &_transform, const Mesh *_mesh,
+    SubMesh &_subMesh)
 {
-  std::unique_ptr<SubMesh> subMesh(new SubMesh);
-  subMesh->SetName(this->currentNodeName);
   bool combinedVertNorms = false;
 
-  subMesh->SetPrimitiveType(SubMesh::TRIANGLES);
-
-  if (_trianglesXml->Attribute("material"))
-  {
-    std::map<std::string, std::string>::iterator iter;
-    std::string matStr = _trianglesXml->Attribute("material");
-
-    int matIndex = -1;
-    iter = this->materialMap.find(matStr);
-    if (iter != this->materialMap.end())
-      matStr = iter->second;
-
-    MaterialPtr mat = this->LoadMaterial(matStr);
-    matIndex = _mesh->IndexOfMaterial(mat.get());
-    if (matIndex < 0)
-      matIndex = _mesh->AddMaterial(mat);
-
-    if (matIndex < 0)
-      ignwarn << "Unable to add material[" << matStr << "]\n";
-    else
-      subMesh->SetMaterialIndex(matIndex);
-  }
-
   tinyxml2::XMLElement *trianglesInputXml =
       _trianglesXml->FirstChildElement("input");
 
-  std::vector<ignition::math::Vector3d> verts;
-  std::vector<ignition::math::Vector3d> norms;
-  std::map<unsigned int, std::vector<ignition::math::Vector2d>> texcoords;
+  Vector3SourcePtr verts = std::make_shared<Vector3Source>();
+  Vector3SourcePtr norms = std::make_shared<Vector3Source>();
+  std::map<unsigned int, Vector2SourcePtr> texcoords;
   std::vector<std::pair<unsigned int, unsigned int>> texcoordsOffsetToSet;
 
   const unsigned int VERTEX = 0;
@@ -2344,12 +2662,6 @@ void ColladaLoader::Implementation::LoadTriangles(
   // multiple TEXCOORD inputs.
   std::map<const unsigned int, std::set<int>> inputs;
 
-  // look up table of position/normal/texcoord duplicate indices
-  std::unordered_map<unsigned int, std::map<unsigned int, unsigned int>>
-      texDupMap;
-  std::map<unsigned int, unsigned int> normalDupMap;
-  std::map<unsigned int, unsigned int> positionDupMap;
-
   while (trianglesInputXml)
   {
     std::string semantic = trianglesInputXml->Attribute("semantic");
@@ -2357,17 +2669,19 @@ void ColladaLoader::Implementation::LoadTriangles(
     std::string offset = trianglesInputXml->Attribute("offset");
     if (semantic == "VERTEX")
     {
-      unsigned int count = norms.size();
-      this->LoadVertices(source, _transform, verts, norms,
-          positionDupMap, normalDupMap);
-      if (norms.size() > count)
+      Vector3SourcePtr vertNorms;
+      this->LoadVertices(source, _transform, verts, vertNorms);
+      if (vertNorms && !vertNorms->values.empty())
+      {
+        norms = vertNorms;
         combinedVertNorms = true;
+      }
       inputs[VERTEX].insert(ignition::math::parseInt(offset));
       hasVertices = true;
     }
     else if (semantic == "NORMAL")
     {
-      this->LoadNormals(source, _transform, norms, normalDupMap);
+      norms = this->LoadNormals(source, _transform);
       combinedVertNorms = false;
       inputs[NORMAL].insert(ignition::math::parseInt(offset));
       hasNormals = true;
@@ -2379,7 +2693,7 @@ void ColladaLoader::Implementation::LoadTriangles(
       auto setStr = trianglesInputXml->Attribute("set");
       if (setStr)
         set = ignition::math::parseInt(setStr);
-      this->LoadTexCoords(source, texcoords[set], texDupMap[set]);
+      texcoords[set] = this->LoadTexCoords(source);
       inputs[TEXCOORD].insert(offsetInt);
       texcoordsOffsetToSet.push_back(std::make_pair(offsetInt, set));
       hasTexcoords = true;
@@ -2425,9 +2739,9 @@ void ColladaLoader::Implementation::LoadTriangles(
         << "This is likely not desired\n";
     }
 
-    return;
+    return false;
   }
-  std::string pStr = pXml->GetText();
+  std::vector<unsigned int> p = ParseIndices(pXml->GetText());
 
   // Collada format allows normals and texcoords to have their own set of
   // indices for more efficient storage of data but opengl only supports one
@@ -2435,17 +2749,21 @@ void ColladaLoader::Implementation::LoadTriangles(
   // index and duplicate any vertices that have the same index but different
   // normal/texcoord.
 
-  // vertexIndexMap is a map of collada vertex index to Gazebo submesh vertex
-  // indices, used for identifying vertices that can be shared.
-  std::map<unsigned int, std::vector<GeometryIndices> > vertexIndexMap;
+  // vertexIndexMap holds, for each collada vertex index, the Gazebo submesh
+  // vertex last added for it, used for identifying vertices that can be
+  // shared.
+  std::vector<GeometryIndices> vertexIndexMap(verts->values.size());
+  std::vector<bool> vertexIndexAdded(verts->values.size(), false);
 
   std::vector<unsigned int> values(offsetSize);
-  std::vector<std::string> strs = split(pStr, " \t\r\n");
+  if (offsetSize > 0u)
+    _subMesh.Reserve(0u, static_cast<unsigned int>(p.size() / offsetSize));
 
-  for (unsigned int j = 0; j < strs.size(); j += offsetSize)
+  for (std::size_t j = 0; offsetSize > 0u && j + offsetSize <= p.size();
+      j += offsetSize)
   {
     for (unsigned int i = 0; i < offsetSize; ++i)
-      values.at(i) = ignition::math::parseInt(strs[j+i]);
+      values.at(i) = p[j+i];
 
     unsigned int daeVertIndex = 0;
     bool addIndex = !hasVertices;
@@ -2456,12 +2774,10 @@ void ColladaLoader::Implementation::LoadTriangles(
     {
       // Get the vertex position index value. If the position is a duplicate
       // then reset the index to the first instance of the duplicated position
-      daeVertIndex = values.at(*inputs[VERTEX].begin());
-      if (positionDupMap.find(daeVertIndex) != positionDupMap.end())
-        daeVertIndex = positionDupMap[daeVertIndex];
+      daeVertIndex = verts->First(values.at(*inputs[VERTEX].begin()));
 
       // if the vertex index has not been previously added then just add it.
-      if (vertexIndexMap.find(daeVertIndex) == vertexIndexMap.end())
+      if (!vertexIndexAdded[daeVertIndex])
       {
         addIndex = true;
       }
@@ -2469,66 +2785,54 @@ void ColladaLoader::Implementation::LoadTriangles(
       {
         // if the vertex index was previously added, check to see if it has the
         // same normal and texcoord index values
-        bool toDuplicate = true;
-        unsigned int reuseIndex = 0;
-        std::vector<GeometryIndices> inputValues = vertexIndexMap[daeVertIndex];
-
-        for (unsigned int i = 0; i < inputValues.size(); ++i)
+        GeometryIndices &iv = vertexIndexMap[daeVertIndex];
+        bool normEqual = false;
+        bool texEqual = false;
+        if (hasNormals)
         {
-          GeometryIndices iv = inputValues[i];
-          bool normEqual = false;
-          bool texEqual = false;
-          if (hasNormals)
-          {
-            // Get the vertex normal index value. If the normal is a duplicate
-            // then reset the index to the first instance of the duplicated
-            // position
-            unsigned int remappedNormalIndex = values.at(
-                *inputs[NORMAL].begin());
-            if (normalDupMap.find(remappedNormalIndex) != normalDupMap.end())
-              remappedNormalIndex = normalDupMap[remappedNormalIndex];
-
-            if (iv.normalIndex == remappedNormalIndex)
-              normEqual = true;
-          }
-          if (hasTexcoords)
+          // Get the vertex normal index value. If the normal is a duplicate
+          // then reset the index to the first instance of the duplicated
+          // position
+          unsigned int remappedNormalIndex = norms->First(values.at(
+              *inputs[NORMAL].begin()));
+
+          if (iv.normalIndex == remappedNormalIndex)
+            normEqual = true;
+        }
+        if (hasTexcoords)
+        {
+          texEqual = true;
+          for (auto &pair : texcoordsOffsetToSet)
           {
-            texEqual = true;
-            for (auto &pair : texcoordsOffsetToSet)
-            {
-              unsigned int offset = pair.first;
-              unsigned int set = pair.second;
+            unsigned int offset = pair.first;
+            unsigned int set = pair.second;
 
-              // Get the vertex texcoord index value. If the texcoord is a
-              // duplicate then reset the index to the first instance of the
-              // duplicated texcoord
-              unsigned int remappedTexcoordIndex =
-                  values.at(offset);
-              auto &texDupMapSet = texDupMap[set];
-              auto texDupMapSetIt = texDupMapSet.find(remappedTexcoordIndex);
-              if (texDupMapSetIt != texDupMapSet.end())
-                remappedTexcoordIndex = texDupMapSetIt->second;
-
-              if (iv.texcoordIndex[set] != remappedTexcoordIndex)
-              {
-                texEqual = false;
-                break;
-              }
+            // Get the vertex texcoord index value. If the texcoord is a
+            // duplicate then reset the index to the first instance of the
+            // duplicated texcoord
+            unsigned int remappedTexcoordIndex =
+                texcoords[set]->First(values.at(offset));
+
+            if (iv.texcoordIndex[set] != remappedTexcoordIndex)
+            {
+              texEqual = false;
+              break;
             }
           }
+        }
 
-          // if the vertex has matching normal and texcoord index values then
-          // the vertex can be reused.
-          if ((!hasNormals || normEqual) && (!hasTexcoords || texEqual))
-          {
-            // found a vertex that can be shared.
-            toDuplicate = false;
-            reuseIndex = iv.mappedIndex;
-            subMesh->AddIndex(reuseIndex);
-            break;
-          }
+        // if the vertex has matching normal and texcoord index values then
+        // the vertex can be reused.
+        if ((!hasNormals || normEqual) && (!hasTexcoords || texEqual))
+        {
+          // found a vertex that can be shared.
+          _subMesh.AddIndex(iv.mappedIndex);
+          addIndex = false;
+        }
+        else
+        {
+          addIndex = true;
         }
-        addIndex = toDuplicate;
       }
     }
 
@@ -2538,12 +2842,12 @@ void ColladaLoader::Implementation::LoadTriangles(
       GeometryIndices input;
       if (hasVertices)
       {
-        subMesh->AddVertex(verts[daeVertIndex]);
-        unsigned int newVertIndex = subMesh->VertexCount()-1;
-        subMesh->AddIndex(newVertIndex);
+        _subMesh.AddVertex(verts->values[daeVertIndex]);
+        unsigned int newVertIndex = _subMesh.VertexCount()-1;
+        _subMesh.AddIndex(newVertIndex);
 
         if (combinedVertNorms)
-          subMesh->AddNormal(norms[daeVertIndex]);
+          _subMesh.AddNormal(norms->values[daeVertIndex]);
         if (_mesh->HasSkeleton())
         {
           SkeletonPtr skel = _mesh->MeshSkeleton();
@@ -2560,7 +2864,7 @@ void ColladaLoader::Implementation::LoadTriangles(
                      << node_weight.first << "]" << std::endl;
               continue;
             }
-            subMesh->AddNodeAssignment(subMesh->VertexCount()-1,
+            _subMesh.AddNodeAssignment(_subMesh.VertexCount()-1,
                             node->Handle(), node_weight.second);
           }
         }
@@ -2569,11 +2873,9 @@ void ColladaLoader::Implementation::LoadTriangles(
       }
       if (hasNormals)
       {
-        unsigned int inputRemappedNormalIndex = values.at(
-            *inputs[NORMAL].begin());
-        if (normalDupMap.find(inputRemappedNormalIndex) != normalDupMap.end())
-          inputRemappedNormalIndex = normalDupMap[inputRemappedNormalIndex];
-        subMesh->AddNormal(norms[inputRemappedNormalIndex]);
+        unsigned int inputRemappedNormalIndex = norms->First(values.at(
+            *inputs[NORMAL].begin()));
+        _subMesh.AddNormal(norms->values[inputRemappedNormalIndex]);
         input.normalIndex = inputRemappedNormalIndex;
       }
       if (hasTexcoords)
@@ -2583,17 +2885,13 @@ void ColladaLoader::Implementation::LoadTriangles(
           unsigned int offset = pair.first;
           unsigned int set = pair.second;
 
+          const Vector2Source &texcoordsSet = *texcoords[set];
           unsigned int inputRemappedTexcoordIndex =
-              values.at(offset);
-
-          auto &texDupMapSet = texDupMap[set];
-          auto texDupMapSetIt = texDupMapSet.find(inputRemappedTexcoordIndex);
-          if (texDupMapSetIt != texDupMapSet.end())
-            inputRemappedTexcoordIndex = texDupMapSetIt->second;
-          auto &texcoordsSet = texcoords[set];
-          subMesh->AddTexCoordBySet(
-              texcoordsSet[inputRemappedTexcoordIndex].X(),
-              texcoordsSet[inputRemappedTexcoordIndex].Y(), set);
+              texcoordsSet.First(values.at(offset));
+
+          _subMesh.AddTexCoordBySet(
+              texcoordsSet.values[inputRemappedTexcoordIndex].X(),
+              texcoordsSet.values[inputRemappedTexcoordIndex].Y(), set);
           input.texcoordIndex[set] = inputRemappedTexcoordIndex;
         }
       }
@@ -2601,50 +2899,37 @@ void ColladaLoader::Implementation::LoadTriangles(
       // add the new ignition submesh vertex index to the map
       if (hasVertices)
       {
-        std::vector<GeometryIndices> inputValues;
-        inputValues.push_back(input);
-        vertexIndexMap[daeVertIndex] = inputValues;
+        vertexIndexMap[daeVertIndex] = std::move(input);
+        vertexIndexAdded[daeVertIndex] = true;
       }
     }
   }
 
-  _mesh->AddSubMesh(std::move(subMesh));
+  return true;
 }
 
 /////////////////////////////////////////////////
 void ColladaLoader::Implementation::LoadLines(tinyxml2::XMLElement *_xml,
-    const ignition::math::Matrix4d &_transform, Mesh *_mesh)
+    const ignition::math::Matrix4d &_transform, SubMesh &_subMesh)
 {
-  std::unique_ptr<SubMesh> subMesh(new SubMesh);
-  subMesh->SetName(this->currentNodeName);
-  subMesh->SetPrimitiveType(SubMesh::LINES);
-
   tinyxml2::XMLElement *inputXml = _xml->FirstChildElement("input");
   // std::string semantic = inputXml->Attribute("semantic");
   std::string source = inputXml->Attribute("source");
 
-  std::vector<ignition::math::Vector3d> verts;
-  std::vector<ignition::math::Vector3d> norms;
+  Vector3SourcePtr verts = std::make_shared<Vector3Source>();
+  Vector3SourcePtr norms;
   this->LoadVertices(source, _transform, verts, norms);
 
   tinyxml2::XMLElement *pXml = _xml->FirstChildElement("p");
-  std::string pStr = pXml->GetText();
-  std::istringstream iss(pStr);
+  std::vector<unsigned int> p = ParseIndices(pXml->GetText());
 
-  do
+  for (std::size_t i = 0; i + 1u < p.size(); i += 2u)
   {
-    int a, b;
-    iss >> a >> b;
-
-    if (!iss)
-      break;
-    subMesh->AddVertex(verts[a]);
-    subMesh->AddIndex(subMesh->VertexCount() - 1);
-    subMesh->AddVertex(verts[b]);
-    subMesh->AddIndex(subMesh->VertexCount() - 1);
-  } while (iss);
-
-  _mesh->AddSubMesh(std::move(subMesh));
+    _subMesh.AddVertex(verts->values[p[i]]);
+    _subMesh.AddIndex(_subMesh.VertexCount() - 1);
+    _subMesh.AddVertex(verts->values[p[i+1]]);
+    _subMesh.AddIndex(_subMesh.VertexCount() - 1);
+  }
 }
 
 /////////////////////////////////////////////////
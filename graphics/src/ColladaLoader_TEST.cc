@@ -16,7 +16,12 @@
 */
 #include <gtest/gtest.h>
 
+#include <fstream>
+#include <memory>
+#include <string>
+
 #include "test_config.h"
+#include "ignition/common/Filesystem.hh"
 #include "ignition/common/Mesh.hh"
 #include "ignition/common/SubMesh.hh"
 #include "ignition/common/Material.hh"
@@ -488,6 +493,215 @@ TEST_F(ColladaLoader, LoadCylinderAnimatedFrom3dsMax)
   EXPECT_TRUE(anim->HasNode("Bone02"));
 }
 
+/////////////////////////////////////////////////
+TEST_F(ColladaLoader, ParseLists)
+{
+  const std::string path = common::testing::TempPath("collada_lists.dae");
+  ASSERT_TRUE(common::createDirectories(common::parentPath(path)));
+  {
+    // Lists separated by any whitespace, with duplicate positions and
+    // normals, shared by a triangle list and a polylist
+    std::ofstream out(path);
+    out << "<?xml version=\"1.0\"?>\n"
+        << "<COLLADA version=\"1.4.1\"><library_geometries>"
+        << "<geometry id=\"g\"><mesh>"
+        << "<source id=\"p\"><float_array id=\"pa\" count=\"15\">"
+        << "0 0 0\n\t1.5e0 0 0  -0 2 0\r\n0.0 -0.0 0.0 1 1 -0.25"
+        << "</float_array></source>"
+        << "<source id=\"n\"><float_array id=\"na\" count=\"6\">"
+        << "0 0 2 0 0 1.0</float_array></source>"
+        << "<vertices id=\"v\">"
+        << "<input semantic=\"POSITION\" source=\"#p\"/></vertices>"
+        << "<triangles count=\"2\">"
+        << "<input semantic=\"VERTEX\" source=\"#v\" offset=\"0\"/>"
+        << "<input semantic=\"NORMAL\" source=\"#n\" offset=\"1\"/>"
+        << "<p>0 0 1 0 2 0\n3 1 1 1 4 1</p></triangles>"
+        << "<polylist count=\"1\">"
+        << "<input semantic=\"VERTEX\" source=\"#v\" offset=\"0\"/>"
+        << "<input semantic=\"NORMAL\" source=\"#n\" offset=\"1\"/>"
+        << "<vcount>4</vcount><p>0 0 1 1 4 0 2 1</p></polylist>"
+        << "</mesh></geometry></library_geometries>"
+        << "<library_visual_scenes><visual_scene id=\"s\"><node id=\"n0\">"
+        << "<instance_geometry url=\"#g\"/></node></visual_scene>"
+        << "</library_visual_scenes>"
+        << "<scene><instance_visual_scene url=\"#s\"/></scene></COLLADA>";
+  }
+
+  common::ColladaLoader loader;
+  common::Mesh *mesh = loader.Load(path);
+  ASSERT_NE(nullptr, mesh);
+  ASSERT_EQ(2u, mesh->SubMeshCount());
+
+  // Position 3 duplicates position 0, and normal 1 duplicates normal 0
+  auto triangles = mesh->SubMeshByIndex(0).lock();
+  ASSERT_EQ(4u, triangles->VertexCount());
+  ASSERT_EQ(6u, triangles->IndexCount());
+  EXPECT_EQ(triangles->Index(0), triangles->Index(3));
+  EXPECT_EQ(triangles->Index(1), triangles->Index(4));
+  EXPECT_EQ(math::Vector3d(1.5, 0, 0), triangles->Vertex(1));
+  EXPECT_EQ(math::Vector3d(0, 2, 0), triangles->Vertex(2));
+  EXPECT_EQ(math::Vector3d(1, 1, -0.25), triangles->Vertex(3));
+  EXPECT_EQ(math::Vector3d::UnitZ, triangles->Normal(0));
+
+  // The quad is split into two triangles
+  auto polygons = mesh->SubMeshByIndex(1).lock();
+  EXPECT_EQ(4u, polygons->VertexCount());
+  ASSERT_EQ(6u, polygons->IndexCount());
+  EXPECT_EQ(polygons->Index(0), polygons->Index(3));
+  EXPECT_EQ(polygons->Index(2), polygons->Index(4));
+  EXPECT_EQ(math::Vector3d(0, 2, 0), polygons->Vertex(polygons->Index(5)));
+
+  delete mesh;
+  common::removeFile(path);
+}
+
+/////////////////////////////////////////////////
+/// \brief Expect two meshes to have exactly the same submeshes
+/// \param[in] _expected Mesh loaded serially
+/// \param[in] _actual Mesh loaded in parallel
+void ExpectSameMesh(const common::Mesh &_expected,
+    const common::Mesh &_actual)
+{
+  auto same3 = [](const math::Vector3d &_a, const math::Vector3d &_b)
+  {
+    return _a.X() == _b.X() && _a.Y() == _b.Y() && _a.Z() == _b.Z();
+  };
+
+  EXPECT_EQ(_expected.MaterialCount(), _actual.MaterialCount());
+  ASSERT_EQ(_expected.SubMeshCount(), _actual.SubMeshCount());
+  for (unsigned int i = 0; i < _expected.SubMeshCount(); ++i)
+  {
+    auto expected = _expected.SubMeshByIndex(i).lock();
+    auto actual = _actual.SubMeshByIndex(i).lock();
+    EXPECT_EQ(expected->Name(), actual->Name());
+    EXPECT_EQ(expected->SubMeshPrimitiveType(),
+        actual->SubMeshPrimitiveType());
+    EXPECT_EQ(expected->MaterialIndex(), actual->MaterialIndex());
+    ASSERT_EQ(expected->VertexCount(), actual->VertexCount());
+    ASSERT_EQ(expected->NormalCount(), actual->NormalCount());
+    ASSERT_EQ(expected->IndexCount(), actual->IndexCount());
+    ASSERT_EQ(expected->TexCoordSetCount(), actual->TexCoordSetCount());
+    ASSERT_EQ(expected->NodeAssignmentsCount(),
+        actual->NodeAssignmentsCount());
+    for (unsigned int v = 0; v < expected->VertexCount(); ++v)
+      EXPECT_TRUE(same3(expected->Vertex(v), actual->Vertex(v)));
+    for (unsigned int n = 0; n < expected->NormalCount(); ++n)
+      EXPECT_TRUE(same3(expected->Normal(n), actual->Normal(n)));
+    for (unsigned int n = 0; n < expected->IndexCount(); ++n)
+      EXPECT_EQ(expected->Index(n), actual->Index(n));
+    for (unsigned int set = 0; set < expected->TexCoordSetCount(); ++set)
+    {
+      ASSERT_EQ(expected->TexCoordCountBySet(set),
+          actual->TexCoordCountBySet(set));
+      for (unsigned int t = 0; t < expected->TexCoordCountBySet(set); ++t)
+      {
+        EXPECT_EQ(expected->TexCoordBySet(t, set).X(),
+            actual->TexCoordBySet(t, set).X());
+        EXPECT_EQ(expected->TexCoordBySet(t, set).Y(),
+            actual->TexCoordBySet(t, set).Y());
+      }
+    }
+    for (unsigned int n = 0; n < expected->NodeAssignmentsCount(); ++n)
+    {
+      const auto a = expected->NodeAssignmentByIndex(n);
+      const auto b = actual->NodeAssignmentByIndex(n);
+      EXPECT_EQ(a.vertexIndex, b.vertexIndex);
+      EXPECT_EQ(a.nodeIndex, b.nodeIndex);
+      EXPECT_EQ(a.weight, b.weight);
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+TEST_F(ColladaLoader, Parallel)
+{
+  // Many geometries. The last one is instanced twice with different
+  // transforms, and shares its sources between both instances.
+  const std::string path = common::testing::TempPath("collada_parallel.dae");
+  ASSERT_TRUE(common::createDirectories(common::parentPath(path)));
+  {
+    std::ofstream out(path);
+    out << "<?xml version=\"1.0\"?>\n"
+        << "<COLLADA version=\"1.4.1\"><library_geometries>";
+    const int geometries = 24;
+    for (int g = 0; g < geometries; ++g)
+    {
+      const std::string id = "g" + std::to_string(g);
+      out << "<geometry id=\"" << id << "\"><mesh>"
+          << "<source id=\"" << id << "p\"><float_array count=\"12\">"
+          << g << " 0 0 1 " << g << " 0 0 1 " << g << " 1 1 1"
+          << "</float_array></source>"
+          << "<source id=\"" << id << "n\"><float_array count=\"3\">"
+          << "0 0 1</float_array></source>"
+          << "<vertices id=\"" << id << "v\">"
+          << "<input semantic=\"POSITION\" source=\"#" << id << "p\"/>"
+          << "</vertices>";
+      if (g % 3 == 0)
+      {
+        out << "<lines count=\"2\">"
+            << "<input semantic=\"VERTEX\" source=\"#" << id << "v\"/>"
+            << "<p>0 1 2 3</p></lines>";
+      }
+      else if (g % 3 == 1)
+      {
+        out << "<polylist count=\"1\">"
+            << "<input semantic=\"VERTEX\" source=\"#" << id << "v\""
+            << " offset=\"0\"/>"
+            << "<input semantic=\"NORMAL\" source=\"#" << id << "n\""
+            << " offset=\"1\"/>"
+            << "<vcount>4</vcount><p>0 0 1 0 2 0 3 0</p></polylist>";
+      }
+      else
+      {
+        out << "<triangles count=\"2\">"
+            << "<input semantic=\"VERTEX\" source=\"#" << id << "v\""
+            << " offset=\"0\"/>"
+            << "<p>0 1 2 0 2 3</p></triangles>";
+      }
+      out << "</mesh></geometry>";
+    }
+    out << "</library_geometries><library_visual_scenes>"
+        << "<visual_scene id=\"s\">";
+    for (int g = 0; g < geometries; ++g)
+    {
+      out << "<node name=\"n" << g << "\">"
+          << "<translate>" << g << " 0 0</translate>"
+          << "<instance_geometry url=\"#g" << g << "\"/></node>";
+    }
+    out << "<node name=\"again\"><translate>0 5 0</translate>"
+        << "<instance_geometry url=\"#g" << geometries - 1 << "\"/></node>"
+        << "</visual_scene></library_visual_scenes>"
+        << "<scene><instance_visual_scene url=\"#s\"/></scene></COLLADA>";
+  }
+
+  // Skinned meshes are loaded in parallel up to the first controller
+  for (const std::string &file : {path,
+      common::testing::TestFile("data", "box.dae"),
+      common::testing::TestFile("data", "box_with_multiple_geoms.dae"),
+      common::testing::TestFile("data", "box_with_hierarchical_nodes.dae"),
+      common::testing::TestFile("data", "box_multiple_inst_controllers.dae"),
+      common::testing::TestFile("data",
+        "multiple_texture_coordinates_triangle.dae"),
+      common::testing::TestFile("data",
+        "cylinder_animated_from_3ds_max.dae")})
+  {
+    common::ColladaLoader serialLoader;
+    EXPECT_FALSE(serialLoader.Parallel());
+    std::unique_ptr<common::Mesh> serial(serialLoader.Load(file));
+
+    common::ColladaLoader parallelLoader;
+    parallelLoader.SetParallel(true);
+    EXPECT_TRUE(parallelLoader.Parallel());
+    std::unique_ptr<common::Mesh> parallel(parallelLoader.Load(file));
+
+    ASSERT_NE(nullptr, serial);
+    ASSERT_NE(nullptr, parallel);
+    ExpectSameMesh(*serial, *parallel);
+  }
+
+  common::removeFile(path);
+}
+
 /////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
@@ -19,11 +19,17 @@
 #endif
 #include <FreeImage.h>
 
+#include <algorithm>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <ignition/common/Console.hh>
 #include <ignition/common/Util.hh>
 #include <ignition/common/Image.hh>
+#include <ignition/common/Parallel.hh>
+
+#include "ImageKernels.hh"
 
 using namespace ignition;
 using namespace common;
@@ -51,20 +57,195 @@ namespace ignition
       /// \return bitmap data with red and blue pixels swapped
       public: FIBITMAP* SwapRedBlue(const unsigned int &_width,
                                     const unsigned int &_height);
+
+      /// \brief Get a bitmap whose scanlines the scanline kernels can read
+      /// \param[out] _format Pixel format of the scanlines in memory
+      /// \return The bitmap itself, or a 24 bit copy of it that the caller
+      /// unloads, or nullptr if there is no bitmap
+      public: FIBITMAP *ScanlineBitmap(Image::PixelFormatType &_format) const;
+
+      /// \brief Convert the pixels of the bitmap, top row first
+      /// \param[in] _format Pixel format of the output
+      /// \param[out] _data Buffer for width * height pixels
+      public: void ConvertBitmap(const Image::PixelFormatType _format,
+                  unsigned char *_data) const;
     };
   }
 }
 
-static int count = 0;
+namespace
+{
+  /// \brief Protects freeImageUsers, since images may be created and
+  /// destroyed on several threads
+  std::mutex freeImageMutex;
+
+  /// \brief Number of images, FreeImage is initialized while it is not 0
+  unsigned int freeImageUsers = 0u;
+
+  //////////////////////////////////////////////////
+  /// \brief Get a view of the scanlines of a bitmap, top row first
+  /// \param[in] _bitmap Bitmap returned by ScanlineBitmap
+  /// \param[in] _format Pixel format returned by ScanlineBitmap
+  /// \return The view
+  ImageView BitmapView(FIBITMAP *_bitmap, const Image::PixelFormatType _format)
+  {
+    const unsigned int height = FreeImage_GetHeight(_bitmap);
+    if (height == 0u)
+      return ImageView();
+
+    // Scanlines are stored bottom up
+    return ImageView(FreeImage_GetScanLine(_bitmap,
+          static_cast<int>(height - 1u)), FreeImage_GetWidth(_bitmap), height,
+        -static_cast<std::ptrdiff_t>(FreeImage_GetPitch(_bitmap)), _format);
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Resample pixels with a separable filter, in parallel blocks
+  /// of rows. Columns are blended first when that is less work, which is
+  /// the case when shrinking, so that most of the work runs on whole rows.
+  /// \param[in] _src Pixels to resample
+  /// \param[in] _width Width of the output in pixels
+  /// \param[in] _height Height of the output in pixels
+  /// \param[in] _filter Filter to resample with
+  /// \param[out] _dst First byte of the top row of the output
+  /// \param[in] _dstPitch Number of bytes from a row of the output to the
+  /// row below it
+  /// \return False if the format is not supported or a size is zero
+  bool ResampleRows(const ImageView &_src, const unsigned int _width,
+      const unsigned int _height, const Image::ResampleFilter _filter,
+      unsigned char *_dst, const std::ptrdiff_t _dstPitch)
+  {
+    const Image::PixelFormatType format = _src.PixelFormat();
+    const unsigned int channels = ScanlineChannels(format);
+    if (channels == 0u || _src.Width() == 0u || _src.Height() == 0u ||
+        _width == 0u || _height == 0u)
+    {
+      return false;
+    }
+
+    const ResampleTaps columns(_src.Width(), _width, _filter);
+    const ResampleTaps rows(_src.Height(), _height, _filter);
+    const std::size_t srcRowSize =
+      static_cast<std::size_t>(_src.Width()) * channels;
+    const std::size_t dstRowSize = static_cast<std::size_t>(_width) * channels;
+
+    // Multiply-adds of each order
+    const double rowsFirst = static_cast<double>(_src.Height()) *
+      dstRowSize * columns.Count() +
+      static_cast<double>(_height) * dstRowSize * rows.Count();
+    const double columnsFirst =
+      static_cast<double>(_height) * srcRowSize * rows.Count() +
+      static_cast<double>(_height) * dstRowSize * columns.Count();
+
+    if (columnsFirst <= rowsFirst)
+    {
+      // Every block reads the input rows that its output rows cover
+      ParallelFor(0, _height, 16,
+          [&](const std::size_t _firstRow, const std::size_t _lastRow)
+          {
+            const std::size_t top = rows.First(_firstRow);
+            const std::size_t bottom = rows.First(_lastRow - 1) + rows.Count();
+            std::vector<float> input((bottom - top) * srcRowSize);
+            for (std::size_t y = top; y < bottom; ++y)
+            {
+              ScanlineToFloat(_src.Row(static_cast<unsigned int>(y)), format,
+                  _src.Width(), input.data() + (y - top) * srcRowSize);
+            }
+
+            std::vector<const float *> inputs(rows.Count());
+            std::vector<float> blended(srcRowSize);
+            std::vector<float> output(dstRowSize);
+            for (std::size_t y = _firstRow; y < _lastRow; ++y)
+            {
+              for (std::size_t k = 0; k < inputs.size(); ++k)
+              {
+                inputs[k] = input.data() +
+                  (rows.First(y) + k - top) * srcRowSize;
+              }
+              BlendRows(inputs.data(), rows.Weights(y), inputs.size(),
+                  srcRowSize, blended.data());
+              ResampleRow(blended.data(), channels, columns, _width,
+                  output.data());
+              FloatToScanline(output.data(), format, _width,
+                  _dst + static_cast<std::ptrdiff_t>(y) * _dstPitch);
+            }
+          });
+      return true;
+    }
+
+    std::vector<float> resampled(dstRowSize * _src.Height());
+    ParallelFor(0, _src.Height(), 16,
+        [&](const std::size_t _firstRow, const std::size_t _lastRow)
+        {
+          std::vector<float> input(srcRowSize);
+          for (std::size_t y = _firstRow; y < _lastRow; ++y)
+          {
+            ScanlineToFloat(_src.Row(static_cast<unsigned int>(y)), format,
+                _src.Width(), input.data());
+            ResampleRow(input.data(), channels, columns, _width,
+                resampled.data() + y * dstRowSize);
+          }
+        });
+
+    ParallelFor(0, _height, 16,
+        [&](const std::size_t _firstRow, const std::size_t _lastRow)
+        {
+          std::vector<float> output(dstRowSize);
+          std::vector<const float *> inputs(rows.Count());
+          for (std::size_t y = _firstRow; y < _lastRow; ++y)
+          {
+            for (std::size_t k = 0; k < inputs.size(); ++k)
+            {
+              inputs[k] =
+                resampled.data() + (rows.First(y) + k) * dstRowSize;
+            }
+            BlendRows(inputs.data(), rows.Weights(y), inputs.size(),
+                dstRowSize, output.data());
+            FloatToScanline(output.data(), format, _width,
+                _dst + static_cast<std::ptrdiff_t>(y) * _dstPitch);
+          }
+        });
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Compute the statistics of the channels of rows of pixels, on
+  /// blocks of rows in parallel
+  /// \param[in] _width Number of pixels per row
+  /// \param[in] _height Number of rows
+  /// \param[in] _format Pixel format of the rows
+  /// \param[in] _row Function that returns the pixels of a row
+  /// \return The statistics
+  template <typename Row>
+  Image::ChannelStatistics RowStatistics(const std::size_t _width,
+      const std::size_t _height, const Image::PixelFormatType _format,
+      const Row &_row)
+  {
+    return ParallelReduce(0, _height, 16, ScanlineStatistics(_format),
+        [&](const std::size_t _firstRow, const std::size_t _lastRow)
+        {
+          ScanlineStatistics partial(_format);
+          for (std::size_t y = _firstRow; y < _lastRow; ++y)
+            partial.Add(_row(y), _width);
+          return partial;
+        },
+        [](ScanlineStatistics _a, const ScanlineStatistics &_b)
+        {
+          _a.Merge(_b);
+          return _a;
+        }).Result();
+  }
+}
 
 //////////////////////////////////////////////////
 Image::Image(const std::string &_filename)
 : dataPtr(ignition::utils::MakeImpl<Implementation>())
 {
-  if (count == 0)
-    FreeImage_Initialise();
-
-  count++;
+  {
+    std::lock_guard<std::mutex> lock(freeImageMutex);
+    if (freeImageUsers++ == 0u)
+      FreeImage_Initialise();
+  }
 
   this->dataPtr->bitmap = NULL;
   if (!_filename.empty())
@@ -80,13 +261,12 @@ Image::Image(const std::string &_filename)
 //////////////////////////////////////////////////
 Image::~Image()
 {
-  count--;
-
   if (this->dataPtr->bitmap)
     FreeImage_Unload(this->dataPtr->bitmap);
   this->dataPtr->bitmap = NULL;
 
-  if (count == 0)
+  std::lock_guard<std::mutex> lock(freeImageMutex);
+  if (--freeImageUsers == 0u)
     FreeImage_DeInitialise();
 }
 
@@ -238,20 +418,49 @@ int Image::Pitch() const
 //////////////////////////////////////////////////
 void Image::RGBData(unsigned char **_data, unsigned int &_count)
 {
-  FIBITMAP *tmp = this->dataPtr->bitmap;
-  if (FREEIMAGE_COLORORDER != FREEIMAGE_COLORORDER_RGB)
-  {
-    tmp = this->dataPtr->SwapRedBlue(this->Width(), this->Height());
-  }
-  tmp = FreeImage_ConvertTo24Bits(tmp);
-  this->dataPtr->DataImpl(_data, _count, tmp);
-  FreeImage_Unload(tmp);
+  if (*_data)
+    delete [] *_data;
+  *_data = nullptr;
+  _count = 0;
+  if (!this->Valid())
+    return;
+
+  _count = this->Width() * this->Height() * 3u;
+  *_data = new unsigned char[_count];
+  this->dataPtr->ConvertBitmap(RGB_INT8, *_data);
 }
 
 //////////////////////////////////////////////////
 void Image::Data(unsigned char **_data, unsigned int &_count)
 {
-  if (FREEIMAGE_COLORORDER != FREEIMAGE_COLORORDER_RGB)
+  // Bitmaps with 8 bit channels are converted on whole scanlines, to the
+  // same channels in RGB order
+  Image::PixelFormatType format = UNKNOWN_PIXEL_FORMAT;
+  if (this->Valid())
+  {
+    FIBITMAP *bitmap = this->dataPtr->ScanlineBitmap(format);
+    if (bitmap != this->dataPtr->bitmap)
+    {
+      FreeImage_Unload(bitmap);
+      format = UNKNOWN_PIXEL_FORMAT;
+    }
+  }
+  if (format == L_INT8 || format == RGB_INT8 || format == BGR_INT8 ||
+      format == RGBA_INT8 || format == BGRA_INT8)
+  {
+    if (format == BGR_INT8)
+      format = RGB_INT8;
+    else if (format == BGRA_INT8)
+      format = RGBA_INT8;
+
+    if (*_data)
+      delete [] *_data;
+    _count = this->Width() * this->Height() *
+      static_cast<unsigned int>(ScanlinePixelBytes(format));
+    *_data = new unsigned char[_count];
+    this->dataPtr->ConvertBitmap(format, *_data);
+  }
+  else if (FREEIMAGE_COLORORDER != FREEIMAGE_COLORORDER_RGB)
   {
     this->dataPtr->DataImpl(_data, _count, this->dataPtr->SwapRedBlue(
         this->Width(), this->Height()));
@@ -262,6 +471,156 @@ void Image::Data(unsigned char **_data, unsigned int &_count)
   }
 }
 
+//////////////////////////////////////////////////
+bool Image::Data(const PixelFormatType _format,
+    std::vector<unsigned char> &_data) const
+{
+  const std::size_t size =
+    this->Valid() ? DataSize(_format, this->Width(), this->Height()) : 0u;
+  if (size == 0u)
+    return false;
+
+  _data.resize(size);
+  return this->Data(_format, _data.data(), size);
+}
+
+//////////////////////////////////////////////////
+bool Image::Data(const PixelFormatType _format, unsigned char *_data,
+    const std::size_t _size) const
+{
+  if (!this->Valid())
+    return false;
+
+  const std::size_t size = DataSize(_format, this->Width(), this->Height());
+  if (size == 0u || _size < size)
+    return false;
+
+  this->dataPtr->ConvertBitmap(_format, _data);
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::size_t Image::DataSize(const PixelFormatType _format,
+    const unsigned int _width, const unsigned int _height)
+{
+  return ScanlinePixelBytes(_format) * _width * _height;
+}
+
+//////////////////////////////////////////////////
+ImageView Image::View() const
+{
+  Image::PixelFormatType format;
+  FIBITMAP *scanlines = this->dataPtr->ScanlineBitmap(format);
+  if (!scanlines)
+    return ImageView();
+
+  if (scanlines != this->dataPtr->bitmap)
+  {
+    FreeImage_Unload(scanlines);
+    return ImageView();
+  }
+  return BitmapView(scanlines, format);
+}
+
+//////////////////////////////////////////////////
+bool Image::ConvertPixels(const unsigned char *_src,
+    const PixelFormatType _srcFormat, const unsigned int _width,
+    const unsigned int _height, const PixelFormatType _dstFormat,
+    unsigned char *_dst)
+{
+  const std::size_t srcPitch = ScanlinePixelBytes(_srcFormat) * _width;
+  return ConvertPixels(ImageView(_src, _width, _height,
+        static_cast<std::ptrdiff_t>(srcPitch), _srcFormat), _dstFormat, _dst);
+}
+
+//////////////////////////////////////////////////
+bool Image::ConvertPixels(const ImageView &_src,
+    const PixelFormatType _dstFormat, unsigned char *_dst)
+{
+  if (ScanlinePixelBytes(_src.PixelFormat()) == 0u ||
+      ScanlinePixelBytes(_dstFormat) == 0u)
+  {
+    return false;
+  }
+
+  const std::size_t dstPitch = ScanlinePixelBytes(_dstFormat) * _src.Width();
+  ParallelFor(0, _src.Height(), 16,
+      [&](const std::size_t _firstRow, const std::size_t _lastRow)
+      {
+        for (std::size_t y = _firstRow; y < _lastRow; ++y)
+        {
+          ConvertScanline(_src.Row(static_cast<unsigned int>(y)),
+              _src.PixelFormat(), _src.Width(), _dstFormat,
+              _dst + y * dstPitch);
+        }
+      });
+  return true;
+}
+
+//////////////////////////////////////////////////
+FIBITMAP *Image::Implementation::ScanlineBitmap(
+    Image::PixelFormatType &_format) const
+{
+  _format = UNKNOWN_PIXEL_FORMAT;
+  if (!this->bitmap)
+    return nullptr;
+
+  // Color bitmaps store blue first on little endian machines
+  const bool bgr = FREEIMAGE_COLORORDER != FREEIMAGE_COLORORDER_RGB;
+  const unsigned int bpp = FreeImage_GetBPP(this->bitmap);
+  switch (FreeImage_GetImageType(this->bitmap))
+  {
+    case FIT_BITMAP:
+      if (bpp == 8 &&
+          FreeImage_GetColorType(this->bitmap) == FIC_MINISBLACK)
+      {
+        _format = L_INT8;
+      }
+      else if (bpp == 24)
+        _format = bgr ? BGR_INT8 : RGB_INT8;
+      else if (bpp == 32)
+        _format = bgr ? BGRA_INT8 : RGBA_INT8;
+      break;
+    case FIT_UINT16:
+      _format = L_INT16;
+      break;
+    case FIT_RGB16:
+      _format = RGB_INT16;
+      break;
+    case FIT_FLOAT:
+      _format = R_FLOAT32;
+      break;
+    case FIT_RGBF:
+      _format = RGB_FLOAT32;
+      break;
+    default:
+      break;
+  }
+  if (_format != UNKNOWN_PIXEL_FORMAT)
+    return this->bitmap;
+
+  // Palettes and other formats go through a 24 bit copy
+  FIBITMAP *copy = FreeImage_ConvertTo24Bits(this->bitmap);
+  if (copy)
+    _format = bgr ? BGR_INT8 : RGB_INT8;
+  return copy;
+}
+
+//////////////////////////////////////////////////
+void Image::Implementation::ConvertBitmap(
+    const Image::PixelFormatType _format, unsigned char *_data) const
+{
+  Image::PixelFormatType format;
+  FIBITMAP *scanlines = this->ScanlineBitmap(format);
+  if (!scanlines)
+    return;
+
+  Image::ConvertPixels(BitmapView(scanlines, format), _format, _data);
+
+  if (scanlines != this->bitmap)
+    FreeImage_Unload(scanlines);
+}
+
 //////////////////////////////////////////////////
 void Image::Implementation::DataImpl(
     unsigned char **_data, unsigned int &_count, FIBITMAP *_img) const
@@ -382,104 +741,242 @@ math::Color Image::Pixel(unsigned int _x, unsigned int _y) const
 //////////////////////////////////////////////////
 math::Color Image::AvgColor()
 {
-  unsigned int x, y;
-  double rsum, gsum, bsum;
-  math::Color pixel;
-
-  rsum = gsum = bsum = 0.0;
-  for (y = 0; y < this->Height(); ++y)
+  Image::PixelFormatType format;
+  FIBITMAP *scanlines = this->dataPtr->ScanlineBitmap(format);
+  if (!scanlines)
+    return math::Color::Black;
+
+  const ChannelStatistics statistics = RowStatistics(
+      FreeImage_GetWidth(scanlines), FreeImage_GetHeight(scanlines), format,
+      [scanlines](const std::size_t _y)
+      {
+        return FreeImage_GetScanLine(scanlines, static_cast<int>(_y));
+      });
+  if (scanlines != this->dataPtr->bitmap)
+    FreeImage_Unload(scanlines);
+
+  // Channels are normalized to [0, 1]
+  double range = 255.0;
+  if (format == L_INT16 || format == RGB_INT16)
+    range = 65535.0;
+  else if (format == R_FLOAT32 || format == RGB_FLOAT32)
+    range = 1.0;
+  const auto &mean = statistics.mean;
+  if (statistics.channels == 1u)
   {
-    for (x = 0; x < this->Width(); ++x)
-    {
-      pixel = this->Pixel(x, y);
-      rsum += pixel.R();
-      gsum += pixel.G();
-      bsum += pixel.B();
-    }
+    const float value = static_cast<float>(mean[0] / range);
+    return math::Color(value, value, value);
   }
-
-  rsum /= (this->Width() * this->Height());
-  gsum /= (this->Width() * this->Height());
-  bsum /= (this->Width() * this->Height());
-
-  return math::Color(rsum, gsum, bsum);
+  return math::Color(static_cast<float>(mean[0] / range),
+      static_cast<float>(mean[1] / range),
+      static_cast<float>(mean[2] / range));
 }
 
 //////////////////////////////////////////////////
 math::Color Image::MaxColor() const
 {
-  unsigned int x, y;
   math::Color clr;
   math::Color maxClr;
 
   maxClr.Set(0, 0, 0, 0);
 
-  if (!this->Valid())
+  Image::PixelFormatType format;
+  FIBITMAP *scanlines = this->dataPtr->ScanlineBitmap(format);
+  if (!scanlines)
     return clr;
 
-  FREE_IMAGE_COLOR_TYPE type = FreeImage_GetColorType(this->dataPtr->bitmap);
-
-  if (type == FIC_RGB || type == FIC_RGBALPHA)
+  /// \brief Brightest pixel of a block of rows
+  struct Brightest
   {
-    RGBQUAD firgb;
-
-    for (y = 0; y < this->Height(); y++)
-    {
-      for (x = 0; x < this->Width(); x++)
+    /// \brief Sum of the color channels
+    int brightness;
+
+    /// \brief Red, green and blue
+    std::array<unsigned char, 3> color;
+  };
+
+  // Scanlines with wider channels are converted to 8 bits first
+  const bool convert = format != L_INT8 && format != RGB_INT8 &&
+    format != BGR_INT8 && format != RGBA_INT8 && format != BGRA_INT8;
+  const Image::PixelFormatType rowFormat = convert ? RGB_INT8 : format;
+  const std::size_t pixelBytes = ScanlinePixelBytes(rowFormat);
+  const unsigned int width = FreeImage_GetWidth(scanlines);
+
+  // Keep the first of several equally bright colors, as a row by row scan
+  // would. Black pixels are not brighter than the initial color.
+  const Brightest brightest = ParallelReduce(0,
+      FreeImage_GetHeight(scanlines), 16, Brightest{0, {{0, 0, 0}}},
+      [&](const std::size_t _firstRow, const std::size_t _lastRow)
       {
-        clr.Set(0, 0, 0, 0);
-
-        if (FALSE ==
-              FreeImage_GetPixelColor(this->dataPtr->bitmap, x, y, &firgb))
+        Brightest block{0, {{0, 0, 0}}};
+        std::vector<unsigned char> converted(convert ? width * 3u : 0u);
+        for (std::size_t y = _firstRow; y < _lastRow; ++y)
         {
-          ignerr << "Image: Coordinates out of range["
-            << x << " " << y << "] \n";
-          continue;
+          const unsigned char *row =
+            FreeImage_GetScanLine(scanlines, static_cast<int>(y));
+          if (convert)
+          {
+            ConvertScanline(row, format, width, RGB_INT8, converted.data());
+            row = converted.data();
+          }
+          unsigned int brightness;
+          const std::size_t x =
+            BrightestPixel(row, rowFormat, width, brightness);
+          if (static_cast<int>(brightness) <= block.brightness)
+            continue;
+
+          block.brightness = static_cast<int>(brightness);
+          ConvertScanline(row + x * pixelBytes, rowFormat, 1u, RGB_INT8,
+              block.color.data());
         }
-        clr.Set(firgb.rgbRed, firgb.rgbGreen, firgb.rgbBlue);
+        return block;
+      },
+      [](const Brightest &_a, const Brightest &_b)
+      {
+        return _b.brightness > _a.brightness ? _b : _a;
+      });
+  if (scanlines != this->dataPtr->bitmap)
+    FreeImage_Unload(scanlines);
+
+  if (brightest.brightness <= 0)
+    return maxClr;
+  clr.Set(brightest.color[0], brightest.color[1], brightest.color[2]);
+  return clr;
+}
 
-        if (clr.R() + clr.G() + clr.B() > maxClr.R() + maxClr.G() + maxClr.B())
-        {
-          maxClr = clr;
-        }
-      }
-    }
-  }
-  else
-  {
-    BYTE byteValue;
-    for (y = 0; y < this->Height(); y++)
-    {
-      for (x = 0; x < this->Width(); x++)
+//////////////////////////////////////////////////
+Image::ChannelStatistics Image::Statistics() const
+{
+  Image::PixelFormatType format;
+  FIBITMAP *scanlines = this->dataPtr->ScanlineBitmap(format);
+  if (!scanlines)
+    return ChannelStatistics();
+
+  const ChannelStatistics statistics = RowStatistics(
+      FreeImage_GetWidth(scanlines), FreeImage_GetHeight(scanlines), format,
+      [scanlines](const std::size_t _y)
       {
-        clr.Set(0, 0, 0, 0);
+        return FreeImage_GetScanLine(scanlines, static_cast<int>(_y));
+      });
+  if (scanlines != this->dataPtr->bitmap)
+    FreeImage_Unload(scanlines);
+  return statistics;
+}
 
-        if (FreeImage_GetPixelIndex(
-              this->dataPtr->bitmap, x, y, &byteValue) == FALSE)
-        {
-          ignerr << "Image: Coordinates out of range ["
-            << x << " " << y << "] \n";
-          continue;
-        }
+//////////////////////////////////////////////////
+Image::ChannelStatistics Image::Statistics(const unsigned char *_data,
+    const unsigned int _width, const unsigned int _height,
+    const PixelFormatType _format)
+{
+  const std::size_t pitch = ScanlinePixelBytes(_format) * _width;
+  return RowStatistics(_width, _height, _format,
+      [_data, pitch](const std::size_t _y)
+      {
+        return _data + _y * pitch;
+      });
+}
 
-        clr.Set(byteValue, byteValue, byteValue);
+//////////////////////////////////////////////////
+void Image::Rescale(int _width, int _height)
+{
+  this->Rescale(_width, _height, ResampleFilter::LANCZOS3);
+}
 
-        if (clr.R() + clr.G() + clr.B() > maxClr.R() + maxClr.G() + maxClr.B())
-        {
-          maxClr = clr;
-        }
-      }
+//////////////////////////////////////////////////
+void Image::Rescale(const int _width, const int _height,
+    const ResampleFilter _filter)
+{
+  FIBITMAP *bitmap = this->dataPtr->bitmap;
+  if (!bitmap || _width <= 0 || _height <= 0)
+    return;
+
+  FIBITMAP *resized = nullptr;
+  const ImageView view = this->View();
+  if (view.Valid())
+  {
+    // Same type of bitmap, which stores its scanlines bottom up
+    resized = FreeImage_AllocateT(FreeImage_GetImageType(bitmap), _width,
+        _height, FreeImage_GetBPP(bitmap));
+    if (resized)
+    {
+      ResampleRows(view, _width, _height, _filter,
+          FreeImage_GetScanLine(resized, _height - 1),
+          -static_cast<std::ptrdiff_t>(FreeImage_GetPitch(resized)));
     }
   }
+  else
+  {
+    // Palettes and other formats
+    FREE_IMAGE_FILTER filter = FILTER_LANCZOS3;
+    if (_filter == ResampleFilter::BOX)
+      filter = FILTER_BOX;
+    else if (_filter == ResampleFilter::BILINEAR)
+      filter = FILTER_BILINEAR;
+    resized = FreeImage_Rescale(bitmap, _width, _height, filter);
+  }
+
+  if (resized)
+  {
+    FreeImage_Unload(bitmap);
+    this->dataPtr->bitmap = resized;
+  }
+}
 
-  return maxClr;
+//////////////////////////////////////////////////
+bool Image::Resample(const ImageView &_src, const unsigned int _width,
+    const unsigned int _height, const ResampleFilter _filter,
+    unsigned char *_dst)
+{
+  return ResampleRows(_src, _width, _height, _filter, _dst,
+      static_cast<std::ptrdiff_t>(
+        ScanlinePixelBytes(_src.PixelFormat()) * _width));
 }
 
 //////////////////////////////////////////////////
-void Image::Rescale(int _width, int _height)
+bool Image::Mipmaps(const PixelFormatType _format,
+    std::vector<unsigned char> &_data, std::vector<ImageView> &_levels,
+    const ResampleFilter _filter) const
 {
-  this->dataPtr->bitmap = FreeImage_Rescale(
-      this->dataPtr->bitmap, _width, _height, FILTER_LANCZOS3);
+  const std::size_t pixelBytes = ScanlinePixelBytes(_format);
+  if (!this->Valid() || pixelBytes == 0u)
+    return false;
+
+  // Size of the chain, so that it fits in one buffer
+  std::size_t size = 0u;
+  unsigned int width = this->Width();
+  unsigned int height = this->Height();
+  std::size_t levels = 1u;
+  while (true)
+  {
+    size += pixelBytes * width * height;
+    if (width <= 1u && height <= 1u)
+      break;
+    width = std::max(1u, width / 2u);
+    height = std::max(1u, height / 2u);
+    ++levels;
+  }
+  _data.resize(size);
+  _levels.clear();
+  _levels.reserve(levels);
+
+  width = this->Width();
+  height = this->Height();
+  unsigned char *level = _data.data();
+  this->dataPtr->ConvertBitmap(_format, level);
+  _levels.emplace_back(level, width, height,
+      static_cast<std::ptrdiff_t>(pixelBytes * width), _format);
+
+  // Every level is resampled from the previous one
+  while (_levels.size() < levels)
+  {
+    level += pixelBytes * width * height;
+    width = std::max(1u, width / 2u);
+    height = std::max(1u, height / 2u);
+    Resample(_levels.back(), width, height, _filter, level);
+    _levels.emplace_back(level, width, height,
+        static_cast<std::ptrdiff_t>(pixelBytes * width), _format);
+  }
+  return true;
 }
 
 //////////////////////////////////////////////////
@@ -570,3 +1067,54 @@ FIBITMAP* Image::Implementation::SwapRedBlue(const unsigned int &_width,
 
   return copy;
 }
+
+//////////////////////////////////////////////////
+ImageView::ImageView(const unsigned char *_data, const unsigned int _width,
+    const unsigned int _height, const std::ptrdiff_t _pitch,
+    const Image::PixelFormatType _format)
+: data(_data), width(_width), height(_height), pitch(_pitch),
+  format(_format)
+{
+}
+
+//////////////////////////////////////////////////
+const unsigned char *ImageView::Data() const
+{
+  return this->data;
+}
+
+//////////////////////////////////////////////////
+const unsigned char *ImageView::Row(const unsigned int _y) const
+{
+  return this->data + static_cast<std::ptrdiff_t>(_y) * this->pitch;
+}
+
+//////////////////////////////////////////////////
+unsigned int ImageView::Width() const
+{
+  return this->width;
+}
+
+//////////////////////////////////////////////////
+unsigned int ImageView::Height() const
+{
+  return this->height;
+}
+
+//////////////////////////////////////////////////
+std::ptrdiff_t ImageView::Pitch() const
+{
+  return this->pitch;
+}
+
+//////////////////////////////////////////////////
+Image::PixelFormatType ImageView::PixelFormat() const
+{
+  return this->format;
+}
+
+//////////////////////////////////////////////////
+bool ImageView::Valid() const
+{
+  return this->data != nullptr;
+}
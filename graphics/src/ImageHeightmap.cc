@@ -14,12 +14,63 @@
  * limitations under the License.
  *
  */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
 #include "ignition/common/Console.hh"
 #include "ignition/common/ImageHeightmap.hh"
+#include "ignition/common/Parallel.hh"
+
+#include "ImageKernels.hh"
 
 using namespace ignition;
 using namespace common;
 
+namespace
+{
+  //////////////////////////////////////////////////
+  /// \brief Find the channel that holds heights in a pixel format
+  /// \param[in] _format Pixel format
+  /// \param[out] _red Channel holding the red color, in memory order
+  /// \param[out] _range Value of the channel at full height: 255 for 8 bit
+  /// channels, 65535 for 16 bit channels, and 1 for float channels
+  /// \return False if heights are not read in place from the format
+  bool HeightChannel(const Image::PixelFormatType _format,
+      unsigned int &_red, double &_range)
+  {
+    _red = 0;
+    switch (_format)
+    {
+      case Image::BGR_INT8:
+      case Image::BGRA_INT8:
+        _red = 2;
+        _range = 255.0;
+        return true;
+      case Image::L_INT8:
+      case Image::RGB_INT8:
+      case Image::RGBA_INT8:
+        _range = 255.0;
+        return true;
+      case Image::BGR_INT16:
+        _red = 2;
+        _range = 65535.0;
+        return true;
+      case Image::L_INT16:
+      case Image::RGB_INT16:
+        _range = 65535.0;
+        return true;
+      case Image::R_FLOAT32:
+      case Image::RGB_FLOAT32:
+        _range = 1.0;
+        return true;
+      default:
+        return false;
+    }
+  }
+}
+
 //////////////////////////////////////////////////
 ImageHeightmap::ImageHeightmap()
 {
@@ -51,61 +102,104 @@ void ImageHeightmap::FillHeightMap(int _subSampling,
 
   IGN_ASSERT(imgWidth == imgHeight, "Heightmap image must be square");
 
-  // Bytes per row
-  unsigned int pitch = this->img.Pitch();
+  // Heights come from the red channel of the pixels, read in place and at
+  // the precision of their format. Other formats are converted first.
+  ImageView view = this->img.View();
+  std::vector<unsigned char> converted;
+  unsigned int red = 0;
+  double range = 1.0;
+  if (!HeightChannel(view.PixelFormat(), red, range))
+  {
+    if (!this->img.Data(Image::RGB_INT8, converted))
+      return;
+    view = ImageView(converted.data(), imgWidth, imgHeight, imgWidth * 3,
+        Image::RGB_INT8);
+    HeightChannel(view.PixelFormat(), red, range);
+  }
+  if (!view.Valid() || _vertSize == 0u)
+    return;
 
-  // Bytes per pixel
-  unsigned int bpp = pitch / imgWidth;
+  const unsigned int channels = ScanlineChannels(view.PixelFormat());
+  const double subSampling = static_cast<double>(_subSampling);
 
-  unsigned char *data = nullptr;
-  unsigned int count;
-  this->img.Data(&data, count);
+  // Every vertex row interpolates the same columns of the image
+  std::vector<int> x1s(_vertSize);
+  std::vector<int> x2s(_vertSize);
+  std::vector<double> dxs(_vertSize);
+  for (unsigned int x = 0; x < _vertSize; ++x)
+  {
+    const double xf = std::min(x / subSampling, imgWidth - 1.0);
+    x1s[x] = static_cast<int>(std::floor(xf));
+    x2s[x] = std::min(static_cast<int>(std::ceil(xf)), imgWidth - 1);
+    dxs[x] = xf - x1s[x];
+  }
 
-  // Iterate over all the vertices
-  for (unsigned int y = 0; y < _vertSize; ++y)
+  // Iterate over all the vertices. Rows are independent of each other, so
+  // they are filled in parallel.
+  ParallelFor(0, _vertSize, 8,
+      [&](const std::size_t _firstRow, const std::size_t _lastRow)
   {
-    // yf ranges between 0 and 4
-    double yf = y / static_cast<double>(_subSampling);
-    int y1 = static_cast<int>(std::floor(yf));
-    int y2 = static_cast<int>(std::ceil(yf));
-    if (y2 >= imgHeight)
-      y2 = imgHeight-1;
-    double dy = yf - y1;
-
-    for (unsigned int x = 0; x < _vertSize; ++x)
+    // Heights of the last two image rows read by this block, which are
+    // shared by consecutive vertex rows
+    std::vector<float> pixels(static_cast<std::size_t>(imgWidth) * channels);
+    std::array<std::vector<double>, 2> rows;
+    std::array<int, 2> rowIndices{{-1, -1}};
+
+    auto heightRow = [&](const int _y) -> const double *
     {
-      double xf = x / static_cast<double>(_subSampling);
-      int x1 = static_cast<int>(std::floor(xf));
-      int x2 = static_cast<int>(std::ceil(xf));
-      if (x2 >= imgWidth)
-        x2 = imgWidth-1;
-      double dx = xf - x1;
-
-      double px1 = static_cast<int>(data[y1 * pitch + x1 * bpp]) / 255.0;
-      double px2 = static_cast<int>(data[y1 * pitch + x2 * bpp]) / 255.0;
-      float h1 = (px1 - ((px1 - px2) * dx));
-
-      double px3 = static_cast<int>(data[y2 * pitch + x1 * bpp]) / 255.0;
-      double px4 = static_cast<int>(data[y2 * pitch + x2 * bpp]) / 255.0;
-      float h2 = (px3 - ((px3 - px4) * dx));
-
-      float h = (h1 - ((h1 - h2) * dy)) * _scale.Z();
-
-      // invert pixel definition so 1=ground, 0=full height,
-      //   if the terrain size has a negative z component
-      //   this is mainly for backward compatibility
-      if (_size.Z() < 0)
-        h = 1.0 - h;
-
-      // Store the height for future use
-      if (!_flipY)
-        _heights[y * _vertSize + x] = h;
-      else
-        _heights[(_vertSize - y - 1) * _vertSize + x] = h;
-    }
-  }
+      for (std::size_t i = 0; i < rows.size(); ++i)
+      {
+        if (rowIndices[i] == _y)
+          return rows[i].data();
+      }
 
-  delete [] data;
+      // Replace the upper row, vertex rows go down the image
+      const std::size_t slot = rowIndices[0] < rowIndices[1] ? 0u : 1u;
+      ScanlineToFloat(view.Row(_y), view.PixelFormat(), imgWidth,
+          pixels.data());
+      rows[slot].resize(imgWidth);
+      for (int x = 0; x < imgWidth; ++x)
+        rows[slot][x] = pixels[x * channels + red] / range;
+      rowIndices[slot] = _y;
+      return rows[slot].data();
+    };
+
+    for (std::size_t y = _firstRow; y < _lastRow; ++y)
+    {
+      const double yf = std::min(y / subSampling, imgHeight - 1.0);
+      const int y1 = static_cast<int>(std::floor(yf));
+      const int y2 = std::min(static_cast<int>(std::ceil(yf)), imgHeight - 1);
+      const double dy = yf - y1;
+      const double *row1 = heightRow(y1);
+      const double *row2 = heightRow(y2);
+
+      float *out = _flipY ?
+        &_heights[(_vertSize - y - 1) * _vertSize] : &_heights[y * _vertSize];
+      for (unsigned int x = 0; x < _vertSize; ++x)
+      {
+        const double dx = dxs[x];
+
+        double px1 = row1[x1s[x]];
+        double px2 = row1[x2s[x]];
+        float h1 = (px1 - ((px1 - px2) * dx));
+
+        double px3 = row2[x1s[x]];
+        double px4 = row2[x2s[x]];
+        float h2 = (px3 - ((px3 - px4) * dx));
+
+        float h = (h1 - ((h1 - h2) * dy)) * _scale.Z();
+
+        // invert pixel definition so 1=ground, 0=full height,
+        //   if the terrain size has a negative z component
+        //   this is mainly for backward compatibility
+        if (_size.Z() < 0)
+          h = 1.0 - h;
+
+        // Store the height for future use
+        out[x] = h;
+      }
+    }
+  });
 }
 
 //////////////////////////////////////////////////
@@ -129,5 +223,58 @@ unsigned int ImageHeightmap::Width() const
 //////////////////////////////////////////////////
 float ImageHeightmap::MaxElevation() const
 {
-  return this->img.MaxColor().R();
+  // Red value of the brightest pixel, at the precision of the pixel format
+  const ImageView view = this->img.View();
+  unsigned int red = 0;
+  double range = 1.0;
+  if (!view.Valid() || !HeightChannel(view.PixelFormat(), red, range))
+    return this->img.MaxColor().R();
+
+  /// \brief Brightest pixel of a block of rows
+  struct Brightest
+  {
+    /// \brief Sum of the color channels
+    double brightness;
+
+    /// \brief Red value
+    double red;
+  };
+
+  const unsigned int width = view.Width();
+  const unsigned int channels = ScanlineChannels(view.PixelFormat());
+  const unsigned int colors = std::min(channels, 3u);
+
+  // Keep the first of several equally bright pixels, as a row by row scan
+  // would. Black pixels are not brighter than the initial value.
+  const Brightest brightest = ParallelReduce(0, view.Height(), 16,
+      Brightest{0.0, 0.0},
+      [&](const std::size_t _firstRow, const std::size_t _lastRow)
+      {
+        Brightest block{0.0, 0.0};
+        std::vector<float> pixels(static_cast<std::size_t>(width) * channels);
+        for (std::size_t y = _firstRow; y < _lastRow; ++y)
+        {
+          ScanlineToFloat(view.Row(static_cast<unsigned int>(y)),
+              view.PixelFormat(), width, pixels.data());
+          for (unsigned int x = 0; x < width; ++x)
+          {
+            const float *pixel = &pixels[x * channels];
+            double brightness = 0.0;
+            for (unsigned int c = 0; c < colors; ++c)
+              brightness += pixel[c];
+            if (brightness <= block.brightness)
+              continue;
+
+            block.brightness = brightness;
+            block.red = pixel[red];
+          }
+        }
+        return block;
+      },
+      [](const Brightest &_a, const Brightest &_b)
+      {
+        return _b.brightness > _a.brightness ? _b : _a;
+      });
+
+  return static_cast<float>(brightest.red / range);
 }
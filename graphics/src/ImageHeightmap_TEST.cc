@@ -97,6 +97,82 @@ TEST_F(ImageHeightmapTest, FillHeightmap)
   EXPECT_NEAR(5.0, elevations.at(elevations.size() / 2), ELEVATION_TOL);
 }
 
+/////////////////////////////////////////////////
+TEST_F(ImageHeightmapTest, FillHeightmap16Bit)
+{
+  common::ImageHeightmap img;
+
+  // 65x65 16 bit pixels holding x * 1000 + y * 15 + 7
+  const auto path =
+    common::testing::TestFile("data", "heightmap_ramp_16bit.png");
+  ASSERT_EQ(0, img.Load(path));
+  ASSERT_EQ(65u, img.Width());
+  EXPECT_NEAR(64967.0 / 65535.0, img.MaxElevation(), 1e-6);
+
+  const int subsampling = 2;
+  const unsigned int vertSize = (img.Width() - 1) * subsampling + 1;
+  const math::Vector3d size(65, 65, 2);
+  const math::Vector3d scale(1, 1, 2);
+  std::vector<float> elevations;
+  img.FillHeightMap(subsampling, vertSize, size, scale, false, elevations);
+  ASSERT_EQ(vertSize * vertSize, elevations.size());
+
+  // Bilinear interpolation of a ramp is exact, and steps of a 16 bit value
+  // are much smaller than those of an 8 bit value
+  for (unsigned int y = 0; y < vertSize; ++y)
+  {
+    for (unsigned int x = 0; x < vertSize; ++x)
+    {
+      const double pixel = x * 500.0 + y * 7.5 + 7.0;
+      ASSERT_NEAR(2.0 * pixel / 65535.0, elevations[y * vertSize + x], 1e-5)
+        << x << " " << y;
+    }
+  }
+
+  // Flipped rows and inverted heights
+  std::vector<float> flipped;
+  img.FillHeightMap(subsampling, vertSize, -size, scale, true, flipped);
+  ASSERT_EQ(elevations.size(), flipped.size());
+  for (unsigned int y = 0; y < vertSize; ++y)
+  {
+    for (unsigned int x = 0; x < vertSize; ++x)
+    {
+      EXPECT_FLOAT_EQ(1.0f - elevations[y * vertSize + x],
+          flipped[(vertSize - y - 1) * vertSize + x]);
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+TEST_F(ImageHeightmapTest, FillHeightmapRGB)
+{
+  common::ImageHeightmap img;
+
+  // 3x3 RGB pixels. The brightest one, (100, 255, 255), is not the one with
+  // the largest red value, (200, 0, 0).
+  const auto path = common::testing::TestFile("data", "heightmap_rgb_3x3.png");
+  ASSERT_EQ(0, img.Load(path));
+  ASSERT_EQ(3u, img.Width());
+
+  // The maximum elevation is the red value of the brightest pixel
+  EXPECT_NEAR(100.0 / 255.0, img.MaxElevation(), 1e-6);
+
+  const int subsampling = 2;
+  const unsigned int vertSize = (img.Width() - 1) * subsampling + 1;
+  const math::Vector3d size(3, 3, 1);
+  const math::Vector3d scale(1, 1, 1);
+  std::vector<float> elevations;
+  img.FillHeightMap(subsampling, vertSize, size, scale, false, elevations);
+  ASSERT_EQ(vertSize * vertSize, elevations.size());
+
+  // Heights come from the red channel only
+  EXPECT_NEAR(200.0 / 255.0, elevations[0], 1e-6);
+  EXPECT_NEAR(150.0 / 255.0, elevations[1], 1e-6);
+  EXPECT_NEAR(100.0 / 255.0, elevations[2], 1e-6);
+  EXPECT_NEAR(77.5 / 255.0, elevations[vertSize + 1], 1e-6);
+  EXPECT_NEAR(30.0 / 255.0, elevations[vertSize * vertSize - 1], 1e-6);
+}
+
 /////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
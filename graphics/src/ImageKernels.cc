@@ -0,0 +1,952 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define IGN_COMMON_IMAGE_SSE2
+#endif
+
+#include "ImageKernels.hh"
+
+using namespace ignition;
+using namespace common;
+
+namespace
+{
+  /// \brief Weights of red, green and blue in the luminance, out of 256
+  const std::array<int, 3> kLumaWeights = {{77, 150, 29}};
+
+  /// \brief How a pixel format stores a pixel
+  struct Layout
+  {
+    /// \brief Number of channels, 0 for formats that are not handled
+    unsigned int channels;
+
+    /// \brief Bytes per channel
+    unsigned int bytes;
+
+    /// \brief True if the channels are 32 bit floats
+    bool isFloat;
+
+    /// \brief Channel that holds red, green, blue and alpha, or -1 for
+    /// alpha in formats without alpha. Luminance formats read every color
+    /// from channel 0.
+    std::array<int, 4> order;
+  };
+
+  //////////////////////////////////////////////////
+  /// \brief Describe how a pixel format stores a pixel
+  /// \param[in] _format Pixel format
+  /// \return The layout, with no channels if the format is not handled
+  Layout Describe(const Image::PixelFormatType _format)
+  {
+    switch (_format)
+    {
+      case Image::L_INT8:
+        return {1u, 1u, false, {{0, 0, 0, -1}}};
+      case Image::L_INT16:
+        return {1u, 2u, false, {{0, 0, 0, -1}}};
+      case Image::RGB_INT8:
+        return {3u, 1u, false, {{0, 1, 2, -1}}};
+      case Image::BGR_INT8:
+        return {3u, 1u, false, {{2, 1, 0, -1}}};
+      case Image::RGBA_INT8:
+        return {4u, 1u, false, {{0, 1, 2, 3}}};
+      case Image::BGRA_INT8:
+        return {4u, 1u, false, {{2, 1, 0, 3}}};
+      case Image::RGB_INT16:
+        return {3u, 2u, false, {{0, 1, 2, -1}}};
+      case Image::BGR_INT16:
+        return {3u, 2u, false, {{2, 1, 0, -1}}};
+      case Image::R_FLOAT32:
+        return {1u, 4u, true, {{0, 0, 0, -1}}};
+      case Image::RGB_FLOAT32:
+        return {3u, 4u, true, {{0, 1, 2, -1}}};
+      default:
+        return {0u, 0u, false, {{0, 0, 0, -1}}};
+    }
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Get the color that a channel holds
+  /// \param[in] _layout Layout of the pixels
+  /// \param[in] _channel Channel in memory order
+  /// \return 0 to 3 for red, green, blue and alpha, or 4 for the
+  /// luminance of luminance formats
+  int ColorOf(const Layout &_layout, const unsigned int _channel)
+  {
+    if (_layout.channels == 1u)
+      return 4;
+    for (int color = 0; color < 4; ++color)
+    {
+      if (_layout.order[color] == static_cast<int>(_channel))
+        return color;
+    }
+    return 4;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Compute the luminance of 8 bit colors
+  /// \param[in] _red Red
+  /// \param[in] _green Green
+  /// \param[in] _blue Blue
+  /// \return Luminance
+  unsigned char Luma(const unsigned int _red, const unsigned int _green,
+      const unsigned int _blue)
+  {
+    return static_cast<unsigned char>((kLumaWeights[0] * _red +
+          kLumaWeights[1] * _green + kLumaWeights[2] * _blue + 128u) >> 8u);
+  }
+
+#ifdef IGN_COMMON_IMAGE_SSE2
+  //////////////////////////////////////////////////
+  /// \brief Compute the luminance of 8 bit color pixels, 4 at a time
+  /// \param[in] _src Pixels to convert
+  /// \param[in] _layout Layout of _src. Only four channel layouts are
+  /// converted.
+  /// \param[in] _width Number of pixels
+  /// \param[out] _dst Luminance of every pixel
+  /// \return Number of pixels converted. The others are left to the
+  /// caller.
+  std::size_t Luma8(const unsigned char *_src, const Layout &_layout,
+      const std::size_t _width, unsigned char *_dst)
+  {
+    // Only four channel pixels line up with the weights
+    if (_layout.channels != 4u)
+      return 0u;
+
+    // Weight of every channel of a four channel pixel
+    std::array<int16_t, 4> weights = {{0, 0, 0, 0}};
+    for (unsigned int color = 0; color < 3u; ++color)
+      weights[_layout.order[color]] = static_cast<int16_t>(kLumaWeights[color]);
+    const __m128i weights2 = _mm_setr_epi16(weights[0], weights[1],
+        weights[2], weights[3], weights[0], weights[1], weights[2],
+        weights[3]);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi32(128);
+
+    std::size_t x = 0;
+    for (; x + 4u <= _width; x += 4u)
+    {
+      const __m128i block = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(_src + x * 4u));
+      // Weighted pairs of channels, then sums of the pairs
+      __m128i low = _mm_madd_epi16(_mm_unpacklo_epi8(block, zero), weights2);
+      __m128i high = _mm_madd_epi16(_mm_unpackhi_epi8(block, zero), weights2);
+      low = _mm_add_epi32(low, _mm_shuffle_epi32(low, _MM_SHUFFLE(2, 3, 0, 1)));
+      high = _mm_add_epi32(high,
+          _mm_shuffle_epi32(high, _MM_SHUFFLE(2, 3, 0, 1)));
+      __m128i sums = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(low),
+            _mm_castsi128_ps(high), _MM_SHUFFLE(2, 0, 2, 0)));
+      sums = _mm_srli_epi32(_mm_add_epi32(sums, half), 8);
+      sums = _mm_packs_epi32(sums, sums);
+      sums = _mm_packus_epi16(sums, sums);
+      const int32_t luma = _mm_cvtsi128_si32(sums);
+      std::memcpy(_dst + x, &luma, sizeof(luma));
+    }
+    return x;
+  }
+#endif
+
+  //////////////////////////////////////////////////
+  /// \brief Convert a scanline between two formats with 8 bit channels
+  /// \param[in] _src Pixels to convert
+  /// \param[in] _from Layout of _src
+  /// \param[in] _width Number of pixels
+  /// \param[in] _to Layout of _dst
+  /// \param[out] _dst Converted pixels
+  void Convert8(const unsigned char *_src, const Layout &_from,
+      const std::size_t _width, const Layout &_to, unsigned char *_dst)
+  {
+    const unsigned int fromChannels = _from.channels;
+    const unsigned int toChannels = _to.channels;
+    std::size_t x = 0;
+    if (toChannels == 1u)
+    {
+#ifdef IGN_COMMON_IMAGE_SSE2
+      x = Luma8(_src, _from, _width, _dst);
+#endif
+      for (; x < _width; ++x)
+      {
+        const unsigned char *pixel = _src + x * fromChannels;
+        _dst[x] = Luma(pixel[_from.order[0]], pixel[_from.order[1]],
+            pixel[_from.order[2]]);
+      }
+      return;
+    }
+
+    // Source channel of every destination channel, -1 for opaque alpha
+    std::array<int, 4> sources = {{0, 0, 0, 0}};
+    for (unsigned int channel = 0; channel < toChannels; ++channel)
+      sources[channel] = _from.order[ColorOf(_to, channel)];
+
+    for (; x < _width; ++x)
+    {
+      const unsigned char *pixel = _src + x * fromChannels;
+      unsigned char *out = _dst + x * toChannels;
+      for (unsigned int channel = 0; channel < toChannels; ++channel)
+        out[channel] = sources[channel] < 0 ? 255u : pixel[sources[channel]];
+    }
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Read a channel as a float
+  /// \param[in] _src Pixels
+  /// \param[in] _layout Layout of the pixels
+  /// \param[in] _index Index of the channel from the start of _src
+  /// \return Value, in [0, 1] for integer channels
+  float ReadChannel(const unsigned char *_src, const Layout &_layout,
+      const std::size_t _index)
+  {
+    if (_layout.isFloat)
+    {
+      float value;
+      std::memcpy(&value, _src + _index * 4u, sizeof(value));
+      return value;
+    }
+    if (_layout.bytes == 2u)
+    {
+      uint16_t value;
+      std::memcpy(&value, _src + _index * 2u, sizeof(value));
+      return value / 65535.0f;
+    }
+    return _src[_index] / 255.0f;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Write a float to a channel
+  /// \param[in] _value Value, clamped to [0, 1] for integer channels
+  /// \param[in] _layout Layout of the pixels
+  /// \param[in] _index Index of the channel from the start of _dst
+  /// \param[out] _dst Pixels
+  void WriteChannel(float _value, const Layout &_layout,
+      const std::size_t _index, unsigned char *_dst)
+  {
+    if (_layout.isFloat)
+    {
+      std::memcpy(_dst + _index * 4u, &_value, sizeof(_value));
+      return;
+    }
+    // Written so that NaN turns into 0
+    if (!(_value > 0.0f))
+      _value = 0.0f;
+    else if (_value > 1.0f)
+      _value = 1.0f;
+    if (_layout.bytes == 2u)
+    {
+      const uint16_t value = static_cast<uint16_t>(_value * 65535.0f + 0.5f);
+      std::memcpy(_dst + _index * 2u, &value, sizeof(value));
+      return;
+    }
+    _dst[_index] = static_cast<unsigned char>(_value * 255.0f + 0.5f);
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Convert a scanline through normalized RGBA floats, for formats
+  /// with 16 bit or float channels
+  /// \param[in] _src Pixels to convert
+  /// \param[in] _from Layout of _src
+  /// \param[in] _width Number of pixels
+  /// \param[in] _to Layout of _dst
+  /// \param[out] _dst Converted pixels
+  void ConvertGeneric(const unsigned char *_src, const Layout &_from,
+      const std::size_t _width, const Layout &_to, unsigned char *_dst)
+  {
+    std::array<int, 4> colors = {{4, 4, 4, 4}};
+    for (unsigned int channel = 0; channel < _to.channels; ++channel)
+      colors[channel] = ColorOf(_to, channel);
+
+    for (std::size_t x = 0; x < _width; ++x)
+    {
+      std::array<float, 4> rgba = {{0.0f, 0.0f, 0.0f, 1.0f}};
+      for (unsigned int color = 0; color < 4u; ++color)
+      {
+        if (_from.order[color] >= 0)
+        {
+          rgba[color] = ReadChannel(_src, _from,
+              x * _from.channels + _from.order[color]);
+        }
+      }
+      for (unsigned int channel = 0; channel < _to.channels; ++channel)
+      {
+        const int color = colors[channel];
+        const float value = color < 4 ? rgba[color] :
+          (kLumaWeights[0] * rgba[0] + kLumaWeights[1] * rgba[1] +
+           kLumaWeights[2] * rgba[2]) / 256.0f;
+        WriteChannel(value, _to, x * _to.channels + channel, _dst);
+      }
+    }
+  }
+
+#ifdef IGN_COMMON_IMAGE_SSE2
+  /// \brief Vector of bytes
+  using Bytes = __m128i;
+
+  /// \brief Load a vector
+  /// \param[in] _src Bytes
+  /// \return The vector
+  inline Bytes LoadBytes(const unsigned char *_src)
+  {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(_src));
+  }
+
+  /// \brief Store a vector
+  /// \param[in] _value The vector
+  /// \param[out] _dst Bytes
+  inline void StoreBytes(const Bytes &_value, unsigned char *_dst)
+  {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(_dst), _value);
+  }
+
+  /// \brief Get a vector with every byte set to a value
+  /// \param[in] _value Value
+  /// \return The vector
+  inline Bytes FillBytes(const unsigned char _value)
+  {
+    return _mm_set1_epi8(static_cast<char>(_value));
+  }
+
+  /// \brief Get the smallest of every pair of bytes
+  /// \param[in] _a First vector
+  /// \param[in] _b Second vector
+  /// \return The smallest bytes
+  inline Bytes MinBytes(const Bytes &_a, const Bytes &_b)
+  {
+    return _mm_min_epu8(_a, _b);
+  }
+
+  /// \brief Get the largest of every pair of bytes
+  /// \param[in] _a First vector
+  /// \param[in] _b Second vector
+  /// \return The largest bytes
+  inline Bytes MaxBytes(const Bytes &_a, const Bytes &_b)
+  {
+    return _mm_max_epu8(_a, _b);
+  }
+
+  /// \brief Add the sums of the masked bytes of every group of 8 bytes to
+  /// 64 bit sums
+  /// \param[in] _sums Sums
+  /// \param[in] _value Bytes
+  /// \param[in] _mask Mask of the bytes to add
+  /// \return The new sums
+  inline Bytes AddSums(const Bytes &_sums, const Bytes &_value,
+      const Bytes &_mask)
+  {
+    return _mm_add_epi64(_sums, _mm_sad_epu8(
+          _mm_and_si128(_value, _mask), _mm_setzero_si128()));
+  }
+#endif
+
+  //////////////////////////////////////////////////
+  /// \brief Accumulate the statistics of 8 bit channels
+  /// \param[in] _src Channels
+  /// \param[in] _count Number of channels
+  /// \param[in] _channels Channels per pixel, 1, 3 or 4
+  /// \param[in, out] _min Smallest value of every channel
+  /// \param[in, out] _max Largest value of every channel
+  /// \param[in, out] _sum Sum of every channel
+  void Statistics8(const unsigned char *_src, const std::size_t _count,
+      const unsigned int _channels, std::array<unsigned char, 4> &_min,
+      std::array<unsigned char, 4> &_max, std::array<uint64_t, 4> &_sum)
+  {
+    std::size_t i = 0;
+#ifdef IGN_COMMON_IMAGE_SSE2
+    // The channels of a byte position repeat every vector, or every three
+    // vectors for three channel pixels
+    const std::size_t width = sizeof(Bytes);
+    const std::size_t vectors = _channels == 3u ? 3u : 1u;
+    const std::size_t period = width * vectors;
+    if (_count >= period)
+    {
+      Bytes masks[3][4];
+      Bytes mins[3];
+      Bytes maxs[3];
+      Bytes sums[3][4];
+      for (std::size_t v = 0; v < vectors; ++v)
+      {
+        for (unsigned int channel = 0; channel < _channels; ++channel)
+        {
+          alignas(16) unsigned char mask[sizeof(Bytes)];
+          for (std::size_t b = 0; b < width; ++b)
+            mask[b] = (v * width + b) % _channels == channel ? 0xffu : 0u;
+          masks[v][channel] = LoadBytes(mask);
+          sums[v][channel] = FillBytes(0u);
+        }
+        mins[v] = FillBytes(255u);
+        maxs[v] = FillBytes(0u);
+      }
+
+      for (; i + period <= _count; i += period)
+      {
+        for (std::size_t v = 0; v < vectors; ++v)
+        {
+          const Bytes value = LoadBytes(_src + i + v * width);
+          mins[v] = MinBytes(mins[v], value);
+          maxs[v] = MaxBytes(maxs[v], value);
+          for (unsigned int channel = 0; channel < _channels; ++channel)
+            sums[v][channel] = AddSums(sums[v][channel], value,
+                masks[v][channel]);
+        }
+      }
+
+      for (std::size_t v = 0; v < vectors; ++v)
+      {
+        alignas(16) unsigned char lanes[sizeof(Bytes)];
+        StoreBytes(mins[v], lanes);
+        for (std::size_t b = 0; b < width; ++b)
+        {
+          auto &min = _min[(v * width + b) % _channels];
+          min = std::min(min, lanes[b]);
+        }
+        StoreBytes(maxs[v], lanes);
+        for (std::size_t b = 0; b < width; ++b)
+        {
+          auto &max = _max[(v * width + b) % _channels];
+          max = std::max(max, lanes[b]);
+        }
+        for (unsigned int channel = 0; channel < _channels; ++channel)
+        {
+          alignas(16) uint64_t partial[sizeof(Bytes) / 8u];
+          StoreBytes(sums[v][channel],
+              reinterpret_cast<unsigned char *>(partial));
+          for (const uint64_t value : partial)
+            _sum[channel] += value;
+        }
+      }
+    }
+#endif
+
+    // The vectors covered whole pixels, so i is the first channel of one
+    for (; i < _count; ++i)
+    {
+      const unsigned int channel = static_cast<unsigned int>(i % _channels);
+      _min[channel] = std::min(_min[channel], _src[i]);
+      _max[channel] = std::max(_max[channel], _src[i]);
+      _sum[channel] += _src[i];
+    }
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Get the half width of a resampling filter
+  /// \param[in] _filter Filter
+  /// \return Distance from the center past which the filter is zero, in
+  /// input samples
+  double FilterSupport(const Image::ResampleFilter _filter)
+  {
+    switch (_filter)
+    {
+      case Image::ResampleFilter::BOX:
+        return 0.5;
+      case Image::ResampleFilter::BILINEAR:
+        return 1.0;
+      case Image::ResampleFilter::LANCZOS3:
+      default:
+        return 3.0;
+    }
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Evaluate a resampling filter
+  /// \param[in] _filter Filter
+  /// \param[in] _x Distance from the center, in input samples
+  /// \return Weight of a sample at that distance
+  double FilterWeight(const Image::ResampleFilter _filter, const double _x)
+  {
+    const double distance = std::abs(_x);
+    switch (_filter)
+    {
+      case Image::ResampleFilter::BOX:
+        // Half open, so that a sample is never counted twice
+        return _x >= -0.5 && _x < 0.5 ? 1.0 : 0.0;
+      case Image::ResampleFilter::BILINEAR:
+        return std::max(0.0, 1.0 - distance);
+      case Image::ResampleFilter::LANCZOS3:
+      default:
+      {
+        if (distance >= 3.0)
+          return 0.0;
+        if (distance < 1e-8)
+          return 1.0;
+        const double x = 3.14159265358979323846 * _x;
+        return 3.0 * std::sin(x) * std::sin(x / 3.0) / (x * x);
+      }
+    }
+  }
+
+}
+
+//////////////////////////////////////////////////
+std::size_t ignition::common::ScanlinePixelBytes(
+    const Image::PixelFormatType _format)
+{
+  const Layout layout = Describe(_format);
+  return layout.channels * layout.bytes;
+}
+
+//////////////////////////////////////////////////
+unsigned int ignition::common::ScanlineChannels(
+    const Image::PixelFormatType _format)
+{
+  return Describe(_format).channels;
+}
+
+//////////////////////////////////////////////////
+void ignition::common::ConvertScanline(const unsigned char *_src,
+    const Image::PixelFormatType _srcFormat, const std::size_t _width,
+    const Image::PixelFormatType _dstFormat, unsigned char *_dst)
+{
+  const Layout from = Describe(_srcFormat);
+  const Layout to = Describe(_dstFormat);
+  if (from.channels == 0u || to.channels == 0u)
+    return;
+
+  if (_srcFormat == _dstFormat)
+    std::memcpy(_dst, _src, _width * from.channels * from.bytes);
+  else if (from.bytes == 1u && to.bytes == 1u)
+    Convert8(_src, from, _width, to, _dst);
+  else
+    ConvertGeneric(_src, from, _width, to, _dst);
+}
+
+//////////////////////////////////////////////////
+std::size_t ignition::common::BrightestPixel(const unsigned char *_src,
+    const Image::PixelFormatType _format, const std::size_t _width,
+    unsigned int &_brightness)
+{
+  const Layout layout = Describe(_format);
+  const unsigned int channels = layout.channels;
+  std::size_t brightest = 0;
+  _brightness = 0;
+  for (std::size_t x = 0; x < _width; ++x)
+  {
+    const unsigned char *pixel = _src + x * channels;
+    const unsigned int brightness = channels == 1u ? pixel[0] :
+      pixel[layout.order[0]] + pixel[layout.order[1]] +
+      pixel[layout.order[2]];
+    if (brightness > _brightness || x == 0u)
+    {
+      _brightness = brightness;
+      brightest = x;
+    }
+  }
+  return brightest;
+}
+
+//////////////////////////////////////////////////
+ScanlineStatistics::ScanlineStatistics(const Image::PixelFormatType _format)
+  : format(_format)
+{
+  this->min.fill(std::numeric_limits<double>::infinity());
+  this->max.fill(-std::numeric_limits<double>::infinity());
+  this->sum.fill(0.0);
+  this->count.fill(0u);
+}
+
+//////////////////////////////////////////////////
+void ScanlineStatistics::Add(const unsigned char *_src,
+    const std::size_t _width)
+{
+  const Layout layout = Describe(this->format);
+  const unsigned int channels = layout.channels;
+  if (channels == 0u || _width == 0u)
+    return;
+
+  if (layout.bytes == 1u)
+  {
+    std::array<unsigned char, 4> min = {{255u, 255u, 255u, 255u}};
+    std::array<unsigned char, 4> max = {{0u, 0u, 0u, 0u}};
+    std::array<uint64_t, 4> sum = {{0u, 0u, 0u, 0u}};
+    Statistics8(_src, _width * channels, channels, min, max, sum);
+    for (unsigned int channel = 0; channel < channels; ++channel)
+    {
+      this->min[channel] = std::min<double>(this->min[channel], min[channel]);
+      this->max[channel] = std::max<double>(this->max[channel], max[channel]);
+      this->sum[channel] += static_cast<double>(sum[channel]);
+      this->count[channel] += _width;
+    }
+  }
+  else if (layout.bytes == 2u)
+  {
+    std::array<uint16_t, 4> min = {{65535u, 65535u, 65535u, 65535u}};
+    std::array<uint16_t, 4> max = {{0u, 0u, 0u, 0u}};
+    std::array<uint64_t, 4> sum = {{0u, 0u, 0u, 0u}};
+    for (std::size_t x = 0; x < _width; ++x)
+    {
+      for (unsigned int channel = 0; channel < channels; ++channel)
+      {
+        uint16_t value;
+        std::memcpy(&value, _src + (x * channels + channel) * 2u,
+            sizeof(value));
+        min[channel] = std::min(min[channel], value);
+        max[channel] = std::max(max[channel], value);
+        sum[channel] += value;
+      }
+    }
+    for (unsigned int channel = 0; channel < channels; ++channel)
+    {
+      this->min[channel] = std::min<double>(this->min[channel], min[channel]);
+      this->max[channel] = std::max<double>(this->max[channel], max[channel]);
+      this->sum[channel] += static_cast<double>(sum[channel]);
+      this->count[channel] += _width;
+    }
+  }
+  else
+  {
+    for (std::size_t x = 0; x < _width; ++x)
+    {
+      for (unsigned int channel = 0; channel < channels; ++channel)
+      {
+        float value;
+        std::memcpy(&value, _src + (x * channels + channel) * 4u,
+            sizeof(value));
+        if (!std::isfinite(value))
+          continue;
+        this->min[channel] = std::min<double>(this->min[channel], value);
+        this->max[channel] = std::max<double>(this->max[channel], value);
+        this->sum[channel] += value;
+        ++this->count[channel];
+      }
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void ScanlineStatistics::Merge(const ScanlineStatistics &_other)
+{
+  for (unsigned int channel = 0; channel < 4u; ++channel)
+  {
+    this->min[channel] = std::min(this->min[channel], _other.min[channel]);
+    this->max[channel] = std::max(this->max[channel], _other.max[channel]);
+    this->sum[channel] += _other.sum[channel];
+    this->count[channel] += _other.count[channel];
+  }
+}
+
+//////////////////////////////////////////////////
+Image::ChannelStatistics ScanlineStatistics::Result() const
+{
+  Image::ChannelStatistics result;
+  const Layout layout = Describe(this->format);
+  if (layout.channels == 0u || this->count[0] == 0u)
+    return result;
+
+  result.channels = layout.channels;
+  for (unsigned int color = 0; color < layout.channels; ++color)
+  {
+    // Luminance formats keep their single channel first
+    const int channel = layout.channels == 1u ? 0 : layout.order[color];
+    if (this->count[channel] == 0u)
+      continue;
+    result.min[color] = this->min[channel];
+    result.max[color] = this->max[channel];
+    result.mean[color] = this->sum[channel] / this->count[channel];
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+void ignition::common::ScanlineToFloat(const unsigned char *_src,
+    const Image::PixelFormatType _format, const std::size_t _width,
+    float *_dst)
+{
+  const Layout layout = Describe(_format);
+  const std::size_t count = _width * layout.channels;
+  if (layout.isFloat)
+  {
+    std::memcpy(_dst, _src, count * sizeof(float));
+    return;
+  }
+  if (layout.bytes == 2u)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      uint16_t value;
+      std::memcpy(&value, _src + i * 2u, sizeof(value));
+      _dst[i] = value;
+    }
+    return;
+  }
+
+  std::size_t i = 0;
+#ifdef IGN_COMMON_IMAGE_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16u <= count; i += 16u)
+  {
+    const __m128i bytes =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(_src + i));
+    const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+    _mm_storeu_ps(_dst + i, _mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)));
+    _mm_storeu_ps(_dst + i + 4u,
+        _mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)));
+    _mm_storeu_ps(_dst + i + 8u,
+        _mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)));
+    _mm_storeu_ps(_dst + i + 12u,
+        _mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)));
+  }
+#endif
+  for (; i < count; ++i)
+    _dst[i] = _src[i];
+}
+
+//////////////////////////////////////////////////
+void ignition::common::FloatToScanline(const float *_src,
+    const Image::PixelFormatType _format, const std::size_t _width,
+    unsigned char *_dst)
+{
+  const Layout layout = Describe(_format);
+  const std::size_t count = _width * layout.channels;
+  if (layout.isFloat)
+  {
+    std::memcpy(_dst, _src, count * sizeof(float));
+    return;
+  }
+
+  // Written so that NaN turns into 0. Rounding is to the nearest even
+  // integer, like the vector instructions.
+  const float top = layout.bytes == 2u ? 65535.0f : 255.0f;
+  auto clamp = [top](const float _value)
+  {
+    if (!(_value > 0.0f))
+      return 0.0f;
+    return std::nearbyint(std::min(_value, top));
+  };
+  if (layout.bytes == 2u)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const uint16_t value = static_cast<uint16_t>(clamp(_src[i]));
+      std::memcpy(_dst + i * 2u, &value, sizeof(value));
+    }
+    return;
+  }
+
+  std::size_t i = 0;
+#ifdef IGN_COMMON_IMAGE_SSE2
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 max = _mm_set1_ps(255.0f);
+  auto round = [&](const float *_values)
+  {
+    // max_ps returns its second operand for NaN
+    return _mm_cvtps_epi32(
+        _mm_min_ps(_mm_max_ps(_mm_loadu_ps(_values), zero), max));
+  };
+  for (; i + 16u <= count; i += 16u)
+  {
+    const __m128i low =
+      _mm_packs_epi32(round(_src + i), round(_src + i + 4u));
+    const __m128i high =
+      _mm_packs_epi32(round(_src + i + 8u), round(_src + i + 12u));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(_dst + i),
+        _mm_packus_epi16(low, high));
+  }
+#endif
+  for (; i < count; ++i)
+    _dst[i] = static_cast<unsigned char>(clamp(_src[i]));
+}
+
+//////////////////////////////////////////////////
+ResampleTaps::ResampleTaps(const std::size_t _srcSize,
+    const std::size_t _dstSize, const Image::ResampleFilter _filter)
+: sourceSize(_srcSize)
+{
+  // The filter is stretched to cover every input sample when shrinking
+  const double scale = static_cast<double>(_srcSize) / _dstSize;
+  const double stretch = std::max(1.0, scale);
+  const double radius = FilterSupport(_filter) * stretch;
+  this->count = std::min(_srcSize,
+      static_cast<std::size_t>(std::ceil(2.0 * radius)) + 1u);
+  this->first.resize(_dstSize);
+  this->weights.assign(_dstSize * this->count, 0.0f);
+
+  const long long last = static_cast<long long>(_srcSize) - 1;
+  for (std::size_t i = 0; i < _dstSize; ++i)
+  {
+    // Samples whose centers are within the radius. Those outside the
+    // input are folded onto its edges.
+    const double center = (i + 0.5) * scale;
+    const long long low =
+      static_cast<long long>(std::ceil(center - radius - 0.5));
+    const long long high =
+      static_cast<long long>(std::floor(center + radius - 0.5));
+    const long long start = std::max(0LL,
+        std::min(low, static_cast<long long>(_srcSize - this->count)));
+    this->first[i] = static_cast<std::size_t>(start);
+
+    float *taps = &this->weights[i * this->count];
+    double total = 0.0;
+    for (long long j = low; j <= high; ++j)
+    {
+      const double weight =
+        FilterWeight(_filter, (j + 0.5 - center) / stretch);
+      if (weight == 0.0)
+        continue;
+      const long long sample = std::max(0LL, std::min(j, last));
+      taps[sample - start] += static_cast<float>(weight);
+      total += weight;
+    }
+
+    if (std::abs(total) > 1e-12)
+    {
+      for (std::size_t k = 0; k < this->count; ++k)
+        taps[k] = static_cast<float>(taps[k] / total);
+    }
+    else
+    {
+      const long long nearest = std::max(0LL,
+          std::min(static_cast<long long>(center), last));
+      taps[nearest - start] = 1.0f;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+std::size_t ResampleTaps::SourceSize() const
+{
+  return this->sourceSize;
+}
+
+//////////////////////////////////////////////////
+std::size_t ResampleTaps::Count() const
+{
+  return this->count;
+}
+
+//////////////////////////////////////////////////
+std::size_t ResampleTaps::First(const std::size_t _index) const
+{
+  return this->first[_index];
+}
+
+//////////////////////////////////////////////////
+const float *ResampleTaps::Weights(const std::size_t _index) const
+{
+  return &this->weights[_index * this->count];
+}
+
+//////////////////////////////////////////////////
+void ignition::common::ResampleRow(const float *_src,
+    const unsigned int _channels, const ResampleTaps &_taps,
+    const std::size_t _width, float *_dst)
+{
+  const std::size_t count = _taps.Count();
+  for (std::size_t x = 0; x < _width; ++x)
+  {
+    const float *weights = _taps.Weights(x);
+    const float *in = _src + _taps.First(x) * _channels;
+    float *out = _dst + x * _channels;
+
+#ifdef IGN_COMMON_IMAGE_SSE2
+    // Pixels with 3 or 4 channels are added up as one vector. Vectors of
+    // 3 channel pixels hold the first channel of the next pixel, so the
+    // last pixel of a row is added apart, and the last output pixel is
+    // stored apart.
+    if (_channels == 4u || (_channels == 3u && count > 1u))
+    {
+      std::size_t vectors = count;
+      if (_channels == 3u &&
+          _taps.First(x) + count >= _taps.SourceSize())
+      {
+        vectors = count - 1u;
+      }
+      __m128 sum = _mm_setzero_ps();
+      for (std::size_t k = 0; k < vectors; ++k)
+      {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[k]),
+              _mm_loadu_ps(in + k * _channels)));
+      }
+      if (vectors == count && (_channels == 4u || x + 1u < _width))
+      {
+        _mm_storeu_ps(out, sum);
+        continue;
+      }
+      alignas(16) float lanes[4];
+      _mm_store_ps(lanes, sum);
+      for (std::size_t k = vectors; k < count; ++k)
+      {
+        for (unsigned int c = 0; c < 3u; ++c)
+          lanes[c] += weights[k] * in[k * 3u + c];
+      }
+      std::memcpy(out, lanes, _channels * sizeof(float));
+      continue;
+    }
+
+    // Single channels are a dot product over the taps
+    if (_channels == 1u)
+    {
+      __m128 sum = _mm_setzero_ps();
+      std::size_t k = 0;
+      for (; k + 4u <= count; k += 4u)
+      {
+        sum = _mm_add_ps(sum,
+            _mm_mul_ps(_mm_loadu_ps(weights + k), _mm_loadu_ps(in + k)));
+      }
+      alignas(16) float lanes[4];
+      _mm_store_ps(lanes, sum);
+      float total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+      for (; k < count; ++k)
+        total += weights[k] * in[k];
+      out[0] = total;
+      continue;
+    }
+#endif
+
+    std::array<float, 4> sum = {{0.0f, 0.0f, 0.0f, 0.0f}};
+    for (std::size_t k = 0; k < count; ++k)
+    {
+      for (unsigned int c = 0; c < _channels; ++c)
+        sum[c] += weights[k] * in[k * _channels + c];
+    }
+    std::memcpy(out, sum.data(), _channels * sizeof(float));
+  }
+}
+
+//////////////////////////////////////////////////
+void ignition::common::BlendRows(const float *const *_rows,
+    const float *_weights, const std::size_t _count, const std::size_t _size,
+    float *_dst)
+{
+  std::size_t i = 0;
+#ifdef IGN_COMMON_IMAGE_SSE2
+  for (; i + 4u <= _size; i += 4u)
+  {
+    __m128 sum = _mm_setzero_ps();
+    for (std::size_t k = 0; k < _count; ++k)
+    {
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(_weights[k]),
+            _mm_loadu_ps(_rows[k] + i)));
+    }
+    _mm_storeu_ps(_dst + i, sum);
+  }
+#endif
+  for (; i < _size; ++i)
+  {
+    float sum = 0.0f;
+    for (std::size_t k = 0; k < _count; ++k)
+      sum += _weights[k] * _rows[k][i];
+    _dst[i] = sum;
+  }
+}
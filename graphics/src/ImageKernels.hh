@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGNITION_COMMON_IMAGEKERNELS_HH_
+#define IGNITION_COMMON_IMAGEKERNELS_HH_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ignition/common/Image.hh"
+
+namespace ignition
+{
+  namespace common
+  {
+    /// \brief Get the size of a pixel in the formats handled by the
+    /// scanline kernels.
+    /// \param[in] _format Pixel format.
+    /// \return Number of bytes, or 0 if the format is not handled.
+    std::size_t ScanlinePixelBytes(const Image::PixelFormatType _format);
+
+    /// \brief Get the number of channels of a pixel in the formats handled
+    /// by the scanline kernels.
+    /// \param[in] _format Pixel format.
+    /// \return Number of channels, or 0 if the format is not handled.
+    unsigned int ScanlineChannels(const Image::PixelFormatType _format);
+
+    /// \brief Convert a scanline between two pixel formats handled by the
+    /// scanline kernels.
+    /// \param[in] _src Pixels to convert.
+    /// \param[in] _srcFormat Pixel format of _src.
+    /// \param[in] _width Number of pixels.
+    /// \param[in] _dstFormat Pixel format of _dst.
+    /// \param[out] _dst Converted pixels. Must not overlap _src.
+    void ConvertScanline(const unsigned char *_src,
+        const Image::PixelFormatType _srcFormat, const std::size_t _width,
+        const Image::PixelFormatType _dstFormat, unsigned char *_dst);
+
+    /// \brief Find the brightest pixel of a scanline of 8 bit pixels, the
+    /// one whose color channels add up to the most.
+    /// \param[in] _src Pixels.
+    /// \param[in] _format Pixel format of _src, with 8 bit channels.
+    /// \param[in] _width Number of pixels.
+    /// \param[out] _brightness Sum of the color channels of the pixel.
+    /// \return Index of the first of the brightest pixels.
+    std::size_t BrightestPixel(const unsigned char *_src,
+        const Image::PixelFormatType _format, const std::size_t _width,
+        unsigned int &_brightness);
+
+    /// \brief Read the channels of a scanline as floats, in the units of
+    /// its pixel format.
+    /// \param[in] _src Pixels.
+    /// \param[in] _format Pixel format of _src.
+    /// \param[in] _width Number of pixels.
+    /// \param[out] _dst Channels of the pixels, in memory order.
+    void ScanlineToFloat(const unsigned char *_src,
+        const Image::PixelFormatType _format, const std::size_t _width,
+        float *_dst);
+
+    /// \brief Write channels in the units of a pixel format to a scanline.
+    /// Integer channels are rounded and clamped to their range.
+    /// \param[in] _src Channels of the pixels, in memory order.
+    /// \param[in] _format Pixel format of _dst.
+    /// \param[in] _width Number of pixels.
+    /// \param[out] _dst Pixels.
+    void FloatToScanline(const float *_src,
+        const Image::PixelFormatType _format, const std::size_t _width,
+        unsigned char *_dst);
+
+    /// \brief Weights of the samples that make up every sample of an axis
+    /// resampled with a filter. Every output sample has the same number of
+    /// taps on consecutive input samples, and taps past the edges are
+    /// folded onto the edge samples.
+    class ResampleTaps
+    {
+      /// \brief Constructor
+      /// \param[in] _srcSize Number of input samples, at least 1.
+      /// \param[in] _dstSize Number of output samples, at least 1.
+      /// \param[in] _filter Filter.
+      public: ResampleTaps(const std::size_t _srcSize,
+                  const std::size_t _dstSize,
+                  const Image::ResampleFilter _filter);
+
+      /// \brief Get the number of input samples.
+      /// \return Number of input samples.
+      public: std::size_t SourceSize() const;
+
+      /// \brief Get the number of taps of every output sample.
+      /// \return Number of taps.
+      public: std::size_t Count() const;
+
+      /// \brief Get the first input sample of an output sample.
+      /// \param[in] _index Output sample.
+      /// \return Index of the input sample of the first tap.
+      public: std::size_t First(const std::size_t _index) const;
+
+      /// \brief Get the weights of the taps of an output sample.
+      /// \param[in] _index Output sample.
+      /// \return Count() weights, which add up to 1.
+      public: const float *Weights(const std::size_t _index) const;
+
+      /// \brief Number of input samples
+      private: std::size_t sourceSize;
+
+      /// \brief Number of taps of every output sample
+      private: std::size_t count;
+
+      /// \brief First input sample of every output sample
+      private: std::vector<std::size_t> first;
+
+      /// \brief Weights of the taps of every output sample
+      private: std::vector<float> weights;
+    };
+
+    /// \brief Resample a row of pixels with float channels.
+    /// \param[in] _src Channels of the input pixels.
+    /// \param[in] _channels Number of channels per pixel.
+    /// \param[in] _taps Taps from the input to the output pixels.
+    /// \param[in] _width Number of output pixels.
+    /// \param[out] _dst Channels of the output pixels.
+    void ResampleRow(const float *_src, const unsigned int _channels,
+        const ResampleTaps &_taps, const std::size_t _width, float *_dst);
+
+    /// \brief Add up rows of floats with weights.
+    /// \param[in] _rows Rows to add up.
+    /// \param[in] _weights Weight of every row.
+    /// \param[in] _count Number of rows.
+    /// \param[in] _size Number of floats per row.
+    /// \param[out] _dst Weighted sum of the rows.
+    void BlendRows(const float *const *_rows, const float *_weights,
+        const std::size_t _count, const std::size_t _size, float *_dst);
+
+    /// \brief Accumulates the statistics of the channels of scanlines.
+    class ScanlineStatistics
+    {
+      /// \brief Constructor
+      /// \param[in] _format Pixel format of the scanlines.
+      public: explicit ScanlineStatistics(
+                  const Image::PixelFormatType _format);
+
+      /// \brief Add the pixels of a scanline.
+      /// \param[in] _src Pixels.
+      /// \param[in] _width Number of pixels.
+      public: void Add(const unsigned char *_src, const std::size_t _width);
+
+      /// \brief Add the pixels accumulated by another instance for the
+      /// same pixel format.
+      /// \param[in] _other Other statistics.
+      public: void Merge(const ScanlineStatistics &_other);
+
+      /// \brief Get the statistics of all the pixels added so far.
+      /// \return The statistics.
+      public: Image::ChannelStatistics Result() const;
+
+      /// \brief Pixel format of the scanlines
+      private: Image::PixelFormatType format;
+
+      /// \brief Smallest value of every channel, in memory order
+      private: std::array<double, 4> min;
+
+      /// \brief Largest value of every channel, in memory order
+      private: std::array<double, 4> max;
+
+      /// \brief Sum of every channel, in memory order
+      private: std::array<double, 4> sum;
+
+      /// \brief Number of values added to every channel
+      private: std::array<uint64_t, 4> count;
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,384 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "ignition/common/Console.hh"
+#include "ignition/common/Image.hh"
+#include "ignition/common/ImageLoader.hh"
+#include "ignition/common/Material.hh"
+#include "ignition/common/Parallel.hh"
+#include "ignition/common/Pbr.hh"
+#include "ignition/common/Util.hh"
+
+using namespace ignition;
+using namespace common;
+
+namespace
+{
+  /// \brief Default capacity of the cache, in bytes
+  const std::size_t kDefaultCacheCapacity = 256u * 1024u * 1024u;
+
+  /// \brief An image file that is being decoded. Shared by every request
+  /// for the same file until the image is in the cache.
+  class PendingImage
+  {
+    /// \brief Set by the thread that decodes the file
+    public: std::atomic<bool> claimed{false};
+
+    /// \brief Receives the image, or nullptr on failure
+    public: std::promise<std::shared_ptr<const Image>> promise;
+
+    /// \brief Future of promise, shared by all the requests
+    public: std::shared_future<std::shared_ptr<const Image>> result =
+              promise.get_future().share();
+  };
+
+  /// \brief An image in the cache
+  class CachedImage
+  {
+    /// \brief Resolved path of the image file
+    public: std::string path;
+
+    /// \brief The image
+    public: std::shared_ptr<const Image> image;
+
+    /// \brief Number of bytes of pixels of the image
+    public: std::size_t bytes = 0u;
+  };
+
+  /// \brief State of a batch, shared by the tasks that load its images
+  class BatchState
+  {
+    /// \brief Serializes the callbacks and protects done
+    public: std::mutex mutex;
+
+    /// \brief Number of images loaded or failed
+    public: std::size_t done = 0u;
+
+    /// \brief Called with every image
+    public: ImageLoader::ImageCallback onImage;
+
+    /// \brief Called after every image
+    public: ImageLoader::ProgressCallback onProgress;
+  };
+}
+
+/// \brief Private data for the ImageLoader class
+class ignition::common::ImageLoader::Implementation
+{
+  /// \brief Add an image to the cache, then drop the least recently used
+  /// images until the cache fits its capacity. The mutex must be held.
+  /// \param[in] _path Resolved path of the image file
+  /// \param[in] _image The image
+  public: void Insert(const std::string &_path,
+              const std::shared_ptr<const Image> &_image);
+
+  /// \brief Drop the least recently used images until the cache fits its
+  /// capacity. The mutex must be held.
+  public: void Evict();
+
+  /// \brief Protects every other member
+  public: mutable std::mutex mutex;
+
+  /// \brief Cached images, most recently used first
+  public: std::list<CachedImage> cache;
+
+  /// \brief Cached images, indexed by path
+  public: std::unordered_map<std::string, std::list<CachedImage>::iterator>
+              index;
+
+  /// \brief Images that are being decoded, indexed by path
+  public: std::unordered_map<std::string, std::shared_ptr<PendingImage>>
+              pending;
+
+  /// \brief Maximum number of bytes held by the cache
+  public: std::size_t capacity = kDefaultCacheCapacity;
+
+  /// \brief Number of bytes held by the cache
+  public: std::size_t size = 0u;
+};
+
+//////////////////////////////////////////////////
+ImageLoader::ImageLoader()
+: dataPtr(ignition::utils::MakeUniqueImpl<Implementation>())
+{
+}
+
+//////////////////////////////////////////////////
+ImageLoader::~ImageLoader()
+{
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const Image> ImageLoader::Load(const std::string &_filename)
+{
+  const std::string path = common::findFile(_filename);
+  if (path.empty())
+  {
+    ignerr << "Unable to find image[" << _filename << "]\n";
+    return nullptr;
+  }
+
+  std::shared_ptr<PendingImage> load;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+    auto cached = this->dataPtr->index.find(path);
+    if (cached != this->dataPtr->index.end())
+    {
+      auto &cache = this->dataPtr->cache;
+      cache.splice(cache.begin(), cache, cached->second);
+      return cached->second->image;
+    }
+
+    auto &pending = this->dataPtr->pending[path];
+    if (!pending)
+      pending = std::make_shared<PendingImage>();
+    load = pending;
+  }
+
+  // The first request decodes the file, the others wait for it. A request
+  // that finds the load unclaimed decodes it itself rather than wait, so
+  // that a worker waiting on a queued load can't deadlock.
+  if (!load->claimed.exchange(true))
+  {
+    std::shared_ptr<const Image> result;
+    try
+    {
+      auto image = std::make_shared<Image>();
+      if (image->Load(path) == 0 && image->Valid())
+        result = image;
+      else
+        ignerr << "Unable to decode image[" << path << "]\n";
+    }
+    catch(...)
+    {
+      // Waiting threads get the exception too, and later requests try
+      // again
+      {
+        std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+        this->dataPtr->pending.erase(path);
+      }
+      load->promise.set_exception(std::current_exception());
+      throw;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+      if (result)
+        this->dataPtr->Insert(path, result);
+      // Failures are not remembered, so a later request tries again
+      this->dataPtr->pending.erase(path);
+    }
+    load->promise.set_value(result);
+  }
+  return load->result.get();
+}
+
+//////////////////////////////////////////////////
+TaskFuture<std::shared_ptr<const Image>> ImageLoader::LoadAsync(
+    const std::string &_filename)
+{
+  return ParallelWorkerPool().Submit([this, _filename]
+      {
+        return this->Load(_filename);
+      });
+}
+
+//////////////////////////////////////////////////
+TaskFuture<std::vector<std::shared_ptr<const Image>>> ImageLoader::LoadBatch(
+    const std::vector<std::string> &_filenames,
+    const ImageCallback &_onImage, const ProgressCallback &_onProgress)
+{
+  auto batch = std::make_shared<BatchState>();
+  batch->onImage = _onImage;
+  batch->onProgress = _onProgress;
+
+  // One task per image, so that the pool spreads them over its workers
+  const std::size_t total = _filenames.size();
+  std::vector<TaskFuture<std::shared_ptr<const Image>>> images;
+  std::vector<TaskHandle> handles;
+  images.reserve(total);
+  handles.reserve(total);
+  for (std::size_t i = 0; i < total; ++i)
+  {
+    images.push_back(ParallelWorkerPool().Submit(
+        [this, batch, i, total, filename = _filenames[i]]
+        {
+          // A file that makes the decoder throw must not stop the others
+          std::shared_ptr<const Image> image;
+          try
+          {
+            image = this->Load(filename);
+          }
+          catch(const std::exception &_e)
+          {
+            ignerr << "Unable to load image[" << filename << "]: "
+                   << _e.what() << "\n";
+          }
+          catch(...)
+          {
+            ignerr << "Unable to load image[" << filename << "]\n";
+          }
+          std::lock_guard<std::mutex> lock(batch->mutex);
+          ++batch->done;
+          if (batch->onImage)
+            batch->onImage(i, filename, image);
+          if (batch->onProgress)
+            batch->onProgress(batch->done, total);
+          return image;
+        }));
+    handles.push_back(images.back());
+  }
+
+  return ParallelWorkerPool().SubmitAfter(handles, [images]
+      {
+        std::vector<std::shared_ptr<const Image>> result;
+        result.reserve(images.size());
+        for (const auto &image : images)
+          result.push_back(image.Get());
+        return result;
+      });
+}
+
+//////////////////////////////////////////////////
+TaskFuture<std::vector<std::shared_ptr<const Image>>>
+ImageLoader::LoadTextures(const Material &_material,
+    const ImageCallback &_onImage, const ProgressCallback &_onProgress)
+{
+  return this->LoadBatch(TexturePaths(_material), _onImage, _onProgress);
+}
+
+//////////////////////////////////////////////////
+std::vector<std::string> ImageLoader::TexturePaths(const Material &_material)
+{
+  std::vector<std::string> paths;
+  auto add = [&paths](const std::string &_path)
+  {
+    if (!_path.empty() &&
+        std::find(paths.begin(), paths.end(), _path) == paths.end())
+    {
+      paths.push_back(_path);
+    }
+  };
+
+  add(_material.TextureImage());
+  const Pbr *pbr = _material.PbrMaterial();
+  if (pbr)
+  {
+    add(pbr->AlbedoMap());
+    add(pbr->NormalMap());
+    add(pbr->RoughnessMap());
+    add(pbr->MetalnessMap());
+    add(pbr->AmbientOcclusionMap());
+    add(pbr->EmissiveMap());
+    add(pbr->LightMap());
+    add(pbr->EnvironmentMap());
+    add(pbr->GlossinessMap());
+    add(pbr->SpecularMap());
+  }
+  return paths;
+}
+
+//////////////////////////////////////////////////
+void ImageLoader::SetCacheCapacity(const std::size_t _bytes)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->capacity = _bytes;
+  this->dataPtr->Evict();
+}
+
+//////////////////////////////////////////////////
+std::size_t ImageLoader::CacheCapacity() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->capacity;
+}
+
+//////////////////////////////////////////////////
+std::size_t ImageLoader::CacheSize() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->size;
+}
+
+//////////////////////////////////////////////////
+std::size_t ImageLoader::CachedImageCount() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->cache.size();
+}
+
+//////////////////////////////////////////////////
+bool ImageLoader::IsCached(const std::string &_filename) const
+{
+  const std::string path = common::findFile(_filename);
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->index.count(path) > 0u;
+}
+
+//////////////////////////////////////////////////
+void ImageLoader::ClearCache()
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->cache.clear();
+  this->dataPtr->index.clear();
+  this->dataPtr->size = 0u;
+}
+
+//////////////////////////////////////////////////
+void ImageLoader::Implementation::Insert(const std::string &_path,
+    const std::shared_ptr<const Image> &_image)
+{
+  const std::size_t bytes =
+    static_cast<std::size_t>(_image->Pitch()) * _image->Height();
+  if (bytes > this->capacity)
+    return;
+
+  auto existing = this->index.find(_path);
+  if (existing != this->index.end())
+  {
+    this->size -= existing->second->bytes;
+    this->cache.erase(existing->second);
+    this->index.erase(existing);
+  }
+
+  this->cache.push_front(CachedImage{_path, _image, bytes});
+  this->index[_path] = this->cache.begin();
+  this->size += bytes;
+  this->Evict();
+}
+
+//////////////////////////////////////////////////
+void ImageLoader::Implementation::Evict()
+{
+  while (this->size > this->capacity && !this->cache.empty())
+  {
+    const CachedImage &oldest = this->cache.back();
+    this->size -= oldest.bytes;
+    this->index.erase(oldest.path);
+    this->cache.pop_back();
+  }
+}
@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test_config.h"
+#include "ignition/common/Filesystem.hh"
+#include "ignition/common/Image.hh"
+#include "ignition/common/ImageLoader.hh"
+#include "ignition/common/Material.hh"
+#include "ignition/common/Pbr.hh"
+
+using namespace ignition;
+
+class ImageLoaderTest : public common::testing::AutoLogFixture
+{
+  /// \brief Empty the cache and restore its capacity
+  protected: void SetUp() override
+  {
+    common::testing::AutoLogFixture::SetUp();
+    common::ImageLoader::Instance()->ClearCache();
+    common::ImageLoader::Instance()->SetCacheCapacity(256u * 1024u * 1024u);
+  }
+};
+
+/////////////////////////////////////////////////
+TEST_F(ImageLoaderTest, Load)
+{
+  auto loader = common::ImageLoader::Instance();
+  const std::string path =
+    common::testing::TestFile("data", "red_blue_colors.png");
+
+  EXPECT_FALSE(loader->IsCached(path));
+  std::shared_ptr<const common::Image> image = loader->Load(path);
+  ASSERT_NE(nullptr, image);
+  EXPECT_TRUE(image->Valid());
+  EXPECT_EQ(121u, image->Width());
+  EXPECT_EQ(81u, image->Height());
+  EXPECT_TRUE(loader->IsCached(path));
+  EXPECT_EQ(1u, loader->CachedImageCount());
+  EXPECT_EQ(static_cast<std::size_t>(image->Pitch()) * image->Height(),
+      loader->CacheSize());
+
+  // Shared images are decoded once
+  EXPECT_EQ(image, loader->Load(path));
+  EXPECT_EQ(image, loader->LoadAsync(path).Get());
+
+  EXPECT_EQ(nullptr, loader->Load(path + ".missing"));
+  EXPECT_EQ(nullptr, loader->LoadAsync("missing.png").Get());
+  EXPECT_EQ(1u, loader->CachedImageCount());
+
+  // Cleared images stay valid for their users
+  loader->ClearCache();
+  EXPECT_EQ(0u, loader->CachedImageCount());
+  EXPECT_EQ(0u, loader->CacheSize());
+  EXPECT_EQ(121u, image->Width());
+  std::shared_ptr<const common::Image> reloaded = loader->Load(path);
+  ASSERT_NE(nullptr, reloaded);
+  EXPECT_NE(image, reloaded);
+}
+
+/////////////////////////////////////////////////
+TEST_F(ImageLoaderTest, Batch)
+{
+  auto loader = common::ImageLoader::Instance();
+  const std::vector<std::string> paths =
+  {
+    common::testing::TestFile("data", "heightmap_flat_129x129.png"),
+    common::testing::TestFile("data", "red_blue_colors.png"),
+    common::testing::TestFile("data", "missing.png"),
+    common::testing::TestFile("data", "heightmap_bowl.png"),
+    common::testing::TestFile("data", "red_blue_colors.png"),
+    common::testing::TestFile("data", "heightmap_flat_257x257.png"),
+  };
+
+  std::mutex mutex;
+  std::vector<std::size_t> indices;
+  std::vector<std::size_t> progress;
+  std::atomic<int> concurrent{0};
+  std::atomic<bool> overlapped{false};
+  auto result = loader->LoadBatch(paths,
+      [&](const std::size_t _index, const std::string &_filename,
+          const std::shared_ptr<const common::Image> &_image)
+      {
+        if (concurrent++ != 0)
+          overlapped = true;
+        std::lock_guard<std::mutex> lock(mutex);
+        indices.push_back(_index);
+        EXPECT_EQ(paths[_index], _filename);
+        EXPECT_EQ(_index == 2u, _image == nullptr);
+        --concurrent;
+      },
+      [&](const std::size_t _done, const std::size_t _total)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        progress.push_back(_done);
+        EXPECT_EQ(paths.size(), _total);
+      }).Get();
+
+  ASSERT_EQ(paths.size(), result.size());
+  EXPECT_FALSE(overlapped);
+  EXPECT_EQ(nullptr, result[2]);
+  EXPECT_EQ(129u, result[0]->Width());
+  EXPECT_EQ(257u, result[5]->Width());
+  EXPECT_EQ(result[1], result[4]);
+  EXPECT_EQ(4u, loader->CachedImageCount());
+
+  ASSERT_EQ(paths.size(), indices.size());
+  ASSERT_EQ(paths.size(), progress.size());
+  for (std::size_t i = 0; i < progress.size(); ++i)
+    EXPECT_EQ(i + 1u, progress[i]);
+
+  // Cached images are handed out again
+  auto again = loader->LoadBatch({paths[0], paths[1]}).Get();
+  ASSERT_EQ(2u, again.size());
+  EXPECT_EQ(result[0], again[0]);
+  EXPECT_EQ(result[1], again[1]);
+
+  EXPECT_TRUE(loader->LoadBatch({}).Get().empty());
+}
+
+/////////////////////////////////////////////////
+TEST_F(ImageLoaderTest, Eviction)
+{
+  auto loader = common::ImageLoader::Instance();
+  const std::string small =
+    common::testing::TestFile("data", "red_blue_colors.png");
+  const std::string medium =
+    common::testing::TestFile("data", "heightmap_flat_129x129.png");
+  const std::string large =
+    common::testing::TestFile("data", "heightmap_flat_257x257.png");
+
+  auto smallImage = loader->Load(small);
+  auto mediumImage = loader->Load(medium);
+  ASSERT_NE(nullptr, smallImage);
+  ASSERT_NE(nullptr, mediumImage);
+  const std::size_t smallBytes =
+    static_cast<std::size_t>(smallImage->Pitch()) * smallImage->Height();
+  const std::size_t mediumBytes =
+    static_cast<std::size_t>(mediumImage->Pitch()) * mediumImage->Height();
+  EXPECT_EQ(smallBytes + mediumBytes, loader->CacheSize());
+
+  // Using the small image makes the medium one the least recently used
+  loader->Load(small);
+  auto largeImage = loader->Load(large);
+  ASSERT_NE(nullptr, largeImage);
+  const std::size_t largeBytes =
+    static_cast<std::size_t>(largeImage->Pitch()) * largeImage->Height();
+  loader->SetCacheCapacity(smallBytes + largeBytes);
+  EXPECT_EQ(smallBytes + largeBytes, loader->CacheCapacity());
+  EXPECT_TRUE(loader->IsCached(small));
+  EXPECT_FALSE(loader->IsCached(medium));
+  EXPECT_TRUE(loader->IsCached(large));
+  EXPECT_EQ(smallBytes + largeBytes, loader->CacheSize());
+
+  // Images larger than the capacity are handed out without being cached
+  loader->Load(small);
+  loader->SetCacheCapacity(smallBytes);
+  EXPECT_EQ(1u, loader->CachedImageCount());
+  EXPECT_TRUE(loader->IsCached(small));
+  auto uncached = loader->Load(large);
+  ASSERT_NE(nullptr, uncached);
+  EXPECT_FALSE(loader->IsCached(large));
+  EXPECT_TRUE(loader->IsCached(small));
+
+  loader->SetCacheCapacity(0u);
+  EXPECT_EQ(0u, loader->CachedImageCount());
+  EXPECT_NE(nullptr, loader->Load(small));
+  EXPECT_EQ(0u, loader->CacheSize());
+}
+
+/////////////////////////////////////////////////
+TEST_F(ImageLoaderTest, Textures)
+{
+  const std::string red =
+    common::testing::TestFile("data", "red_blue_colors.png");
+  const std::string bowl =
+    common::testing::TestFile("data", "heightmap_bowl.png");
+
+  common::Material material;
+  EXPECT_TRUE(common::ImageLoader::TexturePaths(material).empty());
+
+  material.SetTextureImage(red);
+  common::Pbr pbr;
+  pbr.SetAlbedoMap(red);
+  pbr.SetNormalMap(bowl);
+  pbr.SetRoughnessMap(bowl);
+  material.SetPbrMaterial(pbr);
+
+  const std::vector<std::string> paths =
+    common::ImageLoader::TexturePaths(material);
+  ASSERT_EQ(2u, paths.size());
+  EXPECT_EQ(red, paths[0]);
+  EXPECT_EQ(bowl, paths[1]);
+
+  std::size_t done = 0u;
+  auto images = common::ImageLoader::Instance()->LoadTextures(material,
+      common::ImageLoader::ImageCallback(),
+      [&done](const std::size_t _done, const std::size_t)
+      {
+        done = _done;
+      }).Get();
+  ASSERT_EQ(2u, images.size());
+  EXPECT_NE(nullptr, images[0]);
+  EXPECT_NE(nullptr, images[1]);
+  EXPECT_EQ(2u, done);
+}
+
+/////////////////////////////////////////////////
+TEST_F(ImageLoaderTest, BadFile)
+{
+  auto loader = common::ImageLoader::Instance();
+  const std::string path = common::testing::TempPath("image_bad.png");
+  ASSERT_TRUE(common::createDirectories(common::parentPath(path)));
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << "\x89PNG\r\n\x1a\n not an image";
+  }
+
+  // Concurrent requests for the same file share its failure, and none of
+  // them is left waiting
+  std::atomic<bool> start{false};
+  std::shared_ptr<const common::Image> images[2] = {
+    std::make_shared<common::Image>(), std::make_shared<common::Image>()};
+  std::vector<std::thread> threads;
+  for (auto &image : images)
+  {
+    threads.emplace_back([&]
+        {
+          while (!start)
+            std::this_thread::yield();
+          image = loader->Load(path);
+        });
+  }
+  start = true;
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_EQ(nullptr, images[0]);
+  EXPECT_EQ(nullptr, images[1]);
+  EXPECT_FALSE(loader->IsCached(path));
+
+  // Failures are not remembered, so a fixed file is loaded
+  ASSERT_TRUE(common::copyFile(
+      common::testing::TestFile("data", "red_blue_colors.png"), path));
+  std::shared_ptr<const common::Image> fixed = loader->Load(path);
+  ASSERT_NE(nullptr, fixed);
+  EXPECT_EQ(121u, fixed->Width());
+  EXPECT_TRUE(loader->IsCached(path));
+
+  common::removeFile(path);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
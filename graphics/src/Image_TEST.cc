@@ -17,6 +17,13 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
 #include <ignition/common/Image.hh>
 #include "test_config.h"
 
@@ -521,6 +528,430 @@ TEST_F(ImageTest, ConvertToRGBImage)
   }
 }
 
+/////////////////////////////////////////////////
+TEST_F(ImageTest, ConvertPixels)
+{
+  using Image = common::Image;
+
+  // Odd width, so vectorized kernels also process a tail
+  const unsigned int width = 37u;
+  const unsigned int height = 3u;
+  const unsigned int count = width * height;
+  std::vector<unsigned char> rgba(count * 4u);
+  for (unsigned int i = 0; i < rgba.size(); ++i)
+    rgba[i] = static_cast<unsigned char>((i * 37u + 11u) % 256u);
+
+  std::vector<unsigned char> bgr(count * 3u);
+  ASSERT_TRUE(Image::ConvertPixels(rgba.data(), Image::RGBA_INT8, width,
+        height, Image::BGR_INT8, bgr.data()));
+  std::vector<unsigned char> bgra(count * 4u);
+  ASSERT_TRUE(Image::ConvertPixels(rgba.data(), Image::RGBA_INT8, width,
+        height, Image::BGRA_INT8, bgra.data()));
+  std::vector<unsigned char> gray(count);
+  ASSERT_TRUE(Image::ConvertPixels(bgr.data(), Image::BGR_INT8, width,
+        height, Image::L_INT8, gray.data()));
+  std::vector<unsigned char> gray16(count * 2u);
+  ASSERT_TRUE(Image::ConvertPixels(gray.data(), Image::L_INT8, width,
+        height, Image::L_INT16, gray16.data()));
+  std::vector<unsigned char> rgbf(count * 3u * sizeof(float));
+  ASSERT_TRUE(Image::ConvertPixels(bgra.data(), Image::BGRA_INT8, width,
+        height, Image::RGB_FLOAT32, rgbf.data()));
+  std::vector<unsigned char> rgb(count * 3u);
+  ASSERT_TRUE(Image::ConvertPixels(rgbf.data(), Image::RGB_FLOAT32, width,
+        height, Image::RGB_INT8, rgb.data()));
+
+  const uint16_t *gray16Data =
+    reinterpret_cast<const uint16_t *>(gray16.data());
+  const float *rgbfData = reinterpret_cast<const float *>(rgbf.data());
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    const unsigned char r = rgba[i * 4u];
+    const unsigned char g = rgba[i * 4u + 1u];
+    const unsigned char b = rgba[i * 4u + 2u];
+    const unsigned char a = rgba[i * 4u + 3u];
+    EXPECT_EQ(b, bgr[i * 3u]);
+    EXPECT_EQ(g, bgr[i * 3u + 1u]);
+    EXPECT_EQ(r, bgr[i * 3u + 2u]);
+    EXPECT_EQ(b, bgra[i * 4u]);
+    EXPECT_EQ(a, bgra[i * 4u + 3u]);
+    EXPECT_EQ((77u * r + 150u * g + 29u * b + 128u) >> 8, gray[i]);
+    EXPECT_EQ(gray[i] * 257u, gray16Data[i]);
+    EXPECT_FLOAT_EQ(r / 255.0f, rgbfData[i * 3u]);
+    EXPECT_FLOAT_EQ(b / 255.0f, rgbfData[i * 3u + 2u]);
+    EXPECT_EQ(r, rgb[i * 3u]);
+    EXPECT_EQ(g, rgb[i * 3u + 1u]);
+    EXPECT_EQ(b, rgb[i * 3u + 2u]);
+  }
+
+  // Unsupported formats
+  EXPECT_FALSE(Image::ConvertPixels(rgba.data(), Image::BAYER_RGGB8, width,
+        height, Image::RGB_INT8, rgb.data()));
+  EXPECT_FALSE(Image::ConvertPixels(rgba.data(), Image::RGBA_INT8, width,
+        height, Image::RGB_FLOAT16, rgb.data()));
+}
+
+/////////////////////////////////////////////////
+TEST_F(ImageTest, Statistics)
+{
+  using Image = common::Image;
+
+  const unsigned int width = 37u;
+  const unsigned int height = 5u;
+  std::vector<unsigned char> bgra(width * height * 4u);
+  for (unsigned int i = 0; i < width * height; ++i)
+  {
+    bgra[i * 4u] = static_cast<unsigned char>(i % 200u);
+    bgra[i * 4u + 1u] = 7u;
+    bgra[i * 4u + 2u] = static_cast<unsigned char>(10u + i % 2u);
+    bgra[i * 4u + 3u] = 255u;
+  }
+  double blueSum = 0;
+  for (unsigned int i = 0; i < width * height; ++i)
+    blueSum += i % 200u;
+
+  Image::ChannelStatistics statistics =
+    Image::Statistics(bgra.data(), width, height, Image::BGRA_INT8);
+  EXPECT_EQ(4u, statistics.channels);
+  EXPECT_DOUBLE_EQ(10.0, statistics.min[0]);
+  EXPECT_DOUBLE_EQ(11.0, statistics.max[0]);
+  EXPECT_DOUBLE_EQ(7.0, statistics.min[1]);
+  EXPECT_DOUBLE_EQ(7.0, statistics.mean[1]);
+  EXPECT_DOUBLE_EQ(0.0, statistics.min[2]);
+  EXPECT_DOUBLE_EQ(184.0, statistics.max[2]);
+  EXPECT_DOUBLE_EQ(blueSum / (width * height), statistics.mean[2]);
+  EXPECT_DOUBLE_EQ(255.0, statistics.mean[3]);
+
+  // Values that are not finite are ignored
+  const std::vector<float> values =
+    {1.0f, -2.0f, std::numeric_limits<float>::infinity(), 4.0f,
+     std::numeric_limits<float>::quiet_NaN(), 3.0f};
+  statistics = Image::Statistics(
+      reinterpret_cast<const unsigned char *>(values.data()), 3u, 2u,
+      Image::R_FLOAT32);
+  EXPECT_EQ(1u, statistics.channels);
+  EXPECT_DOUBLE_EQ(-2.0, statistics.min[0]);
+  EXPECT_DOUBLE_EQ(4.0, statistics.max[0]);
+  EXPECT_DOUBLE_EQ(1.5, statistics.mean[0]);
+
+  EXPECT_EQ(0u, Image::Statistics(bgra.data(), width, height,
+        Image::BAYER_RGGB8).channels);
+
+  // Loaded image, red and blue only
+  Image img;
+  ASSERT_EQ(0, img.Load(kTestData));
+  statistics = img.Statistics();
+  EXPECT_EQ(4u, statistics.channels);
+  EXPECT_NEAR(0.661157 * 255.0, statistics.mean[0], 1e-3);
+  EXPECT_DOUBLE_EQ(0.0, statistics.max[1]);
+  EXPECT_DOUBLE_EQ(255.0, statistics.max[2]);
+  EXPECT_DOUBLE_EQ(255.0, statistics.min[3]);
+}
+
+/////////////////////////////////////////////////
+TEST_F(ImageTest, DataFormat)
+{
+  using Image = common::Image;
+
+  Image img;
+  std::vector<unsigned char> data;
+  EXPECT_FALSE(img.Data(Image::RGB_INT8, data));
+
+  ASSERT_EQ(0, img.Load(kTestData));
+  unsigned char *rgbData = nullptr;
+  unsigned int rgbSize = 0;
+  img.RGBData(&rgbData, rgbSize);
+  ASSERT_NE(nullptr, rgbData);
+
+  ASSERT_TRUE(img.Data(Image::RGB_INT8, data));
+  ASSERT_EQ(rgbSize, data.size());
+  EXPECT_EQ(0, memcmp(rgbData, data.data(), rgbSize));
+  delete[] rgbData;
+
+  // First pixel is red, pixel 85 of the first row is blue
+  ASSERT_TRUE(img.Data(Image::BGRA_INT8, data));
+  ASSERT_EQ(kWidth * kHeight * 4u, data.size());
+  EXPECT_EQ(0u, data[0]);
+  EXPECT_EQ(255u, data[2]);
+  EXPECT_EQ(255u, data[3]);
+  EXPECT_EQ(255u, data[85u * 4u]);
+  EXPECT_EQ(0u, data[85u * 4u + 2u]);
+
+  ASSERT_TRUE(img.Data(Image::L_INT16, data));
+  ASSERT_EQ(kWidth * kHeight * 2u, data.size());
+  const uint16_t *gray = reinterpret_cast<const uint16_t *>(data.data());
+  EXPECT_NEAR(77.0 / 256.0 * 65535.0, gray[0], 1.0);
+  EXPECT_NEAR(29.0 / 256.0 * 65535.0, gray[85], 1.0);
+
+  EXPECT_FALSE(img.Data(Image::BAYER_RGGB8, data));
+}
+
+/////////////////////////////////////////////////
+TEST_F(ImageTest, View)
+{
+  using Image = common::Image;
+
+  Image img;
+  EXPECT_FALSE(img.View().Valid());
+  EXPECT_EQ(0u, img.View().Width());
+
+  ASSERT_EQ(0, img.Load(kTestData));
+  const common::ImageView view = img.View();
+  ASSERT_TRUE(view.Valid());
+  EXPECT_EQ(kWidth, view.Width());
+  EXPECT_EQ(kHeight, view.Height());
+  EXPECT_EQ(-static_cast<std::ptrdiff_t>(img.Pitch()), view.Pitch());
+  EXPECT_EQ(view.Data(), view.Row(0));
+
+  // The view reads the pixels of the image in place
+  std::vector<unsigned char> data;
+  ASSERT_TRUE(img.Data(Image::RGBA_INT8, data));
+  std::vector<unsigned char> converted(
+      Image::DataSize(Image::RGBA_INT8, kWidth, kHeight));
+  ASSERT_EQ(data.size(), converted.size());
+  ASSERT_TRUE(Image::ConvertPixels(view, Image::RGBA_INT8,
+        converted.data()));
+  EXPECT_EQ(data, converted);
+
+  // Views of caller buffers with padding between rows
+  const unsigned int pitch = kWidth * 4u + 12u;
+  std::vector<unsigned char> padded(pitch * kHeight, 0u);
+  for (unsigned int y = 0; y < kHeight; ++y)
+  {
+    memcpy(padded.data() + y * pitch, data.data() + y * kWidth * 4u,
+        kWidth * 4u);
+  }
+  std::vector<unsigned char> rgb(
+      Image::DataSize(Image::RGB_INT8, kWidth, kHeight));
+  ASSERT_TRUE(Image::ConvertPixels(common::ImageView(padded.data(), kWidth,
+          kHeight, pitch, Image::RGBA_INT8), Image::RGB_INT8, rgb.data()));
+  std::vector<unsigned char> expected;
+  ASSERT_TRUE(img.Data(Image::RGB_INT8, expected));
+  EXPECT_EQ(expected, rgb);
+
+  EXPECT_FALSE(Image::ConvertPixels(common::ImageView(), Image::RGB_INT8,
+        rgb.data()));
+}
+
+/////////////////////////////////////////////////
+TEST_F(ImageTest, DataCallerBuffer)
+{
+  using Image = common::Image;
+
+  Image img;
+  std::vector<unsigned char> buffer(
+      Image::DataSize(Image::RGB_INT8, kWidth, kHeight));
+  EXPECT_FALSE(img.Data(Image::RGB_INT8, buffer.data(), buffer.size()));
+
+  ASSERT_EQ(0, img.Load(kTestData));
+  EXPECT_EQ(kWidth * kHeight * 3u, buffer.size());
+  EXPECT_EQ(0u, Image::DataSize(Image::BAYER_RGGB8, kWidth, kHeight));
+  EXPECT_FALSE(img.Data(Image::RGB_INT8, buffer.data(), buffer.size() - 1u));
+  EXPECT_FALSE(img.Data(Image::BAYER_RGGB8, buffer.data(), buffer.size()));
+  ASSERT_TRUE(img.Data(Image::RGB_INT8, buffer.data(), buffer.size()));
+
+  std::vector<unsigned char> data;
+  ASSERT_TRUE(img.Data(Image::RGB_INT8, data));
+  EXPECT_EQ(data, buffer);
+
+  // The capacity of the vector is reused
+  const unsigned char *previous = data.data();
+  ASSERT_TRUE(img.Data(Image::L_INT8, data));
+  EXPECT_EQ(kWidth * kHeight, data.size());
+  EXPECT_EQ(previous, data.data());
+}
+
+/////////////////////////////////////////////////
+TEST_F(ImageTest, Resample)
+{
+  using Image = common::Image;
+  using Filter = Image::ResampleFilter;
+
+  // Box filter averages the pixels that an output pixel covers
+  const std::vector<unsigned char> row = {10, 20, 30, 50, 7, 9};
+  std::vector<unsigned char> out(3);
+  ASSERT_TRUE(Image::Resample(common::ImageView(row.data(), 6u, 1u, 6,
+          Image::L_INT8), 3u, 1u, Filter::BOX, out.data()));
+  EXPECT_EQ(std::vector<unsigned char>({15, 40, 8}), out);
+
+  // Enlarging with a box filter repeats pixels, with bilinear filtering
+  // it interpolates them
+  std::vector<unsigned char> wide(4);
+  ASSERT_TRUE(Image::Resample(common::ImageView(row.data(), 2u, 1u, 2,
+          Image::L_INT8), 4u, 1u, Filter::BOX, wide.data()));
+  EXPECT_EQ(std::vector<unsigned char>({10, 10, 20, 20}), wide);
+  ASSERT_TRUE(Image::Resample(common::ImageView(row.data(), 2u, 1u, 2,
+          Image::L_INT8), 4u, 1u, Filter::BILINEAR, wide.data()));
+  EXPECT_EQ(std::vector<unsigned char>({10, 12, 18, 20}), wide);
+
+  // Filters wider than the input still cover all of it
+  const std::vector<unsigned char> pair = {0, 255};
+  std::vector<unsigned char> single(1);
+  ASSERT_TRUE(Image::Resample(common::ImageView(pair.data(), 2u, 1u, 2,
+          Image::L_INT8), 1u, 1u, Filter::BILINEAR, single.data()));
+  EXPECT_NEAR(128, single[0], 1);
+  const std::vector<unsigned char> step = {0, 0, 255, 255};
+  std::vector<unsigned char> half(2);
+  ASSERT_TRUE(Image::Resample(common::ImageView(step.data(), 4u, 1u, 4,
+          Image::L_INT8), 2u, 1u, Filter::LANCZOS3, half.data()));
+  EXPECT_NEAR(14, half[0], 2);
+  EXPECT_NEAR(241, half[1], 2);
+  const std::vector<unsigned char> peak = {0, 255, 0};
+  std::vector<unsigned char> peakWide(6);
+  ASSERT_TRUE(Image::Resample(common::ImageView(peak.data(), 3u, 1u, 3,
+          Image::L_INT8), 6u, 1u, Filter::LANCZOS3, peakWide.data()));
+  EXPECT_EQ(0u, peakWide[0]);
+  EXPECT_NEAR(69, peakWide[1], 2);
+  EXPECT_NEAR(228, peakWide[2], 2);
+  for (unsigned int i = 0; i < 3u; ++i)
+    EXPECT_EQ(peakWide[i], peakWide[5u - i]) << i;
+
+  // Flat images stay flat in every format and with every filter
+  const unsigned int width = 37u;
+  const unsigned int height = 23u;
+  const std::vector<unsigned char> rgb(width * height * 3u, 200u);
+  for (const auto format : {Image::L_INT8, Image::RGB_INT8,
+      Image::BGRA_INT8, Image::L_INT16, Image::RGB_INT16, Image::R_FLOAT32,
+      Image::RGB_FLOAT32})
+  {
+    std::vector<unsigned char> src(Image::DataSize(format, width, height));
+    ASSERT_TRUE(Image::ConvertPixels(rgb.data(), Image::RGB_INT8, width,
+          height, format, src.data()));
+    const common::ImageView view(src.data(), width, height,
+        Image::DataSize(format, width, 1u), format);
+    const Image::ChannelStatistics expected =
+      Image::Statistics(src.data(), width, height, format);
+
+    for (const auto filter : {Filter::BOX, Filter::BILINEAR,
+        Filter::LANCZOS3})
+    {
+      for (const auto &size : {std::make_pair(5u, 3u),
+          std::make_pair(64u, 49u), std::make_pair(1u, 1u)})
+      {
+        std::vector<unsigned char> dst(
+            Image::DataSize(format, size.first, size.second));
+        ASSERT_TRUE(Image::Resample(view, size.first, size.second, filter,
+              dst.data()));
+        const Image::ChannelStatistics statistics = Image::Statistics(
+            dst.data(), size.first, size.second, format);
+        ASSERT_EQ(expected.channels, statistics.channels);
+        for (unsigned int c = 0; c < statistics.channels; ++c)
+        {
+          EXPECT_NEAR(expected.mean[c], statistics.min[c],
+              expected.mean[c] * 1e-4);
+          EXPECT_NEAR(expected.mean[c], statistics.max[c],
+              expected.mean[c] * 1e-4);
+        }
+      }
+    }
+  }
+
+  // Lanczos rings around edges. Integer channels are clamped, float
+  // channels are not.
+  const std::vector<unsigned char> edge = {0, 0, 0, 255, 255, 255};
+  std::vector<unsigned char> ringing(24u);
+  ASSERT_TRUE(Image::Resample(common::ImageView(edge.data(), 6u, 1u, 6,
+          Image::L_INT8), 24u, 1u, Filter::LANCZOS3, ringing.data()));
+  EXPECT_EQ(0u, ringing.front());
+  EXPECT_EQ(255u, ringing.back());
+  std::vector<float> edgeFloat(6u);
+  ASSERT_TRUE(Image::ConvertPixels(edge.data(), Image::L_INT8, 6u, 1u,
+        Image::R_FLOAT32, reinterpret_cast<unsigned char *>(
+          edgeFloat.data())));
+  std::vector<float> ringingFloat(24u);
+  ASSERT_TRUE(Image::Resample(common::ImageView(
+          reinterpret_cast<const unsigned char *>(edgeFloat.data()), 6u, 1u,
+          6 * sizeof(float), Image::R_FLOAT32), 24u, 1u, Filter::LANCZOS3,
+        reinterpret_cast<unsigned char *>(ringingFloat.data())));
+  EXPECT_GT(*std::max_element(ringingFloat.begin(), ringingFloat.end()),
+      1.0f);
+  EXPECT_LT(*std::min_element(ringingFloat.begin(), ringingFloat.end()),
+      0.0f);
+
+  EXPECT_FALSE(Image::Resample(common::ImageView(row.data(), 6u, 1u, 6,
+          Image::L_INT8), 0u, 1u, Filter::BOX, out.data()));
+  EXPECT_FALSE(Image::Resample(common::ImageView(row.data(), 2u, 1u, 2,
+          Image::BAYER_RGGB8), 1u, 1u, Filter::BOX, out.data()));
+}
+
+/////////////////////////////////////////////////
+TEST_F(ImageTest, Rescale)
+{
+  common::Image img;
+  ASSERT_EQ(0, img.Load(kTestData));
+  const unsigned int bpp = img.BPP();
+  img.Rescale(60, 40);
+  ASSERT_TRUE(img.Valid());
+  EXPECT_EQ(60u, img.Width());
+  EXPECT_EQ(40u, img.Height());
+  EXPECT_EQ(bpp, img.BPP());
+  EXPECT_EQ(math::Color::Red, img.Pixel(0, 0));
+  EXPECT_EQ(math::Color::Blue, img.Pixel(59, 39));
+
+  for (const auto filter : {common::Image::ResampleFilter::BOX,
+      common::Image::ResampleFilter::BILINEAR})
+  {
+    common::Image larger;
+    ASSERT_EQ(0, larger.Load(kTestData));
+    larger.Rescale(250, 170, filter);
+    EXPECT_EQ(250u, larger.Width());
+    EXPECT_EQ(170u, larger.Height());
+    EXPECT_EQ(math::Color::Red, larger.Pixel(0, 169));
+    EXPECT_EQ(math::Color::Blue, larger.Pixel(249, 0));
+  }
+
+  // Invalid sizes are ignored
+  img.Rescale(0, 10);
+  EXPECT_EQ(60u, img.Width());
+}
+
+/////////////////////////////////////////////////
+TEST_F(ImageTest, Mipmaps)
+{
+  using Image = common::Image;
+
+  Image img;
+  std::vector<unsigned char> data;
+  std::vector<common::ImageView> levels;
+  EXPECT_FALSE(img.Mipmaps(Image::RGB_INT8, data, levels));
+
+  ASSERT_EQ(0, img.Load(kTestData));
+  EXPECT_FALSE(img.Mipmaps(Image::BAYER_RGGB8, data, levels));
+  ASSERT_TRUE(img.Mipmaps(Image::RGB_INT8, data, levels));
+
+  // 121x81, 60x40, 30x20, 15x10, 7x5, 3x2 and 1x1
+  ASSERT_EQ(7u, levels.size());
+  EXPECT_EQ(kWidth, levels[0].Width());
+  EXPECT_EQ(kHeight, levels[0].Height());
+  EXPECT_EQ(data.data(), levels[0].Data());
+  EXPECT_EQ(3u, levels[5].Width());
+  EXPECT_EQ(2u, levels[5].Height());
+  EXPECT_EQ(1u, levels[6].Width());
+  EXPECT_EQ(1u, levels[6].Height());
+  EXPECT_EQ(data.data() + data.size() - 3, levels[6].Data());
+
+  std::vector<unsigned char> rgb;
+  ASSERT_TRUE(img.Data(Image::RGB_INT8, rgb));
+  EXPECT_EQ(0, memcmp(rgb.data(), data.data(), rgb.size()));
+
+  // The last level is close to the average color, give or take the
+  // rounding of every level
+  const unsigned char *pixel = levels[6].Data();
+  EXPECT_NEAR(0.661157 * 255.0, pixel[0], 20.0);
+  EXPECT_EQ(0u, pixel[1]);
+  EXPECT_NEAR(0.338843 * 255.0, pixel[2], 20.0);
+
+  // Levels of other formats, with every filter
+  for (const auto filter : {Image::ResampleFilter::BILINEAR,
+      Image::ResampleFilter::LANCZOS3})
+  {
+    ASSERT_TRUE(img.Mipmaps(Image::R_FLOAT32, data, levels, filter));
+    ASSERT_EQ(7u, levels.size());
+    EXPECT_EQ(Image::R_FLOAT32, levels[3].PixelFormat());
+    EXPECT_EQ(data.size(), Image::DataSize(Image::R_FLOAT32, 1u, 1u) +
+        static_cast<std::size_t>(levels[6].Data() - data.data()));
+  }
+}
+
 using string_int2 = std::tuple<const char *, unsigned int, unsigned int>;
 
 class ImagePerformanceTest : public ImageTest,
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#include <fstream>
+
+#include "MappedFile.hh"
+
+using namespace ignition;
+using namespace common;
+
+//////////////////////////////////////////////////
+MappedFile::MappedFile(const std::string &_path)
+{
+#ifndef _WIN32
+  const int fd = open(_path.c_str(), O_RDONLY);
+  if (fd >= 0)
+  {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    {
+      const std::size_t bytes = static_cast<std::size_t>(st.st_size);
+      void *addr = bytes > 0u ?
+        mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+      if (addr != MAP_FAILED)
+      {
+        this->data = static_cast<const char *>(addr);
+        this->size = bytes;
+        this->mapped = bytes > 0u;
+        this->valid = true;
+      }
+    }
+    close(fd);
+  }
+  if (this->valid)
+    return;
+#endif
+
+  // Fall back to reading the whole file
+  std::ifstream file(_path, std::ios::binary | std::ios::ate);
+  if (!file)
+    return;
+
+  this->size = static_cast<std::size_t>(file.tellg());
+  this->buffer.resize((this->size + sizeof(double) - 1) / sizeof(double));
+  file.seekg(0);
+  char *out = reinterpret_cast<char *>(this->buffer.data());
+  if (!file.read(out, static_cast<std::streamsize>(this->size)))
+  {
+    this->buffer.clear();
+    this->size = 0;
+    return;
+  }
+  this->data = this->size > 0u ? out : nullptr;
+  this->valid = true;
+}
+
+//////////////////////////////////////////////////
+MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+  if (this->mapped)
+    munmap(const_cast<char *>(this->data), this->size);
+#endif
+}
+
+//////////////////////////////////////////////////
+bool MappedFile::Valid() const
+{
+  return this->valid;
+}
+
+//////////////////////////////////////////////////
+const char *MappedFile::Data() const
+{
+  return this->data;
+}
+
+//////////////////////////////////////////////////
+std::size_t MappedFile::Size() const
+{
+  return this->size;
+}
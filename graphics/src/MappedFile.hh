@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGNITION_COMMON_MAPPEDFILE_HH_
+#define IGNITION_COMMON_MAPPEDFILE_HH_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace ignition
+{
+  namespace common
+  {
+    /// \brief Read-only view of the whole content of a file. The file is
+    /// memory mapped where the platform supports it, and read into memory
+    /// otherwise.
+    class MappedFile
+    {
+      /// \brief Constructor. Open and map a file.
+      /// \param[in] _path Path of the file.
+      public: explicit MappedFile(const std::string &_path);
+
+      /// \brief Destructor. Unmap the file.
+      public: ~MappedFile();
+
+      /// \brief Copying is not allowed
+      public: MappedFile(const MappedFile &) = delete;
+
+      /// \brief Copying is not allowed
+      public: MappedFile &operator=(const MappedFile &) = delete;
+
+      /// \brief Check whether the file could be opened.
+      /// \return True if Data() holds the content of the file.
+      public: bool Valid() const;
+
+      /// \brief Get the content of the file.
+      /// \return Pointer to Size() bytes, aligned to at least 8 bytes, or
+      /// nullptr if the file is empty or could not be opened.
+      public: const char *Data() const;
+
+      /// \brief Get the size of the file.
+      /// \return Number of bytes.
+      public: std::size_t Size() const;
+
+      /// \brief Start of the mapping, or of buffer
+      private: const char *data = nullptr;
+
+      /// \brief Number of bytes
+      private: std::size_t size = 0;
+
+      /// \brief True if the file could be opened
+      private: bool valid = false;
+
+      /// \brief True if data points to a memory mapping
+      private: bool mapped = false;
+
+      /// \brief Content of the file when it could not be mapped. Stored as
+      /// doubles so that the buffer is suitably aligned.
+      private: std::vector<double> buffer;
+    };
+  }
+}
+
+#endif
@@ -15,6 +15,7 @@
  *
  */
 #include <algorithm>
+#include <atomic>
 #include <ignition/math/Color.hh>
 
 #include "ignition/common/Material.hh"
@@ -80,7 +81,7 @@ class ignition::common::Material::Implementation
   public: Material::ShadeMode shadeMode;
 
   /// \brief the total number of instantiated Material instances
-  public: static unsigned int counter;
+  public: static std::atomic<unsigned int> counter;
 
   /// \brief flag to perform depth buffer write
   public: bool depthWrite = true;
@@ -98,7 +99,7 @@ class ignition::common::Material::Implementation
   public: std::unique_ptr<Pbr> pbr;
 };
 
-unsigned int Material::Implementation::counter = 0;
+std::atomic<unsigned int> Material::Implementation::counter{0};
 
 //////////////////////////////////////////////////
 Material::Material()
@@ -15,8 +15,10 @@
  *
  */
 
-#include <string>
 #include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
 
 #include "ignition/math/Helpers.hh"
 
@@ -46,6 +48,47 @@ class ignition::common::Mesh::Implementation
 
   /// \brief The skeleton (for animation)
   public: SkeletonPtr skeleton;
+
+  /// \brief Implementation of Mesh::FillBuffers for every output type
+  /// \param[out] _vertices Positions, or nullptr
+  /// \param[out] _indices Indices, or nullptr
+  /// \return False if an index does not fit in I
+  public: template <typename V, typename I>
+          bool FillBuffers(V *_vertices, I *_indices) const
+  {
+    // Check every submesh first, so that nothing is written on failure
+    if (_indices)
+    {
+      uint64_t offset = 0;
+      for (const auto &submesh : this->submeshes)
+      {
+        if (submesh->IndexCount() > 0u &&
+            offset + submesh->MaxIndex() > std::numeric_limits<I>::max())
+        {
+          return false;
+        }
+        offset += submesh->VertexCount();
+      }
+    }
+
+    unsigned int offset = 0;
+    for (const auto &submesh : this->submeshes)
+    {
+      if (_vertices)
+      {
+        submesh->FillVertexBuffer(_vertices);
+        _vertices += submesh->VertexCount() * 3u;
+      }
+      if (_indices)
+      {
+        if (!submesh->FillIndexBuffer(_indices, offset))
+          return false;
+        _indices += submesh->IndexCount();
+      }
+      offset += submesh->VertexCount();
+    }
+    return true;
+  }
 };
 
 //////////////////////////////////////////////////
@@ -287,30 +330,32 @@ void Mesh::FillArrays(double **_vertArr, int **_indArr) const
   *_vertArr = new double[vertCount * 3];
   *_indArr = new int[indCount];
 
-  double *vPtr = *_vertArr;
-  unsigned int index = 0;
-  unsigned int offset = 0;
-
-  for (const auto &submesh : this->dataPtr->submeshes)
-  {
-    double *vertTmp = NULL;
-    int *indTmp = NULL;
-    submesh->FillArrays(&vertTmp, &indTmp);
-
-    memcpy(vPtr, vertTmp, sizeof(vertTmp[0])*submesh->VertexCount()*3);
+  if (!this->FillBuffers(*_vertArr, reinterpret_cast<uint32_t *>(*_indArr)))
+    ignerr << "Mesh indices do not fit in 32 bits\n";
+}
 
-    for (unsigned int i = 0; i < submesh->IndexCount(); ++i)
-    {
-      (*_indArr)[index++] = submesh->Index(i) + offset;
-    }
+//////////////////////////////////////////////////
+bool Mesh::FillBuffers(float *_vertices, uint32_t *_indices) const
+{
+  return this->dataPtr->FillBuffers(_vertices, _indices);
+}
 
-    offset = offset + submesh->MaxIndex() + 1;
+//////////////////////////////////////////////////
+bool Mesh::FillBuffers(double *_vertices, uint32_t *_indices) const
+{
+  return this->dataPtr->FillBuffers(_vertices, _indices);
+}
 
-    vPtr += submesh->VertexCount()*3;
+//////////////////////////////////////////////////
+bool Mesh::FillBuffers(float *_vertices, uint16_t *_indices) const
+{
+  return this->dataPtr->FillBuffers(_vertices, _indices);
+}
 
-    delete [] vertTmp;
-    delete [] indTmp;
-  }
+//////////////////////////////////////////////////
+bool Mesh::FillBuffers(double *_vertices, uint16_t *_indices) const
+{
+  return this->dataPtr->FillBuffers(_vertices, _indices);
 }
 
 //////////////////////////////////////////////////
@@ -320,6 +365,14 @@ void Mesh::RecalculateNormals()
     submesh->RecalculateNormals();
 }
 
+//////////////////////////////////////////////////
+void Mesh::RecalculateNormals(const SubMesh::NormalWeighting _weighting,
+    const bool _weld)
+{
+  for (auto &submesh : this->dataPtr->submeshes)
+    submesh->RecalculateNormals(_weighting, _weld);
+}
+
 //////////////////////////////////////////////////
 void Mesh::SetSkeleton(const SkeletonPtr &_skel)
 {
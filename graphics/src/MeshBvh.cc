@@ -0,0 +1,1328 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+  #include <xmmintrin.h>
+  #define IGN_COMMON_MESHBVH_SSE
+#endif
+
+#include "ignition/common/Mesh.hh"
+#include "ignition/common/MeshBvh.hh"
+#include "ignition/common/Parallel.hh"
+#include "ignition/common/SubMesh.hh"
+
+using namespace ignition;
+using namespace common;
+
+namespace
+{
+  /// \brief Infinity
+  const double kInf = std::numeric_limits<double>::infinity();
+
+  /// \brief Infinity in single precision
+  const float kInfF = std::numeric_limits<float>::infinity();
+
+  /// \brief Number of bins of the surface area heuristic along each axis
+  const unsigned int kBins = 16u;
+
+  /// \brief Largest number of triangles in a leaf
+  const uint32_t kMaxLeafSize = 8u;
+
+  /// \brief Cost of visiting a node, relative to intersecting a triangle
+  const double kTraversalCost = 1.0;
+
+  /// \brief Depth below which nodes are split at the median instead of with
+  /// the surface area heuristic, which bounds the depth of the hierarchy
+  const unsigned int kMaxSahDepth = 48u;
+
+  /// \brief Size of the traversal stacks. Every level of the hierarchy
+  /// adds at most three entries, and there are fewer than 80 levels.
+  const std::size_t kStackSize = 256u;
+
+  /// \brief Subtrees with fewer triangles are built by a single thread
+  const uint32_t kMinTaskSize = 4096u;
+
+  /// \brief Number of triangles handed to a thread at once when computing
+  /// boxes or copying corners
+  const std::size_t kGrain = 8192u;
+
+  /// \brief Value of Node4::count for lanes that hold a node
+  const uint32_t kInterior = std::numeric_limits<uint32_t>::max();
+
+  /// \brief Relative tolerance of the single precision box tests
+  const float kRayPadding = 1.00001f;
+
+  /// \brief Largest magnitude of an inverse ray direction, which keeps the
+  /// slab tests free of NaNs when the ray is parallel to a slab
+  const double kMaxInverse = 1e30;
+
+  /// \brief Axis aligned box in double precision
+  struct Box
+  {
+    /// \brief Grow to contain a point
+    /// \param[in] _p Coordinates of the point
+    void Grow(const double *_p)
+    {
+      for (int a = 0; a < 3; ++a)
+      {
+        this->lo[a] = std::min(this->lo[a], _p[a]);
+        this->hi[a] = std::max(this->hi[a], _p[a]);
+      }
+    }
+
+    /// \brief Grow to contain another box
+    /// \param[in] _b Box
+    void Grow(const Box &_b)
+    {
+      for (int a = 0; a < 3; ++a)
+      {
+        this->lo[a] = std::min(this->lo[a], _b.lo[a]);
+        this->hi[a] = std::max(this->hi[a], _b.hi[a]);
+      }
+    }
+
+    /// \brief Get the center along an axis
+    /// \param[in] _a Axis
+    /// \return Center
+    double Center(const int _a) const
+    {
+      return 0.5 * (this->lo[_a] + this->hi[_a]);
+    }
+
+    /// \brief Get half of the surface area
+    /// \return Half area, zero if the box is empty
+    double HalfArea() const
+    {
+      const double dx = this->hi[0] - this->lo[0];
+      const double dy = this->hi[1] - this->lo[1];
+      const double dz = this->hi[2] - this->lo[2];
+      if (!(dx >= 0.0))
+        return 0.0;
+      return dx * dy + dy * dz + dz * dx;
+    }
+
+    /// \brief Smallest corner
+    double lo[3] = {kInf, kInf, kInf};
+
+    /// \brief Largest corner
+    double hi[3] = {-kInf, -kInf, -kInf};
+  };
+
+  /// \brief Node with four children, each of which is either a node or a
+  /// leaf with a range of triangles. The boxes of the children are stored
+  /// axis by axis so that they are tested together.
+  struct Node4
+  {
+    /// \brief Smallest corner of the box of every child, per axis
+    float lo[3][4] = {{kInfF, kInfF, kInfF, kInfF},
+      {kInfF, kInfF, kInfF, kInfF}, {kInfF, kInfF, kInfF, kInfF}};
+
+    /// \brief Largest corner of the box of every child, per axis
+    float hi[3][4] = {{-kInfF, -kInfF, -kInfF, -kInfF},
+      {-kInfF, -kInfF, -kInfF, -kInfF}, {-kInfF, -kInfF, -kInfF, -kInfF}};
+
+    /// \brief Index of the node, or of the first triangle of the leaf
+    uint32_t child[4] = {0u, 0u, 0u, 0u};
+
+    /// \brief Number of triangles of the leaf, kInterior for nodes, or zero
+    /// for unused lanes
+    uint32_t count[4] = {0u, 0u, 0u, 0u};
+  };
+
+  /// \brief Triangle of a submesh
+  struct TriangleRef
+  {
+    /// \brief Index of the submesh
+    uint32_t subMesh;
+
+    /// \brief Index of the triangle in the submesh
+    uint32_t triangle;
+  };
+
+  /// \brief Submesh the hierarchy was built from
+  struct Source
+  {
+    /// \brief The submesh
+    std::shared_ptr<const SubMesh> subMesh;
+
+    /// \brief Vertex revision at the last build or refit
+    uint64_t vertexRevision = 0u;
+
+    /// \brief Index revision at the last build
+    uint64_t indexRevision = 0u;
+
+    /// \brief Number of vertices at the last build
+    unsigned int vertexCount = 0u;
+  };
+
+  /// \brief Node of the binary hierarchy built before it is collapsed into
+  /// 4-wide nodes
+  struct BuildNode
+  {
+    /// \brief First primitive, for leaves
+    uint32_t first = 0u;
+
+    /// \brief Number of triangles of a leaf, zero for interior nodes
+    uint32_t count = 0u;
+
+    /// \brief Children in the same tree, for interior nodes
+    uint32_t children[2] = {0u, 0u};
+
+    /// \brief Half of the surface area of the box of the node
+    double area = 0.0;
+
+    /// \brief Index of the tree that replaces this node, or -1. Subtrees
+    /// built by other threads are kept in separate trees.
+    int subtree = -1;
+  };
+
+  /// \brief Range of primitives waiting to become a node
+  struct BuildRange
+  {
+    /// \brief Index of the node in its tree
+    uint32_t node;
+
+    /// \brief First primitive
+    uint32_t first;
+
+    /// \brief Number of triangles
+    uint32_t count;
+
+    /// \brief Depth of the node in the whole hierarchy
+    unsigned int depth;
+
+    /// \brief Box of the triangles
+    Box bounds;
+
+    /// \brief Box of the centers of the boxes of the triangles
+    Box centers;
+  };
+
+  /// \brief Box of a triangle being sorted into the hierarchy
+  struct Primitive
+  {
+    /// \brief Box of the triangle
+    Box box;
+
+    /// \brief Index of the triangle
+    uint32_t index;
+  };
+
+  /// \brief Reference to a node of one of the binary trees
+  struct TreeRef
+  {
+    /// \brief Index of the tree
+    std::size_t tree;
+
+    /// \brief Index of the node in the tree
+    uint32_t node;
+  };
+
+  /// \brief Entry of a traversal stack
+  struct StackEntry
+  {
+    /// \brief Index of the node
+    uint32_t node;
+
+    /// \brief Lower bound of the distance of the node, along the ray or
+    /// squared from the query point
+    float distance;
+  };
+
+  /// \brief Ray prepared for the slab tests of Node4 boxes
+  struct Ray4
+  {
+#ifdef IGN_COMMON_MESHBVH_SSE
+    /// \brief Origin, one axis per register
+    __m128 origin[3];
+
+    /// \brief Inverse of the direction, one axis per register
+    __m128 inverse[3];
+#else
+    /// \brief Origin
+    float origin[3];
+
+    /// \brief Inverse of the direction
+    float inverse[3];
+#endif
+  };
+
+  /// \brief Push the children of a node on a traversal stack, the nearest
+  /// one last so that it is visited first
+  /// \param[in, out] _children Children, which are sorted
+  /// \param[in] _count Number of children
+  /// \param[in, out] _stack Stack
+  /// \param[in, out] _size Number of entries of the stack
+  void PushChildren(std::array<StackEntry, 4> &_children,
+      const std::size_t _count, std::array<StackEntry, kStackSize> &_stack,
+      std::size_t &_size)
+  {
+    for (std::size_t i = 1; i < _count; ++i)
+    {
+      for (std::size_t j = i;
+          j > 0 && _children[j - 1].distance < _children[j].distance; --j)
+      {
+        std::swap(_children[j - 1], _children[j]);
+      }
+    }
+    for (std::size_t i = 0; i < _count; ++i)
+      _stack[_size++] = _children[i];
+  }
+
+  /// \brief Round a value down to single precision
+  /// \param[in] _v Value
+  /// \return Largest float not greater than _v
+  float RoundDown(const double _v)
+  {
+    float f = static_cast<float>(_v);
+    if (static_cast<double>(f) > _v)
+      f = std::nextafter(f, -kInfF);
+    return f;
+  }
+
+  /// \brief Round a value up to single precision
+  /// \param[in] _v Value
+  /// \return Smallest float not less than _v
+  float RoundUp(const double _v)
+  {
+    float f = static_cast<float>(_v);
+    if (static_cast<double>(f) < _v)
+      f = std::nextafter(f, kInfF);
+    return f;
+  }
+
+  /// \brief Intersect a ray with the four boxes of a node
+  /// \param[in] _node Node
+  /// \param[in] _ray Ray
+  /// \param[in] _tMax Largest distance along the ray
+  /// \param[out] _tNear Distance at which the ray enters each box
+  /// \return Bit mask of the lanes whose box is hit
+  int IntersectLanes(const Node4 &_node, const Ray4 &_ray, const float _tMax,
+      float *_tNear)
+  {
+#ifdef IGN_COMMON_MESHBVH_SSE
+    __m128 tMin = _mm_setzero_ps();
+    __m128 tMax = _mm_set1_ps(_tMax);
+    for (int a = 0; a < 3; ++a)
+    {
+      const __m128 t0 = _mm_mul_ps(
+          _mm_sub_ps(_mm_loadu_ps(_node.lo[a]), _ray.origin[a]),
+          _ray.inverse[a]);
+      const __m128 t1 = _mm_mul_ps(
+          _mm_sub_ps(_mm_loadu_ps(_node.hi[a]), _ray.origin[a]),
+          _ray.inverse[a]);
+      tMin = _mm_max_ps(tMin, _mm_min_ps(t0, t1));
+      tMax = _mm_min_ps(tMax, _mm_max_ps(t0, t1));
+    }
+    _mm_storeu_ps(_tNear, tMin);
+    return _mm_movemask_ps(_mm_cmple_ps(tMin,
+          _mm_mul_ps(tMax, _mm_set1_ps(kRayPadding))));
+#else
+    int mask = 0;
+    for (int lane = 0; lane < 4; ++lane)
+    {
+      float tMin = 0.0f;
+      float tMax = _tMax;
+      for (int a = 0; a < 3; ++a)
+      {
+        const float t0 =
+          (_node.lo[a][lane] - _ray.origin[a]) * _ray.inverse[a];
+        const float t1 =
+          (_node.hi[a][lane] - _ray.origin[a]) * _ray.inverse[a];
+        tMin = std::max(tMin, std::min(t0, t1));
+        tMax = std::min(tMax, std::max(t0, t1));
+      }
+      _tNear[lane] = tMin;
+      if (tMin <= tMax * kRayPadding)
+        mask |= 1 << lane;
+    }
+    return mask;
+#endif
+  }
+
+  /// \brief Get the unit normal of a triangle
+  /// \param[in] _c Corners of the triangle, three coordinates each
+  /// \return Normal following the winding, or zero if degenerate
+  math::Vector3d TriangleNormal(const double *_c)
+  {
+    const math::Vector3d v0(_c[0], _c[1], _c[2]);
+    const math::Vector3d v1(_c[3], _c[4], _c[5]);
+    const math::Vector3d v2(_c[6], _c[7], _c[8]);
+    math::Vector3d n = (v1 - v0).Cross(v2 - v0);
+    const double length = n.Length();
+    return length > 0.0 ? n / length : math::Vector3d::Zero;
+  }
+
+  /// \brief Intersect a ray with a triangle, from both sides
+  /// \param[in] _c Corners of the triangle, three coordinates each
+  /// \param[in] _o Origin of the ray
+  /// \param[in] _d Direction of the ray
+  /// \param[out] _t Distance along the ray, in units of _d
+  /// \return True if the triangle is hit in front of the origin
+  bool IntersectTriangle(const double *_c, const double *_o,
+      const double *_d, double &_t)
+  {
+    const double e1[3] = {_c[3] - _c[0], _c[4] - _c[1], _c[5] - _c[2]};
+    const double e2[3] = {_c[6] - _c[0], _c[7] - _c[1], _c[8] - _c[2]};
+    const double p[3] = {_d[1] * e2[2] - _d[2] * e2[1],
+      _d[2] * e2[0] - _d[0] * e2[2], _d[0] * e2[1] - _d[1] * e2[0]};
+    const double det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    if (det == 0.0)
+      return false;
+
+    const double inv = 1.0 / det;
+    const double s[3] = {_o[0] - _c[0], _o[1] - _c[1], _o[2] - _c[2]};
+    const double u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv;
+    if (u < 0.0 || u > 1.0)
+      return false;
+
+    const double q[3] = {s[1] * e1[2] - s[2] * e1[1],
+      s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]};
+    const double v = (_d[0] * q[0] + _d[1] * q[1] + _d[2] * q[2]) * inv;
+    if (v < 0.0 || u + v > 1.0)
+      return false;
+
+    _t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv;
+    return _t >= 0.0;
+  }
+
+  /// \brief Find the point of a triangle closest to a point, as in
+  /// "Real-Time Collision Detection" by Christer Ericson
+  /// \param[in] _c Corners of the triangle, three coordinates each
+  /// \param[in] _p Query point
+  /// \return Closest point
+  math::Vector3d ClosestPointOnTriangle(const double *_c,
+      const math::Vector3d &_p)
+  {
+    const math::Vector3d a(_c[0], _c[1], _c[2]);
+    const math::Vector3d b(_c[3], _c[4], _c[5]);
+    const math::Vector3d c(_c[6], _c[7], _c[8]);
+    const math::Vector3d ab = b - a;
+    const math::Vector3d ac = c - a;
+
+    const math::Vector3d ap = _p - a;
+    const double d1 = ab.Dot(ap);
+    const double d2 = ac.Dot(ap);
+    if (d1 <= 0.0 && d2 <= 0.0)
+      return a;
+
+    const math::Vector3d bp = _p - b;
+    const double d3 = ab.Dot(bp);
+    const double d4 = ac.Dot(bp);
+    if (d3 >= 0.0 && d4 <= d3)
+      return b;
+
+    const double vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+      return a + ab * (d1 / (d1 - d3));
+
+    const math::Vector3d cp = _p - c;
+    const double d5 = ab.Dot(cp);
+    const double d6 = ac.Dot(cp);
+    if (d6 >= 0.0 && d5 <= d6)
+      return c;
+
+    const double vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+      return a + ac * (d2 / (d2 - d6));
+
+    const double va = d3 * d6 - d5 * d4;
+    if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+      return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    // Inside the triangle. Degenerate triangles end up in the cases above.
+    const double denom = 1.0 / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+  }
+
+  /// \brief Check whether a triangle intersects a box, with the separating
+  /// axis test of Akenine-Moller
+  /// \param[in] _c Corners of the triangle, three coordinates each
+  /// \param[in] _center Center of the box
+  /// \param[in] _half Half of the size of the box
+  /// \return True if they intersect
+  bool TriangleOverlapsBox(const double *_c, const math::Vector3d &_center,
+      const math::Vector3d &_half)
+  {
+    const math::Vector3d v[3] =
+    {
+      math::Vector3d(_c[0], _c[1], _c[2]) - _center,
+      math::Vector3d(_c[3], _c[4], _c[5]) - _center,
+      math::Vector3d(_c[6], _c[7], _c[8]) - _center
+    };
+
+    // Projection on an axis against the projected radius of the box
+    auto separated = [&](const math::Vector3d &_axis)
+    {
+      const double p0 = _axis.Dot(v[0]);
+      const double p1 = _axis.Dot(v[1]);
+      const double p2 = _axis.Dot(v[2]);
+      const double r = _half.Dot(_axis.Abs());
+      return std::min({p0, p1, p2}) > r || std::max({p0, p1, p2}) < -r;
+    };
+
+    const math::Vector3d axes[3] =
+    {
+      math::Vector3d::UnitX, math::Vector3d::UnitY, math::Vector3d::UnitZ
+    };
+    const math::Vector3d edges[3] = {v[1] - v[0], v[2] - v[1], v[0] - v[2]};
+    for (const math::Vector3d &axis : axes)
+    {
+      if (separated(axis))
+        return false;
+    }
+    if (separated(edges[0].Cross(edges[1])))
+      return false;
+    for (const math::Vector3d &axis : axes)
+    {
+      for (const math::Vector3d &edge : edges)
+      {
+        if (separated(axis.Cross(edge)))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  /// \brief Builds a binary hierarchy with the binned surface area
+  /// heuristic, by partitioning a shared array of triangle boxes
+  class Builder
+  {
+    /// \brief Constructor
+    /// \param[in, out] _primitives Triangle boxes, partitioned in place
+    public: explicit Builder(std::vector<Primitive> &_primitives)
+      : primitives(_primitives)
+    {
+    }
+
+    /// \brief Build a tree over a range of the primitives
+    /// \param[in] _range Range, which becomes node 0
+    /// \param[in] _taskSize Ranges with at most this many triangles are
+    /// not split but added to _tasks, unless _tasks is nullptr
+    /// \param[out] _nodes Nodes of the tree, the root first
+    /// \param[out] _tasks Ranges left to other trees
+    public: void Build(const BuildRange &_range, const uint32_t _taskSize,
+                std::vector<BuildNode> &_nodes,
+                std::vector<BuildRange> *_tasks) const
+    {
+      _nodes.assign(1u, BuildNode());
+      std::vector<BuildRange> stack(1u, _range);
+      stack.back().node = 0u;
+      while (!stack.empty())
+      {
+        const BuildRange range = stack.back();
+        stack.pop_back();
+
+        BuildNode &node = _nodes[range.node];
+        node.area = range.bounds.HalfArea();
+        if (_tasks && range.count <= _taskSize)
+        {
+          node.subtree = static_cast<int>(_tasks->size());
+          _tasks->push_back(range);
+          continue;
+        }
+
+        BuildRange children[2];
+        if (!this->Split(range, children))
+        {
+          node.first = range.first;
+          node.count = range.count;
+          continue;
+        }
+
+        const uint32_t left = static_cast<uint32_t>(_nodes.size());
+        node.children[0] = left;
+        node.children[1] = left + 1u;
+        children[0].node = left;
+        children[1].node = left + 1u;
+        _nodes.resize(_nodes.size() + 2u);
+        stack.push_back(children[1]);
+        stack.push_back(children[0]);
+      }
+    }
+
+    /// \brief Compute the bounds of a range
+    /// \param[in, out] _range Range whose bounds and centers are set
+    public: void Bound(BuildRange &_range) const
+    {
+      _range.bounds = Box();
+      _range.centers = Box();
+      for (uint32_t i = _range.first; i < _range.first + _range.count; ++i)
+      {
+        const Box &box = this->primitives[i].box;
+        _range.bounds.Grow(box);
+        const double center[3] =
+          {box.Center(0), box.Center(1), box.Center(2)};
+        _range.centers.Grow(center);
+      }
+    }
+
+    /// \brief Choose how to split a range, and partition it
+    /// \param[in] _range Range
+    /// \param[out] _children The two halves, with their bounds
+    /// \return False to make a leaf
+    private: bool Split(const BuildRange &_range,
+                 BuildRange _children[2]) const
+    {
+      const uint32_t first = _range.first;
+      const uint32_t count = _range.count;
+      if (count <= 1u)
+        return false;
+
+      // Bin the triangles along all axes in a single pass
+      const Box &centers = _range.centers;
+      double scale[3];
+      for (int a = 0; a < 3; ++a)
+      {
+        const double extent = centers.hi[a] - centers.lo[a];
+        scale[a] = extent > 0.0 ? kBins / extent : 0.0;
+      }
+      std::array<std::array<Box, kBins>, 3> bins;
+      std::array<std::array<uint32_t, kBins>, 3> counts{};
+      if (_range.depth < kMaxSahDepth)
+      {
+        for (uint32_t i = first; i < first + count; ++i)
+        {
+          const Box &box = this->primitives[i].box;
+          for (int a = 0; a < 3; ++a)
+          {
+            const unsigned int b =
+              BinIndex(box.Center(a), centers.lo[a], scale[a]);
+            ++counts[a][b];
+            bins[a][b].Grow(box);
+          }
+        }
+      }
+
+      // Costs are multiplied by the area of the node, which avoids dividing
+      // by zero for degenerate boxes
+      double bestCost = kInf;
+      int bestAxis = -1;
+      unsigned int bestBin = 0u;
+      for (int a = 0; a < 3 && _range.depth < kMaxSahDepth; ++a)
+      {
+        if (scale[a] == 0.0)
+          continue;
+
+        // Cost of the right side of every split, from the right
+        std::array<double, kBins> rightCost{};
+        Box right;
+        uint32_t rightCount = 0u;
+        for (unsigned int b = kBins - 1u; b > 0u; --b)
+        {
+          right.Grow(bins[a][b]);
+          rightCount += counts[a][b];
+          rightCost[b] = right.HalfArea() * rightCount;
+        }
+
+        Box left;
+        uint32_t leftCount = 0u;
+        for (unsigned int b = 1u; b < kBins; ++b)
+        {
+          left.Grow(bins[a][b - 1u]);
+          leftCount += counts[a][b - 1u];
+          if (leftCount == 0u || leftCount == count)
+            continue;
+          const double cost = left.HalfArea() * leftCount + rightCost[b];
+          if (cost < bestCost)
+          {
+            bestCost = cost;
+            bestAxis = a;
+            bestBin = b;
+          }
+        }
+      }
+
+      for (int c = 0; c < 2; ++c)
+      {
+        _children[c] = {0u, first, 0u, _range.depth + 1u, Box(), Box()};
+      }
+
+      if (bestAxis >= 0)
+      {
+        const double area = _range.bounds.HalfArea();
+        if (count <= kMaxLeafSize &&
+            count * area <= kTraversalCost * area + bestCost)
+        {
+          return false;
+        }
+
+        // Partition, and bound the centers of each half on the way
+        uint32_t i = first;
+        uint32_t j = first + count;
+        while (i < j)
+        {
+          const Box &box = this->primitives[i].box;
+          const double center[3] =
+            {box.Center(0), box.Center(1), box.Center(2)};
+          if (BinIndex(center[bestAxis], centers.lo[bestAxis],
+                scale[bestAxis]) < bestBin)
+          {
+            _children[0].centers.Grow(center);
+            ++i;
+          }
+          else
+          {
+            _children[1].centers.Grow(center);
+            std::swap(this->primitives[i], this->primitives[--j]);
+          }
+        }
+
+        _children[0].count = i - first;
+        _children[1].first = i;
+        _children[1].count = first + count - i;
+        for (unsigned int b = 0u; b < kBins; ++b)
+          _children[b < bestBin ? 0 : 1].bounds.Grow(bins[bestAxis][b]);
+        return true;
+      }
+
+      // All centers coincide, or the hierarchy is too deep for the
+      // heuristic: split at the median of the longest axis
+      if (count <= kMaxLeafSize && _range.depth < kMaxSahDepth)
+        return false;
+      int axis = 0;
+      for (int a = 1; a < 3; ++a)
+      {
+        if (centers.hi[a] - centers.lo[a] >
+            centers.hi[axis] - centers.lo[axis])
+        {
+          axis = a;
+        }
+      }
+      auto begin = this->primitives.begin() + first;
+      std::nth_element(begin, begin + count / 2u, begin + count,
+          [&](const Primitive &_a, const Primitive &_b)
+          {
+            return _a.box.Center(axis) < _b.box.Center(axis);
+          });
+      _children[0].count = count / 2u;
+      _children[1].first = first + count / 2u;
+      _children[1].count = count - count / 2u;
+      this->Bound(_children[0]);
+      this->Bound(_children[1]);
+      return true;
+    }
+
+    /// \brief Get the bin of a center
+    /// \param[in] _center Center along the axis
+    /// \param[in] _lo Smallest center along the axis
+    /// \param[in] _scale Number of bins per unit
+    /// \return Bin index
+    private: static unsigned int BinIndex(const double _center,
+                 const double _lo, const double _scale)
+    {
+      const double bin = (_center - _lo) * _scale;
+      return std::min(kBins - 1u, static_cast<unsigned int>(
+            std::max(0.0, bin)));
+    }
+
+    /// \brief Triangle boxes
+    private: std::vector<Primitive> &primitives;
+  };
+}
+
+/// \brief Private data for the MeshBvh class
+class ignition::common::MeshBvh::Implementation
+{
+  /// \brief Build the hierarchy from the sources
+  public: void Rebuild();
+
+  /// \brief Copy the corners of triangles from their submeshes
+  /// \param[in] _positions Vertex positions of every source, empty for
+  /// sources whose triangles are not copied
+  public: void CopyCorners(
+              const std::vector<std::vector<double>> &_positions);
+
+  /// \brief Recompute the boxes of all nodes from the triangle corners
+  public: void Refit();
+
+  /// \brief Submeshes of the mesh, in order
+  public: std::vector<Source> sources;
+
+  /// \brief Nodes, each before its children. The root is the first one.
+  public: std::vector<Node4> nodes;
+
+  /// \brief Triangles in leaf order
+  public: std::vector<TriangleRef> triangles;
+
+  /// \brief Corners of the triangles in leaf order, nine values each
+  public: std::vector<double> corners;
+
+  /// \brief Box of all triangles
+  public: math::AxisAlignedBox box;
+};
+
+/////////////////////////////////////////////////
+void MeshBvh::Implementation::Rebuild()
+{
+  this->nodes.clear();
+  this->triangles.clear();
+  this->corners.clear();
+  this->box = math::AxisAlignedBox();
+
+  // Triangles with valid indices
+  std::vector<std::vector<double>> positions(this->sources.size());
+  std::vector<TriangleRef> refs;
+  for (std::size_t s = 0; s < this->sources.size(); ++s)
+  {
+    Source &source = this->sources[s];
+    const SubMesh &subMesh = *source.subMesh;
+    source.vertexRevision = subMesh.VertexRevision();
+    source.indexRevision = subMesh.IndexRevision();
+    source.vertexCount = subMesh.VertexCount();
+    if (subMesh.SubMeshPrimitiveType() != SubMesh::TRIANGLES ||
+        source.vertexCount == 0u)
+    {
+      continue;
+    }
+
+    positions[s].resize(source.vertexCount * 3u);
+    subMesh.FillVertexBuffer(positions[s].data());
+    const unsigned int *indices = subMesh.IndexData();
+    const unsigned int count = subMesh.IndexCount() / 3u;
+    for (unsigned int t = 0; t < count; ++t)
+    {
+      if (indices[t * 3u] < source.vertexCount &&
+          indices[t * 3u + 1u] < source.vertexCount &&
+          indices[t * 3u + 2u] < source.vertexCount)
+      {
+        refs.push_back({static_cast<uint32_t>(s), t});
+      }
+    }
+  }
+  if (refs.empty())
+    return;
+
+  const uint32_t count = static_cast<uint32_t>(refs.size());
+  std::vector<Primitive> primitives(count);
+  ParallelFor(0u, count, kGrain,
+      [&](const std::size_t _first, const std::size_t _last)
+      {
+        for (std::size_t i = _first; i < _last; ++i)
+        {
+          const TriangleRef &ref = refs[i];
+          const unsigned int *indices =
+            this->sources[ref.subMesh].subMesh->IndexData() +
+            ref.triangle * 3u;
+          for (int c = 0; c < 3; ++c)
+            primitives[i].box.Grow(&positions[ref.subMesh][indices[c] * 3u]);
+          primitives[i].index = static_cast<uint32_t>(i);
+        }
+      });
+
+  // Build the top of the binary hierarchy, then the subtrees below it in
+  // parallel. Each subtree partitions its own range of the primitives.
+  const Builder builder(primitives);
+  BuildRange root = {0u, 0u, count, 0u, Box(), Box()};
+  builder.Bound(root);
+  std::vector<std::vector<BuildNode>> trees(1u);
+  std::vector<BuildRange> tasks;
+  const uint32_t taskSize = std::max(kMinTaskSize, count / 64u);
+  builder.Build(root, taskSize, trees[0],
+      count > taskSize ? &tasks : nullptr);
+  trees.resize(tasks.size() + 1u);
+  ParallelFor(0u, tasks.size(), 1u,
+      [&](const std::size_t _first, const std::size_t _last)
+      {
+        for (std::size_t i = _first; i < _last; ++i)
+          builder.Build(tasks[i], 0u, trees[i + 1u], nullptr);
+      });
+
+  // Collapse into 4-wide nodes, by replacing the child with the largest
+  // area by its own children until there are four
+  auto resolve = [&](TreeRef _ref)
+  {
+    while (trees[_ref.tree][_ref.node].subtree >= 0)
+      _ref = {static_cast<std::size_t>(trees[_ref.tree][_ref.node].subtree) +
+        1u, 0u};
+    return _ref;
+  };
+  auto node = [&](const TreeRef &_ref) -> const BuildNode &
+  {
+    return trees[_ref.tree][_ref.node];
+  };
+
+  this->triangles.reserve(count);
+  this->nodes.emplace_back();
+  std::vector<std::pair<uint32_t, TreeRef>> stack;
+  stack.emplace_back(0u, resolve({0u, 0u}));
+  while (!stack.empty())
+  {
+    const uint32_t index = stack.back().first;
+    const TreeRef ref = stack.back().second;
+    stack.pop_back();
+
+    std::array<TreeRef, 4> lanes;
+    std::size_t laneCount = 0u;
+    if (node(ref).count > 0u)
+    {
+      lanes[laneCount++] = ref;
+    }
+    else
+    {
+      lanes[laneCount++] = resolve({ref.tree, node(ref).children[0]});
+      lanes[laneCount++] = resolve({ref.tree, node(ref).children[1]});
+    }
+    while (laneCount < lanes.size())
+    {
+      std::size_t largest = laneCount;
+      for (std::size_t l = 0; l < laneCount; ++l)
+      {
+        if (node(lanes[l]).count == 0u && (largest == laneCount ||
+              node(lanes[l]).area > node(lanes[largest]).area))
+        {
+          largest = l;
+        }
+      }
+      if (largest == laneCount)
+        break;
+      const TreeRef split = lanes[largest];
+      lanes[largest] = resolve({split.tree, node(split).children[0]});
+      lanes[laneCount++] = resolve({split.tree, node(split).children[1]});
+    }
+
+    for (std::size_t l = 0; l < laneCount; ++l)
+    {
+      const BuildNode &child = node(lanes[l]);
+      if (child.count > 0u)
+      {
+        this->nodes[index].child[l] =
+          static_cast<uint32_t>(this->triangles.size());
+        this->nodes[index].count[l] = child.count;
+        for (uint32_t i = child.first; i < child.first + child.count; ++i)
+          this->triangles.push_back(refs[primitives[i].index]);
+      }
+      else
+      {
+        const uint32_t childIndex = static_cast<uint32_t>(this->nodes.size());
+        this->nodes.emplace_back();
+        this->nodes[index].child[l] = childIndex;
+        this->nodes[index].count[l] = kInterior;
+        stack.emplace_back(childIndex, lanes[l]);
+      }
+    }
+  }
+
+  this->CopyCorners(positions);
+  this->Refit();
+}
+
+/////////////////////////////////////////////////
+void MeshBvh::Implementation::CopyCorners(
+    const std::vector<std::vector<double>> &_positions)
+{
+  this->corners.resize(this->triangles.size() * 9u);
+  ParallelFor(0u, this->triangles.size(), kGrain,
+      [&](const std::size_t _first, const std::size_t _last)
+      {
+        for (std::size_t i = _first; i < _last; ++i)
+        {
+          const TriangleRef &ref = this->triangles[i];
+          const std::vector<double> &positions = _positions[ref.subMesh];
+          if (positions.empty())
+            continue;
+          const unsigned int *indices =
+            this->sources[ref.subMesh].subMesh->IndexData() +
+            ref.triangle * 3u;
+          for (int c = 0; c < 3; ++c)
+          {
+            std::copy_n(&positions[indices[c] * 3u], 3u,
+                &this->corners[i * 9u + c * 3u]);
+          }
+        }
+      });
+}
+
+/////////////////////////////////////////////////
+void MeshBvh::Implementation::Refit()
+{
+  // Children are stored after their parent
+  Box all;
+  for (std::size_t n = this->nodes.size(); n-- > 0u;)
+  {
+    Node4 &node = this->nodes[n];
+    for (int l = 0; l < 4; ++l)
+    {
+      if (node.count[l] == 0u)
+        continue;
+
+      Box box;
+      if (node.count[l] == kInterior)
+      {
+        const Node4 &child = this->nodes[node.child[l]];
+        for (int c = 0; c < 4; ++c)
+        {
+          if (child.count[c] == 0u)
+            continue;
+          for (int a = 0; a < 3; ++a)
+          {
+            box.lo[a] = std::min(box.lo[a],
+                static_cast<double>(child.lo[a][c]));
+            box.hi[a] = std::max(box.hi[a],
+                static_cast<double>(child.hi[a][c]));
+          }
+        }
+      }
+      else
+      {
+        const uint32_t end = node.child[l] + node.count[l];
+        for (uint32_t t = node.child[l]; t < end; ++t)
+        {
+          for (int c = 0; c < 3; ++c)
+            box.Grow(&this->corners[t * 9u + c * 3u]);
+        }
+        all.Grow(box);
+      }
+
+      for (int a = 0; a < 3; ++a)
+      {
+        node.lo[a][l] = RoundDown(box.lo[a]);
+        node.hi[a][l] = RoundUp(box.hi[a]);
+      }
+    }
+  }
+
+  this->box = math::AxisAlignedBox();
+  if (!this->triangles.empty())
+  {
+    this->box = math::AxisAlignedBox(
+        math::Vector3d(all.lo[0], all.lo[1], all.lo[2]),
+        math::Vector3d(all.hi[0], all.hi[1], all.hi[2]));
+  }
+}
+
+/////////////////////////////////////////////////
+MeshBvh::MeshBvh()
+: dataPtr(ignition::utils::MakeImpl<Implementation>())
+{
+}
+
+/////////////////////////////////////////////////
+MeshBvh::~MeshBvh()
+{
+}
+
+/////////////////////////////////////////////////
+void MeshBvh::Build(const Mesh &_mesh)
+{
+  this->dataPtr->sources.clear();
+  for (unsigned int i = 0; i < _mesh.SubMeshCount(); ++i)
+  {
+    Source source;
+    source.subMesh = _mesh.SubMeshByIndex(i).lock();
+    if (!source.subMesh)
+      source.subMesh = std::make_shared<SubMesh>();
+    this->dataPtr->sources.push_back(source);
+  }
+  this->dataPtr->Rebuild();
+}
+
+/////////////////////////////////////////////////
+bool MeshBvh::Update()
+{
+  std::vector<std::vector<double>> positions(this->dataPtr->sources.size());
+  bool moved = false;
+  for (std::size_t s = 0; s < this->dataPtr->sources.size(); ++s)
+  {
+    Source &source = this->dataPtr->sources[s];
+    const SubMesh &subMesh = *source.subMesh;
+    if (subMesh.IndexRevision() != source.indexRevision ||
+        subMesh.VertexCount() != source.vertexCount)
+    {
+      this->dataPtr->Rebuild();
+      return true;
+    }
+
+    if (subMesh.VertexRevision() != source.vertexRevision)
+    {
+      source.vertexRevision = subMesh.VertexRevision();
+      if (subMesh.SubMeshPrimitiveType() == SubMesh::TRIANGLES &&
+          source.vertexCount > 0u)
+      {
+        positions[s].resize(source.vertexCount * 3u);
+        subMesh.FillVertexBuffer(positions[s].data());
+      }
+      moved = true;
+    }
+  }
+
+  if (moved)
+  {
+    this->dataPtr->CopyCorners(positions);
+    this->dataPtr->Refit();
+  }
+  return moved;
+}
+
+/////////////////////////////////////////////////
+bool MeshBvh::UpToDate() const
+{
+  for (const Source &source : this->dataPtr->sources)
+  {
+    const SubMesh &subMesh = *source.subMesh;
+    if (subMesh.IndexRevision() != source.indexRevision ||
+        subMesh.VertexCount() != source.vertexCount ||
+        subMesh.VertexRevision() != source.vertexRevision)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+unsigned int MeshBvh::TriangleCount() const
+{
+  return static_cast<unsigned int>(this->dataPtr->triangles.size());
+}
+
+/////////////////////////////////////////////////
+unsigned int MeshBvh::NodeCount() const
+{
+  return static_cast<unsigned int>(this->dataPtr->nodes.size());
+}
+
+/////////////////////////////////////////////////
+math::AxisAlignedBox MeshBvh::BoundingBox() const
+{
+  return this->dataPtr->box;
+}
+
+/////////////////////////////////////////////////
+bool MeshBvh::Raycast(const math::Vector3d &_origin,
+    const math::Vector3d &_direction, Hit &_hit,
+    const double _maxDistance) const
+{
+  const double length = _direction.Length();
+  if (this->dataPtr->nodes.empty() || !(length > 0.0))
+    return false;
+
+  const double origin[3] = {_origin.X(), _origin.Y(), _origin.Z()};
+  const double direction[3] =
+    {_direction.X() / length, _direction.Y() / length,
+     _direction.Z() / length};
+
+  Ray4 ray;
+  for (int a = 0; a < 3; ++a)
+  {
+    const double inverse = direction[a] == 0.0 ? kMaxInverse :
+      std::max(-kMaxInverse, std::min(kMaxInverse, 1.0 / direction[a]));
+#ifdef IGN_COMMON_MESHBVH_SSE
+    ray.origin[a] = _mm_set1_ps(static_cast<float>(origin[a]));
+    ray.inverse[a] = _mm_set1_ps(static_cast<float>(inverse));
+#else
+    ray.origin[a] = static_cast<float>(origin[a]);
+    ray.inverse[a] = static_cast<float>(inverse);
+#endif
+  }
+
+  double best = _maxDistance;
+  std::size_t bestTriangle = this->dataPtr->triangles.size();
+  std::array<StackEntry, kStackSize> stack;
+  std::size_t size = 0u;
+  stack[size++] = {0u, 0.0f};
+  while (size > 0u)
+  {
+    const StackEntry entry = stack[--size];
+    if (entry.distance > best)
+      continue;
+
+    const Node4 &node = this->dataPtr->nodes[entry.node];
+    float tNear[4];
+    int mask = IntersectLanes(node, ray,
+        static_cast<float>(std::min(best, 3e38)), tNear);
+
+    // Test leaves right away, and visit nodes from near to far
+    std::array<StackEntry, 4> children;
+    std::size_t childCount = 0u;
+    for (int l = 0; l < 4; ++l)
+    {
+      if (!(mask & (1 << l)) || node.count[l] == 0u)
+        continue;
+
+      if (node.count[l] == kInterior)
+      {
+        children[childCount++] = {node.child[l], tNear[l]};
+        continue;
+      }
+
+      const uint32_t end = node.child[l] + node.count[l];
+      for (uint32_t t = node.child[l]; t < end; ++t)
+      {
+        double distance;
+        if (IntersectTriangle(&this->dataPtr->corners[t * 9u], origin,
+              direction, distance) && distance <= best)
+        {
+          best = distance;
+          bestTriangle = t;
+        }
+      }
+    }
+    PushChildren(children, childCount, stack, size);
+  }
+
+  if (bestTriangle == this->dataPtr->triangles.size())
+    return false;
+
+  const TriangleRef &ref = this->dataPtr->triangles[bestTriangle];
+  _hit.subMesh = ref.subMesh;
+  _hit.triangle = ref.triangle;
+  _hit.distance = best;
+  _hit.point = _origin + _direction * (best / length);
+  _hit.normal = TriangleNormal(&this->dataPtr->corners[bestTriangle * 9u]);
+  return true;
+}
+
+/////////////////////////////////////////////////
+bool MeshBvh::ClosestPoint(const math::Vector3d &_point, Hit &_hit,
+    const double _maxDistance) const
+{
+  if (this->dataPtr->nodes.empty())
+    return false;
+
+  double best = _maxDistance * _maxDistance;
+  std::size_t bestTriangle = this->dataPtr->triangles.size();
+  math::Vector3d bestPoint;
+  const double p[3] = {_point.X(), _point.Y(), _point.Z()};
+
+  std::array<StackEntry, kStackSize> stack;
+  std::size_t size = 0u;
+  stack[size++] = {0u, 0.0f};
+  while (size > 0u)
+  {
+    const StackEntry entry = stack[--size];
+    if (entry.distance > best)
+      continue;
+
+    const Node4 &node = this->dataPtr->nodes[entry.node];
+    std::array<StackEntry, 4> children;
+    std::size_t childCount = 0u;
+    for (int l = 0; l < 4; ++l)
+    {
+      if (node.count[l] == 0u)
+        continue;
+
+      double distance = 0.0;
+      for (int a = 0; a < 3; ++a)
+      {
+        const double d = std::max({0.0, node.lo[a][l] - p[a],
+            p[a] - node.hi[a][l]});
+        distance += d * d;
+      }
+      if (distance > best)
+        continue;
+
+      if (node.count[l] == kInterior)
+      {
+        // Round down so that the bound stays a lower bound
+        children[childCount++] = {node.child[l], RoundDown(distance)};
+        continue;
+      }
+
+      const uint32_t end = node.child[l] + node.count[l];
+      for (uint32_t t = node.child[l]; t < end; ++t)
+      {
+        const math::Vector3d closest = ClosestPointOnTriangle(
+            &this->dataPtr->corners[t * 9u], _point);
+        const double d = (closest - _point).SquaredLength();
+        if (d <= best)
+        {
+          best = d;
+          bestTriangle = t;
+          bestPoint = closest;
+        }
+      }
+    }
+    PushChildren(children, childCount, stack, size);
+  }
+
+  if (bestTriangle == this->dataPtr->triangles.size())
+    return false;
+
+  const TriangleRef &ref = this->dataPtr->triangles[bestTriangle];
+  _hit.subMesh = ref.subMesh;
+  _hit.triangle = ref.triangle;
+  _hit.distance = std::sqrt(best);
+  _hit.point = bestPoint;
+  _hit.normal = TriangleNormal(&this->dataPtr->corners[bestTriangle * 9u]);
+  return true;
+}
+
+/////////////////////////////////////////////////
+void MeshBvh::Overlap(const math::AxisAlignedBox &_box,
+    std::vector<Hit> &_hits) const
+{
+  _hits.clear();
+  const math::Vector3d &lo = _box.Min();
+  const math::Vector3d &hi = _box.Max();
+  if (this->dataPtr->nodes.empty() || !(lo.X() <= hi.X()) ||
+      !(lo.Y() <= hi.Y()) || !(lo.Z() <= hi.Z()))
+  {
+    return;
+  }
+
+  const math::Vector3d center = (lo + hi) * 0.5;
+  const math::Vector3d half = (hi - lo) * 0.5;
+  std::array<uint32_t, kStackSize> stack;
+  std::size_t size = 0u;
+  stack[size++] = 0u;
+  while (size > 0u)
+  {
+    const Node4 &node = this->dataPtr->nodes[stack[--size]];
+    for (int l = 0; l < 4; ++l)
+    {
+      if (node.count[l] == 0u ||
+          node.lo[0][l] > hi.X() || node.hi[0][l] < lo.X() ||
+          node.lo[1][l] > hi.Y() || node.hi[1][l] < lo.Y() ||
+          node.lo[2][l] > hi.Z() || node.hi[2][l] < lo.Z())
+      {
+        continue;
+      }
+
+      if (node.count[l] == kInterior)
+      {
+        stack[size++] = node.child[l];
+        continue;
+      }
+
+      const uint32_t end = node.child[l] + node.count[l];
+      for (uint32_t t = node.child[l]; t < end; ++t)
+      {
+        const double *corners = &this->dataPtr->corners[t * 9u];
+        if (!TriangleOverlapsBox(corners, center, half))
+          continue;
+
+        Hit hit;
+        hit.subMesh = this->dataPtr->triangles[t].subMesh;
+        hit.triangle = this->dataPtr->triangles[t].triangle;
+        hit.normal = TriangleNormal(corners);
+        _hits.push_back(hit);
+      }
+    }
+  }
+}
@@ -0,0 +1,409 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "test_config.h"
+#include "ignition/common/Mesh.hh"
+#include "ignition/common/MeshBvh.hh"
+#include "ignition/common/MeshManager.hh"
+#include "ignition/common/SubMesh.hh"
+
+using namespace ignition;
+
+class MeshBvh : public common::testing::AutoLogFixture { };
+
+/////////////////////////////////////////////////
+/// \brief Create a wavy grid in the xy plane
+/// \param[in] _size Number of vertices along each side
+/// \param[in] _offset Offset added to every vertex
+/// \return The grid, spanning [0, 1] along x and y
+std::unique_ptr<common::SubMesh> Grid(const unsigned int _size,
+    const math::Vector3d &_offset = math::Vector3d::Zero)
+{
+  auto subMesh = std::make_unique<common::SubMesh>("grid");
+  const double step = 1.0 / (_size - 1);
+  for (unsigned int y = 0; y < _size; ++y)
+  {
+    for (unsigned int x = 0; x < _size; ++x)
+    {
+      subMesh->AddVertex(math::Vector3d(x * step, y * step,
+            0.1 * std::sin(x * step * 7.0) * std::cos(y * step * 5.0)) +
+          _offset);
+    }
+  }
+  for (unsigned int y = 0; y + 1 < _size; ++y)
+  {
+    for (unsigned int x = 0; x + 1 < _size; ++x)
+    {
+      const unsigned int i = y * _size + x;
+      for (const unsigned int index : {i, i + 1, i + _size + 1,
+          i, i + _size + 1, i + _size})
+      {
+        subMesh->AddIndex(index);
+      }
+    }
+  }
+  return subMesh;
+}
+
+/////////////////////////////////////////////////
+/// \brief Find the first triangle hit by a ray by testing all triangles
+/// \param[in] _mesh Mesh
+/// \param[in] _origin Origin of the ray
+/// \param[in] _direction Unit direction of the ray
+/// \return Distance of the hit, or infinity
+double BruteForceRaycast(const common::Mesh &_mesh,
+    const math::Vector3d &_origin, const math::Vector3d &_direction)
+{
+  double best = std::numeric_limits<double>::infinity();
+  for (unsigned int s = 0; s < _mesh.SubMeshCount(); ++s)
+  {
+    auto subMesh = _mesh.SubMeshByIndex(s).lock();
+    if (subMesh->SubMeshPrimitiveType() != common::SubMesh::TRIANGLES)
+      continue;
+    for (unsigned int i = 0; i + 2 < subMesh->IndexCount(); i += 3)
+    {
+      const math::Vector3d a = subMesh->Vertex(subMesh->Index(i));
+      const math::Vector3d e1 = subMesh->Vertex(subMesh->Index(i + 1)) - a;
+      const math::Vector3d e2 = subMesh->Vertex(subMesh->Index(i + 2)) - a;
+      const math::Vector3d n = e1.Cross(e2);
+      const double denom = n.Dot(_direction);
+      if (denom == 0.0)
+        continue;
+      const double t = n.Dot(a - _origin) / denom;
+      const math::Vector3d p = _origin + _direction * t - a;
+      const double u = p.Cross(e2).Dot(n) / n.SquaredLength();
+      const double v = e1.Cross(p).Dot(n) / n.SquaredLength();
+      if (t >= 0.0 && u >= 0.0 && v >= 0.0 && u + v <= 1.0)
+        best = std::min(best, t);
+    }
+  }
+  return best;
+}
+
+/////////////////////////////////////////////////
+/// \brief Find the smallest distance from a point to the vertices and
+/// edge midpoints of a mesh, which bounds the distance to the mesh from
+/// above
+/// \param[in] _mesh Mesh
+/// \param[in] _point Query point
+/// \return Distance
+double DistanceToSamples(const common::Mesh &_mesh,
+    const math::Vector3d &_point)
+{
+  double best = std::numeric_limits<double>::infinity();
+  for (unsigned int s = 0; s < _mesh.SubMeshCount(); ++s)
+  {
+    auto subMesh = _mesh.SubMeshByIndex(s).lock();
+    for (unsigned int i = 0; i + 2 < subMesh->IndexCount(); i += 3)
+    {
+      for (unsigned int c = 0; c < 3; ++c)
+      {
+        const math::Vector3d a = subMesh->Vertex(subMesh->Index(i + c));
+        const math::Vector3d b =
+          subMesh->Vertex(subMesh->Index(i + (c + 1) % 3));
+        best = std::min({best, a.Distance(_point),
+            ((a + b) * 0.5).Distance(_point)});
+      }
+    }
+  }
+  return best;
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshBvh, Raycast)
+{
+  // Enough triangles for subtrees to be built in parallel
+  common::Mesh mesh;
+  mesh.AddSubMesh(Grid(129));
+  mesh.AddSubMesh(Grid(9, math::Vector3d(0.25, 0.25, 0.5)));
+  auto lines = Grid(3, math::Vector3d(0, 0, 5));
+  lines->SetPrimitiveType(common::SubMesh::LINES);
+  mesh.AddSubMesh(std::move(lines));
+
+  common::MeshBvh bvh;
+  EXPECT_EQ(0u, bvh.TriangleCount());
+  common::MeshBvh::Hit hit;
+  EXPECT_FALSE(bvh.Raycast(math::Vector3d::Zero, math::Vector3d::UnitZ,
+        hit));
+
+  bvh.Build(mesh);
+  EXPECT_EQ(128u * 128u * 2u + 8u * 8u * 2u, bvh.TriangleCount());
+  EXPECT_GT(bvh.NodeCount(), bvh.TriangleCount() / 32u);
+  EXPECT_EQ(mesh.SubMeshByIndex(0).lock()->Min(), bvh.BoundingBox().Min());
+  EXPECT_EQ(mesh.SubMeshByIndex(1).lock()->Max(), bvh.BoundingBox().Max());
+
+  // Rays from above, from below and sideways
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> coord(-0.2, 1.2);
+  std::uniform_real_distribution<double> angle(-0.6, 0.6);
+  for (int i = 0; i < 500; ++i)
+  {
+    const double side = i % 2 ? 1.0 : -1.0;
+    const math::Vector3d origin(coord(rng), coord(rng), side * 2.0);
+    const math::Vector3d direction = math::Vector3d(angle(rng), angle(rng),
+        -side).Normalize();
+    const double expected = BruteForceRaycast(mesh, origin, direction);
+
+    // The direction doesn't need to be normalized
+    const bool found = bvh.Raycast(origin, direction * 3.0, hit);
+    ASSERT_EQ(std::isfinite(expected), found) << i;
+    if (!found)
+      continue;
+    EXPECT_NEAR(expected, hit.distance, 1e-9) << i;
+    EXPECT_EQ(origin + direction * hit.distance, hit.point);
+    EXPECT_NEAR(1.0, hit.normal.Length(), 1e-9);
+    EXPECT_NEAR(0.0, (hit.point - mesh.SubMeshByIndex(hit.subMesh).lock()->
+          Vertex(mesh.SubMeshByIndex(hit.subMesh).lock()->Index(
+              hit.triangle * 3u))).Dot(hit.normal), 1e-9);
+
+    // Limited distance
+    common::MeshBvh::Hit near;
+    EXPECT_FALSE(bvh.Raycast(origin, direction, near, expected * 0.99));
+    EXPECT_TRUE(bvh.Raycast(origin, direction, near, expected * 1.01));
+  }
+
+  // Upper grid first, and rays along an axis
+  ASSERT_TRUE(bvh.Raycast(math::Vector3d(0.5, 0.5, 3),
+        -math::Vector3d::UnitZ, hit));
+  EXPECT_EQ(1u, hit.subMesh);
+  EXPECT_NEAR(3.0 - 0.5 - 0.1 * std::sin(0.25 * 7.0) * std::cos(0.25 * 5.0),
+      hit.distance, 1e-9);
+  EXPECT_LT(hit.triangle, 128u);
+  EXPECT_FALSE(bvh.Raycast(math::Vector3d(-1, 0.5, 0.05),
+        -math::Vector3d::UnitX, hit));
+  EXPECT_FALSE(bvh.Raycast(math::Vector3d(0.5, 0.5, 3), math::Vector3d::Zero,
+        hit));
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshBvh, ClosestPoint)
+{
+  common::MeshManager::Instance()->CreateSphere("bvh_sphere", 1.0f, 16, 16);
+  const common::Mesh *sphere =
+    common::MeshManager::Instance()->MeshByName("bvh_sphere");
+  ASSERT_NE(nullptr, sphere);
+
+  common::MeshBvh bvh;
+  bvh.Build(*sphere);
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> coord(-2.0, 2.0);
+  common::MeshBvh::Hit hit;
+  for (int i = 0; i < 200; ++i)
+  {
+    const math::Vector3d point(coord(rng), coord(rng), coord(rng));
+    ASSERT_TRUE(bvh.ClosestPoint(point, hit));
+    EXPECT_NEAR(hit.distance, hit.point.Distance(point), 1e-9);
+    EXPECT_LE(hit.distance, DistanceToSamples(*sphere, point) + 1e-9);
+
+    // The tessellated sphere is within 0.05 of the unit sphere
+    EXPECT_NEAR(std::abs(point.Length() - 1.0), hit.distance, 0.05);
+    EXPECT_LE(hit.point.Length(), 1.0 + 1e-6);
+
+    common::MeshBvh::Hit near;
+    EXPECT_FALSE(bvh.ClosestPoint(point, near, hit.distance * 0.99));
+  }
+
+  // Point on the surface
+  ASSERT_TRUE(bvh.ClosestPoint(math::Vector3d(0, 0, 1), hit));
+  EXPECT_NEAR(0.0, hit.distance, 1e-6);
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshBvh, Overlap)
+{
+  common::Mesh mesh;
+  auto grid = Grid(33);
+  const common::SubMesh original = *grid;
+  mesh.AddSubMesh(std::move(grid));
+
+  common::MeshBvh bvh;
+  bvh.Build(mesh);
+  std::vector<common::MeshBvh::Hit> hits;
+  bvh.Overlap(math::AxisAlignedBox(math::Vector3d(0.3, 0.3, -1),
+        math::Vector3d(0.5, 0.6, 1)), hits);
+
+  // Every triangle with a corner inside the box is found, and only
+  // triangles whose box intersects the query box
+  std::vector<bool> found(original.IndexCount() / 3u, false);
+  for (const auto &h : hits)
+  {
+    EXPECT_EQ(0u, h.subMesh);
+    ASSERT_LT(h.triangle, found.size());
+    EXPECT_FALSE(found[h.triangle]);
+    found[h.triangle] = true;
+  }
+  for (unsigned int t = 0; t < found.size(); ++t)
+  {
+    bool inside = false;
+    math::Vector3d lo(1e9, 1e9, 1e9);
+    math::Vector3d hi(-1e9, -1e9, -1e9);
+    for (unsigned int c = 0; c < 3; ++c)
+    {
+      const math::Vector3d v = original.Vertex(original.Index(t * 3 + c));
+      inside = inside || (v.X() >= 0.3 && v.X() <= 0.5 && v.Y() >= 0.3 &&
+          v.Y() <= 0.6);
+      lo.Min(v);
+      hi.Max(v);
+    }
+    if (inside)
+    {
+      EXPECT_TRUE(found[t]) << t;
+    }
+    if (lo.X() > 0.5 || hi.X() < 0.3 || lo.Y() > 0.6 || hi.Y() < 0.3)
+    {
+      EXPECT_FALSE(found[t]) << t;
+    }
+  }
+
+  // A thin box above the surface touches nothing, and the capacity of the
+  // hits is reused
+  bvh.Overlap(math::AxisAlignedBox(math::Vector3d(0.3, 0.3, 0.2),
+        math::Vector3d(0.5, 0.6, 0.3)), hits);
+  EXPECT_TRUE(hits.empty());
+  EXPECT_GT(hits.capacity(), 0u);
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshBvh, Update)
+{
+  common::Mesh mesh;
+  mesh.AddSubMesh(Grid(17));
+  auto subMesh = mesh.SubMeshByIndex(0).lock();
+  common::MeshBvh bvh;
+  bvh.Build(mesh);
+  EXPECT_FALSE(bvh.Update());
+
+  // Moved vertices are refit
+  const unsigned int nodes = bvh.NodeCount();
+  subMesh->Translate(math::Vector3d(0, 0, 1));
+  subMesh->SetVertex(0, math::Vector3d(0, 0, -3));
+  EXPECT_TRUE(bvh.Update());
+  EXPECT_FALSE(bvh.Update());
+  EXPECT_EQ(nodes, bvh.NodeCount());
+  EXPECT_EQ(-3.0, bvh.BoundingBox().Min().Z());
+
+  common::MeshBvh::Hit hit;
+  ASSERT_TRUE(bvh.Raycast(math::Vector3d(0.5, 0.5, 3),
+        -math::Vector3d::UnitZ, hit));
+  EXPECT_NEAR(2.0 - subMesh->Vertex(8 * 17 + 8).Z() + 1.0, hit.distance,
+      1e-9);
+
+  // New triangles rebuild the hierarchy
+  const unsigned int triangles = bvh.TriangleCount();
+  subMesh->AddVertex(0, 0, 5);
+  subMesh->AddIndex(0);
+  subMesh->AddIndex(1);
+  subMesh->AddIndex(subMesh->VertexCount() - 1);
+  EXPECT_TRUE(bvh.Update());
+  EXPECT_EQ(triangles + 1u, bvh.TriangleCount());
+  EXPECT_EQ(5.0, bvh.BoundingBox().Max().Z());
+
+  // Changing the primitive type removes the triangles
+  subMesh->SetPrimitiveType(common::SubMesh::LINES);
+  EXPECT_TRUE(bvh.Update());
+  EXPECT_EQ(0u, bvh.TriangleCount());
+  EXPECT_FALSE(bvh.Raycast(math::Vector3d(0.5, 0.5, 3),
+        -math::Vector3d::UnitZ, hit));
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshBvh, MeshManager)
+{
+  auto *mgr = common::MeshManager::Instance();
+  EXPECT_EQ(nullptr, mgr->Bvh("bvh_missing"));
+
+  mgr->CreateBox("bvh_box", math::Vector3d(2, 2, 2), math::Vector2d::One);
+  std::shared_ptr<const common::MeshBvh> bvh = mgr->Bvh("bvh_box");
+  ASSERT_NE(nullptr, bvh);
+  EXPECT_EQ(12u, bvh->TriangleCount());
+  EXPECT_TRUE(bvh->UpToDate());
+  EXPECT_EQ(bvh, mgr->Bvh("bvh_box"));
+
+  common::MeshBvh::Hit hit;
+  ASSERT_TRUE(bvh->Raycast(math::Vector3d(0.2, 0.3, 5),
+        -math::Vector3d::UnitZ, hit));
+  EXPECT_NEAR(4.0, hit.distance, 1e-9);
+  EXPECT_EQ(math::Vector3d::UnitZ, hit.normal);
+
+  // Later calls see moved vertices in a new hierarchy, and the one handed
+  // out before is left as it was
+  auto mesh = const_cast<common::Mesh *>(mgr->MeshByName("bvh_box"));
+  mesh->Translate(math::Vector3d(0, 0, 1));
+  EXPECT_FALSE(bvh->UpToDate());
+  std::shared_ptr<const common::MeshBvh> moved = mgr->Bvh("bvh_box");
+  ASSERT_NE(nullptr, moved);
+  EXPECT_NE(bvh, moved);
+  EXPECT_TRUE(moved->UpToDate());
+  EXPECT_EQ(moved, mgr->Bvh("bvh_box"));
+  ASSERT_TRUE(moved->Raycast(math::Vector3d(0.2, 0.3, 5),
+        -math::Vector3d::UnitZ, hit));
+  EXPECT_NEAR(3.0, hit.distance, 1e-9);
+  ASSERT_TRUE(bvh->Raycast(math::Vector3d(0.2, 0.3, 5),
+        -math::Vector3d::UnitZ, hit));
+  EXPECT_NEAR(4.0, hit.distance, 1e-9);
+
+  // Hierarchies that were handed out give the same answers while the mesh
+  // moves and other calls refit new ones
+  std::atomic<bool> stop(false);
+  std::atomic<int> wrong(0);
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t)
+  {
+    readers.emplace_back([&]
+        {
+          while (!stop)
+          {
+            common::MeshBvh::Hit readerHit;
+            if (!moved->Raycast(math::Vector3d(0.2, 0.3, 5),
+                  -math::Vector3d::UnitZ, readerHit) ||
+                std::abs(readerHit.distance - 3.0) > 1e-9)
+            {
+              ++wrong;
+            }
+          }
+        });
+  }
+  for (int i = 0; i < 200; ++i)
+  {
+    mesh->Translate(math::Vector3d(0, 0, i % 2 == 0 ? 1 : -1));
+    std::shared_ptr<const common::MeshBvh> current = mgr->Bvh("bvh_box");
+    ASSERT_NE(nullptr, current);
+    ASSERT_TRUE(current->Raycast(math::Vector3d(0.2, 0.3, 5),
+          -math::Vector3d::UnitZ, hit));
+    EXPECT_NEAR(i % 2 == 0 ? 2.0 : 3.0, hit.distance, 1e-9);
+  }
+  stop = true;
+  for (auto &reader : readers)
+    reader.join();
+  EXPECT_EQ(0, wrong.load());
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,1320 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <ignition/math/Vector3.hh>
+
+#include "ignition/common/Mesh.hh"
+#include "ignition/common/MeshConvexDecomposition.hh"
+#include "ignition/common/Parallel.hh"
+#include "ignition/common/SubMesh.hh"
+
+using namespace ignition;
+using namespace common;
+
+/// \brief Private data for the MeshConvexDecomposition class
+class ignition::common::MeshConvexDecomposition::Implementation
+{
+  /// \brief Largest number of hulls of a submesh
+  public: unsigned int maxConvexHulls = 16u;
+
+  /// \brief Largest number of vertices of a hull
+  public: unsigned int maxVerticesPerHull = 64u;
+
+  /// \brief Concavity below which a piece is not cut, relative to the
+  /// diagonal of the bounding box of the submesh
+  public: double maxConcavity = 0.01;
+};
+
+namespace
+{
+  /// \brief Number of candidate planes per axis of a cut
+  const unsigned int kPlanesPerAxis = 8u;
+
+  /// \brief Relative difference of cost below which candidate planes are
+  /// considered equally good
+  const double kCostTolerance = 0.01;
+
+  /// \brief Largest number of triangles cut to evaluate a candidate plane
+  const std::size_t kMaxEvaluatedTriangles = 1024u;
+
+  /// \brief Largest number of hull vertices used to evaluate a candidate
+  /// plane
+  const std::size_t kMaxOutlineVertices = 256u;
+
+  /// \brief Largest number of triangles whose depth is measured to compute
+  /// the concavity of a piece
+  const std::size_t kMaxConcavitySamples = 512u;
+
+  /// \brief Distance below which a point is on a plane, relative to the
+  /// magnitude of the coordinates
+  const double kRelativeTolerance = 1e-9;
+
+  /// \brief Number of vertices of hulls that are not limited
+  const std::size_t kUnlimited = std::numeric_limits<std::size_t>::max();
+
+  /// \brief Infinity
+  const double kInfinity = std::numeric_limits<double>::infinity();
+
+  /// \brief Corners of a triangle
+  using Triangle = std::array<math::Vector3d, 3>;
+
+  /// \brief Convex hull of a set of points, computed with quickhull
+  class Hull
+  {
+    /// \brief Compute the hull of points. When the number of vertices is
+    /// limited, points farthest out of the current hull are added first.
+    /// \param[in] _points Points
+    /// \param[in] _maxVertices Largest number of vertices, at least 4
+    /// \return False if the points are on a plane
+    public: bool Compute(const std::vector<math::Vector3d> &_points,
+                const std::size_t _maxVertices);
+
+    /// \brief Get the vertices of the hull
+    /// \return Vertices
+    public: const std::vector<math::Vector3d> &Vertices() const;
+
+    /// \brief Get the depth of a point below the surface of the hull
+    /// \param[in] _point Point
+    /// \return Distance to the closest face plane, negative outside
+    public: double Depth(const math::Vector3d &_point) const;
+
+    /// \brief Get the volume of the hull
+    /// \return Volume
+    public: double Volume() const;
+
+    /// \brief Create a submesh of the hull
+    /// \return Indexed triangle list
+    public: std::unique_ptr<SubMesh> Output() const;
+
+    /// \brief Face of the hull while it is computed
+    private: struct Face
+    {
+      /// \brief Indices of the corners in the points, counterclockwise
+      /// seen from outside
+      std::array<unsigned int, 3> corners{};
+
+      /// \brief Face across the edge from corners[i] to corners[i + 1]
+      std::array<unsigned int, 3> neighbors{};
+
+      /// \brief Outward unit normal
+      math::Vector3d normal;
+
+      /// \brief Dot product of the normal with points on the face
+      double offset = 0.0;
+
+      /// \brief Points above the face which were assigned to it
+      std::vector<unsigned int> outside;
+
+      /// \brief Point of outside farthest above the face
+      unsigned int farthest = 0u;
+
+      /// \brief Distance of farthest above the face
+      double farthestDistance = 0.0;
+
+      /// \brief False once the face is removed
+      bool alive = true;
+
+      /// \brief Last search that found the face visible
+      unsigned int visit = 0u;
+    };
+
+    /// \brief Edge of a face
+    private: struct Edge
+    {
+      /// \brief Index of the face
+      unsigned int face;
+
+      /// \brief Index of the edge in the face
+      unsigned int edge;
+    };
+
+    /// \brief Add a face
+    /// \param[in] _a First corner
+    /// \param[in] _b Second corner
+    /// \param[in] _c Third corner
+    /// \return Index of the face
+    private: unsigned int AddFace(const unsigned int _a,
+                 const unsigned int _b, const unsigned int _c);
+
+    /// \brief Get the distance of a point above a face
+    /// \param[in] _face Face
+    /// \param[in] _point Index of the point
+    /// \return Signed distance
+    private: double Distance(const Face &_face,
+                 const unsigned int _point) const;
+
+    /// \brief Assign points to the face they are farthest above, and queue
+    /// the faces that got points. Points that are above no face are inside
+    /// the hull and dropped.
+    /// \param[in] _points Indices of the points
+    /// \param[in] _first First face that may get points
+    /// \param[in] _last One past the last face that may get points
+    private: void Assign(const std::vector<unsigned int> &_points,
+                 const unsigned int _first, const unsigned int _last);
+
+    /// \brief Find the farthest point of a face and queue the face
+    /// \param[in] _face Index of the face
+    private: void Queue(const unsigned int _face);
+
+    /// \brief Add a point to the hull, replacing the faces it sees
+    /// \param[in] _face Face whose farthest point is added
+    /// \return False if the faces seen by the point don't form a disc, in
+    /// which case the point is dropped
+    private: bool AddPoint(const unsigned int _face);
+
+    /// \brief Points of the hull being computed
+    private: const std::vector<math::Vector3d> *points = nullptr;
+
+    /// \brief Distance below which a point is on a face
+    private: double tolerance = 0.0;
+
+    /// \brief Faces, including removed ones
+    private: std::vector<Face> faces;
+
+    /// \brief Faces with outside points, farthest first
+    private: std::priority_queue<std::pair<double, unsigned int>> queue;
+
+    /// \brief Index of the current visibility search
+    private: unsigned int visit = 0u;
+
+    /// \brief Vertices of the hull
+    private: std::vector<math::Vector3d> vertices;
+
+    /// \brief Corners of the triangles of the hull, in vertices
+    private: std::vector<unsigned int> indices;
+
+    /// \brief Outward unit normals of the triangles
+    private: std::vector<math::Vector3d> normals;
+
+    /// \brief Offsets of the triangle planes along their normals
+    private: std::vector<double> offsets;
+  };
+
+  //////////////////////////////////////////////////
+  bool Hull::Compute(const std::vector<math::Vector3d> &_points,
+      const std::size_t _maxVertices)
+  {
+    this->faces.clear();
+    this->queue = {};
+    this->vertices.clear();
+    this->indices.clear();
+    this->normals.clear();
+    this->offsets.clear();
+    this->points = &_points;
+    if (_points.size() < 4u)
+      return false;
+
+    // Extreme points along every axis, and the magnitude of the coordinates
+    const unsigned int count = static_cast<unsigned int>(_points.size());
+    std::array<unsigned int, 6> extremes{};
+    math::Vector3d magnitude;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      const math::Vector3d &p = _points[i];
+      for (unsigned int axis = 0; axis < 3u; ++axis)
+      {
+        if (p[axis] < _points[extremes[axis * 2u]][axis])
+          extremes[axis * 2u] = i;
+        if (p[axis] > _points[extremes[axis * 2u + 1u]][axis])
+          extremes[axis * 2u + 1u] = i;
+        magnitude[axis] = std::max(magnitude[axis], std::abs(p[axis]));
+      }
+    }
+    this->tolerance = kRelativeTolerance * magnitude.Sum();
+
+    // Initial tetrahedron: the two extremes farthest apart, the point
+    // farthest from their line and the point farthest from the plane of
+    // these three
+    unsigned int a = 0u;
+    unsigned int b = 0u;
+    double best = 0.0;
+    for (unsigned int axis = 0; axis < 3u; ++axis)
+    {
+      const double distance = _points[extremes[axis * 2u]].Distance(
+          _points[extremes[axis * 2u + 1u]]);
+      if (distance > best)
+      {
+        best = distance;
+        a = extremes[axis * 2u];
+        b = extremes[axis * 2u + 1u];
+      }
+    }
+    if (best <= this->tolerance)
+      return false;
+
+    const math::Vector3d direction = (_points[b] - _points[a]) / best;
+    unsigned int c = 0u;
+    best = 0.0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      const double distance =
+        (_points[i] - _points[a]).Cross(direction).Length();
+      if (distance > best)
+      {
+        best = distance;
+        c = i;
+      }
+    }
+    if (best <= this->tolerance)
+      return false;
+
+    const math::Vector3d normal = (_points[b] - _points[a]).Cross(
+        _points[c] - _points[a]).Normalized();
+    unsigned int d = 0u;
+    best = 0.0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      const double distance = std::abs(normal.Dot(_points[i] - _points[a]));
+      if (distance > best)
+      {
+        best = distance;
+        d = i;
+      }
+    }
+    if (best <= this->tolerance)
+      return false;
+
+    // Face abc must face away from d
+    if (normal.Dot(_points[d] - _points[a]) > 0.0)
+      std::swap(b, c);
+    this->AddFace(a, b, c);
+    this->AddFace(a, d, b);
+    this->AddFace(b, d, c);
+    this->AddFace(c, d, a);
+    for (auto &face : this->faces)
+    {
+      for (unsigned int e = 0; e < 3u; ++e)
+      {
+        const unsigned int from = face.corners[e];
+        const unsigned int to = face.corners[(e + 1u) % 3u];
+        for (unsigned int f = 0; f < 4u; ++f)
+        {
+          const auto &other = this->faces[f].corners;
+          for (unsigned int o = 0; o < 3u; ++o)
+          {
+            if (other[o] == to && other[(o + 1u) % 3u] == from)
+              face.neighbors[e] = f;
+          }
+        }
+      }
+    }
+
+    std::vector<unsigned int> remaining;
+    remaining.reserve(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      if (i != a && i != b && i != c && i != d)
+        remaining.push_back(i);
+    }
+    this->Assign(remaining, 0u, 4u);
+
+    std::size_t vertexCount = 4u;
+    while (vertexCount < _maxVertices && !this->queue.empty())
+    {
+      const unsigned int face = this->queue.top().second;
+      this->queue.pop();
+      if (this->faces[face].alive && this->AddPoint(face))
+        ++vertexCount;
+    }
+
+    // Keep the live faces, with their corners renumbered
+    std::unordered_map<unsigned int, unsigned int> vertexIndex;
+    for (const auto &face : this->faces)
+    {
+      if (!face.alive)
+        continue;
+      for (const unsigned int corner : face.corners)
+      {
+        auto inserted = vertexIndex.emplace(corner,
+            static_cast<unsigned int>(this->vertices.size()));
+        if (inserted.second)
+          this->vertices.push_back(_points[corner]);
+        this->indices.push_back(inserted.first->second);
+      }
+      this->normals.push_back(face.normal);
+      this->offsets.push_back(face.offset);
+    }
+    this->faces.clear();
+    this->points = nullptr;
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  unsigned int Hull::AddFace(const unsigned int _a, const unsigned int _b,
+      const unsigned int _c)
+  {
+    const auto &p = *this->points;
+    Face face;
+    face.corners = {_a, _b, _c};
+    face.normal = (p[_b] - p[_a]).Cross(p[_c] - p[_a]).Normalized();
+    face.offset = face.normal.Dot(p[_a]);
+    this->faces.push_back(std::move(face));
+    return static_cast<unsigned int>(this->faces.size() - 1u);
+  }
+
+  //////////////////////////////////////////////////
+  double Hull::Distance(const Face &_face, const unsigned int _point) const
+  {
+    return _face.normal.Dot((*this->points)[_point]) - _face.offset;
+  }
+
+  //////////////////////////////////////////////////
+  void Hull::Assign(const std::vector<unsigned int> &_points,
+      const unsigned int _first, const unsigned int _last)
+  {
+    for (const unsigned int point : _points)
+    {
+      double best = this->tolerance;
+      unsigned int bestFace = _last;
+      for (unsigned int f = _first; f < _last; ++f)
+      {
+        const double distance = this->Distance(this->faces[f], point);
+        if (distance > best)
+        {
+          best = distance;
+          bestFace = f;
+        }
+      }
+      if (bestFace != _last)
+        this->faces[bestFace].outside.push_back(point);
+    }
+    for (unsigned int f = _first; f < _last; ++f)
+      this->Queue(f);
+  }
+
+  //////////////////////////////////////////////////
+  void Hull::Queue(const unsigned int _face)
+  {
+    Face &face = this->faces[_face];
+    if (face.outside.empty())
+      return;
+    face.farthestDistance = -1.0;
+    for (const unsigned int point : face.outside)
+    {
+      const double distance = this->Distance(face, point);
+      if (distance > face.farthestDistance)
+      {
+        face.farthestDistance = distance;
+        face.farthest = point;
+      }
+    }
+    this->queue.emplace(face.farthestDistance, _face);
+  }
+
+  //////////////////////////////////////////////////
+  bool Hull::AddPoint(const unsigned int _face)
+  {
+    const unsigned int eye = this->faces[_face].farthest;
+
+    // Faces seen from the point form a disc. Its border is the horizon.
+    ++this->visit;
+    std::vector<unsigned int> visible = {_face};
+    this->faces[_face].visit = this->visit;
+    std::vector<Edge> horizon;
+    for (std::size_t i = 0; i < visible.size(); ++i)
+    {
+      const unsigned int face = visible[i];
+      for (unsigned int e = 0; e < 3u; ++e)
+      {
+        const unsigned int neighbor = this->faces[face].neighbors[e];
+        Face &other = this->faces[neighbor];
+        if (other.visit == this->visit)
+          continue;
+        if (this->Distance(other, eye) > this->tolerance)
+        {
+          other.visit = this->visit;
+          visible.push_back(neighbor);
+        }
+        else
+        {
+          horizon.push_back({face, e});
+        }
+      }
+    }
+
+    // Every corner of the horizon must start and end exactly one edge.
+    // Otherwise rounding made the visible faces inconsistent.
+    std::unordered_map<unsigned int, unsigned int> starts;
+    std::unordered_map<unsigned int, unsigned int> ends;
+    for (unsigned int h = 0; h < horizon.size(); ++h)
+    {
+      const auto &corners = this->faces[horizon[h].face].corners;
+      starts.emplace(corners[horizon[h].edge], h);
+      ends.emplace(corners[(horizon[h].edge + 1u) % 3u], h);
+    }
+    bool closed = starts.size() == horizon.size() &&
+      ends.size() == horizon.size();
+    for (const auto &end : ends)
+      closed = closed && starts.count(end.first) > 0u;
+    if (!closed)
+    {
+      auto &outside = this->faces[_face].outside;
+      outside.erase(std::find(outside.begin(), outside.end(), eye));
+      this->Queue(_face);
+      return false;
+    }
+
+    // Connect the horizon to the point
+    const unsigned int first = static_cast<unsigned int>(this->faces.size());
+    for (const auto &edge : horizon)
+    {
+      const unsigned int from = this->faces[edge.face].corners[edge.edge];
+      const unsigned int to =
+        this->faces[edge.face].corners[(edge.edge + 1u) % 3u];
+      const unsigned int neighbor =
+        this->faces[edge.face].neighbors[edge.edge];
+      const unsigned int face = this->AddFace(from, to, eye);
+      Face &added = this->faces[face];
+      added.neighbors[0] = neighbor;
+      added.neighbors[1] = first + starts[to];
+      added.neighbors[2] = first + ends[from];
+      Face &other = this->faces[neighbor];
+      for (unsigned int e = 0; e < 3u; ++e)
+      {
+        if (other.corners[e] == to && other.corners[(e + 1u) % 3u] == from)
+          other.neighbors[e] = face;
+      }
+    }
+
+    // Give the points seen by the removed faces to the new ones
+    std::vector<unsigned int> orphans;
+    for (const unsigned int face : visible)
+    {
+      Face &removed = this->faces[face];
+      for (const unsigned int point : removed.outside)
+      {
+        if (point != eye)
+          orphans.push_back(point);
+      }
+      removed.alive = false;
+      removed.outside = std::vector<unsigned int>();
+    }
+    this->Assign(orphans, first,
+        static_cast<unsigned int>(this->faces.size()));
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  const std::vector<math::Vector3d> &Hull::Vertices() const
+  {
+    return this->vertices;
+  }
+
+  //////////////////////////////////////////////////
+  double Hull::Depth(const math::Vector3d &_point) const
+  {
+    double depth = kInfinity;
+    for (std::size_t f = 0; f < this->normals.size(); ++f)
+      depth = std::min(depth, this->offsets[f] - this->normals[f].Dot(_point));
+    return depth;
+  }
+
+  //////////////////////////////////////////////////
+  double Hull::Volume() const
+  {
+    if (this->vertices.empty())
+      return 0.0;
+
+    // Sum of the tetrahedra from a vertex to every triangle
+    const math::Vector3d &origin = this->vertices[0];
+    double volume = 0.0;
+    for (std::size_t i = 0; i < this->indices.size(); i += 3u)
+    {
+      const math::Vector3d a = this->vertices[this->indices[i]] - origin;
+      const math::Vector3d b = this->vertices[this->indices[i + 1u]] - origin;
+      const math::Vector3d c = this->vertices[this->indices[i + 2u]] - origin;
+      volume += a.Dot(b.Cross(c));
+    }
+    return volume / 6.0;
+  }
+
+  //////////////////////////////////////////////////
+  std::unique_ptr<SubMesh> Hull::Output() const
+  {
+    auto subMesh = std::make_unique<SubMesh>();
+    subMesh->SetPrimitiveType(SubMesh::TRIANGLES);
+    for (const auto &vertex : this->vertices)
+      subMesh->AddVertex(vertex);
+    for (const unsigned int index : this->indices)
+      subMesh->AddIndex(index);
+    return subMesh;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Get the corners of triangles
+  /// \param[in] _triangles Triangles
+  /// \return Three points per triangle
+  std::vector<math::Vector3d> Corners(const std::vector<Triangle> &_triangles)
+  {
+    std::vector<math::Vector3d> corners;
+    corners.reserve(_triangles.size() * 3u);
+    for (const auto &triangle : _triangles)
+      corners.insert(corners.end(), triangle.begin(), triangle.end());
+    return corners;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Pick a sample of triangles spread over the whole list. The
+  /// picks follow a low discrepancy sequence rather than a fixed stride,
+  /// which would alias with the regular order of generated meshes.
+  /// \param[in] _triangles Triangles
+  /// \param[in] _count Largest number of triangles to pick
+  /// \return All the triangles if there are at most _count of them, and
+  /// _count triangles otherwise
+  std::vector<Triangle> Sample(const std::vector<Triangle> &_triangles,
+      const std::size_t _count)
+  {
+    if (_triangles.size() <= _count)
+      return _triangles;
+
+    const double goldenRatio = 0.5 * (std::sqrt(5.0) - 1.0);
+    std::vector<Triangle> sample(_count);
+    for (std::size_t i = 0; i < _count; ++i)
+    {
+      const double fraction = std::fmod(i * goldenRatio, 1.0);
+      sample[i] = _triangles[std::min(_triangles.size() - 1u,
+          static_cast<std::size_t>(fraction * _triangles.size()))];
+    }
+    return sample;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Get the concavity of a piece
+  /// \param[in] _triangles Triangles of the piece
+  /// \param[in] _hull Hull of the piece
+  /// \return Largest depth below the hull surface of the corners and
+  /// centroids of a sample of the triangles. Centroids catch concavities
+  /// whose corners all lie on the hull, as in extruded shapes.
+  double Concavity(const std::vector<Triangle> &_triangles,
+      const Hull &_hull)
+  {
+    double concavity = 0.0;
+    for (const auto &triangle : Sample(_triangles, kMaxConcavitySamples))
+    {
+      concavity = std::max(concavity,
+          _hull.Depth((triangle[0] + triangle[1] + triangle[2]) / 3.0));
+      for (const auto &corner : triangle)
+        concavity = std::max(concavity, _hull.Depth(corner));
+    }
+    return concavity;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Cut triangles with an axis aligned plane
+  /// \param[in] _triangles Triangles to cut
+  /// \param[in] _axis Axis normal to the plane
+  /// \param[in] _position Coordinate of the plane along _axis
+  /// \param[out] _below Parts of the triangles below the plane
+  /// \param[out] _above Parts of the triangles above the plane
+  void Cut(const std::vector<Triangle> &_triangles, const unsigned int _axis,
+      const double _position, std::vector<Triangle> &_below,
+      std::vector<Triangle> &_above)
+  {
+    for (const auto &triangle : _triangles)
+    {
+      std::array<double, 3> d;
+      for (unsigned int c = 0; c < 3u; ++c)
+        d[c] = triangle[c][_axis] - _position;
+
+      // Triangles on the plane close the side they face away from
+      if (d[0] == 0.0 && d[1] == 0.0 && d[2] == 0.0)
+      {
+        const math::Vector3d normal =
+          (triangle[1] - triangle[0]).Cross(triangle[2] - triangle[0]);
+        (normal[_axis] > 0.0 ? _below : _above).push_back(triangle);
+        continue;
+      }
+      if (d[0] <= 0.0 && d[1] <= 0.0 && d[2] <= 0.0)
+      {
+        _below.push_back(triangle);
+        continue;
+      }
+      if (d[0] >= 0.0 && d[1] >= 0.0 && d[2] >= 0.0)
+      {
+        _above.push_back(triangle);
+        continue;
+      }
+
+      // Split into a triangle and a quad, each cut into a fan
+      std::array<math::Vector3d, 4> low;
+      std::array<math::Vector3d, 4> high;
+      std::size_t lowCount = 0u;
+      std::size_t highCount = 0u;
+      for (unsigned int c = 0; c < 3u; ++c)
+      {
+        const unsigned int next = (c + 1u) % 3u;
+        if (d[c] <= 0.0)
+          low[lowCount++] = triangle[c];
+        if (d[c] >= 0.0)
+          high[highCount++] = triangle[c];
+        if ((d[c] < 0.0 && d[next] > 0.0) || (d[c] > 0.0 && d[next] < 0.0))
+        {
+          // Interpolate from the corner below, so that the triangles on
+          // both sides of the edge get the same crossing, and put it
+          // exactly on the plane, so that the cap finds it
+          const unsigned int from = d[c] < 0.0 ? c : next;
+          const unsigned int to = d[c] < 0.0 ? next : c;
+          math::Vector3d crossing = triangle[from] +
+            (triangle[to] - triangle[from]) * (d[from] / (d[from] - d[to]));
+          crossing[_axis] = _position;
+          low[lowCount++] = crossing;
+          high[highCount++] = crossing;
+        }
+      }
+      for (std::size_t i = 1u; i + 1u < lowCount; ++i)
+        _below.push_back({low[0], low[i], low[i + 1u]});
+      for (std::size_t i = 1u; i + 1u < highCount; ++i)
+        _above.push_back({high[0], high[i], high[i + 1u]});
+    }
+  }
+
+  /// \brief Welds positions with equal coordinates into one id
+  class Positions
+  {
+    /// \brief Get the id of a position
+    /// \param[in] _position Position
+    /// \return Id, assigned in order of first appearance
+    public: uint32_t Id(const math::Vector3d &_position)
+    {
+      // Adding zero turns -0 into +0
+      const Key key{_position.X() + 0.0, _position.Y() + 0.0,
+        _position.Z() + 0.0};
+      const auto inserted = this->ids.emplace(key,
+          static_cast<uint32_t>(this->positions.size()));
+      if (inserted.second)
+        this->positions.push_back(_position);
+      return inserted.first->second;
+    }
+
+    /// \brief Get a position
+    /// \param[in] _id Id of the position
+    /// \return The position
+    public: const math::Vector3d &Position(const uint32_t _id) const
+    {
+      return this->positions[_id];
+    }
+
+    /// \brief Coordinates of a position
+    private: using Key = std::array<double, 3>;
+
+    /// \brief Hash of the coordinates of a position
+    private: struct KeyHash
+    {
+      /// \brief Compute the hash
+      /// \param[in] _key Coordinates
+      /// \return Hash
+      std::size_t operator()(const Key &_key) const
+      {
+        std::size_t hash = 0u;
+        for (const double coordinate : _key)
+          hash = hash * 1000003u ^ std::hash<double>()(coordinate);
+        return hash;
+      }
+    };
+
+    /// \brief Id of every position
+    private: std::unordered_map<Key, uint32_t, KeyHash> ids;
+
+    /// \brief Position of every id
+    private: std::vector<math::Vector3d> positions;
+  };
+
+  //////////////////////////////////////////////////
+  /// \brief Count how often every edge between two positions is used in
+  /// one direction more than in the other
+  /// \param[in] _triangles Triangles
+  /// \param[in] _onPlane Only count edges whose ends satisfy this
+  /// \param[out] _positions Positions of the edge ends
+  /// \return Count per edge, keyed by the smaller id in the upper 32 bits.
+  /// Positive counts go from the smaller to the larger id.
+  std::unordered_map<uint64_t, int> OpenEdges(
+      const std::vector<Triangle> &_triangles,
+      const std::function<bool(const math::Vector3d &)> &_onPlane,
+      Positions &_positions)
+  {
+    std::unordered_map<uint64_t, int> edges;
+    for (const auto &triangle : _triangles)
+    {
+      for (unsigned int e = 0; e < 3u; ++e)
+      {
+        const math::Vector3d &from = triangle[e];
+        const math::Vector3d &to = triangle[(e + 1u) % 3u];
+        if (_onPlane && (!_onPlane(from) || !_onPlane(to)))
+          continue;
+        const uint32_t a = _positions.Id(from);
+        const uint32_t b = _positions.Id(to);
+        if (a == b)
+          continue;
+        const uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32u) |
+          std::max(a, b);
+        edges[key] += a < b ? 1 : -1;
+      }
+    }
+    for (auto edge = edges.begin(); edge != edges.end();)
+      edge = edge->second == 0 ? edges.erase(edge) : std::next(edge);
+    return edges;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Check whether triangles form closed surfaces, where every edge
+  /// between two positions is used as often in both directions
+  /// \param[in] _triangles Triangles
+  /// \return True if the triangles are closed
+  bool Closed(const std::vector<Triangle> &_triangles)
+  {
+    Positions positions;
+    return OpenEdges(_triangles, nullptr, positions).empty();
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Close the hole that a cut left in a piece of a closed mesh.
+  /// The open edges on the plane are chained into loops, and every loop is
+  /// closed by a fan of triangles. The fans of concave loops overlap, but
+  /// the overlaps cancel out in volumes and in later cuts.
+  /// \param[in, out] _triangles Triangles of the piece
+  /// \param[in] _axis Axis normal to the cut plane
+  /// \param[in] _position Coordinate of the cut plane along _axis
+  void Cap(std::vector<Triangle> &_triangles, const unsigned int _axis,
+      const double _position)
+  {
+    Positions positions;
+    const auto edges = OpenEdges(_triangles,
+        [&](const math::Vector3d &_p) {return _p[_axis] == _position;},
+        positions);
+
+    // Next positions along the open edges
+    std::unordered_multimap<uint32_t, uint32_t> next;
+    for (const auto &edge : edges)
+    {
+      uint32_t from = static_cast<uint32_t>(edge.first >> 32u);
+      uint32_t to = static_cast<uint32_t>(edge.first);
+      if (edge.second < 0)
+        std::swap(from, to);
+      for (int i = 0; i < std::abs(edge.second); ++i)
+        next.emplace(from, to);
+    }
+
+    while (!next.empty())
+    {
+      // Follow the edges until the loop returns to its start. The fan
+      // triangles run against the edges, which closes them.
+      const uint32_t start = next.begin()->first;
+      uint32_t from = start;
+      while (true)
+      {
+        const auto edge = next.find(from);
+        if (edge == next.end())
+          break;
+        const uint32_t to = edge->second;
+        next.erase(edge);
+        if (from != start && to != start)
+        {
+          _triangles.push_back({positions.Position(start),
+              positions.Position(to), positions.Position(from)});
+        }
+        from = to;
+      }
+    }
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Get the signed volume enclosed by closed triangles
+  /// \param[in] _triangles Triangles
+  /// \param[in] _center Point near the triangles, the apex of all the
+  /// volumes
+  /// \return Volume, positive if the triangles face outwards
+  double Volume(const std::vector<Triangle> &_triangles,
+      const math::Vector3d &_center)
+  {
+    double volume = 0.0;
+    for (const auto &triangle : _triangles)
+    {
+      const math::Vector3d a = triangle[0] - _center;
+      const math::Vector3d b = triangle[1] - _center;
+      const math::Vector3d c = triangle[2] - _center;
+      volume += a.Dot(b.Cross(c));
+    }
+    return volume / 6.0;
+  }
+
+  /// \brief Parameters of a decomposition
+  struct Settings
+  {
+    /// \brief Concavity below which a piece is not cut, in mesh units
+    double maxConcavity;
+
+    /// \brief Empty volume in the hull of a piece below which the piece is
+    /// not cut, or infinity if the submesh is not closed. Pieces of closed
+    /// submeshes are capped where they are cut, so they stay closed.
+    double maxEmptyVolume;
+  };
+
+  /// \brief Plane that may cut a piece
+  struct Candidate
+  {
+    /// \brief Axis normal to the plane
+    unsigned int axis;
+
+    /// \brief Coordinate of the plane along axis
+    double position;
+
+    /// \brief Sum of the hull volumes of both sides, or infinity if a side
+    /// is empty
+    double cost;
+  };
+
+  /// \brief Declared here for CutCost, see below
+  Candidate BestCut(const std::vector<Triangle> &_sample,
+      const std::vector<math::Vector3d> &_outline, const bool _lookAhead);
+
+  //////////////////////////////////////////////////
+  /// \brief Get the cost of cutting a piece with a plane
+  /// \param[in] _sample Sample of the triangles of the piece
+  /// \param[in] _outline Hull vertices of the piece, which are added to
+  /// the sides since the sample misses most extreme points
+  /// \param[in] _axis Axis normal to the plane
+  /// \param[in] _position Coordinate of the plane along _axis
+  /// \param[in] _lookAhead True to also cut every side with its best plane
+  /// when that makes its hulls smaller
+  /// \return Sum of the hull volumes of both sides, or infinity if a side
+  /// is empty
+  double CutCost(const std::vector<Triangle> &_sample,
+      const std::vector<math::Vector3d> &_outline, const unsigned int _axis,
+      const double _position, const bool _lookAhead)
+  {
+    std::array<std::vector<Triangle>, 2> sides;
+    Cut(_sample, _axis, _position, sides[0], sides[1]);
+    if (sides[0].empty() || sides[1].empty())
+      return kInfinity;
+
+    double cost = 0.0;
+    for (unsigned int side = 0; side < 2u; ++side)
+    {
+      std::vector<math::Vector3d> points = Corners(sides[side]);
+      for (const auto &vertex : _outline)
+      {
+        if ((vertex[_axis] < _position) == (side == 0u))
+          points.push_back(vertex);
+      }
+      Hull hull;
+      if (!hull.Compute(points, kMaxOutlineVertices))
+        continue;
+      double volume = hull.Volume();
+      if (_lookAhead)
+        volume = std::min(volume, BestCut(sides[side], hull.Vertices(),
+              false).cost);
+      cost += volume;
+    }
+    return cost;
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Find the plane whose sides have the smallest hulls, among
+  /// planes spread evenly across a piece along every axis. Planes that
+  /// cost about as little as the best one are preferred along the longest
+  /// side of the piece, since cuts across thin parts, as across a ring,
+  /// rarely pay off later.
+  /// \param[in] _sample Sample of the triangles of the piece
+  /// \param[in] _outline Hull vertices of the piece
+  /// \param[in] _lookAhead True to rate planes by the hulls of both sides
+  /// after they are cut once more
+  /// \return The best plane, with an infinite cost if no plane cuts the
+  /// piece
+  Candidate BestCut(const std::vector<Triangle> &_sample,
+      const std::vector<math::Vector3d> &_outline, const bool _lookAhead)
+  {
+    math::Vector3d min = _outline[0];
+    math::Vector3d max = min;
+    for (const auto &vertex : _outline)
+    {
+      min.Min(vertex);
+      max.Max(vertex);
+    }
+
+    std::vector<Candidate> candidates;
+    for (unsigned int axis = 0; axis < 3u; ++axis)
+    {
+      for (unsigned int i = 1u; i <= kPlanesPerAxis; ++i)
+      {
+        const double position = min[axis] +
+          (max[axis] - min[axis]) * i / (kPlanesPerAxis + 1u);
+        candidates.push_back({axis, position, kInfinity});
+      }
+    }
+    ParallelFor(0u, candidates.size(), 1u,
+        [&](const std::size_t _first, const std::size_t _last)
+        {
+          for (std::size_t i = _first; i < _last; ++i)
+          {
+            candidates[i].cost = CutCost(_sample, _outline,
+                candidates[i].axis, candidates[i].position, _lookAhead);
+          }
+        });
+
+    const double lowestCost = std::min_element(candidates.begin(),
+        candidates.end(), [](const Candidate &_a, const Candidate &_b)
+        {
+          return _a.cost < _b.cost;
+        })->cost;
+    const math::Vector3d size = max - min;
+    return *std::min_element(candidates.begin(), candidates.end(),
+        [&](const Candidate &_a, const Candidate &_b)
+        {
+          const bool aLow = _a.cost <= lowestCost * (1.0 + kCostTolerance);
+          const bool bLow = _b.cost <= lowestCost * (1.0 + kCostTolerance);
+          if (aLow != bLow)
+            return aLow;
+          if (aLow && size[_a.axis] != size[_b.axis])
+            return size[_a.axis] > size[_b.axis];
+          return _a.cost < _b.cost;
+        });
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Recursively cut a piece until its parts are convex enough
+  /// \param[in, out] _triangles Triangles of the piece. Cleared if the
+  /// piece is cut.
+  /// \param[in] _depth Number of cuts left on the way down
+  /// \param[in] _settings Parameters of the decomposition
+  /// \return Hull vertices of every part, empty for flat parts
+  std::vector<std::vector<math::Vector3d>> Split(
+      std::vector<Triangle> &_triangles, const unsigned int _depth,
+      const Settings &_settings)
+  {
+    const std::vector<math::Vector3d> points = Corners(_triangles);
+    Hull hull;
+    if (!hull.Compute(points, kUnlimited))
+      return {};
+
+    math::Vector3d min = hull.Vertices()[0];
+    math::Vector3d max = min;
+    for (const auto &vertex : hull.Vertices())
+    {
+      min.Min(vertex);
+      max.Max(vertex);
+    }
+
+    // Pieces of closed meshes are also cut when their hull holds too much
+    // empty space, which catches holes through thin parts
+    bool concave = Concavity(_triangles, hull) > _settings.maxConcavity;
+    if (!concave && !std::isinf(_settings.maxEmptyVolume))
+    {
+      concave = hull.Volume() -
+        Volume(_triangles, (min + max) * 0.5) >
+        _settings.maxEmptyVolume;
+    }
+    if (_depth == 0u || !concave)
+      return {hull.Vertices()};
+
+    // Look one cut further ahead when no single cut pays off, as with
+    // rings, whose halves have the same hull as the whole
+    const std::vector<Triangle> sample =
+      Sample(_triangles, kMaxEvaluatedTriangles);
+    Hull outline;
+    outline.Compute(hull.Vertices(), kMaxOutlineVertices);
+    Candidate best = BestCut(sample, outline.Vertices(), false);
+    if (_depth > 1u && best.cost > outline.Volume() * (1.0 - kCostTolerance))
+      best = BestCut(sample, outline.Vertices(), true);
+    if (std::isinf(best.cost))
+      return {hull.Vertices()};
+
+    std::array<std::vector<Triangle>, 2> sides;
+    Cut(_triangles, best.axis, best.position, sides[0], sides[1]);
+    _triangles = std::vector<Triangle>();
+    if (!std::isinf(_settings.maxEmptyVolume))
+    {
+      for (auto &side : sides)
+        Cap(side, best.axis, best.position);
+    }
+
+    std::array<std::vector<std::vector<math::Vector3d>>, 2> parts;
+    ParallelFor(0u, 2u, 1u,
+        [&](const std::size_t _first, const std::size_t _last)
+        {
+          for (std::size_t i = _first; i < _last; ++i)
+            parts[i] = Split(sides[i], _depth - 1u, _settings);
+        });
+    parts[0].insert(parts[0].end(),
+        std::make_move_iterator(parts[1].begin()),
+        std::make_move_iterator(parts[1].end()));
+    return std::move(parts[0]);
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Merge parts until there are few enough, choosing every time the
+  /// two parts whose merged hull adds the least volume
+  /// \param[in, out] _parts Hull vertices of the parts
+  /// \param[in] _maxParts Largest number of parts
+  void Merge(std::vector<std::vector<math::Vector3d>> &_parts,
+      const std::size_t _maxParts)
+  {
+    if (_parts.size() <= _maxParts)
+      return;
+
+    std::vector<double> volumes(_parts.size());
+    ParallelFor(0u, _parts.size(), 1u,
+        [&](const std::size_t _first, const std::size_t _last)
+        {
+          for (std::size_t i = _first; i < _last; ++i)
+          {
+            Hull hull;
+            hull.Compute(_parts[i], kUnlimited);
+            volumes[i] = hull.Volume();
+          }
+        });
+
+    // Volume added by merging part i with every part j < i
+    auto mergeCost = [&](const std::size_t _i, const std::size_t _j)
+    {
+      std::vector<math::Vector3d> points = _parts[_i];
+      points.insert(points.end(), _parts[_j].begin(), _parts[_j].end());
+      Hull hull;
+      hull.Compute(points, kUnlimited);
+      return hull.Volume() - volumes[_i] - volumes[_j];
+    };
+    std::vector<std::vector<double>> costs(_parts.size());
+    ParallelFor(0u, _parts.size(), 1u,
+        [&](const std::size_t _first, const std::size_t _last)
+        {
+          for (std::size_t i = _first; i < _last; ++i)
+          {
+            for (std::size_t j = 0; j < i; ++j)
+              costs[i].push_back(mergeCost(i, j));
+          }
+        });
+
+    while (_parts.size() > _maxParts)
+    {
+      std::size_t bestI = 1u;
+      std::size_t bestJ = 0u;
+      for (std::size_t i = 1u; i < _parts.size(); ++i)
+      {
+        for (std::size_t j = 0; j < i; ++j)
+        {
+          if (costs[i][j] < costs[bestI][bestJ])
+          {
+            bestI = i;
+            bestJ = j;
+          }
+        }
+      }
+
+      // Keep the merged part at bestJ, and remove bestI
+      std::vector<math::Vector3d> points = std::move(_parts[bestJ]);
+      points.insert(points.end(), _parts[bestI].begin(),
+          _parts[bestI].end());
+      Hull hull;
+      hull.Compute(points, kUnlimited);
+      _parts[bestJ] = hull.Vertices();
+      volumes[bestJ] = hull.Volume();
+
+      _parts.erase(_parts.begin() + bestI);
+      volumes.erase(volumes.begin() + bestI);
+      costs.erase(costs.begin() + bestI);
+      for (std::size_t i = bestI; i < costs.size(); ++i)
+        costs[i].erase(costs[i].begin() + bestI);
+
+      for (std::size_t i = bestJ + 1u; i < _parts.size(); ++i)
+        costs[i][bestJ] = mergeCost(i, bestJ);
+      for (std::size_t j = 0; j < bestJ; ++j)
+        costs[bestJ][j] = mergeCost(bestJ, j);
+    }
+  }
+
+  //////////////////////////////////////////////////
+  /// \brief Decompose a submesh into convex hulls
+  /// \param[in] _subMesh Submesh to decompose
+  /// \param[in] _maxHulls Largest number of hulls
+  /// \param[in] _maxVertices Largest number of vertices of a hull
+  /// \param[in] _maxConcavity Concavity below which a piece is not cut,
+  /// relative to the size of the submesh
+  /// \return The hulls
+  std::vector<std::unique_ptr<SubMesh>> DecomposeSubMesh(
+      const SubMesh &_subMesh, const unsigned int _maxHulls,
+      const unsigned int _maxVertices, const double _maxConcavity)
+  {
+    const unsigned int vertexCount = _subMesh.VertexCount();
+    const unsigned int indexCount = _subMesh.IndexCount();
+    if (_subMesh.SubMeshPrimitiveType() != SubMesh::TRIANGLES ||
+        indexCount == 0u || indexCount % 3u != 0u)
+    {
+      return {};
+    }
+
+    const unsigned int *indices = _subMesh.IndexData();
+    std::vector<Triangle> triangles(indexCount / 3u);
+    for (std::size_t t = 0; t < triangles.size(); ++t)
+    {
+      for (unsigned int c = 0; c < 3u; ++c)
+      {
+        const unsigned int index = indices[t * 3u + c];
+        if (index >= vertexCount)
+          return {};
+        triangles[t][c] = _subMesh.Vertex(index);
+      }
+    }
+
+    // Enough cuts to reach the number of hulls, which is then met by
+    // merging when it is not a power of two
+    unsigned int depth = 0u;
+    while ((1u << depth) < _maxHulls && depth < 31u)
+      ++depth;
+    const math::Vector3d min = _subMesh.Min();
+    const math::Vector3d max = _subMesh.Max();
+    Settings settings{_maxConcavity * (max - min).Length(), kInfinity};
+    if (Closed(triangles))
+    {
+      settings.maxEmptyVolume = _maxConcavity *
+        std::abs(Volume(triangles, (min + max) * 0.5));
+    }
+    auto parts = Split(triangles, depth, settings);
+    Merge(parts, _maxHulls);
+
+    std::vector<std::unique_ptr<SubMesh>> hulls;
+    for (const auto &part : parts)
+    {
+      Hull hull;
+      if (hull.Compute(part, _maxVertices))
+        hulls.push_back(hull.Output());
+    }
+    return hulls;
+  }
+}
+
+//////////////////////////////////////////////////
+MeshConvexDecomposition::MeshConvexDecomposition()
+: dataPtr(ignition::utils::MakeImpl<Implementation>())
+{
+}
+
+//////////////////////////////////////////////////
+MeshConvexDecomposition::~MeshConvexDecomposition()
+{
+}
+
+//////////////////////////////////////////////////
+void MeshConvexDecomposition::SetMaxConvexHulls(const unsigned int _count)
+{
+  this->dataPtr->maxConvexHulls = std::max(1u, _count);
+}
+
+//////////////////////////////////////////////////
+unsigned int MeshConvexDecomposition::MaxConvexHulls() const
+{
+  return this->dataPtr->maxConvexHulls;
+}
+
+//////////////////////////////////////////////////
+void MeshConvexDecomposition::SetMaxVerticesPerHull(const unsigned int _count)
+{
+  this->dataPtr->maxVerticesPerHull = std::max(4u, _count);
+}
+
+//////////////////////////////////////////////////
+unsigned int MeshConvexDecomposition::MaxVerticesPerHull() const
+{
+  return this->dataPtr->maxVerticesPerHull;
+}
+
+//////////////////////////////////////////////////
+void MeshConvexDecomposition::SetMaxConcavity(const double _concavity)
+{
+  this->dataPtr->maxConcavity = _concavity;
+}
+
+//////////////////////////////////////////////////
+double MeshConvexDecomposition::MaxConcavity() const
+{
+  return this->dataPtr->maxConcavity;
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<SubMesh> MeshConvexDecomposition::ConvexHull(
+    const SubMesh &_subMesh) const
+{
+  std::vector<math::Vector3d> points(_subMesh.VertexCount());
+  for (unsigned int i = 0; i < points.size(); ++i)
+    points[i] = _subMesh.Vertex(i);
+
+  Hull hull;
+  if (!hull.Compute(points, this->dataPtr->maxVerticesPerHull))
+    return nullptr;
+  return hull.Output();
+}
+
+//////////////////////////////////////////////////
+std::vector<std::unique_ptr<SubMesh>> MeshConvexDecomposition::Decompose(
+    const SubMesh &_subMesh) const
+{
+  return DecomposeSubMesh(_subMesh, this->dataPtr->maxConvexHulls,
+      this->dataPtr->maxVerticesPerHull, this->dataPtr->maxConcavity);
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<Mesh> MeshConvexDecomposition::Decompose(
+    const Mesh &_mesh) const
+{
+  auto mesh = std::make_unique<Mesh>();
+  mesh->SetName(_mesh.Name());
+  mesh->SetPath(_mesh.Path());
+  for (unsigned int i = 0; i < _mesh.MaterialCount(); ++i)
+    mesh->AddMaterial(_mesh.MaterialByIndex(i));
+
+  const Implementation &settings = *this->dataPtr;
+  std::vector<std::vector<std::unique_ptr<SubMesh>>> hulls(
+      _mesh.SubMeshCount());
+  ParallelFor(0u, hulls.size(), 1u,
+      [&](const std::size_t _first, const std::size_t _last)
+      {
+        for (std::size_t i = _first; i < _last; ++i)
+        {
+          auto subMesh =
+            _mesh.SubMeshByIndex(static_cast<unsigned int>(i)).lock();
+          if (!subMesh)
+            continue;
+          hulls[i] = DecomposeSubMesh(*subMesh, settings.maxConvexHulls,
+              settings.maxVerticesPerHull, settings.maxConcavity);
+          for (std::size_t h = 0; h < hulls[i].size(); ++h)
+          {
+            hulls[i][h]->SetName(
+                subMesh->Name() + "_convex_" + std::to_string(h));
+            hulls[i][h]->SetMaterialIndex(subMesh->MaterialIndex());
+          }
+        }
+      });
+
+  for (auto &subMeshHulls : hulls)
+  {
+    for (auto &hull : subMeshHulls)
+      mesh->AddSubMesh(std::move(hull));
+  }
+  return mesh;
+}
@@ -0,0 +1,349 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "test_config.h"
+#include "ignition/common/Mesh.hh"
+#include "ignition/common/MeshConvexDecomposition.hh"
+#include "ignition/common/MeshManager.hh"
+#include "ignition/common/SubMesh.hh"
+
+using namespace ignition;
+
+class MeshConvexDecomposition : public common::testing::AutoLogFixture { };
+
+/////////////////////////////////////////////////
+/// \brief Add the triangles of an axis aligned box to a submesh
+/// \param[in, out] _subMesh Submesh
+/// \param[in] _min Smallest corner of the box
+/// \param[in] _max Largest corner of the box
+void AddBox(common::SubMesh &_subMesh, const math::Vector3d &_min,
+    const math::Vector3d &_max)
+{
+  const unsigned int first = _subMesh.VertexCount();
+  for (unsigned int i = 0; i < 8u; ++i)
+  {
+    _subMesh.AddVertex((i & 1u) ? _max.X() : _min.X(),
+        (i & 2u) ? _max.Y() : _min.Y(), (i & 4u) ? _max.Z() : _min.Z());
+  }
+  const unsigned int faces[6][4] =
+  {
+    {0, 2, 3, 1}, {4, 5, 7, 6}, {0, 1, 5, 4},
+    {2, 6, 7, 3}, {0, 4, 6, 2}, {1, 3, 7, 5}
+  };
+  for (const auto &face : faces)
+  {
+    for (const unsigned int corner : {0, 1, 2, 0, 2, 3})
+      _subMesh.AddIndex(first + face[corner]);
+  }
+}
+
+/////////////////////////////////////////////////
+/// \brief Get the volume of a closed submesh with outward facing triangles
+/// \param[in] _subMesh Submesh
+/// \return Volume
+double Volume(const common::SubMesh &_subMesh)
+{
+  double volume = 0.0;
+  for (unsigned int i = 0; i + 2 < _subMesh.IndexCount(); i += 3)
+  {
+    const math::Vector3d a = _subMesh.Vertex(_subMesh.Index(i));
+    const math::Vector3d b = _subMesh.Vertex(_subMesh.Index(i + 1));
+    const math::Vector3d c = _subMesh.Vertex(_subMesh.Index(i + 2));
+    volume += a.Dot(b.Cross(c));
+  }
+  return volume / 6.0;
+}
+
+/////////////////////////////////////////////////
+/// \brief Check whether a point is inside a convex hull
+/// \param[in] _hull Hull with outward facing triangles
+/// \param[in] _point Point
+/// \param[in] _tolerance Largest distance outside the hull
+/// \return True if no triangle plane has _point farther than _tolerance
+/// in front of it
+bool Inside(const common::SubMesh &_hull, const math::Vector3d &_point,
+    const double _tolerance)
+{
+  for (unsigned int i = 0; i + 2 < _hull.IndexCount(); i += 3)
+  {
+    const math::Vector3d a = _hull.Vertex(_hull.Index(i));
+    const math::Vector3d b = _hull.Vertex(_hull.Index(i + 1));
+    const math::Vector3d c = _hull.Vertex(_hull.Index(i + 2));
+    const math::Vector3d normal = (b - a).Cross(c - a).Normalized();
+    if (normal.Dot(_point - a) > _tolerance)
+      return false;
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+/// \brief Check that a hull is convex: every vertex is behind every
+/// triangle
+/// \param[in] _hull Hull
+void ExpectConvex(const common::SubMesh &_hull)
+{
+  EXPECT_GT(Volume(_hull), 0.0);
+  for (unsigned int v = 0; v < _hull.VertexCount(); ++v)
+    EXPECT_TRUE(Inside(_hull, _hull.Vertex(v), 1e-6));
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshConvexDecomposition, ConvexHull)
+{
+  common::MeshConvexDecomposition decomposition;
+  EXPECT_EQ(16u, decomposition.MaxConvexHulls());
+  EXPECT_EQ(64u, decomposition.MaxVerticesPerHull());
+  EXPECT_DOUBLE_EQ(0.01, decomposition.MaxConcavity());
+
+  // Points inside a box don't change its hull
+  common::SubMesh box;
+  AddBox(box, math::Vector3d(-1, -2, -3), math::Vector3d(1, 2, 3));
+  AddBox(box, math::Vector3d(-0.5, -1, 0), math::Vector3d(1, 1, 1));
+  auto hull = decomposition.ConvexHull(box);
+  ASSERT_NE(nullptr, hull);
+  EXPECT_EQ(8u, hull->VertexCount());
+  EXPECT_EQ(36u, hull->IndexCount());
+  EXPECT_EQ(math::Vector3d(-1, -2, -3), hull->Min());
+  EXPECT_EQ(math::Vector3d(1, 2, 3), hull->Max());
+  EXPECT_NEAR(48.0, Volume(*hull), 1e-9);
+  ExpectConvex(*hull);
+
+  // The number of vertices is limited, keeping the points farthest out
+  common::MeshManager::Instance()->CreateSphere(
+      "convex_sphere", 1.0f, 32, 32);
+  auto sphere = common::MeshManager::Instance()->MeshByName(
+      "convex_sphere")->SubMeshByIndex(0).lock();
+  decomposition.SetMaxVerticesPerHull(1000);
+  hull = decomposition.ConvexHull(*sphere);
+  ASSERT_NE(nullptr, hull);
+  EXPECT_GT(hull->VertexCount(), 64u);
+  const double fullVolume = Volume(*hull);
+  ExpectConvex(*hull);
+  for (unsigned int v = 0; v < sphere->VertexCount(); ++v)
+    EXPECT_TRUE(Inside(*hull, sphere->Vertex(v), 1e-6));
+
+  decomposition.SetMaxVerticesPerHull(32);
+  hull = decomposition.ConvexHull(*sphere);
+  ASSERT_NE(nullptr, hull);
+  EXPECT_LE(hull->VertexCount(), 32u);
+  ExpectConvex(*hull);
+  EXPECT_LT(Volume(*hull), fullVolume);
+  EXPECT_GT(Volume(*hull), 0.5 * fullVolume);
+
+  decomposition.SetMaxVerticesPerHull(1);
+  EXPECT_EQ(4u, decomposition.MaxVerticesPerHull());
+
+  // Flat and empty point sets have no hull
+  common::SubMesh flat;
+  flat.AddVertex(0, 0, 0);
+  flat.AddVertex(1, 0, 0);
+  flat.AddVertex(0, 1, 0);
+  flat.AddVertex(1, 1, 0);
+  EXPECT_EQ(nullptr, decomposition.ConvexHull(flat));
+  EXPECT_EQ(nullptr, decomposition.ConvexHull(common::SubMesh()));
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshConvexDecomposition, Decompose)
+{
+  // A U shape: a bar with two posts on top
+  common::SubMesh shape;
+  AddBox(shape, math::Vector3d(0, 0, 0), math::Vector3d(3, 1, 1));
+  AddBox(shape, math::Vector3d(0, 1, 0), math::Vector3d(1, 3, 1));
+  AddBox(shape, math::Vector3d(2, 1, 0), math::Vector3d(3, 3, 1));
+
+  common::MeshConvexDecomposition decomposition;
+  auto hulls = decomposition.Decompose(shape);
+  ASSERT_GE(hulls.size(), 3u);
+  EXPECT_LE(hulls.size(), 16u);
+
+  // The hulls cover the shape and fill little more than it
+  double volume = 0.0;
+  for (const auto &hull : hulls)
+  {
+    ExpectConvex(*hull);
+    EXPECT_LE(hull->VertexCount(), 64u);
+    volume += Volume(*hull);
+  }
+  EXPECT_NEAR(7.0, volume, 0.1);
+  for (unsigned int v = 0; v < shape.VertexCount(); ++v)
+  {
+    bool covered = false;
+    for (const auto &hull : hulls)
+      covered = covered || Inside(*hull, shape.Vertex(v), 1e-9);
+    EXPECT_TRUE(covered);
+  }
+
+  // Hulls are merged down to the limit
+  decomposition.SetMaxConvexHulls(2);
+  hulls = decomposition.Decompose(shape);
+  ASSERT_EQ(2u, hulls.size());
+  volume = Volume(*hulls[0]) + Volume(*hulls[1]);
+  EXPECT_GE(volume, 7.0 - 1e-9);
+  EXPECT_LT(volume, 9.0);
+
+  // A single hull is the convex hull
+  decomposition.SetMaxConvexHulls(0);
+  EXPECT_EQ(1u, decomposition.MaxConvexHulls());
+  hulls = decomposition.Decompose(shape);
+  ASSERT_EQ(1u, hulls.size());
+  EXPECT_NEAR(9.0, Volume(*hulls[0]), 1e-9);
+
+  // Convex shapes are not cut
+  decomposition.SetMaxConvexHulls(16);
+  common::SubMesh box;
+  AddBox(box, math::Vector3d(0, 0, 0), math::Vector3d(1, 2, 3));
+  hulls = decomposition.Decompose(box);
+  ASSERT_EQ(1u, hulls.size());
+  EXPECT_EQ(8u, hulls[0]->VertexCount());
+
+  // A large concavity threshold keeps the shape whole
+  decomposition.SetMaxConcavity(1.0);
+  EXPECT_EQ(1u, decomposition.Decompose(shape).size());
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshConvexDecomposition, Ring)
+{
+  // A flat square frame, whose hole is shallow compared to its size
+  common::SubMesh frame;
+  AddBox(frame, math::Vector3d(0, 0, 0), math::Vector3d(3, 1, 0.5));
+  AddBox(frame, math::Vector3d(0, 2, 0), math::Vector3d(3, 3, 0.5));
+  AddBox(frame, math::Vector3d(0, 1, 0), math::Vector3d(1, 2, 0.5));
+  AddBox(frame, math::Vector3d(2, 1, 0), math::Vector3d(3, 2, 0.5));
+
+  common::MeshConvexDecomposition decomposition;
+  decomposition.SetMaxConvexHulls(8);
+  const auto hulls = decomposition.Decompose(frame);
+  ASSERT_GE(hulls.size(), 4u);
+
+  // Pieces cut on several axes still cover the frame, including the
+  // corners of the cells they were cut out of
+  double volume = 0.0;
+  for (const auto &hull : hulls)
+    volume += Volume(*hull);
+  EXPECT_GE(volume, 4.0 - 1e-9);
+  EXPECT_LT(volume, 4.25);
+  for (double x = 0.125; x < 3.0; x += 0.25)
+  {
+    for (double y = 0.125; y < 3.0; y += 0.25)
+    {
+      if (x > 1.0 && x < 2.0 && y > 1.0 && y < 2.0)
+        continue;
+      bool covered = false;
+      for (const auto &hull : hulls)
+        covered = covered || Inside(*hull, math::Vector3d(x, y, 0.25), 1e-9);
+      EXPECT_TRUE(covered) << x << " " << y;
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshConvexDecomposition, Unsupported)
+{
+  common::MeshConvexDecomposition decomposition;
+
+  common::SubMesh lines;
+  AddBox(lines, math::Vector3d::Zero, math::Vector3d::One);
+  lines.SetPrimitiveType(common::SubMesh::LINES);
+  EXPECT_TRUE(decomposition.Decompose(lines).empty());
+
+  common::SubMesh invalid;
+  AddBox(invalid, math::Vector3d::Zero, math::Vector3d::One);
+  invalid.AddIndex(100);
+  invalid.AddIndex(0);
+  invalid.AddIndex(1);
+  EXPECT_TRUE(decomposition.Decompose(invalid).empty());
+
+  // Flat surfaces have no volume
+  common::SubMesh flat;
+  flat.AddVertex(0, 0, 0);
+  flat.AddVertex(1, 0, 0);
+  flat.AddVertex(0, 1, 0);
+  flat.AddIndex(0);
+  flat.AddIndex(1);
+  flat.AddIndex(2);
+  EXPECT_TRUE(decomposition.Decompose(flat).empty());
+  EXPECT_TRUE(decomposition.Decompose(common::SubMesh()).empty());
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshConvexDecomposition, Mesh)
+{
+  common::Mesh mesh;
+  mesh.SetName("shapes");
+  auto shape = std::make_unique<common::SubMesh>("u");
+  AddBox(*shape, math::Vector3d(0, 0, 0), math::Vector3d(3, 1, 1));
+  AddBox(*shape, math::Vector3d(0, 1, 0), math::Vector3d(1, 3, 1));
+  AddBox(*shape, math::Vector3d(2, 1, 0), math::Vector3d(3, 3, 1));
+  shape->SetMaterialIndex(0);
+  mesh.AddSubMesh(std::move(shape));
+  auto box = std::make_unique<common::SubMesh>("box");
+  AddBox(*box, math::Vector3d(5, 0, 0), math::Vector3d(6, 1, 1));
+  mesh.AddSubMesh(std::move(box));
+
+  common::MeshConvexDecomposition decomposition;
+  auto decomposed = decomposition.Decompose(mesh);
+  ASSERT_NE(nullptr, decomposed);
+  EXPECT_EQ("shapes", decomposed->Name());
+  ASSERT_GE(decomposed->SubMeshCount(), 4u);
+
+  // Hulls of every submesh follow each other
+  const unsigned int count = decomposed->SubMeshCount();
+  for (unsigned int i = 0; i + 1 < count; ++i)
+  {
+    auto hull = decomposed->SubMeshByIndex(i).lock();
+    EXPECT_EQ("u_convex_" + std::to_string(i), hull->Name());
+    EXPECT_EQ(0u, hull->MaterialIndex());
+  }
+  auto last = decomposed->SubMeshByIndex(count - 1).lock();
+  EXPECT_EQ("box_convex_0", last->Name());
+  EXPECT_EQ(math::Vector3d(5, 0, 0), last->Min());
+  double volume = 0.0;
+  for (unsigned int i = 0; i < count; ++i)
+    volume += Volume(*decomposed->SubMeshByIndex(i).lock());
+  EXPECT_NEAR(8.0, volume, 0.1);
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshConvexDecomposition, MeshManager)
+{
+  auto mgr = common::MeshManager::Instance();
+  EXPECT_EQ(nullptr, mgr->ConvexDecomposition("no_such_mesh"));
+
+  const common::Mesh *convex = mgr->ConvexDecomposition("unit_box");
+  ASSERT_NE(nullptr, convex);
+  EXPECT_EQ("unit_box::convex", convex->Name());
+  EXPECT_EQ(convex, mgr->MeshByName("unit_box::convex"));
+  ASSERT_EQ(1u, convex->SubMeshCount());
+  EXPECT_NEAR(1.0, Volume(*convex->SubMeshByIndex(0).lock()), 1e-6);
+
+  // The decomposition is computed once
+  EXPECT_EQ(convex, mgr->ConvexDecomposition("unit_box", 2, 8));
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -16,9 +16,19 @@
  */
 
 #include <sys/stat.h>
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <future>
 #include <string>
 #include <mutex>
 #include <map>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
 #include <cctype>
 
 #ifndef _WIN32
@@ -27,18 +37,88 @@
 #endif
 
 #include "ignition/common/Console.hh"
+#include "ignition/common/Filesystem.hh"
 #include "ignition/common/Mesh.hh"
 #include "ignition/common/SubMesh.hh"
+#include "ignition/common/BinaryMeshExporter.hh"
+#include "ignition/common/BinaryMeshLoader.hh"
 #include "ignition/common/ColladaLoader.hh"
 #include "ignition/common/ColladaExporter.hh"
 #include "ignition/common/OBJLoader.hh"
+#include "ignition/common/Parallel.hh"
 #include "ignition/common/STLLoader.hh"
+#include "ignition/common/Util.hh"
+#include "ignition/common/Uuid.hh"
 #include "ignition/common/config.hh"
 
+#include "ignition/common/MeshBvh.hh"
+#include "ignition/common/MeshConvexDecomposition.hh"
 #include "ignition/common/MeshManager.hh"
+#include "ignition/common/MeshOptimizer.hh"
+#include "ignition/common/MeshSimplifier.hh"
+
+#include "BinaryMesh.hh"
+#include "MappedFile.hh"
 
 using namespace ignition::common;
 
+namespace
+{
+  /// \brief A mesh file that is being decoded. Shared by every request for
+  /// the same file until the mesh is in the mesh map.
+  class PendingLoad
+  {
+    /// \brief Set by the thread that decodes the file
+    public: std::atomic<bool> claimed{false};
+
+    /// \brief Receives the mesh, or nullptr on failure
+    public: std::promise<const Mesh *> promise;
+
+    /// \brief Future of promise, shared by all the requests
+    public: std::shared_future<const Mesh *> result =
+              promise.get_future().share();
+  };
+
+  /// \brief A part of the mesh map. Meshes are spread over the shards by
+  /// the hash of their name, so that lookups of different meshes rarely
+  /// touch the same lock or the same counters.
+  class alignas(64) MeshShard
+  {
+    /// \brief Protects meshes. Lookups take it shared, and it is taken
+    /// exclusively only to insert a mesh that is fully built.
+    public: mutable std::shared_mutex mutex;
+
+    /// \brief Meshes of the shard, indexed by name
+    public: std::unordered_map<std::string, Mesh *> meshes;
+
+    /// \brief Number of lookups that found a mesh
+    public: mutable std::atomic<uint64_t> hits{0};
+
+    /// \brief Number of lookups that found no mesh
+    public: mutable std::atomic<uint64_t> misses{0};
+
+    /// \brief Number of lookups that waited for an insertion
+    public: mutable std::atomic<uint64_t> contentions{0};
+  };
+
+  /// \brief Get the name of a level of detail of a mesh
+  /// \param[in] _name Name of the mesh
+  /// \param[in] _level Level, greater than 0
+  /// \return Name of the level
+  std::string LodName(const std::string &_name, const unsigned int _level)
+  {
+    return _name + "::lod" + std::to_string(_level);
+  }
+
+  /// \brief Get the name of the convex decomposition of a mesh
+  /// \param[in] _name Name of the mesh
+  /// \return Name of the decomposition
+  std::string ConvexName(const std::string &_name)
+  {
+    return _name + "::convex";
+  }
+}
+
 class ignition::common::MeshManager::Implementation
 {
 #ifdef _WIN32
@@ -46,26 +126,111 @@ class ignition::common::MeshManager::Implementation
 #pragma warning(push)
 #pragma warning(disable: 4251)
 #endif
-  /// \brief 3D mesh loader for COLLADA files
-  public: ColladaLoader colladaLoader;
-
   /// \brief 3D mesh exporter for COLLADA files
   public: ColladaExporter colladaExporter;
 
-  /// \brief 3D mesh loader for STL files
-  public: STLLoader stlLoader;
+  /// \brief 3D mesh exporter for binary mesh files
+  public: BinaryMeshExporter binaryMeshExporter;
 
-  /// \brief 3D mesh loader for OBJ files
-  public: OBJLoader objLoader;
+  /// \brief Dictionary of meshes, sharded by the hash of the mesh name
+  public: std::array<MeshShard, 16> shards;
 
-  /// \brief Dictionary of meshes, indexed by name
-  public: std::map<std::string, Mesh*> meshes;
+  /// \brief Mesh files being decoded, indexed by the name given to Load
+  public: std::map<std::string, std::shared_ptr<PendingLoad>> pending;
 
   /// \brief supported file extensions for meshes
   public: std::vector<std::string> fileExtensions;
 
-  /// \brief Mutex to protect the mesh map
-  public: std::mutex mutex;
+  /// \brief Mutex to protect the pending loads and the cache settings. It
+  /// is never held while a file is decoded, nor taken by mesh lookups.
+  public: mutable std::mutex mutex;
+
+  /// \brief Directory of the on-disk mesh cache, empty if disabled
+  public: std::string cacheDirectory;
+
+  /// \brief How cached meshes are matched with mesh files
+  public: MeshManager::CacheKey cacheKey = MeshManager::CacheKey::FILE_STATS;
+
+  /// \brief True to optimize meshes loaded from files
+  public: bool optimizeMeshes = false;
+
+  /// \brief Bounding volume hierarchies of meshes, indexed by mesh name
+  public: std::map<std::string, std::shared_ptr<const MeshBvh>> bvhs;
+
+  /// \brief Mutex to protect bvhs
+  public: std::mutex bvhMutex;
+
+  /// \brief Mutex held while a convex decomposition is computed, so that
+  /// every mesh is decomposed once
+  public: std::mutex convexMutex;
+
+  /// \brief Get the shard that holds a mesh
+  /// \param[in] _name Name of the mesh
+  /// \return Index of the shard in shards
+  public: std::size_t ShardIndex(const std::string &_name) const;
+
+  /// \brief Find a mesh
+  /// \param[in] _name Name of the mesh
+  /// \param[in] _count True to record the lookup as a hit or a miss. Only
+  /// lookups made for users of the manager are counted.
+  /// \return The mesh, or nullptr if there is no mesh with this name
+  public: Mesh *Find(const std::string &_name, const bool _count) const;
+
+  /// \brief Check whether a mesh exists, without counting the lookup
+  /// \param[in] _name Name of the mesh
+  /// \return True if a mesh named _name exists
+  public: bool Has(const std::string &_name) const;
+
+  /// \brief Add a mesh unless a mesh with the same name exists
+  /// \param[in] _name Name of the mesh
+  /// \param[in] _mesh The mesh
+  /// \return False if a mesh with the same name exists
+  public: bool Insert(const std::string &_name, Mesh *_mesh);
+
+  /// \brief Find a loaded mesh, or join or start the load of a mesh file
+  /// \param[in] _filename Name of the mesh file
+  /// \param[out] _mesh The mesh if it is already loaded
+  /// \return The pending load of the file, or nullptr if _mesh is set
+  public: std::shared_ptr<PendingLoad> Request(const std::string &_filename,
+              const Mesh *&_mesh);
+
+  /// \brief Decode the file of a pending load unless another thread already
+  /// does it, and wait for the mesh
+  /// \param[in] _filename Name of the mesh file
+  /// \param[in] _load Pending load returned by Request
+  /// \return The mesh, or nullptr if it could not be loaded
+  public: const Mesh *Complete(const std::string &_filename,
+              PendingLoad &_load);
+
+  /// \brief Decode a mesh file, through the cache when it is enabled
+  /// \param[in] _filename Name of the mesh file
+  /// \return New mesh, or nullptr on failure
+  public: Mesh *Decode(const std::string &_filename) const;
+
+  /// \brief Get the cache file and the key of a mesh file
+  /// \param[in] _fullname Full path of the mesh file
+  /// \param[in] _directory Directory of the cache, empty if disabled
+  /// \param[in] _type How the key is computed
+  /// \param[out] _cacheFile Path of the cache file
+  /// \param[out] _key Key that the cache file must hold
+  /// \return False if the cache is disabled or the mesh file can't be read
+  public: static bool CacheEntry(const std::string &_fullname,
+              const std::string &_directory, const MeshManager::CacheKey _type,
+              std::string &_cacheFile, std::string &_key);
+
+  /// \brief Read a mesh from the cache
+  /// \param[in] _cacheFile Path of the cache file
+  /// \param[in] _key Key that the cache file must hold
+  /// \return The mesh, or nullptr if the cache file is missing or stale
+  public: static Mesh *LoadCached(const std::string &_cacheFile,
+              const std::string &_key);
+
+  /// \brief Write a mesh to the cache
+  /// \param[in] _mesh Mesh to write
+  /// \param[in] _cacheFile Path of the cache file
+  /// \param[in] _key Key to store with the mesh
+  public: static void SaveCached(const Mesh &_mesh,
+              const std::string &_cacheFile, const std::string &_key);
 #ifdef _WIN32
 #pragma warning(pop)
 #endif
@@ -100,15 +265,18 @@ MeshManager::MeshManager()
   this->dataPtr->fileExtensions.push_back("stl");
   this->dataPtr->fileExtensions.push_back("dae");
   this->dataPtr->fileExtensions.push_back("obj");
+  this->dataPtr->fileExtensions.push_back("ignmesh");
 }
 
 //////////////////////////////////////////////////
 MeshManager::~MeshManager()
 {
-  for (auto iter = this->dataPtr->meshes.begin();
-      iter != this->dataPtr->meshes.end(); ++iter)
-    delete iter->second;
-  this->dataPtr->meshes.clear();
+  for (auto &shard : this->dataPtr->shards)
+  {
+    for (auto iter = shard.meshes.begin(); iter != shard.meshes.end(); ++iter)
+      delete iter->second;
+    shard.meshes.clear();
+  }
 }
 
 //////////////////////////////////////////////////
@@ -120,60 +288,305 @@ const Mesh *MeshManager::Load(const std::string &_filename)
     return nullptr;
   }
 
-  Mesh *mesh = nullptr;
+  const Mesh *mesh = nullptr;
+  auto load = this->dataPtr->Request(_filename, mesh);
+  if (load)
+    mesh = this->dataPtr->Complete(_filename, *load);
+  return mesh;
+}
 
-  std::string extension;
+//////////////////////////////////////////////////
+TaskFuture<const Mesh *> MeshManager::LoadAsync(const std::string &_filename)
+{
+  return ParallelWorkerPool().Submit([this, _filename]
+      {
+        return this->Load(_filename);
+      });
+}
 
-  if (this->HasMesh(_filename))
-  {
-    return this->dataPtr->meshes[_filename];
-  }
+//////////////////////////////////////////////////
+std::vector<const Mesh *> MeshManager::LoadBatch(
+    const std::vector<std::string> &_filenames)
+{
+  std::vector<const Mesh *> result(_filenames.size(), nullptr);
+  ParallelFor(0u, _filenames.size(), 1u,
+      [&](const std::size_t _first, const std::size_t _last)
+      {
+        for (std::size_t i = _first; i < _last; ++i)
+        {
+          // A file that makes its loader throw must not stop the others
+          try
+          {
+            result[i] = this->Load(_filenames[i]);
+          }
+          catch(const std::exception &_e)
+          {
+            ignerr << "Unable to load mesh[" << _filenames[i] << "]: "
+                   << _e.what() << "\n";
+          }
+          catch(...)
+          {
+            ignerr << "Unable to load mesh[" << _filenames[i] << "]\n";
+          }
+        }
+      });
+  return result;
+}
 
-  std::string fullname = common::findFile(_filename);
+//////////////////////////////////////////////////
+std::shared_ptr<PendingLoad> MeshManager::Implementation::Request(
+    const std::string &_filename, const Mesh *&_mesh)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  _mesh = this->Find(_filename, false);
+  if (_mesh)
+    return nullptr;
 
-  if (!fullname.empty())
-  {
-    extension = fullname.substr(fullname.rfind(".")+1, fullname.size());
-    std::transform(extension.begin(), extension.end(),
-        extension.begin(), ::tolower);
-    MeshLoader *loader = nullptr;
+  auto &load = this->pending[_filename];
+  if (!load)
+    load = std::make_shared<PendingLoad>();
+  return load;
+}
 
-    if (extension == "stl" || extension == "stlb" || extension == "stla")
-      loader = &this->dataPtr->stlLoader;
-    else if (extension == "dae")
-      loader = &this->dataPtr->colladaLoader;
-    else if (extension == "obj")
-      loader = &this->dataPtr->objLoader;
-    else
+//////////////////////////////////////////////////
+const Mesh *MeshManager::Implementation::Complete(
+    const std::string &_filename, PendingLoad &_load)
+{
+  // Threads that find the load unclaimed decode the file themselves rather
+  // than wait, so that a worker waiting on a queued load can't deadlock.
+  if (!_load.claimed.exchange(true))
+  {
+    Mesh *mesh = nullptr;
+    try
     {
-      ignerr << "Unsupported mesh format for file[" << _filename << "]\n";
-      return nullptr;
+      mesh = this->Decode(_filename);
     }
-
-    // This mutex prevents two threads from loading the same mesh at the
-    // same time.
-    std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
-    if (!this->HasMesh(_filename))
+    catch(...)
     {
-      if ((mesh = loader->Load(fullname)) != nullptr)
+      // Waiting threads get the exception too, and later requests try
+      // again
       {
-        mesh->SetName(_filename);
-        this->dataPtr->meshes.insert(std::make_pair(_filename, mesh));
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->pending.erase(_filename);
       }
-      else
-        ignerr << "Unable to load mesh[" << fullname << "]\n";
+      _load.promise.set_exception(std::current_exception());
+      throw;
     }
-    else
+    const Mesh *result = mesh;
     {
-      mesh = this->dataPtr->meshes[_filename];
+      std::lock_guard<std::mutex> lock(this->mutex);
+      if (mesh)
+      {
+        mesh->SetName(_filename);
+
+        // A mesh added with the same name while the file was decoded
+        // takes precedence
+        if (!this->Insert(_filename, mesh))
+        {
+          delete mesh;
+          result = this->Find(_filename, false);
+        }
+      }
+      // Failures are not remembered, so a later request tries again
+      this->pending.erase(_filename);
     }
+    _load.promise.set_value(result);
   }
-  else
+  return _load.result.get();
+}
+
+//////////////////////////////////////////////////
+Mesh *MeshManager::Implementation::Decode(const std::string &_filename) const
+{
+  std::string fullname = common::findFile(_filename);
+  if (fullname.empty())
+  {
     ignerr << "Unable to find file[" << _filename << "]\n";
+    return nullptr;
+  }
+
+  std::string extension =
+    fullname.substr(fullname.rfind(".")+1, fullname.size());
+  std::transform(extension.begin(), extension.end(),
+      extension.begin(), ::tolower);
+
+  // Loaders keep state while they parse, so every decode uses its own
+  std::unique_ptr<MeshLoader> loader;
+  if (extension == "stl" || extension == "stlb" || extension == "stla")
+    loader.reset(new STLLoader());
+  else if (extension == "dae")
+    loader.reset(new ColladaLoader());
+  else if (extension == "obj")
+    loader.reset(new OBJLoader());
+  else if (extension == "ignmesh")
+    loader.reset(new BinaryMeshLoader());
+  else
+  {
+    ignerr << "Unsupported mesh format for file[" << _filename << "]\n";
+    return nullptr;
+  }
+
+  std::string directory;
+  MeshManager::CacheKey type;
+  bool optimize;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    directory = this->cacheDirectory;
+    type = this->cacheKey;
+    optimize = this->optimizeMeshes;
+  }
+
+  std::string cacheFile;
+  std::string cacheKey;
+  // Binary mesh files are already in the format of the cache
+  const bool cacheable = extension != "ignmesh" &&
+    CacheEntry(fullname, directory, type, cacheFile, cacheKey);
+
+  // Optimized meshes are not interchangeable with unoptimized ones
+  if (cacheable && optimize)
+    cacheKey += "\noptimized";
+
+  Mesh *mesh = nullptr;
+  if (cacheable)
+    mesh = LoadCached(cacheFile, cacheKey);
 
+  if (!mesh && (mesh = loader->Load(fullname)) != nullptr)
+  {
+    if (optimize)
+      MeshOptimizer().Optimize(*mesh);
+    if (cacheable)
+      SaveCached(*mesh, cacheFile, cacheKey);
+  }
+
+  if (!mesh)
+    ignerr << "Unable to load mesh[" << fullname << "]\n";
   return mesh;
 }
 
+//////////////////////////////////////////////////
+void MeshManager::SetCacheDirectory(const std::string &_path)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->cacheDirectory = _path;
+}
+
+//////////////////////////////////////////////////
+std::string MeshManager::CacheDirectory() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->cacheDirectory;
+}
+
+//////////////////////////////////////////////////
+void MeshManager::SetCacheKey(const CacheKey _key)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->cacheKey = _key;
+}
+
+//////////////////////////////////////////////////
+MeshManager::CacheKey MeshManager::CacheKeyType() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->cacheKey;
+}
+
+//////////////////////////////////////////////////
+void MeshManager::SetMeshOptimization(const bool _optimize)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  this->dataPtr->optimizeMeshes = _optimize;
+}
+
+//////////////////////////////////////////////////
+bool MeshManager::MeshOptimization() const
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->mutex);
+  return this->dataPtr->optimizeMeshes;
+}
+
+//////////////////////////////////////////////////
+bool MeshManager::Implementation::CacheEntry(const std::string &_fullname,
+    const std::string &_directory, const MeshManager::CacheKey _type,
+    std::string &_cacheFile, std::string &_key)
+{
+  if (_directory.empty())
+    return false;
+
+  if (_type == MeshManager::CacheKey::CONTENT_SHA1)
+  {
+    MappedFile file(_fullname);
+    if (!file.Valid())
+      return false;
+    _key = sha1(file.Data(), file.Size());
+    _cacheFile = joinPaths(_directory, _key + ".ignmesh");
+    return true;
+  }
+
+  struct stat st;
+  if (stat(_fullname.c_str(), &st) != 0)
+    return false;
+  _key = _fullname + "\n" + std::to_string(st.st_size) + "\n" +
+    std::to_string(st.st_mtime);
+  _cacheFile = joinPaths(_directory, sha1(_fullname) + ".ignmesh");
+  return true;
+}
+
+//////////////////////////////////////////////////
+Mesh *MeshManager::Implementation::LoadCached(const std::string &_cacheFile,
+    const std::string &_key)
+{
+  MappedFile file(_cacheFile);
+  std::string key;
+  if (!file.Valid() ||
+      !ReadBinaryMeshKey(file.Data(), file.Size(), key) || key != _key)
+  {
+    return nullptr;
+  }
+
+  Mesh *mesh = ReadBinaryMesh(file.Data(), file.Size());
+  if (!mesh)
+    ignwarn << "Ignoring corrupt mesh cache file[" << _cacheFile << "]\n";
+  return mesh;
+}
+
+//////////////////////////////////////////////////
+void MeshManager::Implementation::SaveCached(const Mesh &_mesh,
+    const std::string &_cacheFile, const std::string &_key)
+{
+  const std::string directory = parentPath(_cacheFile);
+  if (!createDirectories(directory))
+  {
+    ignwarn << "Unable to create mesh cache directory["
+            << directory << "]\n";
+    return;
+  }
+
+  // Write to a temporary file that is renamed when complete, so that other
+  // processes never map a partially written file
+  const std::string tmpFile = _cacheFile + "." + Uuid().String() + ".tmp";
+  bool written = false;
+  {
+    std::ofstream out(tmpFile, std::ios::binary);
+    written = out && WriteBinaryMesh(_mesh, _key, out);
+    out.close();
+    written = written && !out.fail();
+  }
+
+  if (written && std::rename(tmpFile.c_str(), _cacheFile.c_str()) != 0)
+  {
+    // Renaming over an existing file fails on some platforms
+    removeFile(_cacheFile, FSWO_SUPPRESS_WARNINGS);
+    written = std::rename(tmpFile.c_str(), _cacheFile.c_str()) == 0;
+  }
+
+  if (!written)
+  {
+    removeFile(tmpFile, FSWO_SUPPRESS_WARNINGS);
+    ignwarn << "Unable to write mesh cache file[" << _cacheFile << "]\n";
+  }
+}
+
 //////////////////////////////////////////////////
 void MeshManager::Export(const Mesh *_mesh, const std::string &_filename,
     const std::string &_extension, bool _exportTextures)
@@ -182,6 +595,11 @@ void MeshManager::Export(const Mesh *_mesh, const std::string &_filename,
   {
     this->dataPtr->colladaExporter.Export(_mesh, _filename, _exportTextures);
   }
+  else if (_extension == "ignmesh")
+  {
+    this->dataPtr->binaryMeshExporter.Export(_mesh, _filename,
+        _exportTextures);
+  }
   else
   {
     ignerr << "Unsupported mesh format for file[" << _filename << "]\n";
@@ -209,36 +627,125 @@ void MeshManager::MeshAABB(const Mesh *_mesh,
     ignition::math::Vector3d &_center,
     ignition::math::Vector3d &_minXYZ, ignition::math::Vector3d &_maxXYZ)
 {
-  if (this->HasMesh(_mesh->Name()))
-    this->dataPtr->meshes[_mesh->Name()]->AABB(_center, _minXYZ, _maxXYZ);
+  Mesh *mesh = this->dataPtr->Find(_mesh->Name(), false);
+  if (mesh)
+    mesh->AABB(_center, _minXYZ, _maxXYZ);
 }
 
 //////////////////////////////////////////////////
 void MeshManager::GenSphericalTexCoord(const Mesh *_mesh,
     const ignition::math::Vector3d &_center)
 {
-  if (this->HasMesh(_mesh->Name()))
-    this->dataPtr->meshes[_mesh->Name()]->GenSphericalTexCoord(_center);
+  Mesh *mesh = this->dataPtr->Find(_mesh->Name(), false);
+  if (mesh)
+    mesh->GenSphericalTexCoord(_center);
 }
 
 //////////////////////////////////////////////////
 void MeshManager::AddMesh(Mesh *_mesh)
 {
-  if (!this->HasMesh(_mesh->Name()))
-    this->dataPtr->meshes[_mesh->Name()] = _mesh;
+  this->dataPtr->Insert(_mesh->Name(), _mesh);
 }
 
 //////////////////////////////////////////////////
 const Mesh *MeshManager::MeshByName(const std::string &_name) const
 {
-  std::map<std::string, Mesh*>::const_iterator iter;
+  return this->dataPtr->Find(_name, true);
+}
+
+//////////////////////////////////////////////////
+bool MeshManager::CreateLods(const std::string &_name,
+    const unsigned int _levels, const double _ratio)
+{
+  const Mesh *mesh = this->dataPtr->Find(_name, false);
+  if (!mesh)
+  {
+    ignerr << "Unable to create levels of detail of unknown mesh["
+           << _name << "]\n";
+    return false;
+  }
+
+  bool complete = true;
+  for (unsigned int level = 1; level <= _levels && complete; ++level)
+    complete = this->dataPtr->Find(LodName(_name, level), false) != nullptr;
+  if (complete)
+    return true;
+
+  MeshSimplifier simplifier;
+  auto lods = simplifier.CreateLods(*mesh, _levels, _ratio);
+  for (unsigned int level = 1; level <= lods.size(); ++level)
+  {
+    auto &lod = lods[level - 1];
+    lod->SetName(LodName(_name, level));
+    if (this->dataPtr->Insert(lod->Name(), lod.get()))
+      lod.release();
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+const Mesh *MeshManager::MeshLod(const std::string &_name,
+    const unsigned int _level) const
+{
+  if (_level == 0u)
+    return this->dataPtr->Find(_name, false);
+  return this->dataPtr->Find(LodName(_name, _level), false);
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const MeshBvh> MeshManager::Bvh(const std::string &_name)
+{
+  const Mesh *mesh = this->dataPtr->Find(_name, false);
+  if (!mesh)
+    return nullptr;
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->bvhMutex);
+  auto &bvh = this->dataPtr->bvhs[_name];
+  if (!bvh)
+  {
+    auto built = std::make_shared<MeshBvh>();
+    built->Build(*mesh);
+    bvh = built;
+  }
+  else if (!bvh->UpToDate())
+  {
+    // Refit a copy, since other threads may be querying the current one
+    auto refit = std::make_shared<MeshBvh>(*bvh);
+    refit->Update();
+    bvh = refit;
+  }
+  return bvh;
+}
 
-  iter = this->dataPtr->meshes.find(_name);
+//////////////////////////////////////////////////
+const Mesh *MeshManager::ConvexDecomposition(const std::string &_name,
+    const unsigned int _maxConvexHulls, const unsigned int _maxVerticesPerHull)
+{
+  const std::string name = ConvexName(_name);
+  const Mesh *convex = this->dataPtr->Find(name, false);
+  if (convex)
+    return convex;
 
-  if (iter != this->dataPtr->meshes.end())
-    return iter->second;
+  const Mesh *mesh = this->dataPtr->Find(_name, false);
+  if (!mesh)
+  {
+    ignerr << "Unable to decompose unknown mesh[" << _name << "]\n";
+    return nullptr;
+  }
 
-  return nullptr;
+  std::lock_guard<std::mutex> lock(this->dataPtr->convexMutex);
+  convex = this->dataPtr->Find(name, false);
+  if (convex)
+    return convex;
+
+  MeshConvexDecomposition decomposition;
+  decomposition.SetMaxConvexHulls(_maxConvexHulls);
+  decomposition.SetMaxVerticesPerHull(_maxVerticesPerHull);
+  std::unique_ptr<Mesh> decomposed = decomposition.Decompose(*mesh);
+  decomposed->SetName(name);
+  if (this->dataPtr->Insert(name, decomposed.get()))
+    return decomposed.release();
+  return this->dataPtr->Find(name, false);
 }
 
 //////////////////////////////////////////////////
@@ -247,17 +754,98 @@ bool MeshManager::HasMesh(const std::string &_name) const
   if (_name.empty())
     return false;
 
-  std::map<std::string, Mesh*>::const_iterator iter;
-  iter = this->dataPtr->meshes.find(_name);
+  return this->dataPtr->Find(_name, true) != nullptr;
+}
+
+//////////////////////////////////////////////////
+uint64_t MeshManager::LookupHits() const
+{
+  uint64_t count = 0;
+  for (const auto &shard : this->dataPtr->shards)
+    count += shard.hits.load(std::memory_order_relaxed);
+  return count;
+}
+
+//////////////////////////////////////////////////
+uint64_t MeshManager::LookupMisses() const
+{
+  uint64_t count = 0;
+  for (const auto &shard : this->dataPtr->shards)
+    count += shard.misses.load(std::memory_order_relaxed);
+  return count;
+}
+
+//////////////////////////////////////////////////
+uint64_t MeshManager::LookupContentions() const
+{
+  uint64_t count = 0;
+  for (const auto &shard : this->dataPtr->shards)
+    count += shard.contentions.load(std::memory_order_relaxed);
+  return count;
+}
+
+//////////////////////////////////////////////////
+void MeshManager::ResetLookupCounters()
+{
+  for (auto &shard : this->dataPtr->shards)
+  {
+    shard.hits.store(0, std::memory_order_relaxed);
+    shard.misses.store(0, std::memory_order_relaxed);
+    shard.contentions.store(0, std::memory_order_relaxed);
+  }
+}
+
+//////////////////////////////////////////////////
+std::size_t MeshManager::Implementation::ShardIndex(
+    const std::string &_name) const
+{
+  return std::hash<std::string>()(_name) % this->shards.size();
+}
+
+//////////////////////////////////////////////////
+Mesh *MeshManager::Implementation::Find(const std::string &_name,
+    const bool _count) const
+{
+  const MeshShard &shard = this->shards[this->ShardIndex(_name)];
+  std::shared_lock<std::shared_mutex> lock(shard.mutex, std::try_to_lock);
+  if (!lock.owns_lock())
+  {
+    shard.contentions.fetch_add(1, std::memory_order_relaxed);
+    lock.lock();
+  }
 
-  return iter != this->dataPtr->meshes.end();
+  auto iter = shard.meshes.find(_name);
+  if (iter == shard.meshes.end())
+  {
+    if (_count)
+      shard.misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  if (_count)
+    shard.hits.fetch_add(1, std::memory_order_relaxed);
+  return iter->second;
+}
+
+//////////////////////////////////////////////////
+bool MeshManager::Implementation::Has(const std::string &_name) const
+{
+  return !_name.empty() && this->Find(_name, false) != nullptr;
+}
+
+//////////////////////////////////////////////////
+bool MeshManager::Implementation::Insert(const std::string &_name,
+    Mesh *_mesh)
+{
+  MeshShard &shard = this->shards[this->ShardIndex(_name)];
+  std::unique_lock<std::shared_mutex> lock(shard.mutex);
+  return shard.meshes.insert(std::make_pair(_name, _mesh)).second;
 }
 
 //////////////////////////////////////////////////
 void MeshManager::CreateSphere(const std::string &name, float radius,
     int rings, int segments)
 {
-  if (this->HasMesh(name))
+  if (this->dataPtr->Has(name))
   {
     return;
   }
@@ -270,7 +858,6 @@ void MeshManager::CreateSphere(const std::string &name, float radius,
 
   Mesh *mesh = new Mesh();
   mesh->SetName(name);
-  this->dataPtr->meshes.insert(std::make_pair(name, mesh));
 
   SubMesh subMesh;
 
@@ -311,6 +898,8 @@ void MeshManager::CreateSphere(const std::string &name, float radius,
     }
   }
   mesh->AddSubMesh(subMesh);
+  if (!this->dataPtr->Insert(name, mesh))
+    delete mesh;
 }
 
 //////////////////////////////////////////////////
@@ -331,14 +920,13 @@ void MeshManager::CreatePlane(const std::string &_name,
     const ignition::math::Vector2d &_segments,
     const ignition::math::Vector2d &_uvTile)
 {
-  if (this->HasMesh(_name))
+  if (this->dataPtr->Has(_name))
   {
     return;
   }
 
   Mesh *mesh = new Mesh();
   mesh->SetName(_name);
-  this->dataPtr->meshes.insert(std::make_pair(_name, mesh));
 
   SubMesh subMesh;
 
@@ -408,6 +996,8 @@ void MeshManager::CreatePlane(const std::string &_name,
       static_cast<int>(_segments.X() + 1),
       static_cast<int>(_segments.Y() + 1), false);
   mesh->AddSubMesh(subMesh);
+  if (!this->dataPtr->Insert(_name, mesh))
+    delete mesh;
 }
 
 //////////////////////////////////////////////////
@@ -417,14 +1007,13 @@ void MeshManager::CreateBox(const std::string &_name,
 {
   int i, k;
 
-  if (this->HasMesh(_name))
+  if (this->dataPtr->Has(_name))
   {
     return;
   }
 
   Mesh *mesh = new Mesh();
   mesh->SetName(_name);
-  this->dataPtr->meshes.insert(std::make_pair(_name, mesh));
 
   SubMesh subMesh;
 
@@ -510,6 +1099,8 @@ void MeshManager::CreateBox(const std::string &_name,
   for (i = 0; i < 36; ++i)
     subMesh.AddIndex(ind[i]);
   mesh->AddSubMesh(subMesh);
+  if (!this->dataPtr->Insert(_name, mesh))
+    delete mesh;
 }
 
 //////////////////////////////////////////////////
@@ -539,7 +1130,7 @@ void MeshManager::CreateExtrudedPolyline(const std::string &_name,
     }
   }
 
-  if (this->HasMesh(_name))
+  if (this->dataPtr->Has(_name))
   {
     return;
   }
@@ -720,7 +1311,8 @@ void MeshManager::CreateExtrudedPolyline(const std::string &_name,
   }
 
   mesh->AddSubMesh(subMesh);
-  this->dataPtr->meshes.insert(std::make_pair(_name, mesh));
+  if (!this->dataPtr->Insert(_name, mesh))
+    delete mesh;
 #endif
   return;
 }
@@ -730,14 +1322,13 @@ void MeshManager::CreateCamera(const std::string &_name, float _scale)
 {
   int i, k;
 
-  if (this->HasMesh(_name))
+  if (this->dataPtr->Has(_name))
   {
     return;
   }
 
   Mesh *mesh = new Mesh();
   mesh->SetName(_name);
-  this->dataPtr->meshes.insert(std::make_pair(_name, mesh));
 
   SubMesh subMesh;
 
@@ -820,6 +1411,8 @@ void MeshManager::CreateCamera(const std::string &_name, float _scale)
 
   mesh->AddSubMesh(subMesh);
   mesh->RecalculateNormals();
+  if (!this->dataPtr->Insert(_name, mesh))
+    delete mesh;
 }
 
 //////////////////////////////////////////////////
@@ -828,14 +1421,13 @@ void MeshManager::CreateEllipsoid(const std::string &_name,
                                   const unsigned int _rings,
                                   const unsigned int _segments)
 {
-  if (this->HasMesh(_name))
+  if (this->dataPtr->Has(_name))
   {
     return;
   }
 
   Mesh *mesh = new Mesh();
   mesh->SetName(_name);
-  this->dataPtr->meshes.insert(std::make_pair(_name, mesh));
 
   SubMesh subMesh;
 
@@ -899,6 +1491,8 @@ void MeshManager::CreateEllipsoid(const std::string &_name,
     }
   }
   mesh->AddSubMesh(subMesh);
+  if (!this->dataPtr->Insert(_name, mesh))
+    delete mesh;
 }
 
 //////////////////////////////////////////////////
@@ -908,14 +1502,13 @@ void MeshManager::CreateCapsule(const std::string &_name,
                                 const unsigned int _rings,
                                 const unsigned int _segments)
 {
-  if (this->HasMesh(_name))
+  if (this->dataPtr->Has(_name))
   {
     return;
   }
 
   Mesh *mesh = new Mesh();
   mesh->SetName(_name);
-  this->dataPtr->meshes.insert(std::make_pair(_name, mesh));
 
   SubMesh subMesh;
 
@@ -1058,6 +1651,8 @@ void MeshManager::CreateCapsule(const std::string &_name,
   }
 
   mesh->AddSubMesh(subMesh);
+  if (!this->dataPtr->Insert(_name, mesh))
+    delete mesh;
 }
 
 //////////////////////////////////////////////////
@@ -1069,14 +1664,13 @@ void MeshManager::CreateCylinder(const std::string &name, float radius,
   int ring, seg;
   float deltaSegAngle = (2.0 * IGN_PI / segments);
 
-  if (this->HasMesh(name))
+  if (this->dataPtr->Has(name))
   {
     return;
   }
 
   Mesh *mesh = new Mesh();
   mesh->SetName(name);
-  this->dataPtr->meshes.insert(std::make_pair(name, mesh));
 
   SubMesh subMesh;
 
@@ -1175,6 +1769,8 @@ void MeshManager::CreateCylinder(const std::string &name, float radius,
     }
   }
   mesh->AddSubMesh(subMesh);
+  if (!this->dataPtr->Insert(name, mesh))
+    delete mesh;
 }
 
 //////////////////////////////////////////////////
@@ -1186,14 +1782,13 @@ void MeshManager::CreateCone(const std::string &name, float radius,
   unsigned int i, j;
   int ring, seg;
 
-  if (this->HasMesh(name))
+  if (this->dataPtr->Has(name))
   {
     return;
   }
 
   Mesh *mesh = new Mesh();
   mesh->SetName(name);
-  this->dataPtr->meshes.insert(std::make_pair(name, mesh));
 
   SubMesh subMesh;
 
@@ -1285,6 +1880,8 @@ void MeshManager::CreateCone(const std::string &name, float radius,
 
   mesh->AddSubMesh(subMesh);
   mesh->RecalculateNormals();
+  if (!this->dataPtr->Insert(name, mesh))
+    delete mesh;
 }
 
 //////////////////////////////////////////////////
@@ -1305,12 +1902,11 @@ void MeshManager::CreateTube(const std::string &_name, float _innerRadius,
 
   radius = _outerRadius;
 
-  if (this->HasMesh(_name))
+  if (this->dataPtr->Has(_name))
     return;
 
   Mesh *mesh = new Mesh();
   mesh->SetName(_name);
-  this->dataPtr->meshes.insert(std::make_pair(_name, mesh));
   SubMesh subMesh;
 
   // Generate the group of rings for the outsides of the cylinder
@@ -1452,6 +2048,8 @@ void MeshManager::CreateTube(const std::string &_name, float _innerRadius,
 
   mesh->AddSubMesh(subMesh);
   mesh->RecalculateNormals();
+  if (!this->dataPtr->Insert(_name, mesh))
+    delete mesh;
 }
 
 //////////////////////////////////////////////////
@@ -1524,14 +2122,15 @@ void MeshManager::Tesselate2DMesh(SubMesh *sm, int meshWidth, int meshHeight,
 void MeshManager::CreateBoolean(const std::string &_name, const Mesh *_m1,
     const Mesh *_m2, int _operation, const ignition::math::Pose3d &_offset)
 {
-  if (this->HasMesh(_name))
+  if (this->dataPtr->Has(_name))
     return;
 
 #ifndef _WIN32
   MeshCSG csg;
   Mesh *mesh = csg.CreateBoolean(_m1, _m2, _operation, _offset);
   mesh->SetName(_name);
-  this->dataPtr->meshes.insert(std::make_pair(_name, mesh));
+  if (!this->dataPtr->Insert(_name, mesh))
+    delete mesh;
 #endif
 }
 
@@ -17,9 +17,27 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "test_config.h"
+#include "ignition/common/BinaryMeshExporter.hh"
+#include "ignition/common/BinaryMeshLoader.hh"
+#include "ignition/common/Filesystem.hh"
+#include "ignition/common/Material.hh"
 #include "ignition/common/Mesh.hh"
+#include "ignition/common/NodeAnimation.hh"
+#include "ignition/common/Pbr.hh"
+#include "ignition/common/Skeleton.hh"
+#include "ignition/common/SkeletonAnimation.hh"
+#include "ignition/common/SkeletonNode.hh"
 #include "ignition/common/SubMesh.hh"
+#include "ignition/common/TaskFuture.hh"
 #include "ignition/common/MeshManager.hh"
 #include "ignition/common/config.hh"
 
@@ -267,6 +285,557 @@ TEST_F(MeshManager, CreateExtrudedPolylineInvalid)
   EXPECT_TRUE(!common::MeshManager::Instance()->HasMesh(meshName));
 }
 
+/////////////////////////////////////////////////
+/// \brief Expect two meshes to hold the same data
+/// \param[in] _a First mesh
+/// \param[in] _b Second mesh
+void ExpectSameMesh(const common::Mesh &_a, const common::Mesh &_b)
+{
+  ASSERT_EQ(_a.SubMeshCount(), _b.SubMeshCount());
+  for (unsigned int s = 0; s < _a.SubMeshCount(); ++s)
+  {
+    auto a = _a.SubMeshByIndex(s).lock();
+    auto b = _b.SubMeshByIndex(s).lock();
+    EXPECT_EQ(a->Name(), b->Name());
+    EXPECT_EQ(a->SubMeshPrimitiveType(), b->SubMeshPrimitiveType());
+    EXPECT_EQ(a->MaterialIndex(), b->MaterialIndex());
+    ASSERT_EQ(a->VertexCount(), b->VertexCount());
+    ASSERT_EQ(a->NormalCount(), b->NormalCount());
+    ASSERT_EQ(a->IndexCount(), b->IndexCount());
+    ASSERT_EQ(a->TexCoordSetCount(), b->TexCoordSetCount());
+    ASSERT_EQ(a->NodeAssignmentsCount(), b->NodeAssignmentsCount());
+    for (unsigned int i = 0; i < a->VertexCount(); ++i)
+      EXPECT_TRUE(a->Vertex(i).Equal(b->Vertex(i), 0.0));
+    for (unsigned int i = 0; i < a->NormalCount(); ++i)
+      EXPECT_TRUE(a->Normal(i).Equal(b->Normal(i), 0.0));
+    for (unsigned int i = 0; i < a->IndexCount(); ++i)
+      EXPECT_EQ(a->Index(i), b->Index(i));
+    for (unsigned int t = 0; t < a->TexCoordSetCount(); ++t)
+    {
+      ASSERT_EQ(a->TexCoordCountBySet(t), b->TexCoordCountBySet(t));
+      for (unsigned int i = 0; i < a->TexCoordCountBySet(t); ++i)
+        EXPECT_EQ(a->TexCoordBySet(i, t), b->TexCoordBySet(i, t));
+    }
+    for (unsigned int i = 0; i < a->NodeAssignmentsCount(); ++i)
+    {
+      EXPECT_EQ(a->NodeAssignmentByIndex(i).vertexIndex,
+          b->NodeAssignmentByIndex(i).vertexIndex);
+      EXPECT_EQ(a->NodeAssignmentByIndex(i).nodeIndex,
+          b->NodeAssignmentByIndex(i).nodeIndex);
+      EXPECT_FLOAT_EQ(a->NodeAssignmentByIndex(i).weight,
+          b->NodeAssignmentByIndex(i).weight);
+    }
+  }
+
+  ASSERT_EQ(_a.MaterialCount(), _b.MaterialCount());
+  for (unsigned int m = 0; m < _a.MaterialCount(); ++m)
+  {
+    auto a = _a.MaterialByIndex(m);
+    auto b = _b.MaterialByIndex(m);
+    EXPECT_EQ(a->TextureImage(), b->TextureImage());
+    EXPECT_EQ(a->Ambient(), b->Ambient());
+    EXPECT_EQ(a->Diffuse(), b->Diffuse());
+    EXPECT_EQ(a->Specular(), b->Specular());
+    EXPECT_EQ(a->Emissive(), b->Emissive());
+    EXPECT_DOUBLE_EQ(a->Transparency(), b->Transparency());
+    EXPECT_DOUBLE_EQ(a->Shininess(), b->Shininess());
+    EXPECT_EQ(a->Blend(), b->Blend());
+    EXPECT_EQ(a->Shade(), b->Shade());
+    ASSERT_EQ(nullptr == a->PbrMaterial(), nullptr == b->PbrMaterial());
+    if (a->PbrMaterial())
+    {
+      EXPECT_EQ(*a->PbrMaterial(), *b->PbrMaterial());
+    }
+  }
+
+  ASSERT_EQ(_a.HasSkeleton(), _b.HasSkeleton());
+  if (!_a.HasSkeleton())
+    return;
+
+  auto a = _a.MeshSkeleton();
+  auto b = _b.MeshSkeleton();
+  EXPECT_EQ(a->BindShapeTransform(), b->BindShapeTransform());
+  ASSERT_EQ(a->NodeCount(), b->NodeCount());
+  for (unsigned int n = 0; n < a->NodeCount(); ++n)
+  {
+    const common::SkeletonNode *na = a->NodeByHandle(n);
+    const common::SkeletonNode *nb = b->NodeByHandle(n);
+    EXPECT_EQ(na->Name(), nb->Name());
+    EXPECT_EQ(na->Id(), nb->Id());
+    EXPECT_EQ(na->IsJoint(), nb->IsJoint());
+    EXPECT_EQ(na->ChildCount(), nb->ChildCount());
+    EXPECT_EQ(na->Transform(), nb->Transform());
+    EXPECT_EQ(na->ModelTransform(), nb->ModelTransform());
+    EXPECT_EQ(na->InverseBindTransform(), nb->InverseBindTransform());
+    EXPECT_EQ(na->RawTransformCount(), nb->RawTransformCount());
+  }
+  ASSERT_EQ(a->NumVertAttached(), b->NumVertAttached());
+  for (unsigned int v = 0; v < a->NumVertAttached(); ++v)
+  {
+    ASSERT_EQ(a->VertNodeWeightCount(v), b->VertNodeWeightCount(v));
+    for (unsigned int i = 0; i < a->VertNodeWeightCount(v); ++i)
+      EXPECT_EQ(a->VertNodeWeight(v, i), b->VertNodeWeight(v, i));
+  }
+  ASSERT_EQ(a->AnimationCount(), b->AnimationCount());
+  for (unsigned int i = 0; i < a->AnimationCount(); ++i)
+  {
+    EXPECT_EQ(a->Animation(i)->Name(), b->Animation(i)->Name());
+    std::vector<const common::NodeAnimation *> nodes;
+    b->Animation(i)->ForEachNodeAnimation(
+        [&nodes](const common::NodeAnimation &_node)
+        {
+          nodes.push_back(&_node);
+        });
+    ASSERT_EQ(a->Animation(i)->NodeCount(), nodes.size());
+    for (unsigned int n = 0; n < a->Animation(i)->NodeCount(); ++n)
+    {
+      auto na = a->Animation(i)->NodeAnimationByIndex(n);
+      EXPECT_EQ(na->Name(), nodes[n]->Name());
+      ASSERT_EQ(na->FrameCount(), nodes[n]->KeyFrames().size());
+      EXPECT_EQ(na->KeyFrames(), nodes[n]->KeyFrames());
+      for (unsigned int k = 0; k < na->FrameCount(); ++k)
+        EXPECT_EQ(na->KeyFrame(k), nodes[n]->KeyFrame(k));
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+/// \brief List the files in a directory
+/// \param[in] _dir Directory
+/// \return Paths of the files
+std::vector<std::string> ListFiles(const std::string &_dir)
+{
+  std::vector<std::string> files;
+  for (common::DirIter it(_dir); it != common::DirIter(); ++it)
+    files.push_back(*it);
+  return files;
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshManager, Cache)
+{
+  auto *mgr = common::MeshManager::Instance();
+  EXPECT_TRUE(mgr->CacheDirectory().empty());
+  EXPECT_EQ(common::MeshManager::CacheKey::FILE_STATS, mgr->CacheKeyType());
+
+  const std::string cacheDir = common::testing::TempPath("mesh_cache");
+  const std::string dataDir = common::testing::TempPath("mesh_cache_data");
+  common::removeAll(cacheDir, common::FSWO_SUPPRESS_WARNINGS);
+  common::removeAll(dataDir, common::FSWO_SUPPRESS_WARNINGS);
+  ASSERT_TRUE(common::createDirectories(dataDir));
+
+  mgr->SetCacheDirectory(cacheDir);
+  mgr->SetCacheKey(common::MeshManager::CacheKey::CONTENT_SHA1);
+  EXPECT_EQ(cacheDir, mgr->CacheDirectory());
+
+  // A skinned, animated mesh and a mesh with PBR materials
+  ASSERT_TRUE(common::copyFile(
+        common::testing::TestFile("data", "blender_pbr.mtl"),
+        common::joinPaths(dataDir, "blender_pbr.mtl")));
+  for (const std::string source :
+      {"box_with_animation_outside_skeleton.dae", "blender_pbr.obj"})
+  {
+    const std::string extension = source.substr(source.rfind('.'));
+    std::vector<std::string> copies;
+    for (const std::string copy : {"a", "b", "c"})
+    {
+      copies.push_back(common::joinPaths(dataDir,
+            source.substr(0, source.rfind('.')) + "_" + copy + extension));
+      ASSERT_TRUE(common::copyFile(
+            common::testing::TestFile("data", source), copies.back()));
+    }
+
+    // The first load parses the file and adds it to the cache
+    const common::Mesh *parsed = mgr->Load(copies[0]);
+    ASSERT_NE(nullptr, parsed);
+    const std::vector<std::string> cacheFiles = ListFiles(cacheDir);
+    ASSERT_EQ(1u, cacheFiles.size());
+    const std::string cacheFile = cacheFiles[0];
+
+    // A file with the same content is read from the cache
+    const common::Mesh *cached = mgr->Load(copies[1]);
+    ASSERT_NE(nullptr, cached);
+    EXPECT_NE(parsed, cached);
+    EXPECT_EQ(copies[1], cached->Name());
+    ExpectSameMesh(*parsed, *cached);
+    EXPECT_EQ(1u, ListFiles(cacheDir).size());
+
+    // A truncated cache file is ignored and replaced
+    std::string content;
+    {
+      std::ifstream in(cacheFile, std::ios::binary);
+      content.assign(std::istreambuf_iterator<char>(in),
+          std::istreambuf_iterator<char>());
+    }
+    {
+      std::ofstream out(cacheFile, std::ios::binary | std::ios::trunc);
+      out.write(content.data(), content.size() / 2);
+    }
+    const common::Mesh *reparsed = mgr->Load(copies[2]);
+    ASSERT_NE(nullptr, reparsed);
+    ExpectSameMesh(*parsed, *reparsed);
+    {
+      std::ifstream in(cacheFile, std::ios::binary | std::ios::ate);
+      EXPECT_EQ(content.size(), static_cast<std::size_t>(in.tellg()));
+    }
+
+    common::removeFile(cacheFile);
+  }
+
+  mgr->SetCacheDirectory("");
+  mgr->SetCacheKey(common::MeshManager::CacheKey::FILE_STATS);
+  common::removeAll(cacheDir);
+  common::removeAll(dataDir);
+}
+
+/////////////////////////////////////////////////
+/// \brief Get the size of a file
+/// \param[in] _path Path of the file
+/// \return Number of bytes
+std::size_t FileSize(const std::string &_path)
+{
+  std::ifstream in(_path, std::ios::binary | std::ios::ate);
+  return static_cast<std::size_t>(in.tellg());
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshManager, ExportBinary)
+{
+  auto *mgr = common::MeshManager::Instance();
+  const std::string dir = common::testing::TempPath("mesh_binary");
+  common::removeAll(dir, common::FSWO_SUPPRESS_WARNINGS);
+  ASSERT_TRUE(common::createDirectories(dir));
+
+  // Skinned and animated meshes, and a mesh with PBR materials
+  for (const std::string source : {"cylinder_animated_from_3ds_max.dae",
+      "box_with_animation_outside_skeleton.dae", "cube_pbr.obj"})
+  {
+    const common::Mesh *parsed =
+      mgr->Load(common::testing::TestFile("data", source));
+    ASSERT_NE(nullptr, parsed);
+    const std::string base =
+      common::joinPaths(dir, source.substr(0, source.rfind('.')));
+
+    // Exported through the mesh manager and loaded like other mesh files
+    mgr->Export(parsed, base, "ignmesh");
+    EXPECT_TRUE(mgr->IsValidFilename(base + ".ignmesh"));
+    const common::Mesh *loaded = mgr->Load(base + ".ignmesh");
+    ASSERT_NE(nullptr, loaded);
+    ExpectSameMesh(*parsed, *loaded);
+
+    // Compressed files hold the same mesh in fewer bytes
+    common::BinaryMeshExporter exporter;
+    EXPECT_FALSE(exporter.Compression());
+    exporter.SetCompression(true);
+    EXPECT_TRUE(exporter.Compression());
+    exporter.Export(parsed, base + "_compressed");
+    EXPECT_LT(FileSize(base + "_compressed.ignmesh"),
+        FileSize(base + ".ignmesh"));
+
+    common::BinaryMeshLoader loader;
+    std::unique_ptr<common::Mesh> compressed(
+        loader.Load(base + "_compressed.ignmesh"));
+    ASSERT_NE(nullptr, compressed);
+    ExpectSameMesh(*parsed, *compressed);
+
+    // Truncated files are rejected
+    std::string content;
+    {
+      std::ifstream in(base + "_compressed.ignmesh", std::ios::binary);
+      content.assign(std::istreambuf_iterator<char>(in),
+          std::istreambuf_iterator<char>());
+    }
+    for (const std::size_t size : {content.size() / 2, content.size() - 8u})
+    {
+      {
+        std::ofstream out(base + "_truncated.ignmesh",
+            std::ios::binary | std::ios::trunc);
+        out.write(content.data(), size);
+      }
+      EXPECT_EQ(nullptr, loader.Load(base + "_truncated.ignmesh"));
+    }
+
+    // A corrupt skeleton node count is rejected before allocating nodes.
+    // The count follows the chunk header and the bind shape matrix.
+    if (parsed->HasSkeleton())
+    {
+      {
+        std::ifstream in(base + ".ignmesh", std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(in),
+            std::istreambuf_iterator<char>());
+      }
+      const std::size_t tag = content.find("SKEL");
+      ASSERT_NE(std::string::npos, tag);
+      const uint32_t nodeCount = 0x00FFFFFFu;
+      content.replace(tag + 16u + 128u, sizeof(nodeCount),
+          reinterpret_cast<const char *>(&nodeCount), sizeof(nodeCount));
+      {
+        std::ofstream out(base + "_corrupt.ignmesh",
+            std::ios::binary | std::ios::trunc);
+        out.write(content.data(), content.size());
+      }
+      EXPECT_EQ(nullptr, loader.Load(base + "_corrupt.ignmesh"));
+    }
+  }
+
+  EXPECT_EQ(nullptr, common::BinaryMeshLoader().Load(
+        common::joinPaths(dir, "missing.ignmesh")));
+  common::removeAll(dir);
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshManager, ExportBinaryEmptyTexCoordSet)
+{
+  const std::string dir = common::testing::TempPath("mesh_binary_empty");
+  common::removeAll(dir, common::FSWO_SUPPRESS_WARNINGS);
+  ASSERT_TRUE(common::createDirectories(dir));
+
+  for (const auto storage : {common::SubMesh::VertexStorage::DOUBLE,
+      common::SubMesh::VertexStorage::FLOAT32})
+  {
+    // Set 0 is created empty, before any vertex is added
+    common::Mesh mesh;
+    common::SubMesh subMesh;
+    subMesh.SetVertexStorage(storage);
+    subMesh.GenSphericalTexCoordBySet(math::Vector3d::Zero, 0u);
+    subMesh.AddVertex(0, 0, 0);
+    subMesh.AddVertex(1, 0, 0);
+    subMesh.AddVertex(0, 1, 0);
+    subMesh.AddIndex(0);
+    subMesh.AddIndex(1);
+    subMesh.AddIndex(2);
+    for (unsigned int i = 0; i < 3u; ++i)
+      subMesh.AddTexCoordBySet(i, 0.5, 3u);
+    ASSERT_EQ(2u, subMesh.TexCoordSetCount());
+    EXPECT_EQ(std::vector<unsigned int>({0u, 3u}),
+        subMesh.TexCoordSetIndices());
+    EXPECT_EQ(0u, subMesh.TexCoordCountBySet(0u));
+    mesh.AddSubMesh(subMesh);
+
+    // Empty sets are kept, so that cached meshes match parsed ones
+    const std::string base = common::joinPaths(dir, "empty_set");
+    common::BinaryMeshExporter().Export(&mesh, base);
+    std::unique_ptr<common::Mesh> loaded(
+        common::BinaryMeshLoader().Load(base + ".ignmesh"));
+    ASSERT_NE(nullptr, loaded);
+    ASSERT_EQ(1u, loaded->SubMeshCount());
+    auto loadedSubMesh = loaded->SubMeshByIndex(0).lock();
+    ASSERT_NE(nullptr, loadedSubMesh);
+    EXPECT_EQ(storage, loadedSubMesh->VertexStorageType());
+    EXPECT_EQ(subMesh.Min(), loadedSubMesh->Min());
+    EXPECT_EQ(subMesh.Max(), loadedSubMesh->Max());
+    EXPECT_EQ(std::vector<unsigned int>({0u, 1u, 2u}),
+        std::vector<unsigned int>(loadedSubMesh->IndexData(),
+          loadedSubMesh->IndexData() + loadedSubMesh->IndexCount()));
+    EXPECT_EQ(subMesh.TexCoordSetCount(),
+        loadedSubMesh->TexCoordSetCount());
+    EXPECT_EQ(subMesh.TexCoordSetIndices(),
+        loadedSubMesh->TexCoordSetIndices());
+    EXPECT_EQ(0u, loadedSubMesh->TexCoordCountBySet(0u));
+    ASSERT_EQ(3u, loadedSubMesh->TexCoordCountBySet(3u));
+    EXPECT_EQ(math::Vector2d(2, 0.5), loadedSubMesh->TexCoordBySet(2u, 3u));
+  }
+
+  common::removeAll(dir);
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshManager, LoadBatch)
+{
+  auto *mgr = common::MeshManager::Instance();
+
+  const std::string boxDae = common::testing::TestFile("data", "box.dae");
+  const std::string boxObj = common::testing::TestFile("data", "box.obj");
+  const std::string pbrObj =
+    common::testing::TestFile("data", "cube_pbr.obj");
+  const std::string nodesDae = common::testing::TestFile("data",
+      "box_with_hierarchical_nodes.dae");
+  const std::string missing = common::testing::TestFile("data",
+      "missing.dae");
+
+  // Duplicates share a single mesh, failures are nullptr
+  const std::vector<std::string> files =
+    {boxDae, boxObj, pbrObj, boxDae, missing, nodesDae, "box.xyz", boxObj};
+  const std::vector<const common::Mesh *> meshes = mgr->LoadBatch(files);
+  ASSERT_EQ(files.size(), meshes.size());
+  EXPECT_EQ(nullptr, meshes[4]);
+  EXPECT_EQ(nullptr, meshes[6]);
+  EXPECT_EQ(meshes[0], meshes[3]);
+  EXPECT_EQ(meshes[1], meshes[7]);
+  for (const std::size_t i : {0u, 1u, 2u, 5u})
+  {
+    ASSERT_NE(nullptr, meshes[i]);
+    EXPECT_EQ(files[i], meshes[i]->Name());
+    EXPECT_EQ(meshes[i], mgr->MeshByName(files[i]));
+    EXPECT_EQ(meshes[i], mgr->Load(files[i]));
+    EXPECT_LT(0u, meshes[i]->SubMeshCount());
+  }
+  EXPECT_NE(meshes[0], meshes[1]);
+  EXPECT_FALSE(mgr->HasMesh(missing));
+
+  // Asynchronous loads of loaded and new meshes
+  common::TaskFuture<const common::Mesh *> loaded = mgr->LoadAsync(boxDae);
+  const std::string newDae = common::testing::TestFile("data",
+      "box_with_multiple_geoms.dae");
+  std::vector<common::TaskFuture<const common::Mesh *>> pending;
+  for (int i = 0; i < 8; ++i)
+    pending.push_back(mgr->LoadAsync(newDae));
+  const common::Mesh *direct = mgr->Load(newDae);
+  ASSERT_NE(nullptr, direct);
+  EXPECT_EQ(meshes[0], loaded.Get());
+  for (const auto &future : pending)
+    EXPECT_EQ(direct, future.Get());
+  EXPECT_EQ(nullptr, mgr->LoadAsync(missing).Get());
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshManager, LoadThrows)
+{
+  auto *mgr = common::MeshManager::Instance();
+
+  // A vertex weight offset that is not a number makes the loader throw
+  const std::string path = common::testing::TempPath("mesh_throws.dae");
+  ASSERT_TRUE(common::createDirectories(common::parentPath(path)));
+  {
+    std::ifstream in(common::testing::TestFile("data",
+          "box_inst_controller_without_skeleton.dae"));
+    std::string content((std::istreambuf_iterator<char>(in)),
+        std::istreambuf_iterator<char>());
+    const std::string offset =
+      "source=\"#Armature_Cube-skin-weights\" offset=\"1\"";
+    const std::size_t pos = content.find(offset);
+    ASSERT_NE(std::string::npos, pos);
+    content.replace(pos, offset.size(),
+        "source=\"#Armature_Cube-skin-weights\" offset=\"abc\"");
+    std::ofstream out(path);
+    out << content;
+  }
+
+  // Failed loads are not left pending, so later loads throw again
+  // rather than wait for them
+  EXPECT_ANY_THROW(mgr->Load(path));
+  EXPECT_ANY_THROW(mgr->Load(path));
+  EXPECT_FALSE(mgr->HasMesh(path));
+
+  // Batches load the other files, on workers and on the calling thread
+  const std::string box = common::testing::TestFile("data", "box.dae");
+  const std::vector<std::string> files = {path, box, path, path, box};
+  const std::vector<const common::Mesh *> meshes = mgr->LoadBatch(files);
+  ASSERT_EQ(files.size(), meshes.size());
+  EXPECT_EQ(nullptr, meshes[0]);
+  EXPECT_NE(nullptr, meshes[1]);
+  EXPECT_EQ(nullptr, meshes[2]);
+  EXPECT_EQ(nullptr, meshes[3]);
+  EXPECT_EQ(meshes[1], meshes[4]);
+  EXPECT_FALSE(mgr->HasMesh(path));
+
+  common::removeFile(path);
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshManager, LoadRacesAddMesh)
+{
+  auto *mgr = common::MeshManager::Instance();
+  const std::string dir = common::testing::TempPath("mesh_race");
+  ASSERT_TRUE(common::createDirectories(dir));
+  ASSERT_TRUE(common::copyFile(
+        common::testing::TestFile("data", "blender_pbr.mtl"),
+        common::joinPaths(dir, "blender_pbr.mtl")));
+
+  // Whichever mesh gets in first, loads return the mesh the manager owns.
+  // Meshes are added at different times while the files are decoded.
+  for (int i = 0; i < 8; ++i)
+  {
+    const std::string path =
+      common::joinPaths(dir, "race_" + std::to_string(i) + ".obj");
+    ASSERT_TRUE(common::copyFile(
+          common::testing::TestFile("data", "blender_pbr.obj"), path));
+
+    common::TaskFuture<const common::Mesh *> loading = mgr->LoadAsync(path);
+    std::this_thread::sleep_for(std::chrono::microseconds(500 * i));
+    common::Mesh *added = new common::Mesh();
+    added->SetName(path);
+    mgr->AddMesh(added);
+
+    const common::Mesh *loaded = loading.Get();
+    ASSERT_NE(nullptr, loaded);
+    EXPECT_EQ(mgr->MeshByName(path), loaded);
+    EXPECT_EQ(loaded, mgr->Load(path));
+    if (loaded != added)
+      delete added;
+  }
+
+  common::removeAll(dir);
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshManager, LookupCounters)
+{
+  auto *mgr = common::MeshManager::Instance();
+  mgr->ResetLookupCounters();
+  EXPECT_EQ(0u, mgr->LookupHits());
+  EXPECT_EQ(0u, mgr->LookupMisses());
+  EXPECT_EQ(0u, mgr->LookupContentions());
+
+  // Checks made by the manager itself are not counted
+  mgr->CreateBox("lookup_counters_box", math::Vector3d::One,
+      math::Vector2d::One);
+  mgr->CreateBox("lookup_counters_box", math::Vector3d::One,
+      math::Vector2d::One);
+  EXPECT_TRUE(mgr->CreateLods("lookup_counters_box", 1u));
+  EXPECT_NE(nullptr, mgr->MeshLod("lookup_counters_box", 1u));
+  EXPECT_EQ(nullptr, mgr->MeshLod("lookup_counters_box", 2u));
+  EXPECT_EQ(0u, mgr->LookupHits());
+  EXPECT_EQ(0u, mgr->LookupMisses());
+
+  EXPECT_TRUE(mgr->HasMesh("unit_box"));
+  EXPECT_NE(nullptr, mgr->MeshByName("unit_sphere"));
+  EXPECT_EQ(nullptr, mgr->MeshByName("lookup_counters_missing"));
+  EXPECT_EQ(2u, mgr->LookupHits());
+  EXPECT_EQ(1u, mgr->LookupMisses());
+
+  // Readers only ever see meshes that are complete
+  const int count = 200;
+  std::atomic<bool> done{false};
+  std::atomic<int> incomplete{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t)
+  {
+    readers.emplace_back([&]
+        {
+          while (!done)
+          {
+            for (int i = 0; i < count; ++i)
+            {
+              const common::Mesh *mesh =
+                mgr->MeshByName("lookup_sphere_" + std::to_string(i));
+              if (mesh && (mesh->SubMeshCount() != 1u ||
+                    mesh->SubMeshByIndex(0).lock()->IndexCount() == 0u))
+              {
+                ++incomplete;
+              }
+            }
+          }
+        });
+  }
+  for (int i = 0; i < count; ++i)
+    mgr->CreateSphere("lookup_sphere_" + std::to_string(i), 1.0f, 32, 32);
+  done = true;
+  for (auto &reader : readers)
+    reader.join();
+
+  EXPECT_EQ(0, incomplete);
+  for (int i = 0; i < count; ++i)
+    EXPECT_TRUE(mgr->HasMesh("lookup_sphere_" + std::to_string(i)));
+  EXPECT_LT(2u, mgr->LookupHits());
+  EXPECT_LT(1u, mgr->LookupMisses());
+
+  mgr->ResetLookupCounters();
+  EXPECT_EQ(0u, mgr->LookupHits());
+  EXPECT_EQ(0u, mgr->LookupMisses());
+  EXPECT_EQ(0u, mgr->LookupContentions());
+}
+
 /////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
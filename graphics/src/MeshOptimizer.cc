@@ -0,0 +1,493 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <ignition/math/Vector3.hh>
+
+#include "ignition/common/Mesh.hh"
+#include "ignition/common/MeshOptimizer.hh"
+#include "ignition/common/Parallel.hh"
+#include "ignition/common/SubMesh.hh"
+
+using namespace ignition;
+using namespace common;
+
+/// \brief Private data for the MeshOptimizer class
+class ignition::common::MeshOptimizer::Implementation
+{
+  /// \brief Number of entries of the vertex cache
+  public: unsigned int cacheSize = 16u;
+
+  /// \brief Largest accepted ratio of ACMR after and before overdraw
+  /// sorting
+  public: double overdrawThreshold = 1.05;
+
+  /// \brief Number of triangles seen by the last call to Optimize
+  public: std::size_t triangles = 0u;
+
+  /// \brief Cache misses before the last call to Optimize
+  public: std::size_t missesBefore = 0u;
+
+  /// \brief Cache misses after the last call to Optimize
+  public: std::size_t missesAfter = 0u;
+};
+
+namespace
+{
+  /// \brief Value of a vertex index that refers to no vertex
+  const int64_t kNoVertex = -1;
+
+  /// \brief Statistics of the optimization of one submesh
+  struct SubMeshResult
+  {
+    /// \brief Number of triangles
+    std::size_t triangles = 0u;
+
+    /// \brief Cache misses before optimization
+    std::size_t missesBefore = 0u;
+
+    /// \brief Cache misses after optimization
+    std::size_t missesAfter = 0u;
+  };
+
+  /// \brief Count the vertices transformed by a FIFO vertex cache
+  /// \param[in] _indices Triangle list
+  /// \param[in] _vertexCount One more than the largest index
+  /// \param[in] _cacheSize Number of entries of the cache
+  /// \return Number of cache misses
+  std::size_t CacheMisses(const std::vector<unsigned int> &_indices,
+      const std::size_t _vertexCount, const unsigned int _cacheSize)
+  {
+    // A vertex is in the cache if fewer than _cacheSize vertices entered
+    // it since the vertex did
+    std::vector<std::size_t> entered(_vertexCount, 0u);
+    std::size_t time = _cacheSize + 1u;
+    std::size_t misses = 0u;
+    for (const unsigned int index : _indices)
+    {
+      if (time - entered[index] > _cacheSize)
+      {
+        entered[index] = time++;
+        ++misses;
+      }
+    }
+    return misses;
+  }
+
+  /// \brief Order triangles for a vertex cache with Tipsify, from "Fast
+  /// Triangle Reordering for Vertex Locality and Reduced Overdraw" by
+  /// Sander, Nehab and Barczak. Triangles are emitted as fans around a
+  /// vertex, and the next fan is centered on a vertex that is still in
+  /// the cache and will stay there while its remaining triangles are
+  /// emitted. When no such vertex exists, the order jumps elsewhere and a
+  /// new cluster of triangles starts.
+  /// \param[in] _indices Triangle list
+  /// \param[in] _vertexCount One more than the largest index
+  /// \param[in] _cacheSize Number of entries of the cache
+  /// \param[out] _clusters Index of the first triangle of every cluster
+  /// \return Reordered triangle list
+  std::vector<unsigned int> Tipsify(const std::vector<unsigned int> &_indices,
+      const std::size_t _vertexCount, const unsigned int _cacheSize,
+      std::vector<std::size_t> &_clusters)
+  {
+    const std::size_t triangleCount = _indices.size() / 3u;
+
+    // Triangles that use every vertex, in compressed rows
+    std::vector<std::size_t> offsets(_vertexCount + 1u, 0u);
+    for (const unsigned int index : _indices)
+      ++offsets[index + 1u];
+    for (std::size_t v = 0; v < _vertexCount; ++v)
+      offsets[v + 1u] += offsets[v];
+    std::vector<unsigned int> adjacency(_indices.size());
+    {
+      std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+      for (std::size_t i = 0; i < _indices.size(); ++i)
+        adjacency[fill[_indices[i]]++] = static_cast<unsigned int>(i / 3u);
+    }
+
+    // Number of triangles not emitted yet, for every vertex
+    std::vector<unsigned int> live(_vertexCount);
+    for (std::size_t v = 0; v < _vertexCount; ++v)
+      live[v] = static_cast<unsigned int>(offsets[v + 1u] - offsets[v]);
+
+    std::vector<std::size_t> entered(_vertexCount, 0u);
+    std::size_t time = _cacheSize + 1u;
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnds;
+    std::vector<unsigned int> candidates;
+    std::size_t cursor = 0u;
+
+    // Vertex with triangles left, recently used if possible
+    auto skipDeadEnd = [&]() -> int64_t
+    {
+      while (!deadEnds.empty())
+      {
+        const unsigned int v = deadEnds.back();
+        deadEnds.pop_back();
+        if (live[v] > 0u)
+          return v;
+      }
+      for (; cursor < _vertexCount; ++cursor)
+      {
+        if (live[cursor] > 0u)
+          return static_cast<int64_t>(cursor);
+      }
+      return kNoVertex;
+    };
+
+    std::vector<unsigned int> out;
+    out.reserve(_indices.size());
+    _clusters.assign(1u, 0u);
+    int64_t fan = skipDeadEnd();
+    while (fan != kNoVertex)
+    {
+      candidates.clear();
+      for (std::size_t k = offsets[fan]; k < offsets[fan + 1]; ++k)
+      {
+        const unsigned int t = adjacency[k];
+        if (emitted[t])
+          continue;
+        emitted[t] = true;
+        for (unsigned int c = 0; c < 3u; ++c)
+        {
+          const unsigned int v = _indices[t * 3u + c];
+          out.push_back(v);
+          deadEnds.push_back(v);
+          candidates.push_back(v);
+          --live[v];
+          if (time - entered[v] > _cacheSize)
+            entered[v] = time++;
+        }
+      }
+
+      // Prefer the vertex that entered the cache earliest, as long as
+      // emitting its remaining triangles keeps it in the cache
+      int64_t next = kNoVertex;
+      std::size_t bestPriority = 0u;
+      for (const unsigned int v : candidates)
+      {
+        if (live[v] == 0u)
+          continue;
+        std::size_t priority = 1u;
+        const std::size_t age = time - entered[v];
+        if (age + 2u * live[v] <= _cacheSize)
+          priority += age;
+        if (priority > bestPriority)
+        {
+          bestPriority = priority;
+          next = v;
+        }
+      }
+
+      if (next == kNoVertex)
+      {
+        next = skipDeadEnd();
+        if (next != kNoVertex)
+          _clusters.push_back(out.size() / 3u);
+      }
+      fan = next;
+    }
+    return out;
+  }
+
+  /// \brief Sort clusters of triangles so that the ones that face away
+  /// from the center of the mesh, and so are likely to occlude others,
+  /// come first.
+  /// \param[in] _indices Triangle list
+  /// \param[in] _clusters Index of the first triangle of every cluster
+  /// \param[in] _positions Vertex positions
+  /// \return Reordered triangle list
+  std::vector<unsigned int> SortClusters(
+      const std::vector<unsigned int> &_indices,
+      const std::vector<std::size_t> &_clusters,
+      const std::vector<math::Vector3d> &_positions)
+  {
+    const std::size_t triangleCount = _indices.size() / 3u;
+    const std::size_t clusterCount = _clusters.size();
+
+    // Area weighted centroid and normal of every cluster, and of the mesh
+    std::vector<math::Vector3d> centroids(clusterCount);
+    std::vector<math::Vector3d> normals(clusterCount);
+    std::vector<double> areas(clusterCount, 0.0);
+    math::Vector3d meshCentroid;
+    double meshArea = 0.0;
+    for (std::size_t c = 0; c < clusterCount; ++c)
+    {
+      const std::size_t last =
+        c + 1u < clusterCount ? _clusters[c + 1u] : triangleCount;
+      for (std::size_t t = _clusters[c]; t < last; ++t)
+      {
+        const math::Vector3d &a = _positions[_indices[t * 3u]];
+        const math::Vector3d &b = _positions[_indices[t * 3u + 1u]];
+        const math::Vector3d &d = _positions[_indices[t * 3u + 2u]];
+        const math::Vector3d cross = (b - a).Cross(d - a);
+        const double area = cross.Length();
+        centroids[c] += (a + b + d) * (area / 3.0);
+        normals[c] += cross;
+        areas[c] += area;
+      }
+      meshCentroid += centroids[c];
+      meshArea += areas[c];
+      if (areas[c] > 0.0)
+        centroids[c] /= areas[c];
+    }
+    if (meshArea > 0.0)
+      meshCentroid /= meshArea;
+
+    std::vector<double> keys(clusterCount, 0.0);
+    for (std::size_t c = 0; c < clusterCount; ++c)
+    {
+      const double length = normals[c].Length();
+      if (length > 0.0)
+        keys[c] = (centroids[c] - meshCentroid).Dot(normals[c]) / length;
+    }
+
+    std::vector<std::size_t> order(clusterCount);
+    for (std::size_t c = 0; c < clusterCount; ++c)
+      order[c] = c;
+    std::stable_sort(order.begin(), order.end(),
+        [&keys](const std::size_t _a, const std::size_t _b)
+        {
+          return keys[_a] > keys[_b];
+        });
+
+    std::vector<unsigned int> out;
+    out.reserve(_indices.size());
+    for (const std::size_t c : order)
+    {
+      const std::size_t last =
+        c + 1u < clusterCount ? _clusters[c + 1u] : triangleCount;
+      out.insert(out.end(), _indices.begin() + _clusters[c] * 3u,
+          _indices.begin() + last * 3u);
+    }
+    return out;
+  }
+
+  /// \brief Optimize a submesh
+  /// \param[in,out] _subMesh Submesh to optimize
+  /// \param[in] _cacheSize Number of entries of the vertex cache
+  /// \param[in] _overdrawThreshold Largest accepted ratio of ACMR after
+  /// and before overdraw sorting
+  /// \param[out] _result Statistics of the optimization
+  /// \return False if the submesh cannot be optimized
+  bool OptimizeSubMesh(SubMesh &_subMesh, const unsigned int _cacheSize,
+      const double _overdrawThreshold, SubMeshResult &_result)
+  {
+    _result = SubMeshResult();
+    const std::size_t indexCount = _subMesh.IndexCount();
+    const std::size_t vertexCount = _subMesh.VertexCount();
+    if (_subMesh.SubMeshPrimitiveType() != SubMesh::TRIANGLES ||
+        indexCount == 0u || indexCount % 3u != 0u)
+    {
+      return false;
+    }
+
+    // Vertices can only be reordered along with their attributes, so the
+    // submesh is checked before anything is changed
+    if (_subMesh.NormalCount() != 0u && _subMesh.NormalCount() != vertexCount)
+      return false;
+    for (const unsigned int set : _subMesh.TexCoordSetIndices())
+    {
+      const std::size_t count = _subMesh.TexCoordCountBySet(set);
+      if (count != 0u && count != vertexCount)
+        return false;
+    }
+
+    std::vector<unsigned int> indices(_subMesh.IndexData(),
+        _subMesh.IndexData() + indexCount);
+    for (const unsigned int index : indices)
+    {
+      if (index >= vertexCount)
+        return false;
+    }
+
+    _result.triangles = indexCount / 3u;
+    _result.missesBefore = CacheMisses(indices, vertexCount, _cacheSize);
+
+    std::vector<std::size_t> clusters;
+    std::vector<unsigned int> ordered =
+      Tipsify(indices, vertexCount, _cacheSize, clusters);
+    std::size_t misses = CacheMisses(ordered, vertexCount, _cacheSize);
+
+    if (_overdrawThreshold >= 1.0 && clusters.size() > 1u)
+    {
+      std::vector<math::Vector3d> positions(vertexCount);
+      for (std::size_t v = 0; v < vertexCount; ++v)
+        positions[v] = _subMesh.Vertex(static_cast<unsigned int>(v));
+      std::vector<unsigned int> sorted =
+        SortClusters(ordered, clusters, positions);
+      const std::size_t sortedMisses =
+        CacheMisses(sorted, vertexCount, _cacheSize);
+      if (static_cast<double>(sortedMisses) <=
+          _overdrawThreshold * static_cast<double>(misses))
+      {
+        ordered.swap(sorted);
+        misses = sortedMisses;
+      }
+    }
+
+    // Keep the original order if it was already better
+    if (misses < _result.missesBefore)
+    {
+      for (std::size_t i = 0; i < indexCount; ++i)
+        _subMesh.SetIndex(static_cast<unsigned int>(i), ordered[i]);
+      indices.swap(ordered);
+    }
+    else
+    {
+      misses = _result.missesBefore;
+    }
+    _result.missesAfter = misses;
+
+    // Number vertices in the order triangles first use them. Unused
+    // vertices go last, in their original order.
+    const unsigned int unset = std::numeric_limits<unsigned int>::max();
+    std::vector<unsigned int> newIndex(vertexCount, unset);
+    std::vector<unsigned int> order;
+    order.reserve(vertexCount);
+    for (const unsigned int index : indices)
+    {
+      if (newIndex[index] == unset)
+      {
+        newIndex[index] = static_cast<unsigned int>(order.size());
+        order.push_back(index);
+      }
+    }
+    for (std::size_t v = 0; v < vertexCount; ++v)
+    {
+      if (newIndex[v] == unset)
+        order.push_back(static_cast<unsigned int>(v));
+    }
+    return _subMesh.ReorderVertices(order);
+  }
+}
+
+//////////////////////////////////////////////////
+MeshOptimizer::MeshOptimizer()
+: dataPtr(ignition::utils::MakeImpl<Implementation>())
+{
+}
+
+//////////////////////////////////////////////////
+MeshOptimizer::~MeshOptimizer()
+{
+}
+
+//////////////////////////////////////////////////
+void MeshOptimizer::SetCacheSize(const unsigned int _size)
+{
+  this->dataPtr->cacheSize = std::max(_size, 3u);
+}
+
+//////////////////////////////////////////////////
+unsigned int MeshOptimizer::CacheSize() const
+{
+  return this->dataPtr->cacheSize;
+}
+
+//////////////////////////////////////////////////
+void MeshOptimizer::SetOverdrawThreshold(const double _threshold)
+{
+  this->dataPtr->overdrawThreshold = _threshold;
+}
+
+//////////////////////////////////////////////////
+double MeshOptimizer::OverdrawThreshold() const
+{
+  return this->dataPtr->overdrawThreshold;
+}
+
+//////////////////////////////////////////////////
+void MeshOptimizer::Optimize(Mesh &_mesh)
+{
+  std::vector<SubMeshResult> results(_mesh.SubMeshCount());
+  const unsigned int cacheSize = this->dataPtr->cacheSize;
+  const double threshold = this->dataPtr->overdrawThreshold;
+  ParallelFor(0u, results.size(), 1u,
+      [&](const std::size_t _first, const std::size_t _last)
+      {
+        for (std::size_t i = _first; i < _last; ++i)
+        {
+          auto subMesh =
+            _mesh.SubMeshByIndex(static_cast<unsigned int>(i)).lock();
+          if (subMesh)
+            OptimizeSubMesh(*subMesh, cacheSize, threshold, results[i]);
+        }
+      });
+
+  this->dataPtr->triangles = 0u;
+  this->dataPtr->missesBefore = 0u;
+  this->dataPtr->missesAfter = 0u;
+  for (const SubMeshResult &result : results)
+  {
+    this->dataPtr->triangles += result.triangles;
+    this->dataPtr->missesBefore += result.missesBefore;
+    this->dataPtr->missesAfter += result.missesAfter;
+  }
+}
+
+//////////////////////////////////////////////////
+bool MeshOptimizer::Optimize(SubMesh &_subMesh)
+{
+  SubMeshResult result;
+  const bool optimized = OptimizeSubMesh(_subMesh, this->dataPtr->cacheSize,
+      this->dataPtr->overdrawThreshold, result);
+  this->dataPtr->triangles = result.triangles;
+  this->dataPtr->missesBefore = result.missesBefore;
+  this->dataPtr->missesAfter = result.missesAfter;
+  return optimized;
+}
+
+//////////////////////////////////////////////////
+double MeshOptimizer::AcmrBefore() const
+{
+  if (this->dataPtr->triangles == 0u)
+    return 0.0;
+  return static_cast<double>(this->dataPtr->missesBefore) /
+    static_cast<double>(this->dataPtr->triangles);
+}
+
+//////////////////////////////////////////////////
+double MeshOptimizer::AcmrAfter() const
+{
+  if (this->dataPtr->triangles == 0u)
+    return 0.0;
+  return static_cast<double>(this->dataPtr->missesAfter) /
+    static_cast<double>(this->dataPtr->triangles);
+}
+
+//////////////////////////////////////////////////
+double MeshOptimizer::Acmr(const SubMesh &_subMesh,
+    const unsigned int _cacheSize)
+{
+  const std::size_t indexCount = _subMesh.IndexCount();
+  if (indexCount < 3u || _cacheSize == 0u)
+    return 0.0;
+
+  const std::vector<unsigned int> indices(_subMesh.IndexData(),
+      _subMesh.IndexData() + indexCount / 3u * 3u);
+  const std::size_t vertexCount = static_cast<std::size_t>(
+      *std::max_element(indices.begin(), indices.end())) + 1u;
+  return static_cast<double>(CacheMisses(indices, vertexCount, _cacheSize)) /
+    static_cast<double>(indexCount / 3u);
+}
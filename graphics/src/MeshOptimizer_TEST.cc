@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "test_config.h"
+#include "ignition/common/Mesh.hh"
+#include "ignition/common/MeshManager.hh"
+#include "ignition/common/MeshOptimizer.hh"
+#include "ignition/common/SubMesh.hh"
+
+using namespace ignition;
+
+class MeshOptimizer : public common::testing::AutoLogFixture { };
+
+/////////////////////////////////////////////////
+/// \brief Create a grid of vertices with triangles in random order
+/// \param[in] _size Number of vertices along each side
+/// \return The grid. Normals and texture coordinates are derived from
+/// the positions.
+std::unique_ptr<common::SubMesh> ShuffledGrid(const unsigned int _size)
+{
+  auto subMesh = std::make_unique<common::SubMesh>("grid");
+  for (unsigned int y = 0; y < _size; ++y)
+  {
+    for (unsigned int x = 0; x < _size; ++x)
+    {
+      subMesh->AddVertex(x, y, 0);
+      subMesh->AddNormal(0, x, y);
+      subMesh->AddTexCoord(x, y);
+    }
+  }
+
+  std::vector<std::array<unsigned int, 3>> triangles;
+  for (unsigned int y = 0; y + 1 < _size; ++y)
+  {
+    for (unsigned int x = 0; x + 1 < _size; ++x)
+    {
+      const unsigned int i = y * _size + x;
+      triangles.push_back({i, i + 1, i + _size});
+      triangles.push_back({i + 1, i + _size + 1, i + _size});
+    }
+  }
+  std::shuffle(triangles.begin(), triangles.end(), std::mt19937(7));
+  for (const auto &triangle : triangles)
+    for (const unsigned int index : triangle)
+      subMesh->AddIndex(index);
+  return subMesh;
+}
+
+/////////////////////////////////////////////////
+/// \brief Get the triangles of a submesh as sorted vertex positions
+/// \param[in] _subMesh Submesh
+/// \return Sorted triangles
+std::vector<std::vector<double>> Triangles(const common::SubMesh &_subMesh)
+{
+  std::vector<std::vector<double>> triangles;
+  for (unsigned int t = 0; t < _subMesh.IndexCount() / 3u; ++t)
+  {
+    std::vector<std::array<double, 3>> corners;
+    for (unsigned int c = 0; c < 3u; ++c)
+    {
+      const math::Vector3d v = _subMesh.Vertex(_subMesh.Index(t * 3u + c));
+      corners.push_back({v.X(), v.Y(), v.Z()});
+    }
+
+    // Rotate the smallest corner first, which keeps the winding
+    const auto first = std::min_element(corners.begin(), corners.end());
+    std::rotate(corners.begin(), first, corners.end());
+    std::vector<double> triangle;
+    for (const auto &corner : corners)
+      triangle.insert(triangle.end(), corner.begin(), corner.end());
+    triangles.push_back(triangle);
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshOptimizer, SubMesh)
+{
+  auto subMesh = ShuffledGrid(64);
+  subMesh->AddNodeAssignment(5, 1, 0.5f);
+  subMesh->AddNodeAssignment(64 * 64 - 1, 2, 0.25f);
+  const auto before = Triangles(*subMesh);
+  const double acmr = common::MeshOptimizer::Acmr(*subMesh);
+
+  common::MeshOptimizer optimizer;
+  EXPECT_EQ(16u, optimizer.CacheSize());
+  EXPECT_DOUBLE_EQ(1.05, optimizer.OverdrawThreshold());
+  EXPECT_DOUBLE_EQ(0.0, optimizer.AcmrBefore());
+  ASSERT_TRUE(optimizer.Optimize(*subMesh));
+
+  // The cache efficiency improves a lot for shuffled triangles
+  EXPECT_DOUBLE_EQ(acmr, optimizer.AcmrBefore());
+  EXPECT_GT(optimizer.AcmrBefore(), 2.0);
+  EXPECT_LT(optimizer.AcmrAfter(), 0.8);
+  EXPECT_DOUBLE_EQ(optimizer.AcmrAfter(),
+      common::MeshOptimizer::Acmr(*subMesh));
+
+  // The same triangles are drawn with the same winding
+  EXPECT_EQ(before, Triangles(*subMesh));
+
+  // Vertices are numbered in the order they are first used, and their
+  // attributes move with them
+  unsigned int next = 0u;
+  for (unsigned int i = 0; i < subMesh->IndexCount(); ++i)
+  {
+    const unsigned int index = subMesh->Index(i);
+    EXPECT_LE(index, next);
+    if (index == next)
+      ++next;
+  }
+  EXPECT_EQ(subMesh->VertexCount(), next);
+  for (unsigned int v = 0; v < subMesh->VertexCount(); ++v)
+  {
+    const math::Vector3d p = subMesh->Vertex(v);
+    EXPECT_EQ(math::Vector3d(0, p.X(), p.Y()), subMesh->Normal(v));
+    EXPECT_EQ(math::Vector2d(p.X(), p.Y()), subMesh->TexCoord(v));
+  }
+
+  ASSERT_EQ(2u, subMesh->NodeAssignmentsCount());
+  EXPECT_EQ(math::Vector3d(5, 0, 0), subMesh->Vertex(
+        subMesh->NodeAssignmentByIndex(0).vertexIndex));
+  EXPECT_EQ(math::Vector3d(63, 63, 0), subMesh->Vertex(
+        subMesh->NodeAssignmentByIndex(1).vertexIndex));
+
+  // Optimizing again keeps an order at least as good
+  const double optimized = optimizer.AcmrAfter();
+  ASSERT_TRUE(optimizer.Optimize(*subMesh));
+  EXPECT_DOUBLE_EQ(optimized, optimizer.AcmrBefore());
+  EXPECT_LE(optimizer.AcmrAfter(), optimized);
+
+  // Without overdraw sorting and with a larger cache
+  auto other = ShuffledGrid(64);
+  optimizer.SetOverdrawThreshold(0.0);
+  optimizer.SetCacheSize(32u);
+  ASSERT_TRUE(optimizer.Optimize(*other));
+  EXPECT_EQ(before, Triangles(*other));
+  EXPECT_LT(optimizer.AcmrAfter(), 0.8);
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshOptimizer, Unsupported)
+{
+  common::MeshOptimizer optimizer;
+
+  // Lines
+  auto lines = ShuffledGrid(4);
+  lines->SetPrimitiveType(common::SubMesh::LINES);
+  EXPECT_FALSE(optimizer.Optimize(*lines));
+
+  // Index out of range
+  auto invalid = ShuffledGrid(4);
+  invalid->SetIndex(0, 1000);
+  EXPECT_FALSE(optimizer.Optimize(*invalid));
+  EXPECT_EQ(1000, invalid->Index(0));
+  EXPECT_DOUBLE_EQ(0.0, optimizer.AcmrAfter());
+
+  // Empty
+  common::SubMesh empty;
+  EXPECT_FALSE(optimizer.Optimize(empty));
+  EXPECT_DOUBLE_EQ(0.0, common::MeshOptimizer::Acmr(empty));
+
+  // Attributes that are not given per vertex leave the submesh unchanged
+  auto normals = ShuffledGrid(16);
+  normals->AddNormal(0, 0, 1);
+  const auto before = Triangles(*normals);
+  const std::vector<unsigned int> indices(normals->IndexData(),
+      normals->IndexData() + normals->IndexCount());
+  EXPECT_FALSE(optimizer.Optimize(*normals));
+  EXPECT_EQ(before, Triangles(*normals));
+  EXPECT_EQ(indices, std::vector<unsigned int>(normals->IndexData(),
+        normals->IndexData() + normals->IndexCount()));
+  EXPECT_EQ(math::Vector3d(0, 5, 0), normals->Normal(5));
+
+  auto texCoords = ShuffledGrid(16);
+  texCoords->AddTexCoordBySet(0, 0, 2u);
+  const std::vector<unsigned int> texCoordIndices(texCoords->IndexData(),
+      texCoords->IndexData() + texCoords->IndexCount());
+  EXPECT_FALSE(optimizer.Optimize(*texCoords));
+  EXPECT_EQ(texCoordIndices, std::vector<unsigned int>(
+        texCoords->IndexData(),
+        texCoords->IndexData() + texCoords->IndexCount()));
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshOptimizer, Mesh)
+{
+  common::Mesh mesh;
+  mesh.AddSubMesh(ShuffledGrid(32));
+  mesh.AddSubMesh(ShuffledGrid(16));
+  auto lines = ShuffledGrid(8);
+  lines->SetPrimitiveType(common::SubMesh::LINESTRIPS);
+  mesh.AddSubMesh(std::move(lines));
+
+  double misses = 0.0;
+  for (unsigned int i = 0; i < 2u; ++i)
+  {
+    auto subMesh = mesh.SubMeshByIndex(i).lock();
+    misses += common::MeshOptimizer::Acmr(*subMesh) *
+      (subMesh->IndexCount() / 3u);
+  }
+
+  common::MeshOptimizer optimizer;
+  optimizer.Optimize(mesh);
+  EXPECT_NEAR(misses / ((31 * 31 + 15 * 15) * 2), optimizer.AcmrBefore(),
+      1e-9);
+  EXPECT_LT(optimizer.AcmrAfter(), 0.8);
+  EXPECT_GT(common::MeshOptimizer::Acmr(*mesh.SubMeshByIndex(2).lock()),
+      2.0);
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshOptimizer, MeshManager)
+{
+  auto *mgr = common::MeshManager::Instance();
+  EXPECT_FALSE(mgr->MeshOptimization());
+  mgr->SetMeshOptimization(true);
+  EXPECT_TRUE(mgr->MeshOptimization());
+
+  const common::Mesh *mesh =
+    mgr->Load(common::testing::TestFile("data", "box.dae"));
+  ASSERT_NE(nullptr, mesh);
+  EXPECT_EQ(36u, mesh->IndexCount());
+  mgr->SetMeshOptimization(false);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
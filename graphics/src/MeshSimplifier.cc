@@ -0,0 +1,947 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <ignition/math/Vector3.hh>
+
+#include "ignition/common/Material.hh"
+#include "ignition/common/Mesh.hh"
+#include "ignition/common/MeshSimplifier.hh"
+#include "ignition/common/Parallel.hh"
+#include "ignition/common/SubMesh.hh"
+
+using namespace ignition;
+using namespace common;
+
+/// \brief Private data for the MeshSimplifier class
+class ignition::common::MeshSimplifier::Implementation
+{
+  /// \brief Largest error of a collapse
+  public: double maxError = std::numeric_limits<double>::infinity();
+
+  /// \brief Largest error of the last simplification
+  public: double error = 0.0;
+};
+
+namespace
+{
+  /// \brief Weight of the planes that keep borders and seams in place,
+  /// relative to the planes of triangles
+  const double kBoundaryWeight = 10.0;
+
+  /// \brief How a position may move
+  enum class PositionKind
+  {
+    /// \brief Inside a surface, with the same attributes all around
+    MANIFOLD,
+
+    /// \brief On a border or a seam, which it may move along
+    OPEN,
+
+    /// \brief Where borders or seams meet, or on a non manifold edge
+    LOCKED
+  };
+
+  /// \brief How the triangles around an edge connect
+  enum class EdgeKind
+  {
+    /// \brief No triangle uses the edge
+    NONE,
+
+    /// \brief Two triangles with the same vertices at both ends
+    INTERIOR,
+
+    /// \brief One triangle, or two triangles with different vertices at
+    /// an end
+    OPEN,
+
+    /// \brief More than two triangles
+    NON_MANIFOLD
+  };
+
+  /// \brief Sum of squared distances to weighted planes, stored as the
+  /// symmetric matrix A, the vector b and the constant c of
+  /// p'Ap + 2b'p + c
+  struct Quadric
+  {
+    /// \brief Add a plane
+    /// \param[in] _n Unit normal of the plane
+    /// \param[in] _d Offset of the plane, such that _n.p + _d = 0
+    /// \param[in] _w Weight
+    void AddPlane(const math::Vector3d &_n, const double _d, const double _w)
+    {
+      this->a00 += _w * _n.X() * _n.X();
+      this->a01 += _w * _n.X() * _n.Y();
+      this->a02 += _w * _n.X() * _n.Z();
+      this->a11 += _w * _n.Y() * _n.Y();
+      this->a12 += _w * _n.Y() * _n.Z();
+      this->a22 += _w * _n.Z() * _n.Z();
+      this->b0 += _w * _d * _n.X();
+      this->b1 += _w * _d * _n.Y();
+      this->b2 += _w * _d * _n.Z();
+      this->c += _w * _d * _d;
+      this->weight += _w;
+    }
+
+    /// \brief Add another quadric
+    /// \param[in] _q Quadric to add
+    void Add(const Quadric &_q)
+    {
+      this->a00 += _q.a00;
+      this->a01 += _q.a01;
+      this->a02 += _q.a02;
+      this->a11 += _q.a11;
+      this->a12 += _q.a12;
+      this->a22 += _q.a22;
+      this->b0 += _q.b0;
+      this->b1 += _q.b1;
+      this->b2 += _q.b2;
+      this->c += _q.c;
+      this->weight += _q.weight;
+    }
+
+    /// \brief Get the root mean square distance of a point to the planes
+    /// \param[in] _p Point
+    /// \return Distance
+    double Error(const math::Vector3d &_p) const
+    {
+      const double x = _p.X();
+      const double y = _p.Y();
+      const double z = _p.Z();
+      const double sum =
+        x * (this->a00 * x + 2.0 * (this->a01 * y + this->a02 * z)) +
+        y * (this->a11 * y + 2.0 * this->a12 * z) +
+        z * this->a22 * z +
+        2.0 * (this->b0 * x + this->b1 * y + this->b2 * z) + this->c;
+      if (this->weight <= 0.0 || sum <= 0.0)
+        return 0.0;
+      return std::sqrt(sum / this->weight);
+    }
+
+    double a00 = 0.0;
+    double a01 = 0.0;
+    double a02 = 0.0;
+    double a11 = 0.0;
+    double a12 = 0.0;
+    double a22 = 0.0;
+    double b0 = 0.0;
+    double b1 = 0.0;
+    double b2 = 0.0;
+    double c = 0.0;
+    double weight = 0.0;
+  };
+
+  /// \brief Exact coordinates of a position, to weld vertices
+  struct PositionKey
+  {
+    double x;
+    double y;
+    double z;
+
+    bool operator==(const PositionKey &_other) const
+    {
+      return this->x == _other.x && this->y == _other.y &&
+        this->z == _other.z;
+    }
+  };
+
+  /// \brief Hash function for PositionKey
+  struct PositionKeyHash
+  {
+    std::size_t operator()(const PositionKey &_key) const
+    {
+      uint64_t bits[3];
+      std::memcpy(&bits[0], &_key.x, sizeof(double));
+      std::memcpy(&bits[1], &_key.y, sizeof(double));
+      std::memcpy(&bits[2], &_key.z, sizeof(double));
+      uint64_t h = bits[0] * 0x9E3779B97F4A7C15ull;
+      h = (h ^ (h >> 29) ^ bits[1]) * 0xBF58476D1CE4E5B9ull;
+      h = (h ^ (h >> 32) ^ bits[2]) * 0x94D049BB133111EBull;
+      return static_cast<std::size_t>(h ^ (h >> 31));
+    }
+  };
+
+  /// \brief Best collapse of a position, queued by error
+  struct Collapse
+  {
+    /// \brief Error of the collapse
+    double error;
+
+    /// \brief Position that moves
+    unsigned int from;
+
+    /// \brief Position it moves onto
+    unsigned int to;
+
+    /// \brief Version of the evaluation of from
+    unsigned int version;
+
+    bool operator>(const Collapse &_other) const
+    {
+      return this->error > _other.error;
+    }
+  };
+
+  /// \brief Vertex of the moving position, and the vertex of the target
+  /// position that replaces it
+  using WedgeMap = std::vector<std::pair<unsigned int, unsigned int>>;
+
+  /// \brief Simplifies one submesh. Vertices with the same coordinates
+  /// form a position; positions are what collapses move and merge, while
+  /// triangles keep referring to vertices, which carry the attributes.
+  class Simplifier
+  {
+    /// \brief Constructor
+    /// \param[in] _subMesh Indexed triangle list to simplify
+    public: explicit Simplifier(const SubMesh &_subMesh);
+
+    /// \brief Check whether the submesh can be simplified
+    /// \return True if the constructor accepted the submesh
+    public: bool Valid() const;
+
+    /// \brief Collapse edges
+    /// \param[in] _target Number of triangles to reduce to
+    /// \param[in] _maxError Largest error of a collapse
+    /// \return Largest error of the performed collapses
+    public: double Run(const std::size_t _target, const double _maxError);
+
+    /// \brief Create the simplified submesh
+    /// \return The submesh, with the vertices of the remaining triangles
+    public: std::unique_ptr<SubMesh> Output() const;
+
+    /// \brief Get the position of a corner of a triangle
+    /// \param[in] _t Triangle
+    /// \param[in] _c Corner, from 0 to 2
+    /// \return Position index
+    private: unsigned int Corner(const unsigned int _t,
+                 const unsigned int _c) const;
+
+    /// \brief Get the positions that share a live triangle with a position
+    /// \param[in] _p Position
+    /// \param[out] _out Sorted neighbors
+    private: void Neighbors(const unsigned int _p,
+                 std::vector<unsigned int> &_out) const;
+
+    /// \brief Classify an edge
+    /// \param[in] _a First position
+    /// \param[in] _b Second position
+    /// \param[out] _wedges If not null, receives the vertices at _a and
+    /// at _b of every triangle on the edge
+    /// \return Kind of the edge
+    private: EdgeKind ClassifyEdge(const unsigned int _a,
+                 const unsigned int _b, WedgeMap *_wedges) const;
+
+    /// \brief Check whether a position may collapse onto another
+    /// \param[in] _from Position that moves
+    /// \param[in] _to Position it moves onto
+    /// \param[out] _map Vertices of _from and their replacements
+    /// \return True if the collapse keeps the surface valid
+    private: bool CanCollapse(const unsigned int _from,
+                 const unsigned int _to, WedgeMap &_map) const;
+
+    /// \brief Find the best collapse of a position and queue it
+    /// \param[in] _p Position
+    private: void Evaluate(const unsigned int _p);
+
+    /// \brief Collapse a position onto another
+    /// \param[in] _from Position that moves
+    /// \param[in] _to Position it moves onto
+    /// \return False if the collapse is no longer valid
+    private: bool Apply(const unsigned int _from, const unsigned int _to);
+
+    /// \brief Submesh being simplified
+    private: const SubMesh &source;
+
+    /// \brief True if the submesh can be simplified
+    private: bool valid = false;
+
+    /// \brief Texture coordinate sets of the submesh
+    private: std::vector<unsigned int> texCoordSets;
+
+    /// \brief Position of every vertex
+    private: std::vector<unsigned int> vertexPosition;
+
+    /// \brief Coordinates of every position
+    private: std::vector<math::Vector3d> positions;
+
+    /// \brief Vertex indices of the triangles
+    private: std::vector<unsigned int> indices;
+
+    /// \brief True for triangles that were not collapsed
+    private: std::vector<bool> triangleAlive;
+
+    /// \brief Number of triangles that were not collapsed
+    private: std::size_t liveTriangles = 0u;
+
+    /// \brief Triangles of every position. May hold collapsed triangles.
+    private: std::vector<std::vector<unsigned int>> triangles;
+
+    /// \brief How every position may move
+    private: std::vector<PositionKind> kinds;
+
+    /// \brief Error quadric of every position
+    private: std::vector<Quadric> quadrics;
+
+    /// \brief True for positions that were not collapsed
+    private: std::vector<bool> positionAlive;
+
+    /// \brief Version of the last evaluation of every position
+    private: std::vector<unsigned int> versions;
+
+    /// \brief Queued collapses, smallest error first
+    private: std::priority_queue<Collapse, std::vector<Collapse>,
+                 std::greater<Collapse>> queue;
+  };
+
+  //////////////////////////////////////////////////
+  Simplifier::Simplifier(const SubMesh &_subMesh)
+    : source(_subMesh)
+  {
+    const unsigned int vertexCount = _subMesh.VertexCount();
+    const unsigned int indexCount = _subMesh.IndexCount();
+    if (_subMesh.SubMeshPrimitiveType() != SubMesh::TRIANGLES ||
+        indexCount == 0u || indexCount % 3u != 0u ||
+        (_subMesh.NormalCount() != 0u &&
+         _subMesh.NormalCount() != vertexCount))
+    {
+      return;
+    }
+
+    // Texture coordinate sets are not necessarily numbered contiguously,
+    // and empty sets carry nothing to interpolate
+    for (const unsigned int set : _subMesh.TexCoordSetIndices())
+    {
+      const unsigned int count = _subMesh.TexCoordCountBySet(set);
+      if (0u == count)
+        continue;
+      if (count != vertexCount)
+        return;
+      this->texCoordSets.push_back(set);
+    }
+
+    this->indices.assign(_subMesh.IndexData(),
+        _subMesh.IndexData() + indexCount);
+    for (const unsigned int index : this->indices)
+    {
+      if (index >= vertexCount)
+        return;
+    }
+
+    // Weld vertices with the same coordinates into positions
+    std::unordered_map<PositionKey, unsigned int, PositionKeyHash> welded;
+    welded.reserve(vertexCount);
+    this->vertexPosition.resize(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; ++v)
+    {
+      const math::Vector3d p = _subMesh.Vertex(v);
+      // Adding zero turns -0 into +0
+      const PositionKey key{p.X() + 0.0, p.Y() + 0.0, p.Z() + 0.0};
+      auto inserted = welded.emplace(key,
+          static_cast<unsigned int>(this->positions.size()));
+      if (inserted.second)
+        this->positions.push_back(p);
+      this->vertexPosition[v] = inserted.first->second;
+    }
+
+    const std::size_t positionCount = this->positions.size();
+    const std::size_t triangleCount = indexCount / 3u;
+    this->triangles.resize(positionCount);
+    for (unsigned int t = 0; t < triangleCount; ++t)
+    {
+      for (unsigned int c = 0; c < 3u; ++c)
+      {
+        auto &list = this->triangles[this->Corner(t, c)];
+        if (list.empty() || list.back() != t)
+          list.push_back(t);
+      }
+    }
+    this->triangleAlive.assign(triangleCount, true);
+    this->liveTriangles = triangleCount;
+    this->positionAlive.resize(positionCount);
+    for (std::size_t p = 0; p < positionCount; ++p)
+      this->positionAlive[p] = !this->triangles[p].empty();
+    this->versions.assign(positionCount, 0u);
+    this->valid = true;
+  }
+
+  //////////////////////////////////////////////////
+  bool Simplifier::Valid() const
+  {
+    return this->valid;
+  }
+
+  //////////////////////////////////////////////////
+  unsigned int Simplifier::Corner(const unsigned int _t,
+      const unsigned int _c) const
+  {
+    return this->vertexPosition[this->indices[_t * 3u + _c]];
+  }
+
+  //////////////////////////////////////////////////
+  void Simplifier::Neighbors(const unsigned int _p,
+      std::vector<unsigned int> &_out) const
+  {
+    _out.clear();
+    for (const unsigned int t : this->triangles[_p])
+    {
+      if (!this->triangleAlive[t])
+        continue;
+      for (unsigned int c = 0; c < 3u; ++c)
+      {
+        const unsigned int q = this->Corner(t, c);
+        if (q != _p)
+          _out.push_back(q);
+      }
+    }
+    std::sort(_out.begin(), _out.end());
+    _out.erase(std::unique(_out.begin(), _out.end()), _out.end());
+  }
+
+  //////////////////////////////////////////////////
+  EdgeKind Simplifier::ClassifyEdge(const unsigned int _a,
+      const unsigned int _b, WedgeMap *_wedges) const
+  {
+    unsigned int count = 0u;
+    unsigned int first[2] = {0u, 0u};
+    bool continuous = true;
+    if (_wedges)
+      _wedges->clear();
+    for (const unsigned int t : this->triangles[_a])
+    {
+      if (!this->triangleAlive[t])
+        continue;
+
+      int ca = -1;
+      int cb = -1;
+      for (int c = 0; c < 3; ++c)
+      {
+        const unsigned int p = this->Corner(t, c);
+        if (p == _a && ca < 0)
+          ca = c;
+        else if (p == _b && cb < 0)
+          cb = c;
+      }
+      if (ca < 0 || cb < 0)
+        continue;
+
+      const unsigned int va = this->indices[t * 3u + ca];
+      const unsigned int vb = this->indices[t * 3u + cb];
+      if (count == 0u)
+      {
+        first[0] = va;
+        first[1] = vb;
+      }
+      else if (va != first[0] || vb != first[1])
+      {
+        continuous = false;
+      }
+      if (_wedges)
+        _wedges->emplace_back(va, vb);
+      ++count;
+    }
+
+    if (count == 0u)
+      return EdgeKind::NONE;
+    if (count > 2u)
+      return EdgeKind::NON_MANIFOLD;
+    if (count == 1u || !continuous)
+      return EdgeKind::OPEN;
+    return EdgeKind::INTERIOR;
+  }
+
+  //////////////////////////////////////////////////
+  bool Simplifier::CanCollapse(const unsigned int _from,
+      const unsigned int _to, WedgeMap &_map) const
+  {
+    WedgeMap wedges;
+    const EdgeKind edge = this->ClassifyEdge(_from, _to, &wedges);
+    const PositionKind kind = this->kinds[_from];
+    if ((kind == PositionKind::MANIFOLD && edge != EdgeKind::INTERIOR) ||
+        (kind == PositionKind::OPEN && edge != EdgeKind::OPEN) ||
+        kind == PositionKind::LOCKED)
+    {
+      return false;
+    }
+
+    // Every vertex of _from is replaced by the vertex of _to that it
+    // shares a triangle with
+    _map.clear();
+    for (const auto &wedge : wedges)
+    {
+      auto it = std::find_if(_map.begin(), _map.end(),
+          [&wedge](const std::pair<unsigned int, unsigned int> &_m)
+          {
+            return _m.first == wedge.first;
+          });
+      if (it == _map.end())
+        _map.push_back(wedge);
+      else if (it->second != wedge.second)
+        return false;
+    }
+
+    // The edge must be the only connection between the two fans, or the
+    // surface pinches
+    std::vector<unsigned int> fromNeighbors;
+    std::vector<unsigned int> toNeighbors;
+    this->Neighbors(_from, fromNeighbors);
+    this->Neighbors(_to, toNeighbors);
+    std::size_t common = 0u;
+    auto a = fromNeighbors.begin();
+    auto b = toNeighbors.begin();
+    while (a != fromNeighbors.end() && b != toNeighbors.end())
+    {
+      if (*a < *b)
+      {
+        ++a;
+      }
+      else if (*b < *a)
+      {
+        ++b;
+      }
+      else
+      {
+        ++common;
+        ++a;
+        ++b;
+      }
+    }
+    if (common != wedges.size())
+      return false;
+
+    // Remaining triangles must not flip, and all their vertices at _from
+    // need a replacement
+    const math::Vector3d &target = this->positions[_to];
+    for (const unsigned int t : this->triangles[_from])
+    {
+      if (!this->triangleAlive[t])
+        continue;
+
+      math::Vector3d before[3];
+      math::Vector3d after[3];
+      bool removed = false;
+      for (unsigned int c = 0; c < 3u; ++c)
+      {
+        const unsigned int p = this->Corner(t, c);
+        removed = removed || p == _to;
+        before[c] = this->positions[p];
+        after[c] = p == _from ? target : before[c];
+        if (p == _from)
+        {
+          const unsigned int v = this->indices[t * 3u + c];
+          if (std::none_of(_map.begin(), _map.end(),
+                [v](const std::pair<unsigned int, unsigned int> &_m)
+                {
+                  return _m.first == v;
+                }))
+          {
+            return false;
+          }
+        }
+      }
+      if (removed)
+        continue;
+
+      const math::Vector3d n0 =
+        (before[1] - before[0]).Cross(before[2] - before[0]);
+      const math::Vector3d n1 =
+        (after[1] - after[0]).Cross(after[2] - after[0]);
+      if (n0 != math::Vector3d::Zero && n0.Dot(n1) <= 0.0)
+        return false;
+    }
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  void Simplifier::Evaluate(const unsigned int _p)
+  {
+    const unsigned int version = ++this->versions[_p];
+    if (!this->positionAlive[_p] || this->kinds[_p] == PositionKind::LOCKED)
+      return;
+
+    std::vector<unsigned int> neighbors;
+    this->Neighbors(_p, neighbors);
+    WedgeMap map;
+    double bestError = std::numeric_limits<double>::infinity();
+    unsigned int best = 0u;
+    for (const unsigned int q : neighbors)
+    {
+      const double error = this->quadrics[_p].Error(this->positions[q]);
+      if (error < bestError && this->CanCollapse(_p, q, map))
+      {
+        bestError = error;
+        best = q;
+      }
+    }
+
+    if (bestError < std::numeric_limits<double>::infinity())
+      this->queue.push(Collapse{bestError, _p, best, version});
+  }
+
+  //////////////////////////////////////////////////
+  bool Simplifier::Apply(const unsigned int _from, const unsigned int _to)
+  {
+    WedgeMap map;
+    if (!this->CanCollapse(_from, _to, map))
+      return false;
+
+    auto &target = this->triangles[_to];
+    for (const unsigned int t : this->triangles[_from])
+    {
+      if (!this->triangleAlive[t])
+        continue;
+
+      bool removed = false;
+      for (unsigned int c = 0; c < 3u; ++c)
+        removed = removed || this->Corner(t, c) == _to;
+      if (removed)
+      {
+        this->triangleAlive[t] = false;
+        --this->liveTriangles;
+        continue;
+      }
+
+      for (unsigned int c = 0; c < 3u; ++c)
+      {
+        unsigned int &v = this->indices[t * 3u + c];
+        if (this->vertexPosition[v] != _from)
+          continue;
+        for (const auto &m : map)
+        {
+          if (m.first == v)
+          {
+            v = m.second;
+            break;
+          }
+        }
+      }
+      target.push_back(t);
+    }
+
+    target.erase(std::remove_if(target.begin(), target.end(),
+          [this](const unsigned int _t)
+          {
+            return !this->triangleAlive[_t];
+          }), target.end());
+    std::vector<unsigned int>().swap(this->triangles[_from]);
+    this->quadrics[_to].Add(this->quadrics[_from]);
+    this->positionAlive[_from] = false;
+    ++this->versions[_from];
+
+    std::vector<unsigned int> neighbors;
+    this->Neighbors(_to, neighbors);
+    this->Evaluate(_to);
+    for (const unsigned int q : neighbors)
+      this->Evaluate(q);
+    return true;
+  }
+
+  //////////////////////////////////////////////////
+  double Simplifier::Run(const std::size_t _target, const double _maxError)
+  {
+    const std::size_t positionCount = this->positions.size();
+    const std::size_t triangleCount = this->indices.size() / 3u;
+
+    // Planes of the triangles, weighted by area
+    this->quadrics.assign(positionCount, Quadric());
+    for (unsigned int t = 0; t < triangleCount; ++t)
+    {
+      const unsigned int p[3] =
+        {this->Corner(t, 0), this->Corner(t, 1), this->Corner(t, 2)};
+      const math::Vector3d &a = this->positions[p[0]];
+      math::Vector3d n = (this->positions[p[1]] - a).Cross(
+          this->positions[p[2]] - a);
+      const double length = n.Length();
+      if (length <= 0.0)
+        continue;
+      n /= length;
+
+      // Triangles with a positive area have three distinct positions
+      for (const unsigned int corner : p)
+        this->quadrics[corner].AddPlane(n, -n.Dot(a), 0.5 * length);
+    }
+
+    // Classify positions. Open edges also get planes perpendicular to
+    // their triangles, so that borders and seams keep their shape.
+    this->kinds.assign(positionCount, PositionKind::LOCKED);
+    std::vector<unsigned int> neighbors;
+    WedgeMap wedges;
+    for (unsigned int p = 0; p < positionCount; ++p)
+    {
+      if (!this->positionAlive[p])
+        continue;
+
+      std::vector<unsigned int> vertices;
+      for (const unsigned int t : this->triangles[p])
+      {
+        for (unsigned int c = 0; c < 3u; ++c)
+        {
+          if (this->Corner(t, c) == p)
+            vertices.push_back(this->indices[t * 3u + c]);
+        }
+      }
+      std::sort(vertices.begin(), vertices.end());
+      const std::size_t wedgeCount = static_cast<std::size_t>(
+          std::unique(vertices.begin(), vertices.end()) - vertices.begin());
+
+      unsigned int open = 0u;
+      bool manifold = true;
+      this->Neighbors(p, neighbors);
+      for (const unsigned int q : neighbors)
+      {
+        const EdgeKind edge = this->ClassifyEdge(p, q, nullptr);
+        manifold = manifold && edge != EdgeKind::NON_MANIFOLD;
+        if (edge != EdgeKind::OPEN)
+          continue;
+        ++open;
+        if (q < p)
+          continue;
+
+        const math::Vector3d &a = this->positions[p];
+        const math::Vector3d e = this->positions[q] - a;
+        for (const unsigned int t : this->triangles[p])
+        {
+          const unsigned int c[3] =
+            {this->Corner(t, 0), this->Corner(t, 1), this->Corner(t, 2)};
+          if (c[0] != q && c[1] != q && c[2] != q)
+            continue;
+          const math::Vector3d normal = (this->positions[c[1]] -
+              this->positions[c[0]]).Cross(this->positions[c[2]] -
+              this->positions[c[0]]);
+          math::Vector3d side = e.Cross(normal);
+          const double length = side.Length();
+          if (length <= 0.0)
+            continue;
+          side /= length;
+          const double w = kBoundaryWeight * e.SquaredLength();
+          this->quadrics[p].AddPlane(side, -side.Dot(a), w);
+          this->quadrics[q].AddPlane(side, -side.Dot(a), w);
+        }
+      }
+
+      if (manifold && open == 0u && wedgeCount == 1u)
+        this->kinds[p] = PositionKind::MANIFOLD;
+      else if (manifold && open == 2u && wedgeCount <= 2u)
+        this->kinds[p] = PositionKind::OPEN;
+    }
+
+    for (unsigned int p = 0; p < positionCount; ++p)
+      this->Evaluate(p);
+
+    double error = 0.0;
+    while (this->liveTriangles > _target && !this->queue.empty())
+    {
+      const Collapse collapse = this->queue.top();
+      this->queue.pop();
+      if (collapse.version != this->versions[collapse.from])
+        continue;
+      if (collapse.error > _maxError)
+        break;
+      if (!this->positionAlive[collapse.to] ||
+          !this->Apply(collapse.from, collapse.to))
+      {
+        this->Evaluate(collapse.from);
+        continue;
+      }
+      error = std::max(error, collapse.error);
+    }
+    return error;
+  }
+
+  //////////////////////////////////////////////////
+  std::unique_ptr<SubMesh> Simplifier::Output() const
+  {
+    const SubMesh &src = this->source;
+    auto out = std::make_unique<SubMesh>(src.Name());
+    out->SetPrimitiveType(src.SubMeshPrimitiveType());
+    out->SetMaterialIndex(src.MaterialIndex());
+    out->SetVertexStorage(src.VertexStorageType());
+
+    // Number the remaining vertices in the order triangles first use them
+    const unsigned int unset = std::numeric_limits<unsigned int>::max();
+    std::vector<unsigned int> newIndex(src.VertexCount(), unset);
+    std::vector<unsigned int> order;
+    std::vector<unsigned int> outIndices;
+    outIndices.reserve(this->liveTriangles * 3u);
+    for (std::size_t t = 0; t < this->triangleAlive.size(); ++t)
+    {
+      if (!this->triangleAlive[t])
+        continue;
+      for (unsigned int c = 0; c < 3u; ++c)
+      {
+        const unsigned int v = this->indices[t * 3u + c];
+        if (newIndex[v] == unset)
+        {
+          newIndex[v] = static_cast<unsigned int>(order.size());
+          order.push_back(v);
+        }
+        outIndices.push_back(newIndex[v]);
+      }
+    }
+
+    const bool normals = src.NormalCount() > 0u;
+    out->Reserve(static_cast<unsigned int>(order.size()),
+        static_cast<unsigned int>(outIndices.size()));
+    for (const unsigned int v : order)
+    {
+      out->AddVertex(src.Vertex(v));
+      if (normals)
+        out->AddNormal(src.Normal(v));
+      for (const unsigned int set : this->texCoordSets)
+        out->AddTexCoordBySet(src.TexCoordBySet(v, set), set);
+    }
+    for (const unsigned int index : outIndices)
+      out->AddIndex(index);
+
+    for (unsigned int i = 0; i < src.NodeAssignmentsCount(); ++i)
+    {
+      const NodeAssignment assignment = src.NodeAssignmentByIndex(i);
+      if (assignment.vertexIndex < newIndex.size() &&
+          newIndex[assignment.vertexIndex] != unset)
+      {
+        out->AddNodeAssignment(newIndex[assignment.vertexIndex],
+            assignment.nodeIndex, assignment.weight);
+      }
+    }
+    return out;
+  }
+
+  /// \brief Simplify a submesh
+  /// \param[in] _subMesh Submesh to simplify
+  /// \param[in] _target Number of triangles to reduce to
+  /// \param[in] _maxError Largest error of a collapse
+  /// \param[out] _error Largest error of the performed collapses
+  /// \return The simplified submesh, or nullptr if it can't be simplified
+  std::unique_ptr<SubMesh> SimplifySubMesh(const SubMesh &_subMesh,
+      const std::size_t _target, const double _maxError, double &_error)
+  {
+    _error = 0.0;
+    Simplifier simplifier(_subMesh);
+    if (!simplifier.Valid())
+      return nullptr;
+    _error = simplifier.Run(_target, _maxError);
+    return simplifier.Output();
+  }
+}
+
+//////////////////////////////////////////////////
+MeshSimplifier::MeshSimplifier()
+: dataPtr(ignition::utils::MakeImpl<Implementation>())
+{
+}
+
+//////////////////////////////////////////////////
+MeshSimplifier::~MeshSimplifier()
+{
+}
+
+//////////////////////////////////////////////////
+void MeshSimplifier::SetMaxError(const double _error)
+{
+  this->dataPtr->maxError = _error;
+}
+
+//////////////////////////////////////////////////
+double MeshSimplifier::MaxError() const
+{
+  return this->dataPtr->maxError;
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<SubMesh> MeshSimplifier::Simplify(const SubMesh &_subMesh,
+    const unsigned int _targetTriangles)
+{
+  return SimplifySubMesh(_subMesh, _targetTriangles, this->dataPtr->maxError,
+      this->dataPtr->error);
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<Mesh> MeshSimplifier::Simplify(const Mesh &_mesh,
+    const double _ratio)
+{
+  auto mesh = std::make_unique<Mesh>();
+  mesh->SetName(_mesh.Name());
+  mesh->SetPath(_mesh.Path());
+  for (unsigned int i = 0; i < _mesh.MaterialCount(); ++i)
+    mesh->AddMaterial(_mesh.MaterialByIndex(i));
+  if (_mesh.HasSkeleton())
+    mesh->SetSkeleton(_mesh.MeshSkeleton());
+
+  const double ratio = std::max(0.0, std::min(1.0, _ratio));
+  const double maxError = this->dataPtr->maxError;
+  std::vector<std::unique_ptr<SubMesh>> subMeshes(_mesh.SubMeshCount());
+  std::vector<double> errors(subMeshes.size(), 0.0);
+  ParallelFor(0u, subMeshes.size(), 1u,
+      [&](const std::size_t _first, const std::size_t _last)
+      {
+        for (std::size_t i = _first; i < _last; ++i)
+        {
+          auto subMesh =
+            _mesh.SubMeshByIndex(static_cast<unsigned int>(i)).lock();
+          if (!subMesh)
+            continue;
+          const std::size_t target = static_cast<std::size_t>(
+              std::ceil(subMesh->IndexCount() / 3u * ratio));
+          subMeshes[i] =
+            SimplifySubMesh(*subMesh, target, maxError, errors[i]);
+          if (!subMeshes[i])
+            subMeshes[i] = std::make_unique<SubMesh>(*subMesh);
+        }
+      });
+
+  for (auto &subMesh : subMeshes)
+  {
+    if (subMesh)
+      mesh->AddSubMesh(std::move(subMesh));
+  }
+  this->dataPtr->error = errors.empty() ? 0.0 :
+    *std::max_element(errors.begin(), errors.end());
+  return mesh;
+}
+
+//////////////////////////////////////////////////
+std::vector<std::unique_ptr<Mesh>> MeshSimplifier::CreateLods(
+    const Mesh &_mesh, const unsigned int _levels, const double _ratio)
+{
+  std::vector<std::unique_ptr<Mesh>> lods;
+  double error = 0.0;
+  for (unsigned int level = 0; level < _levels; ++level)
+  {
+    const Mesh &previous = lods.empty() ? _mesh : *lods.back();
+    lods.push_back(this->Simplify(previous, _ratio));
+    error = std::max(error, this->dataPtr->error);
+  }
+  this->dataPtr->error = error;
+  return lods;
+}
+
+//////////////////////////////////////////////////
+double MeshSimplifier::Error() const
+{
+  return this->dataPtr->error;
+}
@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "test_config.h"
+#include "ignition/common/Material.hh"
+#include "ignition/common/Mesh.hh"
+#include "ignition/common/MeshManager.hh"
+#include "ignition/common/MeshSimplifier.hh"
+#include "ignition/common/SubMesh.hh"
+
+using namespace ignition;
+
+class MeshSimplifier : public common::testing::AutoLogFixture { };
+
+/////////////////////////////////////////////////
+/// \brief Create a flat grid with texture coordinates and a node
+/// assignment derived from the position of every vertex
+/// \param[in] _size Number of vertices along each side
+/// \return The grid, spanning [0, 1] along x and y
+std::unique_ptr<common::SubMesh> Grid(const unsigned int _size)
+{
+  auto subMesh = std::make_unique<common::SubMesh>("grid");
+  const double step = 1.0 / (_size - 1);
+  for (unsigned int y = 0; y < _size; ++y)
+  {
+    for (unsigned int x = 0; x < _size; ++x)
+    {
+      const unsigned int v = subMesh->VertexCount();
+      subMesh->AddVertex(x * step, y * step, 0);
+      subMesh->AddNormal(0, 0, 1);
+      subMesh->AddTexCoord(x * step, 1 - y * step);
+      subMesh->AddNodeAssignment(v, x % 3, 0.5f);
+    }
+  }
+  for (unsigned int y = 0; y + 1 < _size; ++y)
+  {
+    for (unsigned int x = 0; x + 1 < _size; ++x)
+    {
+      const unsigned int i = y * _size + x;
+      for (const unsigned int index : {i, i + 1, i + _size + 1,
+          i, i + _size + 1, i + _size})
+      {
+        subMesh->AddIndex(index);
+      }
+    }
+  }
+  return subMesh;
+}
+
+/////////////////////////////////////////////////
+/// \brief Sum the areas of the triangles of a submesh
+/// \param[in] _subMesh Submesh
+/// \return Area, positive for triangles facing +z
+double SignedArea(const common::SubMesh &_subMesh)
+{
+  double area = 0.0;
+  for (unsigned int t = 0; t < _subMesh.IndexCount() / 3u; ++t)
+  {
+    const math::Vector3d a = _subMesh.Vertex(_subMesh.Index(t * 3u));
+    const math::Vector3d b = _subMesh.Vertex(_subMesh.Index(t * 3u + 1u));
+    const math::Vector3d c = _subMesh.Vertex(_subMesh.Index(t * 3u + 2u));
+    area += 0.5 * (b - a).Cross(c - a).Z();
+  }
+  return area;
+}
+
+/////////////////////////////////////////////////
+/// \brief Check that every vertex of a simplified submesh is a vertex of
+/// the original submesh, with the same attributes
+/// \param[in] _original Original submesh
+/// \param[in] _simplified Simplified submesh
+void ExpectOriginalVertices(const common::SubMesh &_original,
+    const common::SubMesh &_simplified)
+{
+  for (unsigned int v = 0; v < _simplified.VertexCount(); ++v)
+  {
+    bool found = false;
+    for (unsigned int o = 0; o < _original.VertexCount() && !found; ++o)
+    {
+      found = _original.Vertex(o) == _simplified.Vertex(v) &&
+        _original.Normal(o) == _simplified.Normal(v) &&
+        (_original.TexCoordCount() == 0u ||
+         _original.TexCoord(o) == _simplified.TexCoord(v));
+    }
+    EXPECT_TRUE(found) << v;
+  }
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshSimplifier, Plane)
+{
+  auto grid = Grid(33);
+  grid->SetMaterialIndex(2);
+
+  common::MeshSimplifier simplifier;
+  EXPECT_TRUE(std::isinf(simplifier.MaxError()));
+  auto simplified = simplifier.Simplify(*grid, 100);
+  ASSERT_NE(nullptr, simplified);
+  EXPECT_EQ("grid", simplified->Name());
+  EXPECT_EQ(2u, simplified->MaterialIndex());
+  EXPECT_LE(simplified->IndexCount(), 300u);
+  EXPECT_GE(simplified->IndexCount(), 6u);
+  EXPECT_LT(simplifier.Error(), 1e-6);
+
+  // The plane keeps its outline and orientation, and vertices keep their
+  // attributes and skin weights
+  EXPECT_NEAR(1.0, SignedArea(*simplified), 1e-9);
+  EXPECT_EQ(math::Vector3d(1, 1, 0), simplified->Max());
+  EXPECT_EQ(math::Vector3d::Zero, simplified->Min());
+  ExpectOriginalVertices(*grid, *simplified);
+  ASSERT_EQ(simplified->VertexCount(), simplified->NodeAssignmentsCount());
+  for (unsigned int i = 0; i < simplified->NodeAssignmentsCount(); ++i)
+  {
+    const common::NodeAssignment assignment =
+      simplified->NodeAssignmentByIndex(i);
+    const math::Vector3d p = simplified->Vertex(assignment.vertexIndex);
+    EXPECT_EQ(static_cast<unsigned int>(std::lround(p.X() * 32)) % 3,
+        assignment.nodeIndex);
+    EXPECT_FLOAT_EQ(0.5f, assignment.weight);
+  }
+
+  // All vertices are used
+  std::vector<bool> used(simplified->VertexCount(), false);
+  for (unsigned int i = 0; i < simplified->IndexCount(); ++i)
+    used[simplified->Index(i)] = true;
+  EXPECT_EQ(used.end(), std::find(used.begin(), used.end(), false));
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshSimplifier, Sphere)
+{
+  auto *mgr = common::MeshManager::Instance();
+  mgr->CreateSphere("simplifier_sphere", 1.0f, 32, 32);
+  const common::Mesh *sphere = mgr->MeshByName("simplifier_sphere");
+  ASSERT_NE(nullptr, sphere);
+  auto original = sphere->SubMeshByIndex(0).lock();
+  const unsigned int triangles = original->IndexCount() / 3u;
+
+  // Without an error bound the target is reached
+  common::MeshSimplifier simplifier;
+  auto coarse = simplifier.Simplify(*original, triangles / 10u);
+  ASSERT_NE(nullptr, coarse);
+  EXPECT_LE(coarse->IndexCount() / 3u, triangles / 10u);
+  const double coarseError = simplifier.Error();
+  EXPECT_GT(coarseError, 0.0);
+
+  // With an error bound, simplification stops early
+  simplifier.SetMaxError(coarseError / 4.0);
+  EXPECT_DOUBLE_EQ(coarseError / 4.0, simplifier.MaxError());
+  auto fine = simplifier.Simplify(*original, triangles / 10u);
+  ASSERT_NE(nullptr, fine);
+  EXPECT_GT(fine->IndexCount(), coarse->IndexCount());
+  EXPECT_LT(fine->IndexCount(), original->IndexCount());
+  EXPECT_LE(simplifier.Error(), coarseError / 4.0);
+
+  // Vertices stay on the sphere with their normals and texture
+  // coordinates, including those along the texture seam
+  ExpectOriginalVertices(*original, *coarse);
+  ExpectOriginalVertices(*original, *fine);
+  for (unsigned int v = 0; v < coarse->VertexCount(); ++v)
+    EXPECT_NEAR(1.0, coarse->Vertex(v).Length(), 1e-6);
+
+  // Triangles keep facing outwards. The poles of the sphere are made of
+  // degenerate triangles, which may stay degenerate.
+  for (unsigned int t = 0; t < coarse->IndexCount() / 3u; ++t)
+  {
+    const math::Vector3d a = coarse->Vertex(coarse->Index(t * 3u));
+    const math::Vector3d b = coarse->Vertex(coarse->Index(t * 3u + 1u));
+    const math::Vector3d c = coarse->Vertex(coarse->Index(t * 3u + 2u));
+    EXPECT_GT((b - a).Cross(c - a).Dot(a + b + c), -1e-6) << t;
+  }
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshSimplifier, Unsupported)
+{
+  common::MeshSimplifier simplifier;
+  auto lines = Grid(4);
+  lines->SetPrimitiveType(common::SubMesh::LINES);
+  EXPECT_EQ(nullptr, simplifier.Simplify(*lines, 1u));
+
+  auto invalid = Grid(4);
+  invalid->SetIndex(0, 100);
+  EXPECT_EQ(nullptr, simplifier.Simplify(*invalid, 1u));
+
+  auto normals = Grid(4);
+  normals->AddNormal(0, 0, 1);
+  EXPECT_EQ(nullptr, simplifier.Simplify(*normals, 1u));
+
+  EXPECT_EQ(nullptr, simplifier.Simplify(common::SubMesh(), 1u));
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshSimplifier, EmptyTexCoordSet)
+{
+  // Set 1 is created empty, before any vertex is added
+  auto grid = Grid(9);
+  common::SubMesh subMesh("grid");
+  subMesh.GenSphericalTexCoordBySet(math::Vector3d::Zero, 1u);
+  for (unsigned int v = 0; v < grid->VertexCount(); ++v)
+  {
+    subMesh.AddVertex(grid->Vertex(v));
+    subMesh.AddNormal(grid->Normal(v));
+    subMesh.AddTexCoord(grid->TexCoord(v));
+  }
+  for (unsigned int i = 0; i < grid->IndexCount(); ++i)
+    subMesh.AddIndex(grid->Index(i));
+  ASSERT_EQ(2u, subMesh.TexCoordSetCount());
+  EXPECT_EQ(0u, subMesh.TexCoordCountBySet(1u));
+
+  common::MeshSimplifier simplifier;
+  auto simplified = simplifier.Simplify(subMesh, 16u);
+  ASSERT_NE(nullptr, simplified);
+  EXPECT_LE(simplified->IndexCount(), 48u);
+  EXPECT_NEAR(1.0, SignedArea(*simplified), 1e-9);
+  EXPECT_EQ(simplified->VertexCount(), simplified->TexCoordCountBySet(0u));
+  ExpectOriginalVertices(subMesh, *simplified);
+}
+
+/////////////////////////////////////////////////
+TEST_F(MeshSimplifier, Lods)
+{
+  common::Mesh mesh;
+  mesh.SetName("lod_grid");
+  mesh.AddMaterial(std::make_shared<common::Material>());
+  mesh.AddSubMesh(Grid(33));
+  mesh.AddSubMesh(Grid(17));
+  auto lines = Grid(4);
+  lines->SetPrimitiveType(common::SubMesh::LINES);
+  mesh.AddSubMesh(std::move(lines));
+
+  common::MeshSimplifier simplifier;
+  auto lods = simplifier.CreateLods(mesh, 3u);
+  ASSERT_EQ(3u, lods.size());
+  unsigned int previous = mesh.SubMeshByIndex(0).lock()->IndexCount();
+  for (const auto &lod : lods)
+  {
+    EXPECT_EQ("lod_grid", lod->Name());
+    ASSERT_EQ(3u, lod->SubMeshCount());
+    ASSERT_EQ(1u, lod->MaterialCount());
+    EXPECT_EQ(mesh.MaterialByIndex(0), lod->MaterialByIndex(0));
+
+    auto grid = lod->SubMeshByIndex(0).lock();
+    EXPECT_LE(grid->IndexCount(), (previous / 3u + 1u) / 2u * 3u);
+    previous = grid->IndexCount();
+    EXPECT_NEAR(1.0, SignedArea(*grid), 1e-9);
+    EXPECT_NEAR(1.0, SignedArea(*lod->SubMeshByIndex(1).lock()), 1e-9);
+
+    // Submeshes that can't be simplified are copied
+    EXPECT_EQ(mesh.SubMeshByIndex(2).lock()->IndexCount(),
+        lod->SubMeshByIndex(2).lock()->IndexCount());
+  }
+
+  // Levels of detail cached by the mesh manager
+  auto *mgr = common::MeshManager::Instance();
+  EXPECT_FALSE(mgr->CreateLods("simplifier_missing", 2u));
+  mgr->CreateBox("simplifier_box", math::Vector3d::One, math::Vector2d::One);
+  const common::Mesh *box = mgr->MeshByName("simplifier_box");
+  ASSERT_NE(nullptr, box);
+  EXPECT_EQ(box, mgr->MeshLod("simplifier_box", 0u));
+  EXPECT_EQ(nullptr, mgr->MeshLod("simplifier_box", 1u));
+  EXPECT_TRUE(mgr->CreateLods("simplifier_box", 2u));
+  const common::Mesh *lod1 = mgr->MeshLod("simplifier_box", 1u);
+  const common::Mesh *lod2 = mgr->MeshLod("simplifier_box", 2u);
+  ASSERT_NE(nullptr, lod1);
+  ASSERT_NE(nullptr, lod2);
+  EXPECT_EQ(lod1, mgr->MeshByName("simplifier_box::lod1"));
+  EXPECT_EQ("simplifier_box::lod2", lod2->Name());
+  EXPECT_LE(lod1->IndexCount(), box->IndexCount());
+  EXPECT_EQ(nullptr, mgr->MeshLod("simplifier_box", 3u));
+
+  // Existing levels are kept
+  EXPECT_TRUE(mgr->CreateLods("simplifier_box", 2u));
+  EXPECT_EQ(lod1, mgr->MeshLod("simplifier_box", 1u));
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -17,6 +17,10 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 #include "test_config.h"
 #include "ignition/common/Material.hh"
 #include "ignition/common/Mesh.hh"
@@ -152,6 +156,61 @@ TEST_F(MeshTest, Mesh)
   EXPECT_EQ(indices[0], submesh.lock()->Index(0));
 }
 
+/////////////////////////////////////////////////
+TEST_F(MeshTest, FillBuffers)
+{
+  common::Mesh mesh;
+  for (unsigned int s = 0; s < 2u; ++s)
+  {
+    auto submesh = std::make_unique<common::SubMesh>();
+    submesh->AddVertex(s, 0, 0);
+    submesh->AddVertex(s, 1, 0);
+    submesh->AddVertex(s, 0, 1);
+    for (const unsigned int i : {0u, 1u, 2u})
+      submesh->AddIndex(i);
+    mesh.AddSubMesh(std::move(submesh));
+  }
+  ASSERT_EQ(6u, mesh.VertexCount());
+  ASSERT_EQ(6u, mesh.IndexCount());
+
+  // Indices of the second submesh refer to the concatenated positions
+  std::vector<double> vertices(mesh.VertexCount() * 3);
+  std::vector<uint32_t> indices(mesh.IndexCount());
+  EXPECT_TRUE(mesh.FillBuffers(vertices.data(), indices.data()));
+  EXPECT_EQ((std::vector<uint32_t>{0u, 1u, 2u, 3u, 4u, 5u}), indices);
+  for (unsigned int i = 0; i < mesh.IndexCount(); ++i)
+  {
+    const auto submesh = mesh.SubMeshByIndex(i / 3).lock();
+    const math::Vector3d v = submesh->Vertex(submesh->Index(i % 3));
+    EXPECT_DOUBLE_EQ(v.X(), vertices[indices[i] * 3]);
+    EXPECT_DOUBLE_EQ(v.Y(), vertices[indices[i] * 3 + 1]);
+    EXPECT_DOUBLE_EQ(v.Z(), vertices[indices[i] * 3 + 2]);
+  }
+
+  std::vector<float> floats(mesh.VertexCount() * 3);
+  std::vector<uint16_t> shortIndices(mesh.IndexCount());
+  EXPECT_TRUE(mesh.FillBuffers(floats.data(), shortIndices.data()));
+  EXPECT_EQ((std::vector<uint16_t>{0u, 1u, 2u, 3u, 4u, 5u}), shortIndices);
+  EXPECT_FLOAT_EQ(1.0f, floats[9]);
+
+  // Either buffer may be skipped
+  EXPECT_TRUE(mesh.FillBuffers(static_cast<float *>(nullptr),
+      indices.data()));
+  EXPECT_TRUE(mesh.FillBuffers(vertices.data(),
+      static_cast<uint16_t *>(nullptr)));
+
+  // Too many vertices for 16 bit indices
+  auto large = std::make_unique<common::SubMesh>();
+  for (unsigned int i = 0; i < 65536u; ++i)
+    large->AddVertex(i, 0, 0);
+  large->AddIndex(65535u);
+  mesh.AddSubMesh(std::move(large));
+  shortIndices.assign(mesh.IndexCount(), 7u);
+  EXPECT_FALSE(mesh.FillBuffers(static_cast<float *>(nullptr),
+      shortIndices.data()));
+  EXPECT_EQ(std::vector<uint16_t>(mesh.IndexCount(), 7u), shortIndices);
+}
+
 /////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
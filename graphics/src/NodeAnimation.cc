@@ -115,6 +115,12 @@ std::pair<double, math::Matrix4d> NodeAnimation::KeyFrame(
   return std::make_pair(t, mat);
 }
 
+//////////////////////////////////////////////////
+const std::map<double, math::Matrix4d> &NodeAnimation::KeyFrames() const
+{
+  return this->dataPtr->keyFrames;
+}
+
 //////////////////////////////////////////////////
 double NodeAnimation::Length() const
 {
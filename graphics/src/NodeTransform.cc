@@ -133,6 +133,12 @@ void NodeTransform::SetSourceValues(const math::Vector3d &_axis,
   this->dataPtr->source[3] = _angle;
 }
 
+//////////////////////////////////////////////////
+std::vector<double> NodeTransform::SourceValues() const
+{
+  return this->dataPtr->source;
+}
+
 //////////////////////////////////////////////////
 void NodeTransform::RecalculateMatrix()
 {
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <cstdint>
+
+#include "NumberParser.hh"
+
+using namespace ignition;
+using namespace common;
+
+namespace
+{
+  /// \brief Powers of ten that are exact doubles
+  const double kPow10[] =
+  {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  /// \brief Check for a decimal digit
+  /// \param[in] _c Character
+  /// \return True if _c is a digit
+  bool IsDigit(const char _c)
+  {
+    return static_cast<unsigned int>(_c - '0') < 10u;
+  }
+}
+
+//////////////////////////////////////////////////
+bool common::ParseDecimal(const char *_begin, const char *_end,
+    double &_value)
+{
+  const char *p = _begin;
+  const bool negative = p < _end && *p == '-';
+  if (p < _end && (*p == '+' || *p == '-'))
+    ++p;
+
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  const char *integer = p;
+  for (; p < _end && IsDigit(*p); ++p, ++digits)
+    mantissa = mantissa * 10u + static_cast<uint64_t>(*p - '0');
+  if (p == integer)
+    return false;
+
+  if (p < _end && *p == '.')
+  {
+    for (++p; p < _end && IsDigit(*p); ++p, ++digits, --exponent)
+      mantissa = mantissa * 10u + static_cast<uint64_t>(*p - '0');
+  }
+
+  if (p < _end && (*p == 'e' || *p == 'E'))
+  {
+    ++p;
+    const bool negativeExponent = p < _end && *p == '-';
+    if (p < _end && (*p == '+' || *p == '-'))
+      ++p;
+    int value = 0;
+    const char *start = p;
+    for (; p < _end && IsDigit(*p) && value < 1000; ++p)
+      value = value * 10 + (*p - '0');
+    if (p == start)
+      return false;
+    exponent += negativeExponent ? -value : value;
+  }
+
+  if (p != _end || digits > 19 || mantissa > (uint64_t(1) << 53) ||
+      exponent < -22 || exponent > 22)
+  {
+    return false;
+  }
+
+  double value = static_cast<double>(mantissa);
+  value = exponent < 0 ? value / kPow10[-exponent] : value * kPow10[exponent];
+  _value = negative ? -value : value;
+  return true;
+}
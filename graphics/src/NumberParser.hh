@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef IGNITION_COMMON_NUMBERPARSER_HH_
+#define IGNITION_COMMON_NUMBERPARSER_HH_
+
+namespace ignition
+{
+  namespace common
+  {
+    /// \brief Convert a decimal number exactly, without depending on the
+    /// locale. Only numbers that can be converted with a single rounding
+    /// are handled: an optional sign, digits with an optional fraction, and
+    /// an optional exponent, with at most 19 significant digits, a
+    /// mantissa up to 2^53 and a decimal exponent between -22 and 22.
+    /// Mesh files almost only contain such numbers, and callers parse the
+    /// others with a general parser.
+    /// \param[in] _begin Start of the text
+    /// \param[in] _end End of the text
+    /// \param[out] _value The number
+    /// \return False if the whole text is not a number of the supported
+    /// form. _value is not changed in that case.
+    bool ParseDecimal(const char *_begin, const char *_end, double &_value);
+  }
+}
+
+#endif
@@ -15,18 +15,26 @@
  *
  */
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <utility>
 
 #include "ignition/common/Console.hh"
 #include "ignition/common/Filesystem.hh"
 #include "ignition/common/Material.hh"
 #include "ignition/common/Mesh.hh"
+#include "ignition/common/Parallel.hh"
 #include "ignition/common/SubMesh.hh"
 #include "ignition/common/OBJLoader.hh"
 
 #define IGNITION_COMMON_TINYOBJLOADER_IMPLEMENTATION
 #include "tiny_obj_loader.h"
 
+#include "MappedFile.hh"
+#include "NumberParser.hh"
+
 namespace ignition
 {
   namespace common
@@ -42,6 +50,658 @@ namespace ignition
 using namespace ignition;
 using namespace common;
 
+namespace
+{
+  /// \brief Size of the pieces of a file that are parsed in parallel
+  const std::size_t kChunkSize = 4u << 20;
+
+  /// \brief Check for a space or a tab
+  /// \param[in] _c Character
+  /// \return True if _c separates tokens
+  bool IsSpace(const char _c)
+  {
+    return _c == ' ' || _c == '\t';
+  }
+
+  /// \brief Check for a decimal digit
+  /// \param[in] _c Character
+  /// \return True if _c is a digit
+  bool IsDigit(const char _c)
+  {
+    return static_cast<unsigned int>(_c - '0') < 10u;
+  }
+
+  /// \brief Skip spaces and tabs
+  /// \param[in] _p Start of the text
+  /// \param[in] _end End of the line
+  /// \return First other character, or _end
+  const char *SkipSpaces(const char *_p, const char *_end)
+  {
+    while (_p < _end && IsSpace(*_p))
+      ++_p;
+    return _p;
+  }
+
+  /// \brief Find the end of a token
+  /// \param[in] _p Start of the token
+  /// \param[in] _end End of the line
+  /// \param[in] _slash True to also end the token at a slash
+  /// \return First space, tab or slash after _p, or _end
+  const char *TokenEnd(const char *_p, const char *_end, const bool _slash)
+  {
+    while (_p < _end && !IsSpace(*_p) && !(_slash && *_p == '/'))
+      ++_p;
+    return _p;
+  }
+
+  /// \brief Parse an integer the way atoi does
+  /// \param[in] _p Start of the text
+  /// \param[in] _end End of the line
+  /// \return The integer, or 0 if there is none
+  int ParseInt(const char *_p, const char *_end)
+  {
+    while (_p < _end && (IsSpace(*_p) || *_p == '\v' || *_p == '\f'))
+      ++_p;
+    bool negative = false;
+    if (_p < _end && (*_p == '+' || *_p == '-'))
+      negative = *_p++ == '-';
+    int64_t value = 0;
+    for (; _p < _end && IsDigit(*_p) && value <= INT32_MAX; ++_p)
+      value = value * 10 + (*_p - '0');
+    return static_cast<int>(negative ? -value : value);
+  }
+
+  /// \brief Parse a number without depending on the locale. Numbers that
+  /// ParseDecimal does not handle are parsed by tinyobj, which also defines
+  /// which texts are numbers.
+  /// \param[in] _begin Start of the number
+  /// \param[in] _end End of the number
+  /// \param[out] _value The number
+  /// \return False if the text is not a number
+  bool ParseDouble(const char *_begin, const char *_end, double &_value)
+  {
+    return ParseDecimal(_begin, _end, _value) ||
+        tinyobj::tryParseDouble(_begin, _end, &_value);
+  }
+
+  /// \brief Parse the next number of a line, like tinyobj's parseReal
+  /// \param[in, out] _p Position in the line, moved past the number
+  /// \param[in] _end End of the line
+  /// \return The number, or 0 if there is none
+  tinyobj::real_t ParseReal(const char *&_p, const char *_end)
+  {
+    _p = SkipSpaces(_p, _end);
+    const char *end = TokenEnd(_p, _end, false);
+    double value = 0.0;
+    if (!ParseDouble(_p, end, value))
+      value = 0.0;
+    _p = end;
+    return static_cast<tinyobj::real_t>(value);
+  }
+
+  /// \brief A line of an OBJ file that changes how faces are grouped into
+  /// shapes, or which material they use
+  class ObjStatement
+  {
+    /// \brief Number of faces of the chunk before the line
+    public: std::size_t face;
+
+    /// \brief Line number within the chunk, starting at 1
+    public: std::size_t line;
+
+    /// \brief Text of the line, without leading spaces
+    public: std::string text;
+  };
+
+  /// \brief Content of a piece of an OBJ file that starts and ends at line
+  /// boundaries. Face indices refer to the whole file, except for negative
+  /// indices in the file which are resolved relative to the chunk until the
+  /// chunks are merged.
+  class ObjChunk
+  {
+    /// \brief Parse the lines of the chunk
+    /// \param[in] _begin Start of the chunk
+    /// \param[in] _end End of the chunk
+    public: void Parse(const char *_begin, const char *_end)
+    {
+      for (const char *line = _begin; line < _end && this->supported;)
+      {
+        const char *next = static_cast<const char *>(
+            memchr(line, '\n', static_cast<std::size_t>(_end - line)));
+        const char *end = next ? next : _end;
+        ++this->lines;
+        if (end > line && end[-1] == '\r')
+          --end;
+
+        // tinyobj also ends lines at a lone carriage return
+        if (std::find(line, end, '\r') != end)
+          this->supported = false;
+        else
+          this->ParseLine(SkipSpaces(line, end), end);
+
+        line = next ? next + 1 : _end;
+      }
+    }
+
+    /// \brief Parse a line
+    /// \param[in] _p First character that is not a space
+    /// \param[in] _end End of the line
+    private: void ParseLine(const char *_p, const char *_end)
+    {
+      auto at = [&](const std::size_t _i)
+      {
+        return _p + _i < _end ? _p[_i] : '\0';
+      };
+
+      if (at(0) == 'v' && IsSpace(at(1)))
+      {
+        _p += 2;
+        for (int i = 0; i < 3; ++i)
+          this->vertices.push_back(ParseReal(_p, _end));
+      }
+      else if (at(0) == 'v' && at(1) == 'n' && IsSpace(at(2)))
+      {
+        _p += 3;
+        for (int i = 0; i < 3; ++i)
+          this->normals.push_back(ParseReal(_p, _end));
+      }
+      else if (at(0) == 'v' && at(1) == 't' && IsSpace(at(2)))
+      {
+        _p += 3;
+        for (int i = 0; i < 2; ++i)
+          this->texcoords.push_back(ParseReal(_p, _end));
+      }
+      else if (at(0) == 'f' && IsSpace(at(1)))
+      {
+        this->faceStarts.push_back(this->indices.size());
+        for (_p = SkipSpaces(_p + 2, _end); _p < _end && this->supported;
+            _p = SkipSpaces(_p, _end))
+        {
+          this->supported = this->ParseCorner(_p, _end);
+        }
+      }
+      else if (at(0) == 'l' && IsSpace(at(1)))
+      {
+        // Lines change how tinyobj groups faces into shapes
+        this->supported = false;
+      }
+      else if (((at(0) == 'g' || at(0) == 'o') && IsSpace(at(1))) ||
+          (_end - _p > 6 && IsSpace(at(6)) &&
+           (0 == strncmp(_p, "usemtl", 6) || 0 == strncmp(_p, "mtllib", 6))))
+      {
+        this->statements.push_back(ObjStatement{this->faceStarts.size(),
+            this->lines, std::string(_p, _end)});
+      }
+    }
+
+    /// \brief Parse a face corner, like tinyobj's parseTriple
+    /// \param[in, out] _p Position in the line, moved past the corner
+    /// \param[in] _end End of the line
+    /// \return False if an index is zero
+    private: bool ParseCorner(const char *&_p, const char *_end)
+    {
+      tinyobj::index_t corner;
+      corner.vertex_index = -1;
+      corner.normal_index = -1;
+      corner.texcoord_index = -1;
+
+      if (!this->FixIndex(ParseInt(_p, _end), 0, corner.vertex_index))
+        return false;
+      _p = TokenEnd(_p, _end, true);
+
+      if (_p < _end && *_p == '/')
+      {
+        ++_p;
+        if (_p < _end && *_p == '/')
+        {
+          ++_p;
+          if (!this->FixIndex(ParseInt(_p, _end), 2, corner.normal_index))
+            return false;
+          _p = TokenEnd(_p, _end, true);
+        }
+        else
+        {
+          if (!this->FixIndex(ParseInt(_p, _end), 1, corner.texcoord_index))
+            return false;
+          _p = TokenEnd(_p, _end, true);
+          if (_p < _end && *_p == '/')
+          {
+            ++_p;
+            if (!this->FixIndex(ParseInt(_p, _end), 2, corner.normal_index))
+              return false;
+            _p = TokenEnd(_p, _end, true);
+          }
+        }
+      }
+
+      this->indices.push_back(corner);
+      return true;
+    }
+
+    /// \brief Make an index zero based, like tinyobj's fixIndex
+    /// \param[in] _index Index in the file
+    /// \param[in] _component 0 for positions, 1 for texture coordinates and
+    /// 2 for normals
+    /// \param[out] _fixed Zero based index
+    /// \return False if _index is zero
+    private: bool FixIndex(const int _index, const int _component,
+                 int &_fixed)
+    {
+      if (_index > 0)
+      {
+        _fixed = _index - 1;
+        return true;
+      }
+      if (_index == 0)
+        return false;
+
+      const std::size_t count = _component == 0 ? this->vertices.size() / 3 :
+        _component == 1 ? this->texcoords.size() / 2 : this->normals.size() / 3;
+      _fixed = static_cast<int>(count) + _index;
+      this->relative.push_back(this->indices.size() * 3 + _component);
+      return true;
+    }
+
+    /// \brief Positions
+    public: std::vector<tinyobj::real_t> vertices;
+
+    /// \brief Normals
+    public: std::vector<tinyobj::real_t> normals;
+
+    /// \brief Texture coordinates
+    public: std::vector<tinyobj::real_t> texcoords;
+
+    /// \brief Corners of all the faces, -1 for missing attributes
+    public: std::vector<tinyobj::index_t> indices;
+
+    /// \brief Position in indices of the first corner of every face
+    public: std::vector<std::size_t> faceStarts;
+
+    /// \brief Corner index * 3 + component of the indices that are
+    /// relative to the start of the chunk
+    public: std::vector<std::size_t> relative;
+
+    /// \brief Lines that group faces
+    public: std::vector<ObjStatement> statements;
+
+    /// \brief Number of lines
+    public: std::size_t lines = 0;
+
+    /// \brief False if the chunk uses a feature that only tinyobj handles
+    public: bool supported = true;
+  };
+
+  /// \brief Add faces to a shape, like tinyobj's exportGroupsToShape with
+  /// triangulation enabled
+  /// \param[in, out] _shape Shape to add the faces to
+  /// \param[in] _indices Corners of all the faces
+  /// \param[in] _faceStarts First corner of every face, followed by the
+  /// number of corners
+  /// \param[in] _begin First face to add
+  /// \param[in] _end One past the last face to add
+  /// \param[in] _material Material of the faces
+  /// \param[in] _name Name of the shape
+  /// \param[in] _vertices All the positions
+  /// \return False if there are no faces to add
+  bool ExportFaces(tinyobj::shape_t &_shape,
+      const std::vector<tinyobj::index_t> &_indices,
+      const std::vector<std::size_t> &_faceStarts,
+      const std::size_t _begin, const std::size_t _end, const int _material,
+      const std::string &_name, const std::vector<tinyobj::real_t> &_vertices)
+  {
+    if (_begin == _end)
+      return false;
+
+    tinyobj::mesh_t &mesh = _shape.mesh;
+    std::vector<int> lines;
+    std::vector<tinyobj::tag_t> tags;
+    for (std::size_t f = _begin; f < _end; ++f)
+    {
+      const std::size_t first = _faceStarts[f];
+      const std::size_t count = _faceStarts[f + 1] - first;
+      if (count == 3u)
+      {
+        mesh.indices.insert(mesh.indices.end(), _indices.begin() + first,
+            _indices.begin() + first + 3);
+        mesh.num_face_vertices.push_back(3);
+        mesh.material_ids.push_back(_material);
+        mesh.smoothing_group_ids.push_back(0);
+      }
+      else if (count > 3u)
+      {
+        // Polygons are triangulated by tinyobj itself
+        std::vector<tinyobj::face_t> polygon(1);
+        for (std::size_t i = first; i < first + count; ++i)
+        {
+          polygon[0].vertex_indices.push_back(tinyobj::vertex_index_t(
+              _indices[i].vertex_index, _indices[i].texcoord_index,
+              _indices[i].normal_index));
+        }
+        tinyobj::exportGroupsToShape(&_shape, polygon, lines, tags,
+            _material, _name, true, _vertices);
+      }
+    }
+    _shape.name = _name;
+    return true;
+  }
+
+  /// \brief Add the faces of a shape that use a material to a submesh
+  /// \param[in] _attrib Vertex attributes
+  /// \param[in] _mesh Faces of the shape
+  /// \param[in] _matId Material of the faces to add
+  /// \param[in, out] _subMesh Submesh to fill
+  void FillSubMesh(const tinyobj::attrib_t &_attrib,
+      const tinyobj::mesh_t &_mesh, const int _matId, SubMesh &_subMesh)
+  {
+    unsigned int count = 0;
+    for (unsigned int f = 0; f < _mesh.num_face_vertices.size(); ++f)
+    {
+      if (_mesh.material_ids[f] == _matId)
+        count += _mesh.num_face_vertices[f];
+    }
+    _subMesh.Reserve(count, count);
+
+    unsigned int indexOffset = 0;
+    // For each face
+    for (unsigned int f = 0; f < _mesh.num_face_vertices.size(); ++f)
+    {
+      unsigned int fnum = _mesh.num_face_vertices[f];
+      if (_mesh.material_ids[f] != _matId)
+      {
+        indexOffset += fnum;
+        continue;
+      }
+
+      // For each vertex in the face
+      for (unsigned int v = 0; v < fnum; ++v)
+      {
+        auto i = _mesh.indices[indexOffset + v];
+
+        // vertices
+        int vIdx = i.vertex_index;
+        ignition::math::Vector3d vertex(_attrib.vertices[3 * vIdx],
+                                        _attrib.vertices[3 * vIdx + 1],
+                                        _attrib.vertices[3 * vIdx + 2]);
+        _subMesh.AddVertex(vertex);
+
+        // normals
+        if (_attrib.normals.size() > 0)
+        {
+          int nIdx = i.normal_index;
+          ignition::math::Vector3d normal(_attrib.normals[3 * nIdx],
+                                          _attrib.normals[3 * nIdx + 1],
+                                          _attrib.normals[3 * nIdx + 2]);
+          _subMesh.AddNormal(normal);
+        }
+        // texcoords
+        if (_attrib.texcoords.size() > 0)
+        {
+          int tIdx = i.texcoord_index;
+          ignition::math::Vector2d uv(_attrib.texcoords[2 * tIdx],
+                                      _attrib.texcoords[2 * tIdx + 1]);
+          _subMesh.AddTexCoord(uv.X(), 1.0-uv.Y());
+        }
+        _subMesh.AddIndex(_subMesh.IndexCount());
+      }
+      indexOffset += fnum;
+    }
+  }
+
+  /// \brief Parse an OBJ file with several threads. The result is the same
+  /// as the one of tinyobj::LoadObj with triangulation, except for vertex
+  /// colors which are not read.
+  /// \param[in] _filename Path of the file
+  /// \param[in] _path Directory of the material files
+  /// \param[out] _attrib Vertex attributes
+  /// \param[out] _shapes Shapes
+  /// \param[out] _materials Materials
+  /// \param[out] _warn Warnings
+  /// \param[out] _err Errors
+  /// \return False if the file can't be read or uses features that are only
+  /// supported by tinyobj::LoadObj
+  bool ParallelLoadObj(const std::string &_filename, const std::string &_path,
+      tinyobj::attrib_t &_attrib, std::vector<tinyobj::shape_t> &_shapes,
+      std::vector<tinyobj::material_t> &_materials, std::string &_warn,
+      std::string &_err)
+  {
+    MappedFile file(_filename);
+    if (!file.Valid())
+      return false;
+
+    // Split the file at line boundaries
+    const char *data = file.Data();
+    const char *dataEnd = data + file.Size();
+    std::vector<const char *> bounds = {data};
+    while (dataEnd - bounds.back() > static_cast<std::ptrdiff_t>(kChunkSize))
+    {
+      const char *split = bounds.back() + kChunkSize;
+      const char *newline = static_cast<const char *>(
+          memchr(split, '\n', static_cast<std::size_t>(dataEnd - split)));
+      if (!newline || newline + 1 == dataEnd)
+        break;
+      bounds.push_back(newline + 1);
+    }
+    bounds.push_back(dataEnd);
+
+    std::vector<ObjChunk> chunks(bounds.size() - 1);
+    ParallelFor(0u, chunks.size(), 1u,
+        [&](const std::size_t _first, const std::size_t _last)
+        {
+          for (std::size_t c = _first; c < _last; ++c)
+            chunks[c].Parse(bounds[c], bounds[c + 1]);
+        });
+
+    // Offsets of every chunk in the merged arrays
+    std::vector<std::size_t> vertexOffsets(chunks.size() + 1, 0u);
+    std::vector<std::size_t> normalOffsets(chunks.size() + 1, 0u);
+    std::vector<std::size_t> texcoordOffsets(chunks.size() + 1, 0u);
+    std::vector<std::size_t> indexOffsets(chunks.size() + 1, 0u);
+    std::vector<std::size_t> faceOffsets(chunks.size() + 1, 0u);
+    std::size_t lines = 0;
+    for (std::size_t c = 0; c < chunks.size(); ++c)
+    {
+      if (!chunks[c].supported)
+        return false;
+      vertexOffsets[c + 1] = vertexOffsets[c] + chunks[c].vertices.size();
+      normalOffsets[c + 1] = normalOffsets[c] + chunks[c].normals.size();
+      texcoordOffsets[c + 1] =
+        texcoordOffsets[c] + chunks[c].texcoords.size();
+      indexOffsets[c + 1] = indexOffsets[c] + chunks[c].indices.size();
+      faceOffsets[c + 1] = faceOffsets[c] + chunks[c].faceStarts.size();
+      lines += chunks[c].lines;
+    }
+
+    // Merge the chunks
+    _attrib.vertices.resize(vertexOffsets.back());
+    _attrib.normals.resize(normalOffsets.back());
+    _attrib.texcoords.resize(texcoordOffsets.back());
+    std::vector<tinyobj::index_t> indices(indexOffsets.back());
+    std::vector<std::size_t> faceStarts(faceOffsets.back() + 1);
+    faceStarts.back() = indices.size();
+    std::vector<int> greatest(chunks.size() * 3, -1);
+    ParallelFor(0u, chunks.size(), 1u,
+        [&](const std::size_t _first, const std::size_t _last)
+        {
+          for (std::size_t c = _first; c < _last; ++c)
+          {
+            ObjChunk &chunk = chunks[c];
+            for (const std::size_t r : chunk.relative)
+            {
+              tinyobj::index_t &corner = chunk.indices[r / 3];
+              if (r % 3 == 0)
+                corner.vertex_index += static_cast<int>(vertexOffsets[c] / 3);
+              else if (r % 3 == 1)
+                corner.texcoord_index +=
+                  static_cast<int>(texcoordOffsets[c] / 2);
+              else
+                corner.normal_index += static_cast<int>(normalOffsets[c] / 3);
+            }
+
+            int *chunkGreatest = &greatest[c * 3];
+            for (const tinyobj::index_t &corner : chunk.indices)
+            {
+              chunkGreatest[0] =
+                std::max(chunkGreatest[0], corner.vertex_index);
+              chunkGreatest[1] =
+                std::max(chunkGreatest[1], corner.normal_index);
+              chunkGreatest[2] =
+                std::max(chunkGreatest[2], corner.texcoord_index);
+            }
+
+            std::copy(chunk.vertices.begin(), chunk.vertices.end(),
+                _attrib.vertices.begin() + vertexOffsets[c]);
+            std::copy(chunk.normals.begin(), chunk.normals.end(),
+                _attrib.normals.begin() + normalOffsets[c]);
+            std::copy(chunk.texcoords.begin(), chunk.texcoords.end(),
+                _attrib.texcoords.begin() + texcoordOffsets[c]);
+            std::copy(chunk.indices.begin(), chunk.indices.end(),
+                indices.begin() + indexOffsets[c]);
+            for (std::size_t f = 0; f < chunk.faceStarts.size(); ++f)
+            {
+              faceStarts[faceOffsets[c] + f] =
+                indexOffsets[c] + chunk.faceStarts[f];
+            }
+
+            chunk.vertices = std::vector<tinyobj::real_t>();
+            chunk.normals = std::vector<tinyobj::real_t>();
+            chunk.texcoords = std::vector<tinyobj::real_t>();
+            chunk.indices = std::vector<tinyobj::index_t>();
+          }
+        });
+
+    // Replay the lines that group faces, in the order of tinyobj::LoadObj
+    std::string baseDir = _path;
+#ifndef _WIN32
+    const char dirsep = '/';
+#else
+    const char dirsep = '\\';
+#endif
+    if (!baseDir.empty() && baseDir.back() != dirsep)
+      baseDir += dirsep;
+    tinyobj::MaterialFileReader materialReader(baseDir);
+    std::map<std::string, int> materialMap;
+    int material = -1;
+    std::string name;
+    tinyobj::shape_t shape;
+    std::size_t groupBegin = 0;
+    std::size_t lineOffset = 0;
+
+    auto flush = [&](const std::size_t _face)
+    {
+      const bool exported = ExportFaces(shape, indices, faceStarts,
+          groupBegin, _face, material, name, _attrib.vertices);
+      groupBegin = _face;
+      return exported;
+    };
+
+    for (std::size_t c = 0; c < chunks.size(); ++c)
+    {
+      for (const ObjStatement &statement : chunks[c].statements)
+      {
+        const std::size_t face = faceOffsets[c] + statement.face;
+        const std::string &text = statement.text;
+        if (text[0] == 'u')
+        {
+          const std::string materialName = text.substr(7);
+          auto iter = materialMap.find(materialName);
+          const int newMaterial =
+            iter != materialMap.end() ? iter->second : -1;
+          if (newMaterial != material)
+          {
+            flush(face);
+            material = newMaterial;
+          }
+        }
+        else if (text[0] == 'm')
+        {
+          std::vector<std::string> filenames;
+          tinyobj::SplitString(text.substr(7), ' ', filenames);
+          if (filenames.empty())
+          {
+            _warn += "Looks like empty filename for mtllib. Use default "
+                     "material (line " +
+              std::to_string(lineOffset + statement.line) + ".)\n";
+            continue;
+          }
+
+          bool found = false;
+          for (const std::string &materialFile : filenames)
+          {
+            std::string warnMtl;
+            std::string errMtl;
+            const bool ok = materialReader(materialFile, &_materials,
+                &materialMap, &warnMtl, &errMtl);
+            _warn += warnMtl;
+            _err += errMtl;
+            if (ok)
+            {
+              found = true;
+              break;
+            }
+          }
+          if (!found)
+            _warn += "Failed to load material file(s). Use default material.\n";
+        }
+        else if (text[0] == 'g')
+        {
+          flush(face);
+          if (!shape.mesh.indices.empty())
+            _shapes.push_back(std::move(shape));
+          shape = tinyobj::shape_t();
+
+          std::vector<std::string> names;
+          const char *p = text.c_str();
+          const char *end = p + text.size();
+          while (p < end)
+          {
+            const char *nameEnd = TokenEnd(p, end, false);
+            names.emplace_back(p, nameEnd);
+            p = SkipSpaces(nameEnd, end);
+          }
+
+          name.clear();
+          for (std::size_t i = 1; i < names.size(); ++i)
+            name += (i > 1 ? " " : "") + names[i];
+          if (names.size() < 2)
+          {
+            _warn += "Empty group name. line: " +
+              std::to_string(lineOffset + statement.line) + "\n";
+          }
+        }
+        else
+        {
+          if (flush(face))
+            _shapes.push_back(std::move(shape));
+          shape = tinyobj::shape_t();
+          name = text.substr(2);
+        }
+      }
+      lineOffset += chunks[c].lines;
+    }
+
+    if (flush(faceStarts.size() - 1) || !shape.mesh.indices.empty())
+      _shapes.push_back(std::move(shape));
+
+    // Same warnings as tinyobj
+    const char *kinds[] = {"Vertex", "Vertex normal", "Vertex texcoord"};
+    const std::size_t counts[] = {_attrib.vertices.size() / 3,
+      _attrib.normals.size() / 3, _attrib.texcoords.size() / 2};
+    for (int k = 0; k < 3; ++k)
+    {
+      int value = -1;
+      for (std::size_t c = 0; c < chunks.size(); ++c)
+        value = std::max(value, greatest[c * 3 + k]);
+      if (value >= static_cast<int>(counts[k]))
+      {
+        _warn += std::string(kinds[k]) + " indices out of bounds (line " +
+          std::to_string(lines) + ".)\n\n";
+      }
+    }
+
+    return true;
+  }
+}
+
 //////////////////////////////////////////////////
 OBJLoader::OBJLoader()
 : dataPtr(ignition::utils::MakeImpl<Implementation>())
@@ -83,8 +743,19 @@ Mesh *OBJLoader::Load(const std::string &_filename)
 
   std::string warn;
   std::string err;
-  bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err,
-      _filename.c_str(), path.c_str(), triangulate);
+  bool ret = ParallelLoadObj(_filename, path, attrib, shapes, materials,
+      warn, err);
+  if (!ret)
+  {
+    // Files the parallel parser does not support are read by tinyobj
+    attrib = tinyobj::attrib_t();
+    shapes.clear();
+    materials.clear();
+    warn.clear();
+    err.clear();
+    ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err,
+        _filename.c_str(), path.c_str(), triangulate);
+  }
 
   if (!warn.empty())
   {
@@ -206,48 +877,15 @@ Mesh *OBJLoader::Load(const std::string &_filename)
       }
     }
 
-    unsigned int indexOffset = 0;
-    // For each face
-    for (unsigned int f = 0; f < s.mesh.num_face_vertices.size(); ++f)
-    {
-      // find the submesh that corresponds to the current face material
-      unsigned int matId = s.mesh.material_ids[f];
-      SubMesh *subMesh = subMeshMatId[matId];
-
-      unsigned int fnum = s.mesh.num_face_vertices[f];
-      // For each vertex in the face
-      for (unsigned int v = 0; v < fnum; ++v)
-      {
-        auto i = s.mesh.indices[indexOffset + v];
-
-        // vertices
-        int vIdx = i.vertex_index;
-        ignition::math::Vector3d vertex(attrib.vertices[3 * vIdx],
-                                        attrib.vertices[3 * vIdx + 1],
-                                        attrib.vertices[3 * vIdx + 2]);
-        subMesh->AddVertex(vertex);
-
-        // normals
-        if (attrib.normals.size() > 0)
+    // Fill the submeshes of the shape in parallel, one submesh per task
+    std::vector<std::pair<int, SubMesh *>> targets(
+        subMeshMatId.begin(), subMeshMatId.end());
+    ParallelFor(0u, targets.size(), 1u,
+        [&](const std::size_t _first, const std::size_t _last)
         {
-          int nIdx = i.normal_index;
-          ignition::math::Vector3d normal(attrib.normals[3 * nIdx],
-                                          attrib.normals[3 * nIdx + 1],
-                                          attrib.normals[3 * nIdx + 2]);
-          subMesh->AddNormal(normal);
-        }
-        // texcoords
-        if (attrib.texcoords.size() > 0)
-        {
-          int tIdx = i.texcoord_index;
-          ignition::math::Vector2d uv(attrib.texcoords[2 * tIdx],
-                                      attrib.texcoords[2 * tIdx + 1]);
-          subMesh->AddTexCoord(uv.X(), 1.0-uv.Y());
-        }
-        subMesh->AddIndex(subMesh->IndexCount());
-      }
-      indexOffset += fnum;
-    }
+          for (std::size_t t = _first; t < _last; ++t)
+            FillSubMesh(attrib, s.mesh, targets[t].first, *targets[t].second);
+        });
   }
 
   return mesh;
@@ -16,7 +16,14 @@
 */
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
 #include "test_config.h"
+#include "ignition/common/Filesystem.hh"
 #include "ignition/common/Mesh.hh"
 #include "ignition/common/SubMesh.hh"
 #include "ignition/common/Material.hh"
@@ -132,6 +139,129 @@ TEST_F(OBJLoaderTest, PBR)
   }
 }
 
+/////////////////////////////////////////////////
+// Large files are parsed in parallel. Files with carriage return line
+// endings are parsed by tinyobj, and must give the same mesh.
+TEST_F(OBJLoaderTest, Parallel)
+{
+  const std::string dir = common::testing::TempPath("obj_parallel");
+  ASSERT_TRUE(common::createDirectories(dir));
+  {
+    std::ofstream mtl(common::joinPaths(dir, "grid.mtl"));
+    mtl << "newmtl red\nKd 1 0 0\nnewmtl green\nKd 0 1 0\n";
+  }
+
+  // A grid of positions and texture coordinates spread over several chunks
+  const int n = 400;
+  std::ostringstream obj;
+  obj << "# grid\nmtllib grid.mtl\no grid\n";
+  for (int y = 0; y < n; ++y)
+  {
+    for (int x = 0; x < n; ++x)
+    {
+      obj << "v " << x * 0.125 << " " << -y * 3.5e-2 << " "
+          << (x * y % 7) * 1e-3 << "\n";
+      obj << "vt " << x / static_cast<double>(n) << " "
+          << y / static_cast<double>(n) << "\n";
+    }
+  }
+  obj << "vn 0 0 1\nvn 0.0 -0.0 -1.0E0\n";
+
+  // Triangles with positive indices, quads with negative indices, and
+  // faces without texture coordinates
+  obj << "usemtl red\n";
+  const int count = n * n;
+  for (int y = 0; y + 1 < n; ++y)
+  {
+    if (y == n / 3)
+      obj << "g second half\nusemtl green\n";
+    if (y == 2 * n / 3)
+      obj << "usemtl unknown\n";
+    for (int x = 0; x + 1 < n; ++x)
+    {
+      const int a = y * n + x + 1;
+      const int b = a + 1;
+      const int c = a + n + 1;
+      const int d = a + n;
+      if (y % 3 == 0)
+      {
+        obj << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 "
+            << c << "/" << c << "/1\n";
+        obj << "f " << a << "/" << a << "/1 " << c << "/" << c << "/1 "
+            << d << "/" << d << "/1\n";
+      }
+      else if (y % 3 == 1)
+      {
+        obj << "f " << a - count - 1 << "/" << a - count - 1 << "/-2 "
+            << b - count - 1 << "/" << b - count - 1 << "/-2 "
+            << c - count - 1 << "/" << c - count - 1 << "/-2 "
+            << d - count - 1 << "/" << d - count - 1 << "/-2\n";
+      }
+      else
+      {
+        obj << "f " << a << "//2 " << c << "//2 " << b << "//2\n";
+      }
+    }
+  }
+
+  // Relative indices after more positions
+  obj << "o extra\nusemtl red\nv 1 2 3\nv 4 5 6\nv 7 8 9\nvt 0.5 0.5\n"
+      << "f -3/-1/1 -2/-1/1 -1/-1/1\n";
+
+  const std::string content = obj.str();
+  ASSERT_GT(content.size(), 8u << 20);
+  std::string crContent = content;
+  std::replace(crContent.begin(), crContent.end(), '\n', '\r');
+
+  const std::string parallelFile = common::joinPaths(dir, "parallel.obj");
+  const std::string tinyobjFile = common::joinPaths(dir, "tinyobj.obj");
+  {
+    std::ofstream out(parallelFile, std::ios::binary);
+    out << content;
+  }
+  {
+    std::ofstream out(tinyobjFile, std::ios::binary);
+    out << crContent;
+  }
+
+  common::OBJLoader loader;
+  std::unique_ptr<common::Mesh> parallel(loader.Load(parallelFile));
+  std::unique_ptr<common::Mesh> reference(loader.Load(tinyobjFile));
+  ASSERT_NE(nullptr, parallel);
+  ASSERT_NE(nullptr, reference);
+
+  // grid: red; second half: green and unknown material; extra: red
+  ASSERT_EQ(4u, reference->SubMeshCount());
+  ASSERT_EQ(reference->SubMeshCount(), parallel->SubMeshCount());
+  EXPECT_EQ(2u, parallel->MaterialCount());
+  EXPECT_EQ(reference->MaterialCount(), parallel->MaterialCount());
+  for (unsigned int i = 0; i < reference->SubMeshCount(); ++i)
+  {
+    auto expected = reference->SubMeshByIndex(i).lock();
+    auto actual = parallel->SubMeshByIndex(i).lock();
+    EXPECT_EQ(expected->Name(), actual->Name());
+    EXPECT_EQ(expected->MaterialIndex(), actual->MaterialIndex());
+    ASSERT_EQ(expected->VertexCount(), actual->VertexCount());
+    ASSERT_EQ(expected->NormalCount(), actual->NormalCount());
+    ASSERT_EQ(expected->TexCoordCount(), actual->TexCoordCount());
+    ASSERT_EQ(expected->IndexCount(), actual->IndexCount());
+    for (unsigned int v = 0; v < expected->VertexCount(); ++v)
+    {
+      ASSERT_EQ(expected->Vertex(v), actual->Vertex(v));
+      ASSERT_EQ(expected->Normal(v), actual->Normal(v));
+      ASSERT_EQ(expected->TexCoord(v), actual->TexCoord(v));
+      ASSERT_EQ(expected->Index(v), actual->Index(v));
+    }
+  }
+  EXPECT_EQ("grid", parallel->SubMeshByIndex(0).lock()->Name());
+  EXPECT_EQ("second half", parallel->SubMeshByIndex(1).lock()->Name());
+  EXPECT_EQ("extra", parallel->SubMeshByIndex(3).lock()->Name());
+  EXPECT_EQ(math::Vector3d(7, 8, 9),
+      parallel->SubMeshByIndex(3).lock()->Vertex(2));
+
+  common::removeAll(dir);
+}
+
 /////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
@@ -18,6 +18,7 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <memory>
+#include <vector>
 
 #include "ignition/math/Helpers.hh"
 #include "ignition/common/Console.hh"
@@ -25,9 +26,121 @@
 #include "ignition/common/SubMesh.hh"
 #include "ignition/common/STLLoader.hh"
 
+#include "MappedFile.hh"
+
 using namespace ignition;
 using namespace common;
 
+namespace
+{
+  /// \brief Size of the binary STL header, including the triangle count
+  const std::size_t kBinaryHeaderSize = 84u;
+
+  /// \brief Size of a binary STL triangle: normal, three vertices and a
+  /// 16 bit attribute
+  const std::size_t kBinaryTriangleSize = 50u;
+
+  /// \brief Get the number of triangles of a binary STL file
+  /// \param[in] _data Content of the file
+  /// \param[in] _size Number of bytes in _data
+  /// \param[out] _count Number of triangles
+  /// \return True if _data is large enough for the header and all the
+  /// triangles
+  bool BinaryTriangleCount(const char *_data, const std::size_t _size,
+      uint32_t &_count)
+  {
+    if (_size < kBinaryHeaderSize)
+      return false;
+    memcpy(&_count, _data + 80, sizeof(_count));
+    return (_size - kBinaryHeaderSize) / kBinaryTriangleSize >= _count;
+  }
+
+  /// \brief Hash the bits of a vertex position and normal
+  /// \param[in] _bits Six floats reinterpreted as integers
+  /// \return The hash
+  uint64_t WeldHash(const uint32_t *_bits)
+  {
+    uint64_t hash = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 6; ++i)
+    {
+      hash = (hash ^ _bits[i]) * 0xFF51AFD7ED558CCDull;
+      hash ^= hash >> 32;
+    }
+    return hash;
+  }
+
+  /// \brief Decode the triangles of a binary STL file. Corners with the
+  /// same position and normal are welded into a single vertex with an open
+  /// addressing hash table, so that loading takes linear time.
+  /// \param[in] _data Content of the file
+  /// \param[in] _size Number of bytes in _data
+  /// \param[out] _subMesh Submesh that receives the triangles
+  /// \return False if _data is too small for the triangles it announces
+  bool DecodeBinary(const char *_data, const std::size_t _size,
+      SubMesh &_subMesh)
+  {
+    uint32_t count = 0;
+    if (!BinaryTriangleCount(_data, _size, count))
+      return false;
+
+    // Position and normal of every welded vertex, as float bits
+    std::vector<uint32_t> vertices;
+    vertices.reserve(static_cast<std::size_t>(count) * 6u);
+    std::vector<unsigned int> indices(static_cast<std::size_t>(count) * 3u);
+
+    // Table of vertex index + 1, zero for empty slots, at most half full
+    std::size_t slots = 16u;
+    while (slots < static_cast<std::size_t>(count) * 6u)
+      slots *= 2u;
+    std::vector<uint32_t> table(slots, 0u);
+    const std::size_t mask = slots - 1u;
+
+    const char *record = _data + kBinaryHeaderSize;
+    for (std::size_t t = 0; t < count; ++t, record += kBinaryTriangleSize)
+    {
+      float values[12];
+      memcpy(values, record, sizeof(values));
+      for (float &value : values)
+      {
+        // Weld -0 with +0
+        value += 0.0f;
+      }
+
+      for (std::size_t c = 0; c < 3u; ++c)
+      {
+        uint32_t key[6];
+        memcpy(key, values + 3u + c * 3u, 3u * sizeof(float));
+        memcpy(key + 3, values, 3u * sizeof(float));
+
+        std::size_t slot = WeldHash(key) & mask;
+        while (table[slot] != 0u &&
+            memcmp(&vertices[(table[slot] - 1u) * 6u], key, sizeof(key)) != 0)
+        {
+          slot = (slot + 1u) & mask;
+        }
+
+        if (table[slot] == 0u)
+        {
+          vertices.insert(vertices.end(), key, key + 6);
+          table[slot] = static_cast<uint32_t>(vertices.size() / 6u);
+        }
+        indices[t * 3u + c] = table[slot] - 1u;
+      }
+    }
+
+    for (std::size_t i = 0; i < vertices.size(); i += 6u)
+    {
+      float v[6];
+      memcpy(v, &vertices[i], sizeof(v));
+      _subMesh.AddVertex(v[0], v[1], v[2]);
+      _subMesh.AddNormal(v[3], v[4], v[5]);
+    }
+    for (const unsigned int index : indices)
+      _subMesh.AddIndex(index);
+
+    return true;
+  }
+}
 
 //////////////////////////////////////////////////
 class ignition::common::STLLoader::Implementation
@@ -49,7 +162,8 @@ STLLoader::~STLLoader()
 //////////////////////////////////////////////////
 Mesh *STLLoader::Load(const std::string &_filename)
 {
-  FILE *file = fopen(_filename.c_str(), "r");
+  MappedFile mapped(_filename);
+  FILE *file = mapped.Valid() ? fopen(_filename.c_str(), "r") : nullptr;
 
   if (!file)
   {
@@ -59,12 +173,20 @@ Mesh *STLLoader::Load(const std::string &_filename)
 
   Mesh *mesh = new Mesh();
 
-  // Try to read ASCII first. If that fails, try binary
-  if (!this->ReadAscii(file, mesh))
+  // A file whose size matches the triangle count of a binary header is
+  // binary, even when it starts with "solid" like ASCII files do. Others
+  // are read as ASCII first, then as binary.
+  uint32_t count = 0;
+  const bool binary =
+    BinaryTriangleCount(mapped.Data(), mapped.Size(), count) &&
+    mapped.Size() == kBinaryHeaderSize + count * kBinaryTriangleSize;
+
+  if (binary || !this->ReadAscii(file, mesh))
   {
-    fclose(file);
-    file = fopen(_filename.c_str(), "rb");
-    if (!this->ReadBinary(file, mesh))
+    SubMesh subMesh;
+    if (DecodeBinary(mapped.Data(), mapped.Size(), subMesh))
+      mesh->AddSubMesh(subMesh);
+    else
       ignerr << "Unable to read STL[" << _filename << "]\n";
   }
 
@@ -87,6 +209,8 @@ bool STLLoader::ReadAscii(FILE *_filein, Mesh *_mesh)
   bool result = true;
 
   SubMesh subMesh;
+  // Every vertex is looked up by position
+  subMesh.SetVertexHashEnabled(true);
 
   // Read the next line of the file into INPUT.
   while (fgets (input, LINE_MAX_LEN, _filein) != nullptr)
@@ -180,6 +304,7 @@ bool STLLoader::ReadAscii(FILE *_filein, Mesh *_mesh)
   }
 
   result = subMesh.VertexCount() > 0;
+  subMesh.SetVertexHashEnabled(false);
 
   if (result)
     _mesh->AddSubMesh(subMesh);
@@ -190,70 +315,16 @@ bool STLLoader::ReadAscii(FILE *_filein, Mesh *_mesh)
 //////////////////////////////////////////////////
 bool STLLoader::ReadBinary(FILE *_filein, Mesh *_mesh)
 {
-  int i;
-  int iface;
-  int face_num;
+  // Read the rest of the file
+  std::vector<char> data;
+  char buffer[4096];
+  std::size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), _filein)) > 0)
+    data.insert(data.end(), buffer, buffer + read);
 
   SubMesh subMesh;
-
-  // 80 byte Header.
-  for (i = 0; i < 80; ++i)
-    fgetc(_filein);
-
-  // Number of faces.
-  face_num = this->LongIntRead(_filein);
-
-  ignition::math::Vector3d normal;
-  ignition::math::Vector3d vertex;
-
-  // For each (triangular) face,
-  // components of normal vector,
-  // coordinates of three vertices,
-  // 2 byte "attribute".
-  for (iface = 0; iface < face_num; iface++)
-  {
-    if (!this->FloatRead(_filein, normal.X()))
-      return false;
-    if (!this->FloatRead(_filein, normal.Y()))
-      return false;
-    if (!this->FloatRead(_filein, normal.Z()))
-      return false;
-
-    if (!this->FloatRead(_filein, vertex.X()))
-      return false;
-    if (!this->FloatRead(_filein, vertex.Y()))
-      return false;
-    if (!this->FloatRead(_filein, vertex.Z()))
-      return false;
-
-    subMesh.AddVertex(vertex);
-    subMesh.AddNormal(normal);
-    subMesh.AddIndex(subMesh.VertexCount()-1);
-
-    if (!this->FloatRead(_filein, vertex.X()))
-      return false;
-    if (!this->FloatRead(_filein, vertex.Y()))
-      return false;
-    if (!this->FloatRead(_filein, vertex.Z()))
-      return false;
-    subMesh.AddVertex(vertex);
-    subMesh.AddNormal(normal);
-    subMesh.AddIndex(subMesh.VertexCount()-1);
-
-    if (!this->FloatRead(_filein, vertex.X()))
-      return false;
-    if (!this->FloatRead(_filein, vertex.Y()))
-      return false;
-    if (!this->FloatRead(_filein, vertex.Z()))
-      return false;
-    subMesh.AddVertex(vertex);
-    subMesh.AddNormal(normal);
-    subMesh.AddIndex(subMesh.VertexCount()-1);
-
-    uint16_t shortTmp;
-    if (!ShortIntRead(_filein, shortTmp))
-      return false;
-  }
+  if (!DecodeBinary(data.data(), data.size(), subMesh))
+    return false;
 
   _mesh->AddSubMesh(subMesh);
   return true;
@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "test_config.h"
+#include "ignition/common/Filesystem.hh"
+#include "ignition/common/Mesh.hh"
+#include "ignition/common/SubMesh.hh"
+#include "ignition/common/STLLoader.hh"
+
+using namespace ignition;
+
+class STLLoaderTest : public common::testing::AutoLogFixture { };
+
+/////////////////////////////////////////////////
+/// \brief Write a binary STL file
+/// \param[in] _path Path of the file
+/// \param[in] _header First bytes of the 80 byte header
+/// \param[in] _triangles Normal and three vertices of every triangle
+/// \param[in] _extra Number of bytes appended after the triangles
+void WriteBinarySTL(const std::string &_path, const std::string &_header,
+    const std::vector<std::vector<float>> &_triangles,
+    const std::size_t _extra = 0u)
+{
+  std::string data(80, ' ');
+  data.replace(0, _header.size(), _header);
+  const uint32_t count = static_cast<uint32_t>(_triangles.size());
+  data.append(reinterpret_cast<const char *>(&count), sizeof(count));
+  for (const auto &triangle : _triangles)
+  {
+    data.append(reinterpret_cast<const char *>(triangle.data()),
+        12u * sizeof(float));
+    data.append(2u, '\0');
+  }
+  data.append(_extra, '\0');
+
+  std::ofstream out(_path, std::ios::binary);
+  out.write(data.data(), data.size());
+}
+
+/////////////////////////////////////////////////
+TEST_F(STLLoaderTest, Binary)
+{
+  const std::string path = common::testing::TempPath("stl_binary.stl");
+  ASSERT_TRUE(common::createDirectories(common::parentPath(path)));
+
+  // Two triangles of a square sharing an edge, and a triangle with the
+  // same corners but another normal
+  const std::vector<std::vector<float>> triangles =
+  {
+    {0, 0, 1,  0, 0, 0,  1, 0, 0,  1, 1, 0},
+    {0, 0, 1,  0, 0, 0,  1, 1, 0,  0, 1, 0},
+    {0, 0, -1,  0, 0, 0,  1, 1, 0,  1, 0, 0},
+  };
+
+  // Binary files may start with "solid" like ASCII files
+  for (const std::string header : {"binary", "solid square"})
+  {
+    WriteBinarySTL(path, header, triangles);
+
+    common::STLLoader loader;
+    common::Mesh *mesh = loader.Load(path);
+    ASSERT_NE(nullptr, mesh);
+    ASSERT_EQ(1u, mesh->SubMeshCount());
+    auto subMesh = mesh->SubMeshByIndex(0).lock();
+
+    // Corners are welded when both position and normal match
+    EXPECT_EQ(7u, subMesh->VertexCount());
+    EXPECT_EQ(7u, subMesh->NormalCount());
+    ASSERT_EQ(9u, subMesh->IndexCount());
+    for (unsigned int t = 0; t < triangles.size(); ++t)
+    {
+      const auto &triangle = triangles[t];
+      const math::Vector3d normal(triangle[0], triangle[1], triangle[2]);
+      for (unsigned int c = 0; c < 3u; ++c)
+      {
+        const unsigned int index = subMesh->Index(t * 3u + c);
+        EXPECT_EQ(math::Vector3d(triangle[3 + c * 3], triangle[4 + c * 3],
+              triangle[5 + c * 3]), subMesh->Vertex(index));
+        EXPECT_EQ(normal, subMesh->Normal(index));
+      }
+    }
+    EXPECT_EQ(subMesh->Index(0), subMesh->Index(3));
+    EXPECT_EQ(subMesh->Index(2), subMesh->Index(4));
+    EXPECT_NE(subMesh->Index(0), subMesh->Index(6));
+    EXPECT_EQ(math::Vector3d(1, 1, 0), mesh->Max());
+    EXPECT_EQ(math::Vector3d::Zero, mesh->Min());
+    delete mesh;
+  }
+
+  // Trailing bytes after the triangles are ignored
+  WriteBinarySTL(path, "binary", triangles, 7u);
+  {
+    common::STLLoader loader;
+    common::Mesh *mesh = loader.Load(path);
+    ASSERT_NE(nullptr, mesh);
+    ASSERT_EQ(1u, mesh->SubMeshCount());
+    EXPECT_EQ(9u, mesh->IndexCount());
+    delete mesh;
+  }
+
+  common::removeFile(path);
+}
+
+/////////////////////////////////////////////////
+TEST_F(STLLoaderTest, Truncated)
+{
+  const std::string path = common::testing::TempPath("stl_truncated.stl");
+  ASSERT_TRUE(common::createDirectories(common::parentPath(path)));
+  WriteBinarySTL(path, "binary", {{0, 0, 1,  0, 0, 0,  1, 0, 0,  1, 1, 0}});
+
+  // Claim two triangles
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    const uint32_t count = 2u;
+    file.seekp(80);
+    file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  }
+
+  common::STLLoader loader;
+  common::Mesh *mesh = loader.Load(path);
+  ASSERT_NE(nullptr, mesh);
+  EXPECT_EQ(0u, mesh->SubMeshCount());
+  delete mesh;
+
+  EXPECT_EQ(nullptr, loader.Load(path + ".missing"));
+  common::removeFile(path);
+}
+
+/////////////////////////////////////////////////
+TEST_F(STLLoaderTest, Ascii)
+{
+  const std::string path = common::testing::TempPath("stl_ascii.stl");
+  ASSERT_TRUE(common::createDirectories(common::parentPath(path)));
+  {
+    std::ofstream out(path);
+    out << "solid triangle\n"
+        << "facet normal 0 0 1\n"
+        << "  outer loop\n"
+        << "    vertex 0 0 0\n"
+        << "    vertex 1 0 0\n"
+        << "    vertex 1 1 0\n"
+        << "  endloop\n"
+        << "endfacet\n"
+        << "endsolid triangle\n";
+  }
+
+  common::STLLoader loader;
+  common::Mesh *mesh = loader.Load(path);
+  ASSERT_NE(nullptr, mesh);
+  EXPECT_EQ(1u, mesh->SubMeshCount());
+  EXPECT_EQ(3u, mesh->IndexCount());
+  EXPECT_EQ(math::Vector3d(1, 1, 0), mesh->Max());
+  delete mesh;
+
+  common::removeFile(path);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -15,8 +15,14 @@
  *
 */
 
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
 #include "ignition/common/Console.hh"
 #include "ignition/common/NodeAnimation.hh"
+#include "ignition/common/Parallel.hh"
 #include "ignition/common/SkeletonAnimation.hh"
 
 using namespace ignition;
@@ -75,6 +81,23 @@ NodeAnimation *SkeletonAnimation::NodeAnimationByName(
   return nullptr;
 }
 
+//////////////////////////////////////////////////
+NodeAnimation *SkeletonAnimation::NodeAnimationByIndex(
+    const unsigned int _index) const
+{
+  if (_index >= this->dataPtr->animations.size())
+    return nullptr;
+  return std::next(this->dataPtr->animations.begin(), _index)->second.get();
+}
+
+//////////////////////////////////////////////////
+void SkeletonAnimation::ForEachNodeAnimation(
+    const std::function<void(const NodeAnimation &)> &_fn) const
+{
+  for (const auto &animation : this->dataPtr->animations)
+    _fn(*animation.second);
+}
+
 //////////////////////////////////////////////////
 bool SkeletonAnimation::HasNode(const std::string &_node) const
 {
@@ -131,12 +154,25 @@ std::map<std::string, math::Matrix4d> SkeletonAnimation::PoseAt(
   ///  it's not guaranteed. fixing this will help not having to find the
   ///  prev and next keyframe for each node at each time step, but rather
   ///  doing it only once per time step.
+  std::vector<const NodeAnimation *> nodes;
+  nodes.reserve(this->dataPtr->animations.size());
+  for (const auto &anim : this->dataPtr->animations)
+    nodes.push_back(anim.second.get());
+
+  // Interpolating a node only reads its own keyframes
+  std::vector<math::Matrix4d> frames(nodes.size());
+  ParallelFor(0, nodes.size(), 16,
+      [&](const std::size_t _first, const std::size_t _last)
+      {
+        for (std::size_t i = _first; i < _last; ++i)
+          frames[i] = nodes[i]->FrameAt(_time, _loop);
+      });
+
+  // Both containers are sorted by node name
   std::map<std::string, math::Matrix4d> pose;
-  for (auto iter = this->dataPtr->animations.begin();
-      iter != this->dataPtr->animations.end(); ++iter)
-  {
-    pose[iter->first] = iter->second->FrameAt(_time, _loop);
-  }
+  std::size_t i = 0;
+  for (const auto &anim : this->dataPtr->animations)
+    pose.emplace_hint(pose.end(), anim.first, frames[i++]);
 
   return pose;
 }
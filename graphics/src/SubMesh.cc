@@ -16,30 +16,603 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <map>
+#include <mutex>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #include "ignition/math/Helpers.hh"
 
 #include "ignition/common/Console.hh"
 #include "ignition/common/Material.hh"
+#include "ignition/common/Parallel.hh"
 #include "ignition/common/SubMesh.hh"
 
 using namespace ignition;
 using namespace common;
 
+namespace
+{
+  /// \brief Largest tolerance used to compare vertex positions, which is the
+  /// one of math::Vector3d::operator==, slightly enlarged to absorb rounding.
+  const double kPositionTolerance = 1.01e-3;
+
+  /// \brief Size of the cells of VertexGrid. Larger than the tolerance, so
+  /// that most positions only need to look into their own cell.
+  const double kGridCellSize = 4e-3;
+
+  /// \brief Array of per-vertex attributes with N components. They are
+  /// stored either as math vectors of doubles, or packed as N 32 bit floats
+  /// per element that can be handed to consumers without conversion.
+  template <typename Vec, std::size_t N>
+  class AttributeArray
+  {
+    /// \brief Get the number of elements
+    /// \return Number of elements
+    public: std::size_t Size() const
+    {
+      return this->packed ? this->floats.size() / N : this->doubles.size();
+    }
+
+    /// \brief Check whether the array has no elements
+    /// \return True if empty
+    public: bool Empty() const
+    {
+      return 0u == this->Size();
+    }
+
+    /// \brief Get an element
+    /// \param[in] _i Element index, must be less than Size()
+    /// \return Copy of the element
+    public: Vec operator[](const std::size_t _i) const
+    {
+      if (!this->packed)
+        return this->doubles[_i];
+
+      const float *f = &this->floats[_i * N];
+      if constexpr (N == 3)
+        return Vec(f[0], f[1], f[2]);
+      else
+        return Vec(f[0], f[1]);
+    }
+
+    /// \brief Set an element
+    /// \param[in] _i Element index, must be less than Size()
+    /// \param[in] _v New value
+    public: void Set(const std::size_t _i, const Vec &_v)
+    {
+      if (!this->packed)
+      {
+        this->doubles[_i] = _v;
+        return;
+      }
+
+      float *f = &this->floats[_i * N];
+      f[0] = static_cast<float>(_v.X());
+      f[1] = static_cast<float>(_v.Y());
+      if constexpr (N == 3)
+        f[2] = static_cast<float>(_v.Z());
+    }
+
+    /// \brief Append an element
+    /// \param[in] _v Value to append
+    public: void PushBack(const Vec &_v)
+    {
+      if (!this->packed)
+      {
+        this->doubles.push_back(_v);
+        return;
+      }
+
+      this->floats.resize(this->floats.size() + N);
+      this->Set(this->Size() - 1, _v);
+    }
+
+    /// \brief Replace the content with copies of a value
+    /// \param[in] _count Number of elements
+    /// \param[in] _v Value of every element
+    public: void Assign(const std::size_t _count, const Vec &_v)
+    {
+      this->Clear();
+      if (!this->packed)
+      {
+        this->doubles.assign(_count, _v);
+        return;
+      }
+
+      this->floats.resize(_count * N);
+      for (std::size_t i = 0; i < _count; ++i)
+        this->Set(i, _v);
+    }
+
+    /// \brief Replace the content with elements given as consecutive
+    /// components. Packed floats are copied as a whole.
+    /// \param[in] _values Components of the elements
+    /// \param[in] _count Number of components. A partial element at the
+    /// end is ignored.
+    public: template <typename T>
+    void AssignValues(const T *_values, const std::size_t _count)
+    {
+      this->Clear();
+      const std::size_t size = _count / N;
+      if (this->packed)
+      {
+        this->floats.assign(_values, _values + size * N);
+        return;
+      }
+
+      this->doubles.reserve(size);
+      for (std::size_t i = 0; i < size; ++i)
+      {
+        const T *v = _values + i * N;
+        if constexpr (N == 3)
+          this->doubles.emplace_back(v[0], v[1], v[2]);
+        else
+          this->doubles.emplace_back(v[0], v[1]);
+      }
+    }
+
+    /// \brief Reserve memory for elements
+    /// \param[in] _count Number of elements
+    public: void Reserve(const std::size_t _count)
+    {
+      if (this->packed)
+        this->floats.reserve(_count * N);
+      else
+        this->doubles.reserve(_count);
+    }
+
+    /// \brief Remove all elements
+    public: void Clear()
+    {
+      this->doubles.clear();
+      this->floats.clear();
+    }
+
+    /// \brief Change how elements are stored, converting existing ones
+    /// \param[in] _packed True to store packed 32 bit floats
+    public: void SetPacked(const bool _packed)
+    {
+      if (_packed == this->packed)
+        return;
+
+      AttributeArray converted;
+      converted.packed = _packed;
+      if (_packed)
+        converted.floats.reserve(this->Size() * N);
+      else
+        converted.doubles.reserve(this->Size());
+      for (std::size_t i = 0; i < this->Size(); ++i)
+        converted.PushBack((*this)[i]);
+      *this = std::move(converted);
+    }
+
+    /// \brief Reorder the elements
+    /// \param[in] _order Old index of every element in the new order
+    public: void Permute(const std::vector<unsigned int> &_order)
+    {
+      AttributeArray permuted;
+      permuted.packed = this->packed;
+      if (this->packed)
+      {
+        permuted.floats.resize(_order.size() * N);
+        for (std::size_t i = 0; i < _order.size(); ++i)
+        {
+          std::copy_n(&this->floats[_order[i] * N], N,
+              &permuted.floats[i * N]);
+        }
+      }
+      else
+      {
+        permuted.doubles.reserve(_order.size());
+        for (const unsigned int old : _order)
+          permuted.doubles.push_back(this->doubles[old]);
+      }
+      *this = std::move(permuted);
+    }
+
+    /// \brief Get the packed elements
+    /// \return Pointer to Size() * N floats, or nullptr if elements are not
+    /// packed
+    public: const float *Data() const
+    {
+      return this->packed ? this->floats.data() : nullptr;
+    }
+
+    /// \brief True if elements are stored as packed floats
+    private: bool packed = false;
+
+    /// \brief Elements, if not packed
+    private: std::vector<Vec> doubles;
+
+    /// \brief Elements, if packed
+    private: std::vector<float> floats;
+  };
+
+  /// \brief Array of positions or normals
+  using Vector3Array = AttributeArray<ignition::math::Vector3d, 3>;
+
+  /// \brief Array of texture coordinates
+  using Vector2Array = AttributeArray<ignition::math::Vector2d, 2>;
+
+  /// \brief Integer coordinates of a cell of VertexGrid
+  struct GridCell
+  {
+    int64_t x;
+    int64_t y;
+    int64_t z;
+
+    bool operator==(const GridCell &_other) const
+    {
+      return this->x == _other.x && this->y == _other.y &&
+          this->z == _other.z;
+    }
+  };
+
+  /// \brief Hash function for GridCell
+  struct GridCellHash
+  {
+    std::size_t operator()(const GridCell &_cell) const
+    {
+      return static_cast<std::size_t>(
+          (static_cast<uint64_t>(_cell.x) * 73856093u) ^
+          (static_cast<uint64_t>(_cell.y) * 19349663u) ^
+          (static_cast<uint64_t>(_cell.z) * 83492791u));
+    }
+  };
+
+  /// \brief Vertex indices bucketed by the cell that contains them
+  using VertexGrid =
+      std::unordered_map<GridCell, std::vector<std::size_t>, GridCellHash>;
+
+  /// \brief Get the cell coordinate of a position along one axis
+  /// \param[in] _x Position along the axis
+  /// \return Cell coordinate. Non-finite positions all map to cell 0.
+  int64_t GridCoord(const double _x)
+  {
+    const double limit = 1e15;
+    if (!std::isfinite(_x))
+      return 0;
+    return static_cast<int64_t>(
+        std::floor(std::max(-limit, std::min(limit, _x / kGridCellSize))));
+  }
+
+  /// \brief Get the cell of a position
+  /// \param[in] _v Position
+  /// \return Cell containing _v
+  GridCell GridCellOf(const ignition::math::Vector3d &_v)
+  {
+    return GridCell{GridCoord(_v.X()), GridCoord(_v.Y()), GridCoord(_v.Z())};
+  }
+
+  /// \brief Call a function with every vertex of the cells that may hold
+  /// positions equal to a given one. The caller compares the positions.
+  /// \param[in] _grid Grid of the vertices
+  /// \param[in] _v Position to look for
+  /// \param[in] _fn Function called with the index of every candidate
+  template <typename Function>
+  void ForEachVertexNear(const VertexGrid &_grid,
+      const ignition::math::Vector3d &_v, Function &&_fn)
+  {
+    const GridCell lo = GridCellOf(_v - kPositionTolerance);
+    const GridCell hi = GridCellOf(_v + kPositionTolerance);
+    for (int64_t x = lo.x; x <= hi.x; ++x)
+    {
+      for (int64_t y = lo.y; y <= hi.y; ++y)
+      {
+        for (int64_t z = lo.z; z <= hi.z; ++z)
+        {
+          auto bucket = _grid.find(GridCell{x, y, z});
+          if (bucket == _grid.end())
+            continue;
+          for (const std::size_t k : bucket->second)
+            _fn(k);
+        }
+      }
+    }
+  }
+
+  /// \brief Add a vertex to a grid, keeping buckets sorted by index
+  /// \param[in,out] _grid Grid to update
+  /// \param[in] _v Position of the vertex
+  /// \param[in] _index Index of the vertex
+  void GridInsert(VertexGrid &_grid, const ignition::math::Vector3d &_v,
+      const std::size_t _index)
+  {
+    auto &bucket = _grid[GridCellOf(_v)];
+    bucket.insert(std::upper_bound(bucket.begin(), bucket.end(), _index),
+        _index);
+  }
+
+  /// \brief Remove a vertex from a grid
+  /// \param[in,out] _grid Grid to update
+  /// \param[in] _v Position of the vertex when it was inserted
+  /// \param[in] _index Index of the vertex
+  void GridErase(VertexGrid &_grid, const ignition::math::Vector3d &_v,
+      const std::size_t _index)
+  {
+    auto bucket = _grid.find(GridCellOf(_v));
+    if (bucket == _grid.end())
+      return;
+    auto it = std::lower_bound(
+        bucket->second.begin(), bucket->second.end(), _index);
+    if (it != bucket->second.end() && *it == _index)
+      bucket->second.erase(it);
+    if (bucket->second.empty())
+      _grid.erase(bucket);
+  }
+
+  /// \brief Build a grid of vertices
+  /// \param[in] _vertices Vertex positions
+  /// \return Grid of all the vertices
+  VertexGrid BuildGrid(const Vector3Array &_vertices)
+  {
+    VertexGrid grid;
+    grid.reserve(_vertices.Size());
+    for (std::size_t v = 0; v < _vertices.Size(); ++v)
+      grid[GridCellOf(_vertices[v])].push_back(v);
+    return grid;
+  }
+
+  /// \brief Interior angle of a triangle at one of its corners
+  /// \param[in] _corner Position of the corner
+  /// \param[in] _a Position of the next corner
+  /// \param[in] _b Position of the last corner
+  /// \return Angle in radians, between 0 and pi
+  double CornerAngle(const ignition::math::Vector3d &_corner,
+      const ignition::math::Vector3d &_a, const ignition::math::Vector3d &_b)
+  {
+    const ignition::math::Vector3d e1 = _a - _corner;
+    const ignition::math::Vector3d e2 = _b - _corner;
+    return std::atan2(e1.Cross(e2).Length(), e1.Dot(e2));
+  }
+
+  /// \brief Copy positions into a flat array of x, y, z values
+  /// \param[in] _positions Positions to copy
+  /// \param[out] _out Array with room for _positions.Size() * 3 values
+  template <typename T>
+  void CopyPositions(const Vector3Array &_positions, T *_out)
+  {
+    if constexpr (std::is_same_v<T, float>)
+    {
+      if (_positions.Data())
+      {
+        std::copy_n(_positions.Data(), _positions.Size() * 3, _out);
+        return;
+      }
+    }
+
+    for (std::size_t i = 0; i < _positions.Size(); ++i)
+    {
+      const ignition::math::Vector3d v = _positions[i];
+      *_out++ = static_cast<T>(v.X());
+      *_out++ = static_cast<T>(v.Y());
+      *_out++ = static_cast<T>(v.Z());
+    }
+  }
+
+  /// \brief Copy indices into an array of a possibly narrower type
+  /// \param[in] _indices Indices to copy
+  /// \param[in] _offset Value added to every index
+  /// \param[out] _out Array with room for _indices.size() values
+  /// \return False if an index plus _offset does not fit in T, in which case
+  /// nothing is written
+  template <typename T>
+  bool CopyIndices(const std::vector<unsigned int> &_indices,
+      const unsigned int _offset, T *_out)
+  {
+    if (_indices.empty())
+      return true;
+
+    const uint64_t limit = std::numeric_limits<T>::max();
+    if (sizeof(T) < sizeof(unsigned int) || _offset > 0u)
+    {
+      const uint64_t maxIndex =
+        *std::max_element(_indices.begin(), _indices.end());
+      if (maxIndex + _offset > limit)
+        return false;
+    }
+
+    if (0u == _offset)
+    {
+      std::copy(_indices.begin(), _indices.end(), _out);
+      return true;
+    }
+
+    for (const unsigned int index : _indices)
+      *_out++ = static_cast<T>(index + _offset);
+    return true;
+  }
+}
+
+namespace
+{
+  /// \brief Bounds and volume of a submesh. Const functions, which may run
+  /// concurrently, compute them on demand. Functions that change vertices
+  /// or indices update or invalidate them.
+  class DerivedCache
+  {
+    /// \brief Constructor
+    public: DerivedCache() = default;
+
+    /// \brief Copy constructor
+    /// \param[in] _other Cache to copy
+    public: DerivedCache(const DerivedCache &_other)
+    {
+      *this = _other;
+    }
+
+    /// \brief Assignment operator
+    /// \param[in] _other Cache to copy
+    /// \return Reference to this cache
+    public: DerivedCache &operator=(const DerivedCache &_other)
+    {
+      if (this == &_other)
+        return *this;
+
+      std::lock_guard<std::mutex> lock(_other.mutex);
+      this->min = _other.min;
+      this->max = _other.max;
+      this->volume = _other.volume;
+      this->boundsValid.store(
+          _other.boundsValid.load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+      this->volumeValid.store(
+          _other.volumeValid.load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+      return *this;
+    }
+
+    /// \brief Smallest coordinates of the vertices
+    public: ignition::math::Vector3d min;
+
+    /// \brief Largest coordinates of the vertices
+    public: ignition::math::Vector3d max;
+
+    /// \brief Volume of the triangles
+    public: double volume = 0.0;
+
+    /// \brief True if min and max are up to date. Set with release order
+    /// after they are computed.
+    public: std::atomic<bool> boundsValid{false};
+
+    /// \brief True if volume is up to date. Set with release order after
+    /// it is computed.
+    public: std::atomic<bool> volumeValid{false};
+
+    /// \brief Serializes the computations of const functions
+    public: mutable std::mutex mutex;
+  };
+}
+
 /// \brief Private data for SubMesh
 class ignition::common::SubMesh::Implementation
 {
+  /// \brief Compute the bounds unless they are cached
+  public: void UpdateBounds() const
+  {
+    if (this->cache.boundsValid.load(std::memory_order_acquire))
+      return;
+
+    std::lock_guard<std::mutex> lock(this->cache.mutex);
+    if (this->cache.boundsValid.load(std::memory_order_relaxed))
+      return;
+
+    ignition::math::Vector3d min(ignition::math::MAX_F,
+        ignition::math::MAX_F, ignition::math::MAX_F);
+    ignition::math::Vector3d max(-ignition::math::MAX_F,
+        -ignition::math::MAX_F, -ignition::math::MAX_F);
+    for (std::size_t i = 0; i < this->vertices.Size(); ++i)
+    {
+      const ignition::math::Vector3d v = this->vertices[i];
+      min.X(std::min(min.X(), v.X()));
+      min.Y(std::min(min.Y(), v.Y()));
+      min.Z(std::min(min.Z(), v.Z()));
+      max.X(std::max(max.X(), v.X()));
+      max.Y(std::max(max.Y(), v.Y()));
+      max.Z(std::max(max.Z(), v.Z()));
+    }
+    this->cache.min = min;
+    this->cache.max = max;
+    this->cache.boundsValid.store(true, std::memory_order_release);
+  }
+
+  /// \brief Grow the cached bounds to contain a stored vertex position.
+  /// Does nothing if the bounds are not cached.
+  /// \param[in] _v Position
+  public: void GrowBounds(const ignition::math::Vector3d &_v)
+  {
+    if (!this->cache.boundsValid.load(std::memory_order_relaxed))
+      return;
+    this->cache.min.Min(_v);
+    this->cache.max.Max(_v);
+  }
+
+  /// \brief Apply a transformation of every vertex to the cached bounds.
+  /// The transformation must be monotonic along every axis, as scaling and
+  /// translation are.
+  /// \param[in] _transform Function that transforms a position
+  public: template <typename Transform>
+  void TransformBounds(Transform _transform)
+  {
+    if (!this->cache.boundsValid.load(std::memory_order_relaxed))
+      return;
+
+    // Packed positions are rounded after the transformation, so compute
+    // their bounds again when they are needed
+    if (this->storage == SubMesh::VertexStorage::FLOAT32)
+    {
+      this->cache.boundsValid.store(false, std::memory_order_relaxed);
+      return;
+    }
+
+    const ignition::math::Vector3d a = _transform(this->cache.min);
+    const ignition::math::Vector3d b = _transform(this->cache.max);
+    this->cache.min = a;
+    this->cache.min.Min(b);
+    this->cache.max = a;
+    this->cache.max.Max(b);
+  }
+
+  /// \brief Record that vertex positions changed
+  public: void VerticesChanged()
+  {
+    ++this->vertexRevision;
+    this->cache.volumeValid.store(false, std::memory_order_relaxed);
+  }
+
+  /// \brief Record that indices or the primitive type changed
+  public: void IndicesChanged()
+  {
+    ++this->indexRevision;
+    this->cache.volumeValid.store(false, std::memory_order_relaxed);
+  }
+
+  /// \brief Replace all vertex positions
+  /// \param[in] _values x, y, z of each vertex
+  /// \param[in] _count Number of vertices
+  public: template <typename T>
+  void SetVertices(const T *_values, const std::size_t _count)
+  {
+    this->vertices.AssignValues(_values, _count * 3u);
+    this->VerticesChanged();
+    this->cache.boundsValid.store(false, std::memory_order_relaxed);
+    if (this->vertexHashEnabled)
+      this->vertexGrid = BuildGrid(this->vertices);
+  }
+
+  /// \brief Get a texture coordinate set, creating it with the current
+  /// storage if it doesn't exist
+  /// \param[in] _setIndex Texture coordinate set index
+  /// \return The texture coordinate set
+  public: Vector2Array &TexCoordSet(const unsigned int _setIndex)
+  {
+    auto it = this->texCoords.find(_setIndex);
+    if (it == this->texCoords.end())
+    {
+      it = this->texCoords.emplace(_setIndex, Vector2Array()).first;
+      it->second.SetPacked(this->storage == SubMesh::VertexStorage::FLOAT32);
+    }
+    return it->second;
+  }
+
   /// \brief the vertex array
-  public: std::vector<ignition::math::Vector3d> vertices;
+  public: Vector3Array vertices;
 
   /// \brief the normal array
-  public: std::vector<ignition::math::Vector3d> normals;
+  public: Vector3Array normals;
 
   /// \brief A map of texcoord set index to texture coordinate array
-  public: std::map<unsigned int, std::vector<ignition::math::Vector2d>>
-      texCoords;
+  public: std::map<unsigned int, Vector2Array> texCoords;
+
+  /// \brief How vertices, normals and texture coordinates are stored
+  public: SubMesh::VertexStorage storage = SubMesh::VertexStorage::DOUBLE;
 
   /// \brief the vertex index array
   public: std::vector<unsigned int> indices;
@@ -56,6 +629,21 @@ class ignition::common::SubMesh::Implementation
 
   /// \brief The name of the sub-mesh
   public: std::string name;
+
+  /// \brief True if vertexGrid is maintained
+  public: bool vertexHashEnabled = false;
+
+  /// \brief Spatial hash of the vertices, used to find vertices by position
+  public: VertexGrid vertexGrid;
+
+  /// \brief Incremented whenever vertex positions change
+  public: uint64_t vertexRevision = 0;
+
+  /// \brief Incremented whenever indices or the primitive type change
+  public: uint64_t indexRevision = 0;
+
+  /// \brief Bounds and volume
+  public: mutable DerivedCache cache;
 };
 
 //////////////////////////////////////////////////
@@ -80,6 +668,7 @@ SubMesh::~SubMesh()
 void SubMesh::SetPrimitiveType(PrimitiveType _type)
 {
   this->dataPtr->primitiveType = _type;
+  this->dataPtr->IndicesChanged();
 }
 
 //////////////////////////////////////////////////
@@ -92,12 +681,87 @@ SubMesh::PrimitiveType SubMesh::SubMeshPrimitiveType() const
 void SubMesh::AddIndex(const unsigned int _index)
 {
   this->dataPtr->indices.push_back(_index);
+  this->dataPtr->IndicesChanged();
+}
+
+//////////////////////////////////////////////////
+void SubMesh::Reserve(const unsigned int _vertexCount,
+    const unsigned int _indexCount)
+{
+  this->dataPtr->vertices.Reserve(_vertexCount);
+  this->dataPtr->normals.Reserve(_vertexCount);
+  this->dataPtr->indices.reserve(_indexCount);
+}
+
+//////////////////////////////////////////////////
+bool SubMesh::ReorderVertices(const std::vector<unsigned int> &_order)
+{
+  const std::size_t count = this->dataPtr->vertices.Size();
+  if (_order.size() != count)
+    return false;
+
+  const std::size_t normalCount = this->dataPtr->normals.Size();
+  if (normalCount != 0u && normalCount != count)
+    return false;
+  for (const auto &set : this->dataPtr->texCoords)
+  {
+    if (!set.second.Empty() && set.second.Size() != count)
+      return false;
+  }
+
+  // Inverse permutation, which also detects repeated indices
+  const unsigned int unset = std::numeric_limits<unsigned int>::max();
+  std::vector<unsigned int> newIndex(count, unset);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    if (_order[i] >= count || newIndex[_order[i]] != unset)
+      return false;
+    newIndex[_order[i]] = static_cast<unsigned int>(i);
+  }
+
+  this->dataPtr->vertices.Permute(_order);
+  if (normalCount != 0u)
+    this->dataPtr->normals.Permute(_order);
+  for (auto &set : this->dataPtr->texCoords)
+  {
+    if (!set.second.Empty())
+      set.second.Permute(_order);
+  }
+
+  for (unsigned int &index : this->dataPtr->indices)
+  {
+    if (index < count)
+      index = newIndex[index];
+  }
+  for (NodeAssignment &assignment : this->dataPtr->nodeAssignments)
+  {
+    if (assignment.vertexIndex < count)
+      assignment.vertexIndex = newIndex[assignment.vertexIndex];
+  }
+
+  // Bounds and volume don't change
+  ++this->dataPtr->vertexRevision;
+  ++this->dataPtr->indexRevision;
+
+  if (this->dataPtr->vertexHashEnabled)
+    this->dataPtr->vertexGrid = BuildGrid(this->dataPtr->vertices);
+  return true;
 }
 
 //////////////////////////////////////////////////
 void SubMesh::AddVertex(const ignition::math::Vector3d &_v)
 {
-  this->dataPtr->vertices.push_back(_v);
+  this->dataPtr->vertices.PushBack(_v);
+  this->dataPtr->VerticesChanged();
+  this->dataPtr->GrowBounds(
+      this->dataPtr->vertices[this->dataPtr->vertices.Size() - 1]);
+  if (this->dataPtr->vertexHashEnabled)
+  {
+    // Hash the stored position, which may have been rounded
+    const std::size_t index = this->dataPtr->vertices.Size() - 1;
+    this->dataPtr->vertexGrid[GridCellOf(this->dataPtr->vertices[index])]
+        .push_back(index);
+  }
 }
 
 //////////////////////////////////////////////////
@@ -109,7 +773,7 @@ void SubMesh::AddVertex(const double _x, const double _y, const double _z)
 //////////////////////////////////////////////////
 void SubMesh::AddNormal(const ignition::math::Vector3d &_n)
 {
-  this->dataPtr->normals.push_back(_n);
+  this->dataPtr->normals.PushBack(_n);
 }
 
 //////////////////////////////////////////////////
@@ -136,7 +800,7 @@ void SubMesh::AddTexCoord(const ignition::math::Vector2d &_uv)
 //////////////////////////////////////////////////
 void SubMesh::AddTexCoordBySet(double _u, double _v, unsigned int _setIndex)
 {
-  this->dataPtr->texCoords[_setIndex].push_back(
+  this->dataPtr->TexCoordSet(_setIndex).PushBack(
       ignition::math::Vector2d(_u, _v));
 }
 
@@ -147,6 +811,12 @@ void SubMesh::AddTexCoordBySet(const ignition::math::Vector2d &_uv,
   this->AddTexCoordBySet(_uv.X(), _uv.Y(), _setIndex);
 }
 
+//////////////////////////////////////////////////
+void SubMesh::AddTexCoordSet(const unsigned int _setIndex)
+{
+  this->dataPtr->TexCoordSet(_setIndex);
+}
+
 //////////////////////////////////////////////////
 void SubMesh::AddNodeAssignment(const unsigned int _vertex,
     const unsigned int _node, const float _weight)
@@ -162,7 +832,7 @@ void SubMesh::AddNodeAssignment(const unsigned int _vertex,
 //////////////////////////////////////////////////
 ignition::math::Vector3d SubMesh::Vertex(const unsigned int _index) const
 {
-  if (_index >= this->dataPtr->vertices.size())
+  if (_index >= this->dataPtr->vertices.Size())
   {
     ignerr << "Index too large" << std::endl;
     return math::Vector3d::Zero;
@@ -174,26 +844,48 @@ ignition::math::Vector3d SubMesh::Vertex(const unsigned int _index) const
 //////////////////////////////////////////////////
 bool SubMesh::HasVertex(const unsigned int _index) const
 {
-  return _index < this->dataPtr->vertices.size();
+  return _index < this->dataPtr->vertices.Size();
 }
 
 //////////////////////////////////////////////////
 void SubMesh::SetVertex(const unsigned int _index,
     const ignition::math::Vector3d &_v)
 {
-  if (_index >= this->dataPtr->vertices.size())
+  if (_index >= this->dataPtr->vertices.Size())
   {
     ignerr << "Index too large" << std::endl;
     return;
   }
 
-  this->dataPtr->vertices[_index] = _v;
+  if (this->dataPtr->vertexHashEnabled)
+  {
+    GridErase(this->dataPtr->vertexGrid, this->dataPtr->vertices[_index],
+        _index);
+  }
+  // The bounds may shrink if the old position was on them
+  const ignition::math::Vector3d old = this->dataPtr->vertices[_index];
+  const DerivedCache &cache = this->dataPtr->cache;
+  if (old.X() == cache.min.X() || old.Y() == cache.min.Y() ||
+      old.Z() == cache.min.Z() || old.X() == cache.max.X() ||
+      old.Y() == cache.max.Y() || old.Z() == cache.max.Z())
+  {
+    this->dataPtr->cache.boundsValid.store(false, std::memory_order_relaxed);
+  }
+
+  this->dataPtr->vertices.Set(_index, _v);
+  this->dataPtr->VerticesChanged();
+  this->dataPtr->GrowBounds(this->dataPtr->vertices[_index]);
+  if (this->dataPtr->vertexHashEnabled)
+  {
+    GridInsert(this->dataPtr->vertexGrid, this->dataPtr->vertices[_index],
+        _index);
+  }
 }
 
 //////////////////////////////////////////////////
 ignition::math::Vector3d SubMesh::Normal(const unsigned int _index) const
 {
-  if (_index >= this->dataPtr->normals.size())
+  if (_index >= this->dataPtr->normals.Size())
   {
     ignerr << "Index too large" << std::endl;
     return math::Vector3d::Zero;
@@ -205,7 +897,7 @@ ignition::math::Vector3d SubMesh::Normal(const unsigned int _index) const
 //////////////////////////////////////////////////
 bool SubMesh::HasNormal(const unsigned int _index) const
 {
-  return _index < this->dataPtr->normals.size();
+  return _index < this->dataPtr->normals.Size();
 }
 
 //////////////////////////////////////////////////
@@ -233,7 +925,7 @@ bool SubMesh::HasTexCoordBySet(unsigned int _index,
   auto it = this->dataPtr->texCoords.find(_setIndex);
   if (it == this->dataPtr->texCoords.end())
     return false;
-  return _index < it->second.size();
+  return _index < it->second.Size();
 }
 
 //////////////////////////////////////////////////
@@ -246,13 +938,13 @@ bool SubMesh::HasNodeAssignment(const unsigned int _index) const
 void SubMesh::SetNormal(const unsigned int _index,
     const ignition::math::Vector3d &_n)
 {
-  if (_index >= this->dataPtr->normals.size())
+  if (_index >= this->dataPtr->normals.Size())
   {
     ignerr << "Index too large" << std::endl;
     return;
   }
 
-  this->dataPtr->normals[_index] = _n;
+  this->dataPtr->normals.Set(_index, _n);
 }
 
 //////////////////////////////////////////////////
@@ -287,7 +979,7 @@ ignition::math::Vector2d SubMesh::TexCoordBySet(unsigned int _index,
     return math::Vector2d::Zero;
   }
 
-  if (_index >= it->second.size())
+  if (_index >= it->second.Size())
   {
     ignerr << "Index too large" << std::endl;
     return math::Vector2d::Zero;
@@ -326,13 +1018,13 @@ void SubMesh::SetTexCoordBySet(unsigned int _index,
     return;
   }
 
-  if (_index >= it->second.size())
+  if (_index >= it->second.Size())
   {
     ignerr << "Index too large" << std::endl;
     return;
   }
 
-  it->second[_index] = _t;
+  it->second.Set(_index, _t);
 }
 
 //////////////////////////////////////////////////
@@ -357,6 +1049,7 @@ void SubMesh::SetIndex(const unsigned int _index, const unsigned int _i)
   }
 
   this->dataPtr->indices[_index] = _i;
+  this->dataPtr->IndicesChanged();
 }
 
 //////////////////////////////////////////////////
@@ -375,57 +1068,33 @@ NodeAssignment SubMesh::NodeAssignmentByIndex(
 //////////////////////////////////////////////////
 ignition::math::Vector3d SubMesh::Max() const
 {
-  if (this->dataPtr->vertices.empty())
+  if (this->dataPtr->vertices.Empty())
     return ignition::math::Vector3d::Zero;
 
-  ignition::math::Vector3d max;
-
-  max.X(-ignition::math::MAX_F);
-  max.Y(-ignition::math::MAX_F);
-  max.Z(-ignition::math::MAX_F);
-
-  for (const auto &v : this->dataPtr->vertices)
-  {
-    max.X(std::max(max.X(), v.X()));
-    max.Y(std::max(max.Y(), v.Y()));
-    max.Z(std::max(max.Z(), v.Z()));
-  }
-
-  return max;
+  this->dataPtr->UpdateBounds();
+  return this->dataPtr->cache.max;
 }
 
 //////////////////////////////////////////////////
 ignition::math::Vector3d SubMesh::Min() const
 {
-  if (this->dataPtr->vertices.empty())
+  if (this->dataPtr->vertices.Empty())
     return ignition::math::Vector3d::Zero;
 
-  ignition::math::Vector3d min;
-
-  min.X(ignition::math::MAX_F);
-  min.Y(ignition::math::MAX_F);
-  min.Z(ignition::math::MAX_F);
-
-  for (const auto &v : this->dataPtr->vertices)
-  {
-    min.X(std::min(min.X(), v.X()));
-    min.Y(std::min(min.Y(), v.Y()));
-    min.Z(std::min(min.Z(), v.Z()));
-  }
-
-  return min;
+  this->dataPtr->UpdateBounds();
+  return this->dataPtr->cache.min;
 }
 
 //////////////////////////////////////////////////
 unsigned int SubMesh::VertexCount() const
 {
-  return this->dataPtr->vertices.size();
+  return this->dataPtr->vertices.Size();
 }
 
 //////////////////////////////////////////////////
 unsigned int SubMesh::NormalCount() const
 {
-  return this->dataPtr->normals.size();
+  return this->dataPtr->normals.Size();
 }
 
 //////////////////////////////////////////////////
@@ -458,7 +1127,7 @@ unsigned int SubMesh::TexCoordCountBySet(unsigned int _setIndex) const
   if (it == this->dataPtr->texCoords.end())
     return 0u;
 
-  return it->second.size();
+  return it->second.Size();
 }
 
 //////////////////////////////////////////////////
@@ -467,6 +1136,16 @@ unsigned int SubMesh::TexCoordSetCount() const
   return this->dataPtr->texCoords.size();
 }
 
+//////////////////////////////////////////////////
+std::vector<unsigned int> SubMesh::TexCoordSetIndices() const
+{
+  std::vector<unsigned int> result;
+  result.reserve(this->dataPtr->texCoords.size());
+  for (const auto &set : this->dataPtr->texCoords)
+    result.push_back(set.first);
+  return result;
+}
+
 //////////////////////////////////////////////////
 unsigned int SubMesh::NodeAssignmentsCount() const
 {
@@ -500,29 +1179,189 @@ unsigned int SubMesh::MaterialIndex() const
 //////////////////////////////////////////////////
 bool SubMesh::HasVertex(const ignition::math::Vector3d &_v) const
 {
-  for (const auto &v : this->dataPtr->vertices)
-    if (_v.Equal(v))
-      return true;
-
-  return false;
+  return this->IndexOfVertex(_v) >= 0;
 }
 
 //////////////////////////////////////////////////
 int SubMesh::IndexOfVertex(const ignition::math::Vector3d &_v) const
 {
-  for (auto iter = this->dataPtr->vertices.begin();
-      iter != this->dataPtr->vertices.end(); ++iter)
+  if (this->dataPtr->vertexHashEnabled)
+  {
+    // Vertices are bucketed by cell, so look for the lowest matching index
+    // among all the candidate cells
+    std::size_t first = this->dataPtr->vertices.Size();
+    ForEachVertexNear(this->dataPtr->vertexGrid, _v,
+        [&](const std::size_t _k)
+        {
+          if (_k < first && _v.Equal(this->dataPtr->vertices[_k]))
+            first = _k;
+        });
+    return first < this->dataPtr->vertices.Size() ?
+        static_cast<int>(first) : -1;
+  }
+
+  for (std::size_t i = 0; i < this->dataPtr->vertices.Size(); ++i)
   {
-    if (_v.Equal(*iter))
-      return iter - this->dataPtr->vertices.begin();
+    if (_v.Equal(this->dataPtr->vertices[i]))
+      return static_cast<int>(i);
   }
   return -1;
 }
 
+//////////////////////////////////////////////////
+void SubMesh::SetVertexHashEnabled(const bool _enabled)
+{
+  this->dataPtr->vertexHashEnabled = _enabled;
+  if (_enabled)
+    this->dataPtr->vertexGrid = BuildGrid(this->dataPtr->vertices);
+  else
+    VertexGrid().swap(this->dataPtr->vertexGrid);
+}
+
+//////////////////////////////////////////////////
+bool SubMesh::VertexHashEnabled() const
+{
+  return this->dataPtr->vertexHashEnabled;
+}
+
+//////////////////////////////////////////////////
+void SubMesh::SetVertexStorage(const VertexStorage _storage)
+{
+  const bool packed = _storage == VertexStorage::FLOAT32;
+  this->dataPtr->storage = _storage;
+  this->dataPtr->vertices.SetPacked(packed);
+  this->dataPtr->normals.SetPacked(packed);
+  for (auto &set : this->dataPtr->texCoords)
+    set.second.SetPacked(packed);
+
+  // Positions may have been rounded
+  this->dataPtr->VerticesChanged();
+  this->dataPtr->cache.boundsValid.store(false, std::memory_order_relaxed);
+  if (this->dataPtr->vertexHashEnabled)
+    this->dataPtr->vertexGrid = BuildGrid(this->dataPtr->vertices);
+}
+
+//////////////////////////////////////////////////
+SubMesh::VertexStorage SubMesh::VertexStorageType() const
+{
+  return this->dataPtr->storage;
+}
+
+//////////////////////////////////////////////////
+const float *SubMesh::VertexData() const
+{
+  return this->dataPtr->vertices.Data();
+}
+
+//////////////////////////////////////////////////
+const float *SubMesh::NormalData() const
+{
+  return this->dataPtr->normals.Data();
+}
+
+//////////////////////////////////////////////////
+const float *SubMesh::TexCoordDataBySet(const unsigned int _setIndex) const
+{
+  auto it = this->dataPtr->texCoords.find(_setIndex);
+  if (it == this->dataPtr->texCoords.end())
+    return nullptr;
+  return it->second.Data();
+}
+
+//////////////////////////////////////////////////
+const unsigned int *SubMesh::IndexData() const
+{
+  return this->dataPtr->indices.data();
+}
+
+//////////////////////////////////////////////////
+void SubMesh::SetVertexData(const float *_values, const unsigned int _count)
+{
+  this->dataPtr->SetVertices(_values, _count);
+}
+
+//////////////////////////////////////////////////
+void SubMesh::SetVertexData(const double *_values, const unsigned int _count)
+{
+  this->dataPtr->SetVertices(_values, _count);
+}
+
+//////////////////////////////////////////////////
+void SubMesh::SetNormalData(const float *_values, const unsigned int _count)
+{
+  this->dataPtr->normals.AssignValues(_values, _count * 3u);
+}
+
+//////////////////////////////////////////////////
+void SubMesh::SetNormalData(const double *_values, const unsigned int _count)
+{
+  this->dataPtr->normals.AssignValues(_values, _count * 3u);
+}
+
+//////////////////////////////////////////////////
+void SubMesh::SetTexCoordDataBySet(const float *_values,
+    const unsigned int _count, const unsigned int _setIndex)
+{
+  this->dataPtr->TexCoordSet(_setIndex).AssignValues(_values, _count * 2u);
+}
+
+//////////////////////////////////////////////////
+void SubMesh::SetTexCoordDataBySet(const double *_values,
+    const unsigned int _count, const unsigned int _setIndex)
+{
+  this->dataPtr->TexCoordSet(_setIndex).AssignValues(_values, _count * 2u);
+}
+
+//////////////////////////////////////////////////
+void SubMesh::SetIndexData(const unsigned int *_indices,
+    const unsigned int _count)
+{
+  this->dataPtr->indices.assign(_indices, _indices + _count);
+  this->dataPtr->IndicesChanged();
+}
+
+//////////////////////////////////////////////////
+uint64_t SubMesh::VertexRevision() const
+{
+  return this->dataPtr->vertexRevision;
+}
+
+//////////////////////////////////////////////////
+uint64_t SubMesh::IndexRevision() const
+{
+  return this->dataPtr->indexRevision;
+}
+
+//////////////////////////////////////////////////
+void SubMesh::FillVertexBuffer(float *_out) const
+{
+  CopyPositions(this->dataPtr->vertices, _out);
+}
+
+//////////////////////////////////////////////////
+void SubMesh::FillVertexBuffer(double *_out) const
+{
+  CopyPositions(this->dataPtr->vertices, _out);
+}
+
+//////////////////////////////////////////////////
+bool SubMesh::FillIndexBuffer(uint32_t *_out,
+    const unsigned int _offset) const
+{
+  return CopyIndices(this->dataPtr->indices, _offset, _out);
+}
+
+//////////////////////////////////////////////////
+bool SubMesh::FillIndexBuffer(uint16_t *_out,
+    const unsigned int _offset) const
+{
+  return CopyIndices(this->dataPtr->indices, _offset, _out);
+}
+
 //////////////////////////////////////////////////
 void SubMesh::FillArrays(double **_vertArr, int **_indArr) const
 {
-  if (this->dataPtr->vertices.empty() || this->dataPtr->indices.empty())
+  if (this->dataPtr->vertices.Empty() || this->dataPtr->indices.empty())
   {
     ignerr << "No vertices or indices\n";
     return;
@@ -534,63 +1373,155 @@ void SubMesh::FillArrays(double **_vertArr, int **_indArr) const
   if (*_indArr)
     delete [] *_indArr;
 
-  *_vertArr = new double[this->dataPtr->vertices.size() * 3];
+  *_vertArr = new double[this->dataPtr->vertices.Size() * 3];
   *_indArr = new int[this->dataPtr->indices.size()];
 
-  unsigned int vi = 0;
-  for (auto &v : this->dataPtr->vertices)
-  {
-    (*_vertArr)[vi++] = static_cast<float>(v.X());
-    (*_vertArr)[vi++] = static_cast<float>(v.Y());
-    (*_vertArr)[vi++] = static_cast<float>(v.Z());
-  }
-
-  unsigned int ii = 0;
-  for (auto &i : this->dataPtr->indices)
-  {
-    (*_indArr)[ii++] = i;
-  }
+  this->FillVertexBuffer(*_vertArr);
+  std::copy(this->dataPtr->indices.begin(), this->dataPtr->indices.end(),
+      *_indArr);
 }
 
 //////////////////////////////////////////////////
 void SubMesh::RecalculateNormals()
 {
-  if (this->dataPtr->normals.size() < 3u)
-    return;
+  this->RecalculateNormals(NormalWeighting::UNIFORM, true);
+}
 
-  // Reset all the normals
-  for (auto &n : this->dataPtr->normals)
-    n.Set(0, 0, 0);
+//////////////////////////////////////////////////
+void SubMesh::RecalculateNormals(const NormalWeighting _weighting,
+    const bool _weld)
+{
+  auto &vertices = this->dataPtr->vertices;
+  auto &normals = this->dataPtr->normals;
+  const auto &indices = this->dataPtr->indices;
 
-  if (this->dataPtr->normals.size() != this->dataPtr->vertices.size())
-    this->dataPtr->normals.resize(this->dataPtr->vertices.size());
+  if (normals.Size() < 3u)
+    return;
 
-  // For each face, which is defined by three indices, calculate the normals
-  for (unsigned int i = 0; i < this->dataPtr->indices.size(); i+= 3)
+  // Reset all the normals
+  normals.Assign(vertices.Size(), ignition::math::Vector3d::Zero);
+
+  // Weighted face normal contributed by every corner of every face, which is
+  // defined by three indices. Faces with an invalid index contribute nothing.
+  const std::size_t faceCount = indices.size() / 3;
+  std::vector<ignition::math::Vector3d> cornerNormals(faceCount * 3);
+  ParallelFor(0, faceCount, 1024,
+      [&](const std::size_t _first, const std::size_t _last)
+      {
+        for (std::size_t f = _first; f < _last; ++f)
+        {
+          const unsigned int *face = &indices[f * 3];
+          if (face[0] >= vertices.Size() || face[1] >= vertices.Size() ||
+              face[2] >= vertices.Size())
+          {
+            continue;
+          }
+
+          const ignition::math::Vector3d v1 = vertices[face[0]];
+          const ignition::math::Vector3d v2 = vertices[face[1]];
+          const ignition::math::Vector3d v3 = vertices[face[2]];
+          ignition::math::Vector3d *out = &cornerNormals[f * 3];
+
+          switch (_weighting)
+          {
+            case NormalWeighting::AREA:
+            {
+              // The cross product is twice the area of the face
+              out[0] = out[1] = out[2] = (v2 - v1).Cross(v3 - v1);
+              break;
+            }
+            case NormalWeighting::ANGLE:
+            {
+              const ignition::math::Vector3d n =
+                  ignition::math::Vector3d::Normal(v1, v2, v3);
+              out[0] = n * CornerAngle(v1, v2, v3);
+              out[1] = n * CornerAngle(v2, v3, v1);
+              out[2] = n * CornerAngle(v3, v1, v2);
+              break;
+            }
+            case NormalWeighting::UNIFORM:
+            default:
+            {
+              out[0] = out[1] = out[2] =
+                  ignition::math::Vector3d::Normal(v1, v2, v3);
+              break;
+            }
+          }
+        }
+      });
+
+  // Corners that reference each vertex, in face order
+  std::vector<std::size_t> cornerStart(vertices.Size() + 1, 0);
+  for (std::size_t c = 0; c < faceCount * 3; ++c)
   {
-    ignition::math::Vector3d v1 =
-        this->dataPtr->vertices[this->dataPtr->indices[i]];
-    ignition::math::Vector3d v2 =
-        this->dataPtr->vertices[this->dataPtr->indices[i+1]];
-    ignition::math::Vector3d v3 =
-        this->dataPtr->vertices[this->dataPtr->indices[i+2]];
-    ignition::math::Vector3d n = ignition::math::Vector3d::Normal(v1, v2, v3);
+    if (indices[c] < vertices.Size())
+      ++cornerStart[indices[c] + 1];
+  }
+  for (std::size_t v = 0; v < vertices.Size(); ++v)
+    cornerStart[v + 1] += cornerStart[v];
 
-    for (unsigned int j = 0; j < this->dataPtr->vertices.size(); ++j)
+  std::vector<std::size_t> corners(cornerStart.back());
+  {
+    std::vector<std::size_t> next(cornerStart.begin(), cornerStart.end() - 1);
+    for (std::size_t c = 0; c < faceCount * 3; ++c)
     {
-      ignition::math::Vector3d v = this->dataPtr->vertices[j];
-      if (v == v1 || v == v2 || v == v3)
-      {
-        this->dataPtr->normals[j] += n;
-      }
+      if (indices[c] < vertices.Size())
+        corners[next[indices[c]]++] = c;
     }
   }
 
-  // Normalize the results
-  for (auto &n : this->dataPtr->normals)
-  {
-    n.Normalize();
-  }
+  // Vertices bucketed by position, used to find the vertices that share a
+  // position with another one
+  VertexGrid localGrid;
+  if (_weld && !this->dataPtr->vertexHashEnabled)
+    localGrid = BuildGrid(vertices);
+  const VertexGrid &grid = this->dataPtr->vertexHashEnabled ?
+      this->dataPtr->vertexGrid : localGrid;
+
+  // Every vertex sums the contributions of its faces in face order, counting
+  // each face once, so the result does not depend on how vertices are
+  // distributed among threads. With welding and uniform weights this is the
+  // same sum that comparing every vertex with every face would produce.
+  ParallelFor(0, vertices.Size(), 256,
+      [&](const std::size_t _first, const std::size_t _last)
+      {
+        std::vector<std::size_t> incident;
+        for (std::size_t j = _first; j < _last; ++j)
+        {
+          incident.clear();
+          if (_weld)
+          {
+            const ignition::math::Vector3d v = vertices[j];
+            ForEachVertexNear(grid, v, [&](const std::size_t _k)
+                {
+                  if (vertices[_k] == v)
+                  {
+                    incident.insert(incident.end(),
+                        corners.begin() + cornerStart[_k],
+                        corners.begin() + cornerStart[_k + 1]);
+                  }
+                });
+            std::sort(incident.begin(), incident.end());
+          }
+          else
+          {
+            incident.assign(corners.begin() + cornerStart[j],
+                corners.begin() + cornerStart[j + 1]);
+          }
+
+          ignition::math::Vector3d n;
+          std::size_t lastFace = std::numeric_limits<std::size_t>::max();
+          for (const std::size_t c : incident)
+          {
+            if (c / 3 == lastFace)
+              continue;
+            lastFace = c / 3;
+            n += cornerNormals[c];
+          }
+          n.Normalize();
+          normals.Set(j, n);
+        }
+      });
 }
 
 //////////////////////////////////////////////////
@@ -607,10 +1538,11 @@ void SubMesh::GenSphericalTexCoord(const ignition::math::Vector3d &_center)
 void SubMesh::GenSphericalTexCoordBySet(const ignition::math::Vector3d &_center,
     unsigned int _setIndex)
 {
-  this->dataPtr->texCoords[_setIndex].clear();
+  this->dataPtr->TexCoordSet(_setIndex).Clear();
 
-  for (const auto &vert : this->dataPtr->vertices)
+  for (std::size_t i = 0; i < this->dataPtr->vertices.Size(); ++i)
   {
+    const ignition::math::Vector3d vert = this->dataPtr->vertices[i];
     // generate projected texture coordinates, projected from center
     //  x, y, z for computing texture coordinate projections
     double x = vert.X() - _center.X();
@@ -629,15 +1561,35 @@ void SubMesh::GenSphericalTexCoordBySet(const ignition::math::Vector3d &_center,
 //////////////////////////////////////////////////
 void SubMesh::Scale(const ignition::math::Vector3d &_factor)
 {
-  for (auto &v : this->dataPtr->vertices)
-    v *= _factor;
+  auto &vertices = this->dataPtr->vertices;
+  for (std::size_t i = 0; i < vertices.Size(); ++i)
+    vertices.Set(i, vertices[i] * _factor);
+  this->dataPtr->VerticesChanged();
+  this->dataPtr->TransformBounds(
+      [&](const ignition::math::Vector3d &_v)
+      {
+        return _v * _factor;
+      });
+
+  if (this->dataPtr->vertexHashEnabled)
+    this->dataPtr->vertexGrid = BuildGrid(this->dataPtr->vertices);
 }
 
 //////////////////////////////////////////////////
 void SubMesh::Scale(const double &_factor)
 {
-  for (auto &v : this->dataPtr->vertices)
-    v *= _factor;
+  auto &vertices = this->dataPtr->vertices;
+  for (std::size_t i = 0; i < vertices.Size(); ++i)
+    vertices.Set(i, vertices[i] * _factor);
+  this->dataPtr->VerticesChanged();
+  this->dataPtr->TransformBounds(
+      [&](const ignition::math::Vector3d &_v)
+      {
+        return _v * _factor;
+      });
+
+  if (this->dataPtr->vertexHashEnabled)
+    this->dataPtr->vertexGrid = BuildGrid(this->dataPtr->vertices);
 }
 
 //////////////////////////////////////////////////
@@ -654,8 +1606,18 @@ void SubMesh::Center(const ignition::math::Vector3d &_center)
 //////////////////////////////////////////////////
 void SubMesh::Translate(const ignition::math::Vector3d &_vec)
 {
-  for (auto &v : this->dataPtr->vertices)
-    v += _vec;
+  auto &vertices = this->dataPtr->vertices;
+  for (std::size_t i = 0; i < vertices.Size(); ++i)
+    vertices.Set(i, vertices[i] + _vec);
+  this->dataPtr->VerticesChanged();
+  this->dataPtr->TransformBounds(
+      [&](const ignition::math::Vector3d &_v)
+      {
+        return _v + _vec;
+      });
+
+  if (this->dataPtr->vertexHashEnabled)
+    this->dataPtr->vertexGrid = BuildGrid(this->dataPtr->vertices);
 }
 
 //////////////////////////////////////////////////
@@ -673,6 +1635,14 @@ std::string SubMesh::Name() const
 //////////////////////////////////////////////////
 double SubMesh::Volume() const
 {
+  DerivedCache &cache = this->dataPtr->cache;
+  if (cache.volumeValid.load(std::memory_order_acquire))
+    return cache.volume;
+
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  if (cache.volumeValid.load(std::memory_order_relaxed))
+    return cache.volume;
+
   double volume = 0.0;
   if (this->dataPtr->primitiveType == SubMesh::TRIANGLES)
   {
@@ -701,6 +1671,8 @@ double SubMesh::Volume() const
       << " mesh.\n";
   }
 
+  cache.volume = volume;
+  cache.volumeValid.store(true, std::memory_order_release);
   return volume;
 }
 
@@ -17,6 +17,10 @@
 
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
 #include "test_config.h"
 #include "ignition/math/Vector3.hh"
 #include "ignition/common/Mesh.hh"
@@ -358,6 +362,427 @@ void checkIndexes(const common::Mesh *_mesh)
   }
 }
 
+/////////////////////////////////////////////////
+/// \brief Create a unit cube with 4 vertices per side, so that vertices at
+/// the same position have different indices.
+/// \return The cube
+common::SubMeshPtr CreateSplitCube()
+{
+  common::SubMeshPtr cube(new common::SubMesh());
+  const math::Vector3d axes[] = {
+    math::Vector3d::UnitX, math::Vector3d::UnitY, math::Vector3d::UnitZ};
+  for (const auto &axis : axes)
+  {
+    for (const double sign : {1.0, -1.0})
+    {
+      const math::Vector3d n = axis * sign;
+      const math::Vector3d u(n.Z(), n.X(), n.Y());
+      const math::Vector3d v = n.Cross(u);
+      const unsigned int first = cube->VertexCount();
+      cube->AddVertex(n + u + v);
+      cube->AddVertex(n - u + v);
+      cube->AddVertex(n - u - v);
+      cube->AddVertex(n + u - v);
+      for (int i = 0; i < 4; ++i)
+        cube->AddNormal(math::Vector3d::Zero);
+      for (const unsigned int i : {0u, 1u, 2u, 0u, 2u, 3u})
+        cube->AddIndex(first + i);
+    }
+  }
+  return cube;
+}
+
+/////////////////////////////////////////////////
+TEST_F(SubMeshTest, RecalculateNormals)
+{
+  // Without welding every side of the cube keeps its own normal
+  common::SubMeshPtr cube = CreateSplitCube();
+  cube->RecalculateNormals(common::SubMesh::NormalWeighting::UNIFORM, false);
+  const math::Vector3d sides[] = {
+    math::Vector3d::UnitX, -math::Vector3d::UnitX,
+    math::Vector3d::UnitY, -math::Vector3d::UnitY,
+    math::Vector3d::UnitZ, -math::Vector3d::UnitZ};
+  for (unsigned int i = 0; i < cube->VertexCount(); ++i)
+    EXPECT_EQ(sides[i / 4], cube->Normal(i)) << i;
+
+  // With welding and angle weights the three sides around a corner count
+  // the same, whatever their triangulation
+  cube->RecalculateNormals(common::SubMesh::NormalWeighting::ANGLE, true);
+  for (unsigned int i = 0; i < cube->VertexCount(); ++i)
+  {
+    EXPECT_EQ(math::Vector3d(cube->Vertex(i)).Normalize(), cube->Normal(i))
+      << i;
+  }
+
+  // Area weights
+  common::SubMesh corner;
+  corner.AddVertex(0, 0, 0);
+  corner.AddVertex(1, 0, 0);
+  corner.AddVertex(0, 2, 0);
+  corner.AddVertex(0, 2, 0);
+  corner.AddVertex(0, 0, 4);
+  for (int i = 0; i < 5; ++i)
+    corner.AddNormal(math::Vector3d::Zero);
+  for (const unsigned int i : {0u, 1u, 2u, 0u, 3u, 4u})
+    corner.AddIndex(i);
+
+  corner.RecalculateNormals(common::SubMesh::NormalWeighting::AREA, false);
+  EXPECT_EQ(math::Vector3d(4, 0, 1).Normalize(), corner.Normal(0));
+  EXPECT_EQ(math::Vector3d::UnitZ, corner.Normal(2));
+  EXPECT_EQ(math::Vector3d::UnitX, corner.Normal(3));
+
+  corner.RecalculateNormals(common::SubMesh::NormalWeighting::UNIFORM, false);
+  EXPECT_EQ(math::Vector3d(1, 0, 1).Normalize(), corner.Normal(0));
+
+  // Welding merges vertices 2 and 3
+  corner.RecalculateNormals(common::SubMesh::NormalWeighting::AREA, true);
+  EXPECT_EQ(math::Vector3d(4, 0, 1).Normalize(), corner.Normal(2));
+  EXPECT_EQ(corner.Normal(2), corner.Normal(3));
+}
+
+/////////////////////////////////////////////////
+TEST_F(SubMeshTest, RecalculateNormalsMatchesBruteForce)
+{
+  // A bumpy grid with duplicated vertices along a seam, at positions that
+  // differ by less than the tolerance of Vector3d::operator==
+  common::SubMesh grid;
+  const unsigned int size = 20;
+  for (unsigned int y = 0; y < size; ++y)
+  {
+    for (unsigned int x = 0; x < size; ++x)
+    {
+      grid.AddVertex(x * 0.1, y * 0.1,
+          std::sin(x * 0.7) * std::cos(y * 0.3));
+      grid.AddNormal(math::Vector3d::Zero);
+    }
+  }
+  for (unsigned int y = 0; y < size; ++y)
+  {
+    grid.AddVertex(grid.Vertex(y * size + size / 2) +
+        math::Vector3d(5e-4, -5e-4, 0));
+    grid.AddNormal(math::Vector3d::Zero);
+  }
+  for (unsigned int y = 0; y + 1 < size; ++y)
+  {
+    for (unsigned int x = 0; x + 1 < size; ++x)
+    {
+      unsigned int i0 = y * size + x;
+      unsigned int i1 = i0 + 1;
+      unsigned int i2 = i0 + size;
+      unsigned int i3 = i2 + 1;
+      // Faces right of the seam use the duplicated vertices
+      if (x == size / 2)
+      {
+        i0 = size * size + y;
+        i2 = size * size + y + 1;
+      }
+      for (const unsigned int i : {i0, i1, i3, i0, i3, i2})
+        grid.AddIndex(i);
+    }
+  }
+
+  // Reference: compare every vertex with every face
+  std::vector<math::Vector3d> expected(grid.VertexCount());
+  for (unsigned int i = 0; i < grid.IndexCount(); i += 3)
+  {
+    const math::Vector3d v1 = grid.Vertex(grid.Index(i));
+    const math::Vector3d v2 = grid.Vertex(grid.Index(i + 1));
+    const math::Vector3d v3 = grid.Vertex(grid.Index(i + 2));
+    const math::Vector3d n = math::Vector3d::Normal(v1, v2, v3);
+    for (unsigned int j = 0; j < grid.VertexCount(); ++j)
+    {
+      const math::Vector3d v = grid.Vertex(j);
+      if (v == v1 || v == v2 || v == v3)
+        expected[j] += n;
+    }
+  }
+  for (auto &n : expected)
+    n.Normalize();
+
+  grid.RecalculateNormals();
+  for (unsigned int j = 0; j < grid.VertexCount(); ++j)
+  {
+    EXPECT_DOUBLE_EQ(expected[j].X(), grid.Normal(j).X()) << j;
+    EXPECT_DOUBLE_EQ(expected[j].Y(), grid.Normal(j).Y()) << j;
+    EXPECT_DOUBLE_EQ(expected[j].Z(), grid.Normal(j).Z()) << j;
+  }
+
+  // The seam is only smooth with welding
+  grid.RecalculateNormals(common::SubMesh::NormalWeighting::UNIFORM, false);
+  const unsigned int seam = size * size + size / 2;
+  EXPECT_NE(grid.Normal(seam), grid.Normal(size / 2 * size + size / 2));
+}
+
+/////////////////////////////////////////////////
+TEST_F(SubMeshTest, VertexHash)
+{
+  common::SubMesh hashed;
+  EXPECT_FALSE(hashed.VertexHashEnabled());
+  hashed.SetVertexHashEnabled(true);
+  EXPECT_TRUE(hashed.VertexHashEnabled());
+
+  common::SubMesh scanned;
+
+  // Positions on a coarse lattice, some repeated and some within the
+  // comparison tolerance of each other, across cell boundaries
+  auto position = [](const unsigned int _i)
+  {
+    return math::Vector3d((_i % 7) * 0.004, (_i % 5) * -0.004 + 1e-9 * _i,
+        (_i % 3) * 0.5);
+  };
+  for (unsigned int i = 0; i < 300; ++i)
+  {
+    hashed.AddVertex(position(i));
+    scanned.AddVertex(position(i));
+  }
+
+  auto expectSame = [&]()
+  {
+    for (unsigned int i = 0; i < 400; ++i)
+    {
+      for (const double offset : {0.0, 5e-7, 2e-6, -0.0021})
+      {
+        const math::Vector3d v = position(i) + math::Vector3d(offset, 0, 0);
+        EXPECT_EQ(scanned.IndexOfVertex(v), hashed.IndexOfVertex(v)) << v;
+        EXPECT_EQ(scanned.HasVertex(v), hashed.HasVertex(v)) << v;
+      }
+    }
+  };
+  expectSame();
+  EXPECT_EQ(-1, hashed.IndexOfVertex(math::Vector3d(100, 100, 100)));
+  EXPECT_FALSE(hashed.HasVertex(math::Vector3d(100, 100, 100)));
+
+  // Moving the first vertex with a position changes which index is found
+  EXPECT_EQ(0, hashed.IndexOfVertex(position(0)));
+  hashed.SetVertex(0, math::Vector3d(-5, -5, -5));
+  scanned.SetVertex(0, math::Vector3d(-5, -5, -5));
+  EXPECT_EQ(0, hashed.IndexOfVertex(math::Vector3d(-5, -5, -5)));
+  EXPECT_EQ(scanned.IndexOfVertex(position(0)),
+      hashed.IndexOfVertex(position(0)));
+  EXPECT_LT(0, hashed.IndexOfVertex(position(0)));
+  hashed.SetVertex(0, position(0));
+  scanned.SetVertex(0, position(0));
+  expectSame();
+
+  hashed.Translate(math::Vector3d(1, 2, 3));
+  scanned.Translate(math::Vector3d(1, 2, 3));
+  hashed.Scale(2.0);
+  scanned.Scale(2.0);
+  hashed.Scale(math::Vector3d(0.5, 0.5, 0.5));
+  scanned.Scale(math::Vector3d(0.5, 0.5, 0.5));
+  hashed.Translate(math::Vector3d(-1, -2, -3));
+  scanned.Translate(math::Vector3d(-1, -2, -3));
+  expectSame();
+
+  // Copies keep the hash
+  common::SubMesh copy(hashed);
+  EXPECT_TRUE(copy.VertexHashEnabled());
+  EXPECT_EQ(hashed.IndexOfVertex(position(42)),
+      copy.IndexOfVertex(position(42)));
+
+  hashed.SetVertexHashEnabled(false);
+  EXPECT_FALSE(hashed.VertexHashEnabled());
+  expectSame();
+}
+
+/////////////////////////////////////////////////
+TEST_F(SubMeshTest, Float32Storage)
+{
+  common::SubMesh submesh;
+  EXPECT_EQ(common::SubMesh::VertexStorage::DOUBLE,
+      submesh.VertexStorageType());
+
+  submesh.AddVertex(0.1, 0.2, 0.3);
+  submesh.AddVertex(1.0, 0.0, 0.0);
+  submesh.AddNormal(0, 0, 1);
+  submesh.AddNormal(0, 1, 0);
+  submesh.AddTexCoordBySet(0.25, 0.5, 0);
+  submesh.AddTexCoordBySet(0.75, 1.0, 0);
+  for (const unsigned int i : {0u, 1u, 0u})
+    submesh.AddIndex(i);
+
+  EXPECT_EQ(nullptr, submesh.VertexData());
+  EXPECT_EQ(nullptr, submesh.NormalData());
+  EXPECT_EQ(nullptr, submesh.TexCoordDataBySet(0));
+  ASSERT_NE(nullptr, submesh.IndexData());
+  EXPECT_EQ(1u, submesh.IndexData()[1]);
+
+  submesh.SetVertexStorage(common::SubMesh::VertexStorage::FLOAT32);
+  EXPECT_EQ(common::SubMesh::VertexStorage::FLOAT32,
+      submesh.VertexStorageType());
+
+  // Values are rounded to float and available as packed arrays
+  const float *vertices = submesh.VertexData();
+  ASSERT_NE(nullptr, vertices);
+  EXPECT_FLOAT_EQ(0.1f, vertices[0]);
+  EXPECT_FLOAT_EQ(0.2f, vertices[1]);
+  EXPECT_FLOAT_EQ(0.3f, vertices[2]);
+  EXPECT_FLOAT_EQ(1.0f, vertices[3]);
+  EXPECT_DOUBLE_EQ(static_cast<double>(0.1f), submesh.Vertex(0).X());
+  EXPECT_EQ(2u, submesh.VertexCount());
+
+  const float *normals = submesh.NormalData();
+  ASSERT_NE(nullptr, normals);
+  EXPECT_FLOAT_EQ(1.0f, normals[2]);
+  EXPECT_FLOAT_EQ(1.0f, normals[4]);
+  EXPECT_EQ(math::Vector3d::UnitY, submesh.Normal(1));
+
+  const float *texCoords = submesh.TexCoordDataBySet(0);
+  ASSERT_NE(nullptr, texCoords);
+  EXPECT_FLOAT_EQ(0.25f, texCoords[0]);
+  EXPECT_FLOAT_EQ(1.0f, texCoords[3]);
+  EXPECT_EQ(nullptr, submesh.TexCoordDataBySet(1));
+
+  // Editing keeps the packed layout, including for new sets
+  submesh.AddVertex(math::Vector3d(2, 3, 4));
+  submesh.SetVertex(0, math::Vector3d(5, 6, 7));
+  submesh.SetNormal(0, math::Vector3d::UnitX);
+  submesh.AddTexCoordBySet(0.5, 0.5, 1);
+  submesh.SetTexCoordBySet(0, math::Vector2d(0.125, 0.375), 0);
+  EXPECT_EQ(3u, submesh.VertexCount());
+  EXPECT_FLOAT_EQ(5.0f, submesh.VertexData()[0]);
+  EXPECT_FLOAT_EQ(4.0f, submesh.VertexData()[8]);
+  EXPECT_EQ(math::Vector3d(2, 3, 4), submesh.Vertex(2));
+  EXPECT_FLOAT_EQ(1.0f, submesh.NormalData()[0]);
+  EXPECT_FLOAT_EQ(0.375f, submesh.TexCoordDataBySet(0)[1]);
+  ASSERT_NE(nullptr, submesh.TexCoordDataBySet(1));
+  EXPECT_FLOAT_EQ(0.5f, submesh.TexCoordDataBySet(1)[0]);
+  EXPECT_EQ(math::Vector2d(0.5, 0.5), submesh.TexCoordBySet(0, 1));
+
+  // Mesh operations work on packed data
+  submesh.Translate(math::Vector3d(1, 1, 1));
+  EXPECT_EQ(math::Vector3d(6, 7, 8), submesh.Vertex(0));
+  submesh.Scale(2.0);
+  EXPECT_EQ(math::Vector3d(12, 14, 16), submesh.Max());
+  EXPECT_EQ(0, submesh.IndexOfVertex(math::Vector3d(12, 14, 16)));
+  submesh.SetVertexHashEnabled(true);
+  EXPECT_EQ(2, submesh.IndexOfVertex(math::Vector3d(6, 8, 10)));
+
+  common::SubMesh copy(submesh);
+  EXPECT_EQ(common::SubMesh::VertexStorage::FLOAT32,
+      copy.VertexStorageType());
+  EXPECT_NE(submesh.VertexData(), copy.VertexData());
+  EXPECT_FLOAT_EQ(12.0f, copy.VertexData()[0]);
+
+  // Back to doubles, keeping the rounded values
+  submesh.SetVertexStorage(common::SubMesh::VertexStorage::DOUBLE);
+  EXPECT_EQ(nullptr, submesh.VertexData());
+  EXPECT_EQ(nullptr, submesh.TexCoordDataBySet(1));
+  EXPECT_EQ(math::Vector3d(12, 14, 16), submesh.Vertex(0));
+  EXPECT_DOUBLE_EQ(static_cast<double>(0.125f),
+      submesh.TexCoordBySet(0, 0).X());
+}
+
+/////////////////////////////////////////////////
+TEST_F(SubMeshTest, Float32StorageNormals)
+{
+  common::SubMeshPtr cube = CreateSplitCube();
+  common::SubMeshPtr packed = CreateSplitCube();
+  packed->SetVertexStorage(common::SubMesh::VertexStorage::FLOAT32);
+
+  cube->RecalculateNormals(common::SubMesh::NormalWeighting::ANGLE, true);
+  packed->RecalculateNormals(common::SubMesh::NormalWeighting::ANGLE, true);
+  ASSERT_EQ(cube->NormalCount(), packed->NormalCount());
+  for (unsigned int i = 0; i < cube->NormalCount(); ++i)
+  {
+    EXPECT_EQ(cube->Normal(i), packed->Normal(i)) << i;
+    EXPECT_FLOAT_EQ(static_cast<float>(cube->Normal(i).Z()),
+        packed->NormalData()[i * 3 + 2]);
+  }
+}
+
+/////////////////////////////////////////////////
+TEST_F(SubMeshTest, FillBuffers)
+{
+  common::SubMesh submesh;
+  submesh.AddVertex(0.1, 0.2, 0.3);
+  submesh.AddVertex(1.0, 2.0, 3.0);
+  for (const unsigned int i : {0u, 1u, 1u})
+    submesh.AddIndex(i);
+
+  // Double output keeps full precision
+  std::vector<double> doubles(6);
+  submesh.FillVertexBuffer(doubles.data());
+  EXPECT_DOUBLE_EQ(0.1, doubles[0]);
+  EXPECT_DOUBLE_EQ(0.2, doubles[1]);
+  EXPECT_DOUBLE_EQ(3.0, doubles[5]);
+
+  std::vector<uint32_t> indices(3);
+  EXPECT_TRUE(submesh.FillIndexBuffer(indices.data()));
+  EXPECT_EQ((std::vector<uint32_t>{0u, 1u, 1u}), indices);
+  EXPECT_TRUE(submesh.FillIndexBuffer(indices.data(), 10u));
+  EXPECT_EQ((std::vector<uint32_t>{10u, 11u, 11u}), indices);
+
+  // Indices that do not fit are rejected without writing anything
+  std::vector<uint16_t> shortIndices(3, 7u);
+  EXPECT_FALSE(submesh.FillIndexBuffer(shortIndices.data(), 65535u));
+  EXPECT_EQ((std::vector<uint16_t>{7u, 7u, 7u}), shortIndices);
+  EXPECT_TRUE(submesh.FillIndexBuffer(shortIndices.data(), 65534u));
+  EXPECT_EQ((std::vector<uint16_t>{65534u, 65535u, 65535u}), shortIndices);
+
+  // Float output matches the packed storage
+  for (const auto storage : {common::SubMesh::VertexStorage::DOUBLE,
+                             common::SubMesh::VertexStorage::FLOAT32})
+  {
+    submesh.SetVertexStorage(storage);
+    std::vector<float> floats(6);
+    submesh.FillVertexBuffer(floats.data());
+    EXPECT_EQ((std::vector<float>{0.1f, 0.2f, 0.3f, 1.0f, 2.0f, 3.0f}),
+        floats);
+  }
+}
+
+/////////////////////////////////////////////////
+TEST_F(SubMeshTest, SetData)
+{
+  const std::vector<float> positions = {0, 0, 0, 2, 0, 0, 0, 3, -1};
+  const std::vector<double> normals = {0, 0, 1, 0, 0, 1, 0, 0, 1};
+  const std::vector<float> uvs = {0, 0, 1, 0, 0, 1};
+  const std::vector<unsigned int> indices = {0, 1, 2};
+
+  for (const auto storage : {common::SubMesh::VertexStorage::DOUBLE,
+                             common::SubMesh::VertexStorage::FLOAT32})
+  {
+    common::SubMesh submesh;
+    submesh.SetVertexStorage(storage);
+    submesh.SetVertexHashEnabled(true);
+    submesh.AddVertex(5, 5, 5);
+    submesh.AddIndex(0);
+    EXPECT_EQ(math::Vector3d(5, 5, 5), submesh.Max());
+    const uint64_t vertexRevision = submesh.VertexRevision();
+    const uint64_t indexRevision = submesh.IndexRevision();
+
+    // Existing data is replaced, and derived data is updated
+    submesh.SetVertexData(positions.data(), 3u);
+    submesh.SetNormalData(normals.data(), 3u);
+    submesh.SetTexCoordDataBySet(uvs.data(), 3u, 1u);
+    submesh.SetTexCoordDataBySet(static_cast<const double *>(nullptr), 0u,
+        2u);
+    submesh.SetIndexData(indices.data(), 3u);
+    ASSERT_EQ(3u, submesh.VertexCount());
+    EXPECT_EQ(3u, submesh.NormalCount());
+    EXPECT_EQ(3u, submesh.IndexCount());
+    EXPECT_EQ(std::vector<unsigned int>({1u, 2u}),
+        submesh.TexCoordSetIndices());
+    EXPECT_EQ(0u, submesh.TexCoordCountBySet(2u));
+    EXPECT_EQ(math::Vector2d(0, 1), submesh.TexCoordBySet(2u, 1u));
+    EXPECT_EQ(math::Vector3d(2, 0, 0), submesh.Vertex(1));
+    EXPECT_EQ(math::Vector3d::UnitZ, submesh.Normal(2));
+    EXPECT_EQ(math::Vector3d(2, 3, 0), submesh.Max());
+    EXPECT_EQ(math::Vector3d(0, 0, -1), submesh.Min());
+    EXPECT_EQ(1, submesh.IndexOfVertex(math::Vector3d(2, 0, 0)));
+    EXPECT_FALSE(submesh.HasVertex(math::Vector3d(5, 5, 5)));
+    EXPECT_GT(submesh.VertexRevision(), vertexRevision);
+    EXPECT_GT(submesh.IndexRevision(), indexRevision);
+
+    if (storage == common::SubMesh::VertexStorage::FLOAT32)
+    {
+      EXPECT_EQ(positions, std::vector<float>(submesh.VertexData(),
+            submesh.VertexData() + positions.size()));
+    }
+  }
+}
+
 /////////////////////////////////////////////////
 TEST_F(SubMeshTest, Volume)
 {
@@ -502,6 +927,189 @@ TEST_F(SubMeshTest, Volume)
   EXPECT_DOUBLE_EQ(0.0, boxSub.Volume());
 }
 
+/////////////////////////////////////////////////
+TEST_F(SubMeshTest, Revisions)
+{
+  common::SubMesh submesh;
+  uint64_t vertexRevision = submesh.VertexRevision();
+  uint64_t indexRevision = submesh.IndexRevision();
+
+  // Every change of positions is seen
+  auto expectVertexChange = [&]()
+  {
+    EXPECT_NE(vertexRevision, submesh.VertexRevision());
+    EXPECT_EQ(indexRevision, submesh.IndexRevision());
+    vertexRevision = submesh.VertexRevision();
+  };
+  submesh.AddVertex(0, 0, 0);
+  expectVertexChange();
+  submesh.AddVertex(1, 0, 0);
+  submesh.AddVertex(0, 1, 0);
+  vertexRevision = submesh.VertexRevision();
+  submesh.SetVertex(1, math::Vector3d(2, 0, 0));
+  expectVertexChange();
+  submesh.Scale(2.0);
+  expectVertexChange();
+  submesh.Scale(math::Vector3d(1, 2, 3));
+  expectVertexChange();
+  submesh.Translate(math::Vector3d::UnitZ);
+  expectVertexChange();
+  submesh.Center();
+  expectVertexChange();
+  submesh.SetVertexStorage(common::SubMesh::VertexStorage::FLOAT32);
+  expectVertexChange();
+
+  // Other attributes don't change the positions
+  for (int i = 0; i < 3; ++i)
+  {
+    submesh.AddNormal(0, 0, 1);
+    submesh.AddTexCoord(0, 0);
+  }
+  submesh.SetMaterialIndex(1);
+  EXPECT_EQ(vertexRevision, submesh.VertexRevision());
+  EXPECT_EQ(indexRevision, submesh.IndexRevision());
+
+  // Every change of indices is seen
+  auto expectIndexChange = [&]()
+  {
+    EXPECT_NE(indexRevision, submesh.IndexRevision());
+    EXPECT_EQ(vertexRevision, submesh.VertexRevision());
+    indexRevision = submesh.IndexRevision();
+  };
+  submesh.AddIndex(0);
+  expectIndexChange();
+  submesh.AddIndex(1);
+  submesh.AddIndex(2);
+  indexRevision = submesh.IndexRevision();
+  submesh.SetIndex(2, 1);
+  expectIndexChange();
+  submesh.SetPrimitiveType(common::SubMesh::LINES);
+  expectIndexChange();
+
+  // Reordering changes both
+  EXPECT_TRUE(submesh.ReorderVertices({2, 0, 1}));
+  EXPECT_NE(vertexRevision, submesh.VertexRevision());
+  EXPECT_NE(indexRevision, submesh.IndexRevision());
+}
+
+/////////////////////////////////////////////////
+/// \brief Check the bounds and volume of a submesh against the ones of a
+/// new submesh with the same vertices and indices
+/// \param[in] _submesh Submesh to check
+void ExpectDerivedValues(const common::SubMesh &_submesh)
+{
+  common::SubMesh fresh;
+  fresh.SetVertexStorage(_submesh.VertexStorageType());
+  for (unsigned int i = 0; i < _submesh.VertexCount(); ++i)
+    fresh.AddVertex(_submesh.Vertex(i));
+  for (unsigned int i = 0; i < _submesh.IndexCount(); ++i)
+    fresh.AddIndex(_submesh.Index(i));
+
+  // Compare exactly, since both are computed from the same positions
+  const math::Vector3d min = _submesh.Min();
+  const math::Vector3d max = _submesh.Max();
+  EXPECT_DOUBLE_EQ(fresh.Min().X(), min.X());
+  EXPECT_DOUBLE_EQ(fresh.Min().Y(), min.Y());
+  EXPECT_DOUBLE_EQ(fresh.Min().Z(), min.Z());
+  EXPECT_DOUBLE_EQ(fresh.Max().X(), max.X());
+  EXPECT_DOUBLE_EQ(fresh.Max().Y(), max.Y());
+  EXPECT_DOUBLE_EQ(fresh.Max().Z(), max.Z());
+  EXPECT_DOUBLE_EQ(fresh.Volume(), _submesh.Volume());
+}
+
+/////////////////////////////////////////////////
+TEST_F(SubMeshTest, CachedBoundsAndVolume)
+{
+  for (const auto storage : {common::SubMesh::VertexStorage::DOUBLE,
+      common::SubMesh::VertexStorage::FLOAT32})
+  {
+    // Unit cube with a corner at the origin
+    const common::Mesh *unitBox =
+      common::MeshManager::Instance()->MeshByName("unit_box");
+    ASSERT_NE(nullptr, unitBox);
+    common::SubMesh box(*unitBox->SubMeshByIndex(0).lock());
+    box.SetVertexStorage(storage);
+    box.Translate(math::Vector3d(0.5, 0.5, 0.5));
+    EXPECT_EQ(math::Vector3d::Zero, box.Min());
+    EXPECT_EQ(math::Vector3d::One, box.Max());
+    EXPECT_DOUBLE_EQ(1.0, box.Volume());
+    ExpectDerivedValues(box);
+
+    // Repeated queries return the cached values, and changes update them
+    box.Scale(math::Vector3d(2, -3, 0.1));
+    ExpectDerivedValues(box);
+    box.Scale(0.3);
+    ExpectDerivedValues(box);
+    box.Translate(math::Vector3d(1e3, -7, 0.123));
+    ExpectDerivedValues(box);
+    box.Center(math::Vector3d(1, 2, 3));
+    EXPECT_EQ(math::Vector3d(1, 2, 3), (box.Min() + box.Max()) * 0.5);
+    ExpectDerivedValues(box);
+
+    // Moving a vertex inside keeps the bounds, moving one on the bounds
+    // may shrink them, and moving one outside grows them
+    const math::Vector3d center = (box.Min() + box.Max()) * 0.5;
+    const math::Vector3d max = box.Max();
+    box.SetVertex(0, center);
+    ExpectDerivedValues(box);
+    for (unsigned int i = 0; i < box.VertexCount(); ++i)
+      box.SetVertex(i, (box.Vertex(i) - center) * 0.5 + center);
+    EXPECT_NE(max, box.Max());
+    ExpectDerivedValues(box);
+    box.SetVertex(1, max * 4.0);
+    ExpectDerivedValues(box);
+    box.AddVertex(max * -8.0);
+    ExpectDerivedValues(box);
+
+    // Index changes update the volume
+    const double volume = box.Volume();
+    box.SetIndex(0, 1);
+    EXPECT_NE(volume, box.Volume());
+    ExpectDerivedValues(box);
+    box.AddIndex(0);
+    box.AddIndex(1);
+    box.AddIndex(box.VertexCount() - 1);
+    ExpectDerivedValues(box);
+    box.SetPrimitiveType(common::SubMesh::LINES);
+    EXPECT_DOUBLE_EQ(0.0, box.Volume());
+    box.SetPrimitiveType(common::SubMesh::TRIANGLES);
+    ExpectDerivedValues(box);
+
+    // Copies keep their own cache
+    common::SubMesh copy(box);
+    copy.Translate(math::Vector3d(5, 5, 5));
+    ExpectDerivedValues(copy);
+    ExpectDerivedValues(box);
+    copy = box;
+    EXPECT_EQ(box.Max(), copy.Max());
+    EXPECT_DOUBLE_EQ(box.Volume(), copy.Volume());
+
+    // Bounds of the whole mesh
+    common::Mesh mesh;
+    mesh.AddSubMesh(box);
+    mesh.AddSubMesh(copy);
+    mesh.SubMeshByIndex(1).lock()->Translate(math::Vector3d(-100, 0, 0));
+    math::Vector3d aabbCenter, aabbMin, aabbMax;
+    mesh.AABB(aabbCenter, aabbMin, aabbMax);
+    EXPECT_EQ(copy.Min() - math::Vector3d(100, 0, 0), aabbMin);
+    EXPECT_EQ(box.Max(), aabbMax);
+    EXPECT_EQ(mesh.Min(), aabbMin);
+    EXPECT_EQ(mesh.Max(), aabbMax);
+  }
+
+  // Reordering vertices keeps the cached values
+  common::SubMesh triangle;
+  triangle.AddVertex(0, 0, 0);
+  triangle.AddVertex(1, 0, 0);
+  triangle.AddVertex(0, 1, 0);
+  triangle.AddIndex(0);
+  triangle.AddIndex(1);
+  triangle.AddIndex(2);
+  EXPECT_EQ(math::Vector3d(1, 1, 0), triangle.Max());
+  EXPECT_TRUE(triangle.ReorderVertices({2, 1, 0}));
+  ExpectDerivedValues(triangle);
+}
+
 /////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
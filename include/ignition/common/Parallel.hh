@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_COMMON_PARALLEL_HH_
+#define IGNITION_COMMON_PARALLEL_HH_
+
+#include <cstddef>
+
+#include <ignition/common/Export.hh>
+#include <ignition/common/WorkerPool.hh>
+
+namespace ignition
+{
+  namespace common
+  {
+    /// \brief Get the process-wide pool used by the ParallelFor and
+    /// ParallelReduce overloads that do not take a pool. It runs in
+    /// WorkerPoolMode::WORK_STEALING and is created on first use.
+    /// \return The shared pool.
+    IGNITION_COMMON_VISIBLE WorkerPool &ParallelWorkerPool();
+
+    /// \brief Call a function on every sub-range of [_begin, _end) in
+    /// parallel, and return once all of them are done.
+    ///
+    /// The range is split in halves recursively until the pieces hold at
+    /// most _grain indices. One half of every split is offered to the pool
+    /// and the other is processed right away, so the calling thread always
+    /// takes part in the work. Halves that no worker has picked up yet when
+    /// the caller runs out of work are taken back and processed by the
+    /// caller. Nested calls from inside _fn, or from a worker of _pool,
+    /// therefore never wait on work that is stuck in a queue.
+    ///
+    /// If _fn throws, no further sub-ranges are started. The call waits for
+    /// the sub-ranges already running and then rethrows the first exception
+    /// on the calling thread.
+    ///
+    /// \code
+    ///   ParallelFor(0, values.size(), 1024,
+    ///       [&](std::size_t _first, std::size_t _last)
+    ///       {
+    ///         for (std::size_t i = _first; i < _last; ++i)
+    ///           values[i] = Compute(i);
+    ///       });
+    /// \endcode
+    ///
+    /// \param[in] _pool Pool that helps the calling thread.
+    /// \param[in] _begin First index of the range.
+    /// \param[in] _end One past the last index of the range.
+    /// \param[in] _grain Largest number of indices handed to a single call
+    /// of _fn. A value of zero is converted to a value of 1.
+    /// \param[in] _fn Function called as _fn(first, last) for disjoint
+    /// sub-ranges covering [_begin, _end). It may be called concurrently
+    /// from several threads.
+    template <typename Function>
+    void ParallelFor(WorkerPool &_pool, const std::size_t _begin,
+        const std::size_t _end, const std::size_t _grain, Function &&_fn);
+
+    /// \brief Same as the overload above, using ParallelWorkerPool().
+    /// \param[in] _begin First index of the range.
+    /// \param[in] _end One past the last index of the range.
+    /// \param[in] _grain Largest number of indices handed to a single call
+    /// of _fn.
+    /// \param[in] _fn Function called as _fn(first, last).
+    template <typename Function>
+    void ParallelFor(const std::size_t _begin, const std::size_t _end,
+        const std::size_t _grain, Function &&_fn);
+
+    /// \brief Compute a value for every sub-range of [_begin, _end) in
+    /// parallel and combine the partial values.
+    ///
+    /// The range is cut into consecutive blocks of _grain indices, which are
+    /// mapped in parallel with ParallelFor. The partial values are then
+    /// folded from left to right starting with _identity, so the result does
+    /// not depend on the number of threads or on scheduling, even for
+    /// floating point sums. Exceptions thrown by _map are rethrown like
+    /// those of ParallelFor.
+    ///
+    /// \param[in] _pool Pool that helps the calling thread.
+    /// \param[in] _begin First index of the range.
+    /// \param[in] _end One past the last index of the range.
+    /// \param[in] _grain Number of indices per block. A value of zero is
+    /// converted to a value of 1.
+    /// \param[in] _identity Value returned for an empty range, and first
+    /// operand of the fold.
+    /// \param[in] _map Function called as _map(first, last) that returns the
+    /// partial value of a block. It may be called concurrently from several
+    /// threads.
+    /// \param[in] _reduce Function called as _reduce(accumulated, partial)
+    /// that combines two values.
+    /// \return The combined value.
+    template <typename T, typename Map, typename Reduce>
+    T ParallelReduce(WorkerPool &_pool, const std::size_t _begin,
+        const std::size_t _end, const std::size_t _grain, const T &_identity,
+        Map &&_map, Reduce &&_reduce);
+
+    /// \brief Same as the overload above, using ParallelWorkerPool().
+    /// \param[in] _begin First index of the range.
+    /// \param[in] _end One past the last index of the range.
+    /// \param[in] _grain Number of indices per block.
+    /// \param[in] _identity Value returned for an empty range.
+    /// \param[in] _map Function returning the partial value of a block.
+    /// \param[in] _reduce Function combining two values.
+    /// \return The combined value.
+    template <typename T, typename Map, typename Reduce>
+    T ParallelReduce(const std::size_t _begin, const std::size_t _end,
+        const std::size_t _grain, const T &_identity,
+        Map &&_map, Reduce &&_reduce);
+  }
+}
+
+#include "ignition/common/detail/Parallel.hh"
+
+#endif
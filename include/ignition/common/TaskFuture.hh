@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef IGNITION_COMMON_TASKFUTURE_HH_
+#define IGNITION_COMMON_TASKFUTURE_HH_
+
+#include <chrono>
+#include <memory>
+#include <type_traits>
+
+namespace ignition
+{
+  namespace common
+  {
+    // Forward declarations
+    class WorkerPool;
+    template <typename T> class TaskFuture;
+
+    namespace detail
+    {
+      class TaskStateBase;
+      template <typename T> class TaskState;
+
+      /// \brief Result type of a continuation F attached to a task that
+      /// produces a T. The continuation receives the result by const
+      /// reference, or no argument when T is void.
+      template <typename T, typename F, typename = void>
+      struct ContinuationResult
+      {
+        using type = std::invoke_result_t<std::decay_t<F>&, const T&>;
+      };
+
+      template <typename T, typename F>
+      struct ContinuationResult<T, F, std::enable_if_t<std::is_void_v<T>>>
+      {
+        using type = std::invoke_result_t<std::decay_t<F>&>;
+      };
+    }
+
+    /// \brief Type-erased handle to a task that was submitted to a
+    /// WorkerPool. It can only tell whether the task has finished, which is
+    /// all that WorkerPool::SubmitAfter needs to express dependencies between
+    /// tasks of different result types.
+    ///
+    /// Handles are cheap to copy and all copies refer to the same task.
+    class TaskHandle
+    {
+      /// \brief Default constructor. Creates an invalid handle.
+      public: TaskHandle() = default;
+
+      /// \brief Check whether this handle refers to a task.
+      /// \return True if the handle was returned by a WorkerPool.
+      public: bool Valid() const;
+
+      /// \brief Check whether the task has finished, either by returning or
+      /// by throwing an exception.
+      /// \return True if the task has finished.
+      public: bool Ready() const;
+
+      /// \brief Block until the task has finished.
+      /// \note A task whose WorkerPool is destroyed before running it
+      /// finishes with a std::future_error holding
+      /// std::future_errc::broken_promise.
+      public: void Wait() const;
+
+      /// \brief Block until the task has finished or the timeout expires.
+      /// \param[in] _timeout Maximum time to wait.
+      /// \return True if the task has finished.
+      public: bool WaitFor(
+                  const std::chrono::steady_clock::duration &_timeout) const;
+
+      /// \brief Constructor used by WorkerPool and TaskFuture.
+      /// \param[in] _state Shared state of the task.
+      protected: explicit TaskHandle(
+                     std::shared_ptr<detail::TaskStateBase> _state);
+
+      /// \brief Shared state of the task.
+      protected: std::shared_ptr<detail::TaskStateBase> state;
+
+      friend class WorkerPool;
+    };
+
+    /// \brief Future-like handle to the result of a task that was submitted
+    /// with WorkerPool::Submit or WorkerPool::SubmitAfter. Unlike
+    /// std::future it can be copied, read several times and extended with
+    /// continuations, without waiting for the whole pool to drain.
+    ///
+    /// \code
+    ///   WorkerPool pool;
+    ///   auto mesh = pool.Submit([] { return LoadMesh(); });
+    ///   auto image = pool.Submit([] { return DecodeImage(); });
+    ///   auto scaled = mesh.Then([](const MeshData &_m) { return Scale(_m); });
+    ///   auto both = pool.SubmitAfter({scaled, image}, [] { Upload(); });
+    ///   both.Wait();
+    /// \endcode
+    ///
+    /// \tparam T Type of the task result, may be void.
+    template <typename T>
+    class TaskFuture : public TaskHandle
+    {
+      /// \brief Default constructor. Creates an invalid future.
+      public: TaskFuture() = default;
+
+      /// \brief Wait for the task to finish and get its result.
+      /// \return A copy of the task result.
+      /// \note The future must be Valid().
+      /// \throws Any exception thrown by the task, or by the task this one
+      /// is a continuation of.
+      public: T Get() const;
+
+      /// \brief Attach a continuation that runs on the same WorkerPool once
+      /// this task has finished. The continuation receives the result of this
+      /// task as a const reference, or no argument when T is void.
+      /// If this task throws, the continuation is skipped and the exception
+      /// is forwarded to the returned future.
+      /// \param[in] _fn Function to run after this task.
+      /// \return Future for the result of _fn.
+      /// \note The future must be Valid() and the WorkerPool that produced it
+      /// must still exist. The continuation must not outlive that pool:
+      /// when the pool is destroyed before running it, the returned future
+      /// fails with std::future_errc::broken_promise.
+      public: template <typename F>
+              TaskFuture<typename detail::ContinuationResult<T, F>::type>
+              Then(F &&_fn) const;
+
+      /// \brief Constructor used by WorkerPool and continuations.
+      /// \param[in] _state Shared state of the task.
+      private: explicit TaskFuture(
+                   std::shared_ptr<detail::TaskState<T>> _state);
+
+      friend class WorkerPool;
+      template <typename> friend class TaskFuture;
+    };
+  }
+}
+
+#include "ignition/common/detail/TaskFuture.hh"
+
+#endif
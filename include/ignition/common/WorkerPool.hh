@@ -20,8 +20,11 @@
 
 #include <functional>
 #include <memory>
+#include <type_traits>
+#include <vector>
 
 #include <ignition/common/Export.hh>
+#include <ignition/common/TaskFuture.hh>
 #include <ignition/common/Time.hh>
 #include <ignition/common/SuppressWarning.hh>
 
@@ -32,6 +35,22 @@ namespace ignition
     /// \brief forward declaration
     class WorkerPoolPrivate;
 
+    /// \brief Strategy used by a WorkerPool to hand work orders to its
+    /// worker threads.
+    enum class WorkerPoolMode
+    {
+      /// \brief All workers share a single, mutex protected queue. Work is
+      /// started in the order it was added.
+      SHARED_QUEUE,
+
+      /// \brief Each worker owns a lock-free deque and idle workers steal
+      /// from randomly chosen peers. Work added from outside the pool is
+      /// spread over per-worker inboxes, so producers rarely contend. Work
+      /// added from inside a worker goes to that worker's own deque. There
+      /// is no ordering guarantee between work orders.
+      WORK_STEALING
+    };
+
     /// \brief A pool of worker threads that do stuff in parallel
     class IGNITION_COMMON_VISIBLE WorkerPool
     {
@@ -43,7 +62,32 @@ namespace ignition
       /// std::thread::hardware_concurrency.
       public: explicit WorkerPool(const unsigned int _minThreadCount = 1u);
 
-      /// \brief closes worker threads
+      /// \brief Creates worker threads that are scheduled using the given
+      /// strategy. The number of worker threads is determined the same way
+      /// as in WorkerPool(const unsigned int).
+      /// \param[in] _minThreadCount The minimum number of threads to
+      /// create in the pool. A value of zero is converted to a value of 1.
+      /// \param[in] _mode Scheduling strategy used by the pool.
+      public: WorkerPool(const unsigned int _minThreadCount,
+                         const WorkerPoolMode _mode);
+
+      /// \brief Creates worker threads that are scheduled using the given
+      /// strategy.
+      /// \param[in] _threadCount The number of threads to create in the
+      /// pool. A value of zero is converted to a value of 1.
+      /// \param[in] _mode Scheduling strategy used by the pool.
+      /// \param[in] _exactThreadCount When true, exactly _threadCount
+      /// threads are created. When false, _threadCount is a minimum and the
+      /// pool behaves like WorkerPool(const unsigned int, WorkerPoolMode).
+      public: WorkerPool(const unsigned int _threadCount,
+                         const WorkerPoolMode _mode,
+                         const bool _exactThreadCount);
+
+      /// \brief closes worker threads. Work that is already running is
+      /// finished first. Work that has not started yet is released without
+      /// running it or its callback. Futures of released tasks, and of
+      /// their continuations, fail with a std::future_error holding
+      /// std::future_errc::broken_promise instead of blocking forever.
       public: ~WorkerPool();
 
       /// \brief Adds work to the worker pool with optional callback
@@ -54,6 +98,34 @@ namespace ignition
       public: void AddWork(std::function<void()> _work,
                   std::function<void()> _cb = std::function<void()>());
 
+      /// \brief Adds work to the worker pool and returns a handle to its
+      /// result. Unlike WaitForResults, waiting on the handle does not wait
+      /// for unrelated work.
+      /// \param[in] _work Function to run. It must be copyable, like the
+      /// functions accepted by AddWork.
+      /// \return Future for the value returned by _work.
+      /// \sa TaskFuture::Then
+      public: template <typename F>
+              TaskFuture<std::invoke_result_t<std::decay_t<F>&>>
+              Submit(F &&_work);
+
+      /// \brief Adds work to the worker pool that starts once all of the
+      /// given tasks have finished. This is how task graphs are built, e.g.
+      /// to run C when both A and B are done:
+      /// \code
+      ///   auto c = pool.SubmitAfter({a, b}, [] { return C(); });
+      /// \endcode
+      /// \param[in] _dependencies Tasks that must finish first. Invalid
+      /// handles are ignored. A dependency that throws still counts as
+      /// finished, call Get() on it to see the exception.
+      /// \param[in] _work Function to run. It must be copyable, like the
+      /// functions accepted by AddWork.
+      /// \return Future for the value returned by _work.
+      public: template <typename F>
+              TaskFuture<std::invoke_result_t<std::decay_t<F>&>>
+              SubmitAfter(const std::vector<TaskHandle> &_dependencies,
+                          F &&_work);
+
       /// \brief Waits until all work is done and threads are idle
       /// \param[in] _timeout How long to wait, default to forever
       /// \returns true if all work was finished
@@ -78,4 +150,6 @@ namespace ignition
   }
 }
 
+#include "ignition/common/detail/WorkerPool.hh"
+
 #endif
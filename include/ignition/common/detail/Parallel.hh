@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#ifndef IGNITION_COMMON_DETAIL_PARALLEL_HH_
+#define IGNITION_COMMON_DETAIL_PARALLEL_HH_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ignition/common/Parallel.hh"
+
+namespace ignition
+{
+  namespace common
+  {
+    namespace detail
+    {
+      /// \brief Half of a split range that was offered to the pool. Whoever
+      /// claims it first, a worker or the thread that split it, runs it.
+      struct ParallelChunk
+      {
+        /// \brief First index
+        std::size_t begin = 0;
+
+        /// \brief One past the last index
+        std::size_t end = 0;
+
+        /// \brief Set by the thread that runs this chunk
+        std::atomic<bool> claimed{false};
+      };
+
+      /// \brief Bookkeeping shared by every thread taking part in one
+      /// ParallelFor call. It lives on the stack of the calling thread.
+      template <typename Function>
+      class ParallelForContext
+      {
+        /// \brief Constructor
+        /// \param[in] _pool Pool that helps the calling thread
+        /// \param[in] _grain Largest range handed to _fn
+        /// \param[in] _fn Function to call on each range
+        public: ParallelForContext(WorkerPool &_pool, const std::size_t _grain,
+                    Function &_fn)
+          : pool(_pool), grain(_grain), fn(_fn)
+        {
+        }
+
+        /// \brief Process a range, offering halves of it to the pool
+        /// \param[in] _begin First index
+        /// \param[in] _end One past the last index
+        public: void Run(std::size_t _begin, std::size_t _end)
+        {
+          std::vector<std::shared_ptr<ParallelChunk>> offered;
+          while (_end - _begin > this->grain && !this->failed)
+          {
+            const std::size_t mid = _begin + (_end - _begin) / 2;
+
+            auto chunk = std::make_shared<ParallelChunk>();
+            chunk->begin = mid;
+            chunk->end = _end;
+            {
+              std::lock_guard<std::mutex> lock(this->mutex);
+              ++this->outstanding;
+            }
+
+            // A worker that loses the race for the chunk must not touch the
+            // context, which may be gone by then.
+            this->pool.AddWork([this, chunk]()
+                {
+                  if (!chunk->claimed.exchange(true))
+                    this->RunChunk(*chunk);
+                });
+            offered.push_back(chunk);
+            _end = mid;
+          }
+
+          this->Call(_begin, _end);
+
+          // Take back what nobody picked up, most recently split first
+          for (auto it = offered.rbegin(); it != offered.rend(); ++it)
+          {
+            if (!(*it)->claimed.exchange(true))
+              this->RunChunk(**it);
+          }
+        }
+
+        /// \brief Block until every offered chunk has been processed
+        public: void Wait()
+        {
+          std::unique_lock<std::mutex> lock(this->mutex);
+          this->done.wait(lock, [this] { return 0u == this->outstanding; });
+        }
+
+        /// \brief Rethrow the first exception thrown by the function, if
+        /// any. Call after Wait().
+        public: void Rethrow() const
+        {
+          if (this->error)
+            std::rethrow_exception(this->error);
+        }
+
+        /// \brief Call the function on a range, unless a call has thrown
+        /// already, and keep the first exception
+        /// \param[in] _begin First index
+        /// \param[in] _end One past the last index
+        private: void Call(const std::size_t _begin, const std::size_t _end)
+        {
+          if (this->failed)
+            return;
+
+          try
+          {
+            this->fn(_begin, _end);
+          }
+          catch(...)
+          {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!this->error)
+              this->error = std::current_exception();
+            this->failed = true;
+          }
+        }
+
+        /// \brief Process a claimed chunk and account for it
+        /// \param[in] _chunk Chunk to process
+        private: void RunChunk(const ParallelChunk &_chunk)
+        {
+          this->Run(_chunk.begin, _chunk.end);
+
+          // Decrement under the lock so Wait() cannot return, and destroy
+          // the context, while this thread still uses it.
+          std::lock_guard<std::mutex> lock(this->mutex);
+          if (0u == --this->outstanding)
+            this->done.notify_all();
+        }
+
+        /// \brief Pool that helps the calling thread
+        private: WorkerPool &pool;
+
+        /// \brief Largest range handed to fn
+        private: const std::size_t grain;
+
+        /// \brief Function to call on each range
+        private: Function &fn;
+
+        /// \brief Protects outstanding
+        private: std::mutex mutex;
+
+        /// \brief Signaled when outstanding drops to zero
+        private: std::condition_variable done;
+
+        /// \brief Chunks offered to the pool and not processed yet
+        private: std::size_t outstanding = 0;
+
+        /// \brief Set once a call of fn has thrown, after which ranges
+        /// are no longer split nor processed
+        private: std::atomic<bool> failed{false};
+
+        /// \brief First exception thrown by fn, protected by mutex
+        private: std::exception_ptr error;
+      };
+    }
+
+    //////////////////////////////////////////////////
+    template <typename Function>
+    void ParallelFor(WorkerPool &_pool, const std::size_t _begin,
+        const std::size_t _end, const std::size_t _grain, Function &&_fn)
+    {
+      if (_end <= _begin)
+        return;
+
+      const std::size_t grain = std::max<std::size_t>(_grain, 1u);
+      if (_end - _begin <= grain)
+      {
+        _fn(_begin, _end);
+        return;
+      }
+
+      detail::ParallelForContext<std::remove_reference_t<Function>> context(
+          _pool, grain, _fn);
+      context.Run(_begin, _end);
+      context.Wait();
+      context.Rethrow();
+    }
+
+    //////////////////////////////////////////////////
+    template <typename Function>
+    void ParallelFor(const std::size_t _begin, const std::size_t _end,
+        const std::size_t _grain, Function &&_fn)
+    {
+      ParallelFor(ParallelWorkerPool(), _begin, _end, _grain,
+          std::forward<Function>(_fn));
+    }
+
+    //////////////////////////////////////////////////
+    template <typename T, typename Map, typename Reduce>
+    T ParallelReduce(WorkerPool &_pool, const std::size_t _begin,
+        const std::size_t _end, const std::size_t _grain, const T &_identity,
+        Map &&_map, Reduce &&_reduce)
+    {
+      if (_end <= _begin)
+        return _identity;
+
+      const std::size_t grain = std::max<std::size_t>(_grain, 1u);
+      const std::size_t blocks = (_end - _begin + grain - 1) / grain;
+
+      // std::optional avoids requiring T to be default constructible, and
+      // std::vector<bool> packing, which would make writes to different
+      // blocks race.
+      std::vector<std::optional<T>> partials(blocks);
+      ParallelFor(_pool, 0u, blocks, 1u,
+          [&](const std::size_t _first, const std::size_t _last)
+          {
+            for (std::size_t b = _first; b < _last; ++b)
+            {
+              const std::size_t first = _begin + b * grain;
+              partials[b].emplace(
+                  _map(first, std::min(_end, first + grain)));
+            }
+          });
+
+      T result = _identity;
+      for (auto &partial : partials)
+        result = _reduce(result, *partial);
+      return result;
+    }
+
+    //////////////////////////////////////////////////
+    template <typename T, typename Map, typename Reduce>
+    T ParallelReduce(const std::size_t _begin, const std::size_t _end,
+        const std::size_t _grain, const T &_identity,
+        Map &&_map, Reduce &&_reduce)
+    {
+      return ParallelReduce(ParallelWorkerPool(), _begin, _end, _grain,
+          _identity, std::forward<Map>(_map), std::forward<Reduce>(_reduce));
+    }
+  }
+}
+
+#endif
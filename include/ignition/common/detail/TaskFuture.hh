@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#ifndef IGNITION_COMMON_DETAIL_TASKFUTURE_HH_
+#define IGNITION_COMMON_DETAIL_TASKFUTURE_HH_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "ignition/common/TaskFuture.hh"
+
+namespace ignition
+{
+  namespace common
+  {
+    namespace detail
+    {
+      /// \brief State shared by every handle to one task, independent of the
+      /// task result type.
+      class TaskStateBase
+      {
+        /// \brief Constructor
+        /// \param[in] _pool Pool that runs the task and its continuations.
+        public: explicit TaskStateBase(WorkerPool *_pool)
+          : pool(_pool)
+        {
+        }
+
+        /// \brief Destructor
+        public: virtual ~TaskStateBase() = default;
+
+        /// \brief Check whether the task has finished
+        /// \return True if finished
+        public: bool Ready() const
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          return this->ready;
+        }
+
+        /// \brief Block until the task has finished
+        public: void Wait() const
+        {
+          std::unique_lock<std::mutex> lock(this->mutex);
+          this->signalReady.wait(lock, [this] { return this->ready; });
+        }
+
+        /// \brief Block until the task has finished or the timeout expires
+        /// \param[in] _timeout Maximum time to wait
+        /// \return True if finished
+        public: bool WaitFor(
+                    const std::chrono::steady_clock::duration &_timeout) const
+        {
+          std::unique_lock<std::mutex> lock(this->mutex);
+          return this->signalReady.wait_for(lock, _timeout,
+              [this] { return this->ready; });
+        }
+
+        /// \brief Call a function once the task has finished. The function
+        /// is called right away if the task has already finished, otherwise
+        /// it is called by the thread that finishes the task.
+        /// \param[in] _fn Function to call
+        public: void OnReady(std::function<void()> _fn)
+        {
+          {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (!this->ready)
+            {
+              this->continuations.push_back(std::move(_fn));
+              return;
+            }
+          }
+          _fn();
+        }
+
+        /// \brief Exception thrown by the task, if any
+        /// \return The exception, or nullptr. Only meaningful once Ready().
+        public: std::exception_ptr Error() const
+        {
+          return this->error;
+        }
+
+        /// \brief Mark the task as failed
+        /// \param[in] _error Exception thrown by the task
+        public: void SetError(std::exception_ptr _error)
+        {
+          this->error = std::move(_error);
+          this->MarkReady();
+        }
+
+        /// \brief Publish the task result and run continuations. The result
+        /// must be stored before calling this.
+        protected: void MarkReady()
+        {
+          std::vector<std::function<void()>> toRun;
+          {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->ready = true;
+            toRun.swap(this->continuations);
+          }
+          this->signalReady.notify_all();
+
+          for (auto &fn : toRun)
+            fn();
+        }
+
+        /// \brief Pool that runs the task and its continuations
+        public: WorkerPool *const pool;
+
+        /// \brief Protects ready and continuations
+        private: mutable std::mutex mutex;
+
+        /// \brief Signaled when the task finishes
+        private: mutable std::condition_variable signalReady;
+
+        /// \brief True once the task has finished
+        private: bool ready = false;
+
+        /// \brief Exception thrown by the task
+        private: std::exception_ptr error;
+
+        /// \brief Functions to call when the task finishes
+        private: std::vector<std::function<void()>> continuations;
+      };
+
+      /// \brief State of a task that produces a T
+      template <typename T>
+      class TaskState : public TaskStateBase
+      {
+        // Documentation inherited
+        public: using TaskStateBase::TaskStateBase;
+
+        /// \brief Run a function and store its result or exception
+        /// \param[in] _fn Function producing the result
+        public: template <typename F>
+                void Run(F &_fn)
+        {
+          try
+          {
+            this->value.emplace(_fn());
+          }
+          catch (...)
+          {
+            this->SetError(std::current_exception());
+            return;
+          }
+          this->MarkReady();
+        }
+
+        /// \brief Result of the task. Only valid once Ready() and Error()
+        /// is nullptr.
+        /// \return The result
+        public: const T &Value() const
+        {
+          return *this->value;
+        }
+
+        /// \brief Result of the task
+        private: std::optional<T> value;
+      };
+
+      /// \brief State of a task that produces nothing
+      template <>
+      class TaskState<void> : public TaskStateBase
+      {
+        // Documentation inherited
+        public: using TaskStateBase::TaskStateBase;
+
+        /// \brief Run a function and store its exception
+        /// \param[in] _fn Function to run
+        public: template <typename F>
+                void Run(F &_fn)
+        {
+          try
+          {
+            _fn();
+          }
+          catch (...)
+          {
+            this->SetError(std::current_exception());
+            return;
+          }
+          this->MarkReady();
+        }
+
+        /// \brief Does nothing, exists so that void and non-void tasks can
+        /// be read the same way.
+        public: void Value() const
+        {
+        }
+      };
+
+      /// \brief Fails a task with std::future_errc::broken_promise when the
+      /// work that should finish it is destroyed without running, e.g.
+      /// because its WorkerPool was destroyed first. Copies of the work
+      /// share one guard through a shared_ptr, so only the last one counts.
+      class TaskGuard
+      {
+        /// \brief Constructor
+        /// \param[in] _state Task to fail if its work is dropped
+        public: explicit TaskGuard(std::shared_ptr<TaskStateBase> _state)
+          : state(std::move(_state))
+        {
+        }
+
+        /// \brief Destructor. Fails the task unless Release() was called.
+        public: ~TaskGuard()
+        {
+          if (this->state)
+          {
+            this->state->SetError(std::make_exception_ptr(
+                  std::future_error(std::future_errc::broken_promise)));
+          }
+        }
+
+        /// \brief Called when the work starts, which then finishes the task
+        public: void Release()
+        {
+          this->state.reset();
+        }
+
+        /// \brief Task to fail, nullptr once released
+        private: std::shared_ptr<TaskStateBase> state;
+      };
+    }
+
+    //////////////////////////////////////////////////
+    inline TaskHandle::TaskHandle(
+        std::shared_ptr<detail::TaskStateBase> _state)
+      : state(std::move(_state))
+    {
+    }
+
+    //////////////////////////////////////////////////
+    inline bool TaskHandle::Valid() const
+    {
+      return nullptr != this->state;
+    }
+
+    //////////////////////////////////////////////////
+    inline bool TaskHandle::Ready() const
+    {
+      return this->state && this->state->Ready();
+    }
+
+    //////////////////////////////////////////////////
+    inline void TaskHandle::Wait() const
+    {
+      if (this->state)
+        this->state->Wait();
+    }
+
+    //////////////////////////////////////////////////
+    inline bool TaskHandle::WaitFor(
+        const std::chrono::steady_clock::duration &_timeout) const
+    {
+      return this->state && this->state->WaitFor(_timeout);
+    }
+
+    //////////////////////////////////////////////////
+    template <typename T>
+    TaskFuture<T>::TaskFuture(std::shared_ptr<detail::TaskState<T>> _state)
+      : TaskHandle(std::move(_state))
+    {
+    }
+
+    //////////////////////////////////////////////////
+    template <typename T>
+    T TaskFuture<T>::Get() const
+    {
+      this->Wait();
+      const auto &taskState =
+        static_cast<const detail::TaskState<T> &>(*this->state);
+      if (taskState.Error())
+        std::rethrow_exception(taskState.Error());
+      return taskState.Value();
+    }
+  }
+}
+
+#endif
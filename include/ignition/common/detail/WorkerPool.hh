@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+
+#ifndef IGNITION_COMMON_DETAIL_WORKERPOOL_HH_
+#define IGNITION_COMMON_DETAIL_WORKERPOOL_HH_
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "ignition/common/TaskFuture.hh"
+#include "ignition/common/WorkerPool.hh"
+
+namespace ignition
+{
+  namespace common
+  {
+    //////////////////////////////////////////////////
+    template <typename F>
+    TaskFuture<std::invoke_result_t<std::decay_t<F>&>>
+    WorkerPool::Submit(F &&_work)
+    {
+      using ResultT = std::invoke_result_t<std::decay_t<F>&>;
+      auto task = std::make_shared<detail::TaskState<ResultT>>(this);
+      auto guard = std::make_shared<detail::TaskGuard>(task);
+
+      this->AddWork([task, guard, work = std::forward<F>(_work)]() mutable
+          {
+            guard->Release();
+            task->Run(work);
+          });
+
+      return TaskFuture<ResultT>(task);
+    }
+
+    //////////////////////////////////////////////////
+    template <typename F>
+    TaskFuture<std::invoke_result_t<std::decay_t<F>&>>
+    WorkerPool::SubmitAfter(const std::vector<TaskHandle> &_dependencies,
+                            F &&_work)
+    {
+      using ResultT = std::invoke_result_t<std::decay_t<F>&>;
+      auto task = std::make_shared<detail::TaskState<ResultT>>(this);
+      auto guard = std::make_shared<detail::TaskGuard>(task);
+
+      std::function<void()> start =
+        [this, task, guard, work = std::forward<F>(_work)]()
+        {
+          this->AddWork([task, guard, work]() mutable
+              {
+                guard->Release();
+                task->Run(work);
+              });
+        };
+
+      std::vector<std::shared_ptr<detail::TaskStateBase>> pending;
+      for (const auto &dependency : _dependencies)
+      {
+        if (dependency.state)
+          pending.push_back(dependency.state);
+      }
+
+      if (pending.empty())
+      {
+        start();
+        return TaskFuture<ResultT>(task);
+      }
+
+      // The last dependency to finish schedules the work
+      auto remaining = std::make_shared<std::atomic<std::size_t>>(
+          pending.size());
+      for (auto &dependency : pending)
+      {
+        dependency->OnReady([remaining, start]()
+            {
+              if (remaining->fetch_sub(1) == 1)
+                start();
+            });
+      }
+
+      return TaskFuture<ResultT>(task);
+    }
+
+    //////////////////////////////////////////////////
+    template <typename T>
+    template <typename F>
+    TaskFuture<typename detail::ContinuationResult<T, F>::type>
+    TaskFuture<T>::Then(F &&_fn) const
+    {
+      using ResultT = typename detail::ContinuationResult<T, F>::type;
+      auto parent = std::static_pointer_cast<detail::TaskState<T>>(
+          this->state);
+      auto child = std::make_shared<detail::TaskState<ResultT>>(parent->pool);
+      auto guard = std::make_shared<detail::TaskGuard>(child);
+
+      // The parent holds its continuations, so they only hold it weakly. It
+      // is alive whenever it runs them.
+      std::weak_ptr<detail::TaskState<T>> weakParent = parent;
+      parent->OnReady([weakParent, child, guard, fn = std::forward<F>(_fn)]()
+          {
+            auto parent = weakParent.lock();
+            if (!parent)
+              return;
+
+            child->pool->AddWork([parent, child, guard, fn]() mutable
+                {
+                  guard->Release();
+                  if (parent->Error())
+                  {
+                    child->SetError(parent->Error());
+                    return;
+                  }
+
+                  if constexpr (std::is_void_v<T>)
+                  {
+                    child->Run(fn);
+                  }
+                  else
+                  {
+                    auto bound = [&parent, &fn]() -> ResultT
+                      {
+                        return fn(parent->Value());
+                      };
+                    child->Run(bound);
+                  }
+                });
+          });
+
+      return TaskFuture<ResultT>(child);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "ignition/common/Parallel.hh"
+
+using namespace ignition;
+using namespace common;
+
+//////////////////////////////////////////////////
+TEST(Parallel, ForVisitsEveryIndexOnce)
+{
+  for (const WorkerPoolMode mode :
+       {WorkerPoolMode::SHARED_QUEUE, WorkerPoolMode::WORK_STEALING})
+  {
+    WorkerPool pool(4, mode);
+    for (const std::size_t grain : {0u, 1u, 7u, 100u, 5000u})
+    {
+      std::vector<std::atomic<int>> visits(1000);
+      std::atomic<std::size_t> largest(0);
+      ParallelFor(pool, 10, visits.size(), grain,
+          [&](const std::size_t _first, const std::size_t _last)
+          {
+            EXPECT_LT(_first, _last);
+            std::size_t size = _last - _first;
+            std::size_t prev = largest;
+            while (size > prev && !largest.compare_exchange_weak(prev, size))
+            {
+            }
+            for (std::size_t i = _first; i < _last; ++i)
+              ++visits[i];
+          });
+
+      for (std::size_t i = 0; i < visits.size(); ++i)
+        EXPECT_EQ(i < 10 ? 0 : 1, visits[i].load()) << i;
+      EXPECT_LE(largest.load(), std::max<std::size_t>(grain, 1u));
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(Parallel, ForEmptyRange)
+{
+  int calls = 0;
+  ParallelFor(5, 5, 1, [&](std::size_t, std::size_t) { ++calls; });
+  ParallelFor(6, 5, 1, [&](std::size_t, std::size_t) { ++calls; });
+  EXPECT_EQ(0, calls);
+}
+
+//////////////////////////////////////////////////
+TEST(Parallel, ForNested)
+{
+  // Nested calls from inside workers must not deadlock, even when the pool
+  // has fewer threads than there are outer chunks.
+  WorkerPool pool(2, WorkerPoolMode::WORK_STEALING);
+  const std::size_t rows = 64;
+  const std::size_t cols = 256;
+  std::vector<int> cells(rows * cols, 0);
+  ParallelFor(pool, 0, rows, 1,
+      [&](const std::size_t _first, const std::size_t _last)
+      {
+        for (std::size_t r = _first; r < _last; ++r)
+        {
+          ParallelFor(pool, 0, cols, 16,
+              [&](const std::size_t _c0, const std::size_t _c1)
+              {
+                for (std::size_t c = _c0; c < _c1; ++c)
+                  cells[r * cols + c] += 1;
+              });
+        }
+      });
+
+  for (const int cell : cells)
+    EXPECT_EQ(1, cell);
+}
+
+//////////////////////////////////////////////////
+TEST(Parallel, ForFromSubmittedTask)
+{
+  WorkerPool pool(2, WorkerPoolMode::WORK_STEALING);
+  auto sum = pool.Submit([&pool]()
+      {
+        std::atomic<std::size_t> total(0);
+        ParallelFor(pool, 0, 10000, 10,
+            [&](const std::size_t _first, const std::size_t _last)
+            {
+              std::size_t partial = 0;
+              for (std::size_t i = _first; i < _last; ++i)
+                partial += i;
+              total += partial;
+            });
+        return total.load();
+      });
+  EXPECT_EQ(10000u * 9999u / 2u, sum.Get());
+}
+
+//////////////////////////////////////////////////
+TEST(Parallel, Reduce)
+{
+  WorkerPool pool(4, WorkerPoolMode::WORK_STEALING);
+  auto sumRange = [](const std::size_t _first, const std::size_t _last)
+  {
+    std::size_t sum = 0;
+    for (std::size_t i = _first; i < _last; ++i)
+      sum += i;
+    return sum;
+  };
+  auto plus = [](const std::size_t _a, const std::size_t _b)
+  {
+    return _a + _b;
+  };
+
+  EXPECT_EQ(4950u, ParallelReduce(pool, 0, 100, 0, std::size_t(0),
+      sumRange, plus));
+  EXPECT_EQ(4950u, ParallelReduce(pool, 0, 100, 1000, std::size_t(0),
+      sumRange, plus));
+  EXPECT_EQ(42u, ParallelReduce(pool, 3, 3, 8, std::size_t(42),
+      sumRange, plus));
+  EXPECT_EQ(std::size_t(1000000) * 999999u / 2u, ParallelReduce(0, 1000000,
+      1000, std::size_t(0), sumRange, plus));
+}
+
+//////////////////////////////////////////////////
+TEST(Parallel, ReduceIsDeterministic)
+{
+  // Floating point addition is not associative, so the result is only
+  // reproducible if blocks are always combined in the same order.
+  std::vector<double> values(100000);
+  for (std::size_t i = 0; i < values.size(); ++i)
+    values[i] = 1.0 / static_cast<double>(i + 1) * (i % 2 ? -1e8 : 1e-8);
+
+  auto sumRange = [&values](const std::size_t _first, const std::size_t _last)
+  {
+    double sum = 0;
+    for (std::size_t i = _first; i < _last; ++i)
+      sum += values[i];
+    return sum;
+  };
+  auto plus = [](const double _a, const double _b) { return _a + _b; };
+
+  // Sequential fold of the same blocks
+  double expected = 0;
+  for (std::size_t first = 0; first < values.size(); first += 128)
+    expected += sumRange(first, std::min(values.size(), first + 128));
+
+  for (int trial = 0; trial < 20; ++trial)
+  {
+    WorkerPool pool(1 + trial % 5, WorkerPoolMode::WORK_STEALING);
+    EXPECT_EQ(expected, ParallelReduce(pool, 0, values.size(), 128, 0.0,
+        sumRange, plus));
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(Parallel, ReduceNonDefaultConstructible)
+{
+  struct Max
+  {
+    explicit Max(int _v) : v(_v) {}
+    int v;
+  };
+
+  const int result = ParallelReduce(0, 1000, 33, Max(-1),
+      [](const std::size_t, const std::size_t _last)
+      {
+        return Max(static_cast<int>(_last) - 1);
+      },
+      [](const Max &_a, const Max &_b)
+      {
+        return _a.v > _b.v ? _a : _b;
+      }).v;
+  EXPECT_EQ(999, result);
+}
+
+//////////////////////////////////////////////////
+TEST(Parallel, ForRethrows)
+{
+  for (const WorkerPoolMode mode :
+       {WorkerPoolMode::SHARED_QUEUE, WorkerPoolMode::WORK_STEALING})
+  {
+    WorkerPool pool(4, mode);
+
+    // The calling thread always processes the first index, workers most
+    // likely process the last one
+    for (const std::size_t thrower : {0u, 9999u})
+    {
+      std::atomic<int> calls(0);
+      std::atomic<int> running(0);
+      EXPECT_THROW(ParallelFor(pool, 0u, 10000u, 1u,
+          [&](const std::size_t _first, const std::size_t)
+          {
+            ++running;
+            ++calls;
+            std::this_thread::sleep_for(std::chrono::microseconds(10));
+            --running;
+            if (_first == thrower)
+              throw std::runtime_error("range");
+          }), std::runtime_error);
+
+      // Nothing is left running once the exception reaches the caller
+      EXPECT_EQ(0, running.load());
+      const int total = calls;
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      EXPECT_EQ(total, calls.load());
+    }
+
+    // The pool is still usable
+    std::atomic<std::size_t> visited(0);
+    ParallelFor(pool, 0u, 1000u, 10u,
+        [&](const std::size_t _first, const std::size_t _last)
+        {
+          visited += _last - _first;
+        });
+    EXPECT_EQ(1000u, visited.load());
+  }
+
+  EXPECT_THROW(ParallelReduce(0u, 1000u, 10u, 0,
+      [](const std::size_t _first, const std::size_t) -> int
+      {
+        if (_first == 500u)
+          throw std::out_of_range("block");
+        return 1;
+      },
+      [](const int _a, const int _b)
+      {
+        return _a + _b;
+      }), std::out_of_range);
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -16,9 +16,16 @@
 */
 
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <queue>
+#include <random>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "ignition/common/WorkerPool.hh"
 #include "ignition/math/Helpers.hh"
@@ -50,12 +57,195 @@ namespace ignition
       public: std::function<void()> callback = std::function<void()>();
     };
 
+    /// \brief Lock-free work-stealing deque (Chase & Lev, "Dynamic Circular
+    /// Work-Stealing Deque", with the memory orderings of Le et al.,
+    /// "Correct and Efficient Work-Stealing for Weak Memory Models").
+    /// Only the owning worker may call Push and Pop, any thread may call
+    /// Steal.
+    class WorkStealingDeque
+    {
+      /// \brief Circular array of work orders
+      private: class Buffer
+      {
+        /// \brief Constructor
+        /// \param[in] _capacity Number of slots, must be a power of two.
+        public: explicit Buffer(const int64_t _capacity)
+          : capacity(_capacity), mask(_capacity - 1),
+            slots(new std::atomic<WorkOrder *>[_capacity])
+        {
+        }
+
+        /// \brief Get the order stored at a logical index
+        /// \param[in] _i Logical index
+        /// \return Stored order
+        public: WorkOrder *Get(const int64_t _i) const
+        {
+          return this->slots[_i & this->mask].load(std::memory_order_relaxed);
+        }
+
+        /// \brief Store an order at a logical index
+        /// \param[in] _i Logical index
+        /// \param[in] _order Order to store
+        public: void Put(const int64_t _i, WorkOrder *_order)
+        {
+          this->slots[_i & this->mask].store(_order,
+              std::memory_order_relaxed);
+        }
+
+        /// \brief Number of slots
+        public: const int64_t capacity;
+
+        /// \brief capacity - 1, used to wrap indices
+        public: const int64_t mask;
+
+        /// \brief Storage
+        public: std::unique_ptr<std::atomic<WorkOrder *>[]> slots;
+      };
+
+      /// \brief Constructor
+      public: WorkStealingDeque()
+      {
+        this->buffers.emplace_back(new Buffer(kInitialCapacity));
+        this->buffer.store(this->buffers.back().get(),
+            std::memory_order_relaxed);
+      }
+
+      /// \brief Push an order onto the bottom of the deque. Owner only.
+      /// \param[in] _order Order to push
+      public: void Push(WorkOrder *_order)
+      {
+        int64_t b = this->bottom.load(std::memory_order_relaxed);
+        int64_t t = this->top.load(std::memory_order_acquire);
+        Buffer *a = this->buffer.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1)
+        {
+          // Grow. The old buffer is kept alive because thieves may still be
+          // reading from it; it is released with the deque.
+          auto *bigger = new Buffer(a->capacity * 2);
+          for (int64_t i = t; i < b; ++i)
+            bigger->Put(i, a->Get(i));
+          this->buffers.emplace_back(bigger);
+          this->buffer.store(bigger, std::memory_order_release);
+          a = bigger;
+        }
+        a->Put(b, _order);
+        this->bottom.store(b + 1, std::memory_order_release);
+      }
+
+      /// \brief Pop an order from the bottom of the deque. Owner only.
+      /// \return An order, or nullptr if the deque is empty
+      public: WorkOrder *Pop()
+      {
+        int64_t b = this->bottom.load(std::memory_order_relaxed) - 1;
+        Buffer *a = this->buffer.load(std::memory_order_relaxed);
+        this->bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = this->top.load(std::memory_order_relaxed);
+
+        WorkOrder *order = nullptr;
+        if (t <= b)
+        {
+          order = a->Get(b);
+          if (t == b)
+          {
+            // Last element, race against thieves
+            if (!this->top.compare_exchange_strong(t, t + 1,
+                  std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+              order = nullptr;
+            }
+            this->bottom.store(b + 1, std::memory_order_relaxed);
+          }
+        }
+        else
+        {
+          this->bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return order;
+      }
+
+      /// \brief Steal an order from the top of the deque. Any thread.
+      /// \return An order, or nullptr if the deque was empty or the steal
+      /// lost a race.
+      public: WorkOrder *Steal()
+      {
+        int64_t t = this->top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = this->bottom.load(std::memory_order_acquire);
+
+        if (t < b)
+        {
+          Buffer *a = this->buffer.load(std::memory_order_acquire);
+          WorkOrder *order = a->Get(t);
+          if (!this->top.compare_exchange_strong(t, t + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed))
+          {
+            return nullptr;
+          }
+          return order;
+        }
+        return nullptr;
+      }
+
+      /// \brief Initial number of slots
+      private: static constexpr int64_t kInitialCapacity = 256;
+
+      /// \brief Index of the next order to steal
+      private: alignas(64) std::atomic<int64_t> top{0};
+
+      /// \brief Index one past the last pushed order
+      private: alignas(64) std::atomic<int64_t> bottom{0};
+
+      /// \brief Active buffer
+      private: std::atomic<Buffer *> buffer{nullptr};
+
+      /// \brief Every buffer ever allocated by this deque
+      private: std::vector<std::unique_ptr<Buffer>> buffers;
+    };
+
+    /// \brief Mutex protected queue that receives work added from threads
+    /// that are not workers of the pool. Each worker owns one, so producers
+    /// only contend when they land on the same inbox.
+    class WorkInbox
+    {
+      /// \brief lock for orders
+      public: std::mutex mtx;
+
+      /// \brief pending orders
+      public: std::deque<WorkOrder *> orders;
+    };
+
     /// \brief Private implementation
     class WorkerPoolPrivate
     {
       /// \brief Does work until signaled to shut down
       public: void Worker();
 
+      /// \brief Work-stealing variant of Worker()
+      /// \param[in] _index Index of this worker
+      public: void StealingWorker(const unsigned int _index);
+
+      /// \brief Wake up one sleeping worker in work-stealing mode
+      public: void WakeOne();
+
+      /// \brief Queue an order in work-stealing mode
+      /// \param[in] _order Order to queue
+      public: void Submit(WorkOrder *_order);
+
+      /// \brief Find an order to run in work-stealing mode
+      /// \param[in] _index Index of the searching worker
+      /// \param[in] _rng Random generator used to pick victims
+      /// \return An order, or nullptr if none was found
+      public: WorkOrder *FindWork(const unsigned int _index,
+                                  std::minstd_rand &_rng);
+
+      /// \brief Run an order in work-stealing mode and release it
+      /// \param[in] _order Order to run
+      public: void Run(WorkOrder *_order);
+
+      /// \brief Scheduling strategy
+      public: WorkerPoolMode mode = WorkerPoolMode::SHARED_QUEUE;
+
       /// \brief threads that do work
       public: std::vector<std::thread> workers;
 
@@ -76,7 +266,37 @@ namespace ignition
 
       /// \brief used to signal when the pool is being shut down
       public: bool done = false;
+
+      /// \brief Per-worker deques, work-stealing mode only
+      public: std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+
+      /// \brief Per-worker inboxes, work-stealing mode only
+      public: std::vector<std::unique_ptr<WorkInbox>> inboxes;
+
+      /// \brief Round-robin counter used to pick an inbox
+      public: std::atomic<unsigned int> nextInbox{0};
+
+      /// \brief Orders that were added but not finished yet
+      public: std::atomic<uint64_t> pending{0};
+
+      /// \brief Orders that were added but not taken by a worker yet
+      public: std::atomic<int64_t> queued{0};
+
+      /// \brief Number of workers blocked waiting for new work
+      public: std::atomic<int> sleepers{0};
+
+      /// \brief Number of workers looking for work to run
+      public: std::atomic<int> searching{0};
+
+      /// \brief Shutdown flag readable without holding queueMtx
+      public: std::atomic<bool> stopping{false};
     };
+
+    /// \brief Pool the current thread works for, if any
+    static thread_local WorkerPoolPrivate *tlPool = nullptr;
+
+    /// \brief Index of the current thread in tlPool
+    static thread_local unsigned int tlWorkerIndex = 0;
   }
 }
 
@@ -122,18 +342,206 @@ void WorkerPoolPrivate::Worker()
   }
 }
 
+//////////////////////////////////////////////////
+void WorkerPoolPrivate::StealingWorker(const unsigned int _index)
+{
+  tlPool = this;
+  tlWorkerIndex = _index;
+  std::minstd_rand rng(_index + 1);
+
+  this->searching.fetch_add(1, std::memory_order_seq_cst);
+  while (!this->stopping.load(std::memory_order_acquire))
+  {
+    WorkOrder *order = this->FindWork(_index, rng);
+    if (order)
+    {
+      // The last searcher to find work hands the search over to a sleeper
+      // if more work is queued, so work keeps spreading across the pool.
+      if (this->searching.fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+          this->queued.load(std::memory_order_seq_cst) > 0)
+      {
+        this->WakeOne();
+      }
+      this->Run(order);
+      this->searching.fetch_add(1, std::memory_order_seq_cst);
+      continue;
+    }
+
+    // Nothing to do. Stop searching and register as a sleeper before
+    // checking for work one more time. Submit() publishes its order before
+    // checking searching and sleepers, so one of the two always sees the
+    // other.
+    std::unique_lock<std::mutex> queueLock(this->queueMtx);
+    this->searching.fetch_sub(1, std::memory_order_seq_cst);
+    this->sleepers.fetch_add(1, std::memory_order_seq_cst);
+    this->signalNewWork.wait(queueLock, [this]
+        {
+          return this->done ||
+            this->queued.load(std::memory_order_seq_cst) > 0;
+        });
+    this->sleepers.fetch_sub(1, std::memory_order_relaxed);
+    this->searching.fetch_add(1, std::memory_order_seq_cst);
+  }
+
+  tlPool = nullptr;
+}
+
+//////////////////////////////////////////////////
+void WorkerPoolPrivate::WakeOne()
+{
+  // Taking the lock guarantees that a worker that is about to sleep has
+  // either seen the new order or is already waiting on the signal.
+  std::lock_guard<std::mutex> queueLock(this->queueMtx);
+  this->signalNewWork.notify_one();
+}
+
+//////////////////////////////////////////////////
+void WorkerPoolPrivate::Submit(WorkOrder *_order)
+{
+  this->pending.fetch_add(1, std::memory_order_relaxed);
+
+  if (tlPool == this)
+  {
+    // Work spawned by one of our workers stays local, thieves spread it out
+    this->deques[tlWorkerIndex]->Push(_order);
+  }
+  else
+  {
+    const unsigned int i = this->nextInbox.fetch_add(1,
+        std::memory_order_relaxed) % this->inboxes.size();
+    WorkInbox &inbox = *this->inboxes[i];
+    std::lock_guard<std::mutex> inboxLock(inbox.mtx);
+    inbox.orders.push_back(_order);
+  }
+
+  // A worker that is already searching will find the order, only wake a
+  // sleeper when nobody is looking.
+  this->queued.fetch_add(1, std::memory_order_seq_cst);
+  if (this->searching.load(std::memory_order_seq_cst) == 0 &&
+      this->sleepers.load(std::memory_order_seq_cst) > 0)
+  {
+    this->WakeOne();
+  }
+}
+
+//////////////////////////////////////////////////
+WorkOrder *WorkerPoolPrivate::FindWork(const unsigned int _index,
+    std::minstd_rand &_rng)
+{
+  WorkOrder *order = this->deques[_index]->Pop();
+
+  if (!order)
+  {
+    WorkInbox &inbox = *this->inboxes[_index];
+    std::lock_guard<std::mutex> inboxLock(inbox.mtx);
+    if (!inbox.orders.empty())
+    {
+      order = inbox.orders.front();
+      inbox.orders.pop_front();
+    }
+  }
+
+  // Steal from random victims. A couple of passes ride out lost races
+  // without spinning for long, and there is no point scanning when nothing
+  // is queued anywhere.
+  const unsigned int count = static_cast<unsigned int>(this->deques.size());
+  for (unsigned int pass = 0; !order && pass < 2 &&
+       this->queued.load(std::memory_order_relaxed) > 0; ++pass)
+  {
+    const unsigned int start = _rng() % count;
+    for (unsigned int v = 0; !order && v < count; ++v)
+    {
+      const unsigned int victim = (start + v) % count;
+      if (victim == _index)
+        continue;
+
+      order = this->deques[victim]->Steal();
+      if (order)
+        break;
+
+      WorkInbox &inbox = *this->inboxes[victim];
+      std::unique_lock<std::mutex> inboxLock(inbox.mtx, std::try_to_lock);
+      if (inboxLock.owns_lock() && !inbox.orders.empty())
+      {
+        order = inbox.orders.front();
+        inbox.orders.pop_front();
+      }
+    }
+  }
+
+  if (order)
+    this->queued.fetch_sub(1, std::memory_order_relaxed);
+
+  return order;
+}
+
+//////////////////////////////////////////////////
+void WorkerPoolPrivate::Run(WorkOrder *_order)
+{
+  if (_order->work)
+    _order->work();
+
+  if (_order->callback)
+    _order->callback();
+
+  delete _order;
+
+  if (this->pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    std::lock_guard<std::mutex> queueLock(this->queueMtx);
+    this->signalWorkDone.notify_all();
+  }
+}
+
 //////////////////////////////////////////////////
 WorkerPool::WorkerPool(const unsigned int _minThreadCount)
+  : WorkerPool(_minThreadCount, WorkerPoolMode::SHARED_QUEUE)
+{
+}
+
+//////////////////////////////////////////////////
+WorkerPool::WorkerPool(const unsigned int _minThreadCount,
+    const WorkerPoolMode _mode)
+  : WorkerPool(_minThreadCount, _mode, false)
+{
+}
+
+//////////////////////////////////////////////////
+WorkerPool::WorkerPool(const unsigned int _threadCount,
+    const WorkerPoolMode _mode, const bool _exactThreadCount)
   : dataPtr(new WorkerPoolPrivate)
 {
-  unsigned int numWorkers = std::max(std::thread::hardware_concurrency(),
-      std::max(_minThreadCount, 1u));
+  this->dataPtr->mode = _mode;
+
+  unsigned int numWorkers = std::max(_threadCount, 1u);
+  if (!_exactThreadCount)
+  {
+    numWorkers = std::max(std::thread::hardware_concurrency(), numWorkers);
+  }
+
+  if (_mode == WorkerPoolMode::WORK_STEALING)
+  {
+    // All deques must exist before any worker starts looking for victims
+    for (unsigned int w = 0; w < numWorkers; ++w)
+    {
+      this->dataPtr->deques.emplace_back(new WorkStealingDeque);
+      this->dataPtr->inboxes.emplace_back(new WorkInbox);
+    }
+  }
 
   // create worker threads
   for (unsigned int w = 0; w < numWorkers; ++w)
   {
-    this->dataPtr->workers.push_back(
-        std::thread(&WorkerPoolPrivate::Worker, this->dataPtr.get()));
+    if (_mode == WorkerPoolMode::WORK_STEALING)
+    {
+      this->dataPtr->workers.push_back(std::thread(
+            &WorkerPoolPrivate::StealingWorker, this->dataPtr.get(), w));
+    }
+    else
+    {
+      this->dataPtr->workers.push_back(
+          std::thread(&WorkerPoolPrivate::Worker, this->dataPtr.get()));
+    }
   }
 }
 
@@ -144,6 +552,7 @@ WorkerPool::~WorkerPool()
   {
     std::unique_lock<std::mutex> queueLock(this->dataPtr->queueMtx);
     this->dataPtr->done = true;
+    this->dataPtr->stopping = true;
   }
   this->dataPtr->signalNewWork.notify_all();
 
@@ -152,6 +561,39 @@ WorkerPool::~WorkerPool()
     t.join();
   }
 
+  // Release work orders that were never started. Tasks whose work is
+  // released fail with a broken promise, and their continuations may add
+  // more work, so keep going until nothing is left. Orders are released
+  // without holding any lock, since that work is added through AddWork.
+  while (true)
+  {
+    std::queue<WorkOrder> dropped;
+    std::vector<WorkOrder *> droppedOrders;
+    {
+      std::lock_guard<std::mutex> queueLock(this->dataPtr->queueMtx);
+      dropped.swap(this->dataPtr->workOrders);
+    }
+    for (auto &deque : this->dataPtr->deques)
+    {
+      while (WorkOrder *order = deque->Steal())
+        droppedOrders.push_back(order);
+    }
+    for (auto &inbox : this->dataPtr->inboxes)
+    {
+      std::lock_guard<std::mutex> inboxLock(inbox->mtx);
+      droppedOrders.insert(droppedOrders.end(), inbox->orders.begin(),
+          inbox->orders.end());
+      inbox->orders.clear();
+    }
+
+    if (dropped.empty() && droppedOrders.empty())
+      break;
+
+    dropped = std::queue<WorkOrder>();
+    for (WorkOrder *order : droppedOrders)
+      delete order;
+  }
+
   // Signal in case anyone is still waiting for work to finish
   this->dataPtr->signalWorkDone.notify_all();
 }
@@ -159,6 +601,12 @@ WorkerPool::~WorkerPool()
 //////////////////////////////////////////////////
 void WorkerPool::AddWork(std::function<void()> _work, std::function<void()> _cb)
 {
+  if (this->dataPtr->mode == WorkerPoolMode::WORK_STEALING)
+  {
+    this->dataPtr->Submit(new WorkOrder(_work, _cb));
+    return;
+  }
+
   std::unique_lock<std::mutex> queueLock(this->dataPtr->queueMtx);
   this->dataPtr->workOrders.emplace(_work, _cb);
   this->dataPtr->signalNewWork.notify_one();
@@ -180,6 +628,11 @@ bool WorkerPool::WaitForResults(
   // Lambda to keep logic in one place for both cases
   std::function<bool()> haveResults = [this] () -> bool
     {
+      if (this->dataPtr->mode == WorkerPoolMode::WORK_STEALING)
+      {
+        return this->dataPtr->done ||
+          this->dataPtr->pending.load(std::memory_order_acquire) == 0;
+      }
       return this->dataPtr->done ||
         (this->dataPtr->workOrders.empty() && !this->dataPtr->activeOrders);
     };
@@ -189,7 +642,7 @@ bool WorkerPool::WaitForResults(
     if (std::chrono::steady_clock::duration::zero() == _timeout)
     {
       // Wait forever
-      this->dataPtr->signalWorkDone.wait(queueLock);
+      this->dataPtr->signalWorkDone.wait(queueLock, haveResults);
     }
     else
     {
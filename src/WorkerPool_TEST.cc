@@ -18,6 +18,12 @@
 #include <gtest/gtest.h>
 
 #include <atomic>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "ignition/common/Console.hh"
 #include "ignition/common/WorkerPool.hh"
@@ -147,6 +153,342 @@ TEST(WorkerPool,
   EXPECT_EQ(2, sentinel);
 }
 
+//////////////////////////////////////////////////
+TEST(WorkerPool, ExactThreadCount)
+{
+  for (auto mode : {WorkerPoolMode::SHARED_QUEUE,
+                    WorkerPoolMode::WORK_STEALING})
+  {
+    // A single worker never runs two work orders at the same time
+    WorkerPool pool(1u, mode, true);
+    std::atomic<int> running(0);
+    std::atomic<int> maxRunning(0);
+
+    for (int i = 0; i < 100; ++i)
+    {
+      pool.AddWork([&running, &maxRunning] ()
+          {
+            const int now = ++running;
+            int prev = maxRunning;
+            while (now > prev && !maxRunning.compare_exchange_weak(prev, now))
+            {
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            --running;
+          });
+    }
+    EXPECT_TRUE(pool.WaitForResults());
+    EXPECT_EQ(1, maxRunning);
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(WorkerPool, WorkStealingLotsOfWork)
+{
+  WorkerPool pool(4u, WorkerPoolMode::WORK_STEALING);
+  std::atomic<int> workSentinel(0);
+  std::atomic<int> cbSentinel(0);
+
+  for (int i = 0; i < 1000; i++)
+  {
+    pool.AddWork([&workSentinel] ()
+        {
+          workSentinel += 1;
+        },
+      [&cbSentinel] ()
+        {
+          cbSentinel += 2;
+        });
+  }
+  EXPECT_TRUE(pool.WaitForResults());
+  EXPECT_EQ(1000, workSentinel);
+  EXPECT_EQ(2000, cbSentinel);
+
+  // The pool can be reused after draining
+  pool.AddWork([&workSentinel] ()
+      {
+        workSentinel += 1;
+      });
+  EXPECT_TRUE(pool.WaitForResults(std::chrono::seconds(5)));
+  EXPECT_EQ(1001, workSentinel);
+}
+
+//////////////////////////////////////////////////
+TEST(WorkerPool, WorkStealingManyProducers)
+{
+  WorkerPool pool(4u, WorkerPoolMode::WORK_STEALING);
+  std::atomic<int> sentinel(0);
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < 8; ++p)
+  {
+    producers.emplace_back([&pool, &sentinel] ()
+        {
+          for (int i = 0; i < 500; ++i)
+          {
+            pool.AddWork([&sentinel] ()
+                {
+                  ++sentinel;
+                });
+          }
+        });
+  }
+  for (auto &producer : producers)
+    producer.join();
+
+  EXPECT_TRUE(pool.WaitForResults());
+  EXPECT_EQ(4000, sentinel);
+}
+
+//////////////////////////////////////////////////
+TEST(WorkerPool, WorkStealingNestedWork)
+{
+  WorkerPool pool(4u, WorkerPoolMode::WORK_STEALING);
+  std::atomic<int> sentinel(0);
+
+  // Work added from inside a worker lands on that worker's own deque and
+  // must still be seen by WaitForResults.
+  for (int i = 0; i < 16; ++i)
+  {
+    pool.AddWork([&pool, &sentinel] ()
+        {
+          for (int j = 0; j < 100; ++j)
+          {
+            pool.AddWork([&sentinel] ()
+                {
+                  ++sentinel;
+                });
+          }
+        });
+  }
+  EXPECT_TRUE(pool.WaitForResults());
+  EXPECT_EQ(1600, sentinel);
+}
+
+//////////////////////////////////////////////////
+TEST(WorkerPool, DestructWithPendingWork)
+{
+  for (auto mode : {WorkerPoolMode::SHARED_QUEUE,
+                    WorkerPoolMode::WORK_STEALING})
+  {
+    std::atomic<int> started(0);
+    std::atomic<int> finished(0);
+    std::atomic<int> callbacks(0);
+    auto token = std::make_shared<int>(0);
+    std::weak_ptr<int> weakToken = token;
+    {
+      WorkerPool pool(1u, mode, true);
+      for (int i = 0; i < 100; ++i)
+      {
+        pool.AddWork([&started, &finished, token] ()
+            {
+              ++started;
+              std::this_thread::sleep_for(std::chrono::milliseconds(10));
+              ++finished;
+            },
+          [&callbacks] ()
+            {
+              ++callbacks;
+            });
+      }
+      token.reset();
+
+      // Destroy the pool while the first work order is running
+      while (started == 0)
+        std::this_thread::yield();
+    }
+
+    // Work that was running is finished, work that never started is
+    // released without running it or its callback.
+    const int done = finished;
+    EXPECT_LE(1, done);
+    EXPECT_GT(100, done);
+    EXPECT_EQ(done, started);
+    EXPECT_EQ(done, callbacks);
+    EXPECT_TRUE(weakToken.expired());
+
+    // Nothing runs once the pool is gone
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(done, started);
+    EXPECT_EQ(done, finished);
+    EXPECT_EQ(done, callbacks);
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(WorkerPool, DestructWithPendingTasks)
+{
+  auto expectBroken = [] (const TaskHandle &_handle, auto _get)
+  {
+    EXPECT_TRUE(_handle.Ready());
+    try
+    {
+      _get();
+      ADD_FAILURE() << "Expected a broken promise";
+    }
+    catch (const std::future_error &_e)
+    {
+      EXPECT_EQ(std::make_error_code(std::future_errc::broken_promise),
+          _e.code());
+    }
+  };
+
+  for (auto mode : {WorkerPoolMode::SHARED_QUEUE,
+                    WorkerPoolMode::WORK_STEALING})
+  {
+    std::atomic<bool> started(false);
+    std::atomic<bool> ran(false);
+    auto token = std::make_shared<int>(1);
+    std::weak_ptr<int> weakToken = token;
+    TaskFuture<int> running;
+    TaskFuture<int> queued;
+    TaskFuture<int> then;
+    TaskFuture<void> after;
+    {
+      WorkerPool pool(1u, mode, true);
+      running = pool.Submit([&started] ()
+          {
+            started = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            return 1;
+          });
+      queued = pool.Submit([&ran] ()
+          {
+            ran = true;
+            return 2;
+          });
+      then = queued.Then([token] (int _v) { return _v + *token; });
+      after = pool.SubmitAfter({running, queued}, [&ran] () { ran = true; });
+      token.reset();
+
+      // Destroy the pool while the first task is running
+      while (!started)
+        std::this_thread::yield();
+    }
+
+    // Tasks that never started, and the tasks that depend on them, fail
+    // instead of blocking forever
+    EXPECT_EQ(1, running.Get());
+    expectBroken(queued, [&queued] () { queued.Get(); });
+    expectBroken(then, [&then] () { then.Get(); });
+    expectBroken(after, [&after] () { after.Get(); });
+    EXPECT_FALSE(ran);
+
+    // Continuations are released even though the futures are still held
+    EXPECT_TRUE(weakToken.expired());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(WorkerPool, SubmitReturnsResult)
+{
+  for (auto mode : {WorkerPoolMode::SHARED_QUEUE,
+                    WorkerPoolMode::WORK_STEALING})
+  {
+    WorkerPool pool(2u, mode);
+    TaskFuture<int> answer = pool.Submit([] () { return 42; });
+    EXPECT_TRUE(answer.Valid());
+    EXPECT_EQ(42, answer.Get());
+    EXPECT_TRUE(answer.Ready());
+
+    // Results can be read several times
+    EXPECT_EQ(42, answer.Get());
+
+    int sentinel = 0;
+    TaskFuture<void> nothing = pool.Submit([&sentinel] () { sentinel = 5; });
+    nothing.Get();
+    EXPECT_EQ(5, sentinel);
+  }
+
+  TaskFuture<int> invalid;
+  EXPECT_FALSE(invalid.Valid());
+  EXPECT_FALSE(invalid.Ready());
+}
+
+//////////////////////////////////////////////////
+TEST(WorkerPool, SubmitThen)
+{
+  WorkerPool pool(2u, WorkerPoolMode::WORK_STEALING);
+
+  auto length = pool.Submit([] () { return std::string("ignition"); })
+    .Then([] (const std::string &_s) { return _s.size(); })
+    .Then([] (std::size_t _n) { return static_cast<int>(_n) * 2; });
+  EXPECT_EQ(16, length.Get());
+
+  // Continuation attached after the task has already finished
+  auto ready = pool.Submit([] () { return 1; });
+  ready.Wait();
+  EXPECT_EQ(2, ready.Then([] (int _v) { return _v + 1; }).Get());
+
+  // Continuation of a void task
+  std::atomic<int> sentinel(0);
+  auto chained = pool.Submit([&sentinel] () { sentinel = 1; })
+    .Then([&sentinel] () { return sentinel + 1; });
+  EXPECT_EQ(2, chained.Get());
+}
+
+//////////////////////////////////////////////////
+TEST(WorkerPool, SubmitException)
+{
+  WorkerPool pool(2u, WorkerPoolMode::WORK_STEALING);
+
+  bool ran = false;
+  auto failed = pool.Submit([] () -> int
+      {
+        throw std::runtime_error("failed");
+      });
+  auto skipped = failed.Then([&ran] (int _v)
+      {
+        ran = true;
+        return _v;
+      });
+
+  EXPECT_THROW(failed.Get(), std::runtime_error);
+  EXPECT_THROW(skipped.Get(), std::runtime_error);
+  EXPECT_FALSE(ran);
+}
+
+//////////////////////////////////////////////////
+TEST(WorkerPool, SubmitAfter)
+{
+  for (auto mode : {WorkerPoolMode::SHARED_QUEUE,
+                    WorkerPoolMode::WORK_STEALING})
+  {
+    WorkerPool pool(2u, mode);
+
+    std::atomic<int> a(0);
+    std::atomic<int> b(0);
+    auto taskA = pool.Submit([&a] ()
+        {
+          std::this_thread::sleep_for(std::chrono::milliseconds(5));
+          a = 1;
+        });
+    auto taskB = pool.Submit([&b] ()
+        {
+          b = 2;
+          return 2.0;
+        });
+
+    // C must observe the side effects of both A and B
+    auto taskC = pool.SubmitAfter({taskA, taskB}, [&a, &b] ()
+        {
+          return a + b;
+        });
+    EXPECT_EQ(3, taskC.Get());
+
+    // No dependencies means run right away
+    auto taskD = pool.SubmitAfter({}, [] () { return 4; });
+    EXPECT_EQ(4, taskD.Get());
+
+    // Dependents are seen by WaitForResults
+    std::atomic<int> sentinel(0);
+    auto first = pool.Submit([] () {});
+    pool.SubmitAfter({first}, [&sentinel] () { ++sentinel; });
+    EXPECT_TRUE(pool.WaitForResults());
+    EXPECT_EQ(1, sentinel);
+  }
+}
+
 //////////////////////////////////////////////////
 int main(int argc, char **argv)
 {
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifdef BOOL
+#undef BOOL
+#endif
+#include <FreeImage.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "ignition/common/Image.hh"
+
+using namespace ignition;
+
+/// \brief Number of times each measurement is repeated. The fastest run is
+/// reported.
+static const int NumTrials = 3;
+
+/////////////////////////////////////////////////
+/// \brief Time a function, keeping the fastest of NumTrials runs
+/// \param[in] _fn Function to time
+/// \return Duration in milliseconds
+template <typename Function>
+double Time(Function &&_fn)
+{
+  double best = 0;
+  for (int trial = 0; trial < NumTrials; ++trial)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    _fn();
+    const auto finish = std::chrono::steady_clock::now();
+    const double ms =
+        std::chrono::duration<double, std::milli>(finish - start).count();
+    if (trial == 0 || ms < best)
+      best = ms;
+  }
+  return best;
+}
+
+/////////////////////////////////////////////////
+/// \brief Make an RGB test pattern with edges and gradients
+/// \param[in] _size Width and height in pixels
+/// \return Pixels, top row first
+std::vector<unsigned char> Pattern(const unsigned int _size)
+{
+  std::vector<unsigned char> pixels(_size * _size * 3u);
+  for (unsigned int y = 0; y < _size; ++y)
+  {
+    for (unsigned int x = 0; x < _size; ++x)
+    {
+      unsigned char *pixel = &pixels[(y * _size + x) * 3u];
+      pixel[0] = static_cast<unsigned char>(x * 255u / _size);
+      pixel[1] = static_cast<unsigned char>(y * 255u / _size);
+      pixel[2] = ((x / 16u) + (y / 16u)) % 2u ? 255u : 0u;
+    }
+  }
+  return pixels;
+}
+
+/////////////////////////////////////////////////
+/// \brief Time shrinking an image to a quarter of its size with FreeImage
+/// and with Image::Rescale, and computing its mipmaps.
+/// \param[in] _size Width and height of the image
+void Benchmark(const unsigned int _size)
+{
+  const std::vector<unsigned char> pixels = Pattern(_size);
+  common::Image image;
+  image.SetFromData(pixels.data(), _size, _size,
+      common::Image::RGB_INT8);
+  FIBITMAP *bitmap = FreeImage_ConvertFromRawBits(
+      const_cast<BYTE *>(pixels.data()), _size, _size, _size * 3u, 24u,
+      FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, true);
+  ASSERT_NE(nullptr, bitmap);
+
+  const int target = static_cast<int>(_size / 4u);
+  const std::vector<std::pair<const char *, std::pair<FREE_IMAGE_FILTER,
+        common::Image::ResampleFilter>>> filters =
+  {
+    {"box", {FILTER_BOX, common::Image::ResampleFilter::BOX}},
+    {"bilinear", {FILTER_BILINEAR, common::Image::ResampleFilter::BILINEAR}},
+    {"lanczos3", {FILTER_LANCZOS3, common::Image::ResampleFilter::LANCZOS3}}
+  };
+
+  for (const auto &filter : filters)
+  {
+    const double freeImage = Time([&]()
+        {
+          FreeImage_Unload(FreeImage_Rescale(bitmap, target, target,
+                filter.second.first));
+        });
+    const double native = Time([&]()
+        {
+          common::Image copy;
+          copy.SetFromData(pixels.data(), _size, _size,
+              common::Image::RGB_INT8);
+          copy.Rescale(target, target, filter.second.second);
+        });
+    const double copy = Time([&]()
+        {
+          common::Image copy;
+          copy.SetFromData(pixels.data(), _size, _size,
+              common::Image::RGB_INT8);
+        });
+
+    std::cout << std::setw(6) << _size
+              << std::setw(10) << filter.first
+              << std::fixed << std::setprecision(2)
+              << std::setw(16) << freeImage
+              << std::setw(14) << native - copy << "\n";
+  }
+
+  std::vector<unsigned char> data;
+  std::vector<common::ImageView> levels;
+  const double mipmaps = Time([&]()
+      {
+        image.Mipmaps(common::Image::RGB_INT8, data, levels);
+      });
+  std::cout << std::setw(6) << _size << std::setw(10) << "mipmaps"
+            << std::setw(16) << "-"
+            << std::fixed << std::setprecision(2)
+            << std::setw(14) << mipmaps << "\n";
+
+  FreeImage_Unload(bitmap);
+}
+
+/////////////////////////////////////////////////
+TEST(ImageResample, Shrink)
+{
+  std::cout << std::setw(6) << "size"
+            << std::setw(10) << "filter"
+            << std::setw(16) << "FreeImage [ms]"
+            << std::setw(14) << "native [ms]" << "\n";
+  for (unsigned int size = 512; size <= 4096; size *= 2)
+    Benchmark(size);
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "test_config.h"
+#include "ignition/common/Mesh.hh"
+#include "ignition/common/MeshManager.hh"
+#include "ignition/common/SubMesh.hh"
+
+using namespace ignition;
+
+/// \brief Largest faces x vertices product for which the previous quadratic
+/// implementation is timed.
+static const double MaxQuadraticWork = 2e9;
+
+/////////////////////////////////////////////////
+/// \brief Previous implementation of SubMesh::RecalculateNormals, which
+/// compares every vertex with every face.
+/// \param[in,out] _submesh Submesh to update
+void QuadraticRecalculateNormals(common::SubMesh &_submesh)
+{
+  std::vector<math::Vector3d> normals(_submesh.VertexCount());
+  for (unsigned int i = 0; i + 2 < _submesh.IndexCount(); i += 3)
+  {
+    const math::Vector3d v1 = _submesh.Vertex(_submesh.Index(i));
+    const math::Vector3d v2 = _submesh.Vertex(_submesh.Index(i + 1));
+    const math::Vector3d v3 = _submesh.Vertex(_submesh.Index(i + 2));
+    const math::Vector3d n = math::Vector3d::Normal(v1, v2, v3);
+    for (unsigned int j = 0; j < _submesh.VertexCount(); ++j)
+    {
+      const math::Vector3d v = _submesh.Vertex(j);
+      if (v == v1 || v == v2 || v == v3)
+        normals[j] += n;
+    }
+  }
+  for (unsigned int j = 0; j < normals.size(); ++j)
+    _submesh.SetNormal(j, normals[j].Normalize());
+}
+
+/////////////////////////////////////////////////
+/// \brief Merge all the submeshes of a mesh, tiled _copies times along X
+/// so that copies don't share positions.
+/// \param[in] _mesh Mesh to copy
+/// \param[in] _copies Number of copies
+/// \return Merged submesh
+common::SubMesh Tile(const common::Mesh &_mesh, const unsigned int _copies)
+{
+  common::SubMesh result;
+  const double step = (_mesh.Max() - _mesh.Min()).X() * 1.1 + 1.0;
+  for (unsigned int c = 0; c < _copies; ++c)
+  {
+    const math::Vector3d offset(step * c, 0, 0);
+    for (unsigned int s = 0; s < _mesh.SubMeshCount(); ++s)
+    {
+      auto submesh = _mesh.SubMeshByIndex(s).lock();
+      const unsigned int first = result.VertexCount();
+      for (unsigned int v = 0; v < submesh->VertexCount(); ++v)
+      {
+        result.AddVertex(submesh->Vertex(v) + offset);
+        result.AddNormal(math::Vector3d::UnitZ);
+      }
+      for (unsigned int i = 0; i < submesh->IndexCount(); ++i)
+        result.AddIndex(first + submesh->Index(i));
+    }
+  }
+  return result;
+}
+
+/////////////////////////////////////////////////
+/// \brief Time a function
+/// \param[in] _fn Function to time
+/// \return Duration in milliseconds
+template <typename Function>
+double Time(Function &&_fn)
+{
+  const auto start = std::chrono::steady_clock::now();
+  _fn();
+  const auto finish = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(finish - start).count();
+}
+
+/////////////////////////////////////////////////
+/// \brief Time every way of recalculating the normals of a mesh scaled up
+/// by tiling.
+/// \param[in] _file Mesh file in the test data directory
+void Benchmark(const std::string &_file)
+{
+  const common::Mesh *mesh = common::MeshManager::Instance()->Load(
+      common::testing::TestFile("data", _file));
+  ASSERT_NE(nullptr, mesh);
+
+  std::cout << _file << "\n"
+            << std::setw(10) << "faces"
+            << std::setw(10) << "vertices"
+            << std::setw(16) << "previous [ms]"
+            << std::setw(14) << "welded [ms]"
+            << std::setw(14) << "indexed [ms]"
+            << std::setw(12) << "area [ms]"
+            << std::setw(12) << "angle [ms]" << "\n";
+
+  for (unsigned int copies = 1; copies <= 1024; copies *= 4)
+  {
+    common::SubMesh submesh = Tile(*mesh, copies);
+    const double faces = submesh.IndexCount() / 3.0;
+
+    std::string previous = "-";
+    if (faces * submesh.VertexCount() <= MaxQuadraticWork)
+    {
+      common::SubMesh reference = submesh;
+      std::ostringstream stream;
+      stream << std::fixed << std::setprecision(2)
+             << Time([&]() { QuadraticRecalculateNormals(reference); });
+      previous = stream.str();
+
+      submesh.RecalculateNormals();
+      for (unsigned int i = 0; i < submesh.NormalCount(); ++i)
+        EXPECT_EQ(reference.Normal(i), submesh.Normal(i));
+    }
+
+    const double welded = Time([&]() { submesh.RecalculateNormals(); });
+    const double indexed = Time([&]()
+        {
+          submesh.RecalculateNormals(
+              common::SubMesh::NormalWeighting::UNIFORM, false);
+        });
+    const double area = Time([&]()
+        {
+          submesh.RecalculateNormals(
+              common::SubMesh::NormalWeighting::AREA, true);
+        });
+    const double angle = Time([&]()
+        {
+          submesh.RecalculateNormals(
+              common::SubMesh::NormalWeighting::ANGLE, true);
+        });
+
+    std::cout << std::setw(10) << static_cast<unsigned int>(faces)
+              << std::setw(10) << submesh.VertexCount()
+              << std::setw(16) << previous
+              << std::fixed << std::setprecision(2)
+              << std::setw(14) << welded
+              << std::setw(14) << indexed
+              << std::setw(12) << area
+              << std::setw(12) << angle << "\n";
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(MeshNormals, Collada)
+{
+  Benchmark("cordless_drill/meshes/cordless_drill.dae");
+}
+
+/////////////////////////////////////////////////
+TEST(MeshNormals, Obj)
+{
+  Benchmark("blender_pbr.obj");
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
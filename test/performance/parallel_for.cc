@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "ignition/common/Parallel.hh"
+
+using namespace ignition;
+
+/// \brief Number of times each measurement is repeated. The fastest run is
+/// reported.
+static const int NumTrials = 5;
+
+/////////////////////////////////////////////////
+/// \brief Some arithmetic that the compiler can't fold away
+/// \param[in] _i Element index
+/// \return A value derived from _i
+double Work(const std::size_t _i)
+{
+  const double x = static_cast<double>(_i);
+  return std::sqrt(x) * std::sin(x) + std::cos(x * 0.5);
+}
+
+/////////////////////////////////////////////////
+/// \brief Time a function, keeping the fastest of NumTrials runs
+/// \param[in] _fn Function to time
+/// \return Duration in milliseconds
+template <typename Function>
+double Time(Function &&_fn)
+{
+  double best = 0;
+  for (int trial = 0; trial < NumTrials; ++trial)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    _fn();
+    const auto finish = std::chrono::steady_clock::now();
+    const double ms =
+        std::chrono::duration<double, std::milli>(finish - start).count();
+    if (trial == 0 || ms < best)
+      best = ms;
+  }
+  return best;
+}
+
+/////////////////////////////////////////////////
+TEST(Parallel, ForScaling)
+{
+  std::cout << "hardware concurrency: "
+            << std::thread::hardware_concurrency() << "\n"
+            << std::setw(10) << "size"
+            << std::setw(14) << "serial [ms]"
+            << std::setw(16) << "parallel [ms]"
+            << std::setw(10) << "speedup" << "\n";
+
+  for (std::size_t size = 1000; size <= 10000000; size *= 10)
+  {
+    std::vector<double> out(size);
+
+    const double serial = Time([&]()
+        {
+          for (std::size_t i = 0; i < size; ++i)
+            out[i] = Work(i);
+        });
+
+    const double parallel = Time([&]()
+        {
+          common::ParallelFor(0, size, 1024,
+              [&](const std::size_t _first, const std::size_t _last)
+              {
+                for (std::size_t i = _first; i < _last; ++i)
+                  out[i] = Work(i);
+              });
+        });
+
+    std::cout << std::setw(10) << size
+              << std::setw(14) << std::fixed << std::setprecision(3) << serial
+              << std::setw(16) << parallel
+              << std::setw(10) << std::setprecision(2)
+              << serial / parallel << "\n";
+  }
+}
+
+/////////////////////////////////////////////////
+TEST(Parallel, ReduceScaling)
+{
+  std::cout << std::setw(10) << "size"
+            << std::setw(14) << "serial [ms]"
+            << std::setw(16) << "parallel [ms]"
+            << std::setw(10) << "speedup" << "\n";
+
+  for (std::size_t size = 1000; size <= 10000000; size *= 10)
+  {
+    double serialSum = 0;
+    const double serial = Time([&]()
+        {
+          serialSum = 0;
+          for (std::size_t i = 0; i < size; ++i)
+            serialSum += Work(i);
+        });
+
+    double parallelSum = 0;
+    const double parallel = Time([&]()
+        {
+          parallelSum = common::ParallelReduce(0, size, 4096, 0.0,
+              [](const std::size_t _first, const std::size_t _last)
+              {
+                double sum = 0;
+                for (std::size_t i = _first; i < _last; ++i)
+                  sum += Work(i);
+                return sum;
+              },
+              [](const double _a, const double _b)
+              {
+                return _a + _b;
+              });
+        });
+
+    // Only the order of the additions differs
+    EXPECT_NEAR(serialSum, parallelSum, 1e-6 * size);
+
+    std::cout << std::setw(10) << size
+              << std::setw(14) << std::fixed << std::setprecision(3) << serial
+              << std::setw(16) << parallel
+              << std::setw(10) << std::setprecision(2)
+              << serial / parallel << "\n";
+  }
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2021 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "ignition/common/WorkerPool.hh"
+
+using namespace ignition;
+
+/// \brief Number of tiny jobs submitted per trial
+static const int NumJobs = 200000;
+
+/// \brief Number of threads submitting work concurrently
+static const int NumProducers = 4;
+
+/////////////////////////////////////////////////
+/// \brief Submit NumJobs tiny jobs from NumProducers threads and wait for
+/// them to finish.
+/// \param[in] _workers Number of worker threads
+/// \param[in] _mode Scheduling strategy
+/// \return Throughput in jobs per second
+double RunTrial(const unsigned int _workers,
+    const common::WorkerPoolMode _mode)
+{
+  common::WorkerPool pool(_workers, _mode, true);
+  std::atomic<int> counter(0);
+
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < NumProducers; ++p)
+  {
+    producers.emplace_back([&pool, &counter] ()
+        {
+          for (int i = 0; i < NumJobs / NumProducers; ++i)
+          {
+            pool.AddWork([&counter] ()
+                {
+                  counter.fetch_add(1, std::memory_order_relaxed);
+                });
+          }
+        });
+  }
+  for (auto &producer : producers)
+    producer.join();
+
+  EXPECT_TRUE(pool.WaitForResults());
+  const auto finish = std::chrono::steady_clock::now();
+  EXPECT_EQ(NumJobs, counter);
+
+  const double seconds =
+      std::chrono::duration<double>(finish - start).count();
+  return NumJobs / seconds;
+}
+
+/////////////////////////////////////////////////
+TEST(WorkerPool, Throughput)
+{
+  std::cout << "hardware concurrency: "
+            << std::thread::hardware_concurrency() << "\n"
+            << std::setw(8) << "workers"
+            << std::setw(20) << "shared [jobs/s]"
+            << std::setw(20) << "stealing [jobs/s]" << "\n";
+
+  for (unsigned int workers = 1; workers <= 64; workers *= 2)
+  {
+    const double shared =
+        RunTrial(workers, common::WorkerPoolMode::SHARED_QUEUE);
+    const double stealing =
+        RunTrial(workers, common::WorkerPoolMode::WORK_STEALING);
+
+    std::cout << std::setw(8) << workers
+              << std::setw(20) << std::fixed << std::setprecision(0) << shared
+              << std::setw(20) << stealing << "\n";
+  }
+}
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}